@@ -17,6 +17,28 @@
 
 static unsigned char scratch[32768];
 
+#define BOOTTIME_MAX 16
+
+static bootdata_boot_timeline_entry_t boottime_entries[BOOTTIME_MAX];
+static uint32_t boottime_count;
+
+static uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+void boottime_mark(const char* name) {
+    if (boottime_count == BOOTTIME_MAX) {
+        return;
+    }
+    bootdata_boot_timeline_entry_t* e = &boottime_entries[boottime_count];
+    e->ticks = rdtsc();
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->name[sizeof(e->name) - 1] = 0;
+    boottime_count++;
+}
+
 static void start_magenta(uint64_t entry, void* bootdata) {
     // ebx = 0, ebp = 0, edi = 0, esi = bootdata
     __asm__ __volatile__(
@@ -192,6 +214,25 @@ int boot_magenta(efi_handle img, efi_system_table* sys,
         goto fail;
     }
 
+    // install the boot timeline; the kernel and mx_ticks_get() share the
+    // TSC timebase, so later stages append comparable records of their own
+    boottime_mark("bl.exitbs");
+    struct {
+        bootdata_boot_timeline_t hdr;
+        bootdata_boot_timeline_entry_t entries[BOOTTIME_MAX];
+    } timeline;
+    timeline.hdr.ticks_per_second = 0;
+    timeline.hdr.entry_count = boottime_count;
+    timeline.hdr.reserved = 0;
+    memcpy(timeline.entries, boottime_entries,
+           boottime_count * sizeof(bootdata_boot_timeline_entry_t));
+    hdr.type = BOOTDATA_BOOT_TIMELINE;
+    hdr.length = sizeof(bootdata_boot_timeline_t) +
+                 (boottime_count * sizeof(bootdata_boot_timeline_entry_t));
+    if (add_bootdata(&bptr, &blen, &hdr, &timeline)) {
+        goto fail;
+    }
+
     // fill the remaining gap between pre-data and ramdisk image
     if ((blen < sizeof(bootdata_t)) || (blen & 7)) {
         goto fail;
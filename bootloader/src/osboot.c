@@ -305,6 +305,7 @@ void do_netboot() {
         }
 
         // maybe it's a kernel image?
+        boottime_mark("bl.netboot");
         boot_kernel(gImg, gSys, (void*) nbkernel.data, nbkernel.offset,
                     (void*) nbramdisk.data, nbramdisk.offset);
         break;
@@ -313,6 +314,7 @@ void do_netboot() {
 
 EFIAPI efi_status efi_main(efi_handle img, efi_system_table* sys) {
     xefi_init(img, sys);
+    boottime_mark("bl.entry");
     gConOut->ClearScreen(gConOut);
 
     uint64_t mmio;
@@ -380,6 +382,9 @@ EFIAPI efi_status efi_main(efi_handle img, efi_system_table* sys) {
     // TODO: use the filesystem protocol
     size_t ksz = 0;
     void* kernel = xefi_load_file(L"magenta.bin", &ksz, 0);
+    if (kernel != NULL) {
+        boottime_mark("bl.kernel");
+    }
 
     if (!have_network && kernel == NULL) {
         goto fail;
@@ -450,6 +455,7 @@ EFIAPI efi_status efi_main(efi_handle img, efi_system_table* sys) {
                 ramdisk = xefi_read_file(ramdisk_file, &rsz, FRONT_BYTES);
                 ramdisk_file->Close(ramdisk_file);
             }
+            boottime_mark("bl.ramdisk");
             boot_kernel(gImg, gSys, kernel, ksz, ramdisk, rsz);
             break;
         }
@@ -26,6 +26,11 @@ int boot_kernel(efi_handle img, efi_system_table* sys,
                 void* image, size_t sz,
                 void* ramdisk, size_t rsz);
 
+// Records a named TSC timestamp for the boot timeline that is handed to
+// the kernel as a BOOTDATA_BOOT_TIMELINE item.  Names are truncated to
+// BOOTDATA_TIMELINE_NAME_LEN-1 characters.
+void boottime_mark(const char* name);
+
 uint64_t find_acpi_root(efi_handle img, efi_system_table* sys);
 
 uint32_t get_mx_pixel_format(efi_graphics_output_protocol* gop);
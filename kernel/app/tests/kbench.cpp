@@ -0,0 +1,278 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// Microbenchmarks for core kernel primitives. Unlike the functional tests
+// these measure cost, so that regressions in primitive overhead show up on
+// a console run rather than in production. Each benchmark times batches of
+// operations after a warmup and reports per-op percentiles in ns, both
+// human-readable and as one machine-parsable KBENCH line per benchmark.
+
+#include "tests.h"
+
+#include <err.h>
+#include <inttypes.h>
+#include <platform.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arch/ops.h>
+#include <kernel/event.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <kernel/vm.h>
+
+#include <magenta/channel_dispatcher.h>
+#include <magenta/message_packet.h>
+#include <mxtl/ref_ptr.h>
+#include <mxtl/unique_ptr.h>
+
+// Each benchmark takes KBENCH_SAMPLES timed samples of a batch of
+// operations, after KBENCH_WARMUP untimed batches to fault in code and
+// data and warm caches. Batching keeps the clock read out of the
+// measured path for the cheap primitives; percentiles are over batches.
+#define KBENCH_SAMPLES 100u
+#define KBENCH_WARMUP 10u
+
+static uint64_t kbench_samples[KBENCH_SAMPLES];
+
+static int kbench_cmp_u64(const void* a, const void* b) {
+    uint64_t va = *(const uint64_t*)a;
+    uint64_t vb = *(const uint64_t*)b;
+    if (va < vb)
+        return -1;
+    if (va > vb)
+        return 1;
+    return 0;
+}
+
+// Report percentiles of ns/op over the recorded samples; |ops| is the
+// number of operations each sample covered.
+static void kbench_report(const char* name, uint32_t ops) {
+    qsort(kbench_samples, KBENCH_SAMPLES, sizeof(kbench_samples[0]),
+          kbench_cmp_u64);
+
+    uint64_t min = kbench_samples[0] / ops;
+    uint64_t p10 = kbench_samples[KBENCH_SAMPLES / 10] / ops;
+    uint64_t p50 = kbench_samples[KBENCH_SAMPLES / 2] / ops;
+    uint64_t p90 = kbench_samples[(KBENCH_SAMPLES * 9) / 10] / ops;
+    uint64_t max = kbench_samples[KBENCH_SAMPLES - 1] / ops;
+
+    printf("%-22s p50 %6" PRIu64 " ns/op (p10 %" PRIu64 ", p90 %" PRIu64
+           ", min %" PRIu64 ", max %" PRIu64 "; %u samples x %u ops)\n",
+           name, p50, p10, p90, min, max, KBENCH_SAMPLES, ops);
+    // One line per benchmark for scripts scraping the console.
+    printf("KBENCH:%s,%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+           ",%" PRIu64 "\n",
+           name, KBENCH_SAMPLES, ops, min, p10, p50, p90, max);
+}
+
+static void kbench_mutex(void) {
+    const uint32_t kOps = 1000;
+    mutex_t m;
+    mutex_init(&m);
+
+    for (uint32_t s = 0; s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        for (uint32_t i = 0; i < kOps; i++) {
+            mutex_acquire(&m);
+            mutex_release(&m);
+        }
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    mutex_destroy(&m);
+    kbench_report("mutex_acquire_release", kOps);
+}
+
+static int kbench_null_thread(void* arg) {
+    return 0;
+}
+
+static bool kbench_thread(void) {
+    for (uint32_t s = 0; s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        thread_t* t = thread_create("kbench-child", kbench_null_thread, NULL,
+                                    DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+        if (!t) {
+            printf("kbench: thread_create failed\n");
+            return false;
+        }
+        thread_resume(t);
+        thread_join(t, NULL, INFINITE_TIME);
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    kbench_report("thread_create_join", 1);
+    return true;
+}
+
+typedef struct {
+    event_t ping;
+    event_t pong;
+    uint32_t rounds;
+} kbench_switch_args_t;
+
+static int kbench_switch_thread(void* arg) {
+    kbench_switch_args_t* a = (kbench_switch_args_t*)arg;
+    for (uint32_t i = 0; i < a->rounds; i++) {
+        event_wait_deadline(&a->ping, INFINITE_TIME, false);
+        event_signal(&a->pong, true);
+    }
+    return 0;
+}
+
+static bool kbench_context_switch(void) {
+    const uint32_t kRounds = 100;
+    kbench_switch_args_t args;
+    event_init(&args.ping, false, EVENT_FLAG_AUTOUNSIGNAL);
+    event_init(&args.pong, false, EVENT_FLAG_AUTOUNSIGNAL);
+    args.rounds = (KBENCH_WARMUP + KBENCH_SAMPLES) * kRounds;
+
+    thread_t* partner = thread_create("kbench-switch", kbench_switch_thread,
+                                      &args, DEFAULT_PRIORITY,
+                                      DEFAULT_STACK_SIZE);
+    if (!partner) {
+        printf("kbench: thread_create failed\n");
+        return false;
+    }
+    // Pin the partner to this cpu so each round is two context switches,
+    // not a cross-cpu wakeup.
+    thread_set_pinned_cpu(partner, (int)arch_curr_cpu_num());
+    thread_resume(partner);
+
+    for (uint32_t s = 0; s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        for (uint32_t i = 0; i < kRounds; i++) {
+            event_signal(&args.ping, true);
+            event_wait_deadline(&args.pong, INFINITE_TIME, false);
+        }
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    thread_join(partner, NULL, INFINITE_TIME);
+    event_destroy(&args.ping);
+    event_destroy(&args.pong);
+    kbench_report("context_switch", kRounds * 2);
+    return true;
+}
+
+static bool kbench_pmm(void) {
+    const uint32_t kOps = 100;
+
+    for (uint32_t s = 0; s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        for (uint32_t i = 0; i < kOps; i++) {
+            paddr_t pa;
+            vm_page_t* page = pmm_alloc_page(0, &pa);
+            if (!page) {
+                printf("kbench: pmm_alloc_page failed\n");
+                return false;
+            }
+            pmm_free_page(page);
+        }
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    kbench_report("pmm_alloc_free_page", kOps);
+    return true;
+}
+
+static bool kbench_channel(void) {
+    const uint32_t kOps = 100;
+    const uint32_t kMsgSize = 64;
+
+    mxtl::RefPtr<Dispatcher> d0, d1;
+    mx_rights_t rights;
+    if (ChannelDispatcher::Create(0u, &d0, &d1, &rights) != NO_ERROR) {
+        printf("kbench: channel create failed\n");
+        return false;
+    }
+    auto ch0 = DownCastDispatcher<ChannelDispatcher>(&d0);
+    auto ch1 = DownCastDispatcher<ChannelDispatcher>(&d1);
+
+    bool ok = true;
+    for (uint32_t s = 0; ok && s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        for (uint32_t i = 0; i < kOps; i++) {
+            mxtl::unique_ptr<MessagePacket> msg;
+            if (MessagePacket::Create(kMsgSize, 0u, &msg) != NO_ERROR ||
+                ch0->Write(mxtl::move(msg)) != NO_ERROR) {
+                printf("kbench: channel write failed\n");
+                ok = false;
+                break;
+            }
+            uint32_t size = kMsgSize;
+            uint32_t num_handles = 0;
+            if (ch1->Read(&size, &num_handles, &msg, false) != NO_ERROR) {
+                printf("kbench: channel read failed\n");
+                ok = false;
+                break;
+            }
+        }
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    // We never wrapped the dispatchers in handles, so stand in for the
+    // handle teardown that normally severs the endpoints (and breaks
+    // their mutual references) before the last refs drop.
+    ch0->on_zero_handles();
+    ch1->on_zero_handles();
+
+    if (ok)
+        kbench_report("channel_write_read", kOps);
+    return ok;
+}
+
+static enum handler_return kbench_timer_cb(timer_t* t, lk_time_t now,
+                                           void* arg) {
+    return INT_NO_RESCHEDULE;
+}
+
+static void kbench_timer(void) {
+    const uint32_t kOps = 100;
+    timer_t t;
+    timer_initialize(&t);
+
+    for (uint32_t s = 0; s < KBENCH_WARMUP + KBENCH_SAMPLES; s++) {
+        lk_time_t t0 = current_time();
+        for (uint32_t i = 0; i < kOps; i++) {
+            // A deadline an hour out never fires; this measures pure
+            // queue insert and removal.
+            timer_set_oneshot(&t, t0 + LK_SEC(3600), kbench_timer_cb, NULL);
+            timer_cancel(&t);
+        }
+        lk_time_t t1 = current_time();
+        if (s >= KBENCH_WARMUP)
+            kbench_samples[s - KBENCH_WARMUP] = t1 - t0;
+    }
+
+    kbench_report("timer_set_cancel", kOps);
+}
+
+int kbench(int argc, const cmd_args* argv) {
+    printf("kernel microbenchmarks (%u warmup + %u timed samples per benchmark)\n",
+           KBENCH_WARMUP, KBENCH_SAMPLES);
+
+    kbench_mutex();
+    kbench_thread();
+    kbench_context_switch();
+    kbench_pmm();
+    kbench_channel();
+    kbench_timer();
+    return 0;
+}
@@ -14,6 +14,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/cache_tests.c \
     $(LOCAL_DIR)/clock_tests.c \
     $(LOCAL_DIR)/fibo.c \
+    $(LOCAL_DIR)/kbench.cpp \
     $(LOCAL_DIR)/mem_tests.cpp \
     $(LOCAL_DIR)/printf_tests.c \
     $(LOCAL_DIR)/sync_ipi_tests.c \
@@ -27,6 +28,7 @@ MODULE_SRCS += \
 MODULE_DEPS += \
     kernel/lib/crypto \
     kernel/lib/header_tests \
+    kernel/lib/magenta \
     kernel/lib/mxtl \
     third_party/lib/safeint \
     kernel/lib/unittest \
@@ -33,6 +33,7 @@ int sync_ipi_tests(int argc, const cmd_args *argv);
 int arena_tests(int argc, const cmd_args *argv);
 int fifo_tests(int argc, const cmd_args *argv);
 int alloc_checker_tests(int argc, const cmd_args* argv);
+int kbench(int argc, const cmd_args* argv);
 void unittests(void);
 
 __END_CDECLS
@@ -73,6 +73,13 @@ static status_t arch_set_general_regs(struct thread *thread, const mx_arm64_gene
     return NO_ERROR;
 }
 
+status_t arch_set_single_step(struct thread *thread, bool enable)
+{
+    // TODO(dje): Requires managing MDSCR_EL1.SS and SPSR.SS across the
+    // exception return.
+    return ERR_NOT_SUPPORTED;
+}
+
 status_t arch_get_regset(struct thread *thread, uint regset, void *regs, uint32_t *buf_size)
 {
     switch (regset)
@@ -26,6 +26,11 @@
 
 bool arm64_in_int_handler[SMP_MAX_CPUS];
 
+// the frame of the interrupt currently being handled on each cpu, so
+// that irq handlers (the timer tick profiling hook) can see the
+// interrupted context
+struct arm64_iframe_short* arm64_irq_frame[SMP_MAX_CPUS];
+
 static void dump_iframe(const struct arm64_iframe_long *iframe)
 {
     printf("iframe %p:\n", iframe);
@@ -316,9 +321,11 @@ extern "C" void arm64_irq(struct arm64_iframe_short *iframe, uint exception_flag
 
     uint32_t curr_cpu = arch_curr_cpu_num();
     arm64_in_int_handler[curr_cpu] = true;
+    arm64_irq_frame[curr_cpu] = iframe;
 
     enum handler_return ret = platform_irq(iframe);
 
+    arm64_irq_frame[curr_cpu] = NULL;
     arm64_in_int_handler[curr_cpu] = false;
 
     /* if we came from user space, check to see if we have any signals to handle */
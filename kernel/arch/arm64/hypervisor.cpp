@@ -25,3 +25,8 @@ status_t arch_guest_set_entry(const mxtl::unique_ptr<GuestContext>& context,
                               uintptr_t guest_entry) {
     return ERR_NOT_SUPPORTED;
 }
+
+status_t arch_guest_set_state_area(const mxtl::unique_ptr<GuestContext>& context,
+                                   mxtl::RefPtr<VmObject> vcpu_state_vmo) {
+    return ERR_NOT_SUPPORTED;
+}
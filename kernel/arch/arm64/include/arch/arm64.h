@@ -92,6 +92,10 @@ void arm64_sync_exception(struct arm64_iframe_long *iframe, uint exception_flags
 
 typedef struct arm64_iframe_short iframe;
 
+// frame of the interrupt currently being handled on each cpu, valid
+// only while in the irq handler; NULL otherwise
+extern struct arm64_iframe_short* arm64_irq_frame[SMP_MAX_CPUS];
+
 enum handler_return platform_irq(iframe* frame);
 enum handler_return platform_fiq(iframe* frame);
 
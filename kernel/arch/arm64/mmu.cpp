@@ -84,6 +84,8 @@ static pte_t mmu_flags_to_pte_attr(uint flags) {
         attr |= MMU_PTE_ATTR_NORMAL_MEMORY | MMU_PTE_ATTR_SH_INNER_SHAREABLE;
         break;
     case ARCH_MMU_FLAG_WRITE_COMBINING:
+        attr |= MMU_PTE_ATTR_NORMAL_UNCACHED | MMU_PTE_ATTR_SH_INNER_SHAREABLE;
+        break;
     case ARCH_MMU_FLAG_UNCACHED:
         attr |= MMU_PTE_ATTR_STRONGLY_ORDERED;
         break;
@@ -203,6 +205,9 @@ status_t arch_mmu_query(arch_aspace_t* aspace, vaddr_t vaddr, paddr_t* paddr, ui
         case MMU_PTE_ATTR_DEVICE:
             *flags |= ARCH_MMU_FLAG_UNCACHED_DEVICE;
             break;
+        case MMU_PTE_ATTR_NORMAL_UNCACHED:
+            *flags |= ARCH_MMU_FLAG_WRITE_COMBINING;
+            break;
         case MMU_PTE_ATTR_NORMAL_MEMORY:
             break;
         default:
@@ -341,6 +346,58 @@ static bool page_table_is_clear(pte_t* page_table, uint page_size_shift) {
     return true;
 }
 
+/* demote a block descriptor to a table of next level entries covering the
+ * same range, so that part of the block can be unmapped independently */
+static status_t arm64_mmu_split_block(vaddr_t block_vaddr, pte_t* pte_ptr,
+                                      uint index_shift, uint page_size_shift,
+                                      uint asid) {
+    pte_t old_pte = *pte_ptr;
+
+    DEBUG_ASSERT((old_pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_BLOCK);
+    DEBUG_ASSERT(index_shift > page_size_shift);
+
+    paddr_t paddr;
+    status_t ret = alloc_page_table(&paddr, page_size_shift);
+    if (ret)
+        return ret;
+
+    pte_t* new_table = static_cast<pte_t*>(paddr_to_kvaddr(paddr));
+
+    uint next_shift = index_shift - (page_size_shift - 3);
+    size_t next_size = 1UL << next_shift;
+    uint count = 1U << (page_size_shift - 3);
+
+    /* the attribute bits are laid out the same in block and page descriptors */
+    pte_t attrs = old_pte & ~(MMU_PTE_OUTPUT_ADDR_MASK | MMU_PTE_DESCRIPTOR_MASK);
+    pte_t descriptor = (next_shift > page_size_shift) ? MMU_PTE_L012_DESCRIPTOR_BLOCK
+                                                      : MMU_PTE_L3_DESCRIPTOR_PAGE;
+
+    paddr_t block_paddr = old_pte & MMU_PTE_OUTPUT_ADDR_MASK;
+    for (uint i = 0; i < count; i++) {
+        new_table[i] = (block_paddr + i * next_size) | attrs | descriptor;
+    }
+
+    __asm__ volatile("dmb ishst" ::
+                         : "memory");
+
+    /* break-before-make: invalidate the block and flush its tlb entry before
+     * installing the table descriptor */
+    *pte_ptr = MMU_PTE_DESCRIPTOR_INVALID;
+    CF;
+    if (asid == MMU_ARM64_GLOBAL_ASID)
+        ARM64_TLBI(vaae1is, block_vaddr >> 12);
+    else
+        ARM64_TLBI(vae1is, block_vaddr >> 12 | (vaddr_t)asid << 48);
+
+    *pte_ptr = paddr | MMU_PTE_L012_DESCRIPTOR_TABLE;
+    CF;
+
+    LTRACEF("split block pte %p: %#" PRIx64 " -> table at %#" PRIxPTR "\n",
+            pte_ptr, old_pte, paddr);
+
+    return NO_ERROR;
+}
+
 static ssize_t arm64_mmu_unmap_pt(vaddr_t vaddr, vaddr_t vaddr_rel,
                                   size_t size,
                                   uint index_shift, uint page_size_shift,
@@ -384,6 +441,23 @@ static ssize_t arm64_mmu_unmap_pt(vaddr_t vaddr, vaddr_t vaddr_rel,
                                      : "memory");
                 free_page_table(next_page_table, page_table_paddr, page_size_shift);
             }
+        } else if (index_shift > page_size_shift && pte &&
+                   chunk_size != block_size) {
+            /* partially unmapping a block: demote it to a table and retry
+             * this chunk against the new table */
+            if (arm64_mmu_split_block(vaddr - vaddr_rem, &page_table[index],
+                                      index_shift, page_size_shift, asid) == NO_ERROR)
+                continue;
+
+            /* couldn't allocate the table; drop the whole block and let a
+             * later page fault repopulate the remainder */
+            LTRACEF("pte %p[0x%lx] = 0 (block split failed)\n", page_table, index);
+            page_table[index] = MMU_PTE_DESCRIPTOR_INVALID;
+            CF;
+            if (asid == MMU_ARM64_GLOBAL_ASID)
+                ARM64_TLBI(vaae1is, vaddr >> 12);
+            else
+                ARM64_TLBI(vae1is, vaddr >> 12 | (vaddr_t)asid << 48);
         } else if (pte) {
             LTRACEF("pte %p[0x%lx] = 0\n", page_table, index);
             page_table[index] = MMU_PTE_DESCRIPTOR_INVALID;
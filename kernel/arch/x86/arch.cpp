@@ -24,6 +24,7 @@
 #include <arch/x86/mmu.h>
 #include <arch/x86/mmu_mem_types.h>
 #include <arch/x86/mp.h>
+#include <arch/x86/pmu.h>
 #include <arch/x86/proc_trace.h>
 #include <arch/mmu.h>
 #include <kernel/vm.h>
@@ -67,6 +68,8 @@ void arch_init(void)
     idt_setup_readonly();
 
     x86_processor_trace_init();
+
+    x86_pmu_init();
 }
 
 void arch_chain_load(void *entry, ulong arg0, ulong arg1, ulong arg2, ulong arg3)
@@ -103,6 +103,26 @@ static status_t arch_set_general_regs(struct thread *thread, const void *grp, ui
     return NO_ERROR;
 }
 
+status_t arch_set_single_step(struct thread *thread, bool enable)
+{
+    if (!thread_stopped_in_exception(thread))
+        return ERR_BAD_STATE;
+
+    x86_iframe_t *frame = thread->exception_context->frame;
+
+    // TODO: We could get called while processing a synthetic exception where
+    // there is no frame.
+    if (frame == NULL)
+        return ERR_NOT_SUPPORTED;
+
+    if (enable)
+        frame->flags |= X86_FLAGS_TF;
+    else
+        frame->flags &= ~(uint64_t)X86_FLAGS_TF;
+
+    return NO_ERROR;
+}
+
 status_t arch_get_regset(struct thread *thread, uint regset, void *regs, uint32_t *buf_size)
 {
     switch (regset)
@@ -13,6 +13,7 @@
 #include <arch/x86/feature.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/descriptor.h>
+#include <arch/x86/pmu.h>
 #include <kernel/thread.h>
 #include <platform.h>
 
@@ -380,10 +381,16 @@ void x86_exception_handler(x86_iframe_t *frame)
             break;
         }
         case X86_INT_APIC_TIMER: {
+            ktrace_prof_sample(frame->ip, frame->rbp, 0);
             ret = apic_timer_interrupt_handler();
             apic_issue_eoi();
             break;
         }
+        case X86_INT_APIC_PERFMON: {
+            ret = x86_pmu_pmi_handler();
+            apic_issue_eoi();
+            break;
+        }
 #if WITH_SMP
         case X86_INT_IPI_GENERIC: {
             ret = x86_ipi_generic_handler();
@@ -13,6 +13,9 @@
 #include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
 #include <hypervisor/guest_physical_address_space.h>
+#include <kernel/vm.h>
+#include <kernel/vm/vm_object.h>
+#include <magenta/syscalls/hypervisor.h>
 
 #if WITH_LIB_MAGENTA
 #include <magenta/fifo_dispatcher.h>
@@ -820,6 +823,15 @@ status_t VmcsPerCpu::Enter(const VmcsContext& context, GuestPhysicalAddressSpace
         vmx_state_.guest_state.rsi = context.esi();
     }
 
+    mx_vcpu_state_t* vcpu_state = context.vcpu_state();
+    if (vcpu_state != nullptr && (vcpu_state->flags & MX_VCPU_STATE_REGS_DIRTY)) {
+        // The VMM emulated the last exit against the shared state area;
+        // reload the registers it may have changed before resuming.
+        load_vcpu_state(&vmx_state_.guest_state, vcpu_state);
+        vmcs_write(VmcsFieldXX::GUEST_RIP, vcpu_state->rip);
+        vcpu_state->flags &= ~MX_VCPU_STATE_REGS_DIRTY;
+    }
+
     status_t status = vmx_enter(&vmx_state_);
     if (status != NO_ERROR) {
         uint64_t error = vmcs_read(VmcsField32::INSTRUCTION_ERROR);
@@ -827,7 +839,7 @@ status_t VmcsPerCpu::Enter(const VmcsContext& context, GuestPhysicalAddressSpace
     } else {
         vmx_state_.resume = true;
         status = vmexit_handler(&vmx_state_.guest_state, &local_apic_state_, &io_apic_state_, gpas,
-                                serial_fifo);
+                                serial_fifo, vcpu_state);
     }
     return status;
 }
@@ -884,11 +896,9 @@ status_t VmcsContext::Create(mxtl::RefPtr<VmObject> guest_phys_mem,
     if (status != NO_ERROR)
         return status;
 
-    // We ensure the page containing the IO APIC address is not mapped so that
-    // we VM exit with an EPT violation when the guest accesses the page.
-    status = ctx->gpas_->UnmapPage(kIoApicPhysBase);
-    if (status != NO_ERROR)
-        return status;
+    // We ensure the page containing the IO APIC address is never mapped so
+    // that we VM exit with an EPT violation when the guest accesses the page.
+    ctx->gpas_->SetTrapPage(kIoApicPhysBase);
 
     // Setup per-CPU structures.
     status = InitPerCpus(vmx_info, &ctx->per_cpus_);
@@ -957,6 +967,36 @@ status_t VmcsContext::set_esi(uint32_t guest_esi) {
     return NO_ERROR;
 }
 
+static status_t state_area_lookup(void* context, size_t offset, size_t index, paddr_t pa) {
+    *static_cast<paddr_t*>(context) = pa;
+    return NO_ERROR;
+}
+
+status_t VmcsContext::set_state_area(mxtl::RefPtr<VmObject> vcpu_state_vmo) {
+    if (vcpu_state_ != nullptr)
+        return ERR_BAD_STATE;
+    if (vcpu_state_vmo->size() < sizeof(mx_vcpu_state_t))
+        return ERR_INVALID_ARGS;
+
+    // Commit the first page of the VMO and access it through the physmap;
+    // the VMM sees the same bytes through its own mapping of the VMO.
+    uint64_t committed;
+    status_t status = vcpu_state_vmo->CommitRange(0, PAGE_SIZE, &committed);
+    if (status != NO_ERROR)
+        return status;
+
+    paddr_t pa = 0;
+    status = vcpu_state_vmo->Lookup(0, PAGE_SIZE, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE,
+                                    state_area_lookup, &pa);
+    if (status != NO_ERROR)
+        return status;
+
+    vcpu_state_vmo_ = mxtl::move(vcpu_state_vmo);
+    vcpu_state_ = static_cast<mx_vcpu_state_t*>(paddr_to_kvaddr(pa));
+    memset(vcpu_state_, 0, sizeof(*vcpu_state_));
+    return NO_ERROR;
+}
+
 static int vmcs_launch(void* arg) {
     VmcsContext* context = static_cast<VmcsContext*>(arg);
     VmcsPerCpu* per_cpu = context->PerCpu();
@@ -996,6 +1036,11 @@ status_t arch_guest_set_entry(const mxtl::unique_ptr<GuestContext>& context,
     return context->set_entry(guest_entry);
 }
 
+status_t arch_guest_set_state_area(const mxtl::unique_ptr<GuestContext>& context,
+                                   mxtl::RefPtr<VmObject> vcpu_state_vmo) {
+    return context->set_state_area(mxtl::move(vcpu_state_vmo));
+}
+
 status_t x86_guest_set_cr3(const mxtl::unique_ptr<GuestContext>& context, uintptr_t guest_cr3) {
     return context->set_cr3(guest_cr3);
 }
@@ -10,6 +10,7 @@
 
 #include <assert.h>
 #include <magenta/compiler.h>
+#include <arch/x86/pmu.h>
 #include <arch/x86/registers.h>
 #include <sys/types.h>
 
@@ -39,6 +40,13 @@ struct arch_thread {
         x86_iframe_t *iframe;
     } suspended_general_regs;
 
+    /* per-thread accumulated perf counter values, the counter marks
+     * taken at switch-in and the counting session they belong to;
+     * maintained by x86_pmu_thread_context_switch */
+    uint64_t pmu_counts[X86_PMU_MAX_COUNTERS];
+    uint64_t pmu_mark[X86_PMU_MAX_COUNTERS];
+    uint32_t pmu_epoch;
+
     /* buffer to save fpu and extended register (e.g., PT) state */
     vaddr_t *extended_register_state;
     uint8_t extended_register_buffer[X86_MAX_EXTENDED_REGISTER_SIZE + 64];
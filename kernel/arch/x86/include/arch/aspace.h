@@ -10,6 +10,7 @@
 #include <magenta/compiler.h>
 #include <arch/x86/mmu.h>
 #include <kernel/spinlock.h>
+#include <list.h>
 
 __BEGIN_CDECLS
 
@@ -33,6 +34,33 @@ struct arch_aspace {
      * actually an mp_cpu_mask_t, but header dependencies. */
     volatile int active_cpus;
 
+    /* process-context id this aspace's TLB entries are tagged with, or 0 if
+     * the cpu lacks PCID support (or the pool was exhausted) */
+    uint16_t pcid;
+
+    /* cpus whose TLBs may still hold translations tagged with this aspace's
+     * pcid that are coherent with the page tables, i.e. cpus that can switch
+     * into the aspace without flushing.  a cpu sets its bit when it loads the
+     * aspace's cr3 and clears it when it ignores an invalidation because it
+     * is running some other aspace.  actually an mp_cpu_mask_t. */
+    volatile int pcid_cpus;
+
+    /* batched tlb invalidation state for the mmu operation in progress.
+     * guarded by the external lock every mmu operation on this aspace is
+     * serialized by, so no locking is needed here. */
+#define X86_TLB_PENDING_MAX 16
+    struct {
+        bool active;      /* an mmu operation is accumulating invalidations */
+        bool full;        /* too many entries; flush the whole context */
+        bool global;      /* at least one entry is a global mapping */
+        uint32_t count;
+        vaddr_t vaddr[X86_TLB_PENDING_MAX];
+        /* page table pages unmapped during the operation; they can't be
+         * freed until the invalidations have been issued, since other cpus
+         * may still walk through them. */
+        struct list_node free_pages;
+    } tlb_pending;
+
     /* Pointer to a bitmap::RleBitmap representing the range of ports
      * enabled in this aspace. */
     void *io_bitmap;
@@ -28,6 +28,7 @@ enum x86_cpuid_leaf_num {
     X86_CPUID_MODEL_FEATURES = 0x1,
     X86_CPUID_CACHE_V1 = 0x2,
     X86_CPUID_CACHE_V2 = 0x4,
+    X86_CPUID_PERFMON = 0xa,
     X86_CPUID_TOPOLOGY = 0xb,
     X86_CPUID_XSAVE = 0xd,
     X86_CPUID_PT = 0x14,
@@ -98,6 +99,7 @@ void x86_feature_debug(void);
 #define X86_FEATURE_SSE3         X86_CPUID_BIT(0x1, 2, 0)
 #define X86_FEATURE_VMX          X86_CPUID_BIT(0x1, 2, 5)
 #define X86_FEATURE_SSSE3        X86_CPUID_BIT(0x1, 2, 9)
+#define X86_FEATURE_PCID         X86_CPUID_BIT(0x1, 2, 17)
 #define X86_FEATURE_SSE4_1       X86_CPUID_BIT(0x1, 2, 19)
 #define X86_FEATURE_SSE4_2       X86_CPUID_BIT(0x1, 2, 20)
 #define X86_FEATURE_X2APIC       X86_CPUID_BIT(0x1, 2, 21)
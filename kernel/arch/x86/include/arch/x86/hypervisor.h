@@ -12,6 +12,7 @@
 #include <mxtl/unique_ptr.h>
 
 typedef struct vm_page vm_page_t;
+typedef struct mx_vcpu_state mx_vcpu_state_t;
 
 class FifoDispatcher;
 class VmObject;
@@ -73,6 +74,8 @@ public:
     uintptr_t cr3() const { return cr3_; }
     status_t set_esi(uint32_t guest_esi);
     uint32_t esi() const { return esi_; }
+    status_t set_state_area(mxtl::RefPtr<VmObject> vcpu_state_vmo);
+    mx_vcpu_state_t* vcpu_state() const { return vcpu_state_; }
     GuestPhysicalAddressSpace* gpas() const { return gpas_.get(); }
     FifoDispatcher* serial_fifo() const { return serial_fifo_.get(); }
 
@@ -82,6 +85,11 @@ private:
     uint32_t esi_ = UINT32_MAX;
     mxtl::unique_ptr<GuestPhysicalAddressSpace> gpas_;
     mxtl::RefPtr<FifoDispatcher> serial_fifo_;
+    // The VMO backing the shared vcpu state area, held so its first page
+    // stays committed for the life of the guest, and the kernel's view of
+    // that page through the physmap.
+    mxtl::RefPtr<VmObject> vcpu_state_vmo_;
+    mx_vcpu_state_t* vcpu_state_ = nullptr;
 
     VmxPage msr_bitmaps_page_;
     VmxPage apic_address_page_;
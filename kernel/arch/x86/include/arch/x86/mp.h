@@ -94,9 +94,15 @@ void x86_set_local_apic_id(uint32_t apic_id);
 
 int x86_apic_id_to_cpu_num(uint32_t apic_id);
 
+/* look up the local APIC id of the given CPU number */
+status_t x86_cpu_num_to_apic_id(uint cpu_num, uint32_t *out_apic_id);
+
 // Allocate all of the necessary structures for all of the APs to run.
 status_t x86_allocate_ap_structures(uint32_t *apic_ids, uint8_t cpu_count);
 
+// Publish SMT/LLC sharing masks for all enumerated cpus to the scheduler.
+void x86_publish_cpu_topology(void);
+
 static inline struct x86_percpu *x86_get_percpu(void)
 {
     return (struct x86_percpu *)x86_read_gs_offset64(PERCPU_DIRECT_OFFSET);
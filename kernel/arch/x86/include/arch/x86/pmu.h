@@ -0,0 +1,86 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <err.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <magenta/compiler.h>
+
+// TODO(dje): For mx_x86_pmu_regs_t. To be revisited when we switch to
+// "resources".
+#include <magenta/mtrace.h>
+
+// Total number of counter slots tracked per thread in thread mode:
+// the programmable counters followed by the fixed ones.
+#define X86_PMU_MAX_COUNTERS \
+    (MX_PMU_MAX_PROGRAMMABLE_COUNTERS + MX_PMU_MAX_FIXED_COUNTERS)
+
+__BEGIN_CDECLS
+
+void x86_pmu_init(void);
+
+struct thread;
+
+// Accumulate the outgoing thread's counter deltas and mark the incoming
+// thread's starting values; a nop unless thread-mode counting is active.
+// Called from arch_context_switch with interrupts disabled.
+void x86_pmu_thread_context_switch(struct thread* oldthread,
+                                   struct thread* newthread);
+
+// Handle a performance monitor interrupt: acknowledge the overflowed
+// counters and invoke the registered overflow handler, if any.
+// Called from interrupt context.
+enum handler_return x86_pmu_pmi_handler(void);
+
+// Invoked from the PMI handler (interrupt context, interrupts disabled)
+// with the cpu number and the IA32_PERF_GLOBAL_STATUS overflow bits,
+// which have already been acknowledged.
+typedef void (*x86_pmu_overflow_fn)(uint32_t cpu, uint64_t status);
+
+void x86_pmu_set_overflow_handler(x86_pmu_overflow_fn handler);
+
+__END_CDECLS
+
+#ifdef __cplusplus
+
+typedef enum {
+    PMU_COUNT_CPUS,
+    PMU_COUNT_THREADS
+} pmu_count_mode_t;
+
+status_t x86_pmu_set_mode(pmu_count_mode_t mode);
+
+status_t x86_pmu_alloc();
+
+status_t x86_pmu_free();
+
+status_t x86_pmu_start();
+
+status_t x86_pmu_stop();
+
+status_t x86_pmu_stage_cpu_data(uint32_t cpu, const mx_x86_pmu_regs_t* regs);
+
+status_t x86_pmu_get_cpu_data(uint32_t cpu, mx_x86_pmu_regs_t* regs);
+
+status_t x86_pmu_get_thread_data(mx_x86_pmu_regs_t* regs);
+
+// Split form of start/stop for starting or stopping several tracing
+// engines with one cross-cpu synchronization (MTRACE_KIND_SYNC).
+// x86_pmu_sync_arm() performs the validation and bookkeeping of
+// x86_pmu_start() without touching any cpu; the caller then runs
+// x86_pmu_sync_cpu_start() on every cpu from its own mp_sync_exec task.
+// x86_pmu_sync_disarm()/x86_pmu_sync_cpu_stop() are the stop analogues,
+// and disarm also serves to roll back an arm whose companion engine
+// failed to arm.
+status_t x86_pmu_sync_arm();
+status_t x86_pmu_sync_disarm();
+void x86_pmu_sync_cpu_start();
+void x86_pmu_sync_cpu_stop();
+
+#endif // __cplusplus
@@ -38,8 +38,25 @@ status_t x86_ipt_cpu_mode_start();
 
 status_t x86_ipt_cpu_mode_stop();
 
+status_t x86_ipt_cpu_mode_pause(uint32_t cpu, mx_x86_pt_regs_t* regs);
+
+status_t x86_ipt_cpu_mode_resume(uint32_t cpu);
+
 status_t x86_ipt_stage_cpu_data(uint32_t options, const mx_x86_pt_regs_t* regs);
 
 status_t x86_ipt_get_cpu_data(uint32_t options, mx_x86_pt_regs_t* regs);
 
+// Split form of start/stop for starting or stopping several tracing
+// engines with one cross-cpu synchronization (MTRACE_KIND_SYNC).
+// x86_ipt_sync_arm() performs the validation and bookkeeping of
+// x86_ipt_cpu_mode_start() without touching any cpu; the caller then runs
+// x86_ipt_sync_cpu_start() on every cpu from its own mp_sync_exec task.
+// x86_ipt_sync_disarm()/x86_ipt_sync_cpu_stop() are the stop analogues,
+// and disarm also serves to roll back an arm whose companion engine
+// failed to arm.
+status_t x86_ipt_sync_arm();
+status_t x86_ipt_sync_disarm();
+void x86_ipt_sync_cpu_start();
+void x86_ipt_sync_cpu_stop();
+
 #endif // __cplusplus
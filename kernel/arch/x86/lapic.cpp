@@ -86,6 +86,7 @@ static void *apic_virt_base;
 
 static void apic_error_init(void);
 static void apic_timer_init(void);
+static void apic_pmi_init(void);
 
 // This function must be called once on the kernel address space
 void apic_vm_init(void)
@@ -130,6 +131,7 @@ void apic_local_init(void)
 
     apic_error_init();
     apic_timer_init();
+    apic_pmi_init();
 }
 
 uint8_t apic_local_id(void)
@@ -328,6 +330,26 @@ enum handler_return apic_timer_interrupt_handler(void) {
     return platform_handle_apic_timer_tick();
 }
 
+static void apic_pmi_init(void) {
+    *LVT_PERF_ADDR = LVT_VECTOR(X86_INT_APIC_PERFMON) | LVT_MASKED;
+}
+
+void apic_pmi_mask(void) {
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, 0);
+    *LVT_PERF_ADDR |= LVT_MASKED;
+    arch_interrupt_restore(state, 0);
+}
+
+// N.B. Delivery of a PMI sets the mask bit in the LVT entry, so the PMI
+// handler must call this to re-arm it after servicing the interrupt.
+void apic_pmi_unmask(void) {
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, 0);
+    *LVT_PERF_ADDR &= ~LVT_MASKED;
+    arch_interrupt_restore(state, 0);
+}
+
 static void apic_error_init(void) {
     *LVT_ERROR_ADDR = LVT_VECTOR(X86_INT_APIC_ERROR);
     // Re-arm the error interrupt triggering mechanism
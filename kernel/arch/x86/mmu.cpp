@@ -6,6 +6,7 @@
 
 #include <assert.h>
 #include <err.h>
+#include <rand.h>
 #include <string.h>
 #include <trace.h>
 
@@ -18,6 +19,7 @@
 #include <arch/x86/mmu.h>
 #include <arch/x86/mmu_mem_types.h>
 #include <kernel/mp.h>
+#include <kernel/mutex.h>
 #include <kernel/vm.h>
 
 #include <bitmap/rle-bitmap.h>
@@ -32,6 +34,10 @@ uint8_t g_paddr_width = 32;
 /* True if the system supports 1GB pages */
 static bool supports_huge_pages = false;
 
+/* True if user aspaces are tagged with process-context ids, so that a context
+ * switch does not have to discard the entire TLB (see aspace_cr3 below) */
+static bool use_pcid = false;
+
 /* top level kernel page tables, initialized in start.S */
 pt_entry_t pml4[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE);
 pt_entry_t pdp[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE); /* temporary */
@@ -57,6 +63,45 @@ paddr_t x86_kernel_cr3(void) {
     return kernel_pt_phys;
 }
 
+/* pool of process-context ids.  pcid 0 is reserved for the kernel aspace and
+ * for aspaces running without a pcid; it is never handed out. */
+#define X86_MAX_PCIDS 4096
+
+static uint64_t pcid_pool[X86_MAX_PCIDS / 64];
+static mutex_t pcid_lock = MUTEX_INITIAL_VALUE(pcid_lock);
+
+static uint16_t x86_mmu_alloc_pcid() {
+    uint16_t new_pcid;
+    uint32_t retry = X86_MAX_PCIDS;
+
+    mutex_acquire(&pcid_lock);
+    do {
+        new_pcid = static_cast<uint16_t>(rand()) & (X86_MAX_PCIDS - 1);
+        retry--;
+        if (retry == 0) {
+            /* pool exhausted; run the aspace untagged, which simply falls
+             * back to flushing cr3 loads on every context switch */
+            mutex_release(&pcid_lock);
+            return 0;
+        }
+    } while ((pcid_pool[new_pcid >> 6] & (1ull << (new_pcid % 64))) || (new_pcid == 0));
+
+    pcid_pool[new_pcid >> 6] |= (1ull << (new_pcid % 64));
+
+    mutex_release(&pcid_lock);
+
+    return new_pcid;
+}
+
+static void x86_mmu_free_pcid(uint16_t pcid) {
+    /* stale entries tagged with the pcid may linger in TLBs; they are
+     * flushed by the first (non-noflush) cr3 load of whichever aspace the
+     * pcid is recycled to, since a fresh aspace starts with pcid_cpus 0. */
+    mutex_acquire(&pcid_lock);
+    pcid_pool[pcid >> 6] &= ~(1ull << (pcid % 64));
+    mutex_release(&pcid_lock);
+}
+
 /* test the vaddr against the address space's range */
 static bool is_valid_vaddr(arch_aspace_t* aspace, vaddr_t vaddr) {
     return (vaddr >= aspace->base && vaddr <= aspace->base + aspace->size - 1);
@@ -118,6 +163,11 @@ static void x86_tlb_global_invalidate() {
     if (likely(cr4 & X86_CR4_PGE)) {
         x86_set_cr4(cr4 & ~X86_CR4_PGE);
         x86_set_cr4(cr4);
+    } else if (use_pcid) {
+        /* a cr3 load would only flush the current pcid; any write to
+         * CR4.PGE flushes all entries for all pcids */
+        x86_set_cr4(cr4 | X86_CR4_PGE);
+        x86_set_cr4(cr4);
     } else {
         x86_set_cr3(x86_get_cr3());
     }
@@ -125,6 +175,7 @@ static void x86_tlb_global_invalidate() {
 
 /* Task used for invalidating a TLB entry on each CPU */
 struct tlb_invalidate_page_context {
+    arch_aspace_t* aspace;
     ulong target_cr3;
     vaddr_t vaddr;
     enum page_table_levels level;
@@ -134,9 +185,13 @@ static void tlb_invalidate_page_task(void* raw_context) {
     DEBUG_ASSERT(arch_ints_disabled());
     tlb_invalidate_page_context* context = (tlb_invalidate_page_context*)raw_context;
 
-    ulong cr3 = x86_get_cr3();
+    ulong cr3 = x86_get_cr3() & ~X86_CR3_PCID_MASK;
     if (context->target_cr3 != cr3 && !context->global_page) {
-        /* This invalidation doesn't apply to this CPU, ignore it */
+        /* Not running in the target aspace; any entries this cpu holds
+         * tagged with its pcid are now stale, so force a flushing cr3 load
+         * the next time this cpu switches into it. */
+        if (context->aspace != nullptr)
+            atomic_and(&context->aspace->pcid_cpus, (int)~(1U << arch_curr_cpu_num()));
         return;
     }
 
@@ -152,6 +207,43 @@ static void tlb_invalidate_page_task(void* raw_context) {
     }
 }
 
+/* Task used for invalidating a batch of TLB entries on each CPU */
+struct tlb_invalidate_batch_context {
+    arch_aspace_t* aspace;
+    ulong target_cr3;
+    bool full;
+    bool global;
+    uint32_t count;
+    const vaddr_t* vaddr;
+};
+static void tlb_invalidate_batch_task(void* raw_context) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    tlb_invalidate_batch_context* context = (tlb_invalidate_batch_context*)raw_context;
+
+    ulong cr3 = x86_get_cr3() & ~X86_CR3_PCID_MASK;
+    if (context->target_cr3 != cr3 && !context->global) {
+        /* Not running in the target aspace; see tlb_invalidate_page_task */
+        if (context->aspace != nullptr)
+            atomic_and(&context->aspace->pcid_cpus, (int)~(1U << arch_curr_cpu_num()));
+        return;
+    }
+
+    if (context->full) {
+        if (context->global) {
+            x86_tlb_global_invalidate();
+        } else {
+            /* with pcids enabled this only flushes the current pcid, which
+             * is exactly the target aspace's */
+            x86_set_cr3(x86_get_cr3());
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < context->count; i++) {
+        __asm__ volatile("invlpg %0" ::"m"(*(uint8_t*)context->vaddr[i]));
+    }
+}
+
 /**
  * @brief Invalidate a single page at a given page table level
  *
@@ -160,16 +252,31 @@ static void tlb_invalidate_page_task(void* raw_context) {
  * @param level The page table level that maps this vaddr
  * @param global_page True if we are invalidating a global mapping
  *
- * TODO(teisenbe): Optimize this.  This is horribly inefficient.
- * We should also change this to pool invalidations from a single
- * "transaction" and then only execute a single mp_sync_exec for that
- * transaction, rather than one per page.
+ * If the aspace has a batched invalidation in progress (see
+ * x86_tlb_pending_begin/flush), the invalidation is pooled and issued as a
+ * single cross-cpu transaction when the mmu operation completes, rather than
+ * one mp_sync_exec per page.
  */
 void x86_tlb_invalidate_page(arch_aspace_t* aspace, vaddr_t vaddr, enum page_table_levels level,
                              bool global_page) {
-    ulong cr3 = aspace ? aspace->pt_phys : x86_get_cr3();
+    if (aspace && aspace->tlb_pending.active) {
+        auto* pending = &aspace->tlb_pending;
+
+        pending->global |= global_page;
+        if (level == PML4_L || pending->count == X86_TLB_PENDING_MAX) {
+            /* past the point where individual invlpgs pay off; flush the
+             * whole context at the end */
+            pending->full = true;
+        } else if (!pending->full) {
+            pending->vaddr[pending->count++] = vaddr;
+        }
+        return;
+    }
+
+    ulong cr3 = aspace ? aspace->pt_phys : (x86_get_cr3() & ~X86_CR3_PCID_MASK);
     struct tlb_invalidate_page_context task_context = {
-        .target_cr3 = cr3, .vaddr = vaddr, .level = level, .global_page = global_page,
+        .aspace = aspace, .target_cr3 = cr3, .vaddr = vaddr, .level = level,
+        .global_page = global_page,
     };
 
     /* Target only CPUs this aspace is active on.  It may be the case that some
@@ -181,13 +288,60 @@ void x86_tlb_invalidate_page(arch_aspace_t* aspace, vaddr_t vaddr, enum page_tab
     if (global_page || aspace == nullptr) {
         targets = MP_CPU_ALL;
     } else {
-        targets = atomic_load(&aspace->active_cpus);
+        /* in addition to the cpus running in the aspace, reach the cpus that
+         * still hold translations tagged with its pcid, so they note that
+         * those are now stale */
+        targets = atomic_load(&aspace->active_cpus) | atomic_load(&aspace->pcid_cpus);
         static_assert(sizeof(mp_cpu_mask_t) == sizeof(aspace->active_cpus), "err");
     }
 
     mp_sync_exec(targets, tlb_invalidate_page_task, &task_context);
 }
 
+/* Start pooling TLB invalidations for an mmu operation on |aspace|.  The
+ * caller must hold whatever lock serializes mmu operations on the aspace. */
+static void x86_tlb_pending_begin(arch_aspace_t* aspace) {
+    DEBUG_ASSERT(!aspace->tlb_pending.active);
+    aspace->tlb_pending.active = true;
+    aspace->tlb_pending.full = false;
+    aspace->tlb_pending.global = false;
+    aspace->tlb_pending.count = 0;
+    list_initialize(&aspace->tlb_pending.free_pages);
+}
+
+/* Issue the pooled invalidations as a single cross-cpu transaction. */
+static void x86_tlb_pending_flush(arch_aspace_t* aspace) {
+    auto* pending = &aspace->tlb_pending;
+    DEBUG_ASSERT(pending->active);
+    pending->active = false;
+
+    if (pending->count != 0 || pending->full) {
+        struct tlb_invalidate_batch_context task_context = {
+            .aspace = aspace,
+            .target_cr3 = aspace->pt_phys,
+            .full = pending->full,
+            .global = pending->global,
+            .count = pending->count,
+            .vaddr = pending->vaddr,
+        };
+
+        mp_cpu_mask_t targets;
+        if (pending->global) {
+            targets = MP_CPU_ALL;
+        } else {
+            targets = atomic_load(&aspace->active_cpus) | atomic_load(&aspace->pcid_cpus);
+        }
+
+        mp_sync_exec(targets, tlb_invalidate_batch_task, &task_context);
+    }
+
+    /* now that no cpu can be walking through them, release any page table
+     * pages torn down during the operation */
+    if (!list_is_empty(&pending->free_pages)) {
+        pmm_free(&pending->free_pages);
+    }
+}
+
 template <int Level>
 struct PageTableBase {
     static constexpr page_table_levels level = static_cast<page_table_levels>(Level);
@@ -551,6 +705,25 @@ static pt_entry_t* _map_alloc_page(void) {
     return page_ptr;
 }
 
+/**
+ * @brief Release a page table page torn down by an unmap
+ *
+ * If the aspace is batching invalidations, the free is deferred until the
+ * batch is flushed, since other cpus may still walk through the page until
+ * their stale translations are shot down.
+ */
+static void x86_mmu_free_page_table(arch_aspace_t* aspace, pt_entry_t* table) {
+    vm_page_t* page = paddr_to_vm_page(X86_VIRT_TO_PHYS(table));
+    DEBUG_ASSERT(page);
+
+    if (aspace && aspace->tlb_pending.active) {
+        list_add_tail(&aspace->tlb_pending.free_pages, &page->free.node);
+        return;
+    }
+
+    pmm_free_page(page);
+}
+
 /*
  * @brief Split the given large page into smaller pages
  */
@@ -762,7 +935,7 @@ static bool x86_mmu_remove_mapping(arch_aspace_t* aspace, pt_entry_t* table,
         }
         if (unmap_page_table) {
             unmap_entry<PageTable>(aspace, new_cursor->vaddr, e);
-            pmm_free_page(paddr_to_vm_page(X86_VIRT_TO_PHYS(next_table)));
+            x86_mmu_free_page_table(aspace, next_table);
             unmapped = true;
         }
         *new_cursor = cursor;
@@ -1121,7 +1294,9 @@ static status_t mmu_unmap(arch_aspace_t* aspace, vaddr_t vaddr, const size_t cou
     };
 
     MappingCursor result;
+    x86_tlb_pending_begin(aspace);
     x86_mmu_remove_mapping<PageTable<MAX_PAGING_LEVEL>>(aspace, aspace->pt_virt, start, &result);
+    x86_tlb_pending_flush(aspace);
     DEBUG_ASSERT(result.size == 0);
 
     if (unmapped)
@@ -1167,8 +1342,10 @@ static status_t mmu_map(arch_aspace_t* aspace, vaddr_t vaddr, paddr_t paddr, con
         .paddr = paddr, .vaddr = vaddr, .size = count * PAGE_SIZE,
     };
     MappingCursor result;
+    x86_tlb_pending_begin(aspace);
     status_t status = x86_mmu_add_mapping<PageTable<MAX_PAGING_LEVEL>>(aspace, aspace->pt_virt,
                                                                        mmu_flags, start, &result);
+    x86_tlb_pending_flush(aspace);
     if (status != NO_ERROR) {
         dprintf(SPEW, "Add mapping failed with err=%d\n", status);
         return status;
@@ -1215,8 +1392,10 @@ static status_t mmu_protect(arch_aspace_t* aspace, vaddr_t vaddr, size_t count,
         .paddr = 0, .vaddr = vaddr, .size = count * PAGE_SIZE,
     };
     MappingCursor result;
+    x86_tlb_pending_begin(aspace);
     status_t status = x86_mmu_update_mapping<PageTable<MAX_PAGING_LEVEL>>(
         aspace, aspace->pt_virt, mmu_flags, start, &result);
+    x86_tlb_pending_flush(aspace);
     if (status != NO_ERROR) {
         return status;
     }
@@ -1303,8 +1482,14 @@ status_t arch_mmu_init_aspace(arch_aspace_t* aspace, vaddr_t base, size_t size,
     }
     aspace->io_bitmap = nullptr;
     aspace->active_cpus = 0;
+    aspace->pcid = 0;
+    aspace->pcid_cpus = 0;
+    aspace->tlb_pending.active = false;
     spin_lock_init(&aspace->io_bitmap_lock);
 
+    if (use_pcid && !(mmu_flags & ARCH_ASPACE_FLAG_KERNEL))
+        aspace->pcid = x86_mmu_alloc_pcid();
+
     return NO_ERROR;
 }
 
@@ -1328,7 +1513,10 @@ status_t guest_mmu_init_paspace(guest_paspace_t* paspace, size_t size) {
     paspace->base = 0;
     paspace->size = size;
     paspace->active_cpus = 0;
+    paspace->pcid = 0;
+    paspace->pcid_cpus = 0;
     paspace->io_bitmap = nullptr;
+    paspace->tlb_pending.active = false;
     spin_lock_init(&paspace->io_bitmap_lock);
 
     return NO_ERROR;
@@ -1364,6 +1552,9 @@ status_t mmu_destroy_aspace(arch_aspace_t* aspace) {
 
     pmm_free_page(paddr_to_vm_page(aspace->pt_phys));
 
+    if (aspace->pcid != 0)
+        x86_mmu_free_pcid(aspace->pcid);
+
     aspace->magic = 0;
 
     return NO_ERROR;
@@ -1377,12 +1568,28 @@ status_t guest_mmu_destroy_paspace(guest_paspace_t* paspace) {
     return mmu_destroy_aspace<ExtendedPageTable>(paspace);
 }
 
+/* Compute the cr3 value used to run |aspace| on the calling cpu.  With pcids
+ * enabled, a cpu that has received no TLB invalidations for the aspace since
+ * it last loaded its cr3 still holds coherent translations, so the implicit
+ * flush of the cr3 load can be skipped.  Interrupts must be disabled (they
+ * are, since we are called under the thread lock) so that an invalidation
+ * cannot slip in between the pcid_cpus update and the cr3 load. */
+static ulong aspace_cr3(arch_aspace_t* aspace, mp_cpu_mask_t cpu_bit) {
+    if (!use_pcid || aspace->pcid == 0)
+        return aspace->pt_phys;
+
+    ulong cr3 = aspace->pt_phys | aspace->pcid;
+    if (atomic_or(&aspace->pcid_cpus, (int)cpu_bit) & (int)cpu_bit)
+        cr3 |= X86_CR3_NOFLUSH;
+    return cr3;
+}
+
 void arch_mmu_context_switch(arch_aspace_t* old_aspace, arch_aspace_t* aspace) {
     mp_cpu_mask_t cpu_bit = 1U << arch_curr_cpu_num();
     if (aspace != nullptr) {
         DEBUG_ASSERT(aspace->magic == ARCH_ASPACE_MAGIC);
         LTRACEF_LEVEL(3, "switching to aspace %p, pt %#" PRIXPTR "\n", aspace, aspace->pt_phys);
-        x86_set_cr3(aspace->pt_phys);
+        x86_set_cr3(aspace_cr3(aspace, cpu_bit));
 
         if (old_aspace != nullptr) {
             atomic_and(&old_aspace->active_cpus, ~cpu_bit);
@@ -1488,6 +1695,12 @@ void x86_mmu_percpu_init(void) {
         cr4 |= X86_CR4_SMEP;
     if (x86_feature_test(X86_FEATURE_SMAP))
         cr4 |= X86_CR4_SMAP;
+    /* Tag TLB entries with per-aspace pcids; requires cr3[11:0] == 0, which
+     * holds here since we are still on the kernel page tables (pcid 0) */
+    if (x86_feature_test(X86_FEATURE_PCID)) {
+        cr4 |= X86_CR4_PCIDE;
+        use_pcid = true;
+    }
     x86_set_cr4(cr4);
 
     /* Set NXE bit in X86_MSR_IA32_EFER*/
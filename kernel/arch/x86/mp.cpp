@@ -26,6 +26,7 @@
 #include <dev/hw_rng.h>
 #include <dev/interrupt.h>
 #include <kernel/event.h>
+#include <kernel/sched.h>
 #include <kernel/timer.h>
 #include <platform.h>
 
@@ -75,9 +76,38 @@ status_t x86_allocate_ap_structures(uint32_t *apic_ids, uint8_t cpu_count)
     }
 
     x86_num_cpus = cpu_count;
+    x86_publish_cpu_topology();
     return NO_ERROR;
 }
 
+// tell the scheduler which cpus share an SMT core and which share a last
+// level cache, derived from the decoded apic ids. we approximate the LLC
+// domain with the package, which is accurate for every part we support.
+void x86_publish_cpu_topology(void)
+{
+    if (x86_num_cpus > SMP_MAX_CPUS)
+        return;
+
+    x86_cpu_topology_t topo[SMP_MAX_CPUS];
+    x86_cpu_topology_decode(apic_local_id(), &topo[0]);
+    for (uint i = 1; i < x86_num_cpus; ++i) {
+        x86_cpu_topology_decode(ap_percpus[i - 1].apic_id, &topo[i]);
+    }
+
+    for (uint i = 0; i < x86_num_cpus; ++i) {
+        mp_cpu_mask_t smt_siblings = 0;
+        mp_cpu_mask_t llc_peers = 0;
+        for (uint j = 0; j < x86_num_cpus; ++j) {
+            if (topo[j].package_id != topo[i].package_id)
+                continue;
+            llc_peers |= (1u << j);
+            if (topo[j].core_id == topo[i].core_id)
+                smt_siblings |= (1u << j);
+        }
+        sched_set_cpu_topology(i, smt_siblings, llc_peers);
+    }
+}
+
 __NO_SAFESTACK uintptr_t x86_init_percpu(uint cpu_num, uintptr_t unsafe_sp)
 {
     struct x86_percpu *percpu;
@@ -238,6 +268,20 @@ int x86_apic_id_to_cpu_num(uint32_t apic_id)
     return -1;
 }
 
+status_t x86_cpu_num_to_apic_id(uint cpu_num, uint32_t *out_apic_id)
+{
+    if (cpu_num >= (uint)x86_num_cpus) {
+        return ERR_INVALID_ARGS;
+    }
+
+    if (cpu_num == 0) {
+        *out_apic_id = bp_percpu.apic_id;
+    } else {
+        *out_apic_id = ap_percpus[cpu_num - 1].apic_id;
+    }
+    return NO_ERROR;
+}
+
 #if WITH_SMP
 status_t arch_mp_send_ipi(mp_cpu_mask_t target, mp_ipi_t ipi)
 {
@@ -0,0 +1,449 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// Performance monitor (PMU) counter support: program the architectural
+// performance monitoring counters per-cpu and read them back, so that
+// userspace can measure events like cache misses and stalled cycles that
+// Intel PT does not provide.
+//
+// This follows the same shape as Intel PT support (proc_trace.cpp): a
+// small MSR driver in the kernel with an mtrace control plane, until
+// "resources" can be used to read/write x86 MSRs. The control plane is
+// in lib/mtrace/mtrace-pmu.cpp.
+
+#include <arch/arch_ops.h>
+#include <arch/x86.h>
+#include <arch/x86/apic.h>
+#include <arch/x86/feature.h>
+#include <arch/x86/pmu.h>
+#include <err.h>
+#include <kernel/auto_lock.h>
+#include <kernel/mp.h>
+#include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <magenta/mtrace.h>
+#include <magenta/thread_annotations.h>
+#include <string.h>
+#include <trace.h>
+
+#define LOCAL_TRACE 0
+
+// Architectural performance monitoring MSRs, Intel Vol. 3 chapter 18.2.
+#define IA32_PMC0 0xC1
+#define IA32_PERFEVTSEL0 0x186
+#define IA32_FIXED_CTR0 0x309
+#define IA32_FIXED_CTR_CTRL 0x38D
+#define IA32_PERF_GLOBAL_STATUS 0x38E
+#define IA32_PERF_GLOBAL_CTRL 0x38F
+#define IA32_PERF_GLOBAL_OVF_CTRL 0x390
+
+// Our own copy of what h/w supports, from cpuid leaf 0xA.
+static bool supports_pmu = false;
+static uint32_t pmu_version = 0;
+static uint32_t num_programmable = 0;
+static uint32_t num_fixed = 0;
+
+// Per-cpu staged configuration and, after stopping, the counter values.
+struct pmu_cpu_state_t {
+    uint64_t evtsel[MX_PMU_MAX_PROGRAMMABLE_COUNTERS];
+    uint64_t fixed_ctrl;
+    uint64_t counters[MX_PMU_MAX_PROGRAMMABLE_COUNTERS];
+    uint64_t fixed[MX_PMU_MAX_FIXED_COUNTERS];
+};
+
+static Mutex pmu_lock;
+
+static pmu_cpu_state_t* pmu_cpu_state TA_GUARDED(pmu_lock);
+
+static bool active TA_GUARDED(pmu_lock) = false;
+
+static pmu_count_mode_t count_mode TA_GUARDED(pmu_lock) = PMU_COUNT_CPUS;
+
+// Fast flag for the context switch path; only true while counting is
+// active in thread mode.
+static bool counting_threads = false;
+
+// Bumped every time counting starts. A thread whose pmu_epoch does not
+// match has no valid mark or accumulated counts from this session; its
+// first accounting charges it from the staged initial counter values
+// (expected to be zero) instead of a stale mark.
+static uint32_t pmu_epoch = 0;
+
+void x86_pmu_init(void)
+{
+    struct cpuid_leaf leaf;
+    if (!x86_get_cpuid_subleaf(X86_CPUID_PERFMON, 0, &leaf)) {
+        return;
+    }
+
+    pmu_version = leaf.a & 0xff;
+    if (pmu_version == 0) {
+        return;
+    }
+
+    supports_pmu = true;
+    num_programmable = (leaf.a >> 8) & 0xff;
+    if (num_programmable > MX_PMU_MAX_PROGRAMMABLE_COUNTERS)
+        num_programmable = MX_PMU_MAX_PROGRAMMABLE_COUNTERS;
+    if (pmu_version >= 2) {
+        num_fixed = leaf.d & 0x1f;
+        if (num_fixed > MX_PMU_MAX_FIXED_COUNTERS)
+            num_fixed = MX_PMU_MAX_FIXED_COUNTERS;
+    }
+}
+
+status_t x86_pmu_set_mode(pmu_count_mode_t mode) {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+    if (pmu_cpu_state)
+        return ERR_BAD_STATE;
+
+    count_mode = mode;
+    return NO_ERROR;
+}
+
+status_t x86_pmu_alloc() {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+    if (pmu_cpu_state)
+        return ERR_BAD_STATE;
+
+    uint32_t num_cpus = arch_max_num_cpus();
+    pmu_cpu_state =
+        reinterpret_cast<pmu_cpu_state_t*>(calloc(num_cpus,
+                                                  sizeof(*pmu_cpu_state)));
+    if (!pmu_cpu_state)
+        return ERR_NO_MEMORY;
+    return NO_ERROR;
+}
+
+// Free resources obtained by x86_pmu_alloc().
+// This doesn't care if resources have already been freed to save callers
+// from having to care during any cleanup.
+
+status_t x86_pmu_free() {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+
+    free(pmu_cpu_state);
+    pmu_cpu_state = nullptr;
+    return NO_ERROR;
+}
+
+// This is invoked via mp_sync_exec which thread safety analysis cannot follow.
+static void x86_pmu_start_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(active && raw_context);
+
+    pmu_cpu_state_t* context = reinterpret_cast<pmu_cpu_state_t*>(raw_context);
+    uint32_t cpu = arch_curr_cpu_num();
+    pmu_cpu_state_t* state = &context[cpu];
+
+    // Disable everything while we reprogram.
+    if (pmu_version >= 2)
+        write_msr(IA32_PERF_GLOBAL_CTRL, 0);
+
+    uint64_t enable = 0;
+    for (uint32_t i = 0; i < num_programmable; i++) {
+        // Note: writes to IA32_PMCx only take the low 32 bits; staged
+        // initial values are expected to be small (usually zero).
+        write_msr(IA32_PMC0 + i, state->counters[i]);
+        write_msr(IA32_PERFEVTSEL0 + i, state->evtsel[i]);
+        if (state->evtsel[i] != 0)
+            enable |= 1ull << i;
+    }
+    for (uint32_t i = 0; i < num_fixed; i++) {
+        write_msr(IA32_FIXED_CTR0 + i, state->fixed[i]);
+        if ((state->fixed_ctrl >> (i * 4)) & 3)
+            enable |= 1ull << (32 + i);
+    }
+    if (num_fixed > 0)
+        write_msr(IA32_FIXED_CTR_CTRL, state->fixed_ctrl);
+
+    if (pmu_version >= 2) {
+        write_msr(IA32_PERF_GLOBAL_OVF_CTRL, read_msr(IA32_PERF_GLOBAL_STATUS));
+        write_msr(IA32_PERF_GLOBAL_CTRL, enable);
+    }
+
+    // Allow counters staged with the interrupt-on-overflow bits to raise
+    // a PMI; counters without them never do, so this is harmless otherwise.
+    apic_pmi_unmask();
+}
+
+// The validation and bookkeeping half of starting: everything except
+// programming the cpus, so that a combined start (MTRACE_KIND_SYNC) can
+// do the programming of several engines in one mp_sync_exec.
+static status_t x86_pmu_arm_locked() TA_REQ(pmu_lock) {
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+    if (!pmu_cpu_state)
+        return ERR_BAD_STATE;
+
+    TRACEF("Enabling performance counters\n");
+
+    active = true;
+    if (count_mode == PMU_COUNT_THREADS) {
+        pmu_epoch++;
+        counting_threads = true;
+    }
+    return NO_ERROR;
+}
+
+// Begin counting.
+
+status_t x86_pmu_start() {
+    AutoLock al(&pmu_lock);
+
+    status_t status = x86_pmu_arm_locked();
+    if (status != NO_ERROR)
+        return status;
+
+    mp_sync_exec(MP_CPU_ALL, x86_pmu_start_cpu_task, pmu_cpu_state);
+    return NO_ERROR;
+}
+
+status_t x86_pmu_sync_arm() {
+    AutoLock al(&pmu_lock);
+    return x86_pmu_arm_locked();
+}
+
+// Runs from the combined start task; the caller armed us first, so the
+// state cannot go away underneath us.
+void x86_pmu_sync_cpu_start() TA_NO_THREAD_SAFETY_ANALYSIS {
+    x86_pmu_start_cpu_task(pmu_cpu_state);
+}
+
+// This is invoked via mp_sync_exec which thread safety analysis cannot follow.
+static void x86_pmu_stop_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(raw_context);
+
+    pmu_cpu_state_t* context = reinterpret_cast<pmu_cpu_state_t*>(raw_context);
+    uint32_t cpu = arch_curr_cpu_num();
+    pmu_cpu_state_t* state = &context[cpu];
+
+    apic_pmi_mask();
+
+    // Disable counting.
+    if (pmu_version >= 2)
+        write_msr(IA32_PERF_GLOBAL_CTRL, 0);
+
+    // Retrieve counter values for later providing to userspace,
+    // then return all control MSRs to the init state.
+    for (uint32_t i = 0; i < num_programmable; i++) {
+        state->counters[i] = read_msr(IA32_PMC0 + i);
+        write_msr(IA32_PERFEVTSEL0 + i, 0);
+    }
+    for (uint32_t i = 0; i < num_fixed; i++) {
+        state->fixed[i] = read_msr(IA32_FIXED_CTR0 + i);
+    }
+    if (num_fixed > 0)
+        write_msr(IA32_FIXED_CTR_CTRL, 0);
+}
+
+// The stop counterpart of x86_pmu_arm_locked().
+static status_t x86_pmu_disarm_locked() TA_REQ(pmu_lock) {
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (!pmu_cpu_state)
+        return ERR_BAD_STATE;
+
+    TRACEF("Disabling performance counters\n");
+
+    counting_threads = false;
+    return NO_ERROR;
+}
+
+// This can be called while not active, so the caller doesn't have to care
+// during any cleanup.
+
+status_t x86_pmu_stop() {
+    AutoLock al(&pmu_lock);
+
+    status_t status = x86_pmu_disarm_locked();
+    if (status != NO_ERROR)
+        return status;
+
+    mp_sync_exec(MP_CPU_ALL, x86_pmu_stop_cpu_task, pmu_cpu_state);
+    active = false;
+    return NO_ERROR;
+}
+
+status_t x86_pmu_sync_disarm() {
+    AutoLock al(&pmu_lock);
+
+    status_t status = x86_pmu_disarm_locked();
+    if (status != NO_ERROR)
+        return status;
+    active = false;
+    return NO_ERROR;
+}
+
+// Runs from the combined stop task after a successful disarm.
+void x86_pmu_sync_cpu_stop() TA_NO_THREAD_SAFETY_ANALYSIS {
+    x86_pmu_stop_cpu_task(pmu_cpu_state);
+}
+
+status_t x86_pmu_stage_cpu_data(uint32_t cpu, const mx_x86_pmu_regs_t* regs) {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+    if (!pmu_cpu_state)
+        return ERR_BAD_STATE;
+    uint32_t num_cpus = arch_max_num_cpus();
+    if (cpu >= num_cpus)
+        return ERR_INVALID_ARGS;
+
+    static_assert(sizeof(pmu_cpu_state[cpu].evtsel) == sizeof(regs->evtsel), "evtsel size mismatch");
+    memcpy(pmu_cpu_state[cpu].evtsel, regs->evtsel, sizeof(regs->evtsel));
+    pmu_cpu_state[cpu].fixed_ctrl = regs->fixed_ctrl;
+    static_assert(sizeof(pmu_cpu_state[cpu].counters) == sizeof(regs->counters), "counters size mismatch");
+    memcpy(pmu_cpu_state[cpu].counters, regs->counters, sizeof(regs->counters));
+    static_assert(sizeof(pmu_cpu_state[cpu].fixed) == sizeof(regs->fixed), "fixed size mismatch");
+    memcpy(pmu_cpu_state[cpu].fixed, regs->fixed, sizeof(regs->fixed));
+
+    return NO_ERROR;
+}
+
+status_t x86_pmu_get_cpu_data(uint32_t cpu, mx_x86_pmu_regs_t* regs) {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (active)
+        return ERR_BAD_STATE;
+    if (!pmu_cpu_state)
+        return ERR_BAD_STATE;
+    uint32_t num_cpus = arch_max_num_cpus();
+    if (cpu >= num_cpus)
+        return ERR_INVALID_ARGS;
+
+    memcpy(regs->evtsel, pmu_cpu_state[cpu].evtsel, sizeof(regs->evtsel));
+    regs->fixed_ctrl = pmu_cpu_state[cpu].fixed_ctrl;
+    memcpy(regs->counters, pmu_cpu_state[cpu].counters, sizeof(regs->counters));
+    memcpy(regs->fixed, pmu_cpu_state[cpu].fixed, sizeof(regs->fixed));
+
+    return NO_ERROR;
+}
+
+// Accumulate counter deltas per thread. The counters run continuously
+// across all threads on a cpu; each context switch charges the outgoing
+// thread with the distance the counters moved while it ran and marks
+// the incoming thread's starting values. A thread's total is therefore
+// valid on any cpu it migrates across, since marks and deltas are
+// always taken on the same cpu.
+void x86_pmu_thread_context_switch(struct thread* oldthread,
+                                   struct thread* newthread) {
+    if (!counting_threads)
+        return;
+
+    bool old_valid = (oldthread->arch.pmu_epoch == pmu_epoch);
+    for (uint32_t i = 0; i < num_programmable; i++) {
+        uint64_t v = read_msr(IA32_PMC0 + i);
+        if (old_valid) {
+            oldthread->arch.pmu_counts[i] += v - oldthread->arch.pmu_mark[i];
+        } else {
+            oldthread->arch.pmu_counts[i] = v;
+        }
+        newthread->arch.pmu_mark[i] = v;
+    }
+    for (uint32_t i = 0; i < num_fixed; i++) {
+        uint64_t v = read_msr(IA32_FIXED_CTR0 + i);
+        uint32_t slot = MX_PMU_MAX_PROGRAMMABLE_COUNTERS + i;
+        if (old_valid) {
+            oldthread->arch.pmu_counts[slot] += v - oldthread->arch.pmu_mark[slot];
+        } else {
+            oldthread->arch.pmu_counts[slot] = v;
+        }
+        newthread->arch.pmu_mark[slot] = v;
+    }
+    oldthread->arch.pmu_epoch = pmu_epoch;
+    newthread->arch.pmu_epoch = pmu_epoch;
+}
+
+// Report the calling thread's accumulated counts, including the delta
+// the counters have moved since it was switched in.
+
+status_t x86_pmu_get_thread_data(mx_x86_pmu_regs_t* regs) {
+    AutoLock al(&pmu_lock);
+
+    if (!supports_pmu)
+        return ERR_NOT_SUPPORTED;
+    if (count_mode != PMU_COUNT_THREADS)
+        return ERR_BAD_STATE;
+    if (!active)
+        return ERR_BAD_STATE;
+
+    memset(regs, 0, sizeof(*regs));
+
+    thread_t* t = get_current_thread();
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, 0);
+    bool valid = (t->arch.pmu_epoch == pmu_epoch);
+    for (uint32_t i = 0; i < num_programmable; i++) {
+        uint64_t v = read_msr(IA32_PMC0 + i);
+        regs->counters[i] =
+            valid ? t->arch.pmu_counts[i] + (v - t->arch.pmu_mark[i]) : v;
+    }
+    for (uint32_t i = 0; i < num_fixed; i++) {
+        uint64_t v = read_msr(IA32_FIXED_CTR0 + i);
+        uint32_t slot = MX_PMU_MAX_PROGRAMMABLE_COUNTERS + i;
+        regs->fixed[i] =
+            valid ? t->arch.pmu_counts[slot] + (v - t->arch.pmu_mark[slot]) : v;
+    }
+    arch_interrupt_restore(state, 0);
+
+    return NO_ERROR;
+}
+
+// The overflow handler is installed once by the mtrace layer before any
+// counter with the interrupt-on-overflow bits can be started, and then
+// only read from interrupt context; no locking is required.
+static x86_pmu_overflow_fn overflow_handler;
+
+void x86_pmu_set_overflow_handler(x86_pmu_overflow_fn handler) {
+    overflow_handler = handler;
+}
+
+enum handler_return x86_pmu_pmi_handler(void) {
+    enum handler_return ret = INT_NO_RESCHEDULE;
+
+    // Overflow status/acknowledge MSRs require version 2; counters cannot
+    // have been programmed to interrupt without them.
+    if (pmu_version >= 2) {
+        uint64_t status = read_msr(IA32_PERF_GLOBAL_STATUS);
+        if (status != 0) {
+            write_msr(IA32_PERF_GLOBAL_OVF_CTRL, status);
+            x86_pmu_overflow_fn handler = overflow_handler;
+            if (handler) {
+                handler(arch_curr_cpu_num(), status);
+                ret = INT_RESCHEDULE;
+            }
+        }
+    }
+
+    // Delivery of the PMI masked the LVT entry; re-arm it.
+    apic_pmi_unmask();
+    return ret;
+}
@@ -242,11 +242,10 @@ static void x86_ipt_start_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYS
     write_msr(IA32_RTIT_CTL, state->ctl);
 }
 
-// Begin the trace.
-
-status_t x86_ipt_cpu_mode_start() {
-    AutoLock al(&ipt_lock);
-
+// The validation and bookkeeping half of starting: everything except
+// programming the cpus, so that a combined start (MTRACE_KIND_SYNC) can
+// do the programming of several engines in one mp_sync_exec.
+static status_t x86_ipt_arm_locked() TA_REQ(ipt_lock) {
     if (!supports_pt)
         return ERR_NOT_SUPPORTED;
     if (trace_mode == IPT_TRACE_THREADS)
@@ -266,11 +265,33 @@ status_t x86_ipt_cpu_mode_start() {
     unsigned nom_freq = (platform_msr >> 8) & 0xff;
     ktrace(TAG_IPT_START, (uint32_t)nom_freq, 0,
            (uint32_t)kernel_cr3, (uint32_t)(kernel_cr3 >> 32));
+    return NO_ERROR;
+}
+
+// Begin the trace.
+
+status_t x86_ipt_cpu_mode_start() {
+    AutoLock al(&ipt_lock);
+
+    status_t status = x86_ipt_arm_locked();
+    if (status != NO_ERROR)
+        return status;
 
     mp_sync_exec(MP_CPU_ALL, x86_ipt_start_cpu_task, ipt_cpu_state);
     return NO_ERROR;
 }
 
+status_t x86_ipt_sync_arm() {
+    AutoLock al(&ipt_lock);
+    return x86_ipt_arm_locked();
+}
+
+// Runs from the combined start task; the caller armed us first, so the
+// state cannot go away underneath us.
+void x86_ipt_sync_cpu_start() TA_NO_THREAD_SAFETY_ANALYSIS {
+    x86_ipt_start_cpu_task(ipt_cpu_state);
+}
+
 // This is invoked via mp_sync_exec which thread safety analysis cannot follow.
 static void x86_ipt_stop_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
     DEBUG_ASSERT(arch_ints_disabled());
@@ -300,24 +321,144 @@ static void x86_ipt_stop_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSI
     // TODO(teisenbe): Clear ADDR* MSRs depending on leaf 1
 }
 
+// The stop counterpart of x86_ipt_arm_locked().
+static status_t x86_ipt_disarm_locked() TA_REQ(ipt_lock) {
+    if (!supports_pt)
+        return ERR_NOT_SUPPORTED;
+    if (trace_mode == IPT_TRACE_THREADS)
+        return ERR_BAD_STATE;
+    if (!ipt_cpu_state)
+        return ERR_BAD_STATE;
+
+    TRACEF("Disabling processor trace\n");
+    return NO_ERROR;
+}
+
 // This can be called while not active, so the caller doesn't have to care
 // during any cleanup.
 
 status_t x86_ipt_cpu_mode_stop() {
     AutoLock al(&ipt_lock);
 
+    status_t status = x86_ipt_disarm_locked();
+    if (status != NO_ERROR)
+        return status;
+
+    mp_sync_exec(MP_CPU_ALL, x86_ipt_stop_cpu_task, ipt_cpu_state);
+    ktrace(TAG_IPT_STOP, 0, 0, 0, 0);
+    active = false;
+    return NO_ERROR;
+}
+
+status_t x86_ipt_sync_disarm() {
+    AutoLock al(&ipt_lock);
+
+    status_t status = x86_ipt_disarm_locked();
+    if (status != NO_ERROR)
+        return status;
+    ktrace(TAG_IPT_STOP, 0, 0, 0, 0);
+    active = false;
+    return NO_ERROR;
+}
+
+// Runs from the combined stop task after a successful disarm.
+void x86_ipt_sync_cpu_stop() TA_NO_THREAD_SAFETY_ANALYSIS {
+    x86_ipt_stop_cpu_task(ipt_cpu_state);
+}
+
+// This is invoked via mp_sync_exec which thread safety analysis cannot follow.
+static void x86_ipt_pause_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(raw_context);
+
+    ipt_cpu_state_t* context = reinterpret_cast<ipt_cpu_state_t*>(raw_context);
+    uint32_t cpu = arch_curr_cpu_num();
+    ipt_cpu_state_t* state = &context[cpu];
+
+    // Disable the trace, but unlike x86_ipt_stop_cpu_task keep the rest of
+    // the configuration loaded so that collection can be resumed where it
+    // left off with x86_ipt_resume_cpu_task.
+    write_msr(IA32_RTIT_CTL, state->ctl & ~IPT_CTL_TRACE_EN);
+
+    // Retrieve the frozen write head for the snapshotter.
+    state->status = read_msr(IA32_RTIT_STATUS);
+    state->output_base = read_msr(IA32_RTIT_OUTPUT_BASE);
+    state->output_mask_ptrs = read_msr(IA32_RTIT_OUTPUT_MASK_PTRS);
+}
+
+// This is invoked via mp_sync_exec which thread safety analysis cannot follow.
+static void x86_ipt_resume_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(raw_context);
+
+    ipt_cpu_state_t* context = reinterpret_cast<ipt_cpu_state_t*>(raw_context);
+    uint32_t cpu = arch_curr_cpu_num();
+    ipt_cpu_state_t* state = &context[cpu];
+
+    write_msr(IA32_RTIT_OUTPUT_BASE, state->output_base);
+    write_msr(IA32_RTIT_OUTPUT_MASK_PTRS, state->output_mask_ptrs);
+    write_msr(IA32_RTIT_STATUS, state->status);
+    write_msr(IA32_RTIT_CTL, state->ctl);
+}
+
+// Pause collection on one cpu so its buffer can be snapshotted, leaving
+// tracing on all other cpus undisturbed. The frozen msr values are returned
+// in |regs|. Only valid while tracing is active.
+
+status_t x86_ipt_cpu_mode_pause(uint32_t cpu, mx_x86_pt_regs_t* regs) {
+    AutoLock al(&ipt_lock);
+
     if (!supports_pt)
         return ERR_NOT_SUPPORTED;
     if (trace_mode == IPT_TRACE_THREADS)
         return ERR_BAD_STATE;
+    if (!active)
+        return ERR_BAD_STATE;
     if (!ipt_cpu_state)
         return ERR_BAD_STATE;
+    uint32_t num_cpus = arch_max_num_cpus();
+    if (cpu >= num_cpus)
+        return ERR_INVALID_ARGS;
 
-    TRACEF("Disabling processor trace\n");
+    mp_sync_exec(1u << cpu, x86_ipt_pause_cpu_task, ipt_cpu_state);
 
-    mp_sync_exec(MP_CPU_ALL, x86_ipt_stop_cpu_task, ipt_cpu_state);
-    ktrace(TAG_IPT_STOP, 0, 0, 0, 0);
-    active = false;
+    ipt_cpu_state_t* state = &ipt_cpu_state[cpu];
+
+    // Emit a correlation marker so that trace decoders can line up the
+    // frozen write head with ktrace timestamps.
+    ktrace(TAG_IPT_SNAPSHOT, cpu, 0,
+           (uint32_t)state->output_mask_ptrs,
+           (uint32_t)(state->output_mask_ptrs >> 32));
+
+    regs->ctl = state->ctl;
+    regs->status = state->status;
+    regs->output_base = state->output_base;
+    regs->output_mask_ptrs = state->output_mask_ptrs;
+    regs->cr3_match = state->cr3_match;
+    static_assert(sizeof(regs->addr_ranges) == sizeof(state->addr_ranges), "addr_ranges size mismatch");
+    memcpy(regs->addr_ranges, state->addr_ranges, sizeof(regs->addr_ranges));
+
+    return NO_ERROR;
+}
+
+// Resume collection paused with x86_ipt_cpu_mode_pause().
+
+status_t x86_ipt_cpu_mode_resume(uint32_t cpu) {
+    AutoLock al(&ipt_lock);
+
+    if (!supports_pt)
+        return ERR_NOT_SUPPORTED;
+    if (trace_mode == IPT_TRACE_THREADS)
+        return ERR_BAD_STATE;
+    if (!active)
+        return ERR_BAD_STATE;
+    if (!ipt_cpu_state)
+        return ERR_BAD_STATE;
+    uint32_t num_cpus = arch_max_num_cpus();
+    if (cpu >= num_cpus)
+        return ERR_INVALID_ARGS;
+
+    mp_sync_exec(1u << cpu, x86_ipt_resume_cpu_task, ipt_cpu_state);
     return NO_ERROR;
 }
 
@@ -330,13 +330,39 @@ void x86_extended_register_restore_state(void *register_state)
     }
 }
 
+/* Returns true if the given xsave image records every component as being in
+ * its INIT configuration. */
+static inline bool xsave_image_all_init(const void *register_state)
+{
+    return ((const struct xsave_area *)register_state)->xstate_bv == 0;
+}
+
 void x86_extended_register_context_switch(
         thread_t *old_thread, thread_t *new_thread)
 {
+    /* If every component is currently in its INIT configuration, a thread
+     * whose saved image already records all-INIT needs neither a save nor a
+     * restore: the registers hold exactly what xrstor would produce.  XINUSE
+     * (xgetbv with ecx = 1) is conservative - it may report an INIT
+     * component as in-use - which only costs us the save/restore we would
+     * have done anyway.  Most kernel worker threads never leave INIT. */
+    bool all_init = false;
+    if (xgetbv_1_supported) {
+        all_init = (x86_xgetbv(1) == 0);
+    }
+
     if (likely(old_thread)) {
-        x86_extended_register_save_state(old_thread->arch.extended_register_state);
+        void *old_state = old_thread->arch.extended_register_state;
+        if (!(all_init && old_state && xsave_image_all_init(old_state))) {
+            x86_extended_register_save_state(old_state);
+        }
+    }
+
+    void *new_state = new_thread->arch.extended_register_state;
+    if (all_init && new_state && xsave_image_all_init(new_state)) {
+        return;
     }
-    x86_extended_register_restore_state(new_thread->arch.extended_register_state);
+    x86_extended_register_restore_state(new_state);
 }
 
 static void read_xsave_state_info(void)
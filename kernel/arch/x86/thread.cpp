@@ -17,6 +17,7 @@
 #include <arch/x86.h>
 #include <arch/x86/descriptor.h>
 #include <arch/x86/mp.h>
+#include <arch/x86/pmu.h>
 #include <arch/x86/registers.h>
 
 void arch_thread_initialize(thread_t *t, vaddr_t entry_point)
@@ -83,6 +84,8 @@ void arch_context_switch(thread_t *oldthread, thread_t *newthread)
 {
     x86_extended_register_context_switch(oldthread, newthread);
 
+    x86_pmu_thread_context_switch(oldthread, newthread);
+
     //printf("cs 0x%llx\n", kstack_top);
 
     /* set the tss SP0 value to point at the top of our stack */
@@ -13,6 +13,7 @@
 #include <arch/x86/interrupts.h>
 #include <arch/x86/mmu.h>
 #include <hypervisor/guest_physical_address_space.h>
+#include <magenta/syscalls/hypervisor.h>
 #include <mxtl/algorithm.h>
 #include <platform/pc/timer.h>
 
@@ -43,16 +44,46 @@ static const uint8_t kModRMRegMask = 0b00111000;
 static const uint32_t kInterruptValid = 1u << 31;
 
 ExitInfo::ExitInfo() {
+    exit_qualification = 0;
+    instruction_length = 0;
+    guest_physical_address = 0;
+    guest_rip = 0;
+
     exit_reason = static_cast<ExitReason>(vmcs_read(VmcsField32::EXIT_REASON));
-    exit_qualification = vmcs_read(VmcsFieldXX::EXIT_QUALIFICATION);
+
+    // External interrupts are the most frequent exit and their handler looks
+    // at no other state; don't pay for any further vmreads.
+    if (exit_reason == ExitReason::EXTERNAL_INTERRUPT)
+        return;
+
     instruction_length = vmcs_read(VmcsField32::EXIT_INSTRUCTION_LENGTH);
-    guest_physical_address = vmcs_read(VmcsField64::GUEST_PHYSICAL_ADDRESS);
     guest_rip = vmcs_read(VmcsFieldXX::GUEST_RIP);
 
-    if (exit_reason == ExitReason::EXTERNAL_INTERRUPT ||
-        exit_reason == ExitReason::HLT ||
-        exit_reason == ExitReason::IO_INSTRUCTION)
+    switch (exit_reason) {
+    case ExitReason::CPUID:
+    case ExitReason::HLT:
+    case ExitReason::RDMSR:
+    case ExitReason::WRMSR:
+    case ExitReason::XSETBV:
+        // Lightweight exits, emulated entirely from guest registers; skip
+        // the remaining vmreads and the tracing below.
+        return;
+    case ExitReason::IO_INSTRUCTION:
+    case ExitReason::APIC_ACCESS:
+        exit_qualification = vmcs_read(VmcsFieldXX::EXIT_QUALIFICATION);
         return;
+    case ExitReason::EPT_VIOLATION:
+        // EPT violations are how guest physical mappings get populated, so
+        // they are frequent while the guest is warming up; stay quiet.
+        exit_qualification = vmcs_read(VmcsFieldXX::EXIT_QUALIFICATION);
+        guest_physical_address = vmcs_read(VmcsField64::GUEST_PHYSICAL_ADDRESS);
+        return;
+    default:
+        break;
+    }
+
+    exit_qualification = vmcs_read(VmcsFieldXX::EXIT_QUALIFICATION);
+    guest_physical_address = vmcs_read(VmcsField64::GUEST_PHYSICAL_ADDRESS);
 
     dprintf(SPEW, "exit reason: %#" PRIx32 "\n", static_cast<uint32_t>(exit_reason));
     dprintf(SPEW, "exit qualification: %#" PRIx64 "\n", exit_qualification);
@@ -82,6 +113,60 @@ static void next_rip(const ExitInfo& exit_info) {
     vmcs_write(VmcsFieldXX::GUEST_RIP, exit_info.guest_rip + exit_info.instruction_length);
 }
 
+// Punts an exit the in-kernel handlers do not emulate to the VMM: the guest
+// registers and exit information are stored in the shared vcpu state area
+// and ERR_SHOULD_WAIT propagates out of the enter syscall. The VMM emulates
+// the access directly against the state area, sets MX_VCPU_STATE_REGS_DIRTY
+// and re-enters the guest; see load_vcpu_state below for the return trip.
+static status_t punt_to_user(const ExitInfo& exit_info, const GuestState* guest_state,
+                             mx_vcpu_state_t* vcpu_state) {
+    if (vcpu_state == nullptr)
+        return ERR_NOT_SUPPORTED;
+
+    vcpu_state->rax = guest_state->rax;
+    vcpu_state->rbx = guest_state->rbx;
+    vcpu_state->rcx = guest_state->rcx;
+    vcpu_state->rdx = guest_state->rdx;
+    vcpu_state->rdi = guest_state->rdi;
+    vcpu_state->rsi = guest_state->rsi;
+    vcpu_state->rbp = guest_state->rbp;
+    vcpu_state->r8 = guest_state->r8;
+    vcpu_state->r9 = guest_state->r9;
+    vcpu_state->r10 = guest_state->r10;
+    vcpu_state->r11 = guest_state->r11;
+    vcpu_state->r12 = guest_state->r12;
+    vcpu_state->r13 = guest_state->r13;
+    vcpu_state->r14 = guest_state->r14;
+    vcpu_state->r15 = guest_state->r15;
+    vcpu_state->rip = exit_info.guest_rip;
+
+    vcpu_state->exit_reason = static_cast<uint32_t>(exit_info.exit_reason);
+    vcpu_state->instruction_length = exit_info.instruction_length;
+    vcpu_state->exit_qualification = exit_info.exit_qualification;
+    vcpu_state->guest_physical_address = exit_info.guest_physical_address;
+
+    vcpu_state->flags = 0;
+    return ERR_SHOULD_WAIT;
+}
+
+void load_vcpu_state(GuestState* guest_state, const mx_vcpu_state_t* vcpu_state) {
+    guest_state->rax = vcpu_state->rax;
+    guest_state->rbx = vcpu_state->rbx;
+    guest_state->rcx = vcpu_state->rcx;
+    guest_state->rdx = vcpu_state->rdx;
+    guest_state->rdi = vcpu_state->rdi;
+    guest_state->rsi = vcpu_state->rsi;
+    guest_state->rbp = vcpu_state->rbp;
+    guest_state->r8 = vcpu_state->r8;
+    guest_state->r9 = vcpu_state->r9;
+    guest_state->r10 = vcpu_state->r10;
+    guest_state->r11 = vcpu_state->r11;
+    guest_state->r12 = vcpu_state->r12;
+    guest_state->r13 = vcpu_state->r13;
+    guest_state->r14 = vcpu_state->r14;
+    guest_state->r15 = vcpu_state->r15;
+}
+
 static status_t handle_external_interrupt() {
     DEBUG_ASSERT(arch_ints_disabled());
     arch_enable_ints();
@@ -160,13 +245,19 @@ static status_t handle_io(const ExitInfo& exit_info, GuestState* guest_state,
 #endif // WITH_LIB_MAGENTA
 }
 
-static status_t handle_rdmsr(const ExitInfo& exit_info, GuestState* guest_state) {
+static status_t handle_rdmsr(const ExitInfo& exit_info, GuestState* guest_state,
+                             LocalApicState* local_apic_state) {
     switch (guest_state->rcx) {
     case X86_MSR_IA32_APIC_BASE:
         next_rip(exit_info);
         guest_state->rax = kIa32ApicBase;
         guest_state->rdx = 0;
         return NO_ERROR;
+    case X86_MSR_IA32_TSC_DEADLINE:
+        next_rip(exit_info);
+        guest_state->rax = local_apic_state->tsc_deadline & 0xffffffff;
+        guest_state->rdx = local_apic_state->tsc_deadline >> 32;
+        return NO_ERROR;
     // From Volume 3, Section 28.2.6.2: The MTRRs have no effect on the memory
     // type used for an access to a guest-physical address.
     case X86_MSR_IA32_MTRRCAP:
@@ -472,8 +563,13 @@ static status_t handle_apic_access(const ExitInfo& exit_info, GuestState* guest_
 static status_t handle_ept_violation(const ExitInfo& exit_info, GuestState* guest_state,
                                      IoApicState* io_apic_state, GuestPhysicalAddressSpace* gpas) {
     if (exit_info.guest_physical_address < kIoApicPhysBase ||
-        exit_info.guest_physical_address >= kIoApicPhysBase + PAGE_SIZE)
-        return ERR_OUT_OF_RANGE;
+        exit_info.guest_physical_address >= kIoApicPhysBase + PAGE_SIZE) {
+        // The EPT is populated lazily: a violation outside of emulated MMIO
+        // means the guest touched a page which has not been mapped yet.
+        // Build the mapping and resume the guest; the faulting instruction
+        // is re-executed.
+        return gpas->PageFault(exit_info.guest_physical_address);
+    }
 
     uint8_t inst_buf[kMaxInstructionLength];
     uint32_t inst_len = exit_info.instruction_length;
@@ -552,40 +648,55 @@ static status_t handle_xsetbv(const ExitInfo& exit_info, GuestState* guest_state
 
 status_t vmexit_handler(GuestState* guest_state, LocalApicState* local_apic_state,
                         IoApicState* io_apic_state, GuestPhysicalAddressSpace* gpas,
-                        FifoDispatcher* serial_fifo) {
+                        FifoDispatcher* serial_fifo, mx_vcpu_state_t* vcpu_state) {
     ExitInfo exit_info;
+    status_t status;
 
     switch (exit_info.exit_reason) {
     case ExitReason::EXTERNAL_INTERRUPT:
         return handle_external_interrupt();
+    // The hot exits (CPUID, MSR accesses, APIC access, EPT violation) are
+    // handled without tracing; their handlers touch nothing but guest
+    // registers and the VMCS before re-entering the guest.
     case ExitReason::CPUID:
-        dprintf(SPEW, "handling CPUID instruction\n\n");
-        return handle_cpuid(exit_info, guest_state);
+        status = handle_cpuid(exit_info, guest_state);
+        break;
     case ExitReason::HLT:
-        return handle_hlt(exit_info, local_apic_state);
+        status = handle_hlt(exit_info, local_apic_state);
+        break;
     case ExitReason::IO_INSTRUCTION:
-        return handle_io(exit_info, guest_state, serial_fifo);
+        status = handle_io(exit_info, guest_state, serial_fifo);
+        break;
     case ExitReason::RDMSR:
-        dprintf(SPEW, "handling RDMSR instruction\n\n");
-        return handle_rdmsr(exit_info, guest_state);
+        status = handle_rdmsr(exit_info, guest_state, local_apic_state);
+        break;
     case ExitReason::WRMSR:
-        dprintf(SPEW, "handling WRMSR instruction\n\n");
-        return handle_wrmsr(exit_info, guest_state, local_apic_state);
+        status = handle_wrmsr(exit_info, guest_state, local_apic_state);
+        break;
     case ExitReason::ENTRY_FAILURE_GUEST_STATE:
     case ExitReason::ENTRY_FAILURE_MSR_LOADING:
         dprintf(SPEW, "handling VM entry failure\n\n");
         return ERR_BAD_STATE;
     case ExitReason::APIC_ACCESS:
-        dprintf(SPEW, "handling APIC access\n\n");
-        return handle_apic_access(exit_info, guest_state, local_apic_state, gpas);
+        status = handle_apic_access(exit_info, guest_state, local_apic_state, gpas);
+        break;
     case ExitReason::EPT_VIOLATION:
-        dprintf(SPEW, "handling EPT violation\n\n");
-        return handle_ept_violation(exit_info, guest_state, io_apic_state, gpas);
+        status = handle_ept_violation(exit_info, guest_state, io_apic_state, gpas);
+        break;
     case ExitReason::XSETBV:
         dprintf(SPEW, "handling XSETBV instruction\n\n");
-        return handle_xsetbv(exit_info, guest_state);
+        status = handle_xsetbv(exit_info, guest_state);
+        break;
     default:
         dprintf(SPEW, "unhandled VM exit %u\n\n", static_cast<uint32_t>(exit_info.exit_reason));
-        return ERR_NOT_SUPPORTED;
+        status = ERR_NOT_SUPPORTED;
+        break;
     }
+
+    // Exits the in-kernel handlers decline are offered to the VMM through
+    // the shared vcpu state area when one has been set up; without one the
+    // old behavior (kill the run loop) is preserved.
+    if (status == ERR_NOT_SUPPORTED)
+        status = punt_to_user(exit_info, guest_state, vcpu_state);
+    return status;
 }
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 
+typedef struct mx_vcpu_state mx_vcpu_state_t;
+
 class FifoDispatcher;
 class GuestPhysicalAddressSpace;
 struct GuestState;
@@ -80,6 +82,9 @@ struct Instruction {
 status_t decode_instruction(const uint8_t* inst_buf, uint32_t inst_len, GuestState* guest_state,
                             Instruction* inst);
 
+/* Reload guest registers from the shared vcpu state area before re-entry. */
+void load_vcpu_state(GuestState* guest_state, const mx_vcpu_state_t* vcpu_state);
+
 status_t vmexit_handler(GuestState* guest_state, LocalApicState* local_apic_state,
                         IoApicState* io_apic_state, GuestPhysicalAddressSpace* gpas,
-                        FifoDispatcher* serial_fifo);
+                        FifoDispatcher* serial_fifo, mx_vcpu_state_t* vcpu_state);
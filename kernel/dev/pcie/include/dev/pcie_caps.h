@@ -57,6 +57,19 @@ constexpr uint8_t PCIE_CAP_ID_ENHANCED_ALLOCATION      = 0x14;
 
 #define PCIE_CAP_MSI_CTRL_SET_MME(val, ctrl)    (uint16_t)((ctrl & ~0x0070) | ((val & 0x7) << 4))
 #define PCIE_CAP_MSI_CTRL_SET_ENB(val, ctrl)    (uint16_t)((ctrl & ~0x0001) | (!!val))
+
+/**
+ * Structure definitions for capability PCIE_CAP_ID_MSIX
+ *
+ * @see The PCI Local Bus specificiaion v3.0 Section 6.8.2
+ */
+#define PCIE_CAP_MSIX_CTRL_TABLE_SIZE(ctrl)         ((uint)(ctrl & 0x07FF) + 1)
+#define PCIE_CAP_MSIX_CTRL_GET_FUNC_MASK(ctrl)      ((ctrl & 0x4000) != 0)
+#define PCIE_CAP_MSIX_CTRL_GET_ENB(ctrl)            ((ctrl & 0x8000) != 0)
+#define PCIE_CAP_MSIX_CTRL_SET_FUNC_MASK(val, ctrl) (uint16_t)((ctrl & ~0x4000) | ((val) ? 0x4000 : 0))
+#define PCIE_CAP_MSIX_CTRL_SET_ENB(val, ctrl)       (uint16_t)((ctrl & ~0x8000) | ((val) ? 0x8000 : 0))
+#define PCIE_CAP_MSIX_TABLE_BIR(val)                ((val) & 0x7)
+#define PCIE_CAP_MSIX_TABLE_OFFSET(val)             ((val) & ~0x7u)
 #define PCS_CAPS_V1_ENDPOINT_SIZE        ((uint)offsetof(pcie_capabilities_t, link))
 #define PCS_CAPS_V1_UPSTREAM_PORT_SIZE   ((uint)offsetof(pcie_capabilities_t, slot))
 #define PCS_CAPS_V1_DOWNSTREAM_PORT_SIZE ((uint)offsetof(pcie_capabilities_t, root))
@@ -221,6 +234,12 @@ private:
     unsigned int max_irqs_ = 0;
     pcie_msi_block_t irq_block_;
 
+    /* Software shadow of the per-vector mask register.  Once the capability
+     * has been parsed the kernel owns every write to the register, so the
+     * shadow lets the per-interrupt mask/unmask paths skip the config space
+     * read of the read-modify-write cycle. */
+    uint32_t mask_bits_shadow_ = 0;
+
     // Cached registers
     PciReg16 ctrl_;
     PciReg32 addr_;
@@ -230,6 +249,52 @@ private:
     PciReg32 pending_bits_;
 };
 
+/* MSI-X Interrupts.
+ * @see PCI Local Bus Spec v3.0 section 6.8.2
+ */
+class PciCapMsix : public PciStdCapability {
+public:
+    static constexpr uint16_t kControlOffset = 0x02;
+    static constexpr uint16_t kTableOffset   = 0x04;
+    static constexpr uint16_t kPbaOffset     = 0x08;
+
+    /* Layout of a single entry in the vector table (all 32 bit registers) */
+    static constexpr uint     kEntryAddrWord       = 0;
+    static constexpr uint     kEntryAddrUpperWord  = 1;
+    static constexpr uint     kEntryDataWord       = 2;
+    static constexpr uint     kEntryVectorCtrlWord = 3;
+    static constexpr uint     kEntryWords          = 4;
+    static constexpr uint32_t kVectorCtrlMaskBit   = 0x00000001;
+
+    PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id);
+    ~PciCapMsix() {}
+
+    // Accessors
+    uint     table_size()   const { return table_size_; }
+    uint     table_bar()    const { return table_bar_; }
+    uint32_t table_offset() const { return table_offset_; }
+    uint     pba_bar()      const { return pba_bar_; }
+    uint32_t pba_offset()   const { return pba_offset_; }
+    PciReg16 ctrl_reg()     const { return ctrl_; }
+
+private:
+    friend class PcieDevice;
+    uint     table_size_   = 0;  /* Number of entries in the vector table */
+    uint     table_bar_    = 0;  /* BAR register holding the vector table */
+    uint32_t table_offset_ = 0;  /* Byte offset of the table within its BAR */
+    uint     pba_bar_      = 0;  /* BAR register holding the pending bit array */
+    uint32_t pba_offset_   = 0;  /* Byte offset of the PBA within its BAR */
+    pcie_msi_block_t irq_block_;
+
+    /* Kernel mapping of the vector table, valid only while the device is in
+     * MSI-X mode.  Owned and managed by PcieDevice. */
+    void* table_mapping_ = nullptr;
+    volatile uint32_t* table_ = nullptr;
+
+    // Cached registers
+    PciReg16 ctrl_;
+};
+
 /* PCI Express Capability classes */
 
 class PciCapPcie : public PciStdCapability {
@@ -271,6 +271,32 @@ public:
      */
     status_t MaskUnmaskIrq(uint irq_id, bool mask);
 
+    /**
+     * Direct the specified IRQ at a chosen CPU.
+     *
+     * Only supported while the device is operating in MSI-X mode; each MSI-X
+     * table entry carries its own target address, so individual vectors may be
+     * steered at different CPUs.  Vectors are spread round-robin across the
+     * online CPUs when MSI-X mode is entered; this API exists for drivers
+     * (multi-queue NICs, NVMe, and friends) which want a specific
+     * queue-to-CPU assignment instead.
+     *
+     * @param irq_id The ID of the IRQ to re-target.
+     * @param cpu The target CPU number.
+     *
+     * @return A status_t indicating the success or failure of the operation.
+     * Status codes may include (but are not limited to)...
+     *
+     * ++ ERR_BAD_STATE
+     *    The device is not currently in MSI-X IRQ mode.
+     * ++ ERR_INVALID_ARGS
+     *    The irq_id parameter is out of range, or the cpu parameter does not
+     *    name an online CPU.
+     * ++ ERR_NOT_SUPPORTED
+     *    The platform cannot steer individual vectors.
+     */
+    status_t SetIrqAffinity(uint irq_id, uint cpu);
+
     void SetQuirksDone() { quirks_done_ = true; }
 
     /**
@@ -411,6 +437,35 @@ private:
     enum handler_return        MsiIrqHandler(pcie_irq_handler_state_t& hstate);
     static enum handler_return MsiIrqHandlerThunk(void *arg);
 
+    // Internal MSI-X IRQ support.
+    void SetMsixEnb(bool enb, bool func_mask) {
+        DEBUG_ASSERT(irq_.msix);
+        DEBUG_ASSERT(irq_.msix->is_valid());
+        uint16_t ctrl = cfg_->Read(irq_.msix->ctrl_reg());
+        cfg_->Write(irq_.msix->ctrl_reg(),
+                PCIE_CAP_MSIX_CTRL_SET_ENB(enb,
+                PCIE_CAP_MSIX_CTRL_SET_FUNC_MASK(func_mask, ctrl)));
+    }
+
+    volatile uint32_t* MsixEntry(uint irq_id) {
+        DEBUG_ASSERT(irq_.msix && irq_.msix->table_);
+        DEBUG_ASSERT(irq_id < irq_.msix->table_size());
+        return irq_.msix->table_ + (irq_id * PciCapMsix::kEntryWords);
+    }
+
+    status_t MapMsixTableLocked();
+    void     UnmapMsixTableLocked();
+    void     SetMsixVectorTargetLocked(uint irq_id, uint64_t tgt_addr, uint32_t tgt_data);
+    bool     MaskUnmaskMsixIrqLocked(uint irq_id, bool mask);
+    status_t MaskUnmaskMsixIrq(uint irq_id, bool mask);
+    void     MaskAllMsixVectors();
+    void     FreeMsixBlock();
+    void     LeaveMsixIrqMode();
+    status_t EnterMsixIrqMode(uint requested_irqs);
+
+    enum handler_return        MsixIrqHandler(pcie_irq_handler_state_t& hstate);
+    static enum handler_return MsixIrqHandlerThunk(void *arg);
+
     // Common Internal IRQ support.
     void     ResetCommonIrqBookkeeping();
     status_t AllocIrqHandlers(uint requested_irqs, bool is_masked);
@@ -444,8 +499,7 @@ private:
             mxtl::RefPtr<SharedLegacyIrqHandler> shared_handler;
         } legacy;
 
-        PciCapMsi* msi = nullptr;
-        /* TODO(johngro) : Add MSI-X state */
-        struct { } msi_x;
+        PciCapMsi*  msi  = nullptr;
+        PciCapMsix* msix = nullptr;
     } irq_;
 };
@@ -129,6 +129,22 @@ public:
         DEBUG_ASSERT(false);
     }
 
+    /**
+     * Method used to compute the MSI/MSI-X target address which delivers
+     * interrupts to a specific CPU.  Optional; platforms which cannot steer
+     * individual vectors do not override it, in which case every vector uses
+     * the target address chosen at block allocation time.
+     *
+     * @param cpu_num The target CPU number.
+     * @param out_tgt_addr A pointer to storage for the computed target write
+     *        transaction physical address.
+     *
+     * @return A status code indicating the success or failure of the operation.
+     */
+    virtual status_t MsiTargetAddrForCpu(uint cpu_num, uint64_t* out_tgt_addr) const {
+        return ERR_NOT_SUPPORTED;
+    }
+
     /**
      * Method used for masking/unmaskingof MSI handlers at the platform level.
      *
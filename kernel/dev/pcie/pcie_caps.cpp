@@ -247,8 +247,50 @@ PciCapMsi::PciCapMsi(const PcieDevice& dev, uint16_t base, uint8_t id)
      */
     cfg->Write(ctrl_reg(), PCIE_CAP_MSI_CTRL_SET_MME(0,
                            PCIE_CAP_MSI_CTRL_SET_ENB(0, ctrl)));
-    if (has_pvm_)
+    if (has_pvm_) {
         cfg->Write(mask_bits_reg(), 0xFFFFFFFF);
+        mask_bits_shadow_ = 0xFFFFFFFF;
+    }
+
+    is_valid_ = true;
+}
+
+/*
+ * @see PCI Local Bus Specification 3.0 Section 6.8.2
+ */
+PciCapMsix::PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id)
+    : PciStdCapability(dev, base, id) {
+    DEBUG_ASSERT(id == PCIE_CAP_ID_MSIX);
+    auto cfg = dev.config();
+
+    ctrl_ = PciReg16(static_cast<uint16_t>(base_ + kControlOffset));
+
+    uint16_t ctrl = cfg->Read(ctrl_reg());
+    table_size_ = PCIE_CAP_MSIX_CTRL_TABLE_SIZE(ctrl);
+
+    uint32_t table_val = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kTableOffset)));
+    table_bar_    = PCIE_CAP_MSIX_TABLE_BIR(table_val);
+    table_offset_ = PCIE_CAP_MSIX_TABLE_OFFSET(table_val);
+
+    uint32_t pba_val = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kPbaOffset)));
+    pba_bar_    = PCIE_CAP_MSIX_TABLE_BIR(pba_val);
+    pba_offset_ = PCIE_CAP_MSIX_TABLE_OFFSET(pba_val);
+
+    if (table_bar_ >= PCIE_MAX_BAR_REGS || pba_bar_ >= PCIE_MAX_BAR_REGS) {
+        TRACEF("Device %02x:%02x.%01x (%04hx:%04hx) has illegal BAR indices in "
+               "its MSI-X capability structure (table %u, PBA %u)\n",
+               dev.bus_id(), dev.dev_id(), dev.func_id(),
+               dev.vendor_id(), dev.device_id(),
+               table_bar_, pba_bar_);
+        return;
+    }
+
+    memset(&irq_block_, 0, sizeof(irq_block_));
+
+    /* Success!  Make sure that MSI-X starts out disabled with the function
+     * mask asserted, then record our capabilities and we are done. */
+    cfg->Write(ctrl_reg(), PCIE_CAP_MSIX_CTRL_SET_ENB(0,
+                           PCIE_CAP_MSIX_CTRL_SET_FUNC_MASK(1, ctrl)));
 
     is_valid_ = true;
 }
@@ -294,7 +336,10 @@ status_t PcieDevice::ParseStdCapabilitiesLocked() {
             break;
         }
 
-        uint8_t id = cfg_->Read(PciReg8(cap_offset));
+        /* The id and the next pointer live in the first two bytes of every
+         * capability; fetch both with a single config space read. */
+        uint16_t cap_hdr = cfg_->Read(PciReg16(cap_offset));
+        uint8_t id = static_cast<uint8_t>(cap_hdr & 0xFF);
 
         LTRACEF("Found capability (#%u, id = 0x%02x) for device %02x:%02x.%01x (%04hx:%04hx)\n",
                 caps_found, id,
@@ -313,6 +358,8 @@ status_t PcieDevice::ParseStdCapabilitiesLocked() {
         switch(id) {
             case PCIE_CAP_ID_MSI:
                 cap = irq_.msi = new (&ac) PciCapMsi(*this, cap_offset, id); break;
+            case PCIE_CAP_ID_MSIX:
+                cap = irq_.msix = new (&ac) PciCapMsix(*this, cap_offset, id); break;
             case PCIE_CAP_ID_PCI_EXPRESS:
                 cap = pcie_ = new (&ac) PciCapPcie(*this, cap_offset, id); break;
             case PCIE_CAP_ID_ADVANCED_FEATURES:
@@ -328,7 +375,7 @@ status_t PcieDevice::ParseStdCapabilitiesLocked() {
         }
 
         caps_.detected.push_front(mxtl::unique_ptr<PciStdCapability>(cap));
-        cap_offset  = cfg_->Read(PciReg8(static_cast<uint16_t>(cap_offset + 0x1))) & 0xFC;
+        cap_offset  = static_cast<uint8_t>((cap_hdr >> 8) & 0xFC);
         caps_found++;
     }
 
@@ -12,9 +12,11 @@
 #include <dev/pcie_bridge.h>
 #include <dev/pcie_root.h>
 #include <err.h>
+#include <kernel/mp.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/vm.h>
+#include <kernel/vm/vm_aspace.h>
 #include <list.h>
 #include <new.h>
 #include <pow2.h>
@@ -288,13 +290,18 @@ bool PcieDevice::MaskUnmaskMsiIrqLocked(uint irq_id, bool mask) {
                  bus_drv_.platform().supports_msi_masking() ||
                  irq_.msi->has_pvm());
 
-    /* If we can mask at the PCI device level, do so. */
+    /* If we can mask at the PCI device level, do so.  The shadow of the mask
+     * register is authoritative (we own every write to the register), so this
+     * costs us at most a single config space write and no reads. */
     if (irq_.msi->has_pvm()) {
         DEBUG_ASSERT(irq_id < PCIE_MAX_MSI_IRQS);
-        uint32_t  val  = cfg_->Read(irq_.msi->mask_bits_reg());
+        uint32_t  val  = irq_.msi->mask_bits_shadow_;
         if (mask) val |=  (static_cast<uint32_t>(1u) << irq_id);
         else      val &= ~(static_cast<uint32_t>(1u) << irq_id);
-        cfg_->Write(irq_.msi->mask_bits_reg(), val);
+        if (val != irq_.msi->mask_bits_shadow_) {
+            cfg_->Write(irq_.msi->mask_bits_reg(), val);
+            irq_.msi->mask_bits_shadow_ = val;
+        }
     }
 
     /* If we can mask at the platform interrupt controller level, do so. */
@@ -338,8 +345,10 @@ void PcieDevice::MaskAllMsiVectors() {
     /* In theory, this should not be needed as all of the relevant bits should
      * have already been masked during the calls to MaskUnmaskMsiIrq.  Just to
      * be careful, however, we explicitly mask all of the upper bits as well. */
-    if (irq_.msi->has_pvm())
+    if (irq_.msi->has_pvm()) {
         cfg_->Write(irq_.msi->mask_bits_reg(), 0xFFFFFFFF);
+        irq_.msi->mask_bits_shadow_ = 0xFFFFFFFF;
+    }
 }
 
 void PcieDevice::SetMsiTarget(uint64_t tgt_addr, uint32_t tgt_data) {
@@ -431,6 +440,7 @@ status_t PcieDevice::EnterMsiIrqMode(uint requested_irqs) {
     bool initially_masked;
     if (irq_.msi->has_pvm()) {
         cfg_->Write(irq_.msi->mask_bits_reg(), 0xFFFFFFFF);
+        irq_.msi->mask_bits_shadow_ = 0xFFFFFFFF;
         initially_masked = true;
     } else {
         // If we cannot mask at the PCI level, then our IRQs will be initially
@@ -529,6 +539,293 @@ enum handler_return PcieDevice::MsiIrqHandlerThunk(void *arg) {
     return hstate.dev->MsiIrqHandler(hstate);
 }
 
+/******************************************************************************
+ *
+ * MSI-X IRQ mode routines.
+ *
+ ******************************************************************************/
+status_t PcieDevice::MapMsixTableLocked() {
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+    DEBUG_ASSERT(irq_.msix && irq_.msix->is_valid());
+    DEBUG_ASSERT(irq_.msix->table_mapping_ == nullptr);
+
+    /* The vector table lives somewhere in one of the device's MMIO BARs.  The
+     * BAR must have been successfully allocated during the bus scan for the
+     * table to have a home we can map. */
+    const pcie_bar_info_t* info = GetBarInfo(irq_.msix->table_bar());
+    if ((info == nullptr) || !info->is_mmio)
+        return ERR_BAD_STATE;
+
+    size_t   table_bytes = irq_.msix->table_size() * PciCapMsix::kEntryWords * sizeof(uint32_t);
+    uint64_t table_start = irq_.msix->table_offset();
+    if ((table_start + table_bytes) > info->size)
+        return ERR_BAD_STATE;
+
+    /* Map the page aligned window which contains the table. */
+    paddr_t table_phys = info->bus_addr + table_start;
+    paddr_t map_phys   = ROUNDDOWN(table_phys, PAGE_SIZE);
+    size_t  map_size   = ROUNDUP(table_phys + table_bytes, PAGE_SIZE) - map_phys;
+
+    char name_buf[32];
+    snprintf(name_buf, sizeof(name_buf), "msix_%02x_%02x_%01x", bus_id_, dev_id_, func_id_);
+
+    void* vaddr;
+    status_t res = VmAspace::kernel_aspace()->AllocPhysical(
+            name_buf,
+            map_size,
+            &vaddr,
+            PAGE_SIZE_SHIFT,
+            map_phys,
+            0 /* vmm flags */,
+            ARCH_MMU_FLAG_UNCACHED_DEVICE |
+            ARCH_MMU_FLAG_PERM_READ |
+            ARCH_MMU_FLAG_PERM_WRITE);
+    if (res != NO_ERROR)
+        return res;
+
+    irq_.msix->table_mapping_ = vaddr;
+    irq_.msix->table_ = reinterpret_cast<volatile uint32_t*>(
+            reinterpret_cast<uintptr_t>(vaddr) + (table_phys - map_phys));
+    return NO_ERROR;
+}
+
+void PcieDevice::UnmapMsixTableLocked() {
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+    DEBUG_ASSERT(irq_.msix);
+
+    if (irq_.msix->table_mapping_ != nullptr) {
+        VmAspace::kernel_aspace()->FreeRegion(
+                reinterpret_cast<vaddr_t>(irq_.msix->table_mapping_));
+        irq_.msix->table_mapping_ = nullptr;
+        irq_.msix->table_ = nullptr;
+    }
+}
+
+void PcieDevice::SetMsixVectorTargetLocked(uint irq_id, uint64_t tgt_addr, uint32_t tgt_data) {
+    DEBUG_ASSERT(irq_.msix && irq_.msix->table_);
+    DEBUG_ASSERT(irq_id < irq_.msix->table_size());
+
+    /* Mask the vector while we change its address and data; the spec does not
+     * guarantee an atomic update of anything but a single DWORD, and we must
+     * never allow the device to send a half-updated message. */
+    volatile uint32_t* entry = MsixEntry(irq_id);
+    uint32_t vctrl = entry[PciCapMsix::kEntryVectorCtrlWord];
+    entry[PciCapMsix::kEntryVectorCtrlWord] = vctrl | PciCapMsix::kVectorCtrlMaskBit;
+
+    entry[PciCapMsix::kEntryAddrWord]      = static_cast<uint32_t>(tgt_addr & 0xFFFFFFFF);
+    entry[PciCapMsix::kEntryAddrUpperWord] = static_cast<uint32_t>(tgt_addr >> 32);
+    entry[PciCapMsix::kEntryDataWord]      = tgt_data;
+
+    entry[PciCapMsix::kEntryVectorCtrlWord] = vctrl;
+}
+
+bool PcieDevice::MaskUnmaskMsixIrqLocked(uint irq_id, bool mask) {
+    DEBUG_ASSERT(irq_.mode == PCIE_IRQ_MODE_MSI_X);
+    DEBUG_ASSERT(irq_id < irq_.handler_count);
+    DEBUG_ASSERT(irq_.handlers);
+
+    pcie_irq_handler_state_t& hstate = irq_.handlers[irq_id];
+    DEBUG_ASSERT(hstate.lock.IsHeld());
+
+    /* MSI-X always supports masking at the PCI device level via the vector
+     * control word of the table entry. */
+    volatile uint32_t* entry = MsixEntry(irq_id);
+    uint32_t vctrl = entry[PciCapMsix::kEntryVectorCtrlWord];
+    if (mask) vctrl |=  PciCapMsix::kVectorCtrlMaskBit;
+    else      vctrl &= ~PciCapMsix::kVectorCtrlMaskBit;
+    entry[PciCapMsix::kEntryVectorCtrlWord] = vctrl;
+
+    /* If we can mask at the platform interrupt controller level as well, do so. */
+    DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+    DEBUG_ASSERT(irq_id < irq_.msix->irq_block_.num_irq);
+    if (bus_drv_.platform().supports_msi_masking())
+        bus_drv_.platform().MaskUnmaskMsi(&irq_.msix->irq_block_, irq_id, mask);
+
+    bool ret = hstate.masked;
+    hstate.masked = mask;
+    return ret;
+}
+
+status_t PcieDevice::MaskUnmaskMsixIrq(uint irq_id, bool mask) {
+    if (irq_id >= irq_.handler_count)
+        return ERR_INVALID_ARGS;
+
+    DEBUG_ASSERT(irq_.handlers);
+
+    {
+        AutoSpinLockIrqSave handler_lock(irq_.handlers[irq_id].lock);
+        MaskUnmaskMsixIrqLocked(irq_id, mask);
+    }
+
+    return NO_ERROR;
+}
+
+void PcieDevice::MaskAllMsixVectors() {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->is_valid());
+
+    for (uint i = 0; i < irq_.handler_count; i++)
+        MaskUnmaskMsixIrq(i, true);
+}
+
+void PcieDevice::FreeMsixBlock() {
+    /* If no block has been allocated, there is nothing to do */
+    if (!irq_.msix->irq_block_.allocated)
+        return;
+
+    DEBUG_ASSERT(bus_drv_.platform().supports_msi());
+
+    /* Mask the IRQ at the platform interrupt controller level if we can, and
+     * unregister any registered handler. */
+    const pcie_msi_block_t* b = &irq_.msix->irq_block_;
+    for (uint i = 0; i < b->num_irq; i++) {
+        if (bus_drv_.platform().supports_msi_masking()) {
+            bus_drv_.platform().MaskUnmaskMsi(b, i, true);
+        }
+        bus_drv_.platform().RegisterMsiHandler(b, i, nullptr, nullptr);
+    }
+
+    /* Give the block of IRQs back to the plaform */
+    bus_drv_.platform().FreeMsiBlock(&irq_.msix->irq_block_);
+    DEBUG_ASSERT(!irq_.msix->irq_block_.allocated);
+}
+
+void PcieDevice::LeaveMsixIrqMode() {
+    /* Disable MSI-X at the function level and mask all vectors */
+    SetMsixEnb(false, true);
+    if (irq_.msix->table_ != nullptr)
+        MaskAllMsixVectors();
+
+    /* Return any allocated irq_ block to the platform, unregistering with
+     * the interrupt controller and synchronizing with the dispatchers in
+     * the process. */
+    FreeMsixBlock();
+
+    /* Unmap the vector table and reset our common state, freeing any
+     * allocated handlers */
+    UnmapMsixTableLocked();
+    ResetCommonIrqBookkeeping();
+}
+
+status_t PcieDevice::EnterMsixIrqMode(uint requested_irqs) {
+    DEBUG_ASSERT(requested_irqs);
+
+    status_t res = NO_ERROR;
+
+    // We cannot go into MSI-X mode if we don't support MSI-X at all, or we
+    // don't support the number of IRQs requested
+    if (!irq_.msix                            ||
+        !irq_.msix->is_valid()                ||
+        !bus_drv_.platform().supports_msi()   ||
+        (requested_irqs > irq_.msix->table_size()))
+        return ERR_NOT_SUPPORTED;
+
+    // Map the vector table into the kernel's address space.
+    res = MapMsixTableLocked();
+    if (res != NO_ERROR)
+        return res;
+
+    /* Ask the platform for a chunk of MSI compatible IRQs.  MSI-X table
+     * entries each carry a full 64 bit address, so high targets are fine. */
+    DEBUG_ASSERT(!irq_.msix->irq_block_.allocated);
+    res = bus_drv_.platform().AllocMsiBlock(requested_irqs,
+                                            true,   /* can_target_64bit */
+                                            true,   /* is_msix */
+                                            &irq_.msix->irq_block_);
+    if (res != NO_ERROR) {
+        LTRACEF("Failed to allocate a block of %u MSI-X IRQs for device "
+                "%02x:%02x.%01x (res %d)\n",
+                requested_irqs, bus_id_, dev_id_, func_id_, res);
+        goto bailout;
+    }
+
+    /* Allocate our handler table.  MSI-X vectors can always be masked at the
+     * device level, so they all start out masked. */
+    res = AllocIrqHandlers(requested_irqs, true);
+    if (res != NO_ERROR)
+        goto bailout;
+
+    /* Record our new IRQ mode */
+    irq_.mode = PCIE_IRQ_MODE_MSI_X;
+
+    /* Program each table entry (masked).  Each entry has its own target
+     * address, so spread the vectors round-robin across the online CPUs if
+     * the platform knows how to steer them; platforms which do not steer get
+     * every vector at the block's default target. */
+    {
+        const pcie_msi_block_t& b = irq_.msix->irq_block_;
+        mp_cpu_mask_t online = mp_get_online_mask();
+        uint cpu = 0;
+        for (uint i = 0; i < requested_irqs; ++i) {
+            uint64_t tgt_addr = b.tgt_addr;
+
+            if (online) {
+                while (!(online & (1u << cpu)))
+                    cpu = (cpu + 1) % SMP_MAX_CPUS;
+
+                uint64_t cpu_addr;
+                if (bus_drv_.platform().MsiTargetAddrForCpu(cpu, &cpu_addr) == NO_ERROR)
+                    tgt_addr = cpu_addr;
+
+                cpu = (cpu + 1) % SMP_MAX_CPUS;
+            }
+
+            SetMsixVectorTargetLocked(i, tgt_addr, b.tgt_data + i);
+        }
+    }
+
+    /* Register each IRQ with the dispatcher */
+    DEBUG_ASSERT(irq_.handler_count <= irq_.msix->irq_block_.num_irq);
+    for (uint i = 0; i < irq_.handler_count; ++i) {
+        bus_drv_.platform().RegisterMsiHandler(&irq_.msix->irq_block_,
+                                               i,
+                                               PcieDevice::MsixIrqHandlerThunk,
+                                               irq_.handlers + i);
+    }
+
+    /* Enable MSI-X at the function level, dropping the function mask.  The
+     * individual vectors remain masked until handlers are registered and
+     * unmasked by the device driver. */
+    SetMsixEnb(true, false);
+
+bailout:
+    if (res != NO_ERROR)
+        LeaveMsixIrqMode();
+
+    return res;
+}
+
+enum handler_return PcieDevice::MsixIrqHandler(pcie_irq_handler_state_t& hstate) {
+    DEBUG_ASSERT(irq_.msix);
+    /* No need to save IRQ state; we are in an IRQ handler at the moment. */
+    AutoSpinLock handler_lock(hstate.lock);
+
+    /* Mask our IRQ (always possible in MSI-X mode) */
+    bool was_masked = MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, true);
+
+    /* If the IRQ was masked or the handler removed by the time we got here,
+     * leave the IRQ masked, unlock and get out. */
+    if (was_masked || !hstate.handler)
+        return INT_NO_RESCHEDULE;
+
+    /* Dispatch */
+    pcie_irq_handler_retval_t irq_ret = hstate.handler(*this, hstate.pci_irq_id, hstate.ctx);
+
+    /* Re-enable the IRQ if asked to do so */
+    if (!(irq_ret & PCIE_IRQRET_MASK))
+        MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, false);
+
+    /* Request a reschedule if asked to do so */
+    return (irq_ret & PCIE_IRQRET_RESCHED) ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
+}
+
+enum handler_return PcieDevice::MsixIrqHandlerThunk(void *arg) {
+    DEBUG_ASSERT(arg);
+    auto& hstate = *(reinterpret_cast<pcie_irq_handler_state_t*>(arg));
+    DEBUG_ASSERT(hstate.dev);
+    return hstate.dev->MsixIrqHandler(hstate);
+}
+
 /******************************************************************************
  *
  * Internal implementation of the Kernel facing API.
@@ -577,13 +874,21 @@ status_t PcieDevice::QueryIrqModeCapabilitiesLocked(pcie_irq_mode_t mode,
         break;
 
     case PCIE_IRQ_MODE_MSI_X:
-        /* If the platform does not support MSI, then we don't support MSI,
+        /* If the platform does not support MSI, then we don't support MSI-X,
          * even if the device does. */
         if (!bus_drv_.platform().supports_msi())
             return ERR_NOT_SUPPORTED;
 
-        /* TODO(johngro) : finish MSI-X implementation. */
-        return ERR_NOT_SUPPORTED;
+        /* If the device supports MSI-X, it will have a pointer to the control
+         * structure in config. */
+        if (!irq_.msix || !irq_.msix->is_valid())
+            return ERR_NOT_SUPPORTED;
+
+        /* MSI-X vectors can always be masked individually via the vector
+         * control word of their table entry. */
+        out_caps->max_irqs = irq_.msix->table_size();
+        out_caps->per_vector_masking_supported = true;
+        break;
 
     default:
         return ERR_INVALID_ARGS;
@@ -639,10 +944,15 @@ status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_irqs)
             DEBUG_ASSERT(!irq_.registered_handler_count);
             return NO_ERROR;
 
-        /* Right now, there should be no way to get into MSI-X mode */
         case PCIE_IRQ_MODE_MSI_X:
-            DEBUG_ASSERT(false);
-            return ERR_NOT_SUPPORTED;
+            DEBUG_ASSERT(irq_.msix);
+            DEBUG_ASSERT(irq_.msix->is_valid());
+            DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+
+            LeaveMsixIrqMode();
+
+            DEBUG_ASSERT(!irq_.registered_handler_count);
+            return NO_ERROR;
 
         default:
             /* mode is not one of the valid enum values, this should be impossible */
@@ -663,7 +973,7 @@ status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_irqs)
     switch (mode) {
     case PCIE_IRQ_MODE_LEGACY: return EnterLegacyIrqMode(requested_irqs);
     case PCIE_IRQ_MODE_MSI:    return EnterMsiIrqMode   (requested_irqs);
-    case PCIE_IRQ_MODE_MSI_X:  return ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI_X:  return EnterMsixIrqMode  (requested_irqs);
     default:                   return ERR_INVALID_ARGS;
     }
 }
@@ -734,7 +1044,7 @@ status_t PcieDevice::MaskUnmaskIrqLocked(uint irq_id, bool mask) {
     switch (irq_.mode) {
     case PCIE_IRQ_MODE_LEGACY: return MaskUnmaskLegacyIrq(mask);
     case PCIE_IRQ_MODE_MSI:    return MaskUnmaskMsiIrq(irq_id, mask);
-    case PCIE_IRQ_MODE_MSI_X:  return ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI_X:  return MaskUnmaskMsixIrq(irq_id, mask);
     default:
         DEBUG_ASSERT(false); /* This should be un-possible! */
         return ERR_INTERNAL;
@@ -795,6 +1105,43 @@ status_t PcieDevice::MaskUnmaskIrq(uint irq_id, bool mask) {
         : ERR_BAD_STATE;
 }
 
+status_t PcieDevice::SetIrqAffinity(uint irq_id, uint cpu) {
+    AutoLock dev_lock(&dev_lock_);
+
+    if (!plugged_in_ || disabled_)
+        return ERR_BAD_STATE;
+
+    /* Only MSI-X table entries carry a per-vector target address; in legacy
+     * and MSI modes every vector for the device shares a single target. */
+    if (irq_.mode != PCIE_IRQ_MODE_MSI_X)
+        return ERR_BAD_STATE;
+
+    if (irq_id >= irq_.handler_count)
+        return ERR_INVALID_ARGS;
+
+    if ((cpu >= SMP_MAX_CPUS) || !mp_is_cpu_online(cpu))
+        return ERR_INVALID_ARGS;
+
+    uint64_t tgt_addr;
+    status_t res = bus_drv_.platform().MsiTargetAddrForCpu(cpu, &tgt_addr);
+    if (res != NO_ERROR)
+        return res;
+
+    /* Re-target the vector under its handler lock.  SetMsixVectorTargetLocked
+     * masks the entry for the duration of the update and then restores its
+     * previous mask state, so an unmasked vector simply starts arriving at
+     * the new CPU. */
+    DEBUG_ASSERT(irq_.handlers);
+    pcie_irq_handler_state_t& hstate = irq_.handlers[irq_id];
+    {
+        AutoSpinLockIrqSave handler_lock(hstate.lock);
+        SetMsixVectorTargetLocked(irq_id, tgt_addr,
+                                  irq_.msix->irq_block_.tgt_data + irq_id);
+    }
+
+    return NO_ERROR;
+}
+
 
 // Map from a device's interrupt pin ID to the proper system IRQ ID.  Follow the
 // PCIe graph up to the root, swizzling as we traverse PCIe switches,
@@ -9,6 +9,7 @@
 #include <arch/ops.h>
 #include <assert.h>
 #include <inttypes.h>
+#include <lib/ktrace.h>
 #include <lk/init.h>
 #include <platform.h>
 #include <dev/interrupt.h>
@@ -22,6 +23,10 @@
 #include <mdi/mdi-defs.h>
 #endif
 
+#if ARCH_ARM64
+#include <arch/arm64.h>
+#endif
+
 #define LOCAL_TRACE 0
 
 #include <lib/fixed_point.h>
@@ -209,6 +214,16 @@ static uint64_t read_ct(void)
 
 static enum handler_return platform_tick(void *arg)
 {
+#if ARCH_ARM64
+    // sample the interrupted context for the profiler; arm64_irq
+    // stashed the frame on the way in
+    struct arm64_iframe_short *frame = arm64_irq_frame[arch_curr_cpu_num()];
+    if (frame) {
+        // no frame pointer in the short frame; the link register is
+        // the best caller hint we have
+        ktrace_prof_sample(frame->elr, 0, frame->lr);
+    }
+#endif
     write_ctl(0);
     if (t_callback) {
         return t_callback(arg, current_time());
@@ -52,19 +52,29 @@ static enum handler_return qemu_uart_irq(void *arg)
     uint32_t isr = UARTREG(uart_base, UART_TMIS);
 
     if (isr & (1<<4)) { // rxmis
-        /* while fifo is not empty, read chars out of it */
+        char buf[32];
+        size_t n = 0;
+
+        /* batch chars out of the fifo and push them as blocks, so the
+         * reader is signaled once per chunk rather than once per char */
         while ((UARTREG(uart_base, UART_TFR) & (1<<4)) == 0) {
             /* if we're out of rx buffer, mask the irq instead of handling it */
-            if (cbuf_space_avail(&uart_rx_buf) == 0) {
+            if (cbuf_space_avail(&uart_rx_buf) <= n) {
                 UARTREG(uart_base, UART_IMSC) &= ~(1<<4); // !rxim
                 break;
             }
 
-            char c = UARTREG(uart_base, UART_DR);
-            cbuf_write_char(&uart_rx_buf, c, false);
-
+            buf[n++] = UARTREG(uart_base, UART_DR);
             resched = true;
+
+            if (n == sizeof(buf)) {
+                cbuf_write_block(&uart_rx_buf, buf, n, false);
+                n = 0;
+            }
         }
+
+        if (n > 0)
+            cbuf_write_block(&uart_rx_buf, buf, n, false);
     }
 
     return resched ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
@@ -107,7 +117,7 @@ static int qemu_uart_putc(char c)
 static int qemu_uart_getc(bool wait)
 {
     char c;
-    if (cbuf_read_char(&uart_rx_buf, &c, wait) == 1) {
+    if (cbuf_read_block(&uart_rx_buf, &c, 1, wait) == 1) {
         UARTREG(uart_base, UART_IMSC) = (1<<4); // rxim
         return c;
     }
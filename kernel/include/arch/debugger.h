@@ -27,4 +27,9 @@ status_t arch_get_regset(struct thread *thread, uint regset, void* regs, uint* b
 // privileged and unprivileged fields.
 status_t arch_set_regset(struct thread *thread, uint regset, const void* regs, uint buf_size, bool priv);
 
+// Enable or disable hardware single-stepping of |thread|.
+// The thread must be stopped in an exception (the flag is set in its saved
+// state and takes effect when the exception is resumed).
+status_t arch_set_single_step(struct thread *thread, bool enable);
+
 __END_CDECLS
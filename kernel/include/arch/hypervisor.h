@@ -41,3 +41,9 @@ status_t arch_guest_enter(const mxtl::unique_ptr<GuestContext>& context);
 /* Set the entry of the guest context.
  */
 status_t arch_guest_set_entry(const mxtl::unique_ptr<GuestContext>& context, uintptr_t guest_entry);
+
+/* Set the vcpu state area of the guest context.
+ * The first page of the VMO is shared with the VMM for exit handling.
+ */
+status_t arch_guest_set_state_area(const mxtl::unique_ptr<GuestContext>& context,
+                                   mxtl::RefPtr<VmObject> vcpu_state_vmo);
@@ -42,6 +42,10 @@ void mp_init(void);
 
 void mp_reschedule(mp_cpu_mask_t target, uint flags);
 void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context);
+/* fire-and-forget variant of mp_sync_exec: queues the task into each target
+ * cpu's mailbox and returns without waiting for completion.  Falls back to
+ * the synchronous path for any cpu whose mailbox is full. */
+void mp_async_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context);
 void mp_set_curr_cpu_online(bool online);
 void mp_set_curr_cpu_active(bool active);
 
@@ -72,9 +76,10 @@ struct mp_state {
     mp_cpu_mask_t idle_cpus;
     mp_cpu_mask_t realtime_cpus;
 
-    spin_lock_t ipi_task_lock;
-    /* list of outstanding tasks for CPUs to execute.  Should only be
-     * accessed with the ipi_task_lock held */
+    /* per cpu mailboxes of outstanding tasks for CPUs to execute.  Each
+     * list should only be accessed with its own lock held, so enqueues to
+     * different cpus never contend */
+    spin_lock_t ipi_task_lock[SMP_MAX_CPUS];
     struct list_node ipi_task_list[SMP_MAX_CPUS];
 
     /* lock for serializing CPU hotplug/unplug operations */
@@ -150,6 +155,10 @@ static inline void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void
     task(context);
     arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
 }
+static inline void mp_async_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
+{
+    mp_sync_exec(target, task, context);
+}
 static inline void mp_set_curr_cpu_active(bool active) {}
 static inline void mp_set_curr_cpu_online(bool online) {}
 
@@ -24,6 +24,8 @@ typedef struct TA_CAP("mutex") mutex {
     thread_t *holder;
     int count;
     wait_queue_t wait;
+    /* membership in the holder's mutex_list, for priority inheritance */
+    struct list_node holder_node;
 } mutex_t;
 
 #define MUTEX_INITIAL_VALUE(m) \
@@ -32,6 +34,7 @@ typedef struct TA_CAP("mutex") mutex {
     .holder = NULL, \
     .count = 0, \
     .wait = WAIT_QUEUE_INITIAL_VALUE((m).wait), \
+    .holder_node = LIST_INITIAL_CLEARED_VALUE, \
 }
 
 /* Rules for Mutexes:
@@ -8,6 +8,7 @@
 
 #include <stdbool.h>
 #include <list.h>
+#include <kernel/mp.h>
 #include <kernel/thread.h>
 
 /* scheduler routines, used internally by thread.c */
@@ -15,9 +16,37 @@
 void sched_init_early(void);
 thread_t *sched_get_top_thread(uint cpu);
 
+/* called by arch code once cpu enumeration is complete to describe which
+ * cpus share an SMT core and which share a last level cache with |cpu|.
+ * both masks include the cpu itself. cpus never described this way fall
+ * back to a topology-oblivious placement policy.
+ */
+void sched_set_cpu_topology(uint cpu, mp_cpu_mask_t smt_siblings, mp_cpu_mask_t llc_peers);
+
 void sched_block(void);
 void sched_unblock(thread_t *t, bool resched);
 void sched_unblock_list(struct list_node *list, bool resched);
 
 void sched_yield(void);
 void sched_preempt(void);
+
+/* change a thread's effective priority, fixing up whatever queue it sits
+ * in. must be called with the thread_lock held. used by the priority
+ * inheritance code in mutex.c; the caller computes the new effective
+ * priority (base vs inherited) before calling.
+ */
+void sched_change_priority(thread_t *t, int pri);
+
+/* requeue a READY thread after its cpu affinity mask changed, so it can't
+ * keep sitting on the queue of a cpu the new mask excludes. must be called
+ * with the thread_lock held.
+ */
+void sched_affinity_changed(thread_t *t);
+
+/* deadline class management; both must be called with the thread_lock held.
+ * sched_set_deadline() admits |t| into (period != 0) or removes it from
+ * (period == 0) the EDF deadline class; sched_deadline_charge() burns |ran|
+ * ns off the thread's budget for the current period.
+ */
+status_t sched_set_deadline(thread_t *t, lk_time_t capacity, lk_time_t rel_deadline, lk_time_t period);
+void sched_deadline_charge(thread_t *t, lk_time_t ran);
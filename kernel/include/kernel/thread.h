@@ -56,6 +56,7 @@ typedef void (*thread_user_callback_t)(enum thread_user_state_change new_state,
 #define THREAD_FLAG_REAL_TIME                 (1<<3)
 #define THREAD_FLAG_IDLE                      (1<<4)
 #define THREAD_FLAG_DEBUG_STACK_BOUNDS_CHECK  (1<<5)
+#define THREAD_FLAG_DEADLINE                  (1<<6)
 
 #define THREAD_SIGNAL_KILL                    (1<<0)
 #define THREAD_SIGNAL_SUSPEND                 (1<<1)
@@ -68,6 +69,8 @@ typedef void (*thread_user_callback_t)(enum thread_user_state_change new_state,
 
 #define THREAD_LINEBUFFER_LENGTH 128
 
+struct mutex;
+
 typedef struct thread {
     int magic;
     struct list_node thread_list_node;
@@ -76,6 +79,15 @@ typedef struct thread {
     struct list_node queue_node;
     int priority;
     enum thread_state state;
+
+    /* priority inheritance: the priority the thread asked for (priority
+     * above is the effective one and may be boosted by mutex waiters),
+     * the highest boost currently applied (-1 when none), the mutexes
+     * held, and the mutex blocked on, if any */
+    int base_priority;
+    int inherited_priority;
+    struct list_node mutex_list;
+    struct mutex *blocking_mutex;
     lk_time_t last_started_running;
     lk_time_t remaining_time_slice;
     unsigned int flags;
@@ -84,6 +96,9 @@ typedef struct thread {
     uint last_cpu; /* last/current cpu the thread is running on */
     int pinned_cpu; /* only run on pinned_cpu if >= 0 */
 #endif
+    /* mask of cpus the scheduler may place this thread on; all ones by
+     * default. an internal pin (pinned_cpu) takes precedence over it. */
+    uint32_t cpu_affinity;
 
     /* pointer to the kernel address space this thread is associated with */
     vmm_aspace_t *aspace;
@@ -101,6 +116,17 @@ typedef struct thread {
      * left the scheduler. */
     lk_time_t runtime_ns;
 
+    /* time this thread was last made READY and inserted in a run queue */
+    lk_time_t last_ready_time;
+
+    /* total time spent READY in a run queue before being picked to run */
+    lk_time_t runqueue_wait_ns;
+
+    /* context switches away from this thread, split by whether it gave up
+     * the cpu (blocked, slept, yielded) or was preempted while still READY */
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+
     /* if blocked, a pointer to the wait queue */
     struct wait_queue *blocking_wait_queue;
 
@@ -110,6 +136,20 @@ typedef struct thread {
     /* are we allowed to be interrupted on the current thing we're blocked/sleeping on */
     bool interruptable;
 
+    /* default slack, in ns, applied to this thread's sleep and blocking-wait
+     * deadlines so nearby expirations can coalesce; 0 means exact deadlines */
+    lk_time_t timer_slack;
+
+    /* deadline scheduling class state, valid while THREAD_FLAG_DEADLINE is
+     * set. parameters come from thread_set_deadline(); the running state is
+     * maintained by the scheduler under the thread_lock. */
+    lk_time_t dl_capacity;     /* runtime reserved per period */
+    lk_time_t dl_rel_deadline; /* deadline relative to each period start */
+    lk_time_t dl_period;
+    lk_time_t dl_period_start; /* start of the current period */
+    lk_time_t dl_abs_deadline; /* the EDF sort key */
+    lk_time_t dl_budget;       /* capacity left in the current period */
+
     /* non-NULL if stopped in an exception */
     const struct arch_exception_context *exception_context;
 
@@ -179,6 +219,8 @@ void thread_construct_first(thread_t *t, const char *name);
 thread_t *thread_create_idle_thread(uint cpu_num);
 void thread_set_name(const char *name);
 void thread_set_priority(int priority);
+void thread_set_timer_slack(thread_t *t, lk_time_t slack);
+status_t thread_set_cpu_affinity(thread_t *t, uint32_t affinity);
 void thread_set_user_callback(thread_t *t, thread_user_callback_t cb);
 thread_t *thread_create(const char *name, thread_start_routine entry, void *arg, int priority, size_t stack_size);
 thread_t *thread_create_etc(thread_t *t, const char *name, thread_start_routine entry, void *arg, int priority, void *stack, void *unsafe_stack, size_t stack_size, thread_trampoline_routine alt_trampoline);
@@ -191,6 +233,7 @@ status_t thread_detach(thread_t *t);
 status_t thread_join(thread_t *t, int *retcode, lk_time_t deadline);
 status_t thread_detach_and_resume(thread_t *t);
 status_t thread_set_real_time(thread_t *t);
+status_t thread_set_deadline(thread_t *t, lk_time_t capacity, lk_time_t rel_deadline, lk_time_t period);
 
 void thread_owner_name(thread_t *t, char out_name[THREAD_NAME_LENGTH]);
 
@@ -225,6 +268,16 @@ status_t thread_sleep_relative(lk_time_t delay);
 /* return the number of nanoseconds a thread has been running for */
 lk_time_t thread_runtime(const thread_t *t);
 
+/* consistent snapshot of the per-thread scheduler counters */
+typedef struct thread_sched_stats {
+    lk_time_t runtime_ns;
+    lk_time_t runqueue_wait_ns;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+} thread_sched_stats_t;
+
+void thread_get_sched_stats(const thread_t *t, thread_sched_stats_t *stats);
+
 /* deliver a kill signal to a thread */
 void thread_kill(thread_t *t, bool block);
 
@@ -256,6 +309,11 @@ static inline bool thread_is_idle(thread_t *t)
     return !!(t->flags & THREAD_FLAG_IDLE);
 }
 
+static inline bool thread_is_deadline(thread_t *t)
+{
+    return !!(t->flags & THREAD_FLAG_DEADLINE);
+}
+
 static inline bool thread_is_real_time_or_idle(thread_t *t)
 {
     return !!(t->flags & (THREAD_FLAG_REAL_TIME | THREAD_FLAG_IDLE));
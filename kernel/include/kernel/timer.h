@@ -57,6 +57,9 @@ typedef struct timer {
 */
 void timer_initialize(timer_t *);
 void timer_set_oneshot(timer_t *, lk_time_t deadline, timer_callback, void *arg);
+/* as timer_set_oneshot, but the expiration may slide up to slack ns past the
+ * deadline to share an interrupt with a nearby pending timer; never fires early */
+void timer_set_oneshot_slack(timer_t *, lk_time_t deadline, lk_time_t slack, timer_callback, void *arg);
 void timer_set_periodic(timer_t *, lk_time_t period, timer_callback, void *arg);
 void timer_cancel(timer_t *);
 
@@ -102,6 +102,10 @@ typedef struct pmm_arena_info {
 
     paddr_t base;
     size_t size;
+
+    /* numa node this arena's memory belongs to; 0 on non-numa systems.
+     * kept last so positional initializers predating it stay valid. */
+    uint node;
 } pmm_arena_info_t;
 
 #define PMM_ARENA_FLAG_KMAP (0x1) /* this arena is already mapped and useful for kallocs */
@@ -112,6 +116,31 @@ status_t pmm_add_arena(const pmm_arena_info_t* arena) __NONNULL((1));
 /* flags for allocation routines below */
 #define PMM_ALLOC_FLAG_ANY (0x0)  /* no restrictions on which arena to allocate from */
 #define PMM_ALLOC_FLAG_KMAP (0x1) /* allocate only from arenas marked KMAP */
+#define PMM_ALLOC_FLAG_ZERO (0x2) /* return a zeroed page, preferring pre-scrubbed ones */
+
+/* numa placement policies. without one, arenas are walked in priority order.
+ * LOCAL and INTERLEAVE are preferences that fall back to any arena when the
+ * target node is dry; BIND fails instead. policied allocations bypass the
+ * per-cpu caches and pre-zeroed pool, whose pages have no node identity. */
+#define PMM_ALLOC_FLAG_NODE_LOCAL (0x4)       /* prefer arenas on the calling cpu's node */
+#define PMM_ALLOC_FLAG_NODE_BIND (0x8)        /* allocate only on PMM_ALLOC_NODE(flags) */
+#define PMM_ALLOC_FLAG_NODE_INTERLEAVE (0x10) /* rotate successive allocations across nodes */
+#define PMM_ALLOC_NODE_POLICY_MASK \
+    (PMM_ALLOC_FLAG_NODE_LOCAL | PMM_ALLOC_FLAG_NODE_BIND | PMM_ALLOC_FLAG_NODE_INTERLEAVE)
+
+/* the node argument for PMM_ALLOC_FLAG_NODE_BIND lives in bits 15:8 of the flags */
+#define PMM_ALLOC_NODE_SHIFT (8)
+#define PMM_ALLOC_NODE_MASK (0xffu)
+#define PMM_ALLOC_FLAG_NODE(n) ((((uint)(n)) & PMM_ALLOC_NODE_MASK) << PMM_ALLOC_NODE_SHIFT)
+#define PMM_ALLOC_NODE(flags) (((flags) >> PMM_ALLOC_NODE_SHIFT) & PMM_ALLOC_NODE_MASK)
+
+/* cpu-to-node topology, filled in by platform code during boot; cpus default
+ * to node 0, matching arenas that carry no node tag */
+void pmm_set_cpu_node(uint cpu, uint node);
+uint pmm_node_of_cpu(uint cpu);
+
+/* Highest node id seen across the cpu map and arenas, plus one. */
+uint pmm_node_count(void);
 
 /* Allocate count pages of physical memory, adding to the tail of the passed list.
  * The list must be initialized.
@@ -146,6 +175,44 @@ size_t pmm_free_page(vm_page_t* page) __NONNULL((1));
 /* Return count of unallocated physical pages in system */
 size_t pmm_count_free_pages(void);
 
+/* Per-arena statistics snapshot. Page counts are tallied from the page
+ * states without stopping allocators, so they may be slightly stale. */
+typedef struct pmm_arena_stats {
+    pmm_arena_info_t info;  /* arena identity, including its numa node */
+    size_t total_pages;
+    size_t free_pages;      /* in the arena free list */
+    size_t wired_pages;     /* kernel-owned: wired, heap, mmu, raw allocations
+                             * (including pages parked in the per-cpu caches) */
+    size_t committed_pages; /* backing vm objects */
+} pmm_arena_stats_t;
+
+/* Number of arenas the pmm manages. Fixed after early boot. */
+size_t pmm_count_arenas(void);
+
+/* Fill *stats* for the index'th arena, in allocation priority order.
+ * Returns ERR_OUT_OF_RANGE past the last arena. */
+status_t pmm_get_arena_stats(size_t index, pmm_arena_stats_t* stats) __NONNULL((2));
+
+/* Free page count below which the pmm signals memory pressure. */
+#define PMM_LOW_WATER_PAGES (1024)
+
+/* Block until the pmm signals memory pressure (free pages below
+ * PMM_LOW_WATER_PAGES at allocation time). Consumed by the vmo reclaim
+ * thread.
+ */
+void pmm_wait_for_low_mem(void);
+
+/* Block until a contiguous allocation fails for lack of a free run.
+ * Consumed by the vmo compaction thread.
+ */
+void pmm_wait_for_contiguous_pressure(void);
+
+/* True if the frame sits in a nearly-free aligned block, i.e. moving it
+ * (and its few neighbors) elsewhere would coalesce a free run. Used by
+ * the vmo compaction thread to pick pages worth migrating.
+ */
+bool pmm_frame_is_compaction_candidate(paddr_t pa);
+
 // Return amount of physical memory in system, in bytes.
 size_t pmm_count_total_bytes(void);
 
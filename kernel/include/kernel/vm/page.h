@@ -8,6 +8,7 @@
 #pragma once
 
 #include <list.h>
+#include <magenta/atomic.h>
 #include <magenta/compiler.h>
 #include <stdint.h>
 
@@ -35,6 +36,10 @@ typedef struct vm_page {
             // attached to a vm object
             uint64_t offset;
             VmObject* obj;
+            // number of vm object offsets referencing this frame; only
+            // valid while VM_PAGE_FLAG_SHARED is set. modified atomically,
+            // since the referencing objects have independent locks.
+            int share_count;
         } object;
 #endif
 
@@ -42,6 +47,11 @@ typedef struct vm_page {
     };
 } vm_page_t;
 
+// page flags
+#define VM_PAGE_FLAG_ZEROED (0x1) /* contents are zero; only set while the pmm holds the page */
+#define VM_PAGE_FLAG_UNMOVABLE (0x2) /* physical address has been handed out (DMA); never migrate */
+#define VM_PAGE_FLAG_SHARED (0x4) /* frame deduped into multiple vm objects; writers must fork */
+
 // pmm will maintain pages of this size
 #define VM_PAGE_STRUCT_SIZE (sizeof(vm_page_t))
 static_assert(sizeof(vm_page_t) == 32, "");
@@ -62,6 +72,31 @@ static inline bool page_is_free(const vm_page_t* page) {
     return page->state == VM_PAGE_STATE_FREE;
 }
 
+// a page may be relocated to another physical frame if it belongs to a
+// vm object (which tracks it through the object backlink) and its
+// physical address has never been exposed outside the vm. shared frames
+// are also pinned: the backlink only names one of the referencing
+// objects, so the others could not be told about the move.
+static inline bool page_is_movable(const vm_page_t* page) {
+    return page->state == VM_PAGE_STATE_OBJECT &&
+           (page->flags & (VM_PAGE_FLAG_UNMOVABLE | VM_PAGE_FLAG_SHARED)) == 0;
+}
+
+#if __cplusplus
+// drop one vm object's reference to a possibly-shared frame. returns true
+// if the caller held the last reference and now owns the frame outright,
+// so it is responsible for returning it to the pmm.
+static inline bool vm_page_release_shared(vm_page_t* page) {
+    if ((page->flags & VM_PAGE_FLAG_SHARED) == 0)
+        return true;
+    if (atomic_add(&page->object.share_count, -1) > 1)
+        return false;
+    page->flags &= ~VM_PAGE_FLAG_SHARED;
+    page->object.share_count = 0;
+    return true;
+}
+#endif
+
 const char* page_state_to_string(unsigned int state);
 void dump_page(const vm_page_t* page);
 
@@ -129,6 +129,8 @@ private:
 protected:
     // friend VmAddressRegion so it can access DestroyLocked
     friend VmAddressRegion;
+    // friend VmAspace so the fault path can revalidate its cached mapping
+    friend class VmAspace;
 
     // destructor, should only be invoked from RefPtr
     virtual ~VmAddressRegionOrMapping();
@@ -443,6 +445,11 @@ protected:
     // unmap any pages that map the passed in vmo range. May not intersect with this range
     status_t UnmapVmoRangeLocked(uint64_t start, uint64_t size) const;
 
+    // a page was committed to (delta 1) or released from (delta -1) the
+    // page-aligned vmo |offset|; adjust our aspace's commit charge if the
+    // offset falls inside the range we map
+    void CommitChargeUpdateLocked(uint64_t offset, int64_t delta);
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmMapping);
 
@@ -477,10 +484,19 @@ private:
     // in Clang around capability aliasing, we need to relax the analysis.
     void ActivateLocked();
 
+    // drop the commit charge for the pages currently allocated to the vmo
+    // range [offset, offset + len), used when this mapping shrinks away from
+    // the range.  Requires the object_ lock.
+    void DischargeVmoRangeLocked(uint64_t offset, uint64_t len);
+
     // pointer and region of the object we are mapping
     mxtl::RefPtr<VmObject> object_;
     uint64_t object_offset_ = 0;
 
+    // pages in our vmo range currently charged against aspace_'s commit
+    // charge; maintained under the object_ lock
+    uint64_t charged_pages_ = 0;
+
     // cached mapping flags (read/write/user/etc)
     uint arch_mmu_flags_;
 
@@ -12,6 +12,7 @@
 #include <kernel/vm.h>
 #include <kernel/vm/vm_address_region.h>
 #include <lib/crypto/prng.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/intrusive_wavl_tree.h>
@@ -71,6 +72,20 @@ public:
     // returns false. Returns true otherwise.
     bool EnumerateChildren(VmEnumerator* ve);
 
+    // Populates this freshly created, still-empty user address space with a
+    // copy of |source|'s region tree. Sub-regions and mappings are recreated
+    // at their original addresses, and the VMO backing each mapping is
+    // replaced with a copy-on-write clone, so the copy shares all committed
+    // pages with |source| until either side writes. Mappings of VMOs that
+    // cannot be cloned (e.g. physical VMOs) share the source VMO directly.
+    // No pages are copied or mapped up front; the copy populates lazily
+    // through page faults like any other address space.
+    //
+    // The region layout is snapshotted atomically (the walk holds |source|'s
+    // lock), but the caller is responsible for quiescing |source|'s threads
+    // if it wants the page *contents* to be a meaningful snapshot.
+    status_t CloneFrom(VmAspace* source);
+
     // A collection of memory usage counts.
     struct vm_usage_t {
         // A count of pages covered by VmMapping ranges.
@@ -80,6 +95,11 @@ public:
         // VmMapping covers a range of a VmObject that contains that page, and
         // that page has physical memory allocated to it.
         size_t committed_pages;
+
+        // A count of pages mapped through COW clone VmObjects that are still
+        // shared with the clone's ancestors (not forked yet, so not part of
+        // committed_pages).
+        size_t shared_pages;
     };
 
     // Counts memory usage under the VmAspace.
@@ -87,6 +107,21 @@ public:
 
     size_t AllocatedPages() const;
 
+    // Callback fired when the aspace's commit charge crosses the armed
+    // watermark; |above| is true when crossing upward.  Runs under
+    // watermark_lock_, so it must not call back into the VM layer.
+    using CommitWatermarkFn = void (*)(void* cookie, bool above);
+
+    // Adjust the running count of pages committed to ranges mapped in this
+    // aspace.  Called by VmMapping with the backing object's lock held;
+    // cheap (one relaxed atomic op) unless an armed watermark is crossed.
+    void AdjustCommitCharge(int64_t delta_pages);
+
+    // Arm (pages > 0) or disarm (pages == 0, fn/cookie null) the commit
+    // charge watermark.  If the current charge is already at or above a
+    // newly armed watermark, |fn| fires immediately from this call.
+    void SetCommitWatermark(size_t pages, CommitWatermarkFn fn, void* cookie);
+
     // Convenience method for traversing the tree of VMARs to find the deepest
     // VMAR in the tree that includes *va*.
     mxtl::RefPtr<VmAddressRegionOrMapping> FindRegion(vaddr_t va);
@@ -154,10 +189,32 @@ private:
 
     mutable mutex_t lock_ = MUTEX_INITIAL_VALUE(lock_);
 
+    // pages committed to vmo ranges mapped in this aspace, maintained by
+    // AdjustCommitCharge(); transient dips below zero are possible while a
+    // mapping moves between charge sites, so keep it signed
+    mxtl::atomic<int64_t> commit_charge_pages_{0};
+
+    // armed watermark in pages; 0 means disarmed.  Kept in its own atomic so
+    // the fast path of AdjustCommitCharge() can skip the lock entirely.
+    mxtl::atomic<size_t> watermark_pages_{0};
+
+    // serializes watermark arm/disarm against callback delivery so the
+    // callback never fires after SetCommitWatermark(0, ...) returns
+    mutable mutex_t watermark_lock_ = MUTEX_INITIAL_VALUE(watermark_lock_);
+    CommitWatermarkFn watermark_fn_ = nullptr;   // guarded by watermark_lock_
+    void* watermark_cookie_ = nullptr;           // guarded by watermark_lock_
+    bool watermark_above_ = false;               // guarded by watermark_lock_
+
     // root of virtual address space
     // Access to this reference is guarded by lock_.
     mxtl::RefPtr<VmAddressRegion> root_vmar_;
 
+    // The mapping that satisfied the most recent page fault, if any.
+    // Access to this reference is guarded by lock_, and it is revalidated
+    // against the live layout before each reuse, so it is purely a cache
+    // that lets repeated faults against one mapping skip the VMAR walk.
+    mxtl::RefPtr<VmMapping> last_fault_mapping_;
+
     // PRNG used by VMARs for address choices.  We record the seed to enable
     // reproducible debugging.
     crypto::PRNG aslr_prng_;
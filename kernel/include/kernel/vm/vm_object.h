@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 class VmMapping;
+class VmObjectPaged;
 
 typedef status_t (*vmo_lookup_fn_t)(void* context, size_t offset, size_t index, paddr_t pa);
 
@@ -44,11 +45,24 @@ public:
     virtual size_t AllocatedPagesInRange(uint64_t offset, uint64_t len) const {
         return 0;
     }
+    // As above, but with the object's lock already held.
+    virtual size_t AllocatedPagesInRangeLocked(uint64_t offset, uint64_t len) const
+        TA_REQ(lock_) {
+        return 0;
+    }
     // Returns the number of physical pages currently allocated to the object.
     size_t AllocatedPages() const {
         return AllocatedPagesInRange(0, size());
     }
 
+    // Returns the number of pages in the range that a COW clone is still
+    // sharing with its ancestors, i.e. pages visible through the clone's
+    // window that the clone has not forked its own copy of yet.
+    // |offset| and |len| are in bytes.
+    virtual size_t SharedPagesInRange(uint64_t offset, uint64_t len) const {
+        return 0;
+    }
+
     // find physical pages to back the range of the object
     virtual status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) {
         return ERR_NOT_SUPPORTED;
@@ -65,6 +79,26 @@ public:
         return ERR_NOT_SUPPORTED;
     }
 
+    // zero a range of the vmo, releasing pages back to the default state
+    // where possible
+    virtual status_t ZeroRange(uint64_t offset, uint64_t len) {
+        return ERR_NOT_SUPPORTED;
+    }
+
+    // hint that the kernel may (true) or may no longer (false) decommit
+    // the object's pages under memory pressure
+    virtual status_t SetDiscardable(bool discardable) {
+        return ERR_NOT_SUPPORTED;
+    }
+
+    // set the numa placement policy for pages allocated to this vmo.
+    // |node_flags| is a combination of PMM_ALLOC_FLAG_NODE_* values and,
+    // for a bind policy, an encoded node; 0 clears the policy. Only affects
+    // pages allocated after the call.
+    virtual status_t SetNumaPolicy(uint32_t node_flags) {
+        return ERR_NOT_SUPPORTED;
+    }
+
     // read/write operators against kernel pointers only
     virtual status_t Read(void* ptr, uint64_t offset, size_t len, size_t* bytes_read) {
         return ERR_NOT_SUPPORTED;
@@ -88,6 +122,31 @@ public:
         return ERR_NOT_SUPPORTED;
     }
 
+    // one scatter/gather segment for the vectored user accessors: a user
+    // buffer plus the object offset it transfers against. |actual| is
+    // filled in with the bytes moved (short at the end of the object).
+    struct UserVec {
+        void* buffer = nullptr; // user address
+        uint64_t offset = 0;
+        size_t len = 0;
+        size_t actual = 0;
+    };
+
+    // vectored forms of ReadUser/WriteUser. All segments are processed
+    // under a single acquisition of the object lock; on error the return
+    // value applies to segment |*segments_done| and earlier segments have
+    // already transferred.
+    virtual status_t ReadUserVector(UserVec* vec, size_t count, size_t* segments_done) {
+        return ERR_NOT_SUPPORTED;
+    }
+    virtual status_t WriteUserVector(UserVec* vec, size_t count, size_t* segments_done) {
+        return ERR_NOT_SUPPORTED;
+    }
+
+    // downcast for operations (like vmo-to-vmo transfer) that only make
+    // sense between paged objects; same pattern as VmAddressRegionOrMapping
+    virtual VmObjectPaged* as_vm_object_paged() { return nullptr; }
+
     // translate a range of the vmo to physical addresses and store in the buffer
     virtual status_t LookupUser(uint64_t offset, uint64_t len, user_ptr<paddr_t> buffer,
                                 size_t buffer_size) {
@@ -147,6 +206,11 @@ protected:
     // inform all mappings and children that a range of this vmo's pages were added or removed.
     void RangeChangeUpdateLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
 
+    // inform all mappings that a page was committed to (delta 1) or released
+    // from (delta -1) the page-aligned |offset|, so per-aspace commit charges
+    // stay current; see VmAspace::AdjustCommitCharge()
+    void CommitChargeUpdateLocked(uint64_t offset, int64_t delta) TA_REQ(lock_);
+
     // above call but called from a parent
     virtual void RangeChangeUpdateFromParentLocked(uint64_t offset, uint64_t len)
         // Called under the parent's lock, which confuses analysis.
@@ -37,11 +37,36 @@ public:
         TA_NO_THREAD_SAFETY_ANALYSIS { return size_; }
 
     size_t AllocatedPagesInRange(uint64_t offset, uint64_t len) const override;
+    size_t AllocatedPagesInRangeLocked(uint64_t offset, uint64_t len) const override;
+    size_t SharedPagesInRange(uint64_t offset, uint64_t len) const override;
 
     status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) override;
     status_t CommitRangeContiguous(uint64_t offset, uint64_t len, uint64_t* committed,
                                    uint8_t alignment_log2) override;
     status_t DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) override;
+    status_t ZeroRange(uint64_t offset, uint64_t len) override;
+    status_t SetDiscardable(bool discardable) override;
+    status_t SetNumaPolicy(uint32_t node_flags) override;
+
+    // list traits for membership in the global discardable vmo list,
+    // maintained by the reclaim machinery in vm_object_paged.cpp
+    struct ReclaimListTraits {
+        static mxtl::DoublyLinkedListNodeState<VmObjectPaged*>& node_state(VmObjectPaged& vmo) {
+            return vmo.reclaim_node_;
+        }
+    };
+
+    // list traits for membership in the global paged vmo list walked by
+    // the compaction thread in vm_object_paged.cpp
+    struct CompactListTraits {
+        static mxtl::DoublyLinkedListNodeState<VmObjectPaged*>& node_state(VmObjectPaged& vmo) {
+            return vmo.compact_node_;
+        }
+    };
+
+    // migrate movable pages whose frames the pmm reports as compaction
+    // candidates to freshly allocated frames; returns the number moved
+    size_t Compact();
 
     status_t Read(void* ptr, uint64_t offset, size_t len, size_t* bytes_read) override;
     status_t Write(const void* ptr, uint64_t offset, size_t len, size_t* bytes_written) override;
@@ -53,6 +78,26 @@ public:
     status_t WriteUser(user_ptr<const void> ptr, uint64_t offset, size_t len,
                        size_t* bytes_written) override;
 
+    status_t ReadUserVector(UserVec* vec, size_t count, size_t* segments_done) override;
+    status_t WriteUserVector(UserVec* vec, size_t count, size_t* segments_done) override;
+
+    VmObjectPaged* as_vm_object_paged() override { return this; }
+
+    // copy a range of |src| into |dst| without bouncing through a user
+    // buffer. both objects must be paged; uncommitted source ranges stay
+    // uncommitted in the destination where possible.
+    static status_t Transfer(mxtl::RefPtr<VmObject> src, uint64_t src_offset,
+                             mxtl::RefPtr<VmObject> dst, uint64_t dst_offset,
+                             uint64_t len);
+
+    // merge committed pages of |dst| whose contents are identical to the
+    // page at the same position in |src| down to a single shared frame,
+    // copy-on-write protected in both objects. offsets and len must be
+    // page aligned; |deduped| returns the number of pages merged.
+    static status_t Dedup(mxtl::RefPtr<VmObject> src, uint64_t src_offset,
+                          mxtl::RefPtr<VmObject> dst, uint64_t dst_offset,
+                          uint64_t len, uint64_t* deduped);
+
     status_t LookupUser(uint64_t offset, uint64_t len, user_ptr<paddr_t> buffer,
                         size_t buffer_size) override;
 
@@ -105,9 +150,32 @@ private:
     status_t ReadWriteInternal(uint64_t offset, size_t len, size_t* bytes_copied, bool write,
                                T copyfunc);
 
+    // body of ReadWriteInternal, shared with the vectored accessors so a
+    // whole vector can run under one lock acquisition
+    template <typename T>
+    status_t ReadWriteInternalLocked(uint64_t offset, size_t len, size_t* bytes_copied, bool write,
+                                     T copyfunc) TA_REQ(lock_);
+
+    // body of Transfer, called with both objects' locks held
+    static status_t TransferLocked(VmObjectPaged* src, uint64_t src_offset,
+                                   VmObjectPaged* dst, uint64_t dst_offset, uint64_t len)
+        // Holds two object locks at once, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // body of Dedup, called with both objects' locks held
+    static status_t DedupLocked(VmObjectPaged* src, uint64_t src_offset,
+                                VmObjectPaged* dst, uint64_t dst_offset, uint64_t len,
+                                uint64_t* deduped)
+        // Holds two object locks at once, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
     // set our offset within our parent
     status_t SetParentOffsetLocked(uint64_t o) TA_REQ(lock_);
 
+    // copy the committed page at |offset| to a new physical frame,
+    // updating mappings; the old frame goes back to the pmm
+    status_t MigratePageLocked(uint64_t offset) TA_REQ(lock_);
+
     // maximum size of a VMO is one page less than the full 64bit range
     static const uint64_t MAX_SIZE = ROUNDDOWN(UINT64_MAX, PAGE_SIZE);
 
@@ -118,4 +186,13 @@ private:
 
     // a tree of pages
     VmPageList page_list_ TA_GUARDED(lock_);
+
+    // discardable state and list membership; guarded by the global reclaim
+    // list lock in vm_object_paged.cpp, not lock_
+    bool discardable_ = false;
+    mxtl::DoublyLinkedListNodeState<VmObjectPaged*> reclaim_node_;
+
+    // membership in the global paged vmo list; guarded by the global
+    // compact list lock in vm_object_paged.cpp, not lock_
+    mxtl::DoublyLinkedListNodeState<VmObjectPaged*> compact_node_;
 };
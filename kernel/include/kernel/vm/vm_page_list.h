@@ -46,7 +46,7 @@ public:
         }
     }
 
-    vm_page* GetPage(size_t index);
+    vm_page* GetPage(size_t index) const;
     vm_page* RemovePage(size_t index);
     status_t AddPage(vm_page* p, size_t index);
 
@@ -89,7 +89,12 @@ public:
     }
 
     status_t AddPage(vm_page*, uint64_t offset);
-    vm_page* GetPage(uint64_t offset);
+    vm_page* GetPage(uint64_t offset) const;
+    // detach the page at offset and return it without freeing it
+    vm_page* RemovePage(uint64_t offset);
+    // swap |p| into the slot at offset, returning the old page without
+    // freeing it; returns nullptr (and inserts nothing) if no page is there
+    vm_page* ReplacePage(vm_page* p, uint64_t offset);
     status_t FreePage(uint64_t offset);
     size_t FreeAllPages();
 
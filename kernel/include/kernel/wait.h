@@ -51,10 +51,24 @@ status_t wait_queue_block(wait_queue_t *, lk_time_t deadline);
  * release one or more threads from the wait queue.
  * reschedule = should the system reschedule if any is released.
  * wait_queue_error = what wait_queue_block() should return for the blocking thread.
+ * wait queues are kept sorted by effective priority, so wake_one releases
+ * the highest priority waiter (FIFO among waiters of equal priority).
  */
 int wait_queue_wake_one(wait_queue_t *, bool reschedule, status_t wait_queue_error);
 int wait_queue_wake_all(wait_queue_t *, bool reschedule, status_t wait_queue_error);
 
+/*
+ * peek at the highest priority waiter without removing it, or NULL if the
+ * queue is empty. used by the mutex code to track inherited priorities.
+ */
+struct thread *wait_queue_peek(wait_queue_t *);
+
+/*
+ * re-sort a blocked thread within its wait queue after its effective
+ * priority has changed.
+ */
+void wait_queue_priority_changed(struct thread *t);
+
 /*
  * remove the thread from whatever wait queue it's in.
  * return an error if the thread is not currently blocked (or is the current thread)
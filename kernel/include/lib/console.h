@@ -30,6 +30,11 @@ typedef int (*console_cmd)(int argc, const cmd_args *argv, uint32_t flags);
 #define CMD_AVAIL_PANIC  (0x1 << 1)
 #define CMD_AVAIL_ALWAYS (CMD_AVAIL_NORMAL | CMD_AVAIL_PANIC)
 
+/* command is a heavyweight diagnostic; the interactive console runs it on
+ * a low-priority worker thread instead of the console thread so a long
+ * dump doesn't stall the console or perturb the system */
+#define CMD_AVAIL_HEAVY  (0x1 << 2)
+
 /* command is happening at crash time */
 #define CMD_FLAG_PANIC   (0x1 << 0)
 
@@ -67,6 +72,7 @@ typedef struct _cmd_block {
 
 #define STATIC_COMMAND(command_str, help_str, func) { command_str, help_str, func, CMD_AVAIL_NORMAL },
 #define STATIC_COMMAND_MASKED(command_str, help_str, func, availability_mask) { command_str, help_str, func, availability_mask },
+#define STATIC_COMMAND_HEAVY(command_str, help_str, func) { command_str, help_str, func, CMD_AVAIL_NORMAL | CMD_AVAIL_HEAVY },
 
 #else
 
@@ -77,6 +83,7 @@ typedef struct _cmd_block {
 #define STATIC_COMMAND_END_NAMED(name)
 
 #define STATIC_COMMAND(command_str, help_str, func)
+#define STATIC_COMMAND_HEAVY(command_str, help_str, func)
 
 #endif
 
@@ -43,6 +43,7 @@ static inline void ktrace(uint32_t tag, uint32_t a, uint32_t b, uint32_t c, uint
     } \
 }
 void ktrace_name(uint32_t tag, uint32_t id, uint32_t arg, const char* name);
+void ktrace_prof_sample(uintptr_t pc, uintptr_t fp, uintptr_t lr);
 int ktrace_read_user(void* ptr, uint32_t off, uint32_t len);
 status_t ktrace_control(uint32_t action, uint32_t options, void* ptr);
 #else
@@ -52,6 +53,7 @@ static inline void ktrace(uint32_t tag, uint32_t a, uint32_t b, uint32_t c, uint
 static inline void ktrace_probe0(const char* name) {}
 static inline void ktrace_probe2(const char* name, uint32_t arg0, uint32_t arg1) {}
 static inline void ktrace_name(uint32_t tag, uint32_t id, uint32_t arg, const char* name) {}
+static inline void ktrace_prof_sample(uintptr_t pc, uintptr_t fp, uintptr_t lr) {}
 static inline ssize_t ktrace_read_user(void* ptr, uint32_t off, uint32_t len) {
     if ((len == 0) && (off == 0)) {
         return 0;
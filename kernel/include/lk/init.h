@@ -42,6 +42,16 @@ enum lk_init_flags {
     LK_INIT_FLAG_ALL_CPUS        = LK_INIT_FLAG_PRIMARY_CPU | LK_INIT_FLAG_SECONDARY_CPUS,
     LK_INIT_FLAG_CPU_SUSPEND     = 0x4,
     LK_INIT_FLAG_CPU_RESUME      = 0x8,
+
+    /* The hook has no ordering dependency on the other hooks at its own
+     * level and may run on a worker thread concurrently with them.  Hooks
+     * at different levels still strictly order against each other: every
+     * parallel hook is joined before the first hook of a higher level is
+     * called.  Only honored for primary-cpu init at levels where the
+     * scheduler is running (LK_INIT_LEVEL_THREADING and up); below that
+     * the hook is simply called in place.
+     */
+    LK_INIT_FLAG_PARALLEL        = 0x10,
 };
 
 void lk_init_level(enum lk_init_flags flags, uint start_level, uint stop_level);
@@ -75,4 +85,8 @@ struct lk_init_struct {
 #define LK_INIT_HOOK(_name, _hook, _level) \
     LK_INIT_HOOK_FLAGS(_name, _hook, _level, LK_INIT_FLAG_PRIMARY_CPU)
 
+#define LK_INIT_HOOK_PARALLEL(_name, _hook, _level) \
+    LK_INIT_HOOK_FLAGS(_name, _hook, _level, \
+                       LK_INIT_FLAG_PRIMARY_CPU | LK_INIT_FLAG_PARALLEL)
+
 __END_CDECLS
@@ -8,6 +8,7 @@
 #ifndef __PLATFORM_H
 #define __PLATFORM_H
 
+#include <stdbool.h>
 #include <sys/types.h>
 #include <magenta/compiler.h>
 
@@ -39,6 +40,14 @@ lk_time_t current_time(void);
 /* high-precision timer ticks per second */
 uint64_t ticks_per_second(void);
 
+struct fp_32_64;
+
+/* fills in the fixed-point conversion factor from raw ticks to the
+ * monotonic clock and returns true when the clock is directly computable
+ * from the arch tick counter; returns false when reading the clock
+ * requires entering the kernel */
+bool platform_monotonic_tick_scale(struct fp_32_64 *ns_per_tick);
+
 /* super early platform initialization, before almost everything */
 void platform_early_init(void);
 
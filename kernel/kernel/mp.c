@@ -20,6 +20,7 @@
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/timer.h>
+#include <lib/counters.h>
 
 #define LOCAL_TRACE 0
 
@@ -27,17 +28,36 @@
 /* a global state structure, aligned on cpu cache line to minimize aliasing */
 struct mp_state mp __CPU_ALIGN = {
     .hotplug_lock = MUTEX_INITIAL_VALUE(mp.hotplug_lock),
-    .ipi_task_lock = SPIN_LOCK_INITIAL_VALUE,
 };
 
 /* Helpers used for implementing mp_sync */
 struct mp_sync_context;
 static void mp_sync_task(void *context);
 
+/* per cpu rings of fire-and-forget tasks.  The producer side is serialized
+ * by the target cpu's ipi_task_lock; the consumer is the target cpu itself
+ * in interrupt context, reading slots without any lock. */
+#define MP_ASYNC_QUEUE_DEPTH 16
+static_assert((MP_ASYNC_QUEUE_DEPTH & (MP_ASYNC_QUEUE_DEPTH - 1)) == 0, "");
+
+struct mp_async_queue {
+    struct {
+        mp_sync_task_t func;
+        void *context;
+    } slot[MP_ASYNC_QUEUE_DEPTH];
+    volatile uint32_t head; /* consumer cursor */
+    volatile uint32_t tail; /* producer cursor */
+} __CPU_ALIGN;
+
+static struct mp_async_queue async_queue[SMP_MAX_CPUS];
+
+KCOUNTER(mp_generic_ipis, "mp.ipi.generic");
+KCOUNTER(mp_reschedule_ipis, "mp.ipi.reschedule");
+
 void mp_init(void)
 {
-    mp.ipi_task_lock = SPIN_LOCK_INITIAL_VALUE;
     for (uint i = 0; i < countof(mp.ipi_task_list); ++i) {
+        mp.ipi_task_lock[i] = SPIN_LOCK_INITIAL_VALUE;
         list_initialize(&mp.ipi_task_list[i]);
     }
 }
@@ -135,18 +155,18 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
         sync_tasks[i].context = &sync_context;
     }
 
-    /* enqueue tasks */
-    spin_lock(&mp.ipi_task_lock);
+    /* enqueue tasks into each target cpu's mailbox */
     mp_cpu_mask_t remaining = target;
     uint cpu_id = 0;
     while (remaining && cpu_id < num_cpus) {
         if (remaining & 1) {
+            spin_lock(&mp.ipi_task_lock[cpu_id]);
             list_add_tail(&mp.ipi_task_list[cpu_id], &sync_tasks[cpu_id].node);
+            spin_unlock(&mp.ipi_task_lock[cpu_id]);
         }
         remaining >>= 1;
         cpu_id++;
     }
-    spin_unlock(&mp.ipi_task_lock);
 
     /* let CPUs know to begin executing */
     __UNUSED status_t status = arch_mp_send_ipi(target, MP_IPI_GENERIC);
@@ -189,14 +209,78 @@ void mp_sync_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
 
     /* make sure the sync_tasks aren't in lists anymore, since they're
      * stack allocated */
-    spin_lock_irqsave(&mp.ipi_task_lock, irqstate);
     for (uint i = 0; i < num_cpus; ++i) {
+        spin_lock_irqsave(&mp.ipi_task_lock[i], irqstate);
         /* If a task is still around, it's because the CPU went offline. */
         if (list_in_list(&sync_tasks[i].node)) {
             list_delete(&sync_tasks[i].node);
         }
+        spin_unlock_irqrestore(&mp.ipi_task_lock[i], irqstate);
+    }
+}
+
+/* @brief Queue a task on the specified CPUs and return without waiting.
+ *
+ * The task must not reference any state that may be gone by the time it
+ * runs (the classic use is a TLB shootdown of a region whose mappings have
+ * already been removed from the page tables).  If a target cpu's async ring
+ * is full, delivery to that cpu degrades to the synchronous path.
+ */
+void mp_async_exec(mp_cpu_mask_t target, mp_sync_task_t task, void *context)
+{
+    uint num_cpus = arch_max_num_cpus();
+
+    if (target == MP_CPU_ALL) {
+        target = mp_get_online_mask();
+    } else if (target == MP_CPU_ALL_BUT_LOCAL) {
+        DEBUG_ASSERT(arch_ints_disabled());
+        target = mp_get_online_mask() & ~(1U << arch_curr_cpu_num());
+    }
+    target &= mp_get_online_mask();
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    uint local_cpu = arch_curr_cpu_num();
+    bool targetting_self = !!(target & (1U << local_cpu));
+    target &= ~(1U << local_cpu);
+
+    mp_cpu_mask_t overflow = 0;
+    mp_cpu_mask_t remaining = target;
+    uint cpu_id = 0;
+    while (remaining && cpu_id < num_cpus) {
+        if (remaining & 1) {
+            struct mp_async_queue *q = &async_queue[cpu_id];
+
+            spin_lock(&mp.ipi_task_lock[cpu_id]);
+            if (q->tail - q->head < MP_ASYNC_QUEUE_DEPTH) {
+                uint32_t idx = q->tail & (MP_ASYNC_QUEUE_DEPTH - 1);
+                q->slot[idx].func = task;
+                q->slot[idx].context = context;
+                smp_wmb();
+                q->tail++;
+            } else {
+                /* ring full, this cpu gets the slow synchronous treatment */
+                overflow |= (1U << cpu_id);
+            }
+            spin_unlock(&mp.ipi_task_lock[cpu_id]);
+        }
+        remaining >>= 1;
+        cpu_id++;
+    }
+
+    __UNUSED status_t status = arch_mp_send_ipi(target & ~overflow, MP_IPI_GENERIC);
+    DEBUG_ASSERT(status == NO_ERROR);
+
+    if (targetting_self) {
+        task(context);
+    }
+
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (overflow) {
+        mp_sync_exec(overflow, task, context);
     }
-    spin_unlock_irqrestore(&mp.ipi_task_lock, irqstate);
 }
 
 static void mp_unplug_trampoline(void) __NO_RETURN;
@@ -355,18 +439,31 @@ enum handler_return mp_mbx_generic_irq(void)
     uint local_cpu = arch_curr_cpu_num();
 
     THREAD_STATS_INC(generic_ipis);
+    kcounter_add(&mp_generic_ipis, 1);
 
     while (1) {
         struct mp_ipi_task *task;
-        spin_lock(&mp.ipi_task_lock);
+        spin_lock(&mp.ipi_task_lock[local_cpu]);
         task = list_remove_head_type(&mp.ipi_task_list[local_cpu], struct mp_ipi_task, node);
-        spin_unlock(&mp.ipi_task_lock);
+        spin_unlock(&mp.ipi_task_lock[local_cpu]);
         if (task == NULL) {
             break;
         }
 
         task->func(task->context);
     }
+
+    /* drain any fire-and-forget tasks; we're the only consumer of our ring */
+    struct mp_async_queue *q = &async_queue[local_cpu];
+    while (q->head != q->tail) {
+        smp_rmb();
+        uint32_t idx = q->head & (MP_ASYNC_QUEUE_DEPTH - 1);
+        mp_sync_task_t func = q->slot[idx].func;
+        void *context = q->slot[idx].context;
+        q->head++;
+
+        func(context);
+    }
     return INT_NO_RESCHEDULE;
 }
 
@@ -377,6 +474,7 @@ enum handler_return mp_mbx_reschedule_irq(void)
     LTRACEF("cpu %u\n", cpu);
 
     THREAD_STATS_INC(reschedule_ipis);
+    kcounter_add(&mp_reschedule_ipis, 1);
 
     return (mp.active_cpus & (1U << cpu)) ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
 }
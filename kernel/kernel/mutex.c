@@ -19,8 +19,37 @@
 #include <debug.h>
 #include <assert.h>
 #include <err.h>
+#include <kernel/sched.h>
 #include <kernel/thread.h>
 
+/* upper bound on the adaptive spin phase in mutex_acquire. short critical
+ * sections release well within this; anything longer isn't worth burning
+ * cycles on and we fall through to blocking. */
+#define MUTEX_SPIN_MAX_ITERATIONS 1000
+
+#if WITH_SMP
+/* spin waiting for a contended mutex to be released, as long as the holder
+ * appears to be actively running on another cpu. all reads here are racy
+ * by design: they are only a hint about whether blocking is worthwhile,
+ * and the authoritative state is re-examined under thread_lock by the
+ * caller. thread structures are never unmapped, so a stale holder pointer
+ * reads garbage at worst, never faults.
+ */
+static void mutex_spin(mutex_t *m)
+{
+    for (uint spins = 0; spins < MUTEX_SPIN_MAX_ITERATIONS; spins++) {
+        if (likely(*(volatile int *)&m->count == 0))
+            return;
+
+        thread_t *holder = *(thread_t * volatile *)&m->holder;
+        if (!holder || *(volatile enum thread_state *)&holder->state != THREAD_RUNNING)
+            return;
+
+        arch_spinloop_pause();
+    }
+}
+#endif
+
 /**
  * @brief  Initialize a mutex_t
  */
@@ -71,8 +100,31 @@ void mutex_acquire(mutex_t *m) TA_NO_THREAD_SAFETY_ANALYSIS
               get_current_thread(), get_current_thread()->name, m);
 #endif
 
+#if WITH_SMP
+    /* before paying for a block/context switch, briefly spin in the hope
+     * that a holder running on another cpu is about to release */
+    if (unlikely(m->count > 0))
+        mutex_spin(m);
+#endif
+
+    thread_t *ct = get_current_thread();
+
     THREAD_LOCK(state);
     if (unlikely(++m->count > 1)) {
+        /* priority inheritance: lend our effective priority to the holder
+         * so it can't be starved below us while we wait, and push the
+         * boost down any chain of holders blocked on other mutexes */
+        ct->blocking_mutex = m;
+        mutex_t *bm = m;
+        thread_t *owner = m->holder;
+        while (owner && owner->priority < ct->priority) {
+            if (ct->priority > owner->inherited_priority)
+                owner->inherited_priority = ct->priority;
+            sched_change_priority(owner, ct->priority);
+            bm = owner->blocking_mutex;
+            owner = bm ? bm->holder : NULL;
+        }
+
         status_t ret = wait_queue_block(&m->wait, INFINITE_TIME);
         if (unlikely(ret < NO_ERROR)) {
             /* mutexes are not interruptable and cannot time out, so it
@@ -81,13 +133,62 @@ void mutex_acquire(mutex_t *m) TA_NO_THREAD_SAFETY_ANALYSIS
             panic("mutex_acquire: wait_queue_block returns with error %d m %p, thr %p, sp %p\n",
                    ret, m, get_current_thread(), __GET_FRAME());
         }
+
+        ct->blocking_mutex = NULL;
+    }
+
+    m->holder = ct;
+    list_add_head(&ct->mutex_list, &m->holder_node);
+
+    /* take over any boost from the remaining waiters. a thread that
+     * blocked between the previous holder letting go and us getting here
+     * found no holder to lend its priority to, so it may outrank us. */
+    thread_t *waiter = wait_queue_peek(&m->wait);
+    if (waiter) {
+        if (waiter->priority > ct->inherited_priority)
+            ct->inherited_priority = waiter->priority;
+        if (waiter->priority > ct->priority)
+            sched_change_priority(ct, waiter->priority);
     }
 
-    m->holder = get_current_thread();
     THREAD_UNLOCK(state);
 }
 
 
+/* common release path, called with the thread_lock held */
+static void mutex_release_internal(mutex_t *m, bool reschedule)
+{
+    thread_t *ct = get_current_thread();
+
+    list_delete(&m->holder_node);
+    m->holder = 0;
+
+    /* drop whatever priority we inherited through this mutex: recompute
+     * the boost from the top waiters of the mutexes we still hold. the
+     * wait queues are sorted, so only the heads matter. */
+    if (unlikely(ct->inherited_priority >= 0)) {
+        int inherited = -1;
+        mutex_t *om;
+        list_for_every_entry(&ct->mutex_list, om, mutex_t, holder_node) {
+            thread_t *waiter = wait_queue_peek(&om->wait);
+            if (waiter && waiter->priority > inherited)
+                inherited = waiter->priority;
+        }
+        ct->inherited_priority = inherited;
+
+        int effective = ct->base_priority;
+        if (inherited > effective)
+            effective = inherited;
+        /* deflate before waking so the reschedule below sees it */
+        sched_change_priority(ct, effective);
+    }
+
+    if (unlikely(--m->count >= 1)) {
+        /* release the highest priority waiter */
+        wait_queue_wake_one(&m->wait, reschedule, NO_ERROR);
+    }
+}
+
 void mutex_release(mutex_t *m) TA_NO_THREAD_SAFETY_ANALYSIS
 {
     DEBUG_ASSERT(m->magic == MUTEX_MAGIC);
@@ -101,12 +202,7 @@ void mutex_release(mutex_t *m) TA_NO_THREAD_SAFETY_ANALYSIS
 #endif
 
     THREAD_LOCK(state);
-    m->holder = 0;
-
-    if (unlikely(--m->count >= 1)) {
-        /* release a thread */
-        wait_queue_wake_one(&m->wait, true, NO_ERROR);
-    }
+    mutex_release_internal(m, true);
     THREAD_UNLOCK(state);
 }
 
@@ -126,10 +222,5 @@ void mutex_release_thread_locked(mutex_t *m, bool reschedule) TA_NO_THREAD_SAFET
     }
 #endif
 
-    m->holder = 0;
-
-    if (unlikely(--m->count >= 1)) {
-        /* release a thread */
-        wait_queue_wake_one(&m->wait, reschedule, NO_ERROR);
-    }
+    mutex_release_internal(m, reschedule);
 }
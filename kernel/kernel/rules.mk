@@ -10,10 +10,12 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 MODULE := $(LOCAL_DIR)
 
 MODULE_DEPS := \
+	kernel/lib/counters \
 	kernel/lib/debug \
 	kernel/lib/heap \
 	kernel/lib/libc \
 	kernel/lib/mxtl \
+	kernel/lib/percpu \
 
 
 MODULE_SRCS := \
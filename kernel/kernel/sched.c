@@ -19,54 +19,82 @@
 /* legacy implementation that just broadcast ipis for every reschedule */
 #define BROADCAST_RESCHEDULE 0
 
-/* the run queue */
-static struct list_node run_queue[NUM_PRIORITIES];
-static uint32_t run_queue_bitmap;
+/* the per cpu run queues. threads are enqueued on the queue of the cpu
+ * they're expected to run on, so the common resched path only touches
+ * cpu-local state. idle cpus fall back to stealing from their peers.
+ * all queues are still protected by the global thread_lock; splitting
+ * that lock is a separate project, but keeping the data per-cpu already
+ * takes the queue scans off the shared cache lines.
+ */
+struct sched_run_queue {
+    struct list_node queue[NUM_PRIORITIES];
+    uint32_t bitmap;
+};
+static struct sched_run_queue run_queue[SMP_MAX_CPUS];
 
 /* make sure the bitmap is large enough to cover our number of priorities */
-static_assert(NUM_PRIORITIES <= sizeof(run_queue_bitmap) * CHAR_BIT, "");
-
-/* pick a 'random' cpu */
-static mp_cpu_mask_t rand_cpu(const mp_cpu_mask_t mask)
+static_assert(NUM_PRIORITIES <= sizeof(run_queue[0].bitmap) * CHAR_BIT, "");
+
+/* the EDF deadline class: one queue per cpu, kept sorted by absolute
+ * deadline and serviced ahead of every priority queue. admission is
+ * controlled so the class as a whole leaves headroom for the priority
+ * classes; a thread that burns its whole capacity before its period rolls
+ * over competes at its static priority until the next period, so it
+ * degrades instead of hogging the cpu or stalling outright.
+ */
+static struct list_node deadline_queue[SMP_MAX_CPUS];
+
+/* sum of capacity/period over all admitted threads, in permille of one
+ * cpu. protected by the thread_lock like the run queues. */
+static uint64_t deadline_util_permille;
+
+/* cap per online cpu; EDF across per-cpu queues with stealing is a soft
+ * guarantee, so keep real headroom rather than packing to 100% */
+#define DEADLINE_UTIL_LIMIT_PERMILLE 900
+
+static uint64_t deadline_util(lk_time_t capacity, lk_time_t period)
 {
-    if (unlikely(mask == 0))
-        return 0;
-
-    /* check that the mask passed in has at least one bit set in the online mask */
-    mp_cpu_mask_t online = mp_get_online_mask();
-    if (unlikely((mask & online) == 0))
-        return 0;
-
-    /* compute the highest online cpu */
-    uint highest_cpu = (sizeof(mp_cpu_mask_t) * CHAR_BIT - 1) - __builtin_clz(online);
+    return (capacity * 1000u) / period;
+}
 
-    /* not very random, round robins a bit through the mask until it gets a hit */
-    for (;;) {
-        /* protected by THREAD_LOCK, safe to use non atomically */
-        static uint rot = 0;
+#if WITH_SMP
+/* per cpu topology masks, published by arch code via sched_set_cpu_topology().
+ * default to just the cpu itself so an undescribed topology degrades to the
+ * old "any idle cpu" policy rather than anything incorrect.
+ */
+static mp_cpu_mask_t smt_sibling_mask[SMP_MAX_CPUS];
+static mp_cpu_mask_t llc_peer_mask[SMP_MAX_CPUS];
+#endif
 
-        if (++rot > highest_cpu)
-            rot = 0;
+void sched_set_cpu_topology(uint cpu, mp_cpu_mask_t smt_siblings, mp_cpu_mask_t llc_peers)
+{
+#if WITH_SMP
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
+    DEBUG_ASSERT(smt_siblings & (1u << cpu));
+    DEBUG_ASSERT(llc_peers & (1u << cpu));
 
-        if ((1u << rot) & mask)
-            return (1u << rot);
-    }
+    smt_sibling_mask[cpu] = smt_siblings;
+    llc_peer_mask[cpu] = llc_peers;
+#endif
 }
 
-/* find a cpu to wake up */
-static mp_cpu_mask_t find_cpu(thread_t *t)
+/* find a cpu to wake up, restricted to the cpus in |allowed| (which the
+ * caller guarantees is non-empty). a return of 0 means "run locally" and
+ * is only produced when the current cpu is in |allowed|. */
+static mp_cpu_mask_t find_cpu(thread_t *t, mp_cpu_mask_t allowed)
 {
 #if BROADCAST_RESCHEDULE
     return MP_CPU_ALL_BUT_LOCAL;
 #elif WITH_SMP
-    /* get the last cpu the thread ran on */
-    mp_cpu_mask_t last_ran_cpu_mask = (1u << thread_last_cpu(t));
+    /* get the last cpu the thread ran on, if the mask still permits it */
+    uint last_ran_cpu = thread_last_cpu(t);
+    mp_cpu_mask_t last_ran_cpu_mask = (1u << last_ran_cpu) & allowed;
 
     /* the current cpu */
-    mp_cpu_mask_t curr_cpu_mask = (1u << arch_curr_cpu_num());
+    mp_cpu_mask_t curr_cpu_mask = (1u << arch_curr_cpu_num()) & allowed;
 
-    /* get a list of idle cpus */
-    mp_cpu_mask_t idle_cpu_mask = mp_get_idle_mask();
+    /* get a list of idle cpus the thread may run on */
+    mp_cpu_mask_t idle_cpu_mask = mp_get_idle_mask() & allowed;
     if (idle_cpu_mask != 0) {
         if (idle_cpu_mask & curr_cpu_mask) {
             /* the current cpu is idle, so run it here */
@@ -78,76 +106,288 @@ static mp_cpu_mask_t find_cpu(thread_t *t)
             return last_ran_cpu_mask;
         }
 
-        /* pick an idle_cpu */
-        return rand_cpu(idle_cpu_mask);
+        /* walk outwards from the last-run cpu: an idle SMT sibling shares
+         * L1/L2, an idle LLC peer still avoids a cross-socket migration.
+         * the idle mask is consulted directly; no queue scanning needed. */
+        mp_cpu_mask_t mask = smt_sibling_mask[last_ran_cpu] & idle_cpu_mask;
+        if (mask)
+            return 1u << __builtin_ctz(mask);
+
+        mask = llc_peer_mask[last_ran_cpu] & idle_cpu_mask;
+        if (mask)
+            return 1u << __builtin_ctz(mask);
+
+        /* pick the lowest numbered idle cpu */
+        return 1u << __builtin_ctz(idle_cpu_mask);
+    }
+
+    /* no idle cpus in the allowed set */
+    if (curr_cpu_mask && last_ran_cpu_mask == curr_cpu_mask) {
+        /* the last cpu it ran on is us; prefer a busy LLC peer over a
+         * remote cpu so the wakee's working set stays in the cache */
+        mp_cpu_mask_t mask = llc_peer_mask[last_ran_cpu] & mp_get_online_mask() & allowed & ~curr_cpu_mask;
+        if (mask)
+            return 1u << __builtin_ctz(mask);
+
+        mask = mp_get_online_mask() & allowed & ~curr_cpu_mask;
+        if (mask)
+            return 1u << __builtin_ctz(mask);
+
+        return 0;
     }
 
-    /* no idle cpus */
-    if (last_ran_cpu_mask == curr_cpu_mask) {
-        /* the last cpu it ran on is us */
-        /* pick a random cpu that isn't the current one */
-        return rand_cpu(mp_get_online_mask() & ~(curr_cpu_mask));
-    } else {
+    if (last_ran_cpu_mask) {
         /* pick the last cpu it ran on */
         return last_ran_cpu_mask;
     }
+
+    /* the last-run cpu is excluded by the mask */
+    if (curr_cpu_mask)
+        return 0;
+
+    mp_cpu_mask_t mask = mp_get_online_mask() & allowed;
+    if (mask)
+        return 1u << __builtin_ctz(mask);
+
+    /* nothing online in the allowed set; degrade to running locally */
+    return 0;
 #else /* !WITH_SMP */
     /* no smp, dont send an IPI */
     return 0;
 #endif
 }
 
+/* pick the cpu queue a newly runnable thread should be enqueued on,
+ * honoring any pin. the return value is also the IPI target: 0 if
+ * the thread should run locally, otherwise a single cpu mask.
+ */
+static uint pick_run_cpu(thread_t *t, mp_cpu_mask_t *ipi_target)
+{
+#if WITH_SMP
+    if (unlikely(thread_pinned_cpu(t) >= 0)) {
+        uint cpu = (uint)thread_pinned_cpu(t);
+        *ipi_target = (cpu == arch_curr_cpu_num()) ? 0 : (1u << cpu);
+        return cpu;
+    }
+
+    /* constrain placement to the thread's affinity mask; an empty
+     * intersection with the online set falls back to unrestricted
+     * placement rather than stranding the thread */
+    mp_cpu_mask_t allowed = t->cpu_affinity & mp_get_online_mask();
+    if (unlikely(allowed == 0))
+        allowed = mp_get_online_mask();
+
+    mp_cpu_mask_t target = find_cpu(t, allowed);
+    *ipi_target = target;
+    if (target == 0)
+        return arch_curr_cpu_num();
+
+    return (uint)__builtin_ctz(target);
+#else
+    *ipi_target = 0;
+    return 0;
+#endif
+}
+
+/* start a fresh period if the current one has expired by the time the
+ * thread becomes runnable again. a thread that wakes late re-anchors its
+ * period at the wakeup, so a waker that slept through several periods
+ * doesn't bank the deadline slots it missed.
+ */
+static void deadline_replenish(thread_t *t, lk_time_t now)
+{
+    if (now >= t->dl_period_start + t->dl_period) {
+        t->dl_period_start = now;
+        t->dl_abs_deadline = now + t->dl_rel_deadline;
+        t->dl_budget = t->dl_capacity;
+    }
+}
+
+/* sorted insert by absolute deadline, earliest at the head */
+static void insert_in_deadline_queue(uint cpu, thread_t *t)
+{
+    thread_t *other;
+    list_for_every_entry(&deadline_queue[cpu], other, thread_t, queue_node) {
+        if (t->dl_abs_deadline < other->dl_abs_deadline) {
+            list_add_before(&other->queue_node, &t->queue_node);
+            return;
+        }
+    }
+    list_add_tail(&deadline_queue[cpu], &t->queue_node);
+}
+
+/* route a newly READY deadline thread: onto the EDF queue while it has
+ * budget, otherwise onto its priority queue until the next period.
+ * returns true if the thread was queued.
+ */
+static bool insert_deadline_thread(uint cpu, thread_t *t)
+{
+    if (!thread_is_deadline(t))
+        return false;
+
+    deadline_replenish(t, t->last_ready_time);
+    if (t->dl_budget == 0)
+        return false;
+
+    insert_in_deadline_queue(cpu, t);
+    return true;
+}
+
 /* run queue manipulation */
-static void insert_in_run_queue_head(thread_t *t)
+static void insert_in_run_queue_head(uint cpu, thread_t *t)
 {
     DEBUG_ASSERT(t->magic == THREAD_MAGIC);
     DEBUG_ASSERT(t->state == THREAD_READY);
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
 
-    list_add_head(&run_queue[t->priority], &t->queue_node);
-    run_queue_bitmap |= (1<<t->priority);
+    t->last_ready_time = current_time();
+    if (unlikely(insert_deadline_thread(cpu, t)))
+        return;
+    list_add_head(&run_queue[cpu].queue[t->priority], &t->queue_node);
+    run_queue[cpu].bitmap |= (1u<<t->priority);
 }
 
-static void insert_in_run_queue_tail(thread_t *t)
+static void insert_in_run_queue_tail(uint cpu, thread_t *t)
 {
     DEBUG_ASSERT(t->magic == THREAD_MAGIC);
     DEBUG_ASSERT(t->state == THREAD_READY);
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
 
-    list_add_tail(&run_queue[t->priority], &t->queue_node);
-    run_queue_bitmap |= (1<<t->priority);
+    t->last_ready_time = current_time();
+    if (unlikely(insert_deadline_thread(cpu, t)))
+        return;
+    list_add_tail(&run_queue[cpu].queue[t->priority], &t->queue_node);
+    run_queue[cpu].bitmap |= (1u<<t->priority);
 }
 
-thread_t *sched_get_top_thread(uint cpu)
+/* queue the current (just descheduled) thread, normally on the local cpu;
+ * a thread whose affinity mask excludes this cpu migrates away here */
+static void insert_current_in_run_queue(thread_t *ct, bool at_head)
 {
-    thread_t *newthread;
-    uint32_t local_run_queue_bitmap = run_queue_bitmap;
+    uint cpu = arch_curr_cpu_num();
+
+    if (unlikely((ct->cpu_affinity & (1u << cpu)) == 0) && thread_pinned_cpu(ct) < 0) {
+        mp_cpu_mask_t ipi_target;
+        uint target = pick_run_cpu(ct, &ipi_target);
+        if (target != cpu) {
+            insert_in_run_queue_head(target, ct);
+            mp_reschedule(ipi_target, 0);
+            return;
+        }
+    }
+
+    if (at_head)
+        insert_in_run_queue_head(cpu, ct);
+    else
+        insert_in_run_queue_tail(cpu, ct);
+}
+
+/* dequeue the highest priority thread from cpu's local queue, or NULL */
+static thread_t *dequeue_local_thread(uint cpu)
+{
+    /* the deadline class runs ahead of every priority; the queue is
+     * sorted, so the head is the earliest local deadline */
+    if (unlikely(!list_is_empty(&deadline_queue[cpu])))
+        return list_remove_head_type(&deadline_queue[cpu], thread_t, queue_node);
+
+    struct sched_run_queue *rq = &run_queue[cpu];
+
+    if (rq->bitmap == 0)
+        return NULL;
 
-    while (local_run_queue_bitmap) {
-        /* find the first (remaining) queue with a thread in it */
-        uint next_queue = HIGHEST_PRIORITY - __builtin_clz(local_run_queue_bitmap)
-                          - (sizeof(run_queue_bitmap) * CHAR_BIT - NUM_PRIORITIES);
+    /* find the first queue with a thread in it; everything on a local
+     * queue is eligible to run here, so just pop the head */
+    uint next_queue = HIGHEST_PRIORITY - __builtin_clz(rq->bitmap)
+                      - (sizeof(rq->bitmap) * CHAR_BIT - NUM_PRIORITIES);
+
+    thread_t *newthread = list_remove_head_type(&rq->queue[next_queue], thread_t, queue_node);
+    DEBUG_ASSERT(newthread);
+
+    if (list_is_empty(&rq->queue[next_queue]))
+        rq->bitmap &= ~(1u<<next_queue);
+
+    return newthread;
+}
 
-        list_for_every_entry(&run_queue[next_queue], newthread, thread_t, queue_node) {
 #if WITH_SMP
-            if (likely(newthread->pinned_cpu < 0) || (uint)newthread->pinned_cpu == cpu)
-#endif
-            {
-                list_delete(&newthread->queue_node);
+/* work stealing: scan the other cpus' queues from the highest priority down,
+ * taking the first unpinned thread found that outranks anything local */
+static thread_t *steal_thread(uint cpu)
+{
+    mp_cpu_mask_t online = mp_get_online_mask();
 
-                if (list_is_empty(&run_queue[next_queue]))
-                    run_queue_bitmap &= ~(1<<next_queue);
+    /* a waiting deadline thread outranks any priority thread; take the
+     * earliest unpinned deadline across the peers. queues are sorted, so
+     * only the first unpinned entry of each queue is a candidate. */
+    thread_t *dl = NULL;
+    for (uint c = 0; c < SMP_MAX_CPUS; c++) {
+        if (c == cpu || ((online & (1u << c)) == 0))
+            continue;
+
+        thread_t *t;
+        list_for_every_entry(&deadline_queue[c], t, thread_t, queue_node) {
+            if (thread_pinned_cpu(t) >= 0 || (t->cpu_affinity & (1u << cpu)) == 0)
+                continue;
+
+            if (!dl || t->dl_abs_deadline < dl->dl_abs_deadline)
+                dl = t;
+            break;
+        }
+    }
+    if (dl) {
+        list_delete(&dl->queue_node);
+        return dl;
+    }
+
+    for (int pri = HIGHEST_PRIORITY; pri >= LOWEST_PRIORITY; pri--) {
+        uint32_t pri_bit = 1u << pri;
+
+        for (uint c = 0; c < SMP_MAX_CPUS; c++) {
+            if (c == cpu || ((online & (1u << c)) == 0))
+                continue;
+
+            struct sched_run_queue *rq = &run_queue[c];
+            if ((rq->bitmap & pri_bit) == 0)
+                continue;
+
+            thread_t *t;
+            list_for_every_entry(&rq->queue[pri], t, thread_t, queue_node) {
+                if (thread_pinned_cpu(t) >= 0 || (t->cpu_affinity & (1u << cpu)) == 0)
+                    continue;
+
+                list_delete(&t->queue_node);
+                if (list_is_empty(&rq->queue[pri]))
+                    rq->bitmap &= ~pri_bit;
 
-                return newthread;
+                return t;
             }
         }
-
-        local_run_queue_bitmap &= ~(1<<next_queue);
     }
+
+    return NULL;
+}
+#endif
+
+thread_t *sched_get_top_thread(uint cpu)
+{
+    /* the local queue is the fast path */
+    thread_t *newthread = dequeue_local_thread(cpu);
+    if (likely(newthread))
+        return newthread;
+
+#if WITH_SMP
+    /* nothing locally runnable, try to steal from a busy peer */
+    newthread = steal_thread(cpu);
+    if (newthread)
+        return newthread;
+#endif
+
     /* no threads to run, select the idle thread for this cpu */
     return &idle_threads[cpu];
 }
@@ -179,14 +419,17 @@ void sched_unblock(thread_t *t, bool resched)
         thread_t *current_thread = get_current_thread();
 
         current_thread->state = THREAD_READY;
-        insert_in_run_queue_head(current_thread);
+        insert_current_in_run_queue(current_thread, true);
     }
 
-    /* stuff the new thread in the run queue */
+    /* stuff the new thread in the run queue of the cpu it should run on */
+    mp_cpu_mask_t ipi_target;
+    uint cpu = pick_run_cpu(t, &ipi_target);
+
     t->state = THREAD_READY;
-    insert_in_run_queue_head(t);
+    insert_in_run_queue_head(cpu, t);
 
-    mp_reschedule(find_cpu(t), 0);
+    mp_reschedule(ipi_target, 0);
 
     if (resched)
         thread_resched();
@@ -205,7 +448,7 @@ void sched_unblock_list(struct list_node *list, bool resched)
         thread_t *current_thread = get_current_thread();
 
         current_thread->state = THREAD_READY;
-        insert_in_run_queue_head(current_thread);
+        insert_current_in_run_queue(current_thread, true);
     }
 
     /* pop the list of threads and shove into the scheduler */
@@ -214,11 +457,14 @@ void sched_unblock_list(struct list_node *list, bool resched)
         DEBUG_ASSERT(t->magic == THREAD_MAGIC);
         DEBUG_ASSERT(!thread_is_idle(t));
 
-        /* stuff the new thread in the run queue */
+        /* stuff the new thread in the run queue of the cpu it should run on */
+        mp_cpu_mask_t ipi_target;
+        uint cpu = pick_run_cpu(t, &ipi_target);
+
         t->state = THREAD_READY;
-        insert_in_run_queue_head(t);
+        insert_in_run_queue_head(cpu, t);
 
-        mp_reschedule(find_cpu(t), 0);
+        mp_reschedule(ipi_target, 0);
     }
 
     if (resched)
@@ -234,7 +480,7 @@ void sched_yield(void)
     current_thread->state = THREAD_READY;
     current_thread->remaining_time_slice = 0;
     if (likely(!thread_is_idle(current_thread))) { /* idle thread doesn't go in the run queue */
-        insert_in_run_queue_tail(current_thread);
+        insert_current_in_run_queue(current_thread, false);
     }
     thread_resched();
 }
@@ -242,22 +488,181 @@ void sched_yield(void)
 void sched_preempt(void)
 {
     thread_t *current_thread = get_current_thread();
+    uint cpu = arch_curr_cpu_num();
 
     /* we are being preempted, so we get to go back into the front of the run queue if we have quantum left */
     current_thread->state = THREAD_READY;
     if (likely(!thread_is_idle(current_thread))) { /* idle thread doesn't go in the run queue */
-        if (current_thread->remaining_time_slice > 0)
-            insert_in_run_queue_head(current_thread);
-        else
-            insert_in_run_queue_tail(current_thread); /* if we're out of quantum, go to the tail of the queue */
+        /* if we're out of quantum, go to the tail of the queue */
+        insert_current_in_run_queue(current_thread, current_thread->remaining_time_slice > 0);
     }
     sched_block();
 }
 
+/* a READY thread was unlinked from a run queue without knowing which
+ * cpu's queue held it; clear any bitmap bit left pointing at the queue
+ * that was emptied */
+static void scrub_run_queue_bitmaps(int pri)
+{
+    uint32_t pri_bit = 1u << pri;
+    for (uint c = 0; c < SMP_MAX_CPUS; c++) {
+        if ((run_queue[c].bitmap & pri_bit) && list_is_empty(&run_queue[c].queue[pri]))
+            run_queue[c].bitmap &= ~pri_bit;
+    }
+}
+
+void sched_change_priority(thread_t *t, int pri)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(pri > IDLE_PRIORITY && pri <= HIGHEST_PRIORITY);
+    DEBUG_ASSERT(!thread_is_idle(t));
+
+    int old_pri = t->priority;
+    if (old_pri == pri)
+        return;
+
+    t->priority = pri;
+
+    switch (t->state) {
+    case THREAD_READY: {
+        /* deadline threads queue by absolute deadline, not priority; the
+         * static priority only matters once the budget is gone, i.e. at
+         * the next enqueue */
+        if (thread_is_deadline(t) && t->dl_budget > 0)
+            break;
+
+        /* the run queues don't record which cpu a READY thread was queued
+         * on, but unlinking doesn't need the head */
+        DEBUG_ASSERT(list_in_list(&t->queue_node));
+        list_delete(&t->queue_node);
+        scrub_run_queue_bitmaps(old_pri);
+
+        /* requeue at the head of the new priority; a boosted thread has
+         * already waited its turn at the old one */
+        mp_cpu_mask_t ipi_target;
+        uint cpu = pick_run_cpu(t, &ipi_target);
+        list_add_head(&run_queue[cpu].queue[pri], &t->queue_node);
+        run_queue[cpu].bitmap |= (1u << pri);
+        if (pri > old_pri)
+            mp_reschedule(ipi_target, 0);
+        break;
+    }
+    case THREAD_BLOCKED:
+        /* keep the wait queue sorted; if the thread is blocked on a mutex
+         * this is what keeps the next-owner choice correct */
+        if (t->blocking_wait_queue)
+            wait_queue_priority_changed(t);
+        break;
+    default:
+        /* RUNNING threads aren't in any queue and pick up the new priority
+         * at their next preemption check; SLEEPING/SUSPENDED threads get
+         * requeued with it when they wake */
+        break;
+    }
+}
+
+void sched_affinity_changed(thread_t *t)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    if (t->state != THREAD_READY)
+        return;
+
+    /* the thread may be sitting on the queue of a cpu the new mask
+     * excludes; pull it off and let pick_run_cpu() place it again */
+    DEBUG_ASSERT(list_in_list(&t->queue_node));
+    list_delete(&t->queue_node);
+    scrub_run_queue_bitmaps(t->priority);
+
+    mp_cpu_mask_t ipi_target;
+    uint cpu = pick_run_cpu(t, &ipi_target);
+
+    if (thread_is_deadline(t) && t->dl_budget > 0)
+        insert_in_deadline_queue(cpu, t);
+    else {
+        list_add_head(&run_queue[cpu].queue[t->priority], &t->queue_node);
+        run_queue[cpu].bitmap |= (1u << t->priority);
+    }
+
+    mp_reschedule(ipi_target, 0);
+}
+
+status_t sched_set_deadline(thread_t *t, lk_time_t capacity, lk_time_t rel_deadline, lk_time_t period)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    uint64_t old_util = thread_is_deadline(t) ? deadline_util(t->dl_capacity, t->dl_period) : 0;
+
+    if (period == 0) {
+        /* leave the class and return the reservation. if the thread is
+         * sitting READY in a deadline queue it keeps that slot; the change
+         * takes full effect the next time it is queued. */
+        if (thread_is_deadline(t)) {
+            DEBUG_ASSERT(deadline_util_permille >= old_util);
+            deadline_util_permille -= old_util;
+            t->flags &= ~THREAD_FLAG_DEADLINE;
+            t->dl_capacity = 0;
+            t->dl_rel_deadline = 0;
+            t->dl_period = 0;
+        }
+        return NO_ERROR;
+    }
+
+    if (capacity == 0 || capacity > rel_deadline || rel_deadline > period)
+        return ERR_INVALID_ARGS;
+
+    uint64_t new_util = deadline_util(capacity, period);
+    if (new_util == 0)
+        return ERR_INVALID_ARGS;
+
+    /* admission control, scaled by the online cpus */
+    uint64_t limit = (uint64_t)DEADLINE_UTIL_LIMIT_PERMILLE *
+                     (uint64_t)__builtin_popcount((unsigned)mp_get_online_mask());
+    if (deadline_util_permille - old_util + new_util > limit)
+        return ERR_NO_RESOURCES;
+    deadline_util_permille += new_util - old_util;
+
+    /* the first period starts now; a thread already READY in a priority
+     * queue keeps that slot and joins the EDF queue on its next wakeup */
+    lk_time_t now = current_time();
+    t->dl_capacity = capacity;
+    t->dl_rel_deadline = rel_deadline;
+    t->dl_period = period;
+    t->dl_period_start = now;
+    t->dl_abs_deadline = now + rel_deadline;
+    t->dl_budget = capacity;
+    t->flags |= THREAD_FLAG_DEADLINE;
+
+    return NO_ERROR;
+}
+
+void sched_deadline_charge(thread_t *t, lk_time_t ran)
+{
+    DEBUG_ASSERT(thread_is_deadline(t));
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    /* budget is metered at reschedule boundaries, so enforcement is
+     * tick-granular; pick capacities with at least a tick of slop */
+    t->dl_budget -= MIN(ran, t->dl_budget);
+}
+
 void sched_init_early(void)
 {
     /* initialize the run queues */
-    for (int i=0; i < NUM_PRIORITIES; i++)
-        list_initialize(&run_queue[i]);
-}
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        for (int i = 0; i < NUM_PRIORITIES; i++)
+            list_initialize(&run_queue[cpu].queue[i]);
+        list_initialize(&deadline_queue[cpu]);
+    }
 
+#if WITH_SMP
+    /* until arch code describes the topology, every cpu is its own island */
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        smt_sibling_mask[cpu] = (1u << cpu);
+        llc_peer_mask[cpu] = (1u << cpu);
+    }
+#endif
+}
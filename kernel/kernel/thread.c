@@ -30,6 +30,7 @@
 #include <kernel/vm.h>
 #include <platform.h>
 #include <target.h>
+#include <lib/counters.h>
 #include <lib/heap.h>
 #include <lib/ktrace.h>
 
@@ -37,8 +38,14 @@
 #include <magenta/c_user_thread.h>
 #endif
 
+#if WITH_LIB_WATCHDOG
+#include <lib/watchdog.h>
+#endif
+
 struct thread_stats thread_stats[SMP_MAX_CPUS];
 
+KCOUNTER(thread_context_switches, "thread.context_switches");
+
 #define STACK_DEBUG_BYTE (0x99)
 #define STACK_DEBUG_WORD (0x99999999)
 
@@ -70,6 +77,8 @@ static void thread_do_suspend(void);
 #if PLATFORM_HAS_DYNAMIC_TIMER
 /* preemption timer */
 static timer_t preempt_timer[SMP_MAX_CPUS];
+
+static enum handler_return preempt_timer_tick(timer_t *t, lk_time_t now, void *arg);
 #endif
 
 static void init_thread_struct(thread_t *t, const char *name)
@@ -77,7 +86,10 @@ static void init_thread_struct(thread_t *t, const char *name)
     memset(t, 0, sizeof(thread_t));
     t->magic = THREAD_MAGIC;
     thread_set_pinned_cpu(t, -1);
+    t->cpu_affinity = (uint32_t)-1;
     strlcpy(t->name, name, sizeof(t->name));
+    t->inherited_priority = -1;
+    list_initialize(&t->mutex_list);
     wait_queue_init(&t->retcode_wait_queue);
 }
 
@@ -147,11 +159,13 @@ thread_t *thread_create_etc(
     t->entry = entry;
     t->arg = arg;
     t->priority = priority;
+    t->base_priority = priority;
     t->state = THREAD_INITIAL;
     t->signals = 0;
     t->blocking_wait_queue = NULL;
     t->blocked_status = NO_ERROR;
     t->interruptable = false;
+    t->timer_slack = 0;
     thread_set_last_cpu(t, 0);
 
     t->retcode = 0;
@@ -481,6 +495,10 @@ void thread_forget(thread_t *t)
     __UNUSED thread_t *current_thread = get_current_thread();
     DEBUG_ASSERT(current_thread != t);
 
+    /* return any deadline reservation */
+    if (unlikely(thread_is_deadline(t)))
+        sched_set_deadline(t, 0, 0, 0);
+
     list_delete(&t->thread_list_node);
     THREAD_UNLOCK(state);
 
@@ -519,6 +537,10 @@ void thread_exit(int retcode)
 
     THREAD_LOCK(state);
 
+    /* return any deadline reservation before the thread goes away */
+    if (unlikely(thread_is_deadline(current_thread)))
+        sched_set_deadline(current_thread, 0, 0, 0);
+
     thread_exit_locked(current_thread, retcode);
 }
 
@@ -681,6 +703,10 @@ void thread_resched(void)
 
     THREAD_STATS_INC(reschedules);
 
+#if WITH_LIB_WATCHDOG
+    watchdog_lockup_progress();
+#endif
+
     /* pick a new thread to run */
     thread_t *newthread = sched_get_top_thread(cpu);
 
@@ -695,11 +721,32 @@ void thread_resched(void)
         return;
 
     lk_time_t now = current_time();
-    oldthread->runtime_ns += now - oldthread->last_started_running;
+    lk_time_t old_ran = now - oldthread->last_started_running;
+    oldthread->runtime_ns += old_ran;
     newthread->last_started_running = now;
 
-    /* set up quantum for the new thread if it was consumed */
-    if (newthread->remaining_time_slice == 0) {
+    /* burn the outgoing thread's deadline budget */
+    if (unlikely(thread_is_deadline(oldthread)))
+        sched_deadline_charge(oldthread, old_ran);
+
+    /* account for how long the incoming thread sat READY in a run queue and
+     * record why the outgoing thread is leaving the cpu. idle threads are
+     * never queued, so skip them. */
+    if (!thread_is_idle(newthread))
+        newthread->runqueue_wait_ns += now - newthread->last_ready_time;
+    if (!thread_is_idle(oldthread)) {
+        if (oldthread->state == THREAD_READY)
+            oldthread->involuntary_switches++;
+        else
+            oldthread->voluntary_switches++;
+    }
+
+    /* set up quantum for the new thread if it was consumed. a deadline
+     * thread with budget runs on that budget so the tick throttles it the
+     * moment its reservation for this period is spent. */
+    if (unlikely(thread_is_deadline(newthread)) && newthread->dl_budget > 0) {
+        newthread->remaining_time_slice = newthread->dl_budget;
+    } else if (newthread->remaining_time_slice == 0) {
         newthread->remaining_time_slice = THREAD_INITIAL_TIME_SLICE;
     }
 
@@ -720,6 +767,7 @@ void thread_resched(void)
     }
 
     THREAD_STATS_INC(context_switches);
+    kcounter_add(&thread_context_switches, 1);
 
     if (thread_is_idle(oldthread)) {
         thread_stats[cpu].idle_time += now - thread_stats[cpu].last_idle_timestamp;
@@ -742,10 +790,12 @@ void thread_resched(void)
         }
     } else if (thread_is_real_time_or_idle(oldthread)) {
         /* if we're switching from a real time (or idle thread) to a regular one,
-         * set up a periodic timer to run our preemption tick. */
+         * arm a oneshot timer to run our preemption tick. the tick re-arms
+         * itself only while a preemptible thread is running, so idle cpus
+         * take no periodic interrupts at all. */
         TRACE_CONTEXT_SWITCH("start preempt, cpu %u, old %p (%s), new %p (%s)\n",
                 cpu, oldthread, oldthread->name, newthread, newthread->name);
-        timer_set_periodic(&preempt_timer[cpu], THREAD_TICK_RATE, (timer_callback)thread_timer_tick, NULL);
+        timer_set_oneshot(&preempt_timer[cpu], now + THREAD_TICK_RATE, preempt_timer_tick, NULL);
     }
 #endif
 
@@ -858,6 +908,22 @@ void thread_preempt(bool interrupt)
     THREAD_UNLOCK(state);
 }
 
+#if PLATFORM_HAS_DYNAMIC_TIMER
+/* oneshot preemption tick. re-arms itself only while the interrupted thread
+ * can actually be preempted, so a cpu that has gone idle (or is running a
+ * real time thread) stops taking periodic timer interrupts entirely and the
+ * hardware timer is armed purely for pending timer_t deadlines. */
+static enum handler_return preempt_timer_tick(timer_t *t, lk_time_t now, void *arg)
+{
+    enum handler_return ret = thread_timer_tick();
+
+    if (!thread_is_real_time_or_idle(get_current_thread()))
+        timer_set_oneshot(t, now + THREAD_TICK_RATE, preempt_timer_tick, NULL);
+
+    return ret;
+}
+#endif
+
 enum handler_return thread_timer_tick(void)
 {
     thread_t *current_thread = get_current_thread();
@@ -944,7 +1010,8 @@ status_t thread_sleep_etc(lk_time_t deadline, bool interruptable)
 
     if (deadline != INFINITE_TIME) {
         /* set a one shot timer to wake us up and reschedule */
-        timer_set_oneshot(&timer, deadline, thread_sleep_handler, (void *)current_thread);
+        timer_set_oneshot_slack(&timer, deadline, current_thread->timer_slack,
+                                thread_sleep_handler, (void *)current_thread);
     }
     current_thread->state = THREAD_SLEEPING;
     current_thread->blocked_status = NO_ERROR;
@@ -993,6 +1060,27 @@ lk_time_t thread_runtime(const thread_t *t)
     return runtime;
 }
 
+/**
+ * @brief Snapshot the per-thread scheduler counters.
+ *
+ * This takes the thread_lock so the counters are mutually consistent and the
+ * in-progress run interval is folded into the runtime.
+ */
+void thread_get_sched_stats(const thread_t *t, thread_sched_stats_t *stats)
+{
+    THREAD_LOCK(state);
+
+    stats->runtime_ns = t->runtime_ns;
+    if (t->state == THREAD_RUNNING) {
+        stats->runtime_ns += current_time() - t->last_started_running;
+    }
+    stats->runqueue_wait_ns = t->runqueue_wait_ns;
+    stats->voluntary_switches = t->voluntary_switches;
+    stats->involuntary_switches = t->involuntary_switches;
+
+    THREAD_UNLOCK(state);
+}
+
 /**
  * @brief Construct a thread t around the current running state
  *
@@ -1009,6 +1097,7 @@ void thread_construct_first(thread_t *t, const char *name)
 
     init_thread_struct(t, name);
     t->priority = HIGHEST_PRIORITY;
+    t->base_priority = HIGHEST_PRIORITY;
     t->state = THREAD_RUNNING;
     t->flags = THREAD_FLAG_DETACHED;
     t->signals = 0;
@@ -1087,6 +1176,12 @@ void thread_set_priority(int priority)
         priority = IDLE_PRIORITY + 1;
     if (priority > HIGHEST_PRIORITY)
         priority = HIGHEST_PRIORITY;
+    current_thread->base_priority = priority;
+
+    /* an active boost inherited from a mutex waiter keeps the effective
+     * priority up regardless of what the base is set to */
+    if (priority < current_thread->inherited_priority)
+        priority = current_thread->inherited_priority;
     current_thread->priority = priority;
 
     sched_preempt();
@@ -1094,6 +1189,95 @@ void thread_set_priority(int priority)
     THREAD_UNLOCK(state);
 }
 
+/**
+ * @brief Set the default timer slack for a thread
+ *
+ * Deadlines for the thread's sleeps and timed blocking waits may be
+ * serviced up to *slack* ns late so they can share a timer expiration
+ * with other nearby deadlines. Zero (the default) keeps exact deadlines.
+ * The new value applies the next time the thread blocks.
+ */
+void thread_set_timer_slack(thread_t *t, lk_time_t slack)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    t->timer_slack = slack;
+}
+
+/**
+ * @brief Restrict the cpus a thread may be scheduled on
+ *
+ * *affinity* is a mask with one bit per cpu; bits beyond the online set
+ * are simply never used. An internal pin (thread_set_pinned_cpu()) takes
+ * precedence over the mask, and a mask that excludes every online cpu
+ * degrades to unrestricted placement rather than stranding the thread.
+ *
+ * A READY thread is requeued immediately; a thread running on a cpu the
+ * new mask excludes is preempted so it can migrate; blocked and sleeping
+ * threads pick the mask up when they next become runnable.
+ */
+status_t thread_set_cpu_affinity(thread_t *t, uint32_t affinity)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    if (affinity == 0)
+        return ERR_INVALID_ARGS;
+
+    THREAD_LOCK(state);
+
+    t->cpu_affinity = affinity;
+
+#if WITH_SMP
+    switch (t->state) {
+    case THREAD_READY:
+        sched_affinity_changed(t);
+        break;
+    case THREAD_RUNNING:
+        if ((affinity & (1u << thread_last_cpu(t))) == 0 && thread_pinned_cpu(t) < 0) {
+            if (t == get_current_thread())
+                sched_preempt(); /* migrates via the queue-insert path */
+            else
+                mp_reschedule(1u << thread_last_cpu(t), 0);
+        }
+        break;
+    default:
+        break;
+    }
+#endif
+
+    THREAD_UNLOCK(state);
+
+    return NO_ERROR;
+}
+
+/**
+ * @brief Put a thread in, or remove it from, the deadline class
+ *
+ * Reserves *capacity* ns of runtime out of every *period* ns for the thread,
+ * due *rel_deadline* ns into each period. Deadline threads are serviced
+ * earliest-deadline-first ahead of every priority, so the reservation holds
+ * regardless of what the priority ladder is doing. Admission is controlled:
+ * the call fails with ERR_NO_RESOURCES rather than over-committing the cpus.
+ * A *period* of 0 returns the thread to its static priority.
+ *
+ * @return NO_ERROR on success, ERR_INVALID_ARGS unless
+ * 0 < capacity <= rel_deadline <= period, ERR_NO_RESOURCES if the
+ * reservation doesn't fit.
+ */
+status_t thread_set_deadline(thread_t *t, lk_time_t capacity, lk_time_t rel_deadline, lk_time_t period)
+{
+    if (!t)
+        return ERR_INVALID_ARGS;
+
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    THREAD_LOCK(state);
+    status_t status = sched_set_deadline(t, capacity, rel_deadline, period);
+    THREAD_UNLOCK(state);
+
+    return status;
+}
+
 /**
  * @brief  Become an idle thread
  *
@@ -1113,6 +1297,7 @@ void thread_become_idle(void)
 
     /* mark ourself as idle */
     t->priority = IDLE_PRIORITY;
+    t->base_priority = IDLE_PRIORITY;
     t->flags |= THREAD_FLAG_IDLE;
     thread_set_pinned_cpu(t, arch_curr_cpu_num());
 
@@ -1333,10 +1518,28 @@ static enum handler_return wait_queue_timeout_handler(timer_t *timer, lk_time_t
     return ret;
 }
 
+/* insert into the wait queue, which is kept sorted by effective priority,
+ * highest first, FIFO among waiters of equal priority. walk from the tail
+ * since the common case is waiters of equal priority arriving in order.
+ */
+static void wait_queue_insert(wait_queue_t *wait, thread_t *t)
+{
+    thread_t *other;
+    for (other = list_peek_tail_type(&wait->list, thread_t, queue_node);
+         other;
+         other = list_prev_type(&wait->list, &other->queue_node, thread_t, queue_node)) {
+        if (other->priority >= t->priority) {
+            list_add_after(&other->queue_node, &t->queue_node);
+            return;
+        }
+    }
+    list_add_head(&wait->list, &t->queue_node);
+}
+
 /**
  * @brief  Block until a wait queue is notified.
  *
- * This function puts the current thread at the end of a wait
+ * This function puts the current thread in the wait
  * queue and then blocks until some other thread wakes the queue
  * up again.
  *
@@ -1373,7 +1576,7 @@ status_t wait_queue_block(wait_queue_t *wait, lk_time_t deadline)
         }
     }
 
-    list_add_tail(&wait->list, &current_thread->queue_node);
+    wait_queue_insert(wait, current_thread);
     wait->count++;
     current_thread->state = THREAD_BLOCKED;
     current_thread->blocking_wait_queue = wait;
@@ -1382,7 +1585,8 @@ status_t wait_queue_block(wait_queue_t *wait, lk_time_t deadline)
     /* if the deadline is nonzero or noninfinite, set a callback to yank us out of the queue */
     if (deadline != INFINITE_TIME) {
         timer_initialize(&timer);
-        timer_set_oneshot(&timer, deadline, wait_queue_timeout_handler, (void *)current_thread);
+        timer_set_oneshot_slack(&timer, deadline, current_thread->timer_slack,
+                                wait_queue_timeout_handler, (void *)current_thread);
     }
 
     sched_block();
@@ -1399,7 +1603,8 @@ status_t wait_queue_block(wait_queue_t *wait, lk_time_t deadline)
  * @brief  Wake up one thread sleeping on a wait queue
  *
  * This function removes one thread (if any) from the head of the wait queue and
- * makes it executable.  The new thread will be placed at the head of the
+ * makes it executable.  The queue is kept sorted, so this is the highest
+ * priority waiter.  The new thread will be placed at the head of the
  * run queue.
  *
  * @param wait  The wait queue to wake
@@ -1483,6 +1688,43 @@ int wait_queue_wake_all(wait_queue_t *wait, bool reschedule, status_t wait_queue
     return ret;
 }
 
+/**
+ * @brief  Peek at the highest priority waiter
+ *
+ * @return  The thread at the head of the wait queue (which is kept sorted
+ * by effective priority), or NULL if the queue is empty.  The thread is
+ * not removed from the queue.
+ */
+thread_t *wait_queue_peek(wait_queue_t *wait)
+{
+    DEBUG_ASSERT(wait->magic == WAIT_QUEUE_MAGIC);
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    return list_peek_head_type(&wait->list, thread_t, queue_node);
+}
+
+/**
+ * @brief  Re-sort a blocked thread within its wait queue
+ *
+ * Called after a thread's effective priority has been changed while it is
+ * blocked, so the queue stays sorted and wait_queue_wake_one() keeps
+ * releasing the highest priority waiter.
+ */
+void wait_queue_priority_changed(thread_t *t)
+{
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(t->state == THREAD_BLOCKED);
+
+    wait_queue_t *wait = t->blocking_wait_queue;
+    DEBUG_ASSERT(wait && wait->magic == WAIT_QUEUE_MAGIC);
+
+    list_delete(&t->queue_node);
+    wait_queue_insert(wait, t);
+}
+
 /**
  * @brief  Tear down a wait queue
  *
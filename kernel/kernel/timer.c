@@ -31,12 +31,29 @@
 #include <platform/timer.h>
 #include <trace.h>
 
+#if WITH_LIB_WATCHDOG
+#include <lib/watchdog.h>
+#endif
+
 #define LOCAL_TRACE 0
 
 spin_lock_t timer_lock;
 
+/* the pending timers for each cpu live in a hashed timer wheel: deadlines are
+ * bucketed by a fixed time slice and each bucket keeps its timers sorted, so
+ * insertion cost is O(pending / NUM_TIMER_BUCKETS) instead of O(pending).
+ * finding the earliest deadline (to arm the hardware timer) is a scan of the
+ * bucket heads, which is constant work independent of the number of timers.
+ */
+#define TIMER_BUCKET_SHIFT 20 /* ~1ms of deadline per bucket */
+#define NUM_TIMER_BUCKETS 128
+
 struct timer_state {
-    struct list_node timer_queue;
+    struct list_node bucket[NUM_TIMER_BUCKETS];
+    /* cached earliest pending deadline, INFINITE_TIME if the wheel is empty.
+     * may be stale-early if another cpu cancelled one of our timers; the
+     * tick handler simply finds nothing due and re-arms. */
+    lk_time_t earliest;
 } __CPU_ALIGN;
 
 static struct timer_state timers[SMP_MAX_CPUS];
@@ -51,6 +68,32 @@ void timer_initialize(timer_t *timer)
     *timer = (timer_t)TIMER_INITIAL_VALUE(*timer);
 }
 
+static uint timer_bucket(lk_time_t deadline)
+{
+    return (uint)((deadline >> TIMER_BUCKET_SHIFT) & (NUM_TIMER_BUCKETS - 1));
+}
+
+/* scan the bucket heads for the earliest pending timer, NULL if none */
+static timer_t *timer_peek_earliest(uint cpu)
+{
+    timer_t *earliest = NULL;
+
+    for (uint i = 0; i < NUM_TIMER_BUCKETS; i++) {
+        timer_t *entry = list_peek_head_type(&timers[cpu].bucket[i], timer_t, node);
+        if (entry && (!earliest || TIME_LT(entry->scheduled_time, earliest->scheduled_time)))
+            earliest = entry;
+    }
+
+    return earliest;
+}
+
+/* recompute the cached earliest deadline after a removal */
+static void timer_update_earliest(uint cpu)
+{
+    timer_t *entry = timer_peek_earliest(cpu);
+    timers[cpu].earliest = entry ? entry->scheduled_time : INFINITE_TIME;
+}
+
 static void insert_timer_in_queue(uint cpu, timer_t *timer)
 {
     timer_t *entry;
@@ -59,20 +102,64 @@ static void insert_timer_in_queue(uint cpu, timer_t *timer)
 
     LTRACEF("timer %p, cpu %u, scheduled %" PRIu64 ", periodic %" PRIu64 "\n", timer, cpu, timer->scheduled_time, timer->period);
 
-    list_for_every_entry(&timers[cpu].timer_queue, entry, timer_t, node) {
+    struct list_node *bucket = &timers[cpu].bucket[timer_bucket(timer->scheduled_time)];
+
+    if (timer->scheduled_time < timers[cpu].earliest)
+        timers[cpu].earliest = timer->scheduled_time;
+
+    list_for_every_entry(bucket, entry, timer_t, node) {
         if (TIME_GT(entry->scheduled_time, timer->scheduled_time)) {
             list_add_before(&entry->node, &timer->node);
             return;
         }
     }
 
-    /* walked off the end of the list */
-    list_add_tail(&timers[cpu].timer_queue, &timer->node);
+    /* walked off the end of the bucket */
+    list_add_tail(bucket, &timer->node);
 }
 
-static void timer_set(timer_t *timer, lk_time_t deadline, lk_time_t period, timer_callback callback, void *arg)
+/* look for a pending timer on this cpu already due inside [deadline, deadline + slack]
+ * and return its expiration so the new timer can share it; timers with slack only
+ * fire late, never early. returns deadline unchanged if nothing is in the window. */
+static lk_time_t timer_coalesce_deadline(uint cpu, lk_time_t deadline, lk_time_t slack)
 {
-    LTRACEF("timer %p, deadline %" PRIu64 ", period %" PRIu64 ", callback %p, arg %p\n", timer, deadline, period, callback, arg);
+    DEBUG_ASSERT(arch_ints_disabled());
+
+    lk_time_t limit = deadline + slack;
+    if (limit < deadline) /* overflow */
+        limit = INFINITE_TIME;
+
+    /* the window maps onto a bounded run of buckets; cap it so a huge slack
+     * doesn't walk the wheel more than once */
+    uint64_t nbuckets = ((limit >> TIMER_BUCKET_SHIFT) - (deadline >> TIMER_BUCKET_SHIFT)) + 1;
+    if (nbuckets > NUM_TIMER_BUCKETS)
+        nbuckets = NUM_TIMER_BUCKETS;
+
+    lk_time_t best = deadline;
+    bool found = false;
+    for (uint64_t i = 0; i < nbuckets; i++) {
+        uint b = (uint)(((deadline >> TIMER_BUCKET_SHIFT) + i) & (NUM_TIMER_BUCKETS - 1));
+        timer_t *entry;
+        list_for_every_entry(&timers[cpu].bucket[b], entry, timer_t, node) {
+            if (TIME_LT(entry->scheduled_time, deadline))
+                continue;
+            /* buckets are sorted, so the first entry at or past |deadline| is
+             * the only candidate in this bucket; later ones are no earlier */
+            if (TIME_LTE(entry->scheduled_time, limit) &&
+                (!found || TIME_LT(entry->scheduled_time, best))) {
+                best = entry->scheduled_time;
+                found = true;
+            }
+            break;
+        }
+    }
+
+    return best;
+}
+
+static void timer_set(timer_t *timer, lk_time_t deadline, lk_time_t slack, lk_time_t period, timer_callback callback, void *arg)
+{
+    LTRACEF("timer %p, deadline %" PRIu64 ", slack %" PRIu64 ", period %" PRIu64 ", callback %p, arg %p\n", timer, deadline, slack, period, callback, arg);
 
     DEBUG_ASSERT(timer->magic == TIMER_MAGIC);
 
@@ -94,6 +181,8 @@ static void timer_set(timer_t *timer, lk_time_t deadline, lk_time_t period, time
     }
 
     /* set up the structure */
+    if (slack != 0)
+        deadline = timer_coalesce_deadline(cpu, deadline, slack);
     timer->scheduled_time = deadline;
     timer->period = period;
     timer->callback = callback;
@@ -103,11 +192,15 @@ static void timer_set(timer_t *timer, lk_time_t deadline, lk_time_t period, time
 
     LTRACEF("scheduled time %" PRIu64 "\n", timer->scheduled_time);
 
+#if PLATFORM_HAS_DYNAMIC_TIMER
+    lk_time_t old_earliest = timers[cpu].earliest;
+#endif
+
     insert_timer_in_queue(cpu, timer);
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
-    if (list_peek_head_type(&timers[cpu].timer_queue, timer_t, node) == timer) {
-        /* we just modified the head of the timer queue */
+    if (timers[cpu].earliest < old_earliest) {
+        /* we just became the earliest deadline on this cpu */
         LTRACEF("setting new timer for %" PRIu64 " nsecs\n", deadline);
         platform_set_oneshot_timer(timer_tick, NULL, deadline);
     }
@@ -133,7 +226,25 @@ out:
  */
 void timer_set_oneshot(timer_t *timer, lk_time_t deadline, timer_callback callback, void *arg)
 {
-    timer_set(timer, deadline, 0, callback, arg);
+    timer_set(timer, deadline, 0, 0, callback, arg);
+}
+
+/**
+ * @brief  Set up a timer that executes once, with a coalescing window
+ *
+ * Like timer_set_oneshot(), but the timer may fire up to *slack* ns after
+ * *deadline* if another timer on this cpu is already due inside that window,
+ * so both are serviced by a single interrupt. The timer never fires early.
+ *
+ * @param  timer The timer to use
+ * @param  deadline The earliest time, in ns, at which the timer may execute
+ * @param  slack  How far past the deadline, in ns, the expiration may slide
+ * @param  callback  The function to call when the timer expires
+ * @param  arg  The argument to pass to the callback
+ */
+void timer_set_oneshot_slack(timer_t *timer, lk_time_t deadline, lk_time_t slack, timer_callback callback, void *arg)
+{
+    timer_set(timer, deadline, slack, 0, callback, arg);
 }
 
 /**
@@ -154,7 +265,7 @@ void timer_set_periodic(timer_t *timer, lk_time_t period, timer_callback callbac
 {
     if (period == 0)
         period = 1;
-    timer_set(timer, current_time() + period, period, callback, arg);
+    timer_set(timer, current_time() + period, 0, period, callback, arg);
 }
 
 /**
@@ -190,23 +301,21 @@ void timer_cancel(timer_t *timer)
 
     /* if the timer is in a queue, remove it and adjust hardware timers if needed */
     if (list_in_list(&timer->node)) {
-#if PLATFORM_HAS_DYNAMIC_TIMER
-        timer_t *oldhead = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
-#endif
-
-        /* remove it from the queue */
+        /* remove it from its bucket */
         list_delete(&timer->node);
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
-        /* see if we've just modified the head of this cpu's timer queue */
-        /* if we modified another cpu's queue, we'll just let it fire and sort itself out */
-        timer_t *newhead = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
-        if (newhead == NULL) {
-            LTRACEF("clearing old hw timer, nothing in the queue\n");
-            platform_stop_timer();
-        } else if (newhead != oldhead) {
-            LTRACEF("setting new timer to %" PRIu64 "\n", newhead->scheduled_time);
-            platform_set_oneshot_timer(timer_tick, NULL, newhead->scheduled_time);
+        /* if it may have been the earliest deadline on our wheel, recompute.
+         * if we modified another cpu's wheel, we'll just let it fire and sort itself out */
+        if (timer->scheduled_time == timers[cpu].earliest) {
+            timer_update_earliest(cpu);
+            if (timers[cpu].earliest == INFINITE_TIME) {
+                LTRACEF("clearing old hw timer, nothing in the queue\n");
+                platform_stop_timer();
+            } else if (timers[cpu].earliest > timer->scheduled_time) {
+                LTRACEF("setting new timer to %" PRIu64 "\n", timers[cpu].earliest);
+                platform_set_oneshot_timer(timer_tick, NULL, timers[cpu].earliest);
+            }
         }
 #endif
     }
@@ -234,6 +343,10 @@ static enum handler_return timer_tick(void *arg, lk_time_t now)
 
     THREAD_STATS_INC(timer_ints);
 
+#if WITH_LIB_WATCHDOG
+    watchdog_lockup_tick(now);
+#endif
+
     uint cpu = arch_curr_cpu_num();
 
     LTRACEF("cpu %u now %" PRIu64 ", sp %p\n", cpu, now, __GET_FRAME());
@@ -242,7 +355,7 @@ static enum handler_return timer_tick(void *arg, lk_time_t now)
 
     for (;;) {
         /* see if there's an event to process */
-        timer = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
+        timer = timer_peek_earliest(cpu);
         if (likely(timer == 0))
             break;
         LTRACEF("next item on timer queue %p at %" PRIu64 " now %" PRIu64 " (%p, arg %p)\n", timer, timer->scheduled_time, now, timer->callback, timer->arg);
@@ -300,7 +413,8 @@ static enum handler_return timer_tick(void *arg, lk_time_t now)
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
     /* reset the timer to the next event */
-    timer = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
+    timer = timer_peek_earliest(cpu);
+    timers[cpu].earliest = timer ? timer->scheduled_time : INFINITE_TIME;
     if (timer) {
         /* has to be the case or it would have fired already */
         DEBUG_ASSERT(TIME_GT(timer->scheduled_time, now));
@@ -308,6 +422,11 @@ static enum handler_return timer_tick(void *arg, lk_time_t now)
         LTRACEF("setting new timer for %" PRIu64 " nsecs for event %p\n", timer->scheduled_time,
                 timer);
         platform_set_oneshot_timer(timer_tick, NULL, timer->scheduled_time);
+    } else {
+        /* nothing is pending on this cpu; make sure the hardware timer is
+         * quiesced so an idle cpu can sit in a deep sleep state untouched */
+        LTRACEF("no pending timers, stopping hw timer\n");
+        platform_stop_timer();
     }
 
     /* we're done manipulating the timer queue */
@@ -349,21 +468,25 @@ void timer_transition_off_cpu(uint old_cpu)
     spin_lock_irqsave(&timer_lock, state);
     uint cpu = arch_curr_cpu_num();
 
-    timer_t *old_head = list_peek_head_type(&timers[old_cpu].timer_queue, timer_t, node);
+#if PLATFORM_HAS_DYNAMIC_TIMER
+    lk_time_t old_earliest = timers[cpu].earliest;
+#endif
 
     timer_t *entry = NULL, *tmp_entry = NULL;
     /* Move all timers from old_cpu to this cpu */
-    list_for_every_entry_safe(&timers[old_cpu].timer_queue, entry, tmp_entry, timer_t, node) {
-        list_delete(&entry->node);
-        insert_timer_in_queue(cpu, entry);
+    for (uint i = 0; i < NUM_TIMER_BUCKETS; i++) {
+        list_for_every_entry_safe(&timers[old_cpu].bucket[i], entry, tmp_entry, timer_t, node) {
+            list_delete(&entry->node);
+            insert_timer_in_queue(cpu, entry);
+        }
     }
+    timers[old_cpu].earliest = INFINITE_TIME;
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
-    timer_t *new_head = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
-    if (new_head != NULL && new_head != old_head) {
-        /* we just modified the head of the timer queue */
-        LTRACEF("setting new timer for %" PRIu64 " nsecs\n", new_head->scheduled_time);
-        platform_set_oneshot_timer(timer_tick, NULL, new_head->scheduled_time);
+    if (timers[cpu].earliest < old_earliest) {
+        /* an inherited timer is now our earliest deadline */
+        LTRACEF("setting new timer for %" PRIu64 " nsecs\n", timers[cpu].earliest);
+        platform_set_oneshot_timer(timer_tick, NULL, timers[cpu].earliest);
     }
 #endif
 
@@ -380,9 +503,10 @@ void timer_thaw_percpu(void)
 
     uint cpu = arch_curr_cpu_num();
 
-    timer_t *t = list_peek_head_type(&timers[cpu].timer_queue, timer_t, node);
+    timer_t *t = timer_peek_earliest(cpu);
     if (t) {
         LTRACEF("rescheduling timer for %" PRIu64 " nsecs\n", t->scheduled_time);
+        timers[cpu].earliest = t->scheduled_time;
         platform_set_oneshot_timer(timer_tick, NULL, t->scheduled_time);
     }
 
@@ -394,7 +518,10 @@ void timer_init(void)
 {
     timer_lock = SPIN_LOCK_INITIAL_VALUE;
     for (uint i = 0; i < SMP_MAX_CPUS; i++) {
-        list_initialize(&timers[i].timer_queue);
+        for (uint j = 0; j < NUM_TIMER_BUCKETS; j++) {
+            list_initialize(&timers[i].bucket[j]);
+        }
+        timers[i].earliest = INFINITE_TIME;
     }
 #if !PLATFORM_HAS_DYNAMIC_TIMER
     /* register for a periodic timer tick */
@@ -6,12 +6,15 @@
 // https://opensource.org/licenses/MIT
 
 #include "vm_priv.h"
+#include <arch/ops.h>
 #include <assert.h>
 #include <err.h>
 #include <inttypes.h>
 #include <kernel/auto_lock.h>
+#include <kernel/event.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
+#include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <kernel/vm.h>
 #include <lib/console.h>
@@ -35,6 +38,52 @@ static Mutex arena_lock;
 static mxtl::DoublyLinkedList<PmmArena*> arena_list TA_GUARDED(arena_lock);
 static size_t arena_cumulative_size TA_GUARDED(arena_lock);
 
+// cpu-to-numa-node topology, filled in by platform code; defaults to node 0.
+// node_count tracks the highest node id seen across cpus and arenas, plus
+// one, so the interleave policy knows how many nodes to rotate over.
+static uint8_t cpu_node_map[SMP_MAX_CPUS];
+static uint node_count = 1;
+
+// rotor for PMM_ALLOC_FLAG_NODE_INTERLEAVE; racy increments just mean two
+// allocations share a node once in a while, which interleaving tolerates
+static uint interleave_rotor;
+
+// Per-cpu magazine of pages so the single page alloc/free hot paths don't
+// take arena_lock. The magazines are refilled from and drained back to the
+// arena free lists in batches. Pages in a magazine stay in ALLOC state; only
+// the arenas track FREE pages. Magazines are stocked exclusively from KMAP
+// arenas so a cached page satisfies any combination of alloc flags.
+//
+// Disabled under PMM_ENABLE_FREE_FILL since the fill/check debug logic lives
+// in the arenas and must see every free and alloc.
+#if !PMM_ENABLE_FREE_FILL
+#define PMM_CPU_CACHE_ENABLE 1
+#endif
+
+#if PMM_CPU_CACHE_ENABLE
+static const size_t PMM_CPU_CACHE_MAX_PAGES = 64;
+static const size_t PMM_CPU_CACHE_BATCH = 32;
+
+namespace {
+struct pmm_cpu_cache {
+    SpinLock lock;
+    struct list_node pages;
+    size_t count;
+} __CPU_ALIGN;
+} // namespace
+
+static pmm_cpu_cache cpu_cache[SMP_MAX_CPUS];
+static bool cpu_cache_ready;
+
+static void pmm_cpu_cache_init(uint level) {
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        list_initialize(&cpu_cache[i].pages);
+    }
+    cpu_cache_ready = true;
+}
+LK_INIT_HOOK(pmm_cpu_cache, &pmm_cpu_cache_init, LK_INIT_LEVEL_VM);
+#endif // PMM_CPU_CACHE_ENABLE
+
 #if PMM_ENABLE_FREE_FILL
 static void pmm_enforce_fill(uint level) {
     for (auto& a : arena_list) {
@@ -102,30 +151,325 @@ done_add:
 
     arena_cumulative_size += info->size;
 
+    if (info->node + 1 > node_count)
+        node_count = info->node + 1;
+
     return NO_ERROR;
 }
 
-vm_page_t* pmm_alloc_page(uint alloc_flags, paddr_t* pa) {
+void pmm_set_cpu_node(uint cpu, uint node) {
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
+    DEBUG_ASSERT(node <= PMM_ALLOC_NODE_MASK);
+
+    cpu_node_map[cpu] = (uint8_t)node;
+    if (node + 1 > node_count)
+        node_count = node + 1;
+}
+
+uint pmm_node_of_cpu(uint cpu) {
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
+
+    return cpu_node_map[cpu];
+}
+
+uint pmm_node_count(void) {
+    return node_count;
+}
+
+// Pool of pre-zeroed pages kept stocked by a low priority scrubber thread so
+// that PMM_ALLOC_FLAG_ZERO allocations don't have to zero at fault time.
+// Pages in the pool are in ALLOC state with VM_PAGE_FLAG_ZEROED set; the flag
+// is cleared when the page is handed out.
+static const size_t PMM_SCRUB_TARGET_PAGES = 1024;
+static const size_t PMM_SCRUB_LOW_WATER = 256;
+static const size_t PMM_SCRUB_BATCH = 64;
+
+static SpinLock zeroed_lock;
+static struct list_node zeroed_list TA_GUARDED(zeroed_lock) = LIST_INITIAL_VALUE(zeroed_list);
+static size_t zeroed_count TA_GUARDED(zeroed_lock);
+static event_t scrub_event;
+
+// Pop a page off the pre-zeroed pool, waking the scrubber when the pool runs
+// low. Returns nullptr if the pool is empty.
+static vm_page_t* pmm_scrub_alloc_page(paddr_t* pa) {
+    vm_page_t* page;
+    {
+        AutoSpinLockIrqSave guard(zeroed_lock);
+        page = list_remove_head_type(&zeroed_list, vm_page_t, free.node);
+        if (page) {
+            DEBUG_ASSERT(zeroed_count > 0);
+            zeroed_count--;
+            if (zeroed_count < PMM_SCRUB_LOW_WATER)
+                event_signal(&scrub_event, false);
+        }
+    }
+
+    if (!page)
+        return nullptr;
+
+    // the caller is about to dirty the page
+    page->flags &= ~VM_PAGE_FLAG_ZEROED;
+    *pa = vm_page_to_paddr(page);
+    return page;
+}
+
+static int pmm_scrubber_thread(void*) {
+    for (;;) {
+        event_wait(&scrub_event);
+
+        for (;;) {
+            {
+                AutoSpinLockIrqSave guard(zeroed_lock);
+                if (zeroed_count >= PMM_SCRUB_TARGET_PAGES) {
+                    event_unsignal(&scrub_event);
+                    break;
+                }
+            }
+
+            // pull a batch of pages, zero them outside any lock and stock the pool
+            struct list_node pages = LIST_INITIAL_VALUE(pages);
+            size_t count = pmm_alloc_pages(PMM_SCRUB_BATCH, PMM_ALLOC_FLAG_KMAP, &pages);
+            if (count == 0) {
+                // out of memory; retry next time the pool is tapped
+                event_unsignal(&scrub_event);
+                break;
+            }
+
+            vm_page_t* p;
+            list_for_every_entry (&pages, p, vm_page_t, free.node) {
+                void* kvaddr = paddr_to_kvaddr(vm_page_to_paddr(p));
+                DEBUG_ASSERT(kvaddr);
+                arch_zero_page(kvaddr);
+                p->flags |= VM_PAGE_FLAG_ZEROED;
+            }
+
+            AutoSpinLockIrqSave guard(zeroed_lock);
+            while ((p = list_remove_head_type(&pages, vm_page_t, free.node)) != nullptr) {
+                list_add_head(&zeroed_list, &p->free.node);
+                zeroed_count++;
+            }
+        }
+    }
+    return 0;
+}
+
+static void pmm_scrub_init(uint level) {
+    event_init(&scrub_event, true, 0);
+    thread_t* t = thread_create("pmm-scrubber", &pmm_scrubber_thread, nullptr, LOW_PRIORITY,
+                                DEFAULT_STACK_SIZE);
+    thread_detach_and_resume(t);
+}
+LK_INIT_HOOK(pmm_scrub, &pmm_scrub_init, LK_INIT_LEVEL_THREADING);
+
+// Low-memory notification. When the arenas' free page count dips below
+// PMM_LOW_WATER_PAGES at allocation time the event is signaled; the vmo
+// reclaim thread (vm_object_paged.cpp) waits on it via pmm_wait_for_low_mem
+// and discards pages from discardable vmos until the count recovers.
+static event_t low_mem_event;
+static bool low_mem_ready;
+
+static void pmm_low_mem_init(uint level) {
+    event_init(&low_mem_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+    low_mem_ready = true;
+}
+LK_INIT_HOOK(pmm_low_mem, &pmm_low_mem_init, LK_INIT_LEVEL_VM);
+
+static void pmm_check_low_water_locked(void) TA_REQ(arena_lock) {
+    if (unlikely(!low_mem_ready))
+        return;
+
+    size_t free = 0;
+    for (const auto& a : arena_list)
+        free += a.free_count();
+    if (unlikely(free < PMM_LOW_WATER_PAGES))
+        event_signal(&low_mem_event, false);
+}
+
+void pmm_wait_for_low_mem(void) {
+    event_wait(&low_mem_event);
+}
+
+// Contiguous-allocation pressure notification. Signaled when
+// pmm_alloc_contiguous cannot find a run in any arena; the vmo
+// compaction thread (vm_object_paged.cpp) waits on it and migrates
+// movable pages out of nearly-free blocks to rebuild runs.
+static event_t contig_pressure_event;
+static bool contig_pressure_ready;
+
+static void pmm_contig_pressure_init(uint level) {
+    event_init(&contig_pressure_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+    contig_pressure_ready = true;
+}
+LK_INIT_HOOK(pmm_contig_pressure, &pmm_contig_pressure_init, LK_INIT_LEVEL_VM);
+
+void pmm_wait_for_contiguous_pressure(void) {
+    event_wait(&contig_pressure_event);
+}
+
+bool pmm_frame_is_compaction_candidate(paddr_t pa) {
     AutoLock al(&arena_lock);
 
-    /* walk the arenas in order until we find one with a free page */
     for (auto& a : arena_list) {
-        /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
-        if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
-            if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+        if (a.address_in_arena(pa))
+            return a.FrameInNearlyFreeBlock(pa);
+    }
+
+    return false;
+}
+
+// Resolve the node an allocation's numa policy targets, or -1 for no
+// preference. Interleaved allocations rotate through the nodes; the rotor
+// increment is racy, which at worst gives two concurrent allocations the
+// same node.
+static int pmm_target_node(uint alloc_flags) {
+    if (alloc_flags & PMM_ALLOC_FLAG_NODE_BIND)
+        return (int)PMM_ALLOC_NODE(alloc_flags);
+    if (alloc_flags & PMM_ALLOC_FLAG_NODE_LOCAL)
+        return (int)cpu_node_map[arch_curr_cpu_num()];
+    if (alloc_flags & PMM_ALLOC_FLAG_NODE_INTERLEAVE)
+        return (int)(interleave_rotor++ % node_count);
+    return -1;
+}
+
+static vm_page_t* pmm_alloc_page_locked(uint alloc_flags, paddr_t* pa) TA_REQ(arena_lock) {
+    int node = pmm_target_node(alloc_flags);
+
+    /* walk the arenas in order until we find one with a free page; the first
+     * pass honors any numa target, the second takes whatever is left unless
+     * the allocation is hard-bound to its node */
+    for (;;) {
+        for (auto& a : arena_list) {
+            /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
+            if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+            }
+
+            /* skip arenas outside the target node */
+            if (node >= 0 && a.node() != (uint)node)
                 continue;
+
+            // try to allocate the page out of the arena
+            vm_page_t* page = a.AllocPage(pa);
+            if (page)
+                return page;
         }
 
-        // try to allocate the page out of the arena
-        vm_page_t* page = a.AllocPage(pa);
-        if (page)
-            return page;
+        if (node < 0 || (alloc_flags & PMM_ALLOC_FLAG_NODE_BIND))
+            break;
+        node = -1;
     }
 
     LTRACEF("failed to allocate page\n");
     return nullptr;
 }
 
+#if PMM_CPU_CACHE_ENABLE
+static pmm_cpu_cache* pmm_cache_lock(spin_lock_saved_state_t* state) {
+    arch_interrupt_save(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    pmm_cpu_cache* cache = &cpu_cache[arch_curr_cpu_num()];
+    spin_lock(cache->lock.GetInternal());
+    return cache;
+}
+
+static void pmm_cache_unlock(pmm_cpu_cache* cache, spin_lock_saved_state_t state) {
+    spin_unlock(cache->lock.GetInternal());
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+}
+
+// Pop a page off the current cpu's magazine, refilling a batch from the KMAP
+// arenas when the magazine is empty.
+static vm_page_t* pmm_cache_alloc_page(paddr_t* pa) {
+    spin_lock_saved_state_t state;
+    pmm_cpu_cache* cache = pmm_cache_lock(&state);
+    vm_page_t* page = list_remove_head_type(&cache->pages, vm_page_t, free.node);
+    if (page) {
+        DEBUG_ASSERT(cache->count > 0);
+        cache->count--;
+    }
+    pmm_cache_unlock(cache, state);
+
+    if (unlikely(!page)) {
+        // refill a batch, carving the caller's page off the front
+        struct list_node batch = LIST_INITIAL_VALUE(batch);
+        {
+            AutoLock al(&arena_lock);
+            size_t allocated = 0;
+            for (auto& a : arena_list) {
+                if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                    continue;
+                allocated += a.AllocPages(PMM_CPU_CACHE_BATCH - allocated, &batch);
+                if (allocated == PMM_CPU_CACHE_BATCH)
+                    break;
+            }
+            pmm_check_low_water_locked();
+        }
+
+        page = list_remove_head_type(&batch, vm_page_t, free.node);
+        if (!page)
+            return nullptr;
+
+        // stash the remainder; we may have migrated cpus, so respect the cap
+        // and return any excess to the arenas
+        cache = pmm_cache_lock(&state);
+        while (cache->count < PMM_CPU_CACHE_MAX_PAGES) {
+            vm_page_t* p = list_remove_head_type(&batch, vm_page_t, free.node);
+            if (!p)
+                break;
+            list_add_head(&cache->pages, &p->free.node);
+            cache->count++;
+        }
+        pmm_cache_unlock(cache, state);
+
+        if (unlikely(!list_is_empty(&batch)))
+            pmm_free(&batch);
+    }
+
+    if (pa)
+        *pa = vm_page_to_paddr(page);
+    return page;
+}
+#endif // PMM_CPU_CACHE_ENABLE
+
+vm_page_t* pmm_alloc_page(uint alloc_flags, paddr_t* pa) {
+    paddr_t paddr;
+    vm_page_t* page = nullptr;
+
+    /* the per-cpu caches and the pre-zeroed pool hold pages with no node
+     * identity, so allocations with a numa policy go straight to the arenas */
+    const bool policied = (alloc_flags & PMM_ALLOC_NODE_POLICY_MASK) != 0;
+
+    if (unlikely(alloc_flags & PMM_ALLOC_FLAG_ZERO) && !policied)
+        page = pmm_scrub_alloc_page(&paddr);
+
+    if (likely(!page)) {
+#if PMM_CPU_CACHE_ENABLE
+        if (likely(cpu_cache_ready) && !policied)
+            page = pmm_cache_alloc_page(&paddr);
+        // on a miss the KMAP arenas are dry; fall through to the global walk,
+        // which can still satisfy requests that don't need the kernel mapping
+#endif
+        if (unlikely(!page)) {
+            AutoLock al(&arena_lock);
+            page = pmm_alloc_page_locked(alloc_flags, &paddr);
+            pmm_check_low_water_locked();
+            if (!page)
+                return nullptr;
+        }
+
+        // missed the pre-zeroed pool; zero synchronously like callers used to
+        if (unlikely(alloc_flags & PMM_ALLOC_FLAG_ZERO)) {
+            void* kvaddr = paddr_to_kvaddr(paddr);
+            DEBUG_ASSERT(kvaddr);
+            arch_zero_page(kvaddr);
+        }
+    }
+
+    if (pa)
+        *pa = paddr;
+    return page;
+}
+
 size_t pmm_alloc_pages(size_t count, uint alloc_flags, struct list_node* list) {
     LTRACEF("count %zu\n", count);
 
@@ -135,24 +479,84 @@ size_t pmm_alloc_pages(size_t count, uint alloc_flags, struct list_node* list) {
     if (count == 0)
         return 0;
 
-    AutoLock al(&arena_lock);
-
-    /* walk the arenas in order, allocating as many pages as we can from each */
     size_t allocated = 0;
-    for (auto& a : arena_list) {
-        DEBUG_ASSERT(count > allocated);
 
-        /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
-        if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
-            if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
-                continue;
+    /* drain the pre-zeroed pool first for zeroed requests; pool pages have no
+     * node identity, so requests with a numa policy skip it */
+    if (unlikely(alloc_flags & PMM_ALLOC_FLAG_ZERO) &&
+        !(alloc_flags & PMM_ALLOC_NODE_POLICY_MASK)) {
+        /* the zeroing pass below indexes from the list head, so the caller
+         * must not have pages of its own on the list already */
+        DEBUG_ASSERT(list_is_empty(list));
+
+        AutoSpinLockIrqSave guard(zeroed_lock);
+        while (allocated < count) {
+            vm_page_t* page = list_remove_head_type(&zeroed_list, vm_page_t, free.node);
+            if (!page)
+                break;
+
+            DEBUG_ASSERT(zeroed_count > 0);
+            zeroed_count--;
+            page->flags &= ~VM_PAGE_FLAG_ZEROED;
+            list_add_tail(list, &page->free.node);
+            allocated++;
         }
+        if (zeroed_count < PMM_SCRUB_LOW_WATER)
+            event_signal(&scrub_event, false);
+    }
 
-        // ask the arena to allocate some pages
-        allocated += a.AllocPages(count - allocated, list);
-        DEBUG_ASSERT(allocated <= count);
-        if (allocated == count)
-            break;
+    /* remember how much of the list is already zeroed */
+    size_t prezeroed = allocated;
+
+    if (allocated < count) {
+        AutoLock al(&arena_lock);
+
+        int node = pmm_target_node(alloc_flags);
+
+        /* walk the arenas in order, allocating as many pages as we can from
+         * each; the first pass honors any numa target, the second takes
+         * whatever is left unless the allocation is hard-bound to its node */
+        for (;;) {
+            for (auto& a : arena_list) {
+                DEBUG_ASSERT(count > allocated);
+
+                /* skip the arena if it's not KMAP and the KMAP only allocation flag was passed */
+                if (alloc_flags & PMM_ALLOC_FLAG_KMAP) {
+                    if ((a.flags() & PMM_ARENA_FLAG_KMAP) == 0)
+                        continue;
+                }
+
+                /* skip arenas outside the target node */
+                if (node >= 0 && a.node() != (uint)node)
+                    continue;
+
+                // ask the arena to allocate some pages
+                allocated += a.AllocPages(count - allocated, list);
+                DEBUG_ASSERT(allocated <= count);
+                if (allocated == count)
+                    break;
+            }
+
+            if (allocated == count || node < 0 || (alloc_flags & PMM_ALLOC_FLAG_NODE_BIND))
+                break;
+            node = -1;
+        }
+
+        pmm_check_low_water_locked();
+    }
+
+    /* zero whatever didn't come out of the pool */
+    if (unlikely((alloc_flags & PMM_ALLOC_FLAG_ZERO) && allocated > prezeroed)) {
+        size_t i = 0;
+        vm_page_t* p;
+        list_for_every_entry (list, p, vm_page_t, free.node) {
+            if (i++ < prezeroed)
+                continue;
+
+            void* kvaddr = paddr_to_kvaddr(vm_page_to_paddr(p));
+            DEBUG_ASSERT(kvaddr);
+            arch_zero_page(kvaddr);
+        }
     }
 
     return allocated;
@@ -216,6 +620,12 @@ size_t pmm_alloc_contiguous(size_t count, uint alloc_flags, uint8_t alignment_lo
     }
 
     LTRACEF("couldn't find run\n");
+
+    // no arena had a run; wake the compaction thread so it can try to
+    // rebuild one for the inevitable retry
+    if (likely(contig_pressure_ready))
+        event_signal(&contig_pressure_event, false);
+
     return 0;
 }
 
@@ -293,9 +703,37 @@ size_t pmm_free(struct list_node* list) {
 
     DEBUG_ASSERT(list);
 
+    uint count = 0;
+
+#if PMM_CPU_CACHE_ENABLE
+    if (likely(cpu_cache_ready)) {
+        // stash pages in the local magazine up to its cap; the overflow
+        // drains back to the arenas below
+        spin_lock_saved_state_t state;
+        pmm_cpu_cache* cache = pmm_cache_lock(&state);
+        while (cache->count < PMM_CPU_CACHE_MAX_PAGES) {
+            vm_page_t* page = list_remove_head_type(list, vm_page_t, free.node);
+            if (!page)
+                break;
+
+            DEBUG_ASSERT(!page_is_free(page));
+
+            page->state = VM_PAGE_STATE_ALLOC;
+            list_add_head(&cache->pages, &page->free.node);
+            cache->count++;
+            count++;
+        }
+        pmm_cache_unlock(cache, state);
+
+        if (list_is_empty(list)) {
+            LTRACEF("returning count %u\n", count);
+            return count;
+        }
+    }
+#endif
+
     AutoLock al(&arena_lock);
 
-    uint count = 0;
     while (!list_is_empty(list)) {
         vm_page_t* page = list_remove_head_type(list, vm_page_t, free.node);
 
@@ -324,8 +762,23 @@ size_t pmm_free_page(vm_page_t* page) {
     return pmm_free(&list);
 }
 
+#if PMM_CPU_CACHE_ENABLE
+// racy unlocked read; only used for diagnostics and statistics
+static size_t pmm_cache_count_pages() TA_NO_THREAD_SAFETY_ANALYSIS {
+    size_t count = 0u;
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        count += cpu_cache[i].count;
+    }
+    return count;
+}
+#else
+static size_t pmm_cache_count_pages() {
+    return 0u;
+}
+#endif
+
 void pmm_dump_free() TA_REQ(arena_lock) {
-    size_t free = 0u;
+    size_t free = pmm_cache_count_pages();
     for (const auto& a : arena_list) {
         free += a.free_count();
     }
@@ -334,7 +787,7 @@ void pmm_dump_free() TA_REQ(arena_lock) {
 }
 
 size_t pmm_count_free_pages() {
-    size_t free = 0u;
+    size_t free = pmm_cache_count_pages();
     AutoLock al(&arena_lock);
     for (const auto& a : arena_list) {
         free += a.free_count();
@@ -342,6 +795,44 @@ size_t pmm_count_free_pages() {
     return free;
 }
 
+size_t pmm_count_arenas() {
+    AutoLock al(&arena_lock);
+    return arena_list.size_slow();
+}
+
+status_t pmm_get_arena_stats(size_t index, pmm_arena_stats_t* stats) {
+    DEBUG_ASSERT(stats);
+
+    // Find the index'th arena. Arenas are only added during early boot and
+    // never removed, so the object can be inspected after dropping the lock.
+    PmmArena* arena = nullptr;
+    {
+        AutoLock al(&arena_lock);
+        for (auto& a : arena_list) {
+            if (index == 0) {
+                arena = &a;
+                break;
+            }
+            index--;
+        }
+    }
+    if (!arena)
+        return ERR_OUT_OF_RANGE;
+
+    size_t state_count[_VM_PAGE_STATE_COUNT] = {};
+    arena->CountStates(state_count);
+
+    stats->info = arena->info();
+    stats->total_pages = arena->size() / PAGE_SIZE;
+    stats->free_pages = state_count[VM_PAGE_STATE_FREE];
+    stats->wired_pages = state_count[VM_PAGE_STATE_WIRED] +
+                         state_count[VM_PAGE_STATE_HEAP] +
+                         state_count[VM_PAGE_STATE_MMU] +
+                         state_count[VM_PAGE_STATE_ALLOC];
+    stats->committed_pages = state_count[VM_PAGE_STATE_OBJECT];
+    return NO_ERROR;
+}
+
 size_t pmm_count_total_bytes() TA_REQ(arena_lock) {
     return arena_cumulative_size;
 }
@@ -499,6 +990,6 @@ static int cmd_pmm(int argc, const cmd_args* argv, uint32_t flags) {
 
 STATIC_COMMAND_START
 #if LK_DEBUGLEVEL > 0
-STATIC_COMMAND_MASKED("pmm", "physical memory manager", &cmd_pmm, CMD_AVAIL_ALWAYS)
+STATIC_COMMAND_MASKED("pmm", "physical memory manager", &cmd_pmm, CMD_AVAIL_ALWAYS | CMD_AVAIL_HEAVY)
 #endif
 STATIC_COMMAND_END(pmm);
@@ -59,6 +59,21 @@ void PmmArena::BootAllocArray() {
 
     page_array_ = (vm_page_t*)raw_page_array;
 
+    /* allocate the free frame bitmap and its summary level */
+    size_t bitmap_words = (page_count + 63) / 64;
+    size_t summary_words = (bitmap_words + 63) / 64;
+    free_bitmap_ = (uint64_t*)boot_alloc_mem(bitmap_words * sizeof(uint64_t));
+    free_summary_ = (uint64_t*)boot_alloc_mem(summary_words * sizeof(uint64_t));
+
+    /* every page starts out free; bits past the end of the arena in the
+     * last bitmap word stay clear so they read as allocated */
+    memset(free_bitmap_, 0xff, bitmap_words * sizeof(uint64_t));
+    if (page_count % 64)
+        free_bitmap_[bitmap_words - 1] = (1ULL << (page_count % 64)) - 1;
+    memset(free_summary_, 0xff, summary_words * sizeof(uint64_t));
+    if (bitmap_words % 64)
+        free_summary_[summary_words - 1] = (1ULL << (bitmap_words % 64)) - 1;
+
     /* add them to the free list */
     for (size_t i = 0; i < page_count; i++) {
         auto& p = page_array_[i];
@@ -69,6 +84,77 @@ void PmmArena::BootAllocArray() {
     free_count_ += page_count;
 }
 
+void PmmArena::MarkFree(size_t index) {
+    const size_t w = index / 64;
+    const uint64_t bit = 1ULL << (index % 64);
+
+    DEBUG_ASSERT(!(free_bitmap_[w] & bit));
+
+    free_bitmap_[w] |= bit;
+    free_summary_[w / 64] |= 1ULL << (w % 64);
+}
+
+void PmmArena::MarkAllocated(size_t index) {
+    const size_t w = index / 64;
+    const uint64_t bit = 1ULL << (index % 64);
+
+    DEBUG_ASSERT(free_bitmap_[w] & bit);
+
+    free_bitmap_[w] &= ~bit;
+    if (free_bitmap_[w] == 0)
+        free_summary_[w / 64] &= ~(1ULL << (w % 64));
+}
+
+size_t PmmArena::FirstAllocatedInRange(size_t start, size_t end) const {
+    size_t i = start;
+    while (i < end) {
+        const size_t w = i / 64;
+
+        /* allocated pages at or above bit i within this word */
+        uint64_t allocated = ~free_bitmap_[w] >> (i % 64);
+        if (allocated == 0) {
+            /* the rest of the word is free */
+            i += 64 - (i % 64);
+            continue;
+        }
+
+        size_t first = i + __builtin_ctzll(allocated);
+        return (first < end) ? first : end;
+    }
+    return end;
+}
+
+size_t PmmArena::FindNextFree(size_t index) const {
+    const size_t page_count = size() / PAGE_SIZE;
+    while (index < page_count) {
+        const size_t w = index / 64;
+
+        if (index % 64 == 0) {
+            /* at a word boundary, consult the summary to skip runs of
+             * fully allocated words */
+            const size_t sw = w / 64;
+            uint64_t summary = free_summary_[sw] & (~0ULL << (w % 64));
+            if (summary == 0) {
+                /* nothing free in the rest of this summary word's span
+                 * of 4096 pages */
+                index = (sw + 1) * 4096;
+                continue;
+            }
+            const size_t next_w = sw * 64 + __builtin_ctzll(summary);
+            if (next_w != w) {
+                index = next_w * 64;
+                continue;
+            }
+        }
+
+        uint64_t word = free_bitmap_[w] & (~0ULL << (index % 64));
+        if (word != 0)
+            return w * 64 + __builtin_ctzll(word);
+        index = (w + 1) * 64;
+    }
+    return SIZE_MAX;
+}
+
 vm_page_t* PmmArena::AllocPage(paddr_t* pa) {
     vm_page_t* page = list_remove_head_type(&free_list_, vm_page_t, free.node);
     if (!page)
@@ -81,6 +167,7 @@ vm_page_t* PmmArena::AllocPage(paddr_t* pa) {
     DEBUG_ASSERT(page_is_free(page));
 
     page->state = VM_PAGE_STATE_ALLOC;
+    MarkAllocated(page_index(page));
 #if PMM_ENABLE_FREE_FILL
     CheckFreeFill(page);
 #endif
@@ -113,6 +200,7 @@ vm_page_t* PmmArena::AllocSpecific(paddr_t pa) {
     list_delete(&page->free.node);
 
     page->state = VM_PAGE_STATE_ALLOC;
+    MarkAllocated(index);
 
     DEBUG_ASSERT(free_count_ > 0);
 
@@ -141,6 +229,7 @@ size_t PmmArena::AllocPages(size_t count, list_node* list) {
 #endif
 
         page->state = VM_PAGE_STATE_ALLOC;
+        MarkAllocated(page_index(page));
         list_add_tail(list, &page->free.node);
 
         allocated++;
@@ -150,7 +239,7 @@ size_t PmmArena::AllocPages(size_t count, list_node* list) {
 }
 
 size_t PmmArena::AllocContiguous(size_t count, uint8_t alignment_log2, paddr_t* pa, struct list_node* list) {
-    /* walk the list starting at alignment boundaries.
+    /* search the free frame bitmap starting at alignment boundaries.
      * calculate the starting offset into this arena, based on the
      * base address of the arena to handle the case where the arena
      * is not aligned on the same boundary requested.
@@ -159,61 +248,70 @@ size_t PmmArena::AllocContiguous(size_t count, uint8_t alignment_log2, paddr_t*
     if (rounded_base < base() || rounded_base > base() + size() - 1)
         return 0;
 
-    paddr_t aligned_offset = (rounded_base - base()) / PAGE_SIZE;
-    paddr_t start = aligned_offset;
-    LTRACEF("starting search at aligned offset %#" PRIxPTR "\n", start);
+    const size_t page_count = size() / PAGE_SIZE;
+    const size_t align_pages = 1UL << (alignment_log2 - PAGE_SIZE_SHIFT);
+    size_t aligned_offset = (rounded_base - base()) / PAGE_SIZE;
+    size_t start = aligned_offset;
+    LTRACEF("starting search at aligned offset %#zx\n", start);
     LTRACEF("arena base %#" PRIxPTR " size %zu\n", base(), size());
 
-retry:
-    /* search while we're still within the arena and have a chance of finding a slot
-       (start + count < end of arena) */
-    while ((start < size() / PAGE_SIZE) && ((start + count) <= size() / PAGE_SIZE)) {
-        vm_page_t* p = &page_array_[start];
-        for (uint i = 0; i < count; i++) {
-            if (!page_is_free(p)) {
-                /* this run is broken, break out of the inner loop.
-                 * start over at the next alignment boundary
-                 */
-                start = ROUNDUP(start - aligned_offset + i + 1, 1UL << (alignment_log2 - PAGE_SIZE_SHIFT)) +
-                        aligned_offset;
-                goto retry;
-            }
-            p++;
-        }
-
-        /* we found a run */
-        LTRACEF("found run from pn %" PRIuPTR " to %" PRIuPTR "\n", start, start + count);
+    while (start + count <= page_count && start >= aligned_offset) {
+        size_t brk = FirstAllocatedInRange(start, start + count);
+        if (brk == start + count) {
+            /* we found a run */
+            LTRACEF("found run from pn %zu to %zu\n", start, start + count);
 
-        /* remove the pages from the run out of the free list */
-        for (paddr_t i = start; i < start + count; i++) {
-            p = &page_array_[i];
-            DEBUG_ASSERT(page_is_free(p));
-            DEBUG_ASSERT(list_in_list(&p->free.node));
+            /* remove the pages from the run out of the free list */
+            for (size_t i = start; i < start + count; i++) {
+                vm_page_t* p = &page_array_[i];
+                DEBUG_ASSERT(page_is_free(p));
+                DEBUG_ASSERT(list_in_list(&p->free.node));
 
-            list_delete(&p->free.node);
-            p->state = VM_PAGE_STATE_ALLOC;
+                list_delete(&p->free.node);
+                p->state = VM_PAGE_STATE_ALLOC;
+                MarkAllocated(i);
 
-            DEBUG_ASSERT(free_count_ > 0);
+                DEBUG_ASSERT(free_count_ > 0);
 
-            free_count_--;
+                free_count_--;
 
 #if PMM_ENABLE_FREE_FILL
-            CheckFreeFill(p);
+                CheckFreeFill(p);
 #endif
 
-            if (list)
-                list_add_tail(list, &p->free.node);
-        }
+                if (list)
+                    list_add_tail(list, &p->free.node);
+            }
 
-        if (pa)
-            *pa = base() + start * PAGE_SIZE;
+            if (pa)
+                *pa = base() + start * PAGE_SIZE;
 
-        return count;
+            return count;
+        }
+
+        /* the run is broken at brk; use the index to skip the allocated
+         * span, then start over at the next alignment boundary */
+        size_t next = FindNextFree(brk + 1);
+        if (next == SIZE_MAX)
+            return 0;
+        start = ROUNDUP(next - aligned_offset, align_pages) + aligned_offset;
     }
 
     return 0;
 }
 
+bool PmmArena::FrameInNearlyFreeBlock(paddr_t pa) const {
+    DEBUG_ASSERT(address_in_arena(pa));
+
+    const size_t index = (pa - base()) / PAGE_SIZE;
+
+    /* allocated pages in the frame's 64-page block, including itself;
+     * bits past the end of a partial tail word read as allocated, which
+     * conservatively disqualifies the tail block */
+    int allocated = __builtin_popcountll(~free_bitmap_[index / 64]);
+    return allocated <= 4;
+}
+
 status_t PmmArena::FreePage(vm_page_t* page) {
     LTRACEF("page %p\n", page);
     if (!page_belongs_to_arena(page))
@@ -223,13 +321,23 @@ status_t PmmArena::FreePage(vm_page_t* page) {
     FreeFill(page);
 #endif
 
+    // per-owner flags don't follow the frame back into the free pool
+    page->flags &= ~(VM_PAGE_FLAG_UNMOVABLE | VM_PAGE_FLAG_SHARED);
+
     page->state = VM_PAGE_STATE_FREE;
+    MarkFree(page_index(page));
 
     list_add_head(&free_list_, &page->free.node);
     free_count_++;
     return NO_ERROR;
 }
 
+void PmmArena::CountStates(size_t state_count[]) const {
+    for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
+        state_count[page_array_[i].state]++;
+    }
+}
+
 void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) {
     printf("arena %p: name '%s' base %#" PRIxPTR " size 0x%zx priority %u flags 0x%x\n", this, name(), base(),
            size(), priority(), flags());
@@ -244,9 +352,7 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) {
 
     /* count the number of pages in every state */
     size_t state_count[_VM_PAGE_STATE_COUNT] = {};
-    for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-        state_count[page_array_[i].state]++;
-    }
+    CountStates(state_count);
 
     printf("\tpage states:\n");
     for (unsigned int i = 0; i < _VM_PAGE_STATE_COUNT; i++) {
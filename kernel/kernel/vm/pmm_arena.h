@@ -37,8 +37,14 @@ public:
     size_t size() const { return info_.size; }
     unsigned int flags() const { return info_.flags; }
     unsigned int priority() const { return info_.priority; }
+    unsigned int node() const { return info_.node; }
     size_t free_count() const { return free_count_; };
 
+    // Tally the arena's pages by state into |state_count|, which must have
+    // _VM_PAGE_STATE_COUNT entries. Runs unlocked: each state read is a
+    // single racy word, so the result is a statistical snapshot.
+    void CountStates(size_t state_count[/*_VM_PAGE_STATE_COUNT*/]) const;
+
     vm_page_t* get_page(size_t index) { return &page_array_[index]; }
 
     // main allocation routines
@@ -68,15 +74,47 @@ public:
         return (address >= info_.base && address <= info_.base + info_.size - 1);
     }
 
+    // true if the 64-page bitmap block holding the frame is free but for
+    // a handful of pages, making the frame worth migrating elsewhere
+    bool FrameInNearlyFreeBlock(paddr_t pa) const;
+
 private:
 #if PMM_ENABLE_FREE_FILL
     void FreeFill(vm_page_t* page);
     void CheckFreeFill(vm_page_t* page);
 #endif
 
+    // index of a page within the arena's page array
+    size_t page_index(const vm_page* page) const {
+        uintptr_t page_addr = reinterpret_cast<uintptr_t>(page);
+        uintptr_t page_array_base = reinterpret_cast<uintptr_t>(page_array_);
+
+        return (page_addr - page_array_base) / VM_PAGE_STRUCT_SIZE;
+    }
+
+    // maintenance of the two-level free frame bitmap
+    void MarkFree(size_t index);
+    void MarkAllocated(size_t index);
+
+    // return the index of the first allocated page in [start, end), or
+    // |end| if the whole range is free
+    size_t FirstAllocatedInRange(size_t start, size_t end) const;
+
+    // return the index of the first free page at or after |index|, or
+    // SIZE_MAX if there is none
+    size_t FindNextFree(size_t index) const;
+
     const pmm_arena_info_t info_;
     vm_page_t* page_array_ = nullptr;
 
+    // two-level index over free frames, kept in sync with the per-page
+    // state: free_bitmap_ holds one bit per page (1 = free) and
+    // free_summary_ one bit per 64-page bitmap word (1 = the word has at
+    // least one free page), so searches skip allocated spans a word --
+    // or 4096 pages -- at a time instead of touching every vm_page_t.
+    uint64_t* free_bitmap_ = nullptr;
+    uint64_t* free_summary_ = nullptr;
+
     size_t free_count_ = 0;
     list_node free_list_ = LIST_INITIAL_VALUE(free_list_);
 
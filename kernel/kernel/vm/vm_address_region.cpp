@@ -517,7 +517,14 @@ void VmAddressRegion::Activate() {
     DEBUG_ASSERT(is_mutex_held(aspace_->lock()));
 
     state_ = LifeCycleState::ALIVE;
-    parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    // Address space construction (e.g. process startup driven by launchpad)
+    // usually creates regions in ascending order; append directly in that
+    // case instead of descending from the root for every insert.
+    if (parent_->subregions_.is_empty() || parent_->subregions_.back().base() < base_) {
+        parent_->subregions_.insert_back(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    } else {
+        parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    }
 }
 
 status_t VmAddressRegion::Unmap(vaddr_t base, size_t size) {
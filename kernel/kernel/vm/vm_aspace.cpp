@@ -22,7 +22,9 @@
 #include <lib/crypto/prng.h>
 #include <mxtl/auto_call.h>
 #include <mxtl/intrusive_double_list.h>
+#include <mxtl/intrusive_single_list.h>
 #include <mxtl/type_support.h>
+#include <mxtl/unique_ptr.h>
 #include <new.h>
 #include <safeint/safe_math.h>
 #include <stdlib.h>
@@ -234,6 +236,9 @@ status_t VmAspace::Destroy() {
     }
     aspace_destroyed_ = true;
 
+    // drop the fault cache so it does not pin a dead mapping
+    last_fault_mapping_.reset();
+
     // Break the reference cycle between this aspace and the root VMAR
     root_vmar_.reset(dummy_root_vmar);
 
@@ -512,7 +517,30 @@ status_t VmAspace::PageFault(vaddr_t va, uint flags) {
     // the region out from underneath it
     AutoLock a(&lock_);
 
-    return root_vmar_->PageFault(va, flags);
+    // Faults tend to arrive in bursts against a single mapping, so check the
+    // mapping that satisfied the last fault before walking the VMAR tree.
+    // The cached pointer can only go stale in ways the state and range
+    // checks below detect, since any layout change happens under lock_.
+    if (likely(last_fault_mapping_ != nullptr)) {
+        VmMapping* map = last_fault_mapping_.get();
+        if (map->IsAliveLocked() && va >= map->base() &&
+            va <= map->base() + map->size() - 1) {
+            return map->PageFault(va, flags);
+        }
+        last_fault_mapping_.reset();
+    }
+
+    // walk down the tree to find the mapping, remembering it for the next fault
+    for (auto vmar = root_vmar_;
+         auto next = vmar->FindRegionLocked(va);
+         vmar = next->as_vm_address_region()) {
+        if (next->is_mapping()) {
+            last_fault_mapping_ = next->as_vm_mapping();
+            return last_fault_mapping_->PageFault(va, flags);
+        }
+    }
+
+    return ERR_NOT_FOUND;
 }
 
 void VmAspace::Dump(bool verbose) const {
@@ -541,6 +569,139 @@ bool VmAspace::EnumerateChildren(VmEnumerator* ve) {
     return root_vmar_->EnumerateChildrenLocked(ve, 1);
 }
 
+namespace {
+
+// Bounds the sub-vmar nesting depth CloneFrom will replicate; real processes
+// only use a few levels.
+constexpr uint kCloneMaxVmarDepth = 32;
+
+// One source-vmo-to-clone pairing, so that multiple mappings of the same VMO
+// in the source stay aliased to a single clone in the copy.
+struct ClonedVmoNode : public mxtl::SinglyLinkedListable<mxtl::unique_ptr<ClonedVmoNode>> {
+    // Raw pointer; the enumerated mappings keep the source VMOs alive for
+    // the duration of the walk.
+    VmObject* source = nullptr;
+    mxtl::RefPtr<VmObject> clone;
+};
+
+// Replicates the region tree enumerated under a source aspace into the
+// destination rooted at |dst_root|. The walk holds the source aspace lock
+// throughout, so it sees a consistent snapshot; creation on the destination
+// side takes only the destination aspace's (unrelated) lock.
+class AspaceCloner final : public VmEnumerator {
+public:
+    explicit AspaceCloner(mxtl::RefPtr<VmAddressRegion> dst_root) {
+        dst_vmars_[0] = mxtl::move(dst_root);
+    }
+
+    bool OnVmAddressRegion(const VmAddressRegion* vmar, uint depth) override {
+        if (depth == 0) {
+            // The source root; the destination root must cover the same range.
+            if (vmar->base() != dst_vmars_[0]->base() || vmar->size() != dst_vmars_[0]->size()) {
+                status_ = ERR_INVALID_ARGS;
+                return false;
+            }
+            return true;
+        }
+        if (depth >= kCloneMaxVmarDepth) {
+            status_ = ERR_OUT_OF_RANGE;
+            return false;
+        }
+        VmAddressRegion* parent = dst_vmars_[depth - 1].get();
+        // Recreate the region at its original offset. CAN_MAP_SPECIFIC is
+        // added so this region's own children can be placed at their original
+        // addresses too, even if the source region did not carry it.
+        uint32_t vmar_flags = (vmar->flags() & (VMAR_FLAG_COMPACT | VMAR_CAN_RWX_FLAGS)) |
+                              VMAR_FLAG_SPECIFIC | VMAR_FLAG_CAN_MAP_SPECIFIC;
+        status_ = parent->CreateSubVmar(vmar->base() - parent->base(), vmar->size(), 0,
+                                        vmar_flags, vmar->name(), &dst_vmars_[depth]);
+        return status_ == NO_ERROR;
+    }
+
+    bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar, uint depth) override {
+        DEBUG_ASSERT(depth >= 1 && depth <= kCloneMaxVmarDepth);
+        VmAddressRegion* parent = dst_vmars_[depth - 1].get();
+
+        mxtl::RefPtr<VmObject> vmo;
+        status_ = CloneVmo(map->vmo(), &vmo);
+        if (status_ != NO_ERROR)
+            return false;
+
+        uint32_t vmar_flags = (map->flags() & VMAR_CAN_RWX_FLAGS) | VMAR_FLAG_SPECIFIC;
+        mxtl::RefPtr<VmMapping> dst_map;
+        status_ = parent->CreateVmMapping(map->base() - parent->base(), map->size(), 0,
+                                          vmar_flags, mxtl::move(vmo), map->object_offset(),
+                                          map->arch_mmu_flags(), map->name(), &dst_map);
+        return status_ == NO_ERROR;
+    }
+
+    status_t status() const { return status_; }
+
+private:
+    status_t CloneVmo(mxtl::RefPtr<VmObject> source, mxtl::RefPtr<VmObject>* out) {
+        for (auto& node : clones_) {
+            if (node.source == source.get()) {
+                *out = node.clone;
+                return NO_ERROR;
+            }
+        }
+
+        mxtl::RefPtr<VmObject> clone;
+        status_t status = source->CloneCOW(0, source->size(), &clone);
+        if (status == ERR_NOT_SUPPORTED) {
+            // Physical VMOs cannot be cloned; share them with the source.
+            clone = source;
+        } else if (status != NO_ERROR) {
+            return status;
+        }
+
+        AllocChecker ac;
+        mxtl::unique_ptr<ClonedVmoNode> node(new (&ac) ClonedVmoNode);
+        if (!ac.check())
+            return ERR_NO_MEMORY;
+        node->source = source.get();
+        node->clone = clone;
+        clones_.push_front(mxtl::move(node));
+
+        *out = mxtl::move(clone);
+        return NO_ERROR;
+    }
+
+    // dst_vmars_[n] is the replica of the most recently visited source vmar
+    // at depth n; the pre-order traversal guarantees it is the parent of
+    // every node subsequently visited at depth n + 1.
+    mxtl::RefPtr<VmAddressRegion> dst_vmars_[kCloneMaxVmarDepth];
+
+    mxtl::SinglyLinkedList<mxtl::unique_ptr<ClonedVmoNode>> clones_;
+
+    status_t status_ = NO_ERROR;
+};
+
+} // namespace
+
+status_t VmAspace::CloneFrom(VmAspace* source) {
+    canary_.Assert();
+    DEBUG_ASSERT(source);
+    DEBUG_ASSERT(is_user() && source->is_user());
+
+    LTRACEF("%p '%s' from %p '%s'\n", this, name_, source, source->name_);
+
+    if (source == this)
+        return ERR_INVALID_ARGS;
+
+    // EnumerateChildren treats a destroyed aspace as an empty (successful)
+    // walk; catch that case up front so the caller gets an error rather
+    // than an empty copy.
+    if (source->is_destroyed())
+        return ERR_BAD_STATE;
+
+    AspaceCloner cloner(RootVmar());
+    if (!source->EnumerateChildren(&cloner))
+        return (cloner.status() != NO_ERROR) ? cloner.status() : ERR_BAD_STATE;
+
+    return NO_ERROR;
+}
+
 void DumpAllAspaces(bool verbose) {
     AutoLock a(&aspace_list_lock);
 
@@ -556,6 +717,53 @@ size_t VmAspace::AllocatedPages() const {
     return root_vmar_->AllocatedPagesLocked();
 }
 
+void VmAspace::AdjustCommitCharge(int64_t delta_pages) {
+    canary_.Assert();
+
+    const int64_t prev = commit_charge_pages_.fetch_add(delta_pages, mxtl::memory_order_relaxed);
+
+    // fast path: no watermark armed, or we didn't cross it
+    const size_t wm = watermark_pages_.load(mxtl::memory_order_relaxed);
+    if (likely(wm == 0))
+        return;
+    const bool was_above = prev >= static_cast<int64_t>(wm);
+    const bool now_above = prev + delta_pages >= static_cast<int64_t>(wm);
+    if (likely(was_above == now_above))
+        return;
+
+    AutoLock a(&watermark_lock_);
+    if (watermark_fn_ == nullptr)
+        return;
+
+    // recompute from the live counter; concurrent adjusters may have raced
+    // us here, and whoever takes the lock last delivers the final say
+    const int64_t current = commit_charge_pages_.load(mxtl::memory_order_relaxed);
+    const bool above = current >= static_cast<int64_t>(watermark_pages_.load(mxtl::memory_order_relaxed));
+    if (above != watermark_above_) {
+        watermark_above_ = above;
+        watermark_fn_(watermark_cookie_, above);
+    }
+}
+
+void VmAspace::SetCommitWatermark(size_t pages, CommitWatermarkFn fn, void* cookie) {
+    canary_.Assert();
+    DEBUG_ASSERT((pages == 0) == (fn == nullptr));
+
+    AutoLock a(&watermark_lock_);
+    watermark_pages_.store(pages, mxtl::memory_order_relaxed);
+    watermark_fn_ = fn;
+    watermark_cookie_ = cookie;
+    watermark_above_ = false;
+
+    // if the charge already sits at or above a newly armed watermark, tell
+    // the subscriber now rather than waiting for the next crossing
+    if (fn != nullptr &&
+        commit_charge_pages_.load(mxtl::memory_order_relaxed) >= static_cast<int64_t>(pages)) {
+        watermark_above_ = true;
+        fn(cookie, true);
+    }
+}
+
 void VmAspace::InitializeAslr() {
     aslr_enabled_ = is_user() && !cmdline_get_bool("aslr.disable", false);
 
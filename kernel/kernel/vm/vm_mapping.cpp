@@ -140,6 +140,8 @@ status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mmu_f
         LTRACEF("arch_mmu_protect returns %d\n", status);
         arch_mmu_flags_ = new_arch_mmu_flags;
 
+        // the new right-half mapping recharges its range when it activates
+        DischargeVmoRangeLocked(object_offset_ + size, size_ - size);
         size_ = size;
         mapping->ActivateLocked();
         return NO_ERROR;
@@ -162,6 +164,8 @@ status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mmu_f
                                            new_arch_mmu_flags);
         LTRACEF("arch_mmu_protect returns %d\n", status);
 
+        // the new right-half mapping recharges its range when it activates
+        DischargeVmoRangeLocked(object_offset_ + (base - base_), size);
         size_ -= size;
         mapping->ActivateLocked();
         return NO_ERROR;
@@ -191,7 +195,9 @@ status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mmu_f
                                        new_arch_mmu_flags);
     LTRACEF("arch_mmu_protect returns %d\n", status);
 
-    // Turn us into the left half
+    // Turn us into the left half; the center and right mappings recharge
+    // their ranges when they activate
+    DischargeVmoRangeLocked(center_vmo_offset, size_ - left_size);
     size_ = left_size;
 
     center_mapping->ActivateLocked();
@@ -259,6 +265,9 @@ status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
             return status;
         }
 
+        // drop the commit charge for the vmo range we no longer map
+        DischargeVmoRangeLocked(object_offset_ + (base - base_), size);
+
         if (base_ == base && size_ != size) {
             // We need to remove ourselves from tree before updating base_,
             // since base_ is the tree key.
@@ -294,7 +303,10 @@ status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
         return status;
     }
 
-    // Turn us into the left half
+    // Turn us into the left half.  Drop the charge for everything to the
+    // right of the split point; the new mapping recharges its own range when
+    // it activates.
+    DischargeVmoRangeLocked(object_offset_ + (base - base_), size_ - (base - base_));
     size_ = base - base_;
     mapping->ActivateLocked();
     return NO_ERROR;
@@ -367,6 +379,36 @@ status_t VmMapping::UnmapVmoRangeLocked(uint64_t offset, uint64_t len) const {
     return NO_ERROR;
 }
 
+// Called by the VmObject with its lock held whenever a page is committed to
+// or released from the range we map; see VmObject::CommitChargeUpdateLocked().
+// Disable analysis for the same capability-aliasing reason as ActivateLocked().
+void VmMapping::CommitChargeUpdateLocked(uint64_t offset, int64_t delta) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    DEBUG_ASSERT(object_);
+    DEBUG_ASSERT(object_->lock()->IsHeld());
+
+    // only pages inside the window we map are charged to us
+    if (offset < object_offset_ || offset - object_offset_ >= size_)
+        return;
+
+    DEBUG_ASSERT(delta > 0 || charged_pages_ > 0);
+    charged_pages_ += delta;
+    aspace_->AdjustCommitCharge(delta);
+}
+
+void VmMapping::DischargeVmoRangeLocked(uint64_t offset, uint64_t len) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    DEBUG_ASSERT(object_);
+    DEBUG_ASSERT(object_->lock()->IsHeld());
+
+    size_t pages = object_->AllocatedPagesInRangeLocked(offset, len);
+    if (pages > 0) {
+        DEBUG_ASSERT(charged_pages_ >= pages);
+        charged_pages_ -= pages;
+        aspace_->AdjustCommitCharge(-static_cast<int64_t>(pages));
+    }
+}
+
 status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
     canary_.Assert();
 
@@ -395,8 +437,31 @@ status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
     currently_faulting_ = true;
     auto ac = mxtl::MakeAutoCall([&]() { currently_faulting_ = false; });
 
-    // iterate through the range, grabbing a page from the underlying object and
-    // mapping it in
+    // iterate through the range, grabbing pages from the underlying object and
+    // mapping each physically contiguous run with a single mmu operation
+    vaddr_t run_va = 0;
+    paddr_t run_pa = 0;
+    size_t run_pages = 0;
+
+    auto map_run = [&]() {
+        if (run_pages == 0)
+            return;
+
+        LTRACEF_LEVEL(2, "mapping pa %#" PRIxPTR " to va %#" PRIxPTR ", %zu pages\n", run_pa,
+                      run_va, run_pages);
+
+        size_t mapped;
+        auto ret = arch_mmu_map(&aspace_->arch_aspace(), run_va, run_pa, run_pages,
+                                arch_mmu_flags_, &mapped);
+        if (ret < 0) {
+            TRACEF("error %d mapping %zu pages at va %#" PRIxPTR " pa %#" PRIxPTR "\n", ret,
+                   run_pages, run_va, run_pa);
+        }
+
+        DEBUG_ASSERT(mapped == run_pages);
+        run_pages = 0;
+    };
+
     size_t o;
     for (o = offset; o < offset + len; o += PAGE_SIZE) {
         uint64_t vmo_offset = object_offset_ + o;
@@ -411,22 +476,28 @@ status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
                 return status;
             } else {
                 // skip ahead
+                map_run();
                 continue;
             }
         }
 
         vaddr_t va = base_ + o;
-        LTRACEF_LEVEL(2, "mapping pa %#" PRIxPTR " to va %#" PRIxPTR "\n", pa, va);
 
-        size_t mapped;
-        auto ret = arch_mmu_map(&aspace_->arch_aspace(), va, pa, 1, arch_mmu_flags_, &mapped);
-        if (ret < 0) {
-            TRACEF("error %d mapping page at va %#" PRIxPTR " pa %#" PRIxPTR "\n", ret, va, pa);
+        // extend the current run if this page continues it, otherwise flush
+        // the run and start a new one
+        if (run_pages > 0 && pa == run_pa + run_pages * PAGE_SIZE &&
+            va == run_va + run_pages * PAGE_SIZE) {
+            run_pages++;
+        } else {
+            map_run();
+            run_va = va;
+            run_pa = pa;
+            run_pages = 1;
         }
-
-        DEBUG_ASSERT(mapped == 1);
     }
 
+    map_run();
+
     return NO_ERROR;
 }
 
@@ -470,6 +541,11 @@ status_t VmMapping::DestroyLocked() {
     // grab the object lock and remove ourself from its list
     {
         AutoLock al(object_->lock());
+        // Unmap discharged our whole range; drop anything left as a safety net
+        if (charged_pages_ > 0) {
+            aspace_->AdjustCommitCharge(-static_cast<int64_t>(charged_pages_));
+            charged_pages_ = 0;
+        }
         object_->RemoveMappingLocked(this);
     }
 
@@ -640,7 +716,19 @@ void VmMapping::ActivateLocked() TA_NO_THREAD_SAFETY_ANALYSIS {
 
     state_ = LifeCycleState::ALIVE;
     object_->AddMappingLocked(this);
-    parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+
+    // charge the pages already committed to the range we now map
+    charged_pages_ = object_->AllocatedPagesInRangeLocked(object_offset_, size_);
+    if (charged_pages_ > 0)
+        aspace_->AdjustCommitCharge(static_cast<int64_t>(charged_pages_));
+
+    // As in VmAddressRegion::Activate(), mappings tend to be created in
+    // ascending order at process startup; append directly when possible.
+    if (parent_->subregions_.is_empty() || parent_->subregions_.back().base() < base_) {
+        parent_->subregions_.insert_back(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    } else {
+        parent_->subregions_.insert(mxtl::RefPtr<VmAddressRegionOrMapping>(this));
+    }
 }
 
 void VmMapping::Activate() {
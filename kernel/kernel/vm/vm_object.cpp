@@ -96,6 +96,18 @@ void VmObject::RangeChangeUpdateLocked(uint64_t offset, uint64_t len) {
     }
 }
 
+void VmObject::CommitChargeUpdateLocked(uint64_t offset, int64_t delta) {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.IsHeld());
+
+    // COW children seeing this page through their window are not charged;
+    // they only get charged for pages they have forked themselves, matching
+    // the committed/shared split in VmAspace::GetMemoryUsage().
+    for (auto& m : mapping_list_) {
+        m.CommitChargeUpdateLocked(offset, delta);
+    }
+}
+
 static int cmd_vm_object(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
     notenoughargs:
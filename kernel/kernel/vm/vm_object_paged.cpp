@@ -13,10 +13,12 @@
 #include <err.h>
 #include <inttypes.h>
 #include <kernel/auto_lock.h>
+#include <kernel/thread.h>
 #include <kernel/vm.h>
 #include <kernel/vm/vm_address_region.h>
 #include <lib/console.h>
 #include <lib/user_copy.h>
+#include <lk/init.h>
 #include <new.h>
 #include <safeint/safe_math.h>
 #include <stdlib.h>
@@ -41,9 +43,25 @@ void ZeroPage(vm_page_t* p) {
 
 } // namespace
 
+// Global list of discardable vmos, in least-recently-marked-discardable
+// order. The reclaim thread walks it when the pmm signals low memory and
+// decommits pages until the free count recovers.
+// Lock ordering: reclaim_list_lock is always acquired before any vmo lock_.
+static mutex_t reclaim_list_lock = MUTEX_INITIAL_VALUE(reclaim_list_lock);
+static mxtl::DoublyLinkedList<VmObjectPaged*, VmObjectPaged::ReclaimListTraits> reclaim_list;
+
+// Global list of every paged vmo, walked by the compaction thread when
+// the pmm signals contiguous-allocation pressure.
+// Lock ordering: compact_list_lock is always acquired before any vmo lock_.
+static mutex_t compact_list_lock = MUTEX_INITIAL_VALUE(compact_list_lock);
+static mxtl::DoublyLinkedList<VmObjectPaged*, VmObjectPaged::CompactListTraits> compact_list;
+
 VmObjectPaged::VmObjectPaged(uint32_t pmm_alloc_flags, mxtl::RefPtr<VmObject> parent)
     : VmObject(mxtl::move(parent)), pmm_alloc_flags_(pmm_alloc_flags) {
     LTRACEF("%p\n", this);
+
+    AutoLock a(&compact_list_lock);
+    compact_list.push_back(this);
 }
 
 VmObjectPaged::~VmObjectPaged() {
@@ -51,6 +69,19 @@ VmObjectPaged::~VmObjectPaged() {
 
     LTRACEF("%p\n", this);
 
+    // pull ourselves off the global lists before any teardown; the
+    // reclaim and compaction threads only touch vmos while they hold the
+    // respective list lock
+    {
+        AutoLock a(&reclaim_list_lock);
+        if (discardable_)
+            reclaim_list.erase(*this);
+    }
+    {
+        AutoLock a(&compact_list_lock);
+        compact_list.erase(*this);
+    }
+
     // free all of the pages attached to us
     page_list_.FreeAllPages();
 }
@@ -131,8 +162,13 @@ void VmObjectPaged::Dump(uint depth, bool verbose) {
 }
 
 size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const {
-    canary_.Assert();
     AutoLock a(&lock_);
+    return AllocatedPagesInRangeLocked(offset, len);
+}
+
+size_t VmObjectPaged::AllocatedPagesInRangeLocked(uint64_t offset, uint64_t len) const {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.IsHeld());
     uint64_t new_len;
     if (!TrimRange(offset, len, size_, &new_len)) {
         return 0;
@@ -147,6 +183,42 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     return count;
 }
 
+size_t VmObjectPaged::SharedPagesInRange(uint64_t offset, uint64_t len) const {
+    canary_.Assert();
+    AutoLock a(&lock_);
+
+    // only clones share pages with their ancestors
+    if (!parent_)
+        return 0;
+
+    uint64_t new_len;
+    if (!TrimRange(offset, len, size_, &new_len)) {
+        return 0;
+    }
+
+    // count offsets where we haven't forked a copy yet but an ancestor has a
+    // page visible through our window
+    uint64_t end = ROUNDUP_PAGE_SIZE(offset + new_len);
+    size_t count = 0;
+    for (uint64_t o = ROUNDDOWN(offset, PAGE_SIZE); o < end; o += PAGE_SIZE) {
+        if (page_list_.GetPage(o))
+            continue;
+
+        safeint::CheckedNumeric<uint64_t> parent_offset = parent_offset_;
+        parent_offset += o;
+        DEBUG_ASSERT(parent_offset.IsValid());
+
+        // clones share their ancestor's lock, so the parent's Locked variant
+        // is legal here; pf_flags 0 means no new pages get faulted in
+        vm_page_t* p;
+        if (parent_->GetPageLocked(parent_offset.ValueOrDie(), 0, &p, nullptr) == NO_ERROR) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 status_t VmObjectPaged::AddPage(vm_page_t* p, uint64_t offset) {
     AutoLock a(&lock_);
 
@@ -168,9 +240,16 @@ status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
     if (err != NO_ERROR)
         return err;
 
+    // backlink from the frame to us, so the page's owner can be found
+    // when the frame is considered for migration
+    p->object.obj = this;
+    p->object.offset = offset;
+
     // other mappings may have covered this offset into the vmo, so unmap those ranges
     RangeChangeUpdateLocked(offset, PAGE_SIZE);
 
+    CommitChargeUpdateLocked(offset, 1);
+
     return NO_ERROR;
 }
 
@@ -236,6 +315,39 @@ status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, vm_page_t*
     // see if we already have a page at that offset
     p = page_list_.GetPage(offset);
     if (p) {
+        // a deduped frame is referenced by other objects; fork a private
+        // copy before letting a writer at it
+        if ((pf_flags & VMM_PF_FLAG_WRITE) && (p->flags & VM_PAGE_FLAG_SHARED)) {
+            paddr_t pa_clone;
+            vm_page_t* p_clone = pmm_alloc_page(pmm_alloc_flags_, &pa_clone);
+            if (!p_clone)
+                return ERR_NO_MEMORY;
+
+            p_clone->state = VM_PAGE_STATE_OBJECT;
+
+            // unmap the shared frame from our mappings so they refault
+            // onto the copy; other referents keep the original
+            RangeChangeUpdateLocked(offset, PAGE_SIZE);
+
+            memcpy(paddr_to_kvaddr(pa_clone), paddr_to_kvaddr(vm_page_to_paddr(p)), PAGE_SIZE);
+
+            // swap the copy in at the same offset; the commit charge is
+            // unchanged
+            __UNUSED vm_page_t* old = page_list_.ReplacePage(p_clone, offset);
+            DEBUG_ASSERT(old == p);
+
+            p_clone->object.obj = this;
+            p_clone->object.offset = offset;
+
+            if (vm_page_release_shared(p))
+                pmm_free_page(p);
+
+            LTRACEF("copy-on-write forked shared page %p into %p, pa %#" PRIxPTR "\n",
+                    p, p_clone, pa_clone);
+
+            p = p_clone;
+        }
+
         if (page_out)
             *page_out = p;
         if (pa_out)
@@ -318,16 +430,13 @@ status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, vm_page_t*
         return NO_ERROR;
     }
 
-    // allocate a page
-    p = pmm_alloc_page(pmm_alloc_flags_, &pa);
+    // allocate a page, preferring one the pmm scrubber has already zeroed
+    p = pmm_alloc_page(pmm_alloc_flags_ | PMM_ALLOC_FLAG_ZERO, &pa);
     if (!p)
         return ERR_NO_MEMORY;
 
     p->state = VM_PAGE_STATE_OBJECT;
 
-    // TODO: remove once pmm returns zeroed pages
-    ZeroPage(pa);
-
     status_t status = AddPageLocked(p, offset);
     DEBUG_ASSERT(status == NO_ERROR);
 
@@ -379,7 +488,9 @@ status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t* com
     list_node page_list;
     list_initialize(&page_list);
 
-    size_t allocated = pmm_alloc_pages(count, pmm_alloc_flags_, &page_list);
+    // the pmm zeroes the batch for us, preferring pages the scrubber has
+    // already zeroed
+    size_t allocated = pmm_alloc_pages(count, pmm_alloc_flags_ | PMM_ALLOC_FLAG_ZERO, &page_list);
     if (allocated < count) {
         LTRACEF("failed to allocate enough pages (asked for %zu, got %zu)\n", count, allocated);
         pmm_free(&page_list);
@@ -400,12 +511,14 @@ status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t* com
 
         p->state = VM_PAGE_STATE_OBJECT;
 
-        // TODO: remove once pmm returns zeroed pages
-        ZeroPage(p);
-
         status_t status = page_list_.AddPage(p, o);
         DEBUG_ASSERT(status == NO_ERROR);
 
+        p->object.obj = this;
+        p->object.offset = o;
+
+        CommitChargeUpdateLocked(o, 1);
+
         if (committed)
             *committed += PAGE_SIZE;
     }
@@ -473,12 +586,21 @@ status_t VmObjectPaged::CommitRangeContiguous(uint64_t offset, uint64_t len, uin
 
         p->state = VM_PAGE_STATE_OBJECT;
 
+        // contiguous runs exist to be handed to devices, so their frames
+        // must never migrate out from under the caller
+        p->flags |= VM_PAGE_FLAG_UNMOVABLE;
+
         // TODO: remove once pmm returns zeroed pages
         ZeroPage(p);
 
         auto status = page_list_.AddPage(p, o);
         DEBUG_ASSERT(status == NO_ERROR);
 
+        p->object.obj = this;
+        p->object.offset = o;
+
+        CommitChargeUpdateLocked(o, 1);
+
         if (committed)
             *committed += PAGE_SIZE;
     }
@@ -523,8 +645,11 @@ status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t* d
     // iterate through the pages, freeing them
     while (start < end) {
         auto status = page_list_.FreePage(start);
-        if (status == NO_ERROR && decommitted) {
-            *decommitted += PAGE_SIZE;
+        if (status == NO_ERROR) {
+            CommitChargeUpdateLocked(start, -1);
+            if (decommitted) {
+                *decommitted += PAGE_SIZE;
+            }
         }
         start += PAGE_SIZE;
     }
@@ -532,6 +657,266 @@ status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t* d
     return NO_ERROR;
 }
 
+status_t VmObjectPaged::ZeroRange(uint64_t offset, uint64_t len) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    AutoLock a(&lock_);
+
+    // trim the size
+    uint64_t new_len;
+    if (!TrimRange(offset, len, size_, &new_len))
+        return ERR_OUT_OF_RANGE;
+
+    // was in range, just zero length
+    if (new_len == 0)
+        return NO_ERROR;
+
+    const uint64_t end = offset + new_len;
+
+    // for a vmo without a parent, whole pages inside the range can simply be
+    // returned to the pmm; uncommitted ranges already read back as zeros
+    uint64_t aligned_start = PAGE_ALIGN(offset);
+    uint64_t aligned_end = ROUNDDOWN(end, PAGE_SIZE);
+    if (!parent_ && aligned_start < aligned_end) {
+        // unmap the pages in this range on all the mapping regions so that
+        // mapped copies refault and observe the zeroed contents
+        RangeChangeUpdateLocked(aligned_start, aligned_end - aligned_start);
+
+        for (uint64_t off = aligned_start; off < aligned_end; off += PAGE_SIZE) {
+            if (page_list_.FreePage(off) == NO_ERROR)
+                CommitChargeUpdateLocked(off, -1);
+        }
+    }
+
+    // zero the rest in place; for a COW clone this covers the whole range,
+    // since dropping one of our pages would expose the parent's data instead
+    // of zeros
+    for (uint64_t off = ROUNDDOWN(offset, PAGE_SIZE); off < end; off += PAGE_SIZE) {
+        if (!parent_ && off >= aligned_start && off < aligned_end)
+            continue; // freed above
+
+        const size_t page_offset = (offset > off) ? (offset - off) : 0;
+        const size_t zero_len = MIN(end - off, PAGE_SIZE) - page_offset;
+
+        paddr_t pa;
+        vm_page_t* p = page_list_.GetPage(off);
+        if (p) {
+            if (p->flags & VM_PAGE_FLAG_SHARED) {
+                // the frame is deduped into other objects; fork a private
+                // copy to zero so they keep their contents
+                auto status = GetPageLocked(off, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE,
+                                            nullptr, &pa);
+                if (status != NO_ERROR)
+                    return status;
+            } else {
+                pa = vm_page_to_paddr(p);
+            }
+        } else {
+            // see if anything is visible at this offset without faulting
+            auto status = GetPageLocked(off, 0, nullptr, &pa);
+            if (status == ERR_NOT_FOUND) {
+                // nothing committed here or in an ancestor; reads as zeros
+                continue;
+            }
+            if (status != NO_ERROR)
+                return status;
+
+            // the data is only visible through an ancestor; fork our own
+            // copy to zero so siblings sharing the ancestor's page are
+            // unaffected
+            status = GetPageLocked(off, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE, nullptr, &pa);
+            if (status != NO_ERROR)
+                return status;
+        }
+
+        // zero through the kernel mapping of the page
+        uint8_t* page_ptr = reinterpret_cast<uint8_t*>(paddr_to_kvaddr(pa));
+        memset(page_ptr + page_offset, 0, zero_len);
+    }
+
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::SetDiscardable(bool discardable) {
+    canary_.Assert();
+    LTRACEF("vmo %p, discardable %d\n", this, discardable);
+
+    AutoLock a(&reclaim_list_lock);
+
+    if (discardable == discardable_)
+        return NO_ERROR;
+
+    discardable_ = discardable;
+    if (discardable) {
+        reclaim_list.push_back(this);
+    } else {
+        reclaim_list.erase(*this);
+    }
+
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::SetNumaPolicy(uint32_t node_flags) {
+    canary_.Assert();
+    LTRACEF("vmo %p, node_flags %#x\n", this, node_flags);
+
+    if (node_flags & ~(PMM_ALLOC_NODE_POLICY_MASK | PMM_ALLOC_FLAG_NODE(PMM_ALLOC_NODE_MASK)))
+        return ERR_INVALID_ARGS;
+
+    // at most one policy bit may be set
+    uint32_t policy = node_flags & PMM_ALLOC_NODE_POLICY_MASK;
+    if (policy & (policy - 1))
+        return ERR_INVALID_ARGS;
+
+    // a bind policy must name a node that exists
+    if ((node_flags & PMM_ALLOC_FLAG_NODE_BIND) && PMM_ALLOC_NODE(node_flags) >= pmm_node_count())
+        return ERR_INVALID_ARGS;
+
+    AutoLock a(&lock_);
+    pmm_alloc_flags_ =
+        (pmm_alloc_flags_ & ~(PMM_ALLOC_NODE_POLICY_MASK | PMM_ALLOC_FLAG_NODE(PMM_ALLOC_NODE_MASK))) |
+        node_flags;
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::MigratePageLocked(uint64_t offset) {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.IsHeld());
+
+    vm_page_t* old_page = page_list_.GetPage(offset);
+    if (!old_page)
+        return ERR_NOT_FOUND;
+    if (!page_is_movable(old_page))
+        return ERR_BAD_STATE;
+
+    DEBUG_ASSERT(old_page->object.obj == this);
+    DEBUG_ASSERT(old_page->object.offset == offset);
+
+    paddr_t pa;
+    vm_page_t* p = pmm_alloc_page(pmm_alloc_flags_, &pa);
+    if (!p)
+        return ERR_NO_MEMORY;
+
+    p->state = VM_PAGE_STATE_OBJECT;
+
+    // unmap the old frame everywhere first; we hold the lock, so nothing
+    // can fault it back in while the contents move
+    RangeChangeUpdateLocked(offset, PAGE_SIZE);
+
+    paddr_t old_pa = vm_page_to_paddr(old_page);
+    memcpy(paddr_to_kvaddr(pa), paddr_to_kvaddr(old_pa), PAGE_SIZE);
+
+    // swap the new frame in at the same offset; the commit charge is
+    // unchanged, so no CommitChargeUpdateLocked calls are needed
+    __UNUSED vm_page_t* removed = page_list_.ReplacePage(p, offset);
+    DEBUG_ASSERT(removed == old_page);
+
+    p->object.obj = this;
+    p->object.offset = offset;
+
+    pmm_free_page(old_page);
+
+    LTRACEF("vmo %p offset %#" PRIx64 " migrated %#" PRIxPTR " -> %#" PRIxPTR "\n",
+            this, offset, old_pa, pa);
+
+    return NO_ERROR;
+}
+
+size_t VmObjectPaged::Compact() {
+    canary_.Assert();
+
+    AutoLock a(&lock_);
+
+    size_t migrated = 0;
+    uint64_t cursor = 0;
+    for (;;) {
+        // collect a batch of candidate offsets; the page list can't be
+        // mutated while it's being walked
+        uint64_t batch[16];
+        size_t count = 0;
+        page_list_.ForEveryPage([&](const auto p, uint64_t off) {
+            if (off < cursor || count >= countof(batch))
+                return;
+            if (page_is_movable(p) &&
+                pmm_frame_is_compaction_candidate(vm_page_to_paddr(p)))
+                batch[count++] = off;
+        });
+        if (count == 0)
+            break;
+
+        for (size_t i = 0; i < count; i++) {
+            if (MigratePageLocked(batch[i]) == NO_ERROR)
+                migrated++;
+        }
+
+        // the cursor only moves forward, so frames that became
+        // candidates behind it wait for the next pass
+        cursor = batch[count - 1] + PAGE_SIZE;
+    }
+
+    return migrated;
+}
+
+static int vmo_compact_thread(void*) {
+    for (;;) {
+        pmm_wait_for_contiguous_pressure();
+
+        // walk every paged vmo, migrating straggler pages out of
+        // nearly-free blocks so free runs can coalesce
+        size_t migrated = 0;
+        {
+            AutoLock a(&compact_list_lock);
+            for (auto& vmo : compact_list) {
+                migrated += vmo.Compact();
+            }
+        }
+
+        LTRACEF("compaction pass migrated %zu pages\n", migrated);
+    }
+
+    return 0;
+}
+
+static void vmo_compact_init(uint level) {
+    thread_t* t = thread_create("vmo-compact", &vmo_compact_thread, nullptr, LOW_PRIORITY,
+                                DEFAULT_STACK_SIZE);
+    thread_detach_and_resume(t);
+}
+LK_INIT_HOOK(vmo_compact, &vmo_compact_init, LK_INIT_LEVEL_THREADING);
+
+static int vmo_reclaim_thread(void*) {
+    for (;;) {
+        pmm_wait_for_low_mem();
+
+        AutoLock a(&reclaim_list_lock);
+
+        // walk the discardable vmos, least recently marked first, dropping
+        // their pages until the pmm is comfortably above its low watermark.
+        // each vmo visited is rotated to the tail so repeat passes stay fair.
+        size_t remain = reclaim_list.size_slow();
+        while (remain-- > 0 && pmm_count_free_pages() < 2 * PMM_LOW_WATER_PAGES) {
+            VmObjectPaged* vmo = reclaim_list.pop_front();
+            DEBUG_ASSERT(vmo);
+
+            uint64_t decommitted = 0;
+            vmo->DecommitRange(0, vmo->size(), &decommitted);
+            reclaim_list.push_back(vmo);
+
+            LTRACEF("reclaimed %" PRIu64 " bytes from vmo %p\n", decommitted, vmo);
+        }
+    }
+
+    return 0;
+}
+
+static void vmo_reclaim_init(uint level) {
+    thread_t* t = thread_create("vmo-reclaim", &vmo_reclaim_thread, nullptr, LOW_PRIORITY,
+                                DEFAULT_STACK_SIZE);
+    thread_detach_and_resume(t);
+}
+LK_INIT_HOOK(vmo_reclaim, &vmo_reclaim_init, LK_INIT_LEVEL_THREADING);
+
 status_t VmObjectPaged::ResizeLocked(uint64_t s) {
     canary_.Assert();
     DEBUG_ASSERT(lock_.IsHeld());
@@ -557,7 +942,8 @@ status_t VmObjectPaged::ResizeLocked(uint64_t s) {
 
             // iterate through the pages, freeing them
             while (start < end) {
-                page_list_.FreePage(start);
+                if (page_list_.FreePage(start) == NO_ERROR)
+                    CommitChargeUpdateLocked(start, -1);
                 start += PAGE_SIZE;
             }
         }
@@ -613,10 +999,16 @@ template <typename T>
 status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, size_t* bytes_copied, bool write,
                                           T copyfunc) {
     canary_.Assert();
-    if (bytes_copied)
-        *bytes_copied = 0;
 
     AutoLock a(&lock_);
+    return ReadWriteInternalLocked(offset, len, bytes_copied, write, copyfunc);
+}
+
+template <typename T>
+status_t VmObjectPaged::ReadWriteInternalLocked(uint64_t offset, size_t len, size_t* bytes_copied,
+                                                bool write, T copyfunc) {
+    if (bytes_copied)
+        *bytes_copied = 0;
 
     // trim the size
     uint64_t new_len;
@@ -712,10 +1104,16 @@ status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
     size_t index = 0;
     for (uint64_t off = start_page_offset; off != end_page_offset; off += PAGE_SIZE, index++) {
         paddr_t pa;
-        auto status = GetPageLocked(off, pf_flags, nullptr, &pa);
+        vm_page_t* p;
+        auto status = GetPageLocked(off, pf_flags, &p, &pa);
         if (status < 0)
             return ERR_NO_MEMORY;
 
+        // the physical address escapes to the caller (typically for
+        // DMA), so the frame must never migrate from here on
+        if (p->state == VM_PAGE_STATE_OBJECT)
+            p->flags |= VM_PAGE_FLAG_UNMOVABLE;
+
         status = lookup_fn(context, off, index, pa);
         if (unlikely(status < 0))
             return status;
@@ -757,6 +1155,288 @@ status_t VmObjectPaged::WriteUser(user_ptr<const void> ptr, uint64_t offset, siz
     return ReadWriteInternal(offset, len, bytes_written, true, write_routine);
 }
 
+status_t VmObjectPaged::ReadUserVector(UserVec* vec, size_t count, size_t* segments_done) {
+    canary_.Assert();
+    *segments_done = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!user_ptr<void>(vec[i].buffer).is_user_address())
+            return ERR_INVALID_ARGS;
+    }
+
+    // one lock acquisition covers the whole vector
+    AutoLock a(&lock_);
+    for (size_t i = 0; i < count; i++) {
+        user_ptr<void> ptr(vec[i].buffer);
+        auto read_routine = [ptr](const void* src, size_t offset, size_t len) -> status_t {
+            return ptr.byte_offset(offset).copy_array_to_user(src, len);
+        };
+        status_t status = ReadWriteInternalLocked(vec[i].offset, vec[i].len, &vec[i].actual,
+                                                  false, read_routine);
+        if (status != NO_ERROR)
+            return status;
+        (*segments_done)++;
+    }
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::WriteUserVector(UserVec* vec, size_t count, size_t* segments_done) {
+    canary_.Assert();
+    *segments_done = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!user_ptr<void>(vec[i].buffer).is_user_address())
+            return ERR_INVALID_ARGS;
+    }
+
+    // one lock acquisition covers the whole vector
+    AutoLock a(&lock_);
+    for (size_t i = 0; i < count; i++) {
+        user_ptr<const void> ptr(vec[i].buffer);
+        auto write_routine = [ptr](void* dst, size_t offset, size_t len) -> status_t {
+            return ptr.byte_offset(offset).copy_array_from_user(dst, len);
+        };
+        status_t status = ReadWriteInternalLocked(vec[i].offset, vec[i].len, &vec[i].actual,
+                                                  true, write_routine);
+        if (status != NO_ERROR)
+            return status;
+        (*segments_done)++;
+    }
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::Transfer(mxtl::RefPtr<VmObject> src_vmo, uint64_t src_offset,
+                                 mxtl::RefPtr<VmObject> dst_vmo, uint64_t dst_offset,
+                                 uint64_t len) {
+    LTRACEF("src %p offset %#" PRIx64 " dst %p offset %#" PRIx64 " len %#" PRIx64 "\n",
+            src_vmo.get(), src_offset, dst_vmo.get(), dst_offset, len);
+
+    auto src = src_vmo->as_vm_object_paged();
+    auto dst = dst_vmo->as_vm_object_paged();
+    if (!src || !dst)
+        return ERR_NOT_SUPPORTED;
+
+    src->canary_.Assert();
+    dst->canary_.Assert();
+
+    if (len == 0)
+        return NO_ERROR;
+
+    // copying a range of an object onto itself is not supported
+    if (src == dst) {
+        uint64_t unused_off, unused_len;
+        if (GetIntersect(src_offset, len, dst_offset, len, &unused_off, &unused_len))
+            return ERR_INVALID_ARGS;
+    }
+
+    // clones share their ancestor's lock, so the two objects may resolve to
+    // the same mutex; otherwise acquire in address order to avoid deadlocking
+    // against a transfer running the other direction
+    Mutex* src_lock = &src->lock_ref();
+    Mutex* dst_lock = &dst->lock_ref();
+    if (src_lock == dst_lock) {
+        AutoLock a(src_lock);
+        return TransferLocked(src, src_offset, dst, dst_offset, len);
+    } else if (src_lock < dst_lock) {
+        AutoLock a(src_lock);
+        AutoLock b(dst_lock);
+        return TransferLocked(src, src_offset, dst, dst_offset, len);
+    } else {
+        AutoLock a(dst_lock);
+        AutoLock b(src_lock);
+        return TransferLocked(src, src_offset, dst, dst_offset, len);
+    }
+}
+
+status_t VmObjectPaged::TransferLocked(VmObjectPaged* src, uint64_t src_offset,
+                                       VmObjectPaged* dst, uint64_t dst_offset, uint64_t len) {
+    // the whole range must fit in both objects; there is no actual-bytes out
+    // parameter to report a short transfer through
+    if (!InRange(src_offset, len, src->size_) || !InRange(dst_offset, len, dst->size_))
+        return ERR_OUT_OF_RANGE;
+
+    uint64_t soff = src_offset;
+    uint64_t doff = dst_offset;
+    uint64_t remaining = len;
+    while (remaining > 0) {
+        size_t src_page_offset = soff % PAGE_SIZE;
+        size_t dst_page_offset = doff % PAGE_SIZE;
+        size_t tocopy = MIN(MIN(PAGE_SIZE - src_page_offset, PAGE_SIZE - dst_page_offset),
+                            remaining);
+
+        // see what's visible at the source without faulting anything in
+        paddr_t src_pa;
+        auto status = src->GetPageLocked(soff, 0, nullptr, &src_pa);
+        if (status == ERR_NOT_FOUND) {
+            // nothing committed at the source, so it reads as zeros. the
+            // destination must end up zero too, but only needs touching if
+            // data is already visible there; otherwise skipping preserves
+            // the sparseness of both objects.
+            paddr_t dst_pa;
+            status = dst->GetPageLocked(doff, 0, nullptr, &dst_pa);
+            if (status == NO_ERROR) {
+                // fork a writable copy in case the visible page belongs to
+                // an ancestor shared with siblings
+                status = dst->GetPageLocked(doff, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE,
+                                            nullptr, &dst_pa);
+                if (status != NO_ERROR)
+                    return status;
+
+                uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(paddr_to_kvaddr(dst_pa));
+                memset(dst_ptr + dst_page_offset, 0, tocopy);
+            } else if (status != ERR_NOT_FOUND) {
+                return status;
+            }
+        } else if (status != NO_ERROR) {
+            return status;
+        } else {
+            // fault the destination page in for write and copy directly
+            // between the kernel mappings of the two pages
+            paddr_t dst_pa;
+            status = dst->GetPageLocked(doff, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE,
+                                        nullptr, &dst_pa);
+            if (status != NO_ERROR)
+                return status;
+
+            const uint8_t* src_ptr = reinterpret_cast<const uint8_t*>(paddr_to_kvaddr(src_pa));
+            uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(paddr_to_kvaddr(dst_pa));
+            memcpy(dst_ptr + dst_page_offset, src_ptr + src_page_offset, tocopy);
+        }
+
+        soff += tocopy;
+        doff += tocopy;
+        remaining -= tocopy;
+    }
+
+    return NO_ERROR;
+}
+
+status_t VmObjectPaged::Dedup(mxtl::RefPtr<VmObject> src_vmo, uint64_t src_offset,
+                              mxtl::RefPtr<VmObject> dst_vmo, uint64_t dst_offset,
+                              uint64_t len, uint64_t* deduped) {
+    LTRACEF("src %p offset %#" PRIx64 " dst %p offset %#" PRIx64 " len %#" PRIx64 "\n",
+            src_vmo.get(), src_offset, dst_vmo.get(), dst_offset, len);
+
+    if (deduped)
+        *deduped = 0;
+
+    auto src = src_vmo->as_vm_object_paged();
+    auto dst = dst_vmo->as_vm_object_paged();
+    if (!src || !dst)
+        return ERR_NOT_SUPPORTED;
+
+    src->canary_.Assert();
+    dst->canary_.Assert();
+
+    // frames are shared whole, so everything must be page aligned
+    if (!IS_PAGE_ALIGNED(src_offset) || !IS_PAGE_ALIGNED(dst_offset) || !IS_PAGE_ALIGNED(len))
+        return ERR_INVALID_ARGS;
+
+    if (len == 0)
+        return NO_ERROR;
+
+    // merging a range of an object onto itself is not supported
+    if (src == dst) {
+        uint64_t unused_off, unused_len;
+        if (GetIntersect(src_offset, len, dst_offset, len, &unused_off, &unused_len))
+            return ERR_INVALID_ARGS;
+    }
+
+    // clones share their ancestor's lock, so the two objects may resolve to
+    // the same mutex; otherwise acquire in address order to avoid deadlocking
+    // against a merge running the other direction
+    Mutex* src_lock = &src->lock_ref();
+    Mutex* dst_lock = &dst->lock_ref();
+    if (src_lock == dst_lock) {
+        AutoLock a(src_lock);
+        return DedupLocked(src, src_offset, dst, dst_offset, len, deduped);
+    } else if (src_lock < dst_lock) {
+        AutoLock a(src_lock);
+        AutoLock b(dst_lock);
+        return DedupLocked(src, src_offset, dst, dst_offset, len, deduped);
+    } else {
+        AutoLock a(dst_lock);
+        AutoLock b(src_lock);
+        return DedupLocked(src, src_offset, dst, dst_offset, len, deduped);
+    }
+}
+
+status_t VmObjectPaged::DedupLocked(VmObjectPaged* src, uint64_t src_offset,
+                                    VmObjectPaged* dst, uint64_t dst_offset, uint64_t len,
+                                    uint64_t* deduped) {
+    // the whole range must fit in both objects
+    if (!InRange(src_offset, len, src->size_) || !InRange(dst_offset, len, dst->size_))
+        return ERR_OUT_OF_RANGE;
+
+    for (uint64_t off = 0; off < len; off += PAGE_SIZE) {
+        uint64_t soff = src_offset + off;
+        uint64_t doff = dst_offset + off;
+
+        // both sides must have their own committed page; pages visible only
+        // through an ancestor have murkier ownership and are left alone
+        vm_page_t* sp = src->page_list_.GetPage(soff);
+        vm_page_t* dp = dst->page_list_.GetPage(doff);
+        if (!sp || !dp || sp == dp)
+            continue;
+
+        // a pinned destination frame can't be given back, and a pinned
+        // source may be written by a device behind the vm's back, which
+        // would alter the destination's view as well
+        if ((sp->flags | dp->flags) & VM_PAGE_FLAG_UNMOVABLE)
+            continue;
+
+        // Before looking at the contents, tear down any existing mappings of
+        // both frames.  A thread writing through an already-writable mapping
+        // would not fault, so comparing first would let it alter the source
+        // after a successful compare (merging non-identical pages) or write
+        // the doomed destination copy just before it is freed (losing the
+        // write).  Once unmapped, any access must refault, and the fault
+        // path blocks on the object locks we hold until the merge (or the
+        // unwind below) is complete.
+        //
+        // The source frame is marked shared first so that a write fault
+        // landing after we drop the locks forks instead of scribbling on it.
+        bool src_newly_shared = false;
+        if ((sp->flags & VM_PAGE_FLAG_SHARED) == 0) {
+            sp->flags |= VM_PAGE_FLAG_SHARED;
+            sp->object.share_count = 1;
+            src_newly_shared = true;
+        }
+        src->RangeChangeUpdateLocked(soff, PAGE_SIZE);
+        dst->RangeChangeUpdateLocked(doff, PAGE_SIZE);
+
+        // only merge pages whose contents really match; a caller working
+        // from stale hashes must not be able to corrupt the destination
+        const void* src_ptr = paddr_to_kvaddr(vm_page_to_paddr(sp));
+        const void* dst_ptr = paddr_to_kvaddr(vm_page_to_paddr(dp));
+        if (memcmp(src_ptr, dst_ptr, PAGE_SIZE) != 0) {
+            // no concurrent fault can have observed the flag while we hold
+            // the locks, so the speculative share marking can be unwound
+            if (src_newly_shared) {
+                DEBUG_ASSERT(sp->object.share_count == 1);
+                sp->flags &= ~VM_PAGE_FLAG_SHARED;
+                sp->object.share_count = 0;
+            }
+            continue;
+        }
+
+        atomic_add(&sp->object.share_count, 1);
+
+        // swap the shared frame in for the destination's private copy; the
+        // commit charge is unchanged, one page either way
+        __UNUSED vm_page_t* old = dst->page_list_.ReplacePage(sp, doff);
+        DEBUG_ASSERT(old == dp);
+
+        if (vm_page_release_shared(dp))
+            pmm_free_page(dp);
+
+        if (deduped)
+            (*deduped)++;
+    }
+
+    return NO_ERROR;
+}
+
 status_t VmObjectPaged::LookupUser(uint64_t offset, uint64_t len, user_ptr<paddr_t> buffer,
                                    size_t buffer_size) {
     canary_.Assert();
@@ -30,7 +30,7 @@ VmPageListNode::~VmPageListNode() {
     }
 }
 
-vm_page* VmPageListNode::GetPage(size_t index) {
+vm_page* VmPageListNode::GetPage(size_t index) const {
     canary_.Assert();
     DEBUG_ASSERT(index < kPageFanOut);
     return pages_[index];
@@ -95,7 +95,7 @@ status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
     return NO_ERROR;
 }
 
-vm_page* VmPageList::GetPage(uint64_t offset) {
+vm_page* VmPageList::GetPage(uint64_t offset) const {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
 
@@ -111,6 +111,57 @@ vm_page* VmPageList::GetPage(uint64_t offset) {
     return pln->GetPage(index);
 }
 
+vm_page* VmPageList::RemovePage(uint64_t offset) {
+    uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
+    size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
+
+    LTRACEF_LEVEL(2, "%p offset %#" PRIx64 " node_offset %#" PRIx64 " index %zu\n", this, offset, node_offset,
+                  index);
+
+    // lookup the tree node that holds this page
+    auto pln = list_.find(node_offset);
+    if (!pln.IsValid()) {
+        return nullptr;
+    }
+
+    // detach this page, handing ownership to the caller
+    auto page = pln->RemovePage(index);
+    if (page && pln->IsEmpty()) {
+        // it was the last page in the node, remove the node from the tree
+        LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
+        list_.erase(*pln);
+    }
+
+    return page;
+}
+
+vm_page* VmPageList::ReplacePage(vm_page* p, uint64_t offset) {
+    uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
+    size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
+
+    LTRACEF_LEVEL(2, "%p page %p, offset %#" PRIx64 " node_offset %#" PRIx64 " index %zu\n", this, p,
+                  offset, node_offset, index);
+
+    // lookup the tree node that holds this page
+    auto pln = list_.find(node_offset);
+    if (!pln.IsValid()) {
+        return nullptr;
+    }
+
+    // swap the new page into the slot in place; since the node already
+    // exists this cannot fail, unlike a RemovePage/AddPage pair, which may
+    // free the node and then fail to reallocate it
+    auto old = pln->RemovePage(index);
+    if (!old) {
+        return nullptr;
+    }
+
+    __UNUSED auto status = pln->AddPage(p, index);
+    DEBUG_ASSERT(status == NO_ERROR);
+
+    return old;
+}
+
 status_t VmPageList::FreePage(uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
@@ -133,7 +184,9 @@ status_t VmPageList::FreePage(uint64_t offset) {
             list_.erase(*pln);
         }
 
-        pmm_free_page(page);
+        // a deduped frame only goes back to the pmm with its last reference
+        if (vm_page_release_shared(page))
+            pmm_free_page(page);
     }
 
     return NO_ERROR;
@@ -142,25 +195,46 @@ status_t VmPageList::FreePage(uint64_t offset) {
 size_t VmPageList::FreeAllPages() {
     LTRACEF("%p\n", this);
 
+    // Return pages to the pmm in bounded batches rather than as one
+    // giant list, so tearing down a huge vmo never holds the pmm arena
+    // lock across millions of pages at once.
+    constexpr size_t kFreeBatchPages = 512;
+
     list_node list;
     list_initialize(&list);
 
     size_t count = 0;
+    size_t batch = 0;
 
     // per page get a reference to the page pointer inside the page list node
     auto per_page_func = [&](vm_page*& p, uint64_t offset) {
+        // drop our reference; frames still deduped into another object
+        // stay out of the free list
+        if (!vm_page_release_shared(p)) {
+            p = nullptr;
+            count++;
+            return;
+        }
+
         // add the page to our list and null out the inner node
         list_add_tail(&list, &p->free.node);
         p = nullptr;
         count++;
+        if (++batch == kFreeBatchPages) {
+            __UNUSED auto freed = pmm_free(&list);
+            DEBUG_ASSERT(freed == batch);
+            batch = 0;
+        }
     };
 
     // walk the tree in order, freeing all the pages on every node
     ForEveryPage(per_page_func);
 
-    // return all the pages to the pmm at once
-    __UNUSED auto freed = pmm_free(&list);
-    DEBUG_ASSERT(freed == count);
+    // return the final partial batch to the pmm
+    if (batch > 0) {
+        __UNUSED auto freed = pmm_free(&list);
+        DEBUG_ASSERT(freed == batch);
+    }
 
     // empty the tree
     list_.clear();
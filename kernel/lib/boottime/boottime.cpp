@@ -0,0 +1,116 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/boottime.h>
+
+#include <inttypes.h>
+#include <kernel/vm/vm_object_paged.h>
+#include <lib/console.h>
+#include <magenta/boot/bootdata.h>
+#include <platform.h>
+#include <stdio.h>
+#include <string.h>
+
+#if ARCH_X86
+#include <arch/x86.h>
+#endif
+
+#define BOOT_TIMELINE_MAX 32
+
+static bootdata_boot_timeline_entry_t entries[BOOT_TIMELINE_MAX];
+static uint32_t entry_count;
+
+// On x86 the raw TSC matches both the bootloader's records and the
+// userspace mx_ticks_get() timebase, and is readable before any timer
+// calibration.  Elsewhere fall back to the monotonic clock, which reads
+// as zero until the platform timer comes up.
+static uint64_t boot_timeline_ticks(void) {
+#if ARCH_X86
+    return rdtsc();
+#else
+    return current_time();
+#endif
+}
+
+static uint64_t boot_timeline_ticks_per_second(void) {
+#if ARCH_X86
+    return 0; // mx_ticks_get() timebase
+#else
+    return LK_SEC(1); // nanoseconds
+#endif
+}
+
+void boot_timeline_mark(const char* name) {
+    if (entry_count == BOOT_TIMELINE_MAX)
+        return;
+    bootdata_boot_timeline_entry_t* e = &entries[entry_count];
+    e->ticks = boot_timeline_ticks();
+    strlcpy(e->name, name, sizeof(e->name));
+    entry_count++;
+}
+
+mxtl::RefPtr<VmObject> boot_timeline_get_vmo(void) {
+    size_t payload = sizeof(bootdata_boot_timeline_t) +
+                     (entry_count * sizeof(bootdata_boot_timeline_entry_t));
+    size_t total = (2 * sizeof(bootdata_t)) + BOOTDATA_ALIGN(payload);
+
+    auto vmo = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, total);
+    if (!vmo)
+        return nullptr;
+
+    bootdata_t hdr = {
+        .type = BOOTDATA_CONTAINER,
+        .length = static_cast<uint32_t>(total - sizeof(bootdata_t)),
+        .extra = BOOTDATA_MAGIC,
+        .flags = 0,
+    };
+    size_t actual;
+    uint64_t off = 0;
+    if (vmo->Write(&hdr, off, sizeof(hdr), &actual) != NO_ERROR)
+        return nullptr;
+    off += sizeof(hdr);
+
+    hdr.type = BOOTDATA_BOOT_TIMELINE;
+    hdr.length = static_cast<uint32_t>(payload);
+    hdr.extra = 0;
+    if (vmo->Write(&hdr, off, sizeof(hdr), &actual) != NO_ERROR)
+        return nullptr;
+    off += sizeof(hdr);
+
+    bootdata_boot_timeline_t tl = {
+        .ticks_per_second = boot_timeline_ticks_per_second(),
+        .entry_count = entry_count,
+        .reserved = 0,
+    };
+    if (vmo->Write(&tl, off, sizeof(tl), &actual) != NO_ERROR)
+        return nullptr;
+    off += sizeof(tl);
+
+    if (vmo->Write(entries, off,
+                   entry_count * sizeof(entries[0]), &actual) != NO_ERROR)
+        return nullptr;
+
+    return vmo;
+}
+
+static int cmd_boottime(int argc, const cmd_args* argv, uint32_t flags) {
+    uint64_t tps = boot_timeline_ticks_per_second();
+    if (tps == 0)
+        tps = ticks_per_second();
+    uint64_t prev = (entry_count > 0) ? entries[0].ticks : 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        uint64_t delta_us = ((entries[i].ticks - prev) * 1000000u) / tps;
+        printf("%-16s %20" PRIu64 " ticks (+%" PRIu64 ".%03" PRIu64 " ms)\n",
+               entries[i].name, entries[i].ticks,
+               delta_us / 1000, delta_us % 1000);
+        prev = entries[i].ticks;
+    }
+    return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("boottime", "dump the kernel boot timeline", &cmd_boottime)
+STATIC_COMMAND_END(boottime);
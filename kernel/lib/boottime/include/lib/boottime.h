@@ -0,0 +1,31 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <magenta/compiler.h>
+
+__BEGIN_CDECLS
+
+// Records a named timestamp on the kernel's boot timeline.  Only for use
+// from the boot path on the boot cpu; there is no locking.  Names longer
+// than BOOTDATA_TIMELINE_NAME_LEN-1 characters are truncated.
+void boot_timeline_mark(const char* name);
+
+__END_CDECLS
+
+#ifdef __cplusplus
+
+#include <mxtl/ref_ptr.h>
+
+class VmObject;
+
+// Returns a VMO holding a bootdata container with a single
+// BOOTDATA_BOOT_TIMELINE item covering every mark recorded so far, for
+// handing to userboot alongside the bootloader's own timeline item.
+mxtl::RefPtr<VmObject> boot_timeline_get_vmo(void);
+
+#endif // __cplusplus
@@ -12,6 +12,7 @@
 #include <string.h>
 #include <assert.h>
 #include <lib/cbuf.h>
+#include <arch/ops.h>
 #include <kernel/event.h>
 #include <kernel/spinlock.h>
 
@@ -171,6 +172,106 @@ retry:
     return ret;
 }
 
+// Lock-free single-producer/single-consumer block variants.
+//
+// These move whole blocks and touch the event at most once per call,
+// instead of taking the spinlock and signaling per byte the way the
+// char-based API does, so an interrupt handler can drain a device FIFO
+// with one call.  The contract: exactly one producer and one consumer
+// at a time, and no concurrent use of the locked API on the same cbuf.
+// head is owned by the producer and tail by the consumer; each is
+// published only after the data (or space) it covers is visible.
+
+size_t cbuf_write_block(cbuf_t *cbuf, const void *_buf, size_t len, bool canreschedule)
+{
+    const char *buf = (const char *)_buf;
+
+    DEBUG_ASSERT(cbuf);
+    DEBUG_ASSERT(buf);
+
+    uint head = cbuf->head;
+    uint tail = (uint)atomic_load((volatile int *)&cbuf->tail);
+    size_t size = valpow2(cbuf->len_pow2);
+    size_t space = size - modpow2(head - tail, cbuf->len_pow2) - 1;
+
+    size_t towrite = MIN(space, len);
+    size_t pos = 0;
+    while (pos < towrite) {
+        size_t run = MIN(size - head, towrite - pos);
+        memcpy(cbuf->buf + head, buf + pos, run);
+        pos += run;
+        head = INC_POINTER(cbuf, head, run);
+    }
+
+    if (towrite == 0) {
+        return 0;
+    }
+
+    // publish the new head only after the data is visible
+    smp_wmb();
+    cbuf->head = head;
+
+    int signaled = event_signal(&cbuf->event, false);
+    if (canreschedule && (signaled > 0))
+        thread_preempt(false);
+
+    return towrite;
+}
+
+size_t cbuf_read_block(cbuf_t *cbuf, void *_buf, size_t buflen, bool block)
+{
+    char *buf = (char *)_buf;
+
+    DEBUG_ASSERT(cbuf);
+
+retry:
+    // block on the cbuf outside of the lock, which may
+    // unblock us early and we'll have to double check below
+    if (block)
+        event_wait(&cbuf->event);
+
+    uint tail = cbuf->tail;
+    uint head = (uint)atomic_load((volatile int *)&cbuf->head);
+
+    // don't read the data until we've seen the head that covers it
+    smp_rmb();
+
+    size_t size = valpow2(cbuf->len_pow2);
+    size_t used = modpow2(head - tail, cbuf->len_pow2);
+
+    size_t toread = MIN(used, buflen);
+    size_t pos = 0;
+    while (pos < toread) {
+        size_t run = MIN(size - tail, toread - pos);
+        if (NULL != buf) {
+            memcpy(buf + pos, cbuf->buf + tail, run);
+        }
+        pos += run;
+        tail = INC_POINTER(cbuf, tail, run);
+    }
+
+    if (toread > 0) {
+        // release the space back to the producer only after the copy is done
+        smp_mb();
+        cbuf->tail = tail;
+
+        if (tail == head) {
+            // we've emptied the buffer; unsignal and recheck, since the
+            // producer may have pushed more data and signaled between
+            // our read of head and the unsignal
+            event_unsignal(&cbuf->event);
+            if ((uint)atomic_load((volatile int *)&cbuf->head) != tail)
+                event_signal(&cbuf->event, false);
+        }
+    }
+
+    // we apparently blocked but raced with the producer and found no data, retry
+    if (block && toread == 0)
+        goto retry;
+
+    return toread;
+}
+
 size_t cbuf_peek_etc(cbuf_t *cbuf, iovec_t *regions, bool writable)
 {
     DEBUG_ASSERT(cbuf && regions);
@@ -199,6 +199,44 @@ static inline void cbuf_reset(cbuf_t *cbuf)
     cbuf_read(cbuf, NULL, cbuf_size(cbuf), false);
 }
 
+/**
+ * cbuf_write_block
+ *
+ * Lock-free single-producer variant of cbuf_write.  Copies up to len bytes
+ * into the cbuf and signals the event at most once, without taking the
+ * spinlock, so it is safe and cheap to call from an interrupt handler with
+ * a whole batch of data.
+ *
+ * The cbuf must have exactly one producer and one consumer, and the locked
+ * write API must not be used concurrently on the same cbuf.  Pair with
+ * cbuf_read_block on the consumer side.
+ *
+ * @param[in] cbuf The cbuf instance to write to.
+ * @param[in] buf A pointer to the data to copy in; must not be NULL.
+ * @param[in] len The maximum number of bytes to write.
+ * @param[in] canreschedule Rescheduling policy passed through when
+ * signaling the event.
+ *
+ * @return The number of bytes which were written.
+ */
+size_t cbuf_write_block(cbuf_t *cbuf, const void *buf, size_t len, bool canreschedule);
+
+/**
+ * cbuf_read_block
+ *
+ * Lock-free single-consumer variant of cbuf_read; see cbuf_write_block for
+ * the contract.
+ *
+ * @param[in] cbuf The cbuf instance to read from.
+ * @param[in] buf A pointer to a buffer to read data into.  If NULL, skips
+ * up to the next buflen bytes.
+ * @param[in] buflen The maximum number of bytes to read.
+ * @param[in] block When true, block until at least one byte is available.
+ *
+ * @return The actual number of bytes which were read (or skipped).
+ */
+size_t cbuf_read_block(cbuf_t *cbuf, void *buf, size_t buflen, bool block);
+
 /* special cases for dealing with a single char of data */
 size_t cbuf_read_char(cbuf_t *cbuf, char *c, bool block);
 size_t cbuf_write_char(cbuf_t *cbuf, char c, bool canreschedule);
@@ -14,6 +14,8 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <list.h>
+#include <kernel/event.h>
 #include <kernel/thread.h>
 #include <kernel/mutex.h>
 #include <lib/console.h>
@@ -64,6 +66,21 @@ static void dump_history(void);
 /* list of installed commands */
 static cmd_block *command_list = NULL;
 
+/* queue of heavyweight commands pending on the low-priority worker.
+   their printf output is staged in the debug log and drained to the
+   uart asynchronously, so queueing a big dump doesn't stall anything */
+struct console_work {
+    struct list_node node;
+    const cmd *command;
+    int argc;
+    cmd_args args[MAX_NUM_ARGS];
+    char strings[LINE_LEN];
+};
+
+static mutex_t work_lock = MUTEX_INITIAL_VALUE(work_lock);
+static struct list_node work_queue = LIST_INITIAL_VALUE(work_queue);
+static event_t work_event = EVENT_INITIAL_VALUE(work_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
 /* a linear array of statically defined command blocks,
    defined in the linker script.
  */
@@ -88,6 +105,59 @@ STATIC_COMMAND("history", "command history", &cmd_history)
 #endif
 STATIC_COMMAND_END(help);
 
+static int console_worker(void *arg)
+{
+    for (;;) {
+        event_wait(&work_event);
+
+        for (;;) {
+            mutex_acquire(&work_lock);
+            struct console_work *work =
+                list_remove_head_type(&work_queue, struct console_work, node);
+            mutex_release(&work_lock);
+
+            if (work == NULL)
+                break;
+
+            work->command->cmd_callback(work->argc, work->args, 0);
+            free(work);
+        }
+    }
+
+    return NO_ERROR;
+}
+
+static bool queue_heavy_command(const cmd *command, int argc, const cmd_args *args)
+{
+    struct console_work *work = malloc(sizeof(struct console_work));
+    if (work == NULL)
+        return false;
+
+    work->command = command;
+    work->argc = argc;
+
+    /* deep copy the args; the tokenize buffer is reused for the next line */
+    size_t pos = 0;
+    for (int i = 0; i < argc; i++) {
+        size_t len = strlen(args[i].str) + 1;
+        if (pos + len > sizeof(work->strings)) {
+            free(work);
+            return false;
+        }
+        memcpy(work->strings + pos, args[i].str, len);
+        work->args[i] = args[i];
+        work->args[i].str = work->strings + pos;
+        pos += len;
+    }
+
+    mutex_acquire(&work_lock);
+    list_add_tail(&work_queue, &work->node);
+    mutex_release(&work_lock);
+    event_signal(&work_event, true);
+
+    return true;
+}
+
 int console_init(void)
 {
     LTRACE_ENTRY;
@@ -95,6 +165,11 @@ int console_init(void)
     command_lock = calloc(sizeof(mutex_t), 1);
     mutex_init(command_lock);
 
+    thread_t *worker = thread_create("console-worker", &console_worker, NULL,
+                                     LOW_PRIORITY, DEFAULT_STACK_SIZE);
+    if (worker)
+        thread_resume(worker);
+
     /* add all the statically defined commands to the list */
     cmd_block *block;
     for (block = __start_commands; block != __stop_commands; block++) {
@@ -623,6 +698,15 @@ static status_t command_loop(int (*get_line)(const char **, void *), void *get_l
             continue;
         }
 
+        /* hand heavyweight diagnostics to the low-priority worker so the
+           console stays interactive; only for the interactive console, since
+           scripts expect commands to run synchronously */
+        if ((command->availability_mask & CMD_AVAIL_HEAVY) && showprompt) {
+            if (queue_heavy_command(command, argc, args))
+                continue;
+            /* couldn't queue it; fall through and run it inline */
+        }
+
         if (!locked)
             mutex_acquire(command_lock);
 
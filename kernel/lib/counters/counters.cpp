@@ -0,0 +1,123 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/counters.h>
+
+#include <arch/defines.h>
+#include <assert.h>
+#include <debug.h>
+#include <err.h>
+#include <inttypes.h>
+#include <kernel/mp.h>
+#include <kernel/vm.h>
+#include <kernel/vm/vm_object_physical.h>
+#include <lib/console.h>
+#include <lk/init.h>
+#include <magenta/kcounter.h>
+#include <stdio.h>
+#include <string.h>
+#include <trace.h>
+
+#define LOCAL_TRACE 0
+
+uint64_t* kcounters_arena;
+size_t kcounters_percpu_words;
+
+static paddr_t kcounters_phys;
+static size_t kcounters_vmo_size;
+
+static size_t kcounter_count(void) {
+    return (size_t)(__stop_kcountdesc - __start_kcountdesc);
+}
+
+static void counters_init(uint level) {
+    size_t num = kcounter_count();
+    if (num == 0)
+        return;
+
+    // Lay out the shared pages: header, then the name table, then the
+    // per-CPU arena.  The arena starts on its own page and each CPU's slots
+    // are padded out to whole cache lines, so no two CPUs ever share a line.
+    size_t name_table_off = sizeof(kcounter_vmo_header_t);
+    size_t arena_off = ROUNDUP(name_table_off + (num * KCOUNTER_NAME_SIZE), PAGE_SIZE);
+    size_t stride = ROUNDUP(num * sizeof(uint64_t), CACHE_LINE);
+    size_t total = arena_off + (stride * SMP_MAX_CPUS);
+    size_t pages = ROUNDUP(total, PAGE_SIZE) / PAGE_SIZE;
+
+    paddr_t pa;
+    size_t allocated = pmm_alloc_contiguous(pages, PMM_ALLOC_FLAG_ANY, 0, &pa, nullptr);
+    if (allocated != pages) {
+        printf("counters: failed to allocate %zu pages for %zu counters\n", pages, num);
+        return;
+    }
+
+    void* va = paddr_to_kvaddr(pa);
+    DEBUG_ASSERT(va != nullptr);
+    memset(va, 0, pages * PAGE_SIZE);
+
+    auto hdr = static_cast<kcounter_vmo_header_t*>(va);
+    hdr->magic = KCOUNTER_MAGIC;
+    hdr->version = KCOUNTER_VERSION;
+    hdr->num_counters = num;
+    hdr->max_cpus = SMP_MAX_CPUS;
+    hdr->name_table_off = name_table_off;
+    hdr->name_size = KCOUNTER_NAME_SIZE;
+    hdr->arena_off = arena_off;
+    hdr->arena_percpu_stride = stride;
+
+    char* names = static_cast<char*>(va) + name_table_off;
+    for (size_t i = 0; i < num; i++)
+        strlcpy(names + (i * KCOUNTER_NAME_SIZE), __start_kcountdesc[i].name,
+                KCOUNTER_NAME_SIZE);
+
+    kcounters_phys = pa;
+    kcounters_vmo_size = pages * PAGE_SIZE;
+    kcounters_percpu_words = stride / sizeof(uint64_t);
+
+    // Publish the arena last; kcounter_add is a no-op until this store.
+    kcounters_arena = reinterpret_cast<uint64_t*>(static_cast<char*>(va) + arena_off);
+
+    LTRACEF("%zu counters, %zu pages @%#" PRIxPTR "\n", num, pages, pa);
+}
+
+// After the VM is fully up, before any of the interesting event sources
+// start running.
+LK_INIT_HOOK(kcounters, counters_init, LK_INIT_LEVEL_VM + 1);
+
+mxtl::RefPtr<VmObject> kcounters_get_vmo(void) {
+    if (kcounters_phys == 0)
+        return nullptr;
+    return VmObjectPhysical::Create(kcounters_phys, kcounters_vmo_size);
+}
+
+static uint64_t kcounter_sum(size_t index) {
+    uint64_t sum = 0;
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++)
+        sum += kcounters_arena[(kcounters_percpu_words * cpu) + index];
+    return sum;
+}
+
+static int cmd_counters(int argc, const cmd_args* argv, uint32_t flags) {
+    if (kcounters_arena == nullptr) {
+        printf("counter arena is not initialized\n");
+        return -1;
+    }
+
+    // With a prefix argument, only print matching counters.
+    const char* prefix = (argc > 1) ? argv[1].str : nullptr;
+    size_t num = kcounter_count();
+    for (size_t i = 0; i < num; i++) {
+        const char* name = __start_kcountdesc[i].name;
+        if (prefix && (strncmp(name, prefix, strlen(prefix)) != 0))
+            continue;
+        printf("%-55s %" PRIu64 "\n", name, kcounter_sum(i));
+    }
+    return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("counters", "dump kernel event counters", &cmd_counters)
+STATIC_COMMAND_END(counters);
@@ -0,0 +1,86 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+/**
+ * Kernel event counters.
+ *
+ * A counter is declared statically with KCOUNTER(); the descriptors collect
+ * in a dedicated linker section (the same orphan-section trick lk_init
+ * uses), so the full table is known at link time with no registration at
+ * runtime.  Each counter gets one cache-line-private 64-bit slot per CPU in
+ * an arena allocated at boot, and kcounter_add() is a plain unlocked
+ * read-modify-write of the current CPU's slot, cheap enough for any hot
+ * path.  Updates which race a CPU migration can be lost; these are
+ * statistics, not bookkeeping.
+ *
+ * The arena (together with the name table) lives in physical pages exposed
+ * to userspace read-only as the PA_VMO_KCOUNTERS VMO, so a monitoring agent
+ * can map it once and poll every counter with no syscalls.  See
+ * magenta/kcounter.h for the layout.  The "counters" console command dumps
+ * the summed values from the kernel side.
+ *
+ * Typical usage:
+ *
+ *   KCOUNTER(thread_context_switches, "thread.context_switches");
+ *   ...
+ *   kcounter_add(&thread_context_switches, 1);
+ */
+
+#include <arch/ops.h>
+#include <magenta/compiler.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+typedef struct k_counter_desc {
+    const char* name;
+} k_counter_desc_t;
+
+/* Define a counter.  |name_str| should be a dotted path naming the event,
+ * subsystem first (e.g. "channel.messages"), and must fit in the name table
+ * entry size (KCOUNTER_NAME_SIZE bytes including the NUL). */
+#define KCOUNTER(var, name_str)              \
+    __USED __SECTION("kcountdesc")           \
+    static const k_counter_desc_t var = { name_str }
+
+#define KCOUNTER_NAME_SIZE 56u
+
+/* The descriptor table, delimited by the linker. */
+extern const k_counter_desc_t __start_kcountdesc[] __WEAK;
+extern const k_counter_desc_t __stop_kcountdesc[] __WEAK;
+
+/* The live arena; NULL until the boot-time init hook has run.  Counter |i|'s
+ * slot for a given CPU is arena[(cpu * percpu_words) + i]. */
+extern uint64_t* kcounters_arena;
+extern size_t kcounters_percpu_words;
+
+static inline size_t kcounter_index(const k_counter_desc_t* desc) {
+    return (size_t)(desc - __start_kcountdesc);
+}
+
+static inline void kcounter_add(const k_counter_desc_t* desc, int64_t delta) {
+    if (unlikely(kcounters_arena == NULL))
+        return;
+    kcounters_arena[(kcounters_percpu_words * arch_curr_cpu_num()) +
+                    kcounter_index(desc)] += (uint64_t)delta;
+}
+
+__END_CDECLS
+
+#ifdef __cplusplus
+
+#include <mxtl/ref_ptr.h>
+
+class VmObject;
+
+/* Return a VMO spanning the counter pages, for handing to userboot.  Returns
+ * nullptr if the counter arena could not be allocated (or no counters are
+ * compiled in). */
+mxtl::RefPtr<VmObject> kcounters_get_vmo(void);
+
+#endif  // __cplusplus
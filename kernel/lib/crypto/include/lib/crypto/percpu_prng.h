@@ -0,0 +1,38 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace crypto {
+
+// A set of per-cpu fast-key-erasure generators layered on top of the
+// global PRNG.  Small draws come from the calling cpu's generator
+// without touching any shared lock; the generators pull fresh keys from
+// the global pool periodically, and immediately after new entropy is
+// mixed into it.
+namespace PercpuPRNG {
+
+// The maximum number of bytes a single Draw may request.  Larger
+// requests should go to the global PRNG directly.
+constexpr size_t kMaxDrawLen = 256;
+
+// Get pseudo-random output of |size| bytes from the calling cpu's
+// generator.  |size| MUST NOT be greater than kMaxDrawLen.  May block
+// the first time a cpu's generator is (re)seeded, with the same caveats
+// as PRNG::Draw.
+void Draw(void* out, size_t size);
+
+// Notify the per-cpu generators that fresh entropy has been added to
+// the global pool.  Each generator reseeds from the pool on its next
+// Draw.
+void NotifyEntropyAdded();
+
+} // namespace PercpuPRNG
+
+} // namespace crypto
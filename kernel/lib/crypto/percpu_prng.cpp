@@ -0,0 +1,151 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/crypto/percpu_prng.h>
+
+#include <arch/ops.h>
+#include <assert.h>
+#include <string.h>
+
+#include <boring-crypto/chacha.h>
+#include <kernel/spinlock.h>
+#include <lib/crypto/global_prng.h>
+#include <lib/crypto/prng.h>
+#include <lk/init.h>
+#include <magenta/compiler.h>
+
+namespace crypto {
+
+namespace PercpuPRNG {
+
+// ChaCha20 key size, in bytes.
+constexpr size_t kKeySize = 32;
+
+// Pull a fresh key from the global pool after this many bytes of output.
+constexpr uint64_t kReseedAfter = 1u << 16;
+
+// Per-cpu generator state.  A cpu's state is only touched from that cpu
+// with interrupts disabled, so no lock is needed.  The key is rolled
+// forward on every draw (fast key erasure): the first kKeySize bytes of
+// each keystream become the next key, so capturing the state later
+// cannot recover earlier output.
+struct percpu_state {
+    uint8_t key[kKeySize];
+    uint64_t nonce;
+    uint64_t drawn;   // bytes of output since the last reseed
+    int generation;   // pool generation the key was last mixed from
+} __CPU_ALIGN;
+
+static percpu_state percpu[SMP_MAX_CPUS];
+
+// Bumped whenever entropy is added to the global pool; a mismatch with a
+// cpu's generation forces a reseed on its next draw.  Starts out ahead
+// of the (zero-initialized) per-cpu states so the first draw on each cpu
+// seeds it from the pool if the init hook has not run yet.
+static volatile int pool_generation = 1;
+
+static bool NeedsReseed(const percpu_state* s, int gen) {
+    return s->generation != gen || s->drawn >= kReseedAfter;
+}
+
+// Emit |size| bytes from |s| and roll the key forward.  Must be called
+// with interrupts disabled on the cpu owning |s|.
+static void DrawFromState(percpu_state* s, void* out, size_t size) {
+    uint8_t stream[kKeySize + kMaxDrawLen];
+    // CRYPTO_chacha_20 XORs the cipher stream with the contents of the
+    // 'in' buffer; zero it to get just the cipher stream.
+    memset(stream, 0, kKeySize + size);
+
+    uint8_t nonce[12] = {};
+    memcpy(nonce, &s->nonce, sizeof(s->nonce));
+    ++s->nonce;
+
+    CRYPTO_chacha_20(stream, stream, kKeySize + size, s->key, nonce, 0);
+    memcpy(s->key, stream, kKeySize);
+    memcpy(out, stream + kKeySize, size);
+    memset(stream, 0, kKeySize + size);
+
+    s->drawn += size;
+}
+
+// Pre-seed every cpu's generator so the first draw on each cpu does not
+// have to visit the global pool.  The secondary cpus are not drawing
+// this early, so writing their state from here is safe.
+static void SeedAll(uint level) {
+    int gen = atomic_load(&pool_generation);
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        GlobalPRNG::GetInstance()->Draw(percpu[i].key, sizeof(percpu[i].key));
+        percpu[i].generation = gen;
+    }
+}
+
+void Draw(void* out, size_t size) {
+    DEBUG_ASSERT(out || size == 0);
+    ASSERT(size <= kMaxDrawLen);
+
+    uint8_t fresh[kKeySize] = {};
+    bool have_fresh = false;
+
+    for (;;) {
+        int gen = atomic_load(&pool_generation);
+
+        // If the cpu we happen to be on needs a reseed, pull key material
+        // from the global pool before pinning; drawing from the pool takes
+        // its mutex, which we cannot do with interrupts disabled.
+        if (!have_fresh && NeedsReseed(&percpu[arch_curr_cpu_num()], gen)) {
+            GlobalPRNG::GetInstance()->Draw(fresh, sizeof(fresh));
+            have_fresh = true;
+        }
+
+        spin_lock_saved_state_t state;
+        arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        // Now that we cannot migrate, re-resolve the state; it may belong
+        // to a different cpu than the one checked above.
+        percpu_state* s = &percpu[arch_curr_cpu_num()];
+        bool drawn = false;
+        if (NeedsReseed(s, gen)) {
+            if (have_fresh) {
+                // XOR the material in rather than replacing the key, so a
+                // reseed landing on an unexpected cpu never discards what
+                // that cpu's key already held.
+                for (size_t i = 0; i < kKeySize; i++) {
+                    s->key[i] ^= fresh[i];
+                }
+                s->nonce = 0;
+                s->drawn = 0;
+                s->generation = gen;
+                have_fresh = false;
+            }
+            // else: we migrated onto a stale cpu after deciding no material
+            // was needed; drop out and retry with material in hand.
+        }
+        if (s->generation == gen && s->drawn < kReseedAfter) {
+            DrawFromState(s, out, size);
+            drawn = true;
+        }
+
+        arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        if (drawn) {
+            break;
+        }
+    }
+
+    // Get rid of the stack copy of the key material
+    memset(fresh, 0, sizeof(fresh));
+}
+
+void NotifyEntropyAdded() {
+    atomic_add(&pool_generation, 1);
+}
+
+} // namespace PercpuPRNG
+
+} // namespace crypto
+
+LK_INIT_HOOK(percpu_prng_seed, crypto::PercpuPRNG::SeedAll,
+             LK_INIT_LEVEL_THREADING);
@@ -14,6 +14,8 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/global_prng_unittest.cpp \
     $(LOCAL_DIR)/hash.cpp \
     $(LOCAL_DIR)/hash_unittest.cpp \
+    $(LOCAL_DIR)/percpu_prng.cpp \
+    $(LOCAL_DIR)/percpu_prng_unittest.cpp \
     $(LOCAL_DIR)/prng.cpp \
     $(LOCAL_DIR)/prng_unittest.cpp
 
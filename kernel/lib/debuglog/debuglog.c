@@ -6,6 +6,8 @@
 
 #include <lib/debuglog.h>
 
+#include <arch/defines.h>
+#include <arch/ops.h>
 #include <err.h>
 #include <dev/udisplay.h>
 #include <kernel/spinlock.h>
@@ -24,13 +26,31 @@ static_assert((DLOG_SIZE & DLOG_MASK) == 0u, "must be power of two");
 static_assert(DLOG_MAX_RECORD <= DLOG_SIZE, "wat");
 static_assert((DLOG_MAX_RECORD & 3) == 0, "E_DONT_DO_THAT");
 
-static uint8_t DLOG_DATA[DLOG_SIZE];
+// The ring lives inside the export region so its live pages can be
+// aliased into read-only user mappings (see dlog_export_region).  The
+// header page mirrors the committed and tail positions; the mirrors
+// only ever move forward, so a reader that observes a committed mirror
+// value sees every record up to that position fully written.
+static struct {
+    dlog_export_header_t hdr;
+    uint8_t pad[PAGE_SIZE - sizeof(dlog_export_header_t)];
+    uint8_t data[DLOG_SIZE];
+} DLOG_EXPORT __ALIGNED(PAGE_SIZE) = {
+    .hdr = {
+        .magic = DLOG_EXPORT_MAGIC,
+        .version = DLOG_EXPORT_VERSION,
+        .data_offset = PAGE_SIZE,
+        .data_size = DLOG_SIZE,
+    },
+};
+
+static_assert(sizeof(dlog_export_header_t) <= PAGE_SIZE, "");
 
 static dlog_t DLOG = {
-    .lock = SPIN_LOCK_INITIAL_VALUE,
     .head = 0,
+    .committed = 0,
     .tail = 0,
-    .data = DLOG_DATA,
+    .data = DLOG_EXPORT.data,
     .event = EVENT_INITIAL_VALUE(DLOG.event, 0, EVENT_FLAG_AUTOUNSIGNAL),
 
     .readers_lock = MUTEX_INITIAL_VALUE(DLOG.readers_lock),
@@ -46,26 +66,53 @@ static dlog_t DLOG = {
 // or body may wrap but the initial header word never does).
 //
 // The ring buffer position is maintained by continuously incrementing
-// head and tail pointers (type size_t, so uint64_t on 64bit systems),
+// 64bit head, committed, and tail positions.
 //
 // This allows readers to trivial compute if their local tail
 // pointer has "fallen out" of the fifo (an entire fifo's worth
 // of messages were written since they last tried to read) and then
-// they can snap their tail to the global tail and restart
+// they can snap their tail to the current global tail and restart
 //
 //
 // Tail indicates the oldest message in the debug log to read
-// from, Head indicates the next space in the debug log to write
-// a new message to.  They are clipped to the actual buffer by
+// from, Head indicates the next space in the debug log to reserve
+// for a new message.  They are clipped to the actual buffer by
 // DLOG_MASK.
 //
 //       T                     T
 //  [....XXXX....]  [XX........XX]
 //           H         H
+//
+// Writers do not take a shared lock.  A writer reserves its region of
+// the fifo by first pushing the tail over old records until there is
+// room, then advancing head past the region with a compare-and-swap;
+// both only move forward, so the 64bit positions never suffer ABA.
+// Concurrent writers then fill their regions in parallel and publish
+// them in reservation order by advancing the committed position, each
+// waiting its turn.  Interrupts are disabled from reserve to commit so
+// a writer cannot be preempted while others wait behind it, which also
+// bounds the in-flight region to a few records per cpu.
+//
+// The tail is only ever pushed over committed records, so the record
+// header it points at is always parseable.  Readers consume committed
+// records without a lock and validate afterwards that the global tail
+// did not pass the record while they copied it; if it did, the copy
+// may be torn and they restart from the current tail.
 
 
 #define ALIGN4(n) (((n) + 3) & (~3))
 
+// Advance an exported position mirror to |pos|.  Writers race here in
+// commit order but the cmpxchg loses against a larger value, so a slow
+// writer can never drag a mirror backwards.  The cmpxchg is also a full
+// barrier, ordering the mirror update against the ring copies around it.
+static void dlog_export_update(uint64_t* mirror, uint64_t pos) {
+    uint64_t cur = atomic_load_u64(mirror);
+    while (((int64_t)(pos - cur) > 0) &&
+           !atomic_cmpxchg_u64(mirror, &cur, pos)) {
+    }
+}
+
 status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
     dlog_t* log = &DLOG;
 
@@ -97,17 +144,44 @@ status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
         hdr.tid = 0;
     }
 
+    // Interrupts stay off from reserve to commit so we cannot be preempted
+    // while later writers wait for our commit, and so a writer interrupted
+    // on this cpu cannot deadlock against our unfinished reservation.
     spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
 
-    // Discard records at tail until there is enough
-    // space for the new record.
-    while ((log->head - log->tail) > (DLOG_SIZE - wiresize)) {
-        uint32_t header = *((uint32_t*) (log->data + (log->tail & DLOG_MASK)));
-        log->tail += DLOG_HDR_GET_FIFOLEN(header);
+    // Reserve our region of the fifo: discard records at tail until there
+    // is enough space for the new record, then advance head over it.
+    uint64_t head = atomic_load_u64(&log->head);
+    for (;;) {
+        uint64_t tail = atomic_load_u64(&log->tail);
+        while ((head + wiresize - tail) > DLOG_SIZE) {
+            if (tail == atomic_load_u64(&log->committed)) {
+                // Everything between tail and head is still being written.
+                // Cannot happen unless the in-flight region grows to the
+                // whole fifo, but don't parse an uncommitted record if it
+                // somehow does; wait for a commit instead.
+                arch_spinloop_pause();
+                tail = atomic_load_u64(&log->tail);
+                continue;
+            }
+            uint32_t header = *((uint32_t*) (log->data + (tail & DLOG_MASK)));
+            // on failure the cmpxchg reloads tail and we re-check the space
+            atomic_cmpxchg_u64(&log->tail, &tail, tail + DLOG_HDR_GET_FIFOLEN(header));
+        }
+        // on failure the cmpxchg reloads head and we push the tail again
+        if (atomic_cmpxchg_u64(&log->head, &head, head + wiresize)) {
+            break;
+        }
     }
 
-    size_t offset = (log->head & DLOG_MASK);
+    // Mirror the tail before filling our region: a reader of the export
+    // region must be able to see that the records we are about to
+    // overwrite left the fifo before the overwrite starts, mirroring the
+    // tail-then-copy ordering kernel readers rely on.
+    dlog_export_update(&DLOG_EXPORT.hdr.tail, atomic_load_u64(&log->tail));
+
+    size_t offset = (head & DLOG_MASK);
 
     size_t fifospace = DLOG_SIZE - offset;
 
@@ -128,11 +202,22 @@ status_t dlog_write(uint32_t flags, const void* ptr, size_t len) {
         memcpy(log->data + offset, ptr, fifospace);
         memcpy(log->data, ptr + fifospace, len - fifospace);
     }
-    log->head += wiresize;
+
+    // Publish in reservation order: wait for earlier reservations to land,
+    // then advance committed over our record.  The cmpxchg is a full
+    // barrier, so our copies above are visible before the record is.
+    uint64_t expected = head;
+    while (!atomic_cmpxchg_u64(&log->committed, &expected, head + wiresize)) {
+        expected = head;
+        arch_spinloop_pause();
+    }
+
+    // Publish the record to export readers as well.
+    dlog_export_update(&DLOG_EXPORT.hdr.committed, head + wiresize);
 
     event_signal(&log->event, false);
 
-    spin_unlock_irqrestore(&log->lock, state);
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
 
     return NO_ERROR;
 }
@@ -146,26 +231,39 @@ status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, si
     }
 
     dlog_t* log = rdr->log;
-    status_t status = ERR_SHOULD_WAIT;
-
-    spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
 
-    size_t rtail = rdr->tail;
+    for (;;) {
+        uint64_t committed = atomic_load_u64(&log->committed);
+        uint64_t tail = atomic_load_u64(&log->tail);
+        uint64_t rtail = rdr->tail;
+
+        // If the read-tail is not within the range of log-tail..committed
+        // this reader has been lapped by a writer and we reset our read-tail
+        // to the current log-tail.
+        //
+        if ((committed - tail) < (committed - rtail)) {
+            rtail = tail;
+        }
 
-    // If the read-tail is not within the range of log-tail..log-head
-    // this reader has been lapped by a writer and we reset our read-tail
-    // to the current log-tail.
-    //
-    if ((log->head - log->tail) < (log->head - rtail)) {
-        rtail = log->tail;
-    }
+        if (rtail == committed) {
+            rdr->tail = rtail;
+            return ERR_SHOULD_WAIT;
+        }
 
-    if (rtail != log->head) {
         size_t offset = (rtail & DLOG_MASK);
-        uint32_t header = *((uint32_t*) (log->data + offset));
+        uint32_t header = *((volatile uint32_t*) (log->data + offset));
 
+        size_t fifolen = DLOG_HDR_GET_FIFOLEN(header);
         size_t actual = DLOG_HDR_GET_READLEN(header);
+
+        // If a writer lapped us between the loads above and here the header
+        // word may be mid-overwrite garbage; anything implausible means we
+        // go around again and snap forward to the new tail.
+        if ((fifolen < DLOG_MIN_RECORD) || (fifolen > DLOG_MAX_RECORD) ||
+            (fifolen & 3) || (actual < DLOG_MIN_RECORD) || (actual > fifolen)) {
+            continue;
+        }
+
         size_t fifospace = DLOG_SIZE - offset;
 
         if (fifospace >= actual) {
@@ -175,17 +273,18 @@ status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, si
             memcpy(ptr + fifospace, log->data, actual - fifospace);
         }
 
-        *_actual = actual;
-        status = NO_ERROR;
+        // If the global tail passed the start of this record while we were
+        // copying it, a writer may have been overwriting it and the copy
+        // can be torn; retry from the current tail.
+        smp_rmb();
+        if ((int64_t) (atomic_load_u64(&log->tail) - rtail) > 0) {
+            continue;
+        }
 
-        rtail += DLOG_HDR_GET_FIFOLEN(header);
+        rdr->tail = rtail + fifolen;
+        *_actual = actual;
+        return NO_ERROR;
     }
-
-    rdr->tail = rtail;
-
-    spin_unlock_irqrestore(&log->lock, state);
-
-    return status;
 }
 
 void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie) {
@@ -198,13 +297,8 @@ void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie) {
     mutex_acquire(&log->readers_lock);
     list_add_tail(&log->readers, &rdr->node);
 
-    bool do_notify = false;
-
-    spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
-    rdr->tail = log->tail;
-    do_notify = (log->tail != log->head);
-    spin_unlock_irqrestore(&log->lock, state);
+    rdr->tail = atomic_load_u64(&log->tail);
+    bool do_notify = (rdr->tail != atomic_load_u64(&log->committed));
 
     // simulate notify callback for events that arrived
     // before we were initialized
@@ -223,6 +317,28 @@ void dlog_reader_destroy(dlog_reader_t* rdr) {
     mutex_release(&log->readers_lock);
 }
 
+status_t dlog_reader_advance(dlog_reader_t* rdr, uint64_t pos) {
+    dlog_t* log = rdr->log;
+
+    // The cursor only moves forward and never past the committed
+    // position; a reader that was lapped while consuming in place snaps
+    // forward the same way dlog_read does, on its next read or advance.
+    uint64_t committed = atomic_load_u64(&log->committed);
+    if ((int64_t)(pos - committed) > 0) {
+        pos = committed;
+    }
+    if ((int64_t)(pos - rdr->tail) > 0) {
+        rdr->tail = pos;
+    }
+
+    return (rdr->tail == committed) ? ERR_SHOULD_WAIT : NO_ERROR;
+}
+
+const void* dlog_export_region(size_t* size) {
+    *size = sizeof(DLOG_EXPORT);
+    return &DLOG_EXPORT;
+}
+
 
 // The debuglog notifier thread observes when the debuglog is
 // written and calls the notify callback on any readers that
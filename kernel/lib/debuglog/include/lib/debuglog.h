@@ -36,10 +36,17 @@ typedef struct dlog_record dlog_record_t;
 typedef struct dlog_reader dlog_reader_t;
 
 struct dlog {
-    spin_lock_t lock;
-
-    size_t head;
-    size_t tail;
+    // Continuously incrementing byte positions into the ring, all
+    // manipulated with atomics; see debuglog.c for the write protocol.
+    //
+    //   tail <= committed <= head
+    //
+    // head is the reservation point for the next writer, committed is how
+    // far fully written records extend, and tail is the oldest record not
+    // yet overwritten.  Readers consume [their cursor, committed).
+    uint64_t head;
+    uint64_t committed;
+    uint64_t tail;
 
     void* data;
 
@@ -55,7 +62,7 @@ struct dlog_reader {
     struct list_node node;
 
     dlog_t* log;
-    size_t tail;
+    uint64_t tail;
 
     void (*notify)(void* cookie);
     void *cookie;
@@ -88,11 +95,37 @@ struct dlog_record {
 static_assert(sizeof(dlog_header_t) == DLOG_MIN_RECORD, "");
 static_assert(sizeof(dlog_record_t) == DLOG_MAX_RECORD, "");
 
+// The ring is exported to userspace as a read-only VMO: one header page
+// carrying mirrored ring positions, followed by the record data.  This
+// layout must match mx_log_ring_header_t in magenta/syscalls/log.h (the
+// same way dlog_header_t matches mx_log_record_t).
+typedef struct dlog_export_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t data_offset;
+    uint64_t data_size;
+    uint64_t reserved;
+    uint64_t committed;
+    uint64_t tail;
+} dlog_export_header_t;
+
+#define DLOG_EXPORT_MAGIC        (0x646c6f6772696e67ULL)
+#define DLOG_EXPORT_VERSION      (1u)
+
 void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie);
 void dlog_reader_destroy(dlog_reader_t* rdr);
 status_t dlog_write(uint32_t flags, const void* ptr, size_t len);
 status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* ptr, size_t len, size_t* actual);
 
+// Advance a reader's cursor without copying records out, for readers that
+// consume the ring in place through the export region.  Returns
+// ERR_SHOULD_WAIT if the reader is caught up after the advance.
+status_t dlog_reader_advance(dlog_reader_t* rdr, uint64_t pos);
+
+// Return the export region (header page plus ring data, page aligned) so
+// it can be wrapped in a VMO and mapped read-only by log readers.
+const void* dlog_export_region(size_t* size);
+
 // bluescreen_init should be called at the "start" of a fatal fault or
 // panic to ensure that the fault output (via kernel printf/dprintf)
 // is captured or displayed to the user
@@ -8,32 +8,51 @@
 #include <assert.h>
 #include <err.h>
 #include <list.h>
+#include <stdio.h>
 #include <trace.h>
 
+#include <arch/ops.h>
 #include <kernel/event.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <lk/init.h>
 
-static spin_lock_t dpc_lock = SPIN_LOCK_INITIAL_VALUE;
-static struct list_node dpc_list = LIST_INITIAL_VALUE(dpc_list);
-static event_t dpc_event = EVENT_INITIAL_VALUE(dpc_event, false, 0);
+/* two bands per cpu: low latency dpcs always run before bulk ones */
+#define DPC_BAND_LOW_LATENCY 0
+#define DPC_BAND_BULK 1
+#define DPC_NUM_BANDS 2
 
-status_t dpc_queue(dpc_t *dpc, bool reschedule)
+/* each cpu has its own dpc state and a worker thread pinned to it, so
+ * queueing and running dpcs never bounces work across cpus */
+struct dpc_state {
+    spin_lock_t lock;
+    struct list_node list[DPC_NUM_BANDS];
+    event_t event;
+} __CPU_ALIGN;
+
+static struct dpc_state dpc_state[SMP_MAX_CPUS];
+
+static status_t dpc_queue_band(dpc_t *dpc, uint band, bool reschedule)
 {
     DEBUG_ASSERT(dpc);
     DEBUG_ASSERT(dpc->func);
+    DEBUG_ASSERT(band < DPC_NUM_BANDS);
 
     if (list_in_list(&dpc->node))
         return NO_ERROR;
 
     spin_lock_saved_state_t state;
-    spin_lock_irqsave(&dpc_lock, state);
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
 
-    // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&dpc_list, &dpc->node);
-    event_signal(&dpc_event, false);
+    /* queue on the current cpu; the local worker will pick it up */
+    struct dpc_state *ds = &dpc_state[arch_curr_cpu_num()];
 
-    spin_unlock_irqrestore(&dpc_lock, state);
+    spin_lock(&ds->lock);
+    list_add_tail(&ds->list[band], &dpc->node);
+    event_signal(&ds->event, false);
+    spin_unlock(&ds->lock);
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
 
     // reschedule here if asked to
     if (reschedule)
@@ -42,38 +61,71 @@ status_t dpc_queue(dpc_t *dpc, bool reschedule)
     return NO_ERROR;
 }
 
+status_t dpc_queue(dpc_t *dpc, bool reschedule)
+{
+    return dpc_queue_band(dpc, DPC_BAND_BULK, reschedule);
+}
+
+status_t dpc_queue_low_latency(dpc_t *dpc, bool reschedule)
+{
+    return dpc_queue_band(dpc, DPC_BAND_LOW_LATENCY, reschedule);
+}
+
 static int dpc_thread(void *arg)
 {
+    struct dpc_state *ds = arg;
+
     for (;;) {
         // wait for a dpc to fire
-        __UNUSED status_t err = event_wait(&dpc_event);
+        __UNUSED status_t err = event_wait(&ds->event);
         DEBUG_ASSERT(err == NO_ERROR);
 
         spin_lock_saved_state_t state;
-        spin_lock_irqsave(&dpc_lock, state);
+        spin_lock_irqsave(&ds->lock, state);
 
-        // pop a dpc off the list
-        dpc_t *dpc = list_remove_head_type(&dpc_list, dpc_t, node);
+        // pop a dpc off the highest band with work pending
+        dpc_t *dpc = list_remove_head_type(&ds->list[DPC_BAND_LOW_LATENCY], dpc_t, node);
+        if (!dpc)
+            dpc = list_remove_head_type(&ds->list[DPC_BAND_BULK], dpc_t, node);
 
-        // if the list is now empty, unsignal the event so we block until it is
+        // if both lists are now empty, unsignal the event so we block until there's work
         if (!dpc)
-            event_unsignal(&dpc_event);
+            event_unsignal(&ds->event);
 
-        spin_unlock_irqrestore(&dpc_lock, state);
+        spin_unlock_irqrestore(&ds->lock, state);
 
         // call the dpc
         if (dpc && dpc->func)
             dpc->func(dpc);
     }
 
-
     return 0;
 }
 
+static void dpc_init_early(unsigned int level)
+{
+    /* queues must be usable before the worker threads exist, since dpcs can
+     * be queued during early driver init and drained once threading is up */
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        struct dpc_state *ds = &dpc_state[cpu];
+
+        ds->lock = SPIN_LOCK_INITIAL_VALUE;
+        for (uint band = 0; band < DPC_NUM_BANDS; band++)
+            list_initialize(&ds->list[band]);
+        event_init(&ds->event, false, 0);
+    }
+}
+
 static void dpc_init(unsigned int level)
 {
-    thread_t *t = thread_create("dpc", &dpc_thread, NULL, HIGH_PRIORITY, DEFAULT_STACK_SIZE);
-    thread_detach_and_resume(t);
+    for (uint cpu = 0; cpu < arch_max_num_cpus(); cpu++) {
+        char name[16];
+        snprintf(name, sizeof(name), "dpc-%u", cpu);
+        thread_t *t = thread_create(name, &dpc_thread, &dpc_state[cpu], HIGH_PRIORITY, DEFAULT_STACK_SIZE);
+        thread_set_pinned_cpu(t, (int)cpu);
+        thread_detach_and_resume(t);
+    }
 }
 
+LK_INIT_HOOK(dpc_early, dpc_init_early, LK_INIT_LEVEL_EARLIEST);
 LK_INIT_HOOK(dpc, dpc_init, LK_INIT_LEVEL_THREADING);
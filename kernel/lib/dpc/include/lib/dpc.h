@@ -21,7 +21,10 @@ typedef struct dpc {
     void *arg;
 } dpc_t;
 
+/* dpcs are queued on the calling cpu and run by a worker thread pinned to
+ * that cpu, in two bands: low latency dpcs (interrupt completion work) are
+ * always drained before bulk dpcs (background cleanup). */
 status_t dpc_queue(dpc_t *dpc, bool reschedule);
+status_t dpc_queue_low_latency(dpc_t *dpc, bool reschedule);
 
 __END_CDECLS
-
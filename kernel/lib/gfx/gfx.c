@@ -172,38 +172,30 @@ static void putpixel8(gfx_surface *surface, uint x, uint y, uint color)
     *dest = (uint8_t)(surface->translate_color(color));
 }
 
-static void copyrect8(gfx_surface *surface, uint x, uint y, uint width, uint height, uint x2, uint y2)
+static void copyrect(gfx_surface *surface, uint x, uint y, uint width, uint height, uint x2, uint y2)
 {
-    // copy
-    const uint8_t *src = &((const uint8_t *)surface->ptr)[x + y * surface->stride];
-    uint8_t *dest = &((uint8_t *)surface->ptr)[x2 + y2 * surface->stride];
-    uint stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+    // copy a row at a time; works for any pixel size
+    const uint ps = surface->pixelsize;
+    const size_t rowbytes = (size_t)width * ps;
+    const size_t stridebytes = (size_t)surface->stride * ps;
+    const uint8_t *src = (const uint8_t *)surface->ptr + x * ps + y * stridebytes;
+    uint8_t *dest = (uint8_t *)surface->ptr + x2 * ps + y2 * stridebytes;
+
+    if (dest <= src) {
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest += stridebytes;
+            src += stridebytes;
         }
     } else {
-        // copy backwards
-        src += height * surface->stride + width;
-        dest += height * surface->stride + width;
-
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        // start from the last row so overlapping rows are read before
+        // they are written
+        src += (height - 1) * stridebytes;
+        dest += (height - 1) * stridebytes;
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest -= stridebytes;
+            src -= stridebytes;
         }
     }
 }
@@ -211,121 +203,44 @@ static void copyrect8(gfx_surface *surface, uint x, uint y, uint width, uint hei
 static void fillrect8(gfx_surface *surface, uint x, uint y, uint width, uint height, uint color)
 {
     uint8_t *dest = &((uint8_t *)surface->ptr)[x + y * surface->stride];
-    uint stride_diff = surface->stride - width;
 
     uint8_t color8 = (uint8_t)(surface->translate_color(color));
 
-    uint i, j;
-    for (i=0; i < height; i++) {
-        for (j=0; j < width; j++) {
-            *dest = color8;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect16(gfx_surface *surface, uint x, uint y, uint width, uint height, uint x2, uint y2)
-{
-    // copy
-    const uint16_t *src = &((const uint16_t *)surface->ptr)[x + y * surface->stride];
-    uint16_t *dest = &((uint16_t *)surface->ptr)[x2 + y2 * surface->stride];
-    uint stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += height * surface->stride + width;
-        dest += height * surface->stride + width;
-
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    for (uint i = 0; i < height; i++) {
+        memset(dest, color8, width);
+        dest += surface->stride;
     }
 }
 
 static void fillrect16(gfx_surface *surface, uint x, uint y, uint width, uint height, uint color)
 {
     uint16_t *dest = &((uint16_t *)surface->ptr)[x + y * surface->stride];
-    uint stride_diff = surface->stride - width;
 
     uint16_t color16 = (uint16_t)(surface->translate_color(color));
 
-    uint i, j;
-    for (i=0; i < height; i++) {
-        for (j=0; j < width; j++) {
-            *dest = color16;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect32(gfx_surface *surface, uint x, uint y, uint width, uint height, uint x2, uint y2)
-{
-    // copy
-    const uint32_t *src = &((const uint32_t *)surface->ptr)[x + y * surface->stride];
-    uint32_t *dest = &((uint32_t *)surface->ptr)[x2 + y2 * surface->stride];
-    uint stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += height * surface->stride + width;
-        dest += height * surface->stride + width;
+    // render the first row a pixel at a time, then replicate it downward
+    for (uint j = 0; j < width; j++)
+        dest[j] = color16;
 
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    uint16_t *row = dest;
+    for (uint i = 1; i < height; i++) {
+        row += surface->stride;
+        memcpy(row, dest, width * sizeof(uint16_t));
     }
 }
 
 static void fillrect32(gfx_surface *surface, uint x, uint y, uint width, uint height, uint color)
 {
     uint32_t *dest = &((uint32_t *)surface->ptr)[x + y * surface->stride];
-    uint stride_diff = surface->stride - width;
 
-    uint i, j;
-    for (i=0; i < height; i++) {
-        for (j=0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    // render the first row a pixel at a time, then replicate it downward
+    for (uint j = 0; j < width; j++)
+        dest[j] = color;
+
+    uint32_t *row = dest;
+    for (uint i = 1; i < height; i++) {
+        row += surface->stride;
+        memcpy(row, dest, width * sizeof(uint32_t));
     }
 }
 
@@ -447,20 +362,13 @@ void gfx_surface_blend(struct gfx_surface *target, struct gfx_surface *source, u
         // 16 bit to 16 bit
         const uint16_t *src = (const uint16_t *)source->ptr;
         uint16_t *dest = &((uint16_t *)target->ptr)[destx + desty * target->stride];
-        uint dest_stride_diff = target->stride - width;
-        uint source_stride_diff = source->stride - width;
 
-        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
+        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, target->stride, source->stride);
 
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (uint i = 0; i < height; i++) {
+            memcpy(dest, src, width * sizeof(uint16_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == GFX_FORMAT_ARGB_8888 && target->format == GFX_FORMAT_ARGB_8888) {
         // both are 32 bit modes, both alpha
@@ -486,39 +394,25 @@ void gfx_surface_blend(struct gfx_surface *target, struct gfx_surface *source, u
         // both are 32 bit modes, no alpha
         const uint32_t *src = (const uint32_t *)source->ptr;
         uint32_t *dest = &((uint32_t *)target->ptr)[destx + desty * target->stride];
-        uint dest_stride_diff = target->stride - width;
-        uint source_stride_diff = source->stride - width;
 
-        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
+        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, target->stride, source->stride);
 
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (uint i = 0; i < height; i++) {
+            memcpy(dest, src, width * sizeof(uint32_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == GFX_FORMAT_MONO && target->format == GFX_FORMAT_MONO) {
         // both are 8 bit modes, no alpha
         const uint8_t *src = (const uint8_t *)source->ptr;
         uint8_t *dest = &((uint8_t *)target->ptr)[destx + desty * target->stride];
-        uint dest_stride_diff = target->stride - width;
-        uint source_stride_diff = source->stride - width;
 
-        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
+        LTRACEF("w %u h %u dstride %u sstride %u\n", width, height, target->stride, source->stride);
 
-        uint i, j;
-        for (i=0; i < height; i++) {
-            for (j=0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (uint i = 0; i < height; i++) {
+            memcpy(dest, src, width);
+            dest += target->stride;
+            src += source->stride;
         }
     } else {
         panic("gfx_surface_blend: unimplemented colorspace combination (source %u target %u)\n", source->format, target->format);
@@ -594,7 +488,7 @@ int gfx_init_surface(gfx_surface *surface, void *ptr, uint width, uint height, u
     switch (format) {
         case GFX_FORMAT_RGB_565:
             surface->translate_color = &ARGB8888_to_RGB565;
-            surface->copyrect = &copyrect16;
+            surface->copyrect = &copyrect;
             surface->fillrect = &fillrect16;
             surface->putpixel = &putpixel16;
             surface->pixelsize = 2;
@@ -603,7 +497,7 @@ int gfx_init_surface(gfx_surface *surface, void *ptr, uint width, uint height, u
         case GFX_FORMAT_RGB_x888:
         case GFX_FORMAT_ARGB_8888:
             surface->translate_color = NULL;
-            surface->copyrect = &copyrect32;
+            surface->copyrect = &copyrect;
             surface->fillrect = &fillrect32;
             surface->putpixel = &putpixel32;
             surface->pixelsize = 4;
@@ -611,7 +505,7 @@ int gfx_init_surface(gfx_surface *surface, void *ptr, uint width, uint height, u
             break;
         case GFX_FORMAT_MONO:
             surface->translate_color = &ARGB8888_to_Luma;
-            surface->copyrect = &copyrect8;
+            surface->copyrect = &copyrect;
             surface->fillrect = &fillrect8;
             surface->putpixel = &putpixel8;
             surface->pixelsize = 1;
@@ -619,7 +513,7 @@ int gfx_init_surface(gfx_surface *surface, void *ptr, uint width, uint height, u
             break;
         case GFX_FORMAT_RGB_332:
             surface->translate_color = &ARGB8888_to_RGB332;
-            surface->copyrect = &copyrect8;
+            surface->copyrect = &copyrect;
             surface->fillrect = &fillrect8;
             surface->putpixel = &putpixel8;
             surface->pixelsize = 1;
@@ -627,7 +521,7 @@ int gfx_init_surface(gfx_surface *surface, void *ptr, uint width, uint height, u
             break;
         case GFX_FORMAT_RGB_2220:
             surface->translate_color = &ARGB8888_to_RGB2220;
-            surface->copyrect = &copyrect8;
+            surface->copyrect = &copyrect;
             surface->fillrect = &fillrect8;
             surface->putpixel = &putpixel8;
             surface->pixelsize = 1;
@@ -53,17 +53,37 @@ static struct {
 
     uint x, y;
 
+    // text rows are stored as a ring in the backing surface so that
+    // scrolling is a row-offset bump instead of a full-surface copy.
+    // yoff is the physical row that logical row 0 lives in; it is only
+    // ever nonzero when drawing to a backing surface, since a surface
+    // being scanned out directly must stay in display order.
+    uint yoff;
+
     uint32_t front_color;
     uint32_t back_color;
 } gfxconsole;
 
+// map a logical text row to the physical row it is stored in
+static uint phys_row(uint y)
+{
+    uint row = y + gfxconsole.yoff;
+    if (row >= gfxconsole.rows)
+        row -= gfxconsole.rows;
+    return row;
+}
+
 static void draw_char(char c)
 {
-    font_draw_char(gfxconsole.surface, c, gfxconsole.x * FONT_X, gfxconsole.y * FONT_Y,
+    font_draw_char(gfxconsole.surface, c, gfxconsole.x * FONT_X, phys_row(gfxconsole.y) * FONT_Y,
                    gfxconsole.front_color, gfxconsole.back_color);
 }
 
 void gfxconsole_putpixel(unsigned x, unsigned y, unsigned color) {
+    // translate display coordinates through the scroll ring
+    uint row = y / FONT_Y;
+    if (row < gfxconsole.rows)
+        y = phys_row(row) * FONT_Y + (y % FONT_Y);
     gfx_putpixel(gfxconsole.surface, x, y, color);
 }
 
@@ -122,15 +142,25 @@ static bool gfxconsole_putc(char c)
         inval = 1;
     }
     if (gfxconsole.y >= gfxconsole.rows) {
-        // scroll up
-        gfx_copyrect(gfxconsole.surface, 0, FONT_Y, gfxconsole.surface->width,
-                     gfxconsole.surface->height - FONT_Y - gfxconsole.extray, 0, 0);
         gfxconsole.y--;
-
-        // clear the bottom line
-        gfx_fillrect(gfxconsole.surface, 0, gfxconsole.surface->height - FONT_Y - gfxconsole.extray,
-                     gfxconsole.surface->width, FONT_Y, gfxconsole.back_color);
-        gfx_flush(gfxconsole.surface);
+        if (gfxconsole.surface != gfxconsole.hw_surface) {
+            // rotate the ring: the old top row becomes the new bottom row,
+            // so scrolling only costs clearing one line.  the blit to the
+            // hardware surface puts the rows back in display order.
+            gfxconsole.yoff = phys_row(1);
+            gfx_fillrect(gfxconsole.surface, 0, phys_row(gfxconsole.y) * FONT_Y,
+                         gfxconsole.surface->width, FONT_Y, gfxconsole.back_color);
+        } else {
+            // drawing straight to the scanout surface; memory order must
+            // match display order, so scroll the pixels up
+            gfx_copyrect(gfxconsole.surface, 0, FONT_Y, gfxconsole.surface->width,
+                         gfxconsole.surface->height - FONT_Y - gfxconsole.extray, 0, 0);
+
+            // clear the bottom line
+            gfx_fillrect(gfxconsole.surface, 0, gfxconsole.surface->height - FONT_Y - gfxconsole.extray,
+                         gfxconsole.surface->width, FONT_Y, gfxconsole.back_color);
+            gfx_flush(gfxconsole.surface);
+        }
         inval = 1;
     }
     return inval;
@@ -148,13 +178,29 @@ static void gfxconsole_print_callback(print_callback_t *cb, const char *str, siz
     // blit from the software surface to the hardware
     if (gfxconsole.surface != gfxconsole.hw_surface) {
         if (refresh_full_screen) {
-            gfx_surface_blend(gfxconsole.hw_surface, gfxconsole.surface, 0, 0);
+            if (gfxconsole.yoff == 0) {
+                gfx_surface_blend(gfxconsole.hw_surface, gfxconsole.surface, 0, 0);
+            } else {
+                // the rows live in a ring in the backing surface; blit the
+                // two bands so they land in display order
+                gfxconsole.line.ptr = ((uint8_t*) gfxconsole.surface->ptr) +
+                    (gfxconsole.yoff * gfxconsole.linestride);
+                gfxconsole.line.height = (gfxconsole.rows - gfxconsole.yoff) * FONT_Y;
+                gfx_surface_blend(gfxconsole.hw_surface, &gfxconsole.line, 0, 0);
+
+                gfxconsole.line.ptr = gfxconsole.surface->ptr;
+                gfxconsole.line.height = gfxconsole.yoff * FONT_Y;
+                gfx_surface_blend(gfxconsole.hw_surface, &gfxconsole.line,
+                    0, (gfxconsole.rows - gfxconsole.yoff) * FONT_Y);
+
+                gfxconsole.line.height = FONT_Y;
+            }
         } else {
             // Only re-blit the active console line.
             // Since blend only works in whole surfaces, configure a sub-surface
             // to use as the blend source.
             gfxconsole.line.ptr = ((uint8_t*) gfxconsole.surface->ptr) +
-                (gfxconsole.y * gfxconsole.linestride);
+                (phys_row(gfxconsole.y) * gfxconsole.linestride);
             gfx_surface_blend(gfxconsole.hw_surface, &gfxconsole.line,
                 0, gfxconsole.y * FONT_Y);
         }
@@ -193,6 +239,7 @@ static void gfxconsole_clear(bool crash_console)
     // start in the upper left
     gfxconsole.x = 0;
     gfxconsole.y = 0;
+    gfxconsole.yoff = 0;
 
     if (crash_console) {
         gfxconsole.front_color = CRASH_TEXT_COLOR;
@@ -862,6 +862,15 @@ void cmpct_free(void *payload)
     unlock();
 }
 
+size_t cmpct_usable_size(void *payload)
+{
+    // No lock needed: the size of an allocated area only changes when it is
+    // freed, and the caller has to own the allocation to ask about it.
+    header_t *header = (header_t *)payload - 1;
+    DEBUG_ASSERT(!is_tagged_as_free(header));
+    return header->size - sizeof(header_t);
+}
+
 void *cmpct_realloc(void *payload, size_t size)
 {
     if (payload == NULL) return cmpct_alloc(size);
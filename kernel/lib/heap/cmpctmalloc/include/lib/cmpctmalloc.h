@@ -15,6 +15,7 @@ void *cmpct_alloc(size_t);
 void *cmpct_realloc(void *, size_t);
 void cmpct_free(void *);
 void *cmpct_memalign(size_t size, size_t alignment);
+size_t cmpct_usable_size(void *);
 
 void cmpct_init(void);
 void cmpct_dump(bool panic_time);
@@ -0,0 +1,294 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/heap_profile.h>
+
+#include <arch/ops.h>
+#include <assert.h>
+#include <debug.h>
+#include <err.h>
+#include <inttypes.h>
+#include <kernel/spinlock.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Sampled allocation-site accounting, designed so it can stay compiled into
+ * production kernels: the tables are allocated on first enable, sampling
+ * bounds the tracking cost, and every table operation is a short O(1)
+ * critical section under one spinlock.
+ *
+ * Two open-addressed hash tables, both linearly probed and kept under
+ * three quarters full so probes stay short:
+ *  - sites:  call site -> scaled live/total statistics
+ *  - allocs: tracked pointer -> its site and the bytes charged to it,
+ *            so a later free can be attributed without touching the block
+ */
+
+#define PROFILE_SITES 512u
+#define PROFILE_ALLOCS 4096u
+#define PROFILE_ALLOCS_MAX ((PROFILE_ALLOCS / 4u) * 3u)
+
+#define PROFILE_DEFAULT_RATE 64u
+
+typedef struct profile_site {
+    void *caller;          /* NULL if the slot is unused */
+    uint64_t live_bytes;
+    uint64_t live_count;
+    uint64_t total_count;
+} profile_site_t;
+
+typedef struct profile_alloc {
+    void *ptr;             /* NULL if the slot is unused */
+    uint32_t site;
+    uint32_t rate;         /* sampling rate the allocation was charged at */
+    uint64_t bytes;        /* bytes charged to the site (size * rate) */
+} profile_alloc_t;
+
+bool heap_profile_on = false;
+volatile int heap_profile_tracked = 0;
+
+static spin_lock_t profile_lock = SPIN_LOCK_INITIAL_VALUE;
+static profile_site_t *sites;
+static profile_alloc_t *allocs;
+static uint32_t sample_rate = PROFILE_DEFAULT_RATE;
+static volatile int sample_countdown = 1;
+static uint32_t alloc_entries;
+static uint64_t dropped_samples;
+
+static inline uint32_t hash_ptr(const void *ptr, uint32_t mask)
+{
+    return (uint32_t)(((uintptr_t)ptr >> 3) * 2654435761u) & mask;
+}
+
+/* find or create the site entry for caller, NULL if the table is full */
+static profile_site_t *site_lookup(void *caller)
+{
+    uint32_t idx = hash_ptr(caller, PROFILE_SITES - 1);
+    for (uint32_t probe = 0; probe < PROFILE_SITES; probe++) {
+        profile_site_t *site = &sites[idx];
+        if (site->caller == caller)
+            return site;
+        if (site->caller == NULL) {
+            site->caller = caller;
+            return site;
+        }
+        idx = (idx + 1) & (PROFILE_SITES - 1);
+    }
+    return NULL;
+}
+
+static bool alloc_insert(void *ptr, uint32_t site, uint64_t bytes)
+{
+    if (alloc_entries >= PROFILE_ALLOCS_MAX)
+        return false;
+
+    uint32_t idx = hash_ptr(ptr, PROFILE_ALLOCS - 1);
+    while (allocs[idx].ptr != NULL) {
+        DEBUG_ASSERT(allocs[idx].ptr != ptr);
+        idx = (idx + 1) & (PROFILE_ALLOCS - 1);
+    }
+    allocs[idx].ptr = ptr;
+    allocs[idx].site = site;
+    allocs[idx].rate = sample_rate;
+    allocs[idx].bytes = bytes;
+    alloc_entries++;
+    return true;
+}
+
+/* Delete by sliding later entries of the probe cluster back over the hole
+ * (Knuth 6.4 algorithm R), so no tombstones accumulate in the table. */
+static void alloc_remove(uint32_t hole)
+{
+    uint32_t cur = hole;
+    for (;;) {
+        cur = (cur + 1) & (PROFILE_ALLOCS - 1);
+        if (allocs[cur].ptr == NULL)
+            break;
+        uint32_t home = hash_ptr(allocs[cur].ptr, PROFILE_ALLOCS - 1);
+        /* leave the entry alone if its home slot lies (cyclically) after
+         * the hole; it is still reachable from there */
+        bool reachable = (hole <= cur)
+                ? (home > hole && home <= cur)
+                : (home > hole || home <= cur);
+        if (!reachable) {
+            allocs[hole] = allocs[cur];
+            hole = cur;
+        }
+    }
+    memset(&allocs[hole], 0, sizeof(allocs[hole]));
+    alloc_entries--;
+}
+
+void _heap_profile_alloc(void *ptr, size_t size, void *caller)
+{
+    /* cheap shared countdown; sampling only has to be approximate */
+    if (atomic_add_relaxed(&sample_countdown, -1) != 1)
+        return;
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+
+    /* recheck under the lock; a racing disable leaves the countdown alone */
+    if (likely(heap_profile_on)) {
+        sample_countdown = (int)sample_rate;
+
+        uint64_t bytes = (uint64_t)size * sample_rate;
+        profile_site_t *site = site_lookup(caller);
+        if (site == NULL || !alloc_insert(ptr, (uint32_t)(site - sites), bytes)) {
+            dropped_samples++;
+        } else {
+            site->live_bytes += bytes;
+            site->live_count += sample_rate;
+            site->total_count += sample_rate;
+            heap_profile_tracked++;
+        }
+    }
+
+    spin_unlock_irqrestore(&profile_lock, state);
+}
+
+void _heap_profile_free(void *ptr)
+{
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+
+    if (allocs != NULL) {
+        uint32_t idx = hash_ptr(ptr, PROFILE_ALLOCS - 1);
+        while (allocs[idx].ptr != NULL) {
+            if (allocs[idx].ptr == ptr) {
+                profile_site_t *site = &sites[allocs[idx].site];
+                site->live_bytes -= allocs[idx].bytes;
+                site->live_count -= allocs[idx].rate;
+                alloc_remove(idx);
+                heap_profile_tracked--;
+                break;
+            }
+            idx = (idx + 1) & (PROFILE_ALLOCS - 1);
+        }
+    }
+
+    spin_unlock_irqrestore(&profile_lock, state);
+}
+
+status_t heap_profile_enable(uint32_t rate)
+{
+    if (rate == 0)
+        rate = PROFILE_DEFAULT_RATE;
+
+    /* The tables are allocated on first use and kept afterwards; profiling
+     * is still off at this point, so they are not themselves tracked. */
+    profile_site_t *s = NULL;
+    profile_alloc_t *a = NULL;
+    if (sites == NULL) {
+        s = calloc(PROFILE_SITES, sizeof(*s));
+        a = calloc(PROFILE_ALLOCS, sizeof(*a));
+        if (s == NULL || a == NULL) {
+            free(s);
+            free(a);
+            return ERR_NO_MEMORY;
+        }
+    }
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+    if (sites == NULL) {
+        sites = s;
+        allocs = a;
+        s = NULL;
+        a = NULL;
+    }
+    sample_rate = rate;
+    sample_countdown = 1;  /* sample the next allocation */
+    heap_profile_on = true;
+    spin_unlock_irqrestore(&profile_lock, state);
+
+    /* lost the (unlikely) race to install the tables */
+    free(s);
+    free(a);
+    return NO_ERROR;
+}
+
+void heap_profile_disable(void)
+{
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+    heap_profile_on = false;
+    spin_unlock_irqrestore(&profile_lock, state);
+}
+
+void heap_profile_reset(void)
+{
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+    if (sites != NULL) {
+        memset(sites, 0, PROFILE_SITES * sizeof(*sites));
+        memset(allocs, 0, PROFILE_ALLOCS * sizeof(*allocs));
+    }
+    alloc_entries = 0;
+    dropped_samples = 0;
+    heap_profile_tracked = 0;
+    spin_unlock_irqrestore(&profile_lock, state);
+}
+
+size_t heap_profile_snapshot(heap_profile_record_t *records, size_t max,
+                             size_t *avail)
+{
+    size_t count = 0;
+    size_t total = 0;
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&profile_lock, state);
+    if (sites != NULL) {
+        for (uint32_t i = 0; i < PROFILE_SITES; i++) {
+            if (sites[i].caller == NULL || sites[i].total_count == 0)
+                continue;
+            total++;
+            if (count < max) {
+                records[count].caller = (uint64_t)(uintptr_t)sites[i].caller;
+                records[count].live_bytes = sites[i].live_bytes;
+                records[count].live_count = sites[i].live_count;
+                records[count].total_count = sites[i].total_count;
+                count++;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&profile_lock, state);
+
+    if (avail != NULL)
+        *avail = total;
+    return count;
+}
+
+void heap_profile_dump(void)
+{
+    if (sites == NULL) {
+        printf("heap profiling has never been enabled\n");
+        return;
+    }
+
+    /* snapshot first so the console output happens outside the lock */
+    heap_profile_record_t *records = malloc(PROFILE_SITES * sizeof(*records));
+    if (records == NULL) {
+        printf("cannot allocate snapshot buffer\n");
+        return;
+    }
+    size_t count = heap_profile_snapshot(records, PROFILE_SITES, NULL);
+
+    printf("heap profile: %s, sampling 1 in %u, %d tracked allocations, "
+           "%" PRIu64 " dropped samples\n",
+           heap_profile_on ? "on" : "off", sample_rate,
+           heap_profile_tracked, dropped_samples);
+    printf("%18s %16s %12s %12s\n",
+           "caller", "live bytes", "live count", "total count");
+    for (size_t i = 0; i < count; i++) {
+        printf("%#18" PRIx64 " %16" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+               records[i].caller, records[i].live_bytes,
+               records[i].live_count, records[i].total_count);
+    }
+
+    free(records);
+}
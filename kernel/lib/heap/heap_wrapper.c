@@ -15,8 +15,10 @@
 #include <err.h>
 #include <list.h>
 #include <arch/ops.h>
+#include <kernel/mp.h>
 #include <kernel/spinlock.h>
 #include <lib/console.h>
+#include <lib/heap_profile.h>
 #include <lib/page_alloc.h>
 
 #define LOCAL_TRACE 0
@@ -115,6 +117,157 @@ static void heap_free_delayed_list(void)
     }
 }
 
+/* Per-cpu front end cache for small allocations.
+ *
+ * Every malloc/free otherwise takes the central heap mutex, which all cpus
+ * contend on.  For allocations up to HEAP_CACHE_MAX_SIZE bytes we keep a
+ * small per-cpu stack of free blocks per 32 byte size class, so the common
+ * case malloc/free is just an interrupt-disabled window on the local cpu
+ * and touches no shared lock.  A miss refills a batch of blocks from the
+ * central heap in one go; frees that overflow a class go straight back.
+ *
+ * Blocks are binned on free by their underlying heap size
+ * (cmpct_usable_size), so a block always lands in a class no larger than
+ * what it can hold.  Cached blocks bypass the central heap's debug fills
+ * and double free checks, so the cache is left out of debug builds.
+ */
+#if WITH_LIB_HEAP_CMPCTMALLOC && !defined(DEBUG) && LK_DEBUGLEVEL <= 2
+#define HEAP_USE_CACHE 1
+#else
+#define HEAP_USE_CACHE 0
+#endif
+
+#if HEAP_USE_CACHE
+
+/* largest cached allocation and the size class granularity */
+#define HEAP_CACHE_MAX_SIZE 512u
+#define HEAP_CACHE_SHIFT 5u
+#define HEAP_CACHE_CLASSES (HEAP_CACHE_MAX_SIZE >> HEAP_CACHE_SHIFT)
+
+/* most blocks a class will hold and how many a miss fetches at once */
+#define HEAP_CACHE_DEPTH 16u
+#define HEAP_CACHE_BATCH 8u
+
+struct heap_cache {
+    /* singly linked stacks of free blocks; the link lives in the block */
+    void *free[HEAP_CACHE_CLASSES];
+    uint32_t count[HEAP_CACHE_CLASSES];
+} __CPU_ALIGN;
+
+static struct heap_cache heap_cache[SMP_MAX_CPUS];
+
+static void *heap_cache_alloc(size_t size)
+{
+    if (size == 0 || size > HEAP_CACHE_MAX_SIZE)
+        return NULL;
+
+    uint cls = (uint)((size - 1) >> HEAP_CACHE_SHIFT);
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    struct heap_cache *cache = &heap_cache[arch_curr_cpu_num()];
+    void *ptr = cache->free[cls];
+    if (likely(ptr != NULL)) {
+        cache->free[cls] = *(void **)ptr;
+        cache->count[cls]--;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (likely(ptr != NULL))
+        return ptr;
+
+    /* Miss; fetch a batch from the central heap under its lock.  The blocks
+     * are allocated at full class size so that any later allocation in the
+     * class can reuse them. */
+    size_t class_size = ((size_t)cls + 1) << HEAP_CACHE_SHIFT;
+    void *batch[HEAP_CACHE_BATCH];
+    uint n = 0;
+    while (n < HEAP_CACHE_BATCH) {
+        batch[n] = HEAP_MALLOC(class_size);
+        if (batch[n] == NULL)
+            break;
+        n++;
+    }
+    if (n == 0)
+        return NULL;
+    ptr = batch[--n];
+
+    /* Stash the leftovers.  We may have migrated cpus during the refill,
+     * which is fine; they just land on the new cpu's cache. */
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    cache = &heap_cache[arch_curr_cpu_num()];
+    while (n > 0 && cache->count[cls] < HEAP_CACHE_DEPTH) {
+        n--;
+        *(void **)batch[n] = cache->free[cls];
+        cache->free[cls] = batch[n];
+        cache->count[cls]++;
+    }
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    while (n > 0)
+        HEAP_FREE(batch[--n]);
+
+    return ptr;
+}
+
+static bool heap_cache_free(void *ptr)
+{
+    size_t usable = cmpct_usable_size(ptr);
+
+    /* Bin by what the block can actually hold.  Blocks a little larger than
+     * the largest class (the heap rounds sizes up and does not always carve
+     * off small remainders) still land in the largest class. */
+    if (usable < (1u << HEAP_CACHE_SHIFT) ||
+            usable >= HEAP_CACHE_MAX_SIZE + (1u << HEAP_CACHE_SHIFT))
+        return false;
+
+    uint cls = (uint)MIN(usable >> HEAP_CACHE_SHIFT, HEAP_CACHE_CLASSES) - 1;
+
+    bool cached = false;
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    struct heap_cache *cache = &heap_cache[arch_curr_cpu_num()];
+    if (likely(cache->count[cls] < HEAP_CACHE_DEPTH)) {
+        *(void **)ptr = cache->free[cls];
+        cache->free[cls] = ptr;
+        cache->count[cls]++;
+        cached = true;
+    }
+
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    return cached;
+}
+
+/* runs on every cpu at irq time via mp_sync_exec */
+static void heap_cache_flush_task(void *arg)
+{
+    struct heap_cache *cache = &heap_cache[arch_curr_cpu_num()];
+    for (uint cls = 0; cls < HEAP_CACHE_CLASSES; cls++) {
+        void *ptr = cache->free[cls];
+        cache->free[cls] = NULL;
+        cache->count[cls] = 0;
+        while (ptr != NULL) {
+            void *next = *(void **)ptr;
+            /* can't take the heap mutex at irq time; queue the block for
+             * the caller to hand back */
+            heap_delayed_free(ptr);
+            ptr = next;
+        }
+    }
+}
+
+static void heap_cache_flush(void)
+{
+    mp_sync_exec(MP_CPU_ALL, heap_cache_flush_task, NULL);
+    heap_free_delayed_list();
+}
+
+#endif  // HEAP_USE_CACHE
+
 void heap_init(void)
 {
     HEAP_INIT();
@@ -122,6 +275,11 @@ void heap_init(void)
 
 void heap_trim(void)
 {
+#if HEAP_USE_CACHE
+    // give the per-cpu cached blocks back so trim can see them
+    heap_cache_flush();
+#endif
+
     // deal with the pending free list
     if (unlikely(!list_is_empty(&delayed_free_list))) {
         heap_free_delayed_list();
@@ -141,7 +299,14 @@ void *malloc(size_t size)
         heap_free_delayed_list();
     }
 
+#if HEAP_USE_CACHE
+    void *ptr = heap_cache_alloc(size);
+    if (ptr == NULL)
+        ptr = HEAP_MALLOC(size);
+#else
     void *ptr = HEAP_MALLOC(size);
+#endif
+    heap_profile_alloc(ptr, size, __GET_CALLER());
     if (unlikely(heap_trace))
         printf("caller %p malloc %zu -> %p\n", __GET_CALLER(), size, ptr);
 
@@ -164,6 +329,7 @@ void *memalign(size_t boundary, size_t size)
     }
 
     void *ptr = HEAP_MEMALIGN(boundary, size);
+    heap_profile_alloc(ptr, size, __GET_CALLER());
     if (unlikely(heap_trace))
         printf("caller %p memalign %zu, %zu -> %p\n", __GET_CALLER(), boundary, size, ptr);
 
@@ -186,6 +352,7 @@ void *calloc(size_t count, size_t size)
     }
 
     void *ptr = HEAP_CALLOC(count, size);
+    heap_profile_alloc(ptr, count * size, __GET_CALLER());
     if (unlikely(heap_trace))
         printf("caller %p calloc %zu, %zu -> %p\n", __GET_CALLER(), count, size, ptr);
     return ptr;
@@ -203,6 +370,10 @@ void *realloc(void *ptr, size_t size)
     }
 
     void *ptr2 = HEAP_REALLOC(ptr, size);
+    if (ptr2 != NULL) {
+        heap_profile_free(ptr);
+        heap_profile_alloc(ptr2, size, __GET_CALLER());
+    }
     if (unlikely(heap_trace))
         printf("caller %p realloc %p, %zu -> %p\n", __GET_CALLER(), ptr, size, ptr2);
 
@@ -221,6 +392,12 @@ void free(void *ptr)
     if (unlikely(heap_trace))
         printf("caller %p free %p\n", __GET_CALLER(), ptr);
 
+    heap_profile_free(ptr);
+
+#if HEAP_USE_CACHE
+    if (ptr != NULL && heap_cache_free(ptr))
+        return;
+#endif
     HEAP_FREE(ptr);
 }
 
@@ -229,6 +406,8 @@ void heap_delayed_free(void *ptr)
 {
     LTRACEF("ptr %p\n", ptr);
 
+    heap_profile_free(ptr);
+
     /* throw down a structure on the free block */
     /* XXX assumes the free block is large enough to hold a list node */
     struct list_node *node = (struct list_node *)ptr;
@@ -243,6 +422,20 @@ static void heap_dump(bool panic_time)
 {
     HEAP_DUMP(panic_time);
 
+#if HEAP_USE_CACHE
+    printf("\tper-cpu cache (racy snapshot):\n");
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        uint blocks = 0;
+        size_t bytes = 0;
+        for (uint cls = 0; cls < HEAP_CACHE_CLASSES; cls++) {
+            blocks += heap_cache[cpu].count[cls];
+            bytes += heap_cache[cpu].count[cls] * (((size_t)cls + 1) << HEAP_CACHE_SHIFT);
+        }
+        if (blocks > 0)
+            printf("\t\tcpu %u: %u blocks, %zu bytes\n", cpu, blocks, bytes);
+    }
+#endif
+
     printf("\tdelayed free list:\n");
 
     spin_lock_saved_state_t state = 0;
@@ -338,6 +531,7 @@ usage:
         if (!(flags & CMD_FLAG_PANIC)) {
             printf("\t%s trace\n", argv[0].str);
             printf("\t%s trim\n", argv[0].str);
+            printf("\t%s profile [on [rate]|off|reset]\n", argv[0].str);
             printf("\t%s alloc <size> [alignment]\n", argv[0].str);
             printf("\t%s realloc <ptr> <size>\n", argv[0].str);
             printf("\t%s free <address>\n", argv[0].str);
@@ -354,6 +548,20 @@ usage:
         printf("heap trace is now %s\n", heap_trace ? "on" : "off");
     } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "trim") == 0) {
         heap_trim();
+    } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "profile") == 0) {
+        if (argc < 3) {
+            heap_profile_dump();
+        } else if (strcmp(argv[2].str, "on") == 0) {
+            status_t err = heap_profile_enable((argc >= 4) ? (uint32_t)argv[3].u : 0);
+            if (err != NO_ERROR)
+                printf("failed to enable heap profiling: %d\n", err);
+        } else if (strcmp(argv[2].str, "off") == 0) {
+            heap_profile_disable();
+        } else if (strcmp(argv[2].str, "reset") == 0) {
+            heap_profile_reset();
+        } else {
+            goto usage;
+        }
     } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "alloc") == 0) {
         if (argc < 3) goto notenoughargs;
 
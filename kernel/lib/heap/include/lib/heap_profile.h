@@ -0,0 +1,72 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS;
+
+/* Sampled allocation-site accounting for the kernel heap.
+ *
+ * When enabled, one in every sample-rate allocations is tracked back to its
+ * call site (the return address into the caller of malloc), and the bytes
+ * and counts charged to each site are scaled by the sampling rate so the
+ * reported numbers estimate the real totals.  Tracking is off by default
+ * and is switched on from the kernel console ("heap profile on"); the
+ * results can be dumped there or read by userspace diagnostics via
+ * mx_object_get_info(MX_INFO_HEAP_SITES) on the root resource.
+ */
+
+/* one allocation site; layout matches mx_info_heap_site_t */
+typedef struct heap_profile_record {
+    uint64_t caller;       /* return address of the allocation site */
+    uint64_t live_bytes;   /* estimated bytes currently allocated from it */
+    uint64_t live_count;   /* estimated live allocation count */
+    uint64_t total_count;  /* estimated allocations ever made from it */
+} heap_profile_record_t;
+
+/* Start sampling at the given rate (0 picks the default).  Allocates the
+ * tracking tables on first use; they are retained afterwards. */
+status_t heap_profile_enable(uint32_t sample_rate);
+void heap_profile_disable(void);
+
+/* drop all accumulated data (tracking state stays on/off as it was) */
+void heap_profile_reset(void);
+
+/* print the per-site table to the console */
+void heap_profile_dump(void);
+
+/* Copy up to |max| records into |records|, returning the number copied.
+ * |avail| (optional) receives the number of sites with data. */
+size_t heap_profile_snapshot(heap_profile_record_t *records, size_t max,
+                             size_t *avail);
+
+/* hooks called from the allocator entry points in heap_wrapper.c */
+void _heap_profile_alloc(void *ptr, size_t size, void *caller);
+void _heap_profile_free(void *ptr);
+
+extern bool heap_profile_on;
+extern volatile int heap_profile_tracked;
+
+static inline void heap_profile_alloc(void *ptr, size_t size, void *caller)
+{
+    if (unlikely(heap_profile_on) && ptr != NULL)
+        _heap_profile_alloc(ptr, size, caller);
+}
+
+/* Frees must be checked whenever tracked allocations exist, even after
+ * profiling is switched off, so the accounting for them drains cleanly. */
+static inline void heap_profile_free(void *ptr)
+{
+    if (unlikely(heap_profile_tracked != 0) && ptr != NULL)
+        _heap_profile_free(ptr);
+}
+
+__END_CDECLS;
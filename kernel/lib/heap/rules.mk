@@ -12,6 +12,7 @@ KERNEL_INCLUDES += $(LOCAL_DIR)/include
 MODULE := $(LOCAL_DIR)
 
 MODULE_SRCS += \
+	$(LOCAL_DIR)/heap_profile.c \
 	$(LOCAL_DIR)/heap_wrapper.c \
 	$(LOCAL_DIR)/page_alloc.c \
 	$(LOCAL_DIR)/new.cpp
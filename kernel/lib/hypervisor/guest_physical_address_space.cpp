@@ -8,11 +8,40 @@
 
 #include <hypervisor/guest_physical_address_space.h>
 
+#include <mxtl/algorithm.h>
+
 static const uint kPfFlags = VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT;
 static const uint kApicMmuFlags = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
 static const uint kMmuFlags =
     ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE | ARCH_MMU_FLAG_PERM_EXECUTE;
-static const size_t kAddressSpaceSize =  256ul << 30;
+static const size_t kAddressSpaceSize = 256ul << 30;
+static const size_t kLargePageSize = 2u << 20;
+
+namespace {
+// A run of physically contiguous pages accumulated from a VMO lookup, mapped
+// with a single guest_mmu_map call so that suitably aligned runs can be
+// installed as large EPT entries rather than a page at a time.
+struct MapRun {
+    guest_paspace_t* paspace;
+    vaddr_t base;       // guest physical address of the start of the run
+    paddr_t paddr;      // host physical address of the start of the run
+    size_t count;       // length of the run in pages
+};
+} // namespace
+
+static status_t flush_run(MapRun* run) {
+    if (run->count == 0)
+        return NO_ERROR;
+    size_t mapped;
+    status_t status =
+        guest_mmu_map(run->paspace, run->base, run->paddr, run->count, kMmuFlags, &mapped);
+    if (status != NO_ERROR)
+        return status;
+    if (mapped != run->count)
+        return ERR_NO_MEMORY;
+    run->count = 0;
+    return NO_ERROR;
+}
 
 status_t GuestPhysicalAddressSpace::Create(mxtl::RefPtr<VmObject> guest_phys_mem,
                                            mxtl::unique_ptr<GuestPhysicalAddressSpace>* _gpas) {
@@ -26,17 +55,14 @@ status_t GuestPhysicalAddressSpace::Create(mxtl::RefPtr<VmObject> guest_phys_mem
     if (status != NO_ERROR)
         return status;
 
-    // TODO(abdulla): Figure out how to do this on-demand.
-    status = gpas->MapRange(0, guest_phys_mem->size());
-    if (status != NO_ERROR)
-        return status;
-
+    // Mappings are built on demand, from EPT violations, rather than
+    // populated up front.  See PageFault.
     *_gpas = mxtl::move(gpas);
     return NO_ERROR;
 }
 
 GuestPhysicalAddressSpace::GuestPhysicalAddressSpace(mxtl::RefPtr<VmObject> guest_phys_mem)
-    : guest_phys_mem_(guest_phys_mem) {}
+    : guest_phys_mem_(guest_phys_mem), trap_page_(~0ul) {}
 
 GuestPhysicalAddressSpace::~GuestPhysicalAddressSpace() {
     __UNUSED status_t status = guest_mmu_destroy_paspace(&paspace_);
@@ -57,11 +83,56 @@ status_t GuestPhysicalAddressSpace::MapApicPage(vaddr_t guest_paddr, paddr_t hos
 }
 
 status_t GuestPhysicalAddressSpace::MapRange(size_t offset, size_t len) {
+    MapRun run = { &paspace_, 0, 0, 0 };
     auto mmu_map = [](void* context, size_t offset, size_t index, paddr_t pa) -> status_t {
-        guest_paspace_t* paspace = static_cast<guest_paspace_t*>(context);
-        return map_page(paspace, offset, pa, kMmuFlags);
+        MapRun* run = static_cast<MapRun*>(context);
+        if (run->count != 0 && pa == run->paddr + run->count * PAGE_SIZE &&
+            offset == run->base + run->count * PAGE_SIZE) {
+            run->count++;
+            return NO_ERROR;
+        }
+        status_t status = flush_run(run);
+        if (status != NO_ERROR)
+            return status;
+        run->base = offset;
+        run->paddr = pa;
+        run->count = 1;
+        return NO_ERROR;
     };
-    return guest_phys_mem_->Lookup(offset, len, kPfFlags, mmu_map, &paspace_);
+    status_t status = guest_phys_mem_->Lookup(offset, len, kPfFlags, mmu_map, &run);
+    if (status != NO_ERROR)
+        return status;
+    return flush_run(&run);
+}
+
+status_t GuestPhysicalAddressSpace::PageFault(vaddr_t guest_paddr) {
+    if (guest_paddr >= size())
+        return ERR_OUT_OF_RANGE;
+
+    vaddr_t page_base = ROUNDDOWN(guest_paddr, PAGE_SIZE);
+    if (page_base == trap_page_)
+        return ERR_NOT_FOUND;
+
+    // Try to map a large-page-aligned window around the faulting address in
+    // one shot.  If the backing VMO turns out to be physically contiguous,
+    // the arch code installs a single large EPT entry for it.  Skip the
+    // window if it covers the trap page, which must stay unmapped.
+    vaddr_t large_base = ROUNDDOWN(guest_paddr, kLargePageSize);
+    size_t large_len = mxtl::min(size() - large_base, kLargePageSize);
+    if (trap_page_ < large_base || trap_page_ >= large_base + large_len) {
+        status_t status = MapRange(large_base, large_len);
+        if (status != ERR_ALREADY_EXISTS)
+            return status;
+        // Part of the window is already mapped; fall through and map just
+        // the faulting page.
+    }
+
+    status_t status = MapRange(page_base, PAGE_SIZE);
+    if (status == ERR_ALREADY_EXISTS) {
+        // Another VCPU beat us to it.
+        status = NO_ERROR;
+    }
+    return status;
 }
 
 status_t GuestPhysicalAddressSpace::UnmapPage(vaddr_t guest_paddr) {
@@ -74,5 +145,14 @@ status_t GuestPhysicalAddressSpace::UnmapPage(vaddr_t guest_paddr) {
 
 status_t GuestPhysicalAddressSpace::GetPage(vaddr_t guest_paddr, paddr_t* host_paddr) {
     uint mmu_flags;
+    status_t status = guest_mmu_query(&paspace_, guest_paddr, host_paddr, &mmu_flags);
+    if (status == NO_ERROR)
+        return status;
+
+    // The page may simply not have been touched by the guest yet; fault it
+    // in and retry the query.
+    status = PageFault(guest_paddr);
+    if (status != NO_ERROR)
+        return status;
     return guest_mmu_query(&paspace_, guest_paddr, host_paddr, &mmu_flags);
 }
@@ -25,9 +25,20 @@ public:
     status_t UnmapPage(vaddr_t guest_paddr);
     status_t GetPage(vaddr_t guest_paddr, paddr_t* host_paddr);
 
+    // Mark a page which must never be mapped into the guest physical address
+    // space, so that guest accesses to it always exit with an EPT violation
+    // and can be emulated (used for the IO APIC page).
+    void SetTrapPage(vaddr_t guest_paddr) { trap_page_ = guest_paddr; }
+
+    // Handle an EPT violation by building the missing mapping.  Maps a large
+    // page worth of the guest VMO around the faulting address when possible,
+    // falling back to the single faulting page.
+    status_t PageFault(vaddr_t guest_paddr);
+
 private:
     guest_paspace_t paspace_;
     mxtl::RefPtr<VmObject> guest_phys_mem_;
+    vaddr_t trap_page_;
 
     explicit GuestPhysicalAddressSpace(mxtl::RefPtr<VmObject> guest_phys_mem);
 
@@ -12,6 +12,7 @@
 #include <arch/ops.h>
 #include <arch/user_copy.h>
 #include <kernel/cmdline.h>
+#include <kernel/vm.h>
 #include <kernel/vm/vm_aspace.h>
 #include <lib/ktrace.h>
 #include <lk/init.h>
@@ -82,59 +83,118 @@ static void ktrace_report_probes(void) {
     mutex_release(&probe_list_lock);
 }
 
-typedef struct ktrace_state {
-    // where the next record will be written
+// Each cpu traces into its own slice of the buffer, with its write
+// cursor on its own cacheline, so that recording events never bounces
+// cachelines between cpus.  Records carry timestamps, so the per-cpu
+// streams can be merged back into one timeline after the fact.
+typedef struct ktrace_cpu_state {
+    // where the next record will be written, relative to buffer
     int offset;
 
+    // offset where tracing was stopped, 0 if tracing active
+    uint32_t marker;
+
+    // this cpu's slice of the trace buffer
+    uint8_t* buffer;
+} __CPU_ALIGN ktrace_cpu_state_t;
+
+typedef struct ktrace_state {
     // mask of groups we allow, 0 == tracing disabled
     int grpmask;
 
-    // total size of the trace buffer
+    // usable size of each per-cpu slice
     uint32_t bufsize;
 
-    // offset where tracing was stopped, 0 if tracing active
-    uint32_t marker;
+    // number of per-cpu streams
+    uint32_t ncpus;
 
-    // raw trace buffer
-    uint8_t* buffer;
+    ktrace_cpu_state_t cpu[SMP_MAX_CPUS];
 } ktrace_state_t;
 
 static ktrace_state_t KTRACE_STATE;
 
-int ktrace_read_user(void* ptr, uint32_t off, uint32_t len) {
-    ktrace_state_t* ks = &KTRACE_STATE;
-
-    // Buffer size is limited by the marker if set,
-    // otherwise limited by offset (last written point).
-    // Offset can end up pointing past the end, so clip
-    // it to the actual buffer size to be safe.
+// number of bytes of a cpu's stream that a reader may observe:
+// limited by the marker if set, otherwise by the write cursor,
+// which can end up pointing past the end, so clip it to be safe
+static uint32_t ktrace_stream_used(ktrace_state_t* ks, ktrace_cpu_state_t* kc) {
     uint32_t max;
-    if (ks->marker) {
-        max = ks->marker;
+    if (kc->marker) {
+        max = kc->marker;
     } else {
-        max = ks->offset;
+        max = kc->offset;
         if (max > ks->bufsize) {
             max = ks->bufsize;
         }
     }
+    return max;
+}
 
-    // null read is a query for trace buffer size
-    if (ptr == nullptr) {
-        return max;
+// reserve space for a record in the current cpu's stream
+// returns nullptr (and stops tracing) if the stream is full
+static void* ktrace_reserve(ktrace_state_t* ks, uint32_t len) {
+    ktrace_cpu_state_t* kc = &ks->cpu[arch_curr_cpu_num()];
+    // the cursor is on this cpu's own cacheline so the atomic is
+    // uncontended; it's still needed in case we migrate mid-update
+    int off;
+    if ((off = atomic_add(&kc->offset, static_cast<int>(len))) >= (int)ks->bufsize) {
+        // if any stream arrives at its end, stop
+        atomic_store(&ks->grpmask, 0);
+        return nullptr;
     }
+    return kc->buffer + off;
+}
+
+int ktrace_read_user(void* ptr, uint32_t off, uint32_t len) {
+    ktrace_state_t* ks = &KTRACE_STATE;
 
-    // constrain read to available buffer
-    if (off >= max) {
-        return 0;
+    // The read space is the used region of each cpu's stream,
+    // concatenated in cpu order.  Streams identify themselves with
+    // a TAG_CPU_STREAM metadata record, and KTRACE_ACTION_GET_CPU_STREAM
+    // reports where each one lands in this space.
+    uint32_t total = 0;
+    uint32_t actual = 0;
+    for (uint32_t i = 0; i < ks->ncpus; i++) {
+        uint32_t used = ktrace_stream_used(ks, &ks->cpu[i]);
+        uint32_t pos = off + actual;
+        if ((ptr != nullptr) && (len > 0) &&
+            (pos >= total) && (pos < (total + used))) {
+            uint32_t skip = pos - total;
+            uint32_t n = used - skip;
+            if (n > len) {
+                n = len;
+            }
+            if (arch_copy_to_user(static_cast<uint8_t*>(ptr) + actual,
+                                  ks->cpu[i].buffer + skip, n) != NO_ERROR) {
+                return ERR_INVALID_ARGS;
+            }
+            actual += n;
+            len -= n;
+        }
+        total += used;
     }
-    if (len > (max - off)) {
-        len = max - off;
+
+    // null read is a query for trace buffer size
+    if (ptr == nullptr) {
+        return total;
     }
+    return actual;
+}
 
-    if (arch_copy_to_user(ptr, ks->buffer + off, len) != NO_ERROR) {
-        return ERR_INVALID_ARGS;
+// write metadata records at the start of each cpu's stream and
+// roll its write cursor back to just past them
+static void ktrace_rewind(ktrace_state_t* ks) {
+    uint64_t n = ktrace_ticks_per_ms();
+    for (uint32_t i = 0; i < ks->ncpus; i++) {
+        ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->cpu[i].buffer;
+        rec[0].tag = TAG_VERSION;
+        rec[0].a = KTRACE_VERSION;
+        rec[1].tag = TAG_TICKS_PER_MS;
+        rec[1].a = (uint32_t)n;
+        rec[1].b = (uint32_t)(n >> 32);
+        rec[2].tag = TAG_CPU_STREAM;
+        rec[2].a = i;
+        atomic_store(&ks->cpu[i].offset, KTRACE_RECSIZE * 3);
     }
-    return len;
 }
 
 status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
@@ -142,26 +202,44 @@ status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
     switch (action) {
     case KTRACE_ACTION_START:
         options = KTRACE_GRP_TO_MASK(options);
-        ks->marker = 0;
+        for (uint32_t i = 0; i < ks->ncpus; i++) {
+            ks->cpu[i].marker = 0;
+        }
         atomic_store(&ks->grpmask, options ? options : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
         ktrace_report_live_threads();
         break;
     case KTRACE_ACTION_STOP: {
         atomic_store(&ks->grpmask, 0);
-        uint32_t n = ks->offset;
-        if (n > ks->bufsize) {
-            ks->marker = ks->bufsize;
-        } else {
-            ks->marker = n;
+        for (uint32_t i = 0; i < ks->ncpus; i++) {
+            uint32_t n = ks->cpu[i].offset;
+            if (n > ks->bufsize) {
+                ks->cpu[i].marker = ks->bufsize;
+            } else {
+                ks->cpu[i].marker = n;
+            }
         }
         break;
     }
     case KTRACE_ACTION_REWIND:
-        // roll back to just after the metadata
-        atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+        ktrace_rewind(ks);
         ktrace_report_syscalls(kt_syscall_info);
         ktrace_report_probes();
         break;
+    case KTRACE_ACTION_GET_CPU_COUNT:
+        return static_cast<int>(ks->ncpus);
+    case KTRACE_ACTION_GET_CPU_STREAM: {
+        if (options >= ks->ncpus) {
+            return ERR_INVALID_ARGS;
+        }
+        ktrace_cpu_stream_t* stream = (ktrace_cpu_stream_t*) ptr;
+        uint32_t base = 0;
+        for (uint32_t i = 0; i < options; i++) {
+            base += ktrace_stream_used(ks, &ks->cpu[i]);
+        }
+        stream->offset = base;
+        stream->length = ktrace_stream_used(ks, &ks->cpu[options]);
+        break;
+    }
     case KTRACE_ACTION_NEW_PROBE: {
         ktrace_probe_info_t* probe;
         mutex_acquire(&probe_list_lock);
@@ -201,19 +279,34 @@ void ktrace_init(unsigned level) {
 
     mb *= (1024*1024);
 
+    // carve the buffer into one slice per cpu, rounded to record size
+    uint32_t ncpus = arch_max_num_cpus();
+    uint32_t slice = (mb / ncpus) & ~(KTRACE_RECSIZE - 1);
+
+    // The last packet written can overhang the end of a slice, so we
+    // reduce the usable size by the max size of a record; the overhang
+    // lands in the reserved space, not in the next cpu's slice
+    if (slice <= (256 + KTRACE_RECSIZE * 3)) {
+        dprintf(INFO, "ktrace: buffer too small for %u cpus\n", ncpus);
+        return;
+    }
+
     status_t status;
+    uint8_t* buffer;
     VmAspace* aspace = VmAspace::kernel_aspace();
-    if ((status = aspace->Alloc("ktrace", mb, (void**)&ks->buffer, 0, VMM_FLAG_COMMIT,
+    if ((status = aspace->Alloc("ktrace", mb, (void**)&buffer, 0, VMM_FLAG_COMMIT,
                                 ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE)) < 0) {
         dprintf(INFO, "ktrace: cannot alloc buffer %d\n", status);
         return;
     }
 
-    // The last packet written can overhang the end of the buffer,
-    // so we reduce the reported size by the max size of a record
-    ks->bufsize = mb - 256;
+    ks->ncpus = ncpus;
+    ks->bufsize = slice - 256;
+    for (uint32_t i = 0; i < ncpus; i++) {
+        ks->cpu[i].buffer = buffer + i * slice;
+    }
 
-    dprintf(INFO, "ktrace: buffer at %p (%u bytes)\n", ks->buffer, mb);
+    dprintf(INFO, "ktrace: buffer at %p (%u bytes, %u per cpu)\n", buffer, mb, slice);
 
     // register all static probes
     ktrace_probe_info_t *probe;
@@ -223,17 +316,10 @@ void ktrace_init(unsigned level) {
     }
     mutex_release(&probe_list_lock);
 
-    // write metadata to the first two event slots
-    uint64_t n = ktrace_ticks_per_ms();
-    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->buffer;
-    rec[0].tag = TAG_VERSION;
-    rec[0].a = KTRACE_VERSION;
-    rec[1].tag = TAG_TICKS_PER_MS;
-    rec[1].a = (uint32_t)n;
-    rec[1].b = (uint32_t)(n >> 32);
+    // write metadata at the head of each cpu's stream
+    ktrace_rewind(ks);
 
     // enable tracing
-    atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
     ktrace_report_syscalls(kt_syscall_info);
     ktrace_report_probes();
     atomic_store(&ks->grpmask, KTRACE_GRP_TO_MASK(grpmask));
@@ -247,12 +333,8 @@ void ktrace_tiny(uint32_t tag, uint32_t arg) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (tag & atomic_load(&ks->grpmask)) {
         tag = (tag & 0xFFFFFFF0) | 2;
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_HDRSIZE)) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
+        ktrace_header_t* hdr = (ktrace_header_t*) ktrace_reserve(ks, KTRACE_HDRSIZE);
+        if (hdr != nullptr) {
             hdr->ts = ts;
             hdr->tag = tag;
             hdr->tid = arg;
@@ -267,14 +349,10 @@ void* ktrace_open(uint32_t tag) {
         return nullptr;
     }
 
-    int off;
-    if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-        // if we arrive at the end, stop
-        atomic_store(&ks->grpmask, 0);
+    ktrace_header_t* hdr = (ktrace_header_t*) ktrace_reserve(ks, KTRACE_LEN(tag));
+    if (hdr == nullptr) {
         return nullptr;
     }
-
-    ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
     hdr->ts = ts;
     hdr->tag = tag;
     hdr->tid = (uint32_t)get_current_thread()->user_tid;
@@ -289,12 +367,8 @@ static void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char*
         // set size to: sizeof(hdr) + len + 1, round up to multiple of 8
         tag = (tag & 0xFFFFFFF0) | ((KTRACE_NAMESIZE + len + 1 + 7) >> 3);
 
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->buffer + off);
+        ktrace_rec_name_t* rec = (ktrace_rec_name_t*) ktrace_reserve(ks, KTRACE_LEN(tag));
+        if (rec != nullptr) {
             rec->tag = tag;
             rec->id = id;
             rec->arg = arg;
@@ -308,4 +382,25 @@ void ktrace_name(uint32_t tag, uint32_t id, uint32_t arg, const char* name) {
     ktrace_name_etc(tag, id, arg, name, false);
 }
 
+// Record a profiling sample of the interrupted context, called from the
+// platform timer tick path with interrupts disabled.  Costs one atomic
+// load when KTRACE_GRP_PROF is not enabled.  The caller slot is filled
+// by following one frame pointer link when we interrupted kernel code
+// (the kernel is compiled with frame pointers), otherwise from the link
+// register hint if the arch provides one.
+void ktrace_prof_sample(uintptr_t pc, uintptr_t fp, uintptr_t lr) {
+    uint32_t* args = (uint32_t*) ktrace_open(TAG_PROF_SAMPLE);
+    if (args == nullptr) {
+        return;
+    }
+    uintptr_t caller = lr;
+    if (is_kernel_address(pc) && is_kernel_address(fp) && ((fp & 7) == 0)) {
+        caller = ((uintptr_t*)fp)[1];
+    }
+    args[0] = (uint32_t)pc;
+    args[1] = (uint32_t)(pc >> 32);
+    args[2] = (uint32_t)caller;
+    args[3] = (uint32_t)(caller >> 32);
+}
+
 LK_INIT_HOOK(ktrace, ktrace_init, LK_INIT_LEVEL_APPS - 1);
@@ -0,0 +1,84 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <magenta/aspace_reaper.h>
+
+#include <assert.h>
+#include <new.h>
+#include <trace.h>
+
+#include <kernel/auto_lock.h>
+#include <kernel/event.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
+#include <lk/init.h>
+
+#include <mxtl/intrusive_double_list.h>
+#include <mxtl/unique_ptr.h>
+
+#define LOCAL_TRACE 0
+
+namespace {
+struct ReapNode : public mxtl::DoublyLinkedListable<mxtl::unique_ptr<ReapNode>> {
+    explicit ReapNode(mxtl::RefPtr<VmAspace> a) : aspace(mxtl::move(a)) {}
+    mxtl::RefPtr<VmAspace> aspace;
+};
+} // anonymous namespace
+
+static Mutex reaper_mutex;
+static mxtl::DoublyLinkedList<mxtl::unique_ptr<ReapNode>> reaper_aspaces
+    TA_GUARDED(reaper_mutex);
+static event_t reaper_event =
+    EVENT_INITIAL_VALUE(reaper_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
+// Runs at LOW_PRIORITY, so big teardowns are preempted by any real work;
+// reclamation keeps making progress without ever monopolizing a cpu.
+static int AspaceReaperThread(void* arg) {
+    for (;;) {
+        __UNUSED status_t err = event_wait(&reaper_event);
+        DEBUG_ASSERT(err == NO_ERROR);
+
+        for (;;) {
+            mxtl::unique_ptr<ReapNode> node;
+            {
+                AutoLock lock(&reaper_mutex);
+                node = reaper_aspaces.pop_front();
+            }
+            if (!node)
+                break;
+            LTRACEF("destroying aspace %p '%s'\n",
+                    node->aspace.get(), node->aspace->name());
+            node->aspace->Destroy();
+        }
+    }
+    return 0;
+}
+
+void ReapVmAspace(mxtl::RefPtr<VmAspace> aspace) {
+    LTRACE_ENTRY;
+    AllocChecker ac;
+    mxtl::unique_ptr<ReapNode> node(new (&ac) ReapNode(mxtl::move(aspace)));
+    if (!ac.check()) {
+        // The allocation failed, so |aspace| was not consumed. Tearing it
+        // down right here is the best way to get some memory back.
+        aspace->Destroy();
+        return;
+    }
+    {
+        AutoLock lock(&reaper_mutex);
+        reaper_aspaces.push_back(mxtl::move(node));
+    }
+    event_signal(&reaper_event, false);
+}
+
+static void aspace_reaper_init(uint level) {
+    thread_t* t = thread_create("aspace-reaper", AspaceReaperThread, nullptr,
+                                LOW_PRIORITY, DEFAULT_STACK_SIZE);
+    ASSERT(t);
+    thread_detach_and_resume(t);
+}
+
+LK_INIT_HOOK(aspace_reaper, aspace_reaper_init, LK_INIT_LEVEL_THREADING);
@@ -14,20 +14,66 @@
 #include <trace.h>
 
 #include <kernel/event.h>
+#include <lib/ktrace.h>
 #include <platform.h>
 
 #include <magenta/handle.h>
 #include <magenta/message_packet.h>
 #include <magenta/port_client.h>
+#include <magenta/port_dispatcher_v2.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/user_thread.h>
 
+#include <mxtl/atomic.h>
 #include <mxtl/type_support.h>
 
 #define LOCAL_TRACE 0
 
 constexpr mx_rights_t kDefaultChannelRights = MX_RIGHT_TRANSFER | MX_RIGHT_READ | MX_RIGHT_WRITE;
 
+// Posts the completion (or abort) packet for an async call.  Best
+// effort: if the port is out of memory or already closed there is no
+// one left to tell.
+static void queue_call_packet(PortDispatcherV2* port, uint64_t key,
+                              mx_txid_t txid, mx_status_t status) {
+    mx_port_packet_t packet = {};
+    packet.key = key;
+    packet.type = MX_PKT_TYPE_CALL;
+    packet.status = status;
+    packet.call.txid = txid;
+    port->QueueCall(packet);
+}
+
+// Message trace ids pair the MSGPKT_SEND record, emitted where a message
+// enters the receiving endpoint's queue, with the MSGPKT_RECV record
+// emitted where it is handed to the receiver, so a trace viewer can
+// attribute cross-process queueing latency to individual messages without
+// any instrumentation in the applications. Ids are only allocated (and
+// messages only stamped) while the IPC trace group is enabled; otherwise
+// messages travel with a zero id and neither record is emitted.
+static mxtl::atomic<uint64_t> next_msg_trace_id(1u);
+
+static void trace_msg_send(MessagePacket* msg, mx_koid_t channel) {
+    auto args = static_cast<uint32_t*>(ktrace_open(TAG_MSGPKT_SEND));
+    if (likely(!args))
+        return;
+    uint64_t id = next_msg_trace_id.fetch_add(1u);
+    msg->set_trace_id(id);
+    args[0] = static_cast<uint32_t>(id);
+    args[1] = static_cast<uint32_t>(id >> 32);
+    args[2] = static_cast<uint32_t>(channel);
+    args[3] = msg->data_size();
+}
+
+static void trace_msg_recv(const MessagePacket* msg, mx_koid_t channel) {
+    if (likely(msg->trace_id() == 0u))
+        return;
+    ktrace(TAG_MSGPKT_RECV,
+           static_cast<uint32_t>(msg->trace_id()),
+           static_cast<uint32_t>(msg->trace_id() >> 32),
+           static_cast<uint32_t>(channel), msg->data_size());
+}
+
 // static
 status_t ChannelDispatcher::Create(uint32_t flags,
                                    mxtl::RefPtr<Dispatcher>* dispatcher0,
@@ -111,6 +157,11 @@ void ChannelDispatcher::on_zero_handles() TA_NO_THREAD_SAFETY_ANALYSIS {
             auto waiter = waiters_.pop_front();
             waiter->Cancel(ERR_CANCELED);
         }
+        while (!async_waiters_.is_empty()) {
+            auto waiter = async_waiters_.pop_front();
+            queue_call_packet(waiter->port.get(), waiter->key, waiter->txid,
+                              ERR_CANCELED);
+        }
     }
 
     // Ensure other endpoint detaches us
@@ -135,6 +186,11 @@ void ChannelDispatcher::OnPeerZeroHandles() {
         auto waiter = waiters_.pop_front();
         waiter->Cancel(ERR_PEER_CLOSED);
     }
+    while (!async_waiters_.is_empty()) {
+        auto waiter = async_waiters_.pop_front();
+        queue_call_packet(waiter->port.get(), waiter->key, waiter->txid,
+                          ERR_PEER_CLOSED);
+    }
 }
 
 status_t ChannelDispatcher::Read(uint32_t* msg_size,
@@ -161,6 +217,7 @@ status_t ChannelDispatcher::Read(uint32_t* msg_size,
     }
 
     *msg = messages_.pop_front();
+    trace_msg_recv(msg->get(), get_koid());
 
     if (messages_.is_empty())
         state_tracker_.UpdateState(MX_CHANNEL_READABLE, 0u);
@@ -168,6 +225,47 @@ status_t ChannelDispatcher::Read(uint32_t* msg_size,
     return rv;
 }
 
+status_t ChannelDispatcher::ReadBatch(const uint32_t* max_sizes, uint32_t count,
+                                      mxtl::unique_ptr<MessagePacket>* msgs, uint32_t* actual) {
+    canary_.Assert();
+
+    uint32_t popped = 0;
+    status_t rv = NO_ERROR;
+
+    {
+        AutoLock lock(&lock_);
+
+        if (messages_.is_empty()) {
+            *actual = 0u;
+            return other_ ? ERR_SHOULD_WAIT : ERR_PEER_CLOSED;
+        }
+
+        while (popped < count && !messages_.is_empty()) {
+            auto& front = messages_.front();
+            if (front.num_handles() > 0u) {
+                // handle-carrying messages take the regular read path
+                rv = ERR_NOT_SUPPORTED;
+                break;
+            }
+            if (front.data_size() > max_sizes[popped]) {
+                rv = ERR_BUFFER_TOO_SMALL;
+                break;
+            }
+            msgs[popped] = messages_.pop_front();
+            trace_msg_recv(msgs[popped].get(), get_koid());
+            popped++;
+        }
+
+        if (messages_.is_empty())
+            state_tracker_.UpdateState(MX_CHANNEL_READABLE, 0u);
+    }
+
+    *actual = popped;
+    // a partial batch is a success; the stop reason only surfaces when
+    // nothing could be popped at all
+    return (popped > 0u) ? NO_ERROR : rv;
+}
+
 status_t ChannelDispatcher::Write(mxtl::unique_ptr<MessagePacket> msg) {
     canary_.Assert();
 
@@ -189,6 +287,25 @@ status_t ChannelDispatcher::Write(mxtl::unique_ptr<MessagePacket> msg) {
     return NO_ERROR;
 }
 
+status_t ChannelDispatcher::WriteBatch(MessageList* msgs) {
+    canary_.Assert();
+
+    mxtl::RefPtr<ChannelDispatcher> other;
+    {
+        AutoLock lock(&lock_);
+        // batched messages never carry handles, so there is nothing for the
+        // caller to put back on failure
+        if (!other_)
+            return ERR_PEER_CLOSED;
+        other = other_;
+    }
+
+    if (other->WriteSelfBatch(msgs) > 0)
+        thread_preempt(false);
+
+    return NO_ERROR;
+}
+
 status_t ChannelDispatcher::Call(mxtl::unique_ptr<MessagePacket> msg,
                                  mx_time_t deadline, bool* return_handles,
                                  mxtl::unique_ptr<MessagePacket>* reply) {
@@ -264,35 +381,153 @@ status_t ChannelDispatcher::ResumeInterruptedCall(mx_time_t deadline,
     return status;
 }
 
+status_t ChannelDispatcher::CallAsync(mxtl::unique_ptr<MessagePacket> msg,
+                                      mxtl::RefPtr<PortDispatcherV2> port, uint64_t key,
+                                      bool* return_handles) {
+    canary_.Assert();
+
+    AllocChecker ac;
+    mxtl::unique_ptr<AsyncWaiter> waiter(
+        new (&ac) AsyncWaiter(mxtl::move(port), key, msg->get_txid()));
+    if (!ac.check()) {
+        *return_handles = true;
+        return ERR_NO_MEMORY;
+    }
+
+    mxtl::RefPtr<ChannelDispatcher> other;
+    {
+        AutoLock lock(&lock_);
+        if (!other_) {
+            // |msg| will be destroyed but we want to keep the handles alive since
+            // the caller should put them back into the process table.
+            msg->set_owns_handles(false);
+            *return_handles = true;
+            return ERR_PEER_CLOSED;
+        }
+        other = other_;
+
+        // As in Call, the waiter must be registered before the outbound
+        // write so a fast peer cannot reply into the void.
+        async_waiters_.push_back(mxtl::move(waiter));
+    }
+
+    if (other->WriteSelf(mxtl::move(msg)) > 0)
+        thread_preempt(false);
+
+    return NO_ERROR;
+}
+
 int ChannelDispatcher::WriteSelf(mxtl::unique_ptr<MessagePacket> msg) {
     canary_.Assert();
 
     AutoLock lock(&lock_);
     auto size = msg->data_size();
+    mx_txid_t txid = msg->get_txid();
+
+    trace_msg_send(msg.get(), get_koid());
 
     if (!waiters_.is_empty()) {
         // If the far side is waiting for replies to messages
         // send via "call", see if this message has a matching
         // txid to one of the waiters, and if so, deliver it.
-        mx_txid_t txid = msg->get_txid();
         for (auto& waiter: waiters_) {
             // (3C) Deliver message to waiter.
             // Remove waiter from list.
             if (waiter.get_txid() == txid) {
                 waiters_.erase(waiter);
+                // a delivered call reply never sits in the queue; its
+                // receive record coincides with the handoff to the waiter
+                trace_msg_recv(msg.get(), get_koid());
                 // we return how many threads have been woken up, or zero.
                 return waiter.Deliver(mxtl::move(msg));
             }
         }
     }
+
+    // An async call reply is queued like any other message; the matched
+    // waiter just adds a port packet so the caller's event loop knows
+    // which transaction completed.
+    mxtl::unique_ptr<AsyncWaiter> async;
+    for (auto& waiter : async_waiters_) {
+        if (waiter.txid == txid) {
+            async = async_waiters_.erase(waiter);
+            break;
+        }
+    }
+
+    const bool was_empty = messages_.is_empty();
     messages_.push_back(mxtl::move(msg));
 
-    state_tracker_.UpdateState(0u, MX_CHANNEL_READABLE);
+    // only the empty -> non-empty edge changes the signal state; skipping
+    // the no-op update keeps the state tracker's lock out of the convoyed
+    // producer path when the queue stays occupied
+    if (was_empty)
+        state_tracker_.UpdateState(0u, MX_CHANNEL_READABLE);
     if (iopc_)
         iopc_->Signal(MX_CHANNEL_READABLE, size, &lock_);
+    if (async)
+        queue_call_packet(async->port.get(), async->key, async->txid, NO_ERROR);
     return 0;
 }
 
+int ChannelDispatcher::WriteSelfBatch(MessageList* msgs) {
+    canary_.Assert();
+
+    AutoLock lock(&lock_);
+
+    int woken = 0;
+    const bool was_empty = messages_.is_empty();
+    bool queued = false;
+    while (!msgs->is_empty()) {
+        mxtl::unique_ptr<MessagePacket> msg = msgs->pop_front();
+        auto size = msg->data_size();
+
+        trace_msg_send(msg.get(), get_koid());
+
+        // as in WriteSelf, a message whose txid matches a waiting "call" is
+        // delivered directly to the waiter instead of being queued
+        bool delivered = false;
+        mx_txid_t txid = msg->get_txid();
+        if (!waiters_.is_empty()) {
+            for (auto& waiter : waiters_) {
+                if (waiter.get_txid() == txid) {
+                    waiters_.erase(waiter);
+                    trace_msg_recv(msg.get(), get_koid());
+                    woken += waiter.Deliver(mxtl::move(msg));
+                    delivered = true;
+                    break;
+                }
+            }
+        }
+
+        if (!delivered) {
+            // async call replies are queued like other messages, plus the
+            // completion packet (see WriteSelf)
+            mxtl::unique_ptr<AsyncWaiter> async;
+            for (auto& waiter : async_waiters_) {
+                if (waiter.txid == txid) {
+                    async = async_waiters_.erase(waiter);
+                    break;
+                }
+            }
+
+            messages_.push_back(mxtl::move(msg));
+            queued = true;
+            if (iopc_)
+                iopc_->Signal(MX_CHANNEL_READABLE, size, &lock_);
+            if (async)
+                queue_call_packet(async->port.get(), async->key, async->txid,
+                                  NO_ERROR);
+        }
+    }
+
+    // as in WriteSelf, only the empty -> non-empty edge needs to touch the
+    // state tracker
+    if (queued && was_empty)
+        state_tracker_.UpdateState(0u, MX_CHANNEL_READABLE);
+    return woken;
+}
+
 status_t ChannelDispatcher::set_port_client(mxtl::unique_ptr<PortClient> client) {
     canary_.Assert();
 
@@ -353,6 +588,12 @@ status_t ChannelDispatcher::UserSignalSelf(uint32_t clear_mask, uint32_t set_mas
 }
 
 
+ChannelDispatcher::AsyncWaiter::AsyncWaiter(mxtl::RefPtr<PortDispatcherV2> port,
+                                            uint64_t key, mx_txid_t txid)
+    : port(mxtl::move(port)), key(key), txid(txid) {}
+
+ChannelDispatcher::AsyncWaiter::~AsyncWaiter() {}
+
 int ChannelDispatcher::MessageWaiter::Deliver(mxtl::unique_ptr<MessagePacket> msg) {
     DEBUG_ASSERT(armed());
 
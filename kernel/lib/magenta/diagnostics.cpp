@@ -273,6 +273,8 @@ public:
         usage.mapped_pages += map->size() / PAGE_SIZE;
         usage.committed_pages += map->vmo()->AllocatedPagesInRange(
             map->object_offset(), map->size());
+        usage.shared_pages += map->vmo()->SharedPagesInRange(
+            map->object_offset(), map->size());
         return true;
     }
 
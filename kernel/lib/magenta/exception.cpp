@@ -154,7 +154,19 @@ status_t magenta_exception_handler(uint exception_type,
     mx_exception_report_t report;
     build_exception_report(&report, thread, exception_type, context, ip);
 
-    for (size_t i = 0; i < countof(handlers); ++i) {
+    // Most processes are never debugged: no debugger, process or thread
+    // exception port is ever bound, and only the system-wide handler
+    // (crashlogger) is in play. A per-process count maintained on every
+    // bind/unbind lets dispatch skip straight to the system handler with a
+    // single load instead of walking the first three handlers' locks to
+    // find nothing. A bind racing with this check can miss this exception,
+    // which is indistinguishable from binding a moment later.
+    size_t first_handler = 0;
+    if (likely(!thread->process()->HasExceptionPorts())) {
+        first_handler = countof(handlers) - 1; // the system handler
+    }
+
+    for (size_t i = first_handler; i < countof(handlers); ++i) {
         // Initialize for paranoia's sake.
         UserThread::ExceptionStatus estatus = UserThread::ExceptionStatus::UNPROCESSED;
         auto status = handlers[i](thread, &report, context, &estatus);
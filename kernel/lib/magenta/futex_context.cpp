@@ -11,6 +11,7 @@
 #include <magenta/futex_context.h>
 #include <magenta/user_copy.h>
 #include <magenta/user_thread.h>
+#include <mxtl/atomic.h>
 #include <trace.h>
 
 #define LOCAL_TRACE 0
@@ -24,10 +25,28 @@ FutexContext::~FutexContext() {
 
     // All of the threads should have removed themselves from wait queues
     // by the time the process has exited.
-    DEBUG_ASSERT(futex_table_.is_empty());
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        DEBUG_ASSERT(buckets_[i].futex_table.is_empty());
+        DEBUG_ASSERT(buckets_[i].waiters.load() == 0);
+    }
+}
+
+FutexContext::Bucket& FutexContext::LockBucketForNode(FutexNode* node) TA_NO_THREAD_SAFETY_ANALYSIS {
+    for (;;) {
+        // The key read here is racy: FutexRequeue() may move the node to a
+        // different futex (and therefore bucket) concurrently.  Requeueing
+        // happens with both bucket locks held, so once we hold the lock the
+        // key cannot change any more and we can verify our guess.
+        uintptr_t futex_key = node->GetKey();
+        Bucket& bucket = GetBucket(futex_key);
+        bucket.lock.Acquire();
+        if (likely(node->GetKey() == futex_key))
+            return bucket;
+        bucket.lock.Release();
+    }
 }
 
-status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_time_t deadline) {
+status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_time_t deadline) TA_NO_THREAD_SAFETY_ANALYSIS {
     LTRACE_ENTRY;
 
     uintptr_t futex_key = reinterpret_cast<uintptr_t>(value_ptr.get());
@@ -42,16 +61,24 @@ status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_
     // If a FutexWake() operation could occur between them, a userland mutex
     // operation built on top of futexes would have a race condition that
     // could miss wakeups.
-    lock_.Acquire();
+    Bucket& bucket = GetBucket(futex_key);
+    bucket.lock.Acquire();
+
+    // Advertise ourselves as a (potential) waiter before sampling the futex
+    // value.  The seq_cst ordering against the value read is what lets
+    // FutexWake() take its lock-free empty-bucket fast path.
+    bucket.waiters.fetch_add(1);
 
     int value;
     status_t result = value_ptr.copy_from_user(&value);
     if (result != NO_ERROR) {
-        lock_.Release();
+        bucket.waiters.fetch_sub(1);
+        bucket.lock.Release();
         return result;
     }
     if (value != current_value) {
-        lock_.Release();
+        bucket.waiters.fetch_sub(1);
+        bucket.lock.Release();
         return ERR_BAD_STATE;
     }
 
@@ -59,27 +86,35 @@ status_t FutexContext::FutexWait(user_ptr<int> value_ptr, int current_value, mx_
     node = thread->futex_node();
     node->set_hash_key(futex_key);
     node->SetAsSingletonList();
+    node->set_waiter_priority(get_current_thread()->priority);
 
-    QueueNodesLocked(node);
+    QueueNodesLocked(bucket, node);
 
-    // Block current thread.  This releases lock_ and does not reacquire it.
-    result = node->BlockThread(&lock_, deadline);
+    // Block current thread.  This releases the bucket lock and does not
+    // reacquire it.
+    result = node->BlockThread(&bucket.lock, deadline);
     if (result == NO_ERROR) {
         // Fix/workaround for MG-624:
         // We must re-acquire the lock here to force this thread to wait until
         // the WakeThreads() marks this thread as not in the queue anymore.
         // Otherwise, this thread can exit before it does that, causing
         // WakeThreads() to scribble on memory.
-        AutoLock lock(&lock_);
+        // Note that a FutexRequeue() may have moved us to another bucket.
+        Bucket& wake_bucket = LockBucketForNode(node);
         DEBUG_ASSERT(!node->IsInQueue());
+        wake_bucket.waiters.fetch_sub(1);
+        wake_bucket.lock.Release();
         // All the work necessary for removing us from the hash table was done by FutexWake()
         return NO_ERROR;
     }
 
-    AutoLock lock(&lock_);
+    Bucket& timeout_bucket = LockBucketForNode(node);
     // If we hit the deadline, we need to remove the thread's node from the
     // wait queue, since FutexWake() didn't do that.
-    if (UnqueueNodeLocked(node)) {
+    bool was_queued = UnqueueNodeLocked(timeout_bucket, node);
+    timeout_bucket.waiters.fetch_sub(1);
+    timeout_bucket.lock.Release();
+    if (was_queued) {
         return ERR_TIMED_OUT;
     }
     // The current thread was not found on the wait queue.  This means
@@ -114,10 +149,24 @@ status_t FutexContext::FutexWake(user_ptr<const int> value_ptr,
     if (futex_key % sizeof(int))
         return ERR_INVALID_ARGS;
 
+    Bucket& bucket = GetBucket(futex_key);
+
+    // Lock-free fast path: if nobody is (or is committing to be) blocked on
+    // any futex in this bucket, there is nothing to wake.  The full fence
+    // orders the caller's userspace store of the new futex value before the
+    // counter load; it pairs with the waiter-side fetch_add before the value
+    // re-check in FutexWait().  Without it the store could be reordered
+    // after the load (StoreLoad), letting both sides miss each other: we
+    // read waiters == 0 while the waiter still reads the old futex value,
+    // and the wakeup is lost.
+    mxtl::atomic_thread_fence(mxtl::memory_order_seq_cst);
+    if (bucket.waiters.load() == 0)
+        return NO_ERROR;
+
     {
-        AutoLock lock(&lock_);
+        AutoLock lock(&bucket.lock);
 
-        FutexNode* node = futex_table_.erase(futex_key);
+        FutexNode* node = bucket.futex_table.erase(futex_key);
         if (!node) {
             // nothing blocked on this futex if we can't find it
             return NO_ERROR;
@@ -125,12 +174,14 @@ status_t FutexContext::FutexWake(user_ptr<const int> value_ptr,
         DEBUG_ASSERT(node->GetKey() == futex_key);
 
         FutexNode* wake_head = node;
-        node = FutexNode::RemoveFromHead(node, count, futex_key, 0u);
+        // Note: the woken nodes keep their hash key so that the waiter side
+        // can find (and debit) the right bucket when it resumes.
+        node = FutexNode::RemoveFromHead(node, count, futex_key, futex_key);
         // node is now the new blocked thread list head
 
         if (node != nullptr) {
             DEBUG_ASSERT(node->GetKey() == futex_key);
-            futex_table_.insert(node);
+            bucket.futex_table.insert(node);
         }
 
         // Traversing this list of threads must be done while holding the
@@ -144,31 +195,56 @@ status_t FutexContext::FutexWake(user_ptr<const int> value_ptr,
 }
 
 status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count, int current_value,
-                                    user_ptr<int> requeue_ptr, uint32_t requeue_count) {
+                                    user_ptr<int> requeue_ptr, uint32_t requeue_count) TA_NO_THREAD_SAFETY_ANALYSIS {
     LTRACE_ENTRY;
 
     if ((requeue_ptr.get() == nullptr) && requeue_count)
         return ERR_INVALID_ARGS;
 
-    AutoLock lock(&lock_);
-
-    int value;
-    status_t result = wake_ptr.copy_from_user(&value);
-    if (result != NO_ERROR) return result;
-    if (value != current_value) return ERR_BAD_STATE;
-
     uintptr_t wake_key = reinterpret_cast<uintptr_t>(wake_ptr.get());
     uintptr_t requeue_key = reinterpret_cast<uintptr_t>(requeue_ptr.get());
     if (wake_key == requeue_key) return ERR_INVALID_ARGS;
     if (wake_key % sizeof(int) || requeue_key % sizeof(int))
         return ERR_INVALID_ARGS;
 
+    // Lock both buckets in a fixed order to avoid deadlocking against a
+    // concurrent requeue in the opposite direction.
+    Bucket& wake_bucket = GetBucket(wake_key);
+    Bucket& requeue_bucket = GetBucket(requeue_key);
+    if (&wake_bucket == &requeue_bucket) {
+        wake_bucket.lock.Acquire();
+    } else if (&wake_bucket < &requeue_bucket) {
+        wake_bucket.lock.Acquire();
+        requeue_bucket.lock.Acquire();
+    } else {
+        requeue_bucket.lock.Acquire();
+        wake_bucket.lock.Acquire();
+    }
+
+    auto unlock = [&]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        if (&wake_bucket != &requeue_bucket)
+            requeue_bucket.lock.Release();
+        wake_bucket.lock.Release();
+    };
+
+    int value;
+    status_t result = wake_ptr.copy_from_user(&value);
+    if (result != NO_ERROR) {
+        unlock();
+        return result;
+    }
+    if (value != current_value) {
+        unlock();
+        return ERR_BAD_STATE;
+    }
+
     // This must happen before RemoveFromHead() calls set_hash_key() on
-    // nodes below, because operations on futex_table_ look at the GetKey
+    // nodes below, because operations on the tables look at the GetKey
     // field of the list head nodes for wake_key and requeue_key.
-    FutexNode* node = futex_table_.erase(wake_key);
+    FutexNode* node = wake_bucket.futex_table.erase(wake_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
+        unlock();
         return NO_ERROR;
     }
 
@@ -177,7 +253,8 @@ status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count,
         wake_head = nullptr;
     } else {
         wake_head = node;
-        node = FutexNode::RemoveFromHead(node, wake_count, wake_key, 0u);
+        // as in FutexWake(), woken nodes keep their key for bucket accounting
+        node = FutexNode::RemoveFromHead(node, wake_count, wake_key, wake_key);
     }
 
     // node is now the head of wake_ptr futex after possibly removing some threads to wake
@@ -185,43 +262,64 @@ status_t FutexContext::FutexRequeue(user_ptr<int> wake_ptr, uint32_t wake_count,
         if (requeue_count > 0) {
             // head and tail of list of nodes to requeue
             FutexNode* requeue_head = node;
+            uint32_t moved = 0;
             node = FutexNode::RemoveFromHead(node, requeue_count,
-                                             wake_key, requeue_key);
+                                             wake_key, requeue_key, &moved);
+
+            // The requeued waiters now belong to requeue_key's bucket.
+            // Credit the target bucket before debiting ours so the counts
+            // never transiently claim the bucket is empty while it isn't.
+            requeue_bucket.waiters.fetch_add(moved);
+            wake_bucket.waiters.fetch_sub(moved);
 
             // now requeue our nodes to requeue_ptr mutex
             DEBUG_ASSERT(requeue_head->GetKey() == requeue_key);
-            QueueNodesLocked(requeue_head);
+            QueueNodesLocked(requeue_bucket, requeue_head);
         }
     }
 
     // add any remaining nodes back to wake_key futex
     if (node != nullptr) {
         DEBUG_ASSERT(node->GetKey() == wake_key);
-        futex_table_.insert(node);
+        wake_bucket.futex_table.insert(node);
     }
 
     FutexNode::WakeThreads(wake_head);
+    unlock();
     return NO_ERROR;
 }
 
-void FutexContext::QueueNodesLocked(FutexNode* head) {
-    DEBUG_ASSERT(lock_.IsHeld());
+void FutexContext::QueueNodesLocked(Bucket& bucket, FutexNode* head) {
+    DEBUG_ASSERT(bucket.lock.IsHeld());
 
     FutexNode::HashTable::iterator iter;
 
     // Attempt to insert this FutexNode into the hash table.  If the insert
-    // succeeds, then the current thread is first to block on this futex and we
-    // are finished.  If the insert fails, then there is already a thread
-    // waiting on this futex.  Add ourselves to that thread's list.
-    if (!futex_table_.insert_or_find(head, &iter))
-        iter->AppendList(head);
+    // succeeds, then the current thread is first to block on this futex and
+    // we are finished: |head| is either a single node or an already-sorted
+    // chain taken off another futex by FutexRequeue().  If the insert
+    // fails, then there are already threads waiting on this futex; merge
+    // the new nodes into that list one at a time, keeping it sorted so
+    // that FutexWake() releases the highest priority waiters first.
+    if (bucket.futex_table.insert_or_find(head, &iter))
+        return;
+
+    FutexNode* old_head = &*iter;
+    FutexNode* queue_head = FutexNode::MergeByPriority(old_head, head);
+    if (queue_head != old_head) {
+        // The sorted insert produced a new head node.  The hash table only
+        // tracks list heads, so swap the entry.
+        FutexNode* erased = bucket.futex_table.erase(old_head->GetKey());
+        DEBUG_ASSERT(erased == old_head);
+        bucket.futex_table.insert(queue_head);
+    }
 }
 
 // This attempts to unqueue a thread (which may or may not be waiting on a
 // futex), given its FutexNode.  This returns whether the FutexNode was
 // found and removed from a futex wait queue.
-bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
-    DEBUG_ASSERT(lock_.IsHeld());
+bool FutexContext::UnqueueNodeLocked(Bucket& bucket, FutexNode* node) {
+    DEBUG_ASSERT(bucket.lock.IsHeld());
 
     if (!node->IsInQueue())
         return false;
@@ -231,11 +329,12 @@ bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
     // However, that could be out of date if the thread was requeued by
     // FutexRequeue(), so we need to re-get the hash table key here.
     uintptr_t futex_key = node->GetKey();
+    DEBUG_ASSERT(&GetBucket(futex_key) == &bucket);
 
-    FutexNode* old_head = futex_table_.erase(futex_key);
+    FutexNode* old_head = bucket.futex_table.erase(futex_key);
     DEBUG_ASSERT(old_head);
     FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
     if (new_head)
-        futex_table_.insert(new_head);
+        bucket.futex_table.insert(new_head);
     return true;
 }
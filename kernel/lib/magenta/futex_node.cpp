@@ -40,8 +40,42 @@ void FutexNode::SetAsSingletonList() {
     queue_next_ = this;
 }
 
-void FutexNode::AppendList(FutexNode* head) {
-    SpliceNodes(this, head);
+FutexNode* FutexNode::MergeByPriority(FutexNode* list_head, FutexNode* chain) {
+    FutexNode* node = chain;
+    do {
+        // Detach |node| before inserting it; only the forward link is
+        // consumed when walking the remainder of the chain.
+        FutexNode* next = node->queue_next_;
+        node->queue_prev_ = node;
+        node->queue_next_ = node;
+        list_head = InsertByPriority(list_head, node);
+        node = next;
+    } while (node != chain);
+    return list_head;
+}
+
+// Inserts the singleton |node| into the sorted list |list_head| (which may
+// be null) and returns the new head.
+FutexNode* FutexNode::InsertByPriority(FutexNode* list_head, FutexNode* node) {
+    DEBUG_ASSERT(node->queue_next_ == node && node->queue_prev_ == node);
+
+    if (!list_head)
+        return node;
+
+    // Insert before the first node the new waiter outranks; stopping only
+    // on a strict '>' keeps FIFO order among waiters of equal priority.
+    FutexNode* cur = list_head;
+    do {
+        if (node->waiter_priority_ > cur->waiter_priority_) {
+            SpliceNodes(cur, node);
+            return (cur == list_head) ? node : list_head;
+        }
+        cur = cur->queue_next_;
+    } while (cur != list_head);
+
+    // Lowest priority so far: append at the tail.
+    SpliceNodes(list_head, node);
+    return list_head;
 }
 
 // This removes |node| from the list whose first node is |list_head|.  This
@@ -71,13 +105,15 @@ FutexNode* FutexNode::RemoveNodeFromList(FutexNode* list_head,
 // This removes up to |count| nodes from |list_head|.  It returns the new
 // list head (i.e. the list of remaining nodes), which may be null (empty).
 // On return, |list_head| is the list of nodes that were removed --
-// |list_head| remains a valid list.
+// |list_head| remains a valid list.  If |removed_count| is non-null, it is
+// set to the number of nodes actually removed.
 //
 // This will always remove at least one node, because it requires that
 // |count| is non-zero and |list_head| is a non-empty list.
 FutexNode* FutexNode::RemoveFromHead(FutexNode* list_head, uint32_t count,
                                      uintptr_t old_hash_key,
-                                     uintptr_t new_hash_key) {
+                                     uintptr_t new_hash_key,
+                                     uint32_t* removed_count) {
     ASSERT(list_head);
     ASSERT(count != 0);
 
@@ -93,10 +129,15 @@ FutexNode* FutexNode::RemoveFromHead(FutexNode* list_head, uint32_t count,
             // We have reached the end of the list, so we are removing all
             // the entries from the list.  Return an empty list of
             // remaining nodes.
+            if (removed_count)
+                *removed_count = i + 1;
             return nullptr;
         }
     }
 
+    if (removed_count)
+        *removed_count = count;
+
     // Split the list into two lists.
     SpliceNodes(list_head, node);
     return node;
@@ -130,15 +171,26 @@ status_t FutexNode::BlockThread(Mutex* mutex, mx_time_t deadline) TA_NO_THREAD_S
 void FutexNode::WakeThreads(FutexNode* head) {
     if (!head)
         return;
+
+    // Wake the whole chain under a single thread_lock acquisition.  Each
+    // wake unblocks its thread without forcing an immediate reschedule
+    // (remote cpus are still IPI'd as usual); after the batch is unblocked
+    // we give up the cpu once, so broadcasting to N waiters costs one lock
+    // hold and at most one local context switch instead of N.
+    bool woke_threads = false;
+    THREAD_LOCK(state);
     FutexNode* node = head;
     do {
         FutexNode* next = node->queue_next_;
-        THREAD_LOCK(state);
-        wait_queue_wake_one(&node->wait_queue_, true, NO_ERROR);
-        THREAD_UNLOCK(state);
+        if (wait_queue_wake_one(&node->wait_queue_, false, NO_ERROR) > 0)
+            woke_threads = true;
         node->MarkAsNotInQueue();
         node = next;
     } while (node != head);
+    THREAD_UNLOCK(state);
+
+    if (woke_threads)
+        thread_preempt(false);
 }
 
 // Set |node1| and |node2|'s list pointers so that |node1| is immediately
@@ -51,6 +51,12 @@ mx_status_t GuestDispatcher::set_entry(uintptr_t guest_entry) {
     return arch_guest_set_entry(context_, guest_entry);
 }
 
+mx_status_t GuestDispatcher::set_state_area(mxtl::RefPtr<VmObject> vcpu_state_vmo) {
+    canary_.Assert();
+
+    return arch_guest_set_state_area(context_, mxtl::move(vcpu_state_vmo));
+}
+
 #if ARCH_X86_64
 mx_status_t GuestDispatcher::set_cr3(uintptr_t guest_cr3) {
     canary_.Assert();
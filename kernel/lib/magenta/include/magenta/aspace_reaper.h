@@ -0,0 +1,16 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <kernel/vm/vm_aspace.h>
+#include <mxtl/ref_ptr.h>
+
+// Destroy an address space out-of-band on a low priority worker thread,
+// so process teardown does not stall the killer while a large address
+// space is reclaimed. Falls back to destroying |aspace| in the calling
+// context if the work cannot be queued.
+void ReapVmAspace(mxtl::RefPtr<VmAspace> aspace);
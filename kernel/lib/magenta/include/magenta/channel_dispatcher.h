@@ -20,9 +20,12 @@
 #include <mxtl/unique_ptr.h>
 
 class PortClient;
+class PortDispatcherV2;
 
 class ChannelDispatcher final : public Dispatcher {
 public:
+    using MessageList = mxtl::DoublyLinkedList<mxtl::unique_ptr<MessagePacket>>;
+
     static status_t Create(uint32_t flags, mxtl::RefPtr<Dispatcher>* dispatcher0,
                            mxtl::RefPtr<Dispatcher>* dispatcher1, mx_rights_t* rights);
 
@@ -46,8 +49,21 @@ public:
                   mxtl::unique_ptr<MessagePacket>* msg,
                   bool may_disard);
 
+    // Read up to |count| messages from this endpoint's queue under a single
+    // lock acquisition. |max_sizes[i]| is the capacity for the i'th message.
+    // The batch stops early, leaving the message queued, at the first message
+    // that does not fit its slot or that carries handles (which must take the
+    // regular read path). Returns the number of messages popped in |*actual|;
+    // if that is zero, returns the reason the first message was not popped.
+    status_t ReadBatch(const uint32_t* max_sizes, uint32_t count,
+                       mxtl::unique_ptr<MessagePacket>* msgs, uint32_t* actual);
+
     // Write to the opposing endpoint's message queue.
     status_t Write(mxtl::unique_ptr<MessagePacket> msg);
+
+    // Write a list of messages to the opposing endpoint's message queue under
+    // a single lock acquisition on the peer.
+    status_t WriteBatch(MessageList* msgs);
     status_t Call(mxtl::unique_ptr<MessagePacket> msg,
                   mx_time_t deadline, bool* return_handles,
                   mxtl::unique_ptr<MessagePacket>* reply);
@@ -56,6 +72,16 @@ public:
     // after an interruption caused by suspending.
     status_t ResumeInterruptedCall(mx_time_t deadline, mxtl::unique_ptr<MessagePacket>* reply);
 
+    // The async flavor of Call: no thread blocks.  The reply (matched by
+    // the message's txid) is queued like a regular inbound message and an
+    // MX_PKT_TYPE_CALL packet carrying |key| is posted to |port|; if the
+    // call is aborted (either endpoint closing), the packet's status says
+    // why.  As with Write, |*return_handles| is set when the message was
+    // never consumed and the caller must put its handles back.
+    status_t CallAsync(mxtl::unique_ptr<MessagePacket> msg,
+                       mxtl::RefPtr<PortDispatcherV2> port, uint64_t key,
+                       bool* return_handles);
+
     // MessageWaiter's state is guarded by the lock of the
     // owning ChannelDispatcher, and Deliver(), Signal(), Cancel(),
     // and EndWait() methods must only be called under
@@ -128,14 +154,30 @@ public:
     };
 
 private:
-    using MessageList = mxtl::DoublyLinkedList<mxtl::unique_ptr<MessagePacket>>;
     using WaiterList = mxtl::DoublyLinkedList<MessageWaiter*>;
 
+    // An in-flight CallAsync reply registration.  Unlike MessageWaiter no
+    // thread is parked on it: delivery and cancelation both turn into an
+    // MX_PKT_TYPE_CALL packet on |port|.  Guarded by the owning channel's
+    // lock_, like the waiters_ list.
+    struct AsyncWaiter : public mxtl::DoublyLinkedListable<mxtl::unique_ptr<AsyncWaiter>> {
+        // out of line so including this header does not require the full
+        // PortDispatcherV2 type
+        AsyncWaiter(mxtl::RefPtr<PortDispatcherV2> port, uint64_t key, mx_txid_t txid);
+        ~AsyncWaiter();
+
+        const mxtl::RefPtr<PortDispatcherV2> port;
+        const uint64_t key;
+        const mx_txid_t txid;
+    };
+    using AsyncWaiterList = mxtl::DoublyLinkedList<mxtl::unique_ptr<AsyncWaiter>>;
+
     void RemoveWaiter(MessageWaiter* waiter);
 
     ChannelDispatcher(uint32_t flags);
     void Init(mxtl::RefPtr<ChannelDispatcher> other);
     int WriteSelf(mxtl::unique_ptr<MessagePacket> msg);
+    int WriteSelfBatch(MessageList* msgs);
     status_t UserSignalSelf(uint32_t clear_mask, uint32_t set_mask);
     void OnPeerZeroHandles();
 
@@ -144,6 +186,7 @@ private:
     Mutex lock_;
     MessageList messages_ TA_GUARDED(lock_);
     WaiterList waiters_ TA_GUARDED(lock_);
+    AsyncWaiterList async_waiters_ TA_GUARDED(lock_);
     mxtl::unique_ptr<PortClient> iopc_ TA_GUARDED(lock_);
     StateTracker state_tracker_;
     mxtl::RefPtr<ChannelDispatcher> other_ TA_GUARDED(lock_);
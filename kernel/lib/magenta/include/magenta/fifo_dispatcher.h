@@ -65,5 +65,7 @@ private:
     uint32_t tail_ TA_GUARDED(lock_);
     uint8_t* data_ TA_GUARDED(lock_);
 
-    static constexpr uint32_t kMaxSizeBytes = 4096;
+    // Large enough for a block driver to batch a queue depth of requests
+    // per wakeup; the ring is committed kernel heap, so keep it modest.
+    static constexpr uint32_t kMaxSizeBytes = 32768;
 };
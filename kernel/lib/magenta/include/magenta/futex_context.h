@@ -10,6 +10,7 @@
 #include <lib/user_copy/user_ptr.h>
 #include <magenta/futex_node.h>
 #include <magenta/types.h>
+#include <mxtl/atomic.h>
 
 // FutexContext is a class that encapsulates support for futex operations.
 // FutexContext uses a hash table keyed on the futex address (a pointer to integer in userspace)
@@ -23,6 +24,10 @@
 // When the thread at the head of the futex's blocked thread list is resumed,
 // The FutexNode for the new head of the blocked thread list is set as the hash table value
 // for the futex.
+//
+// The table is sharded into independently locked buckets keyed by futex
+// address, so operations on unrelated futexes in the same process do not
+// contend on a single lock.
 class FutexContext {
 public:
     FutexContext();
@@ -51,14 +56,39 @@ private:
     FutexContext(const FutexContext&) = delete;
     FutexContext& operator=(const FutexContext&) = delete;
 
-    void QueueNodesLocked(FutexNode* head) TA_REQ(lock_);
+    static constexpr size_t kNumBuckets = 16;
+
+    struct Bucket {
+        // protects futex_table
+        Mutex lock;
+
+        // Hash table for the futexes that map to this bucket.
+        // Key is futex address, value is the FutexNode for the head of futex's
+        // blocked thread list.
+        FutexNode::HashTable futex_table TA_GUARDED(lock);
+
+        // Number of threads blocked (or committing to block) on a futex in
+        // this bucket.  Incremented by the waiter with seq_cst ordering
+        // *before* it samples the futex value, so a waker that stored a new
+        // futex value and then reads zero here can safely skip taking the
+        // bucket lock: any waiter it could owe a wakeup to must have made
+        // its increment visible first.
+        mxtl::atomic<uint32_t> waiters{0};
+    };
+
+    Bucket& GetBucket(uintptr_t futex_key) {
+        // futex keys are int-aligned userspace addresses
+        return buckets_[(futex_key >> 2) % kNumBuckets];
+    }
+
+    // Acquires and returns the bucket that |node| currently belongs to,
+    // rechecking under the lock since a concurrent FutexRequeue may move the
+    // node to another bucket.
+    Bucket& LockBucketForNode(FutexNode* node);
 
-    bool UnqueueNodeLocked(FutexNode* node) TA_REQ(lock_);
+    void QueueNodesLocked(Bucket& bucket, FutexNode* head) TA_REQ(bucket.lock);
 
-    // protects futex_table_
-    Mutex lock_;
+    bool UnqueueNodeLocked(Bucket& bucket, FutexNode* node) TA_REQ(bucket.lock);
 
-    // Hash table for futexes in this context.
-    // Key is futex address, value is the FutexNode for the head of futex's blocked thread list.
-    FutexNode::HashTable futex_table_ TA_GUARDED(lock_);
+    Bucket buckets_[kNumBuckets];
 };
@@ -28,15 +28,18 @@ public:
     bool IsInQueue() const;
     void SetAsSingletonList();
 
-    // adds a list of nodes to our tail
-    void AppendList(FutexNode* head);
+    // merges every node of |chain| into |list_head|'s list, which is kept
+    // sorted by descending waiter priority (FIFO among waiters of equal
+    // priority), and returns the new head.
+    static FutexNode* MergeByPriority(FutexNode* list_head, FutexNode* chain);
 
     static FutexNode* RemoveNodeFromList(FutexNode* list_head, FutexNode* node);
 
     static FutexNode* RemoveFromHead(FutexNode* list_head,
                                      uint32_t count,
                                      uintptr_t old_hash_key,
-                                     uintptr_t new_hash_key);
+                                     uintptr_t new_hash_key,
+                                     uint32_t* removed_count = nullptr);
 
     // This must be called with |mutex| held and returns without |mutex| held.
     status_t BlockThread(Mutex* mutex, mx_time_t deadline) TA_REL(mutex);
@@ -48,6 +51,11 @@ public:
         hash_key_ = key;
     }
 
+    void set_waiter_priority(int priority) {
+        waiter_priority_ = priority;
+    }
+    int waiter_priority() const { return waiter_priority_; }
+
     // Trait implementation for mxtl::HashTable
     uintptr_t GetKey() const { return hash_key_; }
     static size_t GetHash(uintptr_t key) { return (key >> 3); }
@@ -55,6 +63,7 @@ public:
 private:
     static void RelinkAsAdjacent(FutexNode* node1, FutexNode* node2);
     static void SpliceNodes(FutexNode* node1, FutexNode* node2);
+    static FutexNode* InsertByPriority(FutexNode* list_head, FutexNode* node);
 
     void MarkAsNotInQueue();
 
@@ -76,4 +85,11 @@ private:
     //  * When the thread is not waiting on a futex, queue_next_ is null.
     FutexNode* queue_prev_ = nullptr;
     FutexNode* queue_next_ = nullptr;
+
+    // Effective priority of the blocked thread, sampled when it queued.
+    // FutexWake() pops the highest priority waiters first.  This ABI
+    // carries no owner in the futex value, so the kernel cannot tell whom
+    // a waiter is waiting *on*; the wake ordering is the inheritance-free
+    // half of the anti-inversion story (kernel mutex_t has the full PI).
+    int waiter_priority_ = 0;
 };
@@ -23,6 +23,7 @@ public:
 
     mx_status_t Enter();
     mx_status_t set_entry(uintptr_t guest_entry);
+    mx_status_t set_state_area(mxtl::RefPtr<VmObject> vcpu_state_vmo);
 
 #if ARCH_X86_64
     mx_status_t set_cr3(uintptr_t guest_cr3);
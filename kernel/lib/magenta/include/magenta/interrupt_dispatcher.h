@@ -7,11 +7,17 @@
 #pragma once
 
 #include <kernel/event.h>
+#include <kernel/mutex.h>
+#include <lib/dpc.h>
 
 #include <magenta/dispatcher.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
+#include <mxtl/unique_ptr.h>
 #include <sys/types.h>
 
+class PortClient;
+
 // TODO:
 // - maintain a uint32_t state instead of single bit
 // - provide a way to bind an ID to another ID
@@ -25,6 +31,8 @@ class InterruptDispatcher : public Dispatcher {
 public:
     InterruptDispatcher& operator=(const InterruptDispatcher &) = delete;
 
+    ~InterruptDispatcher();
+
     mx_obj_type_t get_type() const final { return MX_OBJ_TYPE_INTERRUPT; }
 
     // Notify the system that the caller has finished processing the interrupt.
@@ -38,23 +46,52 @@ public:
         return event_wait_deadline(&event_, INFINITE_TIME, true);
     }
 
+    // Batched form of WaitForInterrupt.  Returns the number of interrupts
+    // which have fired since the last batched wait, along with the timestamp
+    // of the most recent one, blocking only when none are pending.  A caller
+    // which falls behind sees a count > 1 instead of paying a wakeup per IRQ.
+    // A given handle should use either this or WaitForInterrupt, not both.
+    status_t WaitForInterruptBatched(uint64_t* out_count, mx_time_t* out_timestamp);
+
+    // Deliver interrupts as port packets instead of (or in addition to)
+    // waking a waiting thread.  Packets are coalesced; at most one is in
+    // flight at a time, with the accumulated count available via a batched
+    // wait or implied by the interrupt protocol.
+    status_t set_port_client(mxtl::unique_ptr<PortClient> client) final;
+
     virtual void on_zero_handles() final {
         // Ensure any waiters stop waiting
         event_signal_etc(&event_, false, ERR_CANCELED);
     }
 
 protected:
-    InterruptDispatcher() {
-        event_init(&event_, false, 0);
-    }
-    int signal(bool resched = false) {
-        return event_signal(&event_, resched);
-    }
+    InterruptDispatcher();
+
+    // Record the interrupt for batched waiters and any bound port, then wake
+    // any waiting thread.  Safe to call from hard IRQ context.
+    int signal(bool resched = false);
+
     void unsignal() {
         event_unsignal(&event_);
     }
 
 private:
+    static void PortPacketDpc(dpc_t* dpc);
+
     mxtl::Canary<mxtl::magic("INTD")> canary_;
     event_t event_;
+
+    // Interrupts accumulated since the last batched wait, and the timestamp
+    // of the most recent one.  Written from IRQ context.
+    mxtl::atomic<uint64_t> pending_count_;
+    mxtl::atomic<uint64_t> last_timestamp_;
+
+    Mutex port_lock_;
+    mxtl::unique_ptr<PortClient> iopc_ TA_GUARDED(port_lock_);
+    // Lock free mirror of (iopc_ != nullptr) so the IRQ path can test for a
+    // bound port without taking port_lock_.
+    mxtl::atomic<uint32_t> port_bound_;
+    // Nonzero while a coalesced packet dpc is queued or being delivered.
+    mxtl::atomic<uint32_t> port_packet_queued_;
+    dpc_t port_dpc_;
 };
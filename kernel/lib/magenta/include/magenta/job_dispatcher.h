@@ -14,9 +14,11 @@
 #include <magenta/policy_manager.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/state_tracker.h>
+#include <magenta/syscalls/object.h>
 #include <magenta/types.h>
 
 #include <mxtl/array.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/ref_counted.h>
@@ -83,14 +85,39 @@ public:
     status_t SetPolicy(uint32_t mode, const mx_policy_basic* in_policy, size_t policy_count);
     pol_cookie_t GetPolicy();
 
+    // Cpuset-style partition (MX_PROP_JOB_CPU_MASK): the cpus threads
+    // created under this job may run on. Applied to threads at creation
+    // and used to clip per-thread affinity masks; 0 means "all cpus".
+    uint32_t cpu_mask() const;
+    status_t set_cpu_mask(uint32_t mask);
+
     // Walks the job/process tree and invokes |je| methods on each node. If
     // |recurse| is false, only visits direct children of this job. Returns
     // false if any methods of |je| return false; returns true otherwise.
     bool EnumerateChildren(JobEnumerator* je, bool recurse);
 
+    // Copies the koids of this job's direct child jobs (if |jobs| is true)
+    // or processes into a kernel buffer. The buffer is sized and allocated
+    // with |lock_| dropped; a generation stamp bumped on every child list
+    // mutation detects concurrent changes, in which case the snapshot is
+    // retried. The lock is only ever held for the koid copy itself, so
+    // callers can stream the result out to user memory without blocking
+    // child creation or teardown.
+    status_t GetChildKoids(bool jobs, mxtl::Array<mx_koid_t>* out_koids);
+
     mxtl::RefPtr<ProcessDispatcher> LookupProcessById(mx_koid_t koid);
     mxtl::RefPtr<JobDispatcher> LookupJobById(mx_koid_t koid);
 
+    // Applies a resource usage delta to this job and every ancestor, so a
+    // job's rollup can be read with a single load per counter instead of
+    // enumerating its task tree. Called by ProcessDispatcher as processes
+    // accrue and release resources; uses relaxed atomics, no locks.
+    void UpdateStats(int64_t mem_delta, int64_t cpu_delta, int64_t handle_delta);
+
+    // Reads the rolled-up counters. The values are approximate; see
+    // mx_info_job_stats_t for how each one is maintained.
+    void GetStats(mx_info_job_stats_t* stats) const;
+
 private:
     enum class State {
         READY,
@@ -124,6 +151,9 @@ private:
     State state_ TA_GUARDED(lock_);
     uint32_t process_count_ TA_GUARDED(lock_);
     uint32_t job_count_ TA_GUARDED(lock_);
+    // Bumped on every child list mutation so GetChildKoids() can detect
+    // that a snapshot went stale while the lock was dropped.
+    uint32_t generation_ TA_GUARDED(lock_);
     StateTracker state_tracker_;
 
     using WeakJobList =
@@ -140,4 +170,17 @@ private:
     WeakProcessList procs_ TA_GUARDED(lock_);
 
     pol_cookie_t policy_ TA_GUARDED(lock_);
+
+    // Cpu partition for this job's threads; 0 means unrestricted. Child
+    // jobs sample their parent's partition at creation. Atomic (like the
+    // stats rollup below) so thread creation can read it without taking
+    // |lock_|.
+    mxtl::atomic<uint32_t> cpu_mask_;
+
+    // Rolled-up resource usage of every process under this job, maintained
+    // via UpdateStats(). Signed so that concurrent deltas can transiently
+    // drive a counter below zero; GetStats() clamps when reporting.
+    mxtl::atomic<int64_t> stats_mem_bytes_{0};
+    mxtl::atomic<int64_t> stats_cpu_time_{0};
+    mxtl::atomic<int64_t> stats_handle_count_{0};
 };
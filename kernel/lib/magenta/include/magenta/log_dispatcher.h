@@ -23,6 +23,8 @@ public:
 
     status_t Write(uint32_t flags, const void* ptr, size_t len);
     status_t Read(uint32_t flags, void* ptr, size_t len, size_t* actual);
+    status_t GetVmo(mxtl::RefPtr<Dispatcher>* vmo_dispatcher, mx_rights_t* rights);
+    status_t Advance(uint64_t position);
 
 private:
     explicit LogDispatcher(uint32_t flags);
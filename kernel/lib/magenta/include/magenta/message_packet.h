@@ -30,6 +30,12 @@ public:
     Handle* const* handles() const { return handles_; }
     Handle** mutable_handles() { return handles_; }
 
+    // When tracing is enabled, messages are stamped with a nonzero trace
+    // id at send; matched TAG_MSGPKT_SEND/TAG_MSGPKT_RECV ktrace records
+    // carrying the id attribute cross-process latency to this message.
+    uint64_t trace_id() const { return trace_id_; }
+    void set_trace_id(uint64_t id) { trace_id_ = id; }
+
     // mx_channel_call treats the leading bytes of the payload as
     // a transaction id of type mx_txid_t.
     mx_txid_t get_txid() const {
@@ -44,12 +50,15 @@ private:
     MessagePacket(uint32_t data_size, uint32_t num_handles, Handle** handles);
     ~MessagePacket();
 
-    static void operator delete(void* ptr) {
-        free(ptr);
-    }
+    // Routes the memory back to the size-class cache it came from, or to
+    // the heap for oversized packets.
+    static void operator delete(void* ptr);
     friend class mxtl::unique_ptr<MessagePacket>;
 
     bool owns_handles_;
+    // size class the backing memory was allocated from, or -1 for the heap
+    int8_t alloc_class_;
+    uint64_t trace_id_;
     uint32_t data_size_;
     uint32_t num_handles_;
     Handle** handles_;
@@ -70,6 +70,14 @@ public:
     // MX_POL_ACTION_DENY all other failure modes.
     uint32_t QueryBasicPolicy(pol_cookie_t policy, uint32_t condition);
 
+    // Flattens |policy| into a bitmask with one bit per MX_POL_xxxx
+    // condition, set when the effective action for that condition
+    // includes MX_POL_ACTION_DENY. ProcessDispatcher caches this at
+    // creation so hot syscall checks are a single load and bit test;
+    // since a job's policy cannot change while it has processes, the
+    // cached mask never goes stale.
+    uint32_t ComputeDenyMask(pol_cookie_t policy);
+
 private:
     PolicyManager(uint32_t default_action);
     ~PolicyManager() = default;
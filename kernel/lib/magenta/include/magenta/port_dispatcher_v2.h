@@ -95,7 +95,8 @@ struct PortPacket final : public mxtl::DoublyLinkedListable<PortPacket*> {
 // callbacks.
 class PortObserver final : public StateObserver {
 public:
-    PortObserver(uint32_t type, Handle* handle, mxtl::RefPtr<PortDispatcherV2> port,
+    PortObserver(uint32_t type, bool counting, Handle* handle,
+                 mxtl::RefPtr<PortDispatcherV2> port,
                  uint64_t key, mx_signals_t signals);
     ~PortObserver() = default;
 
@@ -109,12 +110,15 @@ private:
     bool OnCancel(Handle* handle) final;
     bool OnCancelByKey(Handle* handle, const void* port, uint64_t key) final;
     void OnRemoved() final;
+    mx_signals_t watched_signals() const final { return trigger_; }
 
     // The following method can only be called from
     // OnInitialize(), OnStateChange() and OnCancel().
     void MaybeQueue(mx_signals_t new_state, uint64_t count);
 
     const uint32_t type_;
+    // MX_WAIT_ASYNC_COUNTING: repeat edges coalesce into the pending packet.
+    const bool counting_;
     const uint64_t key_;
     const mx_signals_t trigger_;
     const Handle* const handle_;
@@ -134,10 +138,25 @@ public:
 
     void on_zero_handles() final;
 
-    mx_status_t Queue(PortPacket* port_packet, mx_signals_t observed, uint64_t count);
+    mx_status_t Queue(PortPacket* port_packet, mx_signals_t observed, uint64_t count,
+                      bool coalesce = false);
     mx_status_t QueueUser(const mx_port_packet_t& packet);
+    // Like QueueUser() but the packet is stamped MX_PKT_TYPE_CALL; used by
+    // ChannelDispatcher to deliver mx_channel_call_async completions.
+    mx_status_t QueueCall(const mx_port_packet_t& packet);
     mx_status_t DeQueue(mx_time_t deadline, mx_port_packet_t* packet);
 
+    // Upper bound on packets DeQueueMany() moves per call; bounds both the
+    // caller's buffer and the time spent holding |lock_|.
+    static constexpr size_t kDeQueueBatchMax = 16u;
+
+    // Dequeue up to |count| packets in one |lock_| hold. Blocks until at
+    // least one packet is available (or the deadline passes), then drains
+    // whatever else is pending without further waiting. |packets| must
+    // have room for MIN(count, kDeQueueBatchMax) entries.
+    mx_status_t DeQueueMany(mx_time_t deadline, mx_port_packet_t* packets,
+                            size_t count, size_t* actual);
+
     // Decides who is going to destroy the observer. If it returns |true| it
     // is the duty of the caller. If it is false it is the duty of the port.
     bool CanReap(PortObserver* observer, PortPacket* port_packet);
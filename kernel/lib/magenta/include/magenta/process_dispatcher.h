@@ -22,6 +22,7 @@
 #include <magenta/user_thread.h>
 
 #include <mxtl/array.h>
+#include <mxtl/atomic.h>
 #include <mxtl/canary.h>
 #include <mxtl/intrusive_double_list.h>
 #include <mxtl/ref_counted.h>
@@ -180,6 +181,11 @@ public:
     status_t GetAspaceMaps(user_ptr<mx_info_maps_t> maps, size_t max,
                            size_t* actual, size_t* available);
 
+    // Arm (bytes > 0) or disarm (bytes == 0) the committed-memory watermark;
+    // while the aspace's commit charge sits at or above it the
+    // MX_PROCESS_HIGH_MEMORY signal is asserted on this process.
+    status_t SetMemoryWatermark(size_t bytes);
+
     status_t CreateUserThread(mxtl::StringPiece name, uint32_t flags,
                               mxtl::RefPtr<Dispatcher>* out_dispatcher,
                               mx_rights_t* out_rights);
@@ -193,6 +199,27 @@ public:
     mxtl::RefPtr<ExceptionPort> exception_port();
     mxtl::RefPtr<ExceptionPort> debugger_exception_port();
 
+    // Returns true if any debugger/process/thread exception port is bound
+    // anywhere in this process. Maintained on bind/unbind so exception
+    // dispatch can skip the whole per-process handler chain with one load
+    // in the common no-debugger case. A bind racing with this check can be
+    // missed, which is indistinguishable from binding a moment later.
+    bool HasExceptionPorts() const {
+        return exception_port_count_.load(mxtl::memory_order_relaxed) != 0u;
+    }
+
+    // Track binds/unbinds of this process's exception ports, including its
+    // threads' ports. Called by SetExceptionPort/ResetExceptionPort here and
+    // in UserThread.
+    void IncrementExceptionPortCount() {
+        exception_port_count_.fetch_add(1u, mxtl::memory_order_relaxed);
+    }
+    void DecrementExceptionPortCount() {
+        __UNUSED auto prev =
+            exception_port_count_.fetch_sub(1u, mxtl::memory_order_relaxed);
+        DEBUG_ASSERT(prev > 0u);
+    }
+
     // The following two methods can be slow and innacurrate and should only be
     // called from diagnostics code.
     uint32_t ThreadCount() const;
@@ -259,6 +286,14 @@ private:
     // Kill all threads
     void KillAllThreadsLocked() TA_REQ(state_lock_);
 
+    // Pushes handle-count changes accumulated since the last flush into the
+    // parent job's rollup; see JobDispatcher::UpdateStats().
+    void FlushHandleStatsLocked() TA_REQ(handle_table_lock_);
+
+    // VmAspace::CommitWatermarkFn trampoline; |cookie| is the
+    // ProcessDispatcher that armed the watermark.
+    static void CommitWatermarkThunk(void* cookie, bool above);
+
     mxtl::Canary<mxtl::magic("PROC")> canary_;
 
     // the enclosing job
@@ -267,6 +302,11 @@ private:
     // Policy set by the Job during Create().
     const pol_cookie_t policy_;
 
+    // |policy_| flattened into one deny bit per MX_POL_xxxx condition,
+    // so QueryPolicy() is a load and a bit test. Never stale: a job's
+    // policy cannot change once it has processes.
+    const uint32_t policy_deny_mask_;
+
     // The process can belong to either of these lists independently.
     mxtl::DoublyLinkedListNodeState<ProcessDispatcher*> dll_job_weak_;
     mxtl::SinglyLinkedListNodeState<mxtl::RefPtr<ProcessDispatcher>> dll_job_;
@@ -283,6 +323,12 @@ private:
     mutable Mutex handle_table_lock_; // protects |handles_|.
     mxtl::DoublyLinkedList<Handle*> handles_ TA_GUARDED(handle_table_lock_);
 
+    // Current size of |handles_| and the value last pushed into the job
+    // rollup. Deltas are propagated in batches so the handle hot path
+    // normally touches nothing outside the handle table.
+    int64_t handle_count_ TA_GUARDED(handle_table_lock_) = 0;
+    int64_t reported_handle_count_ TA_GUARDED(handle_table_lock_) = 0;
+
     StateTracker state_tracker_;
 
     FutexContext futex_context_;
@@ -294,11 +340,20 @@ private:
     // process return code
     int retcode_ = 0;
 
+    // Committed memory last pushed into the job rollup; refreshed when
+    // GetStats() samples the address space and retired when the process
+    // dies.
+    int64_t reported_mem_bytes_ TA_GUARDED(state_lock_) = 0;
+
     // Exception ports bound to the process.
     mxtl::RefPtr<ExceptionPort> exception_port_ TA_GUARDED(exception_lock_);
     mxtl::RefPtr<ExceptionPort> debugger_exception_port_ TA_GUARDED(exception_lock_);
     Mutex exception_lock_;
 
+    // Count of exception ports bound to the process, its debugger slot, or
+    // any of its threads; see HasExceptionPorts().
+    mxtl::atomic<uint32_t> exception_port_count_{0u};
+
     // This is the value of _dl_debug_addr from ld.so.
     // See third_party/ulib/musl/ldso/dynlink.c.
     uintptr_t debug_addr_ TA_GUARDED(state_lock_) = 0;
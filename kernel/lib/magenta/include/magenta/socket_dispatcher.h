@@ -42,9 +42,15 @@ public:
 
     status_t HalfClose();
 
-    mx_status_t Read(void* dest, size_t len, bool from_user,
+    // When |peek| is true the data is copied out but left queued, so a later
+    // Read() or Consume() sees the same bytes.
+    mx_status_t Read(void* dest, size_t len, bool from_user, bool peek,
                      size_t* nread);
 
+    // Drops up to |len| queued bytes without copying them, completing a
+    // reservation started with a peeking Read().
+    mx_status_t Consume(size_t len, size_t* nread);
+
     void OnPeerZeroHandles();
 
 private:
@@ -53,7 +59,8 @@ private:
         ~CBuf();
         bool Init(uint32_t len);
         size_t Write(const void* src, size_t len, bool from_user);
-        size_t Read(void* dest, size_t len, bool from_user);
+        size_t Read(void* dest, size_t len, bool from_user, bool peek);
+        size_t Discard(size_t len);
         size_t CouldRead() const;
         size_t free() const;
         bool empty() const;
@@ -40,6 +40,12 @@ public:
     // WARNING: This is called under StateTracker's mutex
     virtual bool OnStateChange(mx_signals_t new_state) = 0;
 
+    // The set of signals this observer cares about. UpdateState() skips observers whose
+    // watched set does not intersect the bits that actually changed; the default (all
+    // bits) preserves delivery of every change. Must be constant while the observer is
+    // registered.
+    virtual mx_signals_t watched_signals() const { return ~0u; }
+
     // Called when |handle| (which refers to a handle to the object that owns the StateTracker) is
     // being destroyed/"closed"/transferred. (The object itself, and thus the StateTracker too, may
     // also be destroyed shortly afterwards.) Returns true if a thread was awoken.
@@ -29,6 +29,8 @@ public:
 
     status_t GetInfo(mx_info_thread_t* info);
 
+    status_t GetStats(mx_info_thread_stats_t* info);
+
     status_t GetExceptionReport(mx_exception_report_t* report);
 
     mx_status_t Resume() { return thread_->Resume(); }
@@ -24,6 +24,7 @@
 #include <mxtl/ref_counted.h>
 #include <mxtl/ref_ptr.h>
 #include <mxtl/string_piece.h>
+#include <mxtl/unique_ptr.h>
 
 class ProcessDispatcher;
 class ThreadDispatcher;
@@ -123,6 +124,15 @@ public:
                                       ExceptionStatus* out_estatus);
     // Called when an exception handler is finished processing the exception.
     status_t MarkExceptionHandled(ExceptionStatus estatus);
+    // Resume the thread from its current exception with the cpu's
+    // single-step flag set, and block until it stops again at the next
+    // instruction (or at whatever exception it hits first). The stop does
+    // not generate a report on the exception port; the caller is the
+    // consumer. On success the thread is stopped in an exception again and
+    // its register state can be read/written as usual.
+    // Returns ERR_BAD_STATE if the thread is not stopped in an exception,
+    // or if it dies before stopping again.
+    status_t StepFromException();
     // Called when exception port |eport| is removed.
     // If the thread is waiting for the associated exception handler, continue
     // exception processing as if the exception port had not been installed.
@@ -138,6 +148,24 @@ public:
     // Fetch the state of the thread for userspace tools.
     void GetInfoForUserspace(mx_info_thread_t* info);
 
+    // Fetch the scheduler counters of the thread for userspace tools.
+    void GetStatsForUserspace(mx_info_thread_stats_t* info);
+
+    // Default timer slack applied to this thread's timed waits; see
+    // thread_set_timer_slack().
+    void set_timer_slack(lk_time_t slack) { thread_set_timer_slack(&thread_, slack); }
+    lk_time_t timer_slack() const { return thread_.timer_slack; }
+
+    // Move the thread into (period != 0) or out of (period == 0) the
+    // deadline scheduling class; see thread_set_deadline().
+    status_t set_deadline(lk_time_t capacity, lk_time_t rel_deadline, lk_time_t period) {
+        return thread_set_deadline(&thread_, capacity, rel_deadline, period);
+    }
+
+    // Restrict the cpus the thread may run on, clipped to the job's cpu
+    // partition; see thread_set_cpu_affinity().
+    status_t set_cpu_affinity(uint32_t mask);
+
     // For debugger usage.
     // TODO(dje): The term "state" here conflicts with "state tracker".
     uint32_t get_num_state_kinds() const;
@@ -154,6 +182,19 @@ public:
     // For ChannelDispatcher use.
     ChannelDispatcher::MessageWaiter* GetMessageWaiter() { return &channel_waiter_; }
 
+    // Capacity of the buffer returned by GetScratchBuffer().
+    static constexpr size_t kScratchSize = PAGE_SIZE;
+
+    // For syscall use: returns a scratch buffer of at least |size| bytes
+    // private to this thread, or nullptr if |size| exceeds kScratchSize or
+    // the one-time allocation fails. Hot syscalls that stage small
+    // variable-length user arrays use this in place of a heap allocation
+    // per call; user data must still go through the usual fault-safe copy
+    // paths. The buffer is only valid until the current syscall returns,
+    // so a caller must be done with it before handing it out again.
+    // Only ever called by this thread itself, so no locking is needed.
+    void* GetScratchBuffer(size_t size);
+
 private:
     UserThread(const UserThread&) = delete;
     UserThread& operator=(const UserThread&) = delete;
@@ -219,6 +260,13 @@ private:
     Mutex exception_wait_lock_;
     event_t exception_event_ = EVENT_INITIAL_VALUE(exception_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
 
+    // True while a StepFromException() caller is waiting for the thread to
+    // stop at the next instruction. The next exception the thread takes is
+    // consumed by the stepper instead of being reported to a port.
+    bool step_pending_ TA_GUARDED(exception_wait_lock_) = false;
+    // Signaled when the single-stepped thread has stopped again (or died).
+    event_t stepped_event_ = EVENT_INITIAL_VALUE(stepped_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
+
     // cleanup dpc structure
     dpc_t cleanup_dpc_ = {};
 
@@ -234,6 +282,9 @@ private:
     mxtl::RefPtr<VmAddressRegion> unsafe_kstack_vmar_;
 #endif
 
+    // Lazily allocated backing store for GetScratchBuffer().
+    mxtl::unique_ptr<uint8_t[]> scratch_buffer_;
+
     // Per-thread structure used while waiting in a ChannelDispatcher::Call.
     // Needed to support the requirements of being able to interrupt a Call
     // in order to suspend a thread.
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <kernel/vm/vm_object.h>
+
 #include <magenta/dispatcher.h>
 #include <magenta/state_tracker.h>
 #include <mxtl/canary.h>
@@ -31,6 +33,8 @@ public:
                      uint64_t offset, size_t* actual);
     mx_status_t Write(user_ptr<const void> user_data, size_t length,
                       uint64_t offset, size_t* actual);
+    mx_status_t ReadVector(VmObject::UserVec* vec, size_t count, size_t* segments_done);
+    mx_status_t WriteVector(VmObject::UserVec* vec, size_t count, size_t* segments_done);
     mx_status_t SetSize(uint64_t);
     mx_status_t GetSize(uint64_t* size);
     mx_status_t RangeOp(uint32_t op, uint64_t offset, uint64_t size, user_ptr<void> buffer, size_t buffer_size);
@@ -0,0 +1,108 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <magenta/interrupt_dispatcher.h>
+
+#include <err.h>
+#include <platform.h>
+
+#include <kernel/auto_lock.h>
+#include <magenta/port_client.h>
+#include <mxtl/ref_ptr.h>
+
+InterruptDispatcher::InterruptDispatcher()
+    : pending_count_(0u),
+      last_timestamp_(0u),
+      port_bound_(0u),
+      port_packet_queued_(0u) {
+    event_init(&event_, false, 0);
+    list_clear_node(&port_dpc_.node);
+    port_dpc_.func = PortPacketDpc;
+    port_dpc_.arg  = this;
+}
+
+InterruptDispatcher::~InterruptDispatcher() {
+    // Any in-flight packet dpc holds a reference to us, so by the time we get
+    // here there cannot be one queued.
+    DEBUG_ASSERT(!port_packet_queued_.load());
+}
+
+int InterruptDispatcher::signal(bool resched) {
+    // Accumulate for batched waiters.  The count is published after the
+    // timestamp so a waiter which observes the count sees a timestamp at
+    // least as recent as the interrupt which produced it.
+    last_timestamp_.store(current_time(), mxtl::memory_order_relaxed);
+    pending_count_.fetch_add(1u, mxtl::memory_order_release);
+
+    // If a port is bound and no packet is already in flight, queue one.
+    // Interrupts which arrive while a packet is pending are coalesced into
+    // it; the accumulated count is available via a batched wait.
+    if (port_bound_.load(mxtl::memory_order_acquire) &&
+        !port_packet_queued_.exchange(1u, mxtl::memory_order_acq_rel)) {
+        // The dpc holds a reference to us so that we cannot be destroyed
+        // while delivery is pending.  Adopted by PortPacketDpc.
+        AddRef();
+        dpc_queue_low_latency(&port_dpc_, false);
+    }
+
+    return event_signal(&event_, resched);
+}
+
+status_t InterruptDispatcher::WaitForInterruptBatched(uint64_t* out_count,
+                                                      mx_time_t* out_timestamp) {
+    canary_.Assert();
+
+    for (;;) {
+        // Rearm the event before checking for accumulated interrupts so an
+        // IRQ which slips in between the check and the park either shows up
+        // in the count or leaves the event signaled.
+        unsignal();
+
+        uint64_t count = pending_count_.exchange(0u, mxtl::memory_order_acquire);
+        if (count > 0u) {
+            *out_count = count;
+            *out_timestamp = last_timestamp_.load(mxtl::memory_order_relaxed);
+            return NO_ERROR;
+        }
+
+        status_t status = event_wait_deadline(&event_, INFINITE_TIME, true);
+        if (status != NO_ERROR)
+            return status;
+    }
+}
+
+status_t InterruptDispatcher::set_port_client(mxtl::unique_ptr<PortClient> client) {
+    canary_.Assert();
+
+    if ((client->get_trigger_signals() & ~MX_INTERRUPT_SIGNALED) != 0)
+        return ERR_INVALID_ARGS;
+
+    AutoLock lock(&port_lock_);
+    if (iopc_)
+        return ERR_BAD_STATE;
+
+    iopc_ = mxtl::move(client);
+    port_bound_.store(1u, mxtl::memory_order_release);
+    return NO_ERROR;
+}
+
+void InterruptDispatcher::PortPacketDpc(dpc_t* dpc) {
+    // Adopt the reference taken when the dpc was queued.
+    auto thiz = mxtl::internal::MakeRefPtrNoAdopt(
+            reinterpret_cast<InterruptDispatcher*>(dpc->arg));
+
+    // Clear the in-flight flag before delivering so an interrupt which
+    // arrives while we are signaling produces a fresh packet instead of
+    // being silently dropped.
+    thiz->port_packet_queued_.store(0u, mxtl::memory_order_release);
+
+    AutoLock lock(&thiz->port_lock_);
+    if (thiz->iopc_ && !thiz->iopc_->Signal(MX_INTERRUPT_SIGNALED, &thiz->port_lock_)) {
+        // The far end of the port is gone; drop our client.
+        thiz->iopc_.reset();
+        thiz->port_bound_.store(0u, mxtl::memory_order_release);
+    }
+}
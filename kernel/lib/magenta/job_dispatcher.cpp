@@ -50,8 +50,10 @@ JobDispatcher::JobDispatcher(uint32_t /*flags*/,
     : parent_(mxtl::move(parent)),
       state_(State::READY),
       process_count_(0u), job_count_(0u),
+      generation_(0u),
       state_tracker_(MX_JOB_NO_PROCESSES|MX_JOB_NO_JOBS),
-      policy_(policy) {
+      policy_(policy),
+      cpu_mask_(parent_ ? parent_->cpu_mask() : 0u) {
 }
 
 JobDispatcher::~JobDispatcher() {
@@ -75,6 +77,7 @@ bool JobDispatcher::AddChildProcess(ProcessDispatcher* process) {
         return false;
     procs_.push_back(process);
     ++process_count_;
+    ++generation_;
     UpdateSignalsIncrementLocked();
     return true;
 }
@@ -88,6 +91,7 @@ bool JobDispatcher::AddChildJob(JobDispatcher* job) {
 
     jobs_.push_back(job);
     ++job_count_;
+    ++generation_;
     UpdateSignalsIncrementLocked();
     return true;
 }
@@ -101,6 +105,7 @@ void JobDispatcher::RemoveChildProcess(ProcessDispatcher* process) {
         return;
     procs_.erase(*process);
     --process_count_;
+    ++generation_;
     UpdateSignalsDecrementLocked();
 }
 
@@ -112,6 +117,7 @@ void JobDispatcher::RemoveChildJob(JobDispatcher* job) {
         return;
     jobs_.erase(*job);
     --job_count_;
+    ++generation_;
     UpdateSignalsDecrementLocked();
 }
 
@@ -219,6 +225,25 @@ status_t JobDispatcher::SetPolicy(
     return NO_ERROR;
 }
 
+uint32_t JobDispatcher::cpu_mask() const {
+    return cpu_mask_.load(mxtl::memory_order_relaxed);
+}
+
+status_t JobDispatcher::set_cpu_mask(uint32_t mask) {
+    // Stay within the partition of the parent job, if it has one. Like
+    // SetPolicy(), the parent's value is sampled here; existing threads
+    // are not repartitioned.
+    uint32_t parent_mask = parent_ ? parent_->cpu_mask() : 0u;
+    if (parent_mask != 0u) {
+        mask = (mask == 0u) ? parent_mask : (mask & parent_mask);
+        if (mask == 0u)
+            return ERR_INVALID_ARGS;
+    }
+
+    cpu_mask_.store(mask, mxtl::memory_order_relaxed);
+    return NO_ERROR;
+}
+
 bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
     canary_.Assert();
 
@@ -244,6 +269,86 @@ bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
     return true;
 }
 
+status_t JobDispatcher::GetChildKoids(bool jobs, mxtl::Array<mx_koid_t>* out_koids) {
+    canary_.Assert();
+
+    mxtl::Array<mx_koid_t> koids;
+    uint32_t gen;
+    size_t count;
+
+    {
+        AutoLock lock(&lock_);
+        gen = generation_;
+        count = jobs ? job_count_ : process_count_;
+    }
+
+    for (;;) {
+        // Size and allocate the buffer with the lock dropped so child
+        // creation and teardown are never gated on the allocator. Any
+        // mutation in the meantime bumps |generation_| and sends us
+        // around again with the new count.
+        // The array's size doubles as the result count, so resize on any
+        // mismatch, not just growth.
+        if (count != koids.size()) {
+            AllocChecker ac;
+            koids.reset(new (&ac) mx_koid_t[count], count);
+            if (!ac.check())
+                return ERR_NO_MEMORY;
+        }
+
+        AutoLock lock(&lock_);
+        if (generation_ != gen) {
+            gen = generation_;
+            count = jobs ? job_count_ : process_count_;
+            continue;
+        }
+        // An unchanged generation implies an unchanged list, so |count|
+        // children are guaranteed to fit.
+        size_t i = 0;
+        if (jobs) {
+            for (auto& job : jobs_)
+                koids[i++] = job.get_koid();
+        } else {
+            for (auto& proc : procs_)
+                koids[i++] = proc.get_koid();
+        }
+        DEBUG_ASSERT(i == count);
+        break;
+    }
+
+    *out_koids = mxtl::move(koids);
+    return NO_ERROR;
+}
+
+void JobDispatcher::UpdateStats(int64_t mem_delta, int64_t cpu_delta,
+                                int64_t handle_delta) {
+    canary_.Assert();
+
+    // Ancestors are kept alive by the RefPtr each child holds on its
+    // parent, so the walk is safe without taking any job's |lock_|.
+    for (JobDispatcher* job = this; job != nullptr; job = job->parent_.get()) {
+        if (mem_delta != 0)
+            job->stats_mem_bytes_.fetch_add(mem_delta, mxtl::memory_order_relaxed);
+        if (cpu_delta != 0)
+            job->stats_cpu_time_.fetch_add(cpu_delta, mxtl::memory_order_relaxed);
+        if (handle_delta != 0)
+            job->stats_handle_count_.fetch_add(handle_delta, mxtl::memory_order_relaxed);
+    }
+}
+
+void JobDispatcher::GetStats(mx_info_job_stats_t* stats) const {
+    canary_.Assert();
+
+    // Concurrent deltas can be observed in any order, so clamp the
+    // transiently-negative case rather than report a huge unsigned value.
+    auto mem = stats_mem_bytes_.load(mxtl::memory_order_relaxed);
+    auto cpu = stats_cpu_time_.load(mxtl::memory_order_relaxed);
+    auto handles = stats_handle_count_.load(mxtl::memory_order_relaxed);
+    stats->mem_committed_bytes = (mem > 0) ? static_cast<size_t>(mem) : 0u;
+    stats->cpu_time = (cpu > 0) ? static_cast<mx_time_t>(cpu) : 0u;
+    stats->handle_count = (handles > 0) ? static_cast<uint64_t>(handles) : 0u;
+}
+
 mxtl::RefPtr<ProcessDispatcher> JobDispatcher::LookupProcessById(mx_koid_t koid) {
     canary_.Assert();
 
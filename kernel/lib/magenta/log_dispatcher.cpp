@@ -6,6 +6,9 @@
 
 #include <magenta/log_dispatcher.h>
 #include <magenta/syscalls/log.h>
+#include <magenta/vm_object_dispatcher.h>
+
+#include <kernel/vm/vm_object_paged.h>
 
 #include <err.h>
 #include <new.h>
@@ -13,6 +16,14 @@
 constexpr mx_rights_t kDefaultEventRights =
     MX_RIGHT_TRANSFER | MX_RIGHT_WRITE | MX_RIGHT_DUPLICATE;
 
+// All log dispatchers share one VMO aliasing the kernel's ring (the
+// export region is global); it is created on first use and lives forever.
+static Mutex ring_vmo_lock;
+static mxtl::RefPtr<VmObject> ring_vmo TA_GUARDED(ring_vmo_lock);
+
+static_assert(sizeof(mx_log_ring_header_t) == sizeof(dlog_export_header_t),
+              "kernel and userspace ring headers must match");
+
 status_t LogDispatcher::Create(uint32_t flags, mxtl::RefPtr<Dispatcher>* dispatcher,
                                mx_rights_t* rights) {
     AllocChecker ac;
@@ -73,3 +84,51 @@ status_t LogDispatcher::Read(uint32_t flags, void* ptr, size_t len, size_t* actu
     return status;
 }
 
+status_t LogDispatcher::GetVmo(mxtl::RefPtr<Dispatcher>* vmo_dispatcher, mx_rights_t* rights) {
+    canary_.Assert();
+
+    if (!(flags_ & MX_LOG_FLAG_READABLE))
+        return ERR_BAD_STATE;
+
+    mxtl::RefPtr<VmObject> vmo;
+    {
+        AutoLock lock(&ring_vmo_lock);
+        if (!ring_vmo) {
+            size_t size;
+            const void* region = dlog_export_region(&size);
+            ring_vmo = VmObjectPaged::CreateFromROData(region, size);
+            if (!ring_vmo)
+                return ERR_NO_MEMORY;
+        }
+        vmo = ring_vmo;
+    }
+
+    status_t status = VmObjectDispatcher::Create(mxtl::move(vmo), vmo_dispatcher, rights);
+    if (status != NO_ERROR)
+        return status;
+
+    // the ring is read-only to userspace; the kernel is the only writer
+    *rights &= ~MX_RIGHT_WRITE;
+    return NO_ERROR;
+}
+
+status_t LogDispatcher::Advance(uint64_t position) {
+    canary_.Assert();
+
+    if (!(flags_ & MX_LOG_FLAG_READABLE))
+        return ERR_BAD_STATE;
+
+    AutoLock lock(&lock_);
+
+    // Signal() takes |lock_| after an append commits, so an append that
+    // slips in after the committed load inside dlog_reader_advance
+    // re-asserts the readable signal after we clear it, never before.
+    mx_status_t status = dlog_reader_advance(&reader_, position);
+    if (status == ERR_SHOULD_WAIT) {
+        state_tracker_.UpdateState(MX_CHANNEL_READABLE, 0);
+        return NO_ERROR;
+    }
+
+    return status;
+}
+
@@ -216,15 +216,17 @@ void DeleteHandle(Handle* handle) {
     handle_arena.Free(handle);
 }
 
-bool HandleInRange(void* addr) {
-    AutoLock lock(&handle_mutex);
-    return handle_arena.in_range(addr);
-}
-
 Handle* MapU32ToHandle(uint32_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
     auto index = value & kHandleIndexMask;
     auto va = &reinterpret_cast<Handle*>(handle_arena.start())[index];
-    if (!HandleInRange(va))
+    // This is called on every syscall that takes a handle, so don't take
+    // |handle_mutex| just to bound the probe: the arena's allocated extent
+    // only grows (the handle arena must never call TrimFreeSpans()), and
+    // any handle legitimately owned by the calling process
+    // was published under the process's handle table lock, which the caller
+    // holds. The slot reads below were always unsynchronized; stale or
+    // freed slots fail the base_value and process_id checks.
+    if (!handle_arena.in_range_unlocked(va))
         return nullptr;
     Handle *handle = reinterpret_cast<Handle*>(va);
     return handle->base_value() == value ? handle : nullptr;
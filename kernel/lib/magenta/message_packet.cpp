@@ -4,16 +4,111 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <assert.h>
 #include <err.h>
 #include <new.h>
+#include <stdlib.h>
 
+#include <arch/ops.h>
+#include <kernel/mp.h>
+#include <kernel/spinlock.h>
+#include <magenta/compiler.h>
 #include <magenta/handle_reaper.h>
 #include <magenta/magenta.h>
 #include <magenta/message_packet.h>
 
+// Messages are capped well below the point where the double copy
+// (user->packet on write, packet->user on read) dominates. Those copies are
+// inherent to the byte-array ABI of mx_channel_write/read; bulk payloads
+// that want to avoid them should transfer a VMO handle through the channel
+// instead, which moves pages by reference rather than by copy.
 constexpr uint32_t kMaxMessageSize = 65536u;
 constexpr uint32_t kMaxMessageHandles = 1024u;
 
+// The limits are baked into the vDSO's fast-fail channel_write entry
+// point, so they must stay in sync with the published constants.
+static_assert(kMaxMessageSize == MX_CHANNEL_MAX_MSG_BYTES, "");
+static_assert(kMaxMessageHandles == MX_CHANNEL_MAX_MSG_HANDLES, "");
+
+namespace {
+
+// Per-cpu caches of packet buffers, keyed by size class, so the small
+// message path (the bulk of channel traffic) does not take the global heap
+// lock on every write. Freed packets are stashed on the local cpu's list,
+// up to a cap, and reused by later allocations of the same class.
+constexpr size_t kPacketClassSizes[] = {256u, 1024u, 2048u};
+constexpr size_t kNumPacketClasses = countof(kPacketClassSizes);
+constexpr size_t kPacketCacheMaxPerClass = 32u;
+
+struct PacketFreeNode {
+    PacketFreeNode* next;
+};
+
+struct PacketCache {
+    SpinLock lock;
+    PacketFreeNode* head[kNumPacketClasses];
+    size_t count[kNumPacketClasses];
+} __CPU_ALIGN;
+
+PacketCache packet_cache[SMP_MAX_CPUS];
+
+PacketCache* packet_cache_lock(spin_lock_saved_state_t* state) {
+    arch_interrupt_save(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    PacketCache* cache = &packet_cache[arch_curr_cpu_num()];
+    spin_lock(cache->lock.GetInternal());
+    return cache;
+}
+
+void packet_cache_unlock(PacketCache* cache, spin_lock_saved_state_t state) {
+    spin_unlock(cache->lock.GetInternal());
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+}
+
+// Returns the smallest size class able to hold |size| bytes, or -1 if the
+// allocation should come straight from the heap.
+int packet_class_for_size(size_t size) {
+    for (size_t i = 0u; i < kNumPacketClasses; i++) {
+        if (size <= kPacketClassSizes[i])
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void* packet_cache_alloc(int cls) {
+    spin_lock_saved_state_t state;
+    PacketCache* cache = packet_cache_lock(&state);
+    PacketFreeNode* node = cache->head[cls];
+    if (node) {
+        cache->head[cls] = node->next;
+        DEBUG_ASSERT(cache->count[cls] > 0u);
+        cache->count[cls]--;
+    }
+    packet_cache_unlock(cache, state);
+
+    if (unlikely(!node))
+        return malloc(kPacketClassSizes[cls]);
+    return node;
+}
+
+void packet_cache_free(int cls, void* ptr) {
+    spin_lock_saved_state_t state;
+    PacketCache* cache = packet_cache_lock(&state);
+    if (likely(cache->count[cls] < kPacketCacheMaxPerClass)) {
+        auto node = static_cast<PacketFreeNode*>(ptr);
+        node->next = cache->head[cls];
+        cache->head[cls] = node;
+        cache->count[cls]++;
+        ptr = nullptr;
+    }
+    packet_cache_unlock(cache, state);
+
+    // the local cache was full; give the buffer back to the heap
+    if (unlikely(ptr))
+        free(ptr);
+}
+
+} // namespace
+
 // static
 mx_status_t MessagePacket::Create(uint32_t data_size, uint32_t num_handles,
                                   mxtl::unique_ptr<MessagePacket>* msg) {
@@ -23,10 +118,13 @@ mx_status_t MessagePacket::Create(uint32_t data_size, uint32_t num_handles,
         return ERR_OUT_OF_RANGE;
 
     // Allocate space for the MessagePacket object followed by num_handles
-    // Handle*s followed by data_size bytes.
-    char* ptr = static_cast<char*>(malloc(sizeof(MessagePacket) +
-                                          num_handles * sizeof(Handle*) +
-                                          data_size));
+    // Handle*s followed by data_size bytes, preferring the size-class cache
+    // for small packets.
+    const size_t size = sizeof(MessagePacket) +
+                        num_handles * sizeof(Handle*) +
+                        data_size;
+    const int cls = packet_class_for_size(size);
+    char* ptr = static_cast<char*>((cls >= 0) ? packet_cache_alloc(cls) : malloc(size));
     if (ptr == nullptr)
         return ERR_NO_MEMORY;
 
@@ -35,9 +133,22 @@ mx_status_t MessagePacket::Create(uint32_t data_size, uint32_t num_handles,
     // fill these arrays immediately after creation of the object.
     msg->reset(new (ptr) MessagePacket(data_size, num_handles,
                                        reinterpret_cast<Handle**>(ptr + sizeof(MessagePacket))));
+    (*msg)->alloc_class_ = static_cast<int8_t>(cls);
     return NO_ERROR;
 }
 
+// static
+void MessagePacket::operator delete(void* ptr) {
+    // alloc_class_ is trivially destructible, so it is still readable here
+    // even though the destructor has already run
+    const int8_t cls = static_cast<MessagePacket*>(ptr)->alloc_class_;
+    if (likely(cls >= 0)) {
+        packet_cache_free(cls, ptr);
+    } else {
+        free(ptr);
+    }
+}
+
 MessagePacket::~MessagePacket() {
     if (owns_handles_) {
         // Delete handles out-of-band to avoid the worst case recursive
@@ -47,5 +158,6 @@ MessagePacket::~MessagePacket() {
 }
 
 MessagePacket::MessagePacket(uint32_t data_size, uint32_t num_handles, Handle** handles)
-    : owns_handles_(false), data_size_(data_size), num_handles_(num_handles), handles_(handles) {
+    : owns_handles_(false), trace_id_(0u), data_size_(data_size), num_handles_(num_handles),
+      handles_(handles) {
 }
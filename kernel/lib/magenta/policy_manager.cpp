@@ -155,6 +155,20 @@ uint32_t PolicyManager::QueryBasicPolicy(pol_cookie_t policy, uint32_t condition
     };
 }
 
+uint32_t PolicyManager::ComputeDenyMask(pol_cookie_t policy) {
+    static_assert(MX_POL_MAX <= sizeof(uint32_t) * 8u, "mask too small");
+
+    uint32_t mask = 0u;
+    for (uint32_t condition = 0u; condition != MX_POL_MAX; ++condition) {
+        // Note this covers MX_POL_NEW_ANY as well: QueryBasicPolicy
+        // denies it (it is an AddPolicy-time pseudo condition), which
+        // matches what a direct query would have returned.
+        if (QueryBasicPolicy(policy, condition) & MX_POL_ACTION_DENY)
+            mask |= 1u << condition;
+    }
+    return mask;
+}
+
 uint32_t PolicyManager::GetEffectiveAction(uint64_t policy) {
     return Encoding::is_default(policy) ?
         default_action_ : Encoding::action(policy);
@@ -25,9 +25,11 @@ PortPacket::PortPacket() : packet{}, observer(nullptr) {
     // Note that packet is initialized to zeros.
 }
 
-PortObserver::PortObserver(uint32_t type, Handle* handle, mxtl::RefPtr<PortDispatcherV2> port,
+PortObserver::PortObserver(uint32_t type, bool counting, Handle* handle,
+                           mxtl::RefPtr<PortDispatcherV2> port,
                            uint64_t key, mx_signals_t signals)
     : type_(type),
+      counting_(counting),
       key_(key),
       trigger_(signals),
       handle_(handle),
@@ -84,7 +86,7 @@ void PortObserver::MaybeQueue(mx_signals_t new_state, uint64_t count) {
     if ((trigger_ & new_state) == 0u)
         return;
 
-    auto status = port_->Queue(&packet_, new_state, count);
+    auto status = port_->Queue(&packet_, new_state, count, counting_);
 
     if ((type_ == MX_PKT_TYPE_SIGNAL_ONE) || (status < 0))
         remove_ = true;
@@ -141,9 +143,27 @@ mx_status_t PortDispatcherV2::QueueUser(const mx_port_packet_t& packet) {
     return status;
 }
 
+mx_status_t PortDispatcherV2::QueueCall(const mx_port_packet_t& packet) {
+    canary_.Assert();
+
+    AllocChecker ac;
+    auto port_packet = new (&ac) PortPacket();
+    if (!ac.check())
+        return ERR_NO_MEMORY;
+
+    port_packet->packet = packet;
+    port_packet->packet.type = MX_PKT_TYPE_CALL;
+
+    auto status = Queue(port_packet, 0u, 0u);
+    if (status < 0)
+        delete port_packet;
+    return status;
+}
+
 mx_status_t PortDispatcherV2::Queue(PortPacket* port_packet,
                                     mx_signals_t observed,
-                                    uint64_t count) {
+                                    uint64_t count,
+                                    bool coalesce) {
     canary_.Assert();
 
     int wake_count = 0;
@@ -153,8 +173,16 @@ mx_status_t PortDispatcherV2::Queue(PortPacket* port_packet,
             return ERR_BAD_STATE;
 
         if (observed) {
-            if (port_packet->InContainer())
+            if (port_packet->InContainer()) {
+                // The packet is still pending so the consumer has not been
+                // woken yet. In coalescing mode fold this edge into it:
+                // freshest signal snapshot, accumulated observation count.
+                if (coalesce) {
+                    port_packet->packet.signal.observed = observed;
+                    port_packet->packet.signal.count += count;
+                }
                 return NO_ERROR;
+            }
             port_packet->packet.signal.observed = observed;
             port_packet->packet.signal.count = count;
         }
@@ -187,7 +215,8 @@ mx_status_t PortDispatcherV2::DeQueue(mx_time_t deadline, mx_port_packet_t* pack
 
         if (observer)
             delete observer;
-        else if (packet && packet->type == MX_PKT_TYPE_USER)
+        else if ((port_packet->type() == MX_PKT_TYPE_USER) ||
+                 (port_packet->type() == MX_PKT_TYPE_CALL))
             delete port_packet;
         return NO_ERROR;
 
@@ -198,11 +227,61 @@ wait:
     }
 }
 
+mx_status_t PortDispatcherV2::DeQueueMany(mx_time_t deadline, mx_port_packet_t* packets,
+                                          size_t count, size_t* actual) {
+    canary_.Assert();
+
+    if (count > kDeQueueBatchMax)
+        count = kDeQueueBatchMax;
+
+    // Destruction of observers and user packets is deferred until the
+    // lock has been dropped.
+    PortObserver* observers[kDeQueueBatchMax];
+    PortPacket* user_packets[kDeQueueBatchMax];
+    size_t n = 0;
+    size_t n_obs = 0;
+    size_t n_user = 0;
+
+    while (true) {
+        {
+            AutoLock al(&lock_);
+            while ((n < count) && !packets_.is_empty()) {
+                PortPacket* port_packet = packets_.pop_front();
+                PortObserver* observer = CopyLocked(port_packet, &packets[n]);
+                if (observer)
+                    observers[n_obs++] = observer;
+                else if ((port_packet->type() == MX_PKT_TYPE_USER) ||
+                         (port_packet->type() == MX_PKT_TYPE_CALL))
+                    user_packets[n_user++] = port_packet;
+                n++;
+            }
+        }
+
+        if (n > 0) {
+            for (size_t ix = 0; ix != n_obs; ++ix)
+                delete observers[ix];
+            for (size_t ix = 0; ix != n_user; ++ix)
+                delete user_packets[ix];
+            // As with DeQueue(), surplus semaphore counts from the drained
+            // packets only cause spurious wakeups, which re-check the queue.
+            *actual = n;
+            return NO_ERROR;
+        }
+
+        status_t st = sema_.Wait(deadline);
+        if (st != NO_ERROR)
+            return st;
+    }
+}
+
 PortObserver* PortDispatcherV2::CopyLocked(PortPacket* port_packet, mx_port_packet_t* packet) {
     if (packet)
         *packet = port_packet->packet;
 
-    return (port_packet->type() == MX_PKT_TYPE_USER) ? nullptr : port_packet->observer;
+    return ((port_packet->type() == MX_PKT_TYPE_USER) ||
+            (port_packet->type() == MX_PKT_TYPE_CALL))
+               ? nullptr
+               : port_packet->observer;
 }
 
 bool PortDispatcherV2::CanReap(PortObserver* observer, PortPacket* port_packet) {
@@ -230,8 +309,9 @@ mx_status_t PortDispatcherV2::MakeObservers(uint32_t options, Handle* handle,
     AllocChecker ac;
     auto type = (options == MX_WAIT_ASYNC_ONCE) ?
         MX_PKT_TYPE_SIGNAL_ONE : MX_PKT_TYPE_SIGNAL_REP;
+    auto counting = (options == MX_WAIT_ASYNC_COUNTING);
 
-    auto observer = new (&ac) PortObserver(type,
+    auto observer = new (&ac) PortObserver(type, counting,
             handle, mxtl::RefPtr<PortDispatcherV2>(this), key, signals);
     if (!ac.check())
         return ERR_NO_MEMORY;
@@ -28,6 +28,7 @@
 #include <magenta/diagnostics.h>
 #include <magenta/futex_context.h>
 #include <magenta/handle_owner.h>
+#include <magenta/aspace_reaper.h>
 #include <magenta/handle_reaper.h>
 #include <magenta/job_dispatcher.h>
 #include <magenta/magenta.h>
@@ -42,6 +43,10 @@ static constexpr mx_rights_t kDefaultProcessRights =
         MX_RIGHT_READ  | MX_RIGHT_WRITE | MX_RIGHT_DUPLICATE | MX_RIGHT_TRANSFER |
         MX_RIGHT_GET_PROPERTY | MX_RIGHT_SET_PROPERTY | MX_RIGHT_ENUMERATE;
 
+// How far the live handle count may drift from the value last pushed into
+// the job rollup before the delta is propagated up the job tree.
+static constexpr int64_t kHandleStatsBatch = 64;
+
 
 static mx_handle_t map_handle_to_value(const Handle* handle, mx_handle_t mixer) {
     // Ensure that the last bit of the result is not zero, and make sure
@@ -97,7 +102,9 @@ mx_status_t ProcessDispatcher::Create(
 ProcessDispatcher::ProcessDispatcher(mxtl::RefPtr<JobDispatcher> job,
                                      mxtl::StringPiece name,
                                      uint32_t flags)
-    : job_(mxtl::move(job)), policy_(job_->GetPolicy()), state_tracker_(0u) {
+    : job_(mxtl::move(job)), policy_(job_->GetPolicy()),
+      policy_deny_mask_(GetSystemPolicyManager()->ComputeDenyMask(policy_)),
+      state_tracker_(0u) {
     LTRACE_ENTRY_OBJ;
 
     // Generate handle XOR mask with top bit and bottom two bits cleared
@@ -122,6 +129,11 @@ ProcessDispatcher::~ProcessDispatcher() {
     DEBUG_ASSERT(exception_port_ == nullptr);
     DEBUG_ASSERT(debugger_exception_port_ == nullptr);
 
+    // Belt and braces: the -> DEAD transition disarms the watermark, but a
+    // process destroyed from INITIAL never ran it.
+    if (aspace_)
+        aspace_->SetCommitWatermark(0, nullptr, nullptr);
+
     // Remove ourselves from the parent job's weak ref to us. Note that this might
     // have beeen called when transitioning State::DEAD. The Job can handle double calls.
     job_->RemoveChildProcess(this);
@@ -258,6 +270,16 @@ void ProcessDispatcher::RemoveThread(UserThread* t) {
         }
     }
 
+    // Fold the exiting thread's cpu time into the job rollup. Running
+    // threads are never sampled, so this is the only place job cpu time
+    // accrues.
+    {
+        mx_info_thread_stats_t stats;
+        t->GetStatsForUserspace(&stats);
+        if (stats.total_runtime != 0)
+            job_->UpdateStats(0, stats.total_runtime, 0);
+    }
+
     // we're going to check for state and possibly transition below
     AutoLock state_lock(&state_lock_);
 
@@ -332,11 +354,21 @@ void ProcessDispatcher::SetStateLocked(State s) {
             // Delete handles out-of-band to avoid the worst case recursive
             // destruction behavior.
             ReapHandles(&handles_);
+            // ReapHandles() bypasses RemoveHandleLocked(), so retire the
+            // whole handle contribution to the job rollup here.
+            handle_count_ = 0;
+            FlushHandleStatsLocked();
         }
         LTRACEF_LEVEL(2, "done cleaning up handle table on proc %p\n", this);
 
-        // tear down the address space
-        aspace_->Destroy();
+        // Disarm the memory watermark so the aspace cannot call back into
+        // us once teardown begins.
+        aspace_->SetCommitWatermark(0, nullptr, nullptr);
+
+        // Tear down the address space out of band: reclaiming a large
+        // process can take hundreds of milliseconds, and neither the
+        // killer nor the last exiting thread should ride it out.
+        ReapVmAspace(aspace_);
 
         // Send out exception reports before signalling MX_TASK_TERMINATED,
         // the theory being that marking the process as terminated is the
@@ -372,6 +404,13 @@ void ProcessDispatcher::SetStateLocked(State s) {
         LTRACEF_LEVEL(2, "signaling waiters\n");
         state_tracker_.UpdateState(0u, MX_TASK_TERMINATED);
 
+        // Retire this process's memory contribution to the job rollup;
+        // the address space has been reaped.
+        if (reported_mem_bytes_ != 0) {
+            job_->UpdateStats(-reported_mem_bytes_, 0, 0);
+            reported_mem_bytes_ = 0;
+        }
+
         // We remove ourselves from the parent Job weak ref (to us) list early, so
         // the semantics of signaling MX_JOB_NO_PROCESSES match that of MX_TASK_TERMINATED.
         job_->RemoveChildProcess(this);
@@ -406,6 +445,9 @@ void ProcessDispatcher::AddHandle(HandleOwner handle) {
 void ProcessDispatcher::AddHandleLocked(HandleOwner handle) {
     handle->set_process_id(get_koid());
     handles_.push_front(handle.release());
+    ++handle_count_;
+    if (handle_count_ - reported_handle_count_ >= kHandleStatsBatch)
+        FlushHandleStatsLocked();
 }
 
 HandleOwner ProcessDispatcher::RemoveHandle(mx_handle_t handle_value) {
@@ -420,10 +462,21 @@ HandleOwner ProcessDispatcher::RemoveHandleLocked(mx_handle_t handle_value) {
 
     handle->set_process_id(0u);
     handles_.erase(*handle);
+    --handle_count_;
+    if (reported_handle_count_ - handle_count_ >= kHandleStatsBatch)
+        FlushHandleStatsLocked();
 
     return HandleOwner(handle);
 }
 
+void ProcessDispatcher::FlushHandleStatsLocked() {
+    int64_t delta = handle_count_ - reported_handle_count_;
+    if (delta == 0)
+        return;
+    job_->UpdateStats(0, 0, delta);
+    reported_handle_count_ = handle_count_;
+}
+
 void ProcessDispatcher::UndoRemoveHandleLocked(mx_handle_t handle_value) {
     auto handle = map_value_to_handle(handle_value, handle_rand_);
     AddHandleLocked(HandleOwner(handle));
@@ -512,6 +565,16 @@ status_t ProcessDispatcher::GetStats(mx_info_task_stats_t* stats) {
     }
     stats->mem_mapped_bytes = usage.mapped_pages * PAGE_SIZE;
     stats->mem_committed_bytes = usage.committed_pages * PAGE_SIZE;
+    stats->mem_shared_bytes = usage.shared_pages * PAGE_SIZE;
+
+    // Lazily propagate the committed-bytes delta into the job rollup, so
+    // sampling a process keeps its job's MX_INFO_JOB_STATS fresh without
+    // the job read ever walking the task tree.
+    auto committed = static_cast<int64_t>(stats->mem_committed_bytes);
+    if (committed != reported_mem_bytes_) {
+        job_->UpdateStats(committed - reported_mem_bytes_, 0, 0);
+        reported_mem_bytes_ = committed;
+    }
     return NO_ERROR;
 }
 
@@ -525,6 +588,34 @@ status_t ProcessDispatcher::GetAspaceMaps(
     return GetVmAspaceMaps(aspace_, maps, max, actual, available);
 }
 
+void ProcessDispatcher::CommitWatermarkThunk(void* cookie, bool above) {
+    auto process = static_cast<ProcessDispatcher*>(cookie);
+    if (above) {
+        process->state_tracker_.UpdateState(0u, MX_PROCESS_HIGH_MEMORY);
+    } else {
+        process->state_tracker_.UpdateState(MX_PROCESS_HIGH_MEMORY, 0u);
+    }
+}
+
+status_t ProcessDispatcher::SetMemoryWatermark(size_t bytes) {
+    AutoLock lock(&state_lock_);
+    if (state_ == State::DEAD) {
+        return ERR_BAD_STATE;
+    }
+
+    if (bytes == 0) {
+        aspace_->SetCommitWatermark(0, nullptr, nullptr);
+        state_tracker_.UpdateState(MX_PROCESS_HIGH_MEMORY, 0u);
+        return NO_ERROR;
+    }
+
+    // round up so the signal asserts only once committed memory actually
+    // reaches the requested byte count
+    size_t pages = bytes / PAGE_SIZE + (bytes % PAGE_SIZE ? 1 : 0);
+    aspace_->SetCommitWatermark(pages, &ProcessDispatcher::CommitWatermarkThunk, this);
+    return NO_ERROR;
+}
+
 status_t ProcessDispatcher::CreateUserThread(mxtl::StringPiece name, uint32_t flags,
                                              mxtl::RefPtr<Dispatcher>* out_thread,
                                              mx_rights_t* out_rights) {
@@ -601,6 +692,7 @@ status_t ProcessDispatcher::SetExceptionPort(mxtl::RefPtr<ExceptionPort> eport)
             return ERR_BAD_STATE; // TODO(dje): ?
         exception_port_ = eport;
     }
+    IncrementExceptionPortCount();
 
     return NO_ERROR;
 }
@@ -642,6 +734,7 @@ bool ProcessDispatcher::ResetExceptionPort(bool debugger, bool quietly) {
         //
         // So, call it before releasing the lock.
         eport->OnTargetUnbind();
+        DecrementExceptionPortCount();
     }
 
     if (!quietly) {
@@ -718,15 +811,16 @@ mx_status_t ProcessDispatcher::set_debug_addr(uintptr_t addr) {
 }
 
 mx_status_t ProcessDispatcher::QueryPolicy(uint32_t condition) const {
-    auto action = GetSystemPolicyManager()->QueryBasicPolicy(policy_, condition);
-    if (action & MX_POL_ACTION_ALARM) {
-        // TODO(cpu): Generate Port packet. Probably need to call up to the
-        // parent job for the actual port.
-        action &= ~MX_POL_ACTION_ALARM;
-    }
+    // The deny mask was flattened from |policy_| at creation time, so
+    // this is a single load on the hot object-creation paths.
+    // TODO(cpu): Generate Port packet when the policy carries
+    // MX_POL_ACTION_ALARM. Probably need to call up to the parent job
+    // for the actual port.
     // TODO(cpu): check for the MX_POL_KILL bit and return an error code
     // that sysgen understands as termination.
-    return (action & MX_POL_ACTION_DENY) ? ERR_ACCESS_DENIED : NO_ERROR;
+    if (unlikely(condition >= MX_POL_MAX))
+        return ERR_ACCESS_DENIED;
+    return (policy_deny_mask_ & (1u << condition)) ? ERR_ACCESS_DENIED : NO_ERROR;
 }
 
 const char* StateToString(ProcessDispatcher::State state) {
@@ -116,21 +116,23 @@ size_t SocketDispatcher::CBuf::Write(const void* src, size_t len, bool from_user
     return pos;
 }
 
-size_t SocketDispatcher::CBuf::Read(void* dest, size_t len, bool from_user) {
+size_t SocketDispatcher::CBuf::Read(void* dest, size_t len, bool from_user, bool peek) {
     size_t ret = 0;
+    // a peek reads through a local tail so the data stays queued
+    size_t tail = tail_;
 
-    if (tail_ != head_) {
+    if (tail != head_) {
         size_t pos = 0;
         // loop until we've read everything we need
         // at most this will make two passes to deal with wraparound
-        while (pos < len && tail_ != head_) {
+        while (pos < len && tail != head_) {
             size_t read_len;
-            if (head_ > tail_) {
+            if (head_ > tail) {
                 // simple case where there is no wraparound
-                read_len = MIN(head_ - tail_, len - pos);
+                read_len = MIN(head_ - tail, len - pos);
             } else {
                 // read to the end of buffer in this pass
-                read_len = MIN(valpow2(len_pow2_) - tail_, len - pos);
+                read_len = MIN(valpow2(len_pow2_) - tail, len - pos);
             }
 
             char *ptr = (char*)dest;
@@ -138,19 +140,27 @@ size_t SocketDispatcher::CBuf::Read(void* dest, size_t len, bool from_user) {
             if (from_user) {
                 // TODO: find a safer way to do this
                 user_ptr<void> uptr(ptr);
-                vmo_->ReadUser(uptr, tail_, read_len, nullptr);
+                vmo_->ReadUser(uptr, tail, read_len, nullptr);
             } else {
-                memcpy(ptr, reinterpret_cast<void*>(mapping_->base() + tail_), read_len);
+                memcpy(ptr, reinterpret_cast<void*>(mapping_->base() + tail), read_len);
             }
 
-            tail_ = INC_POINTER(len_pow2_, tail_, read_len);
+            tail = INC_POINTER(len_pow2_, tail, read_len);
             pos += read_len;
         }
         ret = pos;
     }
+    if (!peek)
+        tail_ = tail;
     return ret;
 }
 
+size_t SocketDispatcher::CBuf::Discard(size_t len) {
+    size_t count = MIN(len, CouldRead());
+    tail_ = INC_POINTER(len_pow2_, tail_, count);
+    return count;
+}
+
 size_t SocketDispatcher::CBuf::CouldRead() const {
     return modpow2((uint)(head_ - tail_), len_pow2_);
 }
@@ -351,7 +361,7 @@ mx_status_t SocketDispatcher::WriteSelf(const void* src, size_t len,
 }
 
 mx_status_t SocketDispatcher::Read(void* dest, size_t len,
-                                   bool from_user, size_t* nread) {
+                                   bool from_user, bool peek, size_t* nread) {
     canary_.Assert();
 
     AutoLock lock(&lock_);
@@ -369,7 +379,35 @@ mx_status_t SocketDispatcher::Read(void* dest, size_t len,
 
     bool was_full = cbuf_.free() == 0u;
 
-    auto st = cbuf_.Read(dest, len, from_user);
+    auto st = cbuf_.Read(dest, len, from_user, peek);
+
+    // A peek consumes nothing, so the signal state cannot have changed.
+    if (!peek) {
+        if (cbuf_.empty()) {
+            state_tracker_.UpdateState(MX_SOCKET_READABLE, 0u);
+        }
+
+        if (!closed && was_full && (st > 0))
+            other_->state_tracker_.UpdateState(0u, MX_SOCKET_WRITABLE);
+    }
+
+    *nread = static_cast<size_t>(st);
+    return NO_ERROR;
+}
+
+mx_status_t SocketDispatcher::Consume(size_t len, size_t* nread) {
+    canary_.Assert();
+
+    AutoLock lock(&lock_);
+
+    bool closed = half_closed_[1] || !other_;
+
+    if (cbuf_.empty())
+        return closed ? ERR_PEER_CLOSED: ERR_SHOULD_WAIT;
+
+    bool was_full = cbuf_.free() == 0u;
+
+    auto st = cbuf_.Discard(len);
 
     if (cbuf_.empty()) {
         state_tracker_.UpdateState(MX_SOCKET_READABLE, 0u);
@@ -378,6 +416,6 @@ mx_status_t SocketDispatcher::Read(void* dest, size_t len,
     if (!closed && was_full && (st > 0))
         other_->state_tracker_.UpdateState(0u, MX_SOCKET_WRITABLE);
 
-    *nread = static_cast<size_t>(st);
+    *nread = st;
     return NO_ERROR;
 }
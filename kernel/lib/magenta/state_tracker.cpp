@@ -98,7 +98,15 @@ void StateTracker::UpdateState(mx_signals_t clear_mask,
         if (previous_signals == signals_)
             return;
 
+        const mx_signals_t changed = previous_signals ^ signals_;
+
         for (auto it = observers_.begin(); it != observers_.end();) {
+            // Observers that don't watch any of the changed bits can't react
+            // to this transition; don't pay for their virtual dispatch.
+            if ((it->watched_signals() & changed) == 0u) {
+                ++it;
+                continue;
+            }
             awoke_threads = it->OnStateChange(signals_) || awoke_threads;
             if (it->remove()) {
                 auto to_remove = it;
@@ -28,6 +28,7 @@
 #include <magenta/c_user_thread.h>
 #include <magenta/exception.h>
 #include <magenta/excp_port.h>
+#include <magenta/job_dispatcher.h>
 #include <magenta/magenta.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/syscalls/debug.h>
@@ -218,6 +219,11 @@ status_t UserThread::Initialize(const char* name, size_t len) {
     // register an event handler with the LK kernel
     thread_set_user_callback(&thread_, &ThreadUserCallback);
 
+    // confine the thread to its job's cpu partition, if one is set
+    uint32_t job_mask = process_->job() ? process_->job()->cpu_mask() : 0u;
+    if (job_mask != 0u)
+        thread_set_cpu_affinity(lkthread, job_mask);
+
     // set the per-thread pointer
     lkthread->user_thread = reinterpret_cast<void*>(this);
 
@@ -249,6 +255,21 @@ void UserThread::get_name(char out_name[MX_MAX_NAME_LEN]) {
     memcpy(out_name, thread_.name, MX_MAX_NAME_LEN);
 }
 
+void* UserThread::GetScratchBuffer(size_t size) {
+    canary_.Assert();
+    DEBUG_ASSERT(&thread_ == get_current_thread());
+
+    if (size > kScratchSize)
+        return nullptr;
+    if (!scratch_buffer_) {
+        AllocChecker ac;
+        scratch_buffer_.reset(new (&ac) uint8_t[kScratchSize]);
+        if (!ac.check())
+            return nullptr;
+    }
+    return scratch_buffer_.get();
+}
+
 // start a thread
 status_t UserThread::Start(uintptr_t entry, uintptr_t sp,
                            uintptr_t arg1, uintptr_t arg2,
@@ -335,6 +356,21 @@ void UserThread::Kill() {
     SetState(State::DYING);
 }
 
+status_t UserThread::set_cpu_affinity(uint32_t mask) {
+    if (mask == 0u)
+        return ERR_INVALID_ARGS;
+
+    // clip to the job's cpu partition, if one is set
+    uint32_t job_mask = process_->job() ? process_->job()->cpu_mask() : 0u;
+    if (job_mask != 0u) {
+        mask &= job_mask;
+        if (mask == 0u)
+            return ERR_INVALID_ARGS;
+    }
+
+    return thread_set_cpu_affinity(&thread_, mask);
+}
+
 status_t UserThread::Suspend() {
     LTRACE_ENTRY_OBJ;
 
@@ -372,6 +408,16 @@ void UserThread::Exiting() {
     // signal any waiters
     state_tracker_.UpdateState(0u, MX_TASK_TERMINATED);
 
+    {
+        AutoLock lock(&exception_wait_lock_);
+        if (step_pending_) {
+            // A debugger is blocked in StepFromException(); wake it so it
+            // can observe the death.
+            step_pending_ = false;
+            event_signal(&stepped_event_, true);
+        }
+    }
+
     {
         AutoLock lock(&exception_lock_);
         if (exception_port_)
@@ -538,6 +584,7 @@ status_t UserThread::SetExceptionPort(ThreadDispatcher* td, mxtl::RefPtr<Excepti
     if (exception_port_)
         return ERR_BAD_STATE; // TODO(dje): ?
     exception_port_ = eport;
+    process_->IncrementExceptionPortCount();
 
     return NO_ERROR;
 }
@@ -576,6 +623,7 @@ bool UserThread::ResetExceptionPort(bool quietly) {
         //
         // So, call it before releasing the lock
         eport->OnTargetUnbind();
+        process_->DecrementExceptionPortCount();
     }
 
     if (!quietly)
@@ -602,19 +650,24 @@ status_t UserThread::ExceptionHandlerExchange(
     {
         AutoLock lock(&exception_wait_lock_);
 
-        // Send message, wait for reply.
-        // Note that there is a "race" that we need handle: We need to send the
-        // exception report before going to sleep, but what if the receiver of the
-        // report gets it and processes it before we are asleep? This is handled by
-        // locking exception_wait_lock_ in places where the handler can see/modify
-        // thread state.
-
-        status_t status = eport->SendReport(report);
-        if (status != NO_ERROR) {
-            LTRACEF("SendReport returned %d\n", status);
-            // Treat the exception as unhandled.
-            *out_estatus = ExceptionStatus::TRY_NEXT;
-            return NO_ERROR;
+        bool stepped = step_pending_;
+        step_pending_ = false;
+
+        if (!stepped) {
+            // Send message, wait for reply.
+            // Note that there is a "race" that we need handle: We need to send the
+            // exception report before going to sleep, but what if the receiver of the
+            // report gets it and processes it before we are asleep? This is handled by
+            // locking exception_wait_lock_ in places where the handler can see/modify
+            // thread state.
+
+            status_t status = eport->SendReport(report);
+            if (status != NO_ERROR) {
+                LTRACEF("SendReport returned %d\n", status);
+                // Treat the exception as unhandled.
+                *out_estatus = ExceptionStatus::TRY_NEXT;
+                return NO_ERROR;
+            }
         }
 
         // Mark that we're in an exception.
@@ -628,6 +681,17 @@ status_t UserThread::ExceptionHandlerExchange(
         exception_wait_port_ = eport;
 
         exception_status_ = ExceptionStatus::UNPROCESSED;
+
+        if (stepped) {
+            // This stop completes a StepFromException(): clear the
+            // single-step flag in the newly saved state and wake the
+            // stepper, which is waiting on stepped_event_ rather than for
+            // a report on the exception port. It's ok if clearing fails
+            // (e.g. a synthetic exception with no frame); the stepper can
+            // still inspect the thread.
+            arch_set_single_step(&thread_, false);
+            event_signal(&stepped_event_, true);
+        }
     }
 
     // Continue to wait for the exception response if we get suspended.
@@ -703,6 +767,52 @@ status_t UserThread::MarkExceptionHandled(ExceptionStatus estatus) {
     return NO_ERROR;
 }
 
+status_t UserThread::StepFromException() {
+    canary_.Assert();
+
+    LTRACE_ENTRY_OBJ;
+
+    {
+        AutoLock lock(&exception_wait_lock_);
+        if (!InExceptionLocked())
+            return ERR_BAD_STATE;
+        // Same first-one-wins policy as MarkExceptionHandled: if someone
+        // already resumed this exception there is nothing to step from.
+        DEBUG_ASSERT(exception_status_ != ExceptionStatus::IDLE);
+        if (exception_status_ != ExceptionStatus::UNPROCESSED)
+            return ERR_BAD_STATE;
+
+        status_t status = arch_set_single_step(&thread_, true);
+        if (status != NO_ERROR)
+            return status;
+
+        step_pending_ = true;
+        // Clear any signal left over from a step abandoned by an
+        // interrupted caller.
+        event_unsignal(&stepped_event_);
+
+        exception_status_ = ExceptionStatus::RESUME;
+        event_signal(&exception_event_, true);
+    }
+
+    // Wait for the thread to stop at the next instruction. The stop is
+    // signaled from ExceptionHandlerExchange (or Exiting if the thread dies
+    // first).
+    status_t status;
+    do {
+        status = event_wait_deadline(&stepped_event_, INFINITE_TIME, true);
+    } while (status == ERR_INTERRUPTED_RETRY);
+    if (status != NO_ERROR)
+        return status;
+
+    AutoLock lock(&exception_wait_lock_);
+    if (!InExceptionLocked()) {
+        // The thread died before (or while) stopping again.
+        return ERR_BAD_STATE;
+    }
+    return NO_ERROR;
+}
+
 void UserThread::OnExceptionPortRemoval(const mxtl::RefPtr<ExceptionPort>& eport) {
     canary_.Assert();
 
@@ -808,6 +918,20 @@ void UserThread::GetInfoForUserspace(mx_info_thread_t* info) {
     }
 }
 
+void UserThread::GetStatsForUserspace(mx_info_thread_stats_t* info) {
+    canary_.Assert();
+
+    LTRACE_ENTRY_OBJ;
+
+    thread_sched_stats_t stats;
+    thread_get_sched_stats(&thread_, &stats);
+
+    info->total_runtime = stats.runtime_ns;
+    info->queue_wait_time = stats.runqueue_wait_ns;
+    info->voluntary_switches = stats.voluntary_switches;
+    info->involuntary_switches = stats.involuntary_switches;
+}
+
 status_t UserThread::GetExceptionReport(mx_exception_report_t* report) {
     canary_.Assert();
 
@@ -56,6 +56,20 @@ mx_status_t VmObjectDispatcher::Write(user_ptr<const void> user_data,
     return vmo_->WriteUser(user_data, offset, length, bytes_written);
 }
 
+mx_status_t VmObjectDispatcher::ReadVector(VmObject::UserVec* vec, size_t count,
+                                           size_t* segments_done) {
+    canary_.Assert();
+
+    return vmo_->ReadUserVector(vec, count, segments_done);
+}
+
+mx_status_t VmObjectDispatcher::WriteVector(VmObject::UserVec* vec, size_t count,
+                                            size_t* segments_done) {
+    canary_.Assert();
+
+    return vmo_->WriteUserVector(vec, count, segments_done);
+}
+
 mx_status_t VmObjectDispatcher::SetSize(uint64_t size) {
     canary_.Assert();
 
@@ -89,10 +103,20 @@ mx_status_t VmObjectDispatcher::RangeOp(uint32_t op, uint64_t offset, uint64_t s
             auto status = vmo_->DecommitRange(offset, size, nullptr);
             return status;
         }
+        case MX_VMO_OP_ZERO: {
+            auto status = vmo_->ZeroRange(offset, size);
+            return status;
+        }
         case MX_VMO_OP_LOCK:
+            // pin the contents again; until the next unlock the kernel will
+            // not discard them under memory pressure
+            // TODO: report whether a discard happened while unlocked, and
+            // support range granularity
+            return vmo_->SetDiscardable(false);
         case MX_VMO_OP_UNLOCK:
-            // TODO: handle
-            return ERR_NOT_SUPPORTED;
+            // mark the vmo discardable: under memory pressure the kernel may
+            // decommit its pages, after which they read back as zeros
+            return vmo_->SetDiscardable(true);
         case MX_VMO_OP_LOOKUP:
             // we will be using the user pointer
             if (!buffer)
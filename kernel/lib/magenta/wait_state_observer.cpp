@@ -43,8 +43,13 @@ mx_signals_t WaitStateObserver::End() {
 
     auto tracker = dispatcher_->get_state_tracker();
     DEBUG_ASSERT(tracker);
-    if (tracker)
+    if (tracker) {
         tracker->RemoveObserver(this);
+        // Changes that don't touch our watched signals are no longer delivered
+        // to OnStateChange(), so fold the final state in here to keep the
+        // returned set an accurate snapshot of what is currently asserted.
+        wakeup_reasons_ |= tracker->GetSignalsState();
+    }
     dispatcher_.reset();
 
     // Return the set of reasons that we may have been woken.  Basically, this
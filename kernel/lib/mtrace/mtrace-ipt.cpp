@@ -80,6 +80,32 @@ status_t mtrace_ipt_control(uint32_t action, uint32_t options,
         return NO_ERROR;
     }
 
+    case MTRACE_IPT_CPU_MODE_PAUSE: {
+        mx_x86_pt_regs_t regs;
+        if (size != sizeof(regs))
+            return ERR_INVALID_ARGS;
+        uint32_t cpu = MTRACE_IPT_OPTIONS_CPU(options);
+        if ((options & ~MTRACE_IPT_OPTIONS_CPU_MASK) != 0)
+            return ERR_INVALID_ARGS;
+        auto status = x86_ipt_cpu_mode_pause(cpu, &regs);
+        if (status != NO_ERROR)
+            return status;
+        TRACEF("action %u, cpu %u, output_base 0x%" PRIx64 ", output_mask_ptrs 0x%" PRIx64 "\n",
+               action, cpu, regs.output_base, regs.output_mask_ptrs);
+        if (arch_copy_to_user(arg, &regs, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        return NO_ERROR;
+    }
+
+    case MTRACE_IPT_CPU_MODE_RESUME: {
+        if (size != 0)
+            return ERR_INVALID_ARGS;
+        uint32_t cpu = MTRACE_IPT_OPTIONS_CPU(options);
+        if ((options & ~MTRACE_IPT_OPTIONS_CPU_MASK) != 0)
+            return ERR_INVALID_ARGS;
+        return x86_ipt_cpu_mode_resume(cpu);
+    }
+
     case MTRACE_IPT_CPU_MODE_ALLOC:
         if (options != 0 || size != 0)
             return ERR_INVALID_ARGS;
@@ -0,0 +1,200 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// N.B. This is ideally temporary, like the IPT control plane next door.
+// It is a stopgap until "resources" can be used to read/write x86 MSRs.
+
+#ifdef __x86_64__ // entire file
+
+#include <inttypes.h>
+#include <new.h>
+
+#include <arch/user_copy.h>
+#include <kernel/auto_lock.h>
+#include <kernel/mutex.h>
+#include <lib/dpc.h>
+#include "lib/mtrace.h"
+#include "trace.h"
+
+#include <magenta/mtrace.h>
+#include <magenta/port_client.h>
+#include <magenta/port_dispatcher.h>
+#include <magenta/process_dispatcher.h>
+
+#include <mxtl/atomic.h>
+#include <mxtl/unique_ptr.h>
+
+#include "arch/x86/pmu.h"
+
+#define LOCAL_TRACE 0
+
+// Overflow delivery. The PMI handler runs in interrupt context, so it
+// only marks a packet in flight and queues a dpc; the dpc queues the
+// port packet. Overflows arriving while a packet is in flight are
+// coalesced into it.
+
+static Mutex pmu_port_lock;
+static mxtl::unique_ptr<PortClient> pmu_iopc TA_GUARDED(pmu_port_lock);
+static mxtl::atomic<int> pmu_packet_queued;
+
+static void mtrace_pmu_port_dpc(dpc_t* dpc);
+
+static dpc_t pmu_port_dpc = {
+    .node = {},
+    .func = mtrace_pmu_port_dpc,
+    .arg = nullptr,
+};
+
+static void mtrace_pmu_port_dpc(dpc_t* dpc) {
+    // Clear the in-flight flag before delivering so an overflow which
+    // arrives while we are signaling produces a fresh packet instead of
+    // being silently dropped.
+    pmu_packet_queued.store(0, mxtl::memory_order_release);
+
+    AutoLock al(&pmu_port_lock);
+    if (pmu_iopc && !pmu_iopc->Signal(MX_USER_SIGNAL_0, &pmu_port_lock)) {
+        // The far end of the port is gone; drop our client.
+        pmu_iopc.reset();
+    }
+}
+
+// Registered with the PMU; runs from the PMI with interrupts disabled.
+static void mtrace_pmu_overflow(uint32_t cpu, uint64_t status) {
+    if (!pmu_packet_queued.exchange(1, mxtl::memory_order_acq_rel))
+        dpc_queue_low_latency(&pmu_port_dpc, false);
+}
+
+static status_t mtrace_pmu_set_overflow_port(mx_handle_t port_handle,
+                                             uint64_t key) {
+    AutoLock al(&pmu_port_lock);
+
+    if (port_handle == MX_HANDLE_INVALID) {
+        pmu_iopc.reset();
+        return NO_ERROR;
+    }
+    if (pmu_iopc)
+        return ERR_BAD_STATE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+    mxtl::RefPtr<PortDispatcher> port;
+    mx_status_t status =
+        up->GetDispatcherWithRights(port_handle, MX_RIGHT_WRITE, &port);
+    if (status != NO_ERROR)
+        return status;
+
+    AllocChecker ac;
+    mxtl::unique_ptr<PortClient> client(
+        new (&ac) PortClient(mxtl::move(port), key, MX_USER_SIGNAL_0));
+    if (!ac.check())
+        return ERR_NO_MEMORY;
+
+    pmu_iopc = mxtl::move(client);
+    x86_pmu_set_overflow_handler(mtrace_pmu_overflow);
+    return NO_ERROR;
+}
+
+status_t mtrace_pmu_control(uint32_t action, uint32_t options,
+                            void* arg, uint32_t size) {
+    TRACEF("action %u, options 0x%x, arg %p, size 0x%x\n",
+           action, options, arg, size);
+
+    switch (action) {
+    case MTRACE_PMU_SET_MODE: {
+        if (options != 0)
+            return ERR_INVALID_ARGS;
+        uint32_t mode;
+        if (size != sizeof(mode))
+            return ERR_INVALID_ARGS;
+        if (arch_copy_from_user(&mode, arg, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        TRACEF("action %u, mode 0x%x\n", action, mode);
+        switch (mode) {
+        case PMU_MODE_CPUS:
+            return x86_pmu_set_mode(PMU_COUNT_CPUS);
+        case PMU_MODE_THREADS:
+            return x86_pmu_set_mode(PMU_COUNT_THREADS);
+        default:
+            return ERR_INVALID_ARGS;
+        }
+    }
+
+    case MTRACE_PMU_STAGE_CPU_DATA: {
+        mx_x86_pmu_regs_t regs;
+        if (size != sizeof(regs))
+            return ERR_INVALID_ARGS;
+        if (arch_copy_from_user(&regs, arg, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        uint32_t cpu = MTRACE_PMU_OPTIONS_CPU(options);
+        if ((options & ~MTRACE_PMU_OPTIONS_CPU_MASK) != 0)
+            return ERR_INVALID_ARGS;
+        return x86_pmu_stage_cpu_data(cpu, &regs);
+    }
+
+    case MTRACE_PMU_GET_CPU_DATA: {
+        mx_x86_pmu_regs_t regs;
+        if (size != sizeof(regs))
+            return ERR_INVALID_ARGS;
+        uint32_t cpu = MTRACE_PMU_OPTIONS_CPU(options);
+        if ((options & ~MTRACE_PMU_OPTIONS_CPU_MASK) != 0)
+            return ERR_INVALID_ARGS;
+        auto status = x86_pmu_get_cpu_data(cpu, &regs);
+        if (status != NO_ERROR)
+            return status;
+        if (arch_copy_to_user(arg, &regs, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        return NO_ERROR;
+    }
+
+    case MTRACE_PMU_GET_THREAD_DATA: {
+        mx_x86_pmu_regs_t regs;
+        if (size != sizeof(regs))
+            return ERR_INVALID_ARGS;
+        auto status = x86_pmu_get_thread_data(&regs);
+        if (status != NO_ERROR)
+            return status;
+        if (arch_copy_to_user(arg, &regs, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        return NO_ERROR;
+    }
+
+    case MTRACE_PMU_SET_OVERFLOW_PORT: {
+        mx_pmu_overflow_port_t params;
+        if (options != 0)
+            return ERR_INVALID_ARGS;
+        if (size != sizeof(params))
+            return ERR_INVALID_ARGS;
+        if (arch_copy_from_user(&params, arg, size) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        if (params.reserved != 0)
+            return ERR_INVALID_ARGS;
+        TRACEF("action %u, port %d, key 0x%" PRIx64 "\n",
+               action, params.port, params.key);
+        return mtrace_pmu_set_overflow_port(params.port, params.key);
+    }
+
+    case MTRACE_PMU_ALLOC:
+        if (options != 0 || size != 0)
+            return ERR_INVALID_ARGS;
+        return x86_pmu_alloc();
+    case MTRACE_PMU_START:
+        if (options != 0 || size != 0)
+            return ERR_INVALID_ARGS;
+        return x86_pmu_start();
+    case MTRACE_PMU_STOP:
+        if (options != 0 || size != 0)
+            return ERR_INVALID_ARGS;
+        return x86_pmu_stop();
+    case MTRACE_PMU_FREE:
+        if (options != 0 || size != 0)
+            return ERR_INVALID_ARGS;
+        return x86_pmu_free();
+
+    default:
+        return ERR_INVALID_ARGS;
+    }
+}
+
+#endif
@@ -0,0 +1,116 @@
+// Copyright 2017 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// MTRACE_KIND_SYNC: start or stop several tracing engines (Intel PT, the
+// PMU) with one cross-cpu synchronization, instead of the skew of one
+// mp_sync_exec per engine. Each engine splits its start/stop into an
+// arm/disarm half (validation and bookkeeping, done under the engine's
+// own lock) and a per-cpu programming half, which we run for all selected
+// engines from a single mp_sync_exec task.
+
+#ifdef __x86_64__ // entire file
+
+#include <inttypes.h>
+
+#include <kernel/mp.h>
+#include "lib/mtrace.h"
+#include "trace.h"
+
+#include <magenta/mtrace.h>
+
+#include "arch/x86/proc_trace.h"
+#include "arch/x86/pmu.h"
+
+#define LOCAL_TRACE 0
+
+#define MTRACE_SYNC_ALL_KINDS \
+    (MTRACE_SYNC_KIND(MTRACE_KIND_IPT) | MTRACE_SYNC_KIND(MTRACE_KIND_PMU))
+
+static void mtrace_sync_start_task(void* raw_context) {
+    uint32_t kinds = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(raw_context));
+    if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_IPT))
+        x86_ipt_sync_cpu_start();
+    if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_PMU))
+        x86_pmu_sync_cpu_start();
+}
+
+static void mtrace_sync_stop_task(void* raw_context) {
+    uint32_t kinds = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(raw_context));
+    if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_IPT))
+        x86_ipt_sync_cpu_stop();
+    if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_PMU))
+        x86_pmu_sync_cpu_stop();
+}
+
+status_t mtrace_sync_control(uint32_t action, uint32_t options,
+                             void* arg, uint32_t size) {
+    TRACEF("action %u, options 0x%x, arg %p, size 0x%x\n",
+           action, options, arg, size);
+
+    if (size != 0)
+        return ERR_INVALID_ARGS;
+    uint32_t kinds = options;
+    if (kinds == 0 || (kinds & ~MTRACE_SYNC_ALL_KINDS) != 0)
+        return ERR_INVALID_ARGS;
+
+    switch (action) {
+    case MTRACE_SYNC_START: {
+        // Arm every selected engine before touching any cpu; an engine
+        // which cannot start fails the whole operation, rolling back the
+        // ones already armed.
+        if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_IPT)) {
+            auto status = x86_ipt_sync_arm();
+            if (status != NO_ERROR)
+                return status;
+        }
+        if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_PMU)) {
+            auto status = x86_pmu_sync_arm();
+            if (status != NO_ERROR) {
+                if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_IPT))
+                    x86_ipt_sync_disarm();
+                return status;
+            }
+        }
+        mp_sync_exec(MP_CPU_ALL, mtrace_sync_start_task,
+                     reinterpret_cast<void*>(static_cast<uintptr_t>(kinds)));
+        return NO_ERROR;
+    }
+
+    case MTRACE_SYNC_STOP: {
+        // Stop whichever of the selected engines are stoppable in one
+        // pass; like the engines' own stops, this doesn't insist they
+        // be active so callers don't have to care during cleanup. The
+        // first failure is reported but doesn't prevent the others from
+        // stopping.
+        status_t status = NO_ERROR;
+        uint32_t stopping = 0;
+        if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_IPT)) {
+            auto s = x86_ipt_sync_disarm();
+            if (s == NO_ERROR)
+                stopping |= MTRACE_SYNC_KIND(MTRACE_KIND_IPT);
+            else
+                status = s;
+        }
+        if (kinds & MTRACE_SYNC_KIND(MTRACE_KIND_PMU)) {
+            auto s = x86_pmu_sync_disarm();
+            if (s == NO_ERROR)
+                stopping |= MTRACE_SYNC_KIND(MTRACE_KIND_PMU);
+            else if (status == NO_ERROR)
+                status = s;
+        }
+        if (stopping != 0) {
+            mp_sync_exec(MP_CPU_ALL, mtrace_sync_stop_task,
+                         reinterpret_cast<void*>(static_cast<uintptr_t>(stopping)));
+        }
+        return status;
+    }
+
+    default:
+        return ERR_INVALID_ARGS;
+    }
+}
+
+#endif
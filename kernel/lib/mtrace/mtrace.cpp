@@ -24,6 +24,10 @@ status_t mtrace_control(uint32_t kind, uint32_t action, uint32_t options,
 #ifdef __x86_64__
     case MTRACE_KIND_IPT:
         return mtrace_ipt_control(action, options, arg, size);
+    case MTRACE_KIND_PMU:
+        return mtrace_pmu_control(action, options, arg, size);
+    case MTRACE_KIND_SYNC:
+        return mtrace_sync_control(action, options, arg, size);
 #endif
     default:
         return ERR_INVALID_ARGS;
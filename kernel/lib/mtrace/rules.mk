@@ -8,8 +8,13 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 
 MODULE := $(LOCAL_DIR)
 
+MODULE_DEPS := \
+    kernel/lib/magenta \
+
 MODULE_SRCS += \
 	$(LOCAL_DIR)/mtrace.cpp \
-	$(LOCAL_DIR)/mtrace-ipt.cpp
+	$(LOCAL_DIR)/mtrace-ipt.cpp \
+	$(LOCAL_DIR)/mtrace-pmu.cpp \
+	$(LOCAL_DIR)/mtrace-sync.cpp
 
 include make/module.mk
@@ -254,6 +254,47 @@ void Arena::Free(void* addr) {
     free_.push_front(node);
 }
 
+size_t Arena::TrimFreeSpans() {
+    DEBUG_ASSERT(vmar_ != nullptr);
+    size_t trimmed = 0;
+    while (!free_.is_empty()) {
+        void* top_slot = data_.TopSlot();
+        // A non-empty free list means at least one data slot was popped.
+        DEBUG_ASSERT(top_slot != nullptr);
+
+        // The data pool can only take back its topmost slot; if that slot
+        // is live, everything on the free list sits below a live object
+        // and nothing more can be reclaimed.
+        Node* found = nullptr;
+        for (auto& node : free_) {
+            if (node.slot == top_slot) {
+                found = &node;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            break;
+        }
+
+        // Only the most-recently-popped control slot can be pushed back,
+        // and that is always the node at the front of the free list (Free
+        // pops a fresh node for every push_front). If some other node
+        // holds the top data slot, have it adopt the front node's slot so
+        // the front node can be retired in its place.
+        Node* front = free_.pop_front();
+        if (front != found) {
+            found->slot = front->slot;
+        }
+        control_.Push(front);
+        data_.Push(top_slot);
+        trimmed++;
+    }
+    if (LOCAL_TRACE && trimmed > 0) {
+        Dump();
+    }
+    return trimmed;
+}
+
 void Arena::Dump() const {
     DEBUG_ASSERT(vmar_ != nullptr);
     printf("%s mappings:\n", vmar_->name());
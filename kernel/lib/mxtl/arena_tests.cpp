@@ -237,7 +237,7 @@ static bool committing_tests(void* context) {
     EXPECT_LT(orig_committed, committed, "");
     EXPECT_GT(orig_uncommitted, uncommitted, "");
 
-    // TODO(dbort): Test uncommitting if Arena ever learns to decommit pages.
+    // Decommit of data pages on demand is covered by trimming_tests.
     END_TEST;
 }
 
@@ -267,7 +267,8 @@ private:
 using mxtl::ArenaTestFriend;
 
 // Hit the decommit code path. We can't observe it without peeking inside the
-// control pool, since the data pool doesn't currently decommit.
+// control pool, since the data pool only decommits when TrimFreeSpans() is
+// called (see trimming_tests).
 static bool uncommitting_tests(void* context) {
     BEGIN_TEST;
     // Create an arena with a 16-page control pool.
@@ -402,6 +403,85 @@ static bool uncommitting_tests(void* context) {
     END_TEST;
 }
 
+// Checks that TrimFreeSpans() returns free data slots to their pool and
+// decommits the pages behind them.
+static bool trimming_tests(void* context) {
+    BEGIN_TEST;
+    static const size_t num_pages = 32;
+    static const size_t num_slots = (num_pages * PAGE_SIZE) / sizeof(TestObj);
+
+    Arena arena;
+    EXPECT_EQ(NO_ERROR, arena.Init("name", sizeof(TestObj), num_slots), "");
+
+    auto start = reinterpret_cast<vaddr_t>(arena.start());
+    auto end = reinterpret_cast<vaddr_t>(arena.end());
+
+    // Allocate all of the data objects, committing every data page.
+    void** objs = reinterpret_cast<void**>(malloc(sizeof(void*) * num_slots));
+    void** top = objs;
+    for (size_t i = 0; i < num_slots; i++) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "[%zu]", i);
+        *top++ = arena.Alloc();
+        EXPECT_NONNULL(top[-1], msg);
+    }
+
+    size_t committed;
+    size_t uncommitted;
+    EXPECT_TRUE(
+        count_committed_pages(start, end, &committed, &uncommitted), "");
+    EXPECT_GT(committed, 0u, "");
+
+    // With every object live there is nothing to trim.
+    EXPECT_EQ(0u, arena.TrimFreeSpans(), "");
+
+    // Drain the top half of the arena. Freeing from the top down leaves
+    // the free list in the reverse of the order that trimming wants,
+    // exercising the free-list scan.
+    const size_t num_freed = num_slots - num_slots / 2;
+    for (size_t i = 0; i < num_freed; i++) {
+        arena.Free(*--top);
+    }
+
+    // Nothing is decommitted until we ask.
+    auto orig_committed = committed;
+    EXPECT_TRUE(
+        count_committed_pages(start, end, &committed, &uncommitted), "");
+    EXPECT_EQ(orig_committed, committed, "");
+
+    // Trimming should reclaim every freed slot and decommit the pages
+    // above the new top (minus hysteresis).
+    EXPECT_EQ(num_freed, arena.TrimFreeSpans(), "");
+    EXPECT_TRUE(
+        count_committed_pages(start, end, &committed, &uncommitted), "");
+    EXPECT_LT(committed, orig_committed, "");
+    EXPECT_GT(uncommitted, 0u, "");
+
+    // The surviving objects are still in range; the reclaimed region
+    // is not.
+    EXPECT_TRUE(arena.in_range(objs[0]), "");
+    EXPECT_TRUE(arena.in_range(objs[num_slots / 2 - 1]), "");
+    EXPECT_FALSE(arena.in_range(objs[num_slots - 1]), "");
+
+    // A second trim with a live top slot is a no-op.
+    EXPECT_EQ(0u, arena.TrimFreeSpans(), "");
+
+    // A trimmed arena can grow back to its full size.
+    for (size_t i = 0; i < num_freed; i++) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "regrow [%zu]", i);
+        *top++ = arena.Alloc();
+        EXPECT_NONNULL(top[-1], msg);
+    }
+    EXPECT_NULL(arena.Alloc(), "");
+
+    while (top > objs) {
+        arena.Free(*--top);
+    }
+    free(objs);
+    END_TEST;
+}
+
 // Checks that destroying an arena unmaps all of its pages.
 static bool memory_cleanup(void* context) {
     BEGIN_TEST;
@@ -503,6 +583,7 @@ ARENA_UNITTEST(in_range_tests)
 ARENA_UNITTEST(out_of_memory)
 ARENA_UNITTEST(committing_tests)
 ARENA_UNITTEST(uncommitting_tests)
+ARENA_UNITTEST(trimming_tests)
 ARENA_UNITTEST(memory_cleanup)
 ARENA_UNITTEST(content_preservation)
 UNITTEST_END_TESTCASE(arena_tests, "arenatests", "Arena allocator test", nullptr, nullptr);
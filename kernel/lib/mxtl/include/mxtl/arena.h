@@ -34,10 +34,30 @@ public:
     status_t Init(const char* name, size_t ob_size, size_t max_count);
     void* Alloc();
     void Free(void* addr);
+
+    // Returns free slots at the top of the data pool to the pool,
+    // decommitting the pages behind them (with the same hysteresis that
+    // free-node pages get). Only slots above the highest live object can
+    // be reclaimed, and each one costs a scan of the free list, so this
+    // is a maintenance operation for callers that know the arena has
+    // drained, not a fast path. Returns the number of slots reclaimed.
+    // Must not be mixed with in_range_unlocked(); see below.
+    size_t TrimFreeSpans();
+
     bool in_range(void* addr) const {
         return data_.InRange(static_cast<char*>(addr));
     }
 
+    // Like in_range(), but safe to call without holding the lock that
+    // guards this Arena -- provided the owner never calls TrimFreeSpans().
+    // For such arenas the data pool's top only ever grows (freed slots are
+    // recycled through the arena free list, never pushed back into the
+    // pool), so a racy read of it can only under-report the extent, and
+    // everything below it stays committed.
+    bool in_range_unlocked(void* addr) const {
+        return data_.InRangeUnlocked(static_cast<char*>(addr));
+    }
+
     void* start() const { return data_.start(); }
     void* end() const { return data_.end(); }
 
@@ -81,6 +101,19 @@ private:
             return (addr >= start_ && addr < top_);
         }
 
+        // The slot most recently returned by Pop, or nullptr if every
+        // popped slot has been pushed back.
+        void* TopSlot() const {
+            return (top_ == start_) ? nullptr : (top_ - slot_size_);
+        }
+
+        // See Arena::in_range_unlocked(). Only valid for pools whose slots
+        // are never pushed back, i.e. whose |top_| is monotonic.
+        bool InRangeUnlocked(void* addr) const {
+            char* top = *const_cast<char* const volatile*>(&top_);
+            return (addr >= start_ && addr < top);
+        }
+
         // The lowest address of the memory managed by this Pool.
         // Pop will only return values > |start| (besides nullptr).
         char* start() const { return start_; }
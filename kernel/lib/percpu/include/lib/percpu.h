@@ -0,0 +1,105 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+/**
+ * Typed per-CPU storage.
+ *
+ * A percpu_slot is a dynamically allocated block of storage replicated once
+ * per possible CPU.  Each CPU's copy starts on its own cache line, so
+ * frequent writes from one CPU (counters, caches, queue state) never share a
+ * line with another CPU's copy, and fetching the current CPU's copy is a
+ * single multiply-add from the slot base.
+ *
+ * Storage is allocated for every possible CPU (SMP_MAX_CPUS) up front, so a
+ * CPU which is hot-plugged after the slot was created already has its
+ * (zeroed) block waiting for it.  Aggregation paths which only care about
+ * CPUs that are up can filter the iteration with mp_is_cpu_online().
+ *
+ * For per-CPU state whose size is known at compile time, the existing idiom
+ * of a __CPU_ALIGN'ed struct array indexed by arch_curr_cpu_num() (see
+ * kernel/lib/dpc) remains fine; this library is for state sized or created
+ * at runtime, and for giving new subsystems one consistent access path.
+ *
+ * Typical usage:
+ *
+ *   static percpu_slot_t stats_slot;
+ *   ...
+ *   status_t res = percpu_slot_init(&stats_slot, sizeof(my_stats_t));
+ *   ...
+ *   // On a hot path (with migration prevented):
+ *   my_stats_t* stats = (my_stats_t*)percpu_slot_get(&stats_slot);
+ *   stats->allocs++;
+ *   ...
+ *   // Aggregating:
+ *   uint cpu;
+ *   void* ptr;
+ *   percpu_slot_for_every_cpu(&stats_slot, cpu, ptr) {
+ *       if (!mp_is_cpu_online(cpu))
+ *           continue;
+ *       total += ((my_stats_t*)ptr)->allocs;
+ *   }
+ */
+
+#include <arch/defines.h>
+#include <arch/ops.h>
+#include <assert.h>
+#include <err.h>
+#include <kernel/mp.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+__BEGIN_CDECLS
+
+typedef struct percpu_slot {
+    void*  base;
+    size_t stride;
+} percpu_slot_t;
+
+/**
+ * Allocate zeroed, cache-line aligned storage of the given size for every
+ * possible CPU.
+ *
+ * @param slot The slot to initialize.
+ * @param size The size of a single CPU's block, in bytes.  Internally rounded
+ * up to a whole number of cache lines.
+ *
+ * @return A status code indicating the success or failure of the operation.
+ * Possible return values include
+ * ++ ERR_INVALID_ARGS slot is NULL or size is zero.
+ * ++ ERR_NO_MEMORY Not enough memory to allocate the storage.
+ */
+status_t percpu_slot_init(percpu_slot_t* slot, size_t size);
+
+/**
+ * Release the storage held by a slot.  The caller is responsible for making
+ * sure that no CPU is still using its block.
+ */
+void percpu_slot_free(percpu_slot_t* slot);
+
+/* Return a pointer to the given CPU's block. */
+static inline void* percpu_slot_get_for_cpu(const percpu_slot_t* slot, uint cpu) {
+    DEBUG_ASSERT(slot && slot->base);
+    DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
+    return (void*)((uintptr_t)slot->base + (slot->stride * cpu));
+}
+
+/* Return a pointer to the current CPU's block.  The caller must prevent
+ * migration (hold a spinlock, run with preemption or interrupts disabled)
+ * while the pointer is in use. */
+static inline void* percpu_slot_get(const percpu_slot_t* slot) {
+    return percpu_slot_get_for_cpu(slot, arch_curr_cpu_num());
+}
+
+/* Iterate |cpu| over every possible CPU with |ptr| pointing at that CPU's
+ * block. */
+#define percpu_slot_for_every_cpu(slot, cpu, ptr)                         \
+    for ((cpu) = 0;                                                       \
+         ((cpu) < SMP_MAX_CPUS) &&                                        \
+             (((ptr) = percpu_slot_get_for_cpu((slot), (cpu))) != NULL);  \
+         (cpu)++)
+
+__END_CDECLS
@@ -0,0 +1,41 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/percpu.h>
+
+#include <assert.h>
+#include <lib/heap.h>
+#include <stdlib.h>
+#include <string.h>
+
+status_t percpu_slot_init(percpu_slot_t* slot, size_t size) {
+    if (!slot || !size)
+        return ERR_INVALID_ARGS;
+
+    /* Round each CPU's block up to a whole number of cache lines so that no
+     * two CPUs' blocks ever share a line. */
+    size_t stride = ROUNDUP(size, CACHE_LINE);
+
+    void* base = memalign(CACHE_LINE, stride * SMP_MAX_CPUS);
+    if (!base) {
+        slot->base   = NULL;
+        slot->stride = 0;
+        return ERR_NO_MEMORY;
+    }
+
+    memset(base, 0, stride * SMP_MAX_CPUS);
+    slot->base   = base;
+    slot->stride = stride;
+    return NO_ERROR;
+}
+
+void percpu_slot_free(percpu_slot_t* slot) {
+    DEBUG_ASSERT(slot);
+
+    free(slot->base);
+    slot->base   = NULL;
+    slot->stride = 0;
+}
@@ -34,6 +34,7 @@ typedef struct p2ra_state {
     struct list_node  unused_blocks;
     struct list_node  allocated_blocks;
     struct list_node* free_block_buckets;
+    struct list_node* block_caches;
     uint              bucket_count;
 } p2ra_state_t;
 
@@ -98,6 +99,31 @@ status_t p2ra_add_range(p2ra_state_t* state, uint range_start, uint range_len);
  */
 status_t p2ra_allocate_range(p2ra_state_t* state, uint size, uint* out_range_start);
 
+/**
+ * Pre-split free blocks so that at least count blocks of the given size are
+ * sitting in the size's block cache, ready to be handed out by
+ * p2ra_allocate_range with a single list operation.
+ *
+ * Cached blocks are deliberately kept out of the free buckets so that they do
+ * not merge back into larger blocks; use this when a burst of allocations of
+ * a known size is coming (e.g. MSI vector allocation while enumerating many
+ * devices) and the cost of splitting should be paid once, up front.
+ *
+ * @param state A pointer to the state structure to reserve from.
+ * @param size The size class to pre-split, a power of 2.
+ * @param count The number of blocks of the size class to have cached.
+ *
+ * @return A status code indicating the success or failure of the operation.
+ * Possible return values include
+ * ++ ERR_INVALID_ARGS size is zero, not a power of two, or larger than the
+ *    allocator's maximum allocation size.
+ * ++ ERR_NO_RESOURCES Not enough free space to reach the requested count.
+ *    Blocks cached before space ran out remain cached.
+ * ++ ERR_NO_MEMORY Bookkeeping for a split could not be allocated.  Blocks
+ *    cached before the failure remain cached.
+ */
+status_t p2ra_reserve_blocks(p2ra_state_t* state, uint size, uint count);
+
 /**
  * Free a range previously allocated using p2ra_allocate_range.
  *
@@ -133,7 +133,7 @@ status_t p2ra_init(p2ra_state_t* state, uint max_alloc_size) {
         return ERR_INVALID_ARGS;
     }
 
-    /* Allocate the storage for our free buckets */
+    /* Allocate the storage for our free buckets and block caches */
     state->bucket_count = log2_uint_floor(max_alloc_size) + 1;
     state->free_block_buckets = malloc(state->bucket_count * sizeof(state->free_block_buckets[0]));
     if (!state->free_block_buckets) {
@@ -141,13 +141,23 @@ status_t p2ra_init(p2ra_state_t* state, uint max_alloc_size) {
         return ERR_NO_MEMORY;
     }
 
+    state->block_caches = malloc(state->bucket_count * sizeof(state->block_caches[0]));
+    if (!state->block_caches) {
+        TRACEF("Failed to allocate storage for %u block cache lists!\n", state->bucket_count);
+        free(state->free_block_buckets);
+        state->free_block_buckets = NULL;
+        return ERR_NO_MEMORY;
+    }
+
     /* Initialize the rest of our bookeeping */
     mutex_init(&state->lock);
     list_initialize(&state->ranges);
     list_initialize(&state->unused_blocks);
     list_initialize(&state->allocated_blocks);
-    for (uint i = 0; i < state->bucket_count; ++i)
+    for (uint i = 0; i < state->bucket_count; ++i) {
         list_initialize(&state->free_block_buckets[i]);
+        list_initialize(&state->block_caches[i]);
+    }
 
     return NO_ERROR;
 }
@@ -161,8 +171,12 @@ void p2ra_free(p2ra_state_t* state) {
     p2ra_free_range_list(&state->ranges);
     p2ra_free_block_list(&state->unused_blocks);
     p2ra_free_block_list(&state->allocated_blocks);
-    for (uint i = 0; i < state->bucket_count; ++i)
+    for (uint i = 0; i < state->bucket_count; ++i) {
         p2ra_free_block_list(&state->free_block_buckets[i]);
+        p2ra_free_block_list(&state->block_caches[i]);
+    }
+    free(state->free_block_buckets);
+    free(state->block_caches);
 
     mutex_destroy(&state->lock);
     memset(state, 0, sizeof(*state));
@@ -305,6 +319,17 @@ status_t p2ra_allocate_range(p2ra_state_t* state, uint size, uint* out_range_sta
     status_t      ret   = NO_ERROR;
     mutex_acquire(&state->lock);
 
+    /* If a block of exactly the right size has been pre-split into this
+     * class's cache (see p2ra_reserve_blocks), just grab it; no splitting
+     * required. */
+    block = list_remove_head_type(&state->block_caches[orig_bucket], p2ra_block_t, node);
+    if (block) {
+        DEBUG_ASSERT(block->bucket == orig_bucket);
+        list_add_head(&state->allocated_blocks, &block->node);
+        *out_range_start = block->start;
+        goto finished;
+    }
+
     /* Find the smallest sized chunk which can hold the allocation and is
      * compatible with the requested addressing capabilities */
     while (bucket < state->bucket_count) {
@@ -362,6 +387,85 @@ finished:
     return ret;
 }
 
+status_t p2ra_reserve_blocks(p2ra_state_t* state, uint size, uint count) {
+    if (!state)
+        return ERR_INVALID_ARGS;
+
+    if (!size || !ispow2(size)) {
+        TRACEF("Size (%u) is not an integer power of 2.\n", size);
+        return ERR_INVALID_ARGS;
+    }
+
+    uint target_bucket = log2_uint_floor(size);
+    if (target_bucket >= state->bucket_count) {
+        TRACEF("Invalid size (%u).  Valid sizes are integer powers of 2 from [1, %u]\n",
+                size, 1u << (state->bucket_count - 1));
+        return ERR_INVALID_ARGS;
+    }
+
+    status_t ret = NO_ERROR;
+    mutex_acquire(&state->lock);
+
+    /* How many blocks of this class are already cached? */
+    uint cached = 0;
+    p2ra_block_t* block;
+    list_for_every_entry(&state->block_caches[target_bucket], block, p2ra_block_t, node)
+        cached++;
+
+    while (cached < count) {
+        /* Find the smallest free chunk which can produce a block of the target
+         * class.  Note that the remainders of a previous iteration's splits
+         * land back in the free buckets, so they are consumed first. */
+        uint bucket = target_bucket;
+        block = NULL;
+        while (bucket < state->bucket_count) {
+            block = list_remove_head_type(&state->free_block_buckets[bucket], p2ra_block_t, node);
+            if (block)
+                break;
+            bucket++;
+        }
+
+        if (!block) {
+            ret = ERR_NO_RESOURCES;
+            break;
+        }
+
+        /* Split the chunk down to the target class, just like
+         * p2ra_allocate_range does for an allocation. */
+        DEBUG_ASSERT(block->bucket == bucket);
+        while (bucket > target_bucket) {
+            p2ra_block_t* split_block = p2ra_get_unused_block(state);
+
+            if (!split_block) {
+                TRACEF("Failed to allocate free bookkeeping block when attempting "
+                       "to split for reservation\n");
+                p2ra_return_free_block(state, block, true);
+                ret = ERR_NO_MEMORY;
+                goto finished;
+            }
+
+            DEBUG_ASSERT(bucket);
+            bucket--;
+
+            block->bucket = bucket;
+
+            split_block->start  = block->start + (1u << block->bucket);
+            split_block->bucket = bucket;
+
+            p2ra_return_free_block(state, split_block, false);
+        }
+
+        /* Park the block in the cache, where it is safe from being merged
+         * back into a larger block. */
+        list_add_tail(&state->block_caches[target_bucket], &block->node);
+        cached++;
+    }
+
+finished:
+    mutex_release(&state->lock);
+    return ret;
+}
+
 void p2ra_free_range(p2ra_state_t* state, uint range_start, uint size) {
     DEBUG_ASSERT(state);
     DEBUG_ASSERT(size && ispow2(size));
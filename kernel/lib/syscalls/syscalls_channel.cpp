@@ -17,12 +17,14 @@
 #include <magenta/handle_owner.h>
 #include <magenta/magenta.h>
 #include <magenta/message_packet.h>
+#include <magenta/port_dispatcher_v2.h>
 #include <magenta/process_dispatcher.h>
 #include <magenta/syscalls/policy.h>
 #include <magenta/user_copy.h>
 
+#include <new.h>
+
 #include <mxtl/algorithm.h>
-#include <mxtl/inline_array.h>
 #include <mxtl/ref_ptr.h>
 
 #include "syscalls_priv.h"
@@ -30,7 +32,6 @@
 #define LOCAL_TRACE 0
 
 constexpr size_t kChannelReadHandlesChunkCount = 16u;
-constexpr size_t kChannelWriteHandlesInlineCount = 8u;
 
 mx_status_t sys_channel_create(
     uint32_t options, user_ptr<mx_handle_t> _out0, user_ptr<mx_handle_t> _out1) {
@@ -225,12 +226,20 @@ mx_status_t sys_channel_write(mx_handle_t handle_value, uint32_t options,
             return ERR_INVALID_ARGS;
     }
 
-    AllocChecker ac;
-    mxtl::InlineArray<mx_handle_t, kChannelWriteHandlesInlineCount> handles(&ac, num_handles);
-    if (!ac.check())
-        return ERR_NO_MEMORY;
+    // Stage the handles in the calling thread's scratch buffer when it is
+    // available, avoiding a heap allocation per call for large writes.
+    mx_handle_t* handles = static_cast<mx_handle_t*>(
+        UserThread::GetCurrent()->GetScratchBuffer(num_handles * sizeof(mx_handle_t)));
+    mxtl::unique_ptr<mx_handle_t[]> handles_heap;
+    if (!handles) {
+        AllocChecker ac;
+        handles_heap.reset(new (&ac) mx_handle_t[num_handles]);
+        if (!ac.check())
+            return ERR_NO_MEMORY;
+        handles = handles_heap.get();
+    }
     if (num_handles > 0u) {
-        result = msg_put_handles(up, msg.get(), handles.get(), _handles, num_handles,
+        result = msg_put_handles(up, msg.get(), handles, _handles, num_handles,
                                  static_cast<Dispatcher*>(channel.get()));
         if (result)
             return result;
@@ -249,6 +258,133 @@ mx_status_t sys_channel_write(mx_handle_t handle_value, uint32_t options,
     return result;
 }
 
+mx_status_t sys_channel_read_batch(mx_handle_t handle_value, uint32_t options,
+                                   user_ptr<mx_channel_batch_entry_t> _entries,
+                                   uint32_t num_entries,
+                                   user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("handle %d entries %p num_entries %u\n",
+            handle_value, _entries.get(), num_entries);
+
+    if (options)
+        return ERR_INVALID_ARGS;
+    if (num_entries == 0u || num_entries > MX_CHANNEL_BATCH_MAX_MESSAGES)
+        return ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ChannelDispatcher> channel;
+    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_READ, &channel);
+    if (result != NO_ERROR)
+        return result;
+
+    mx_channel_batch_entry_t entries[MX_CHANNEL_BATCH_MAX_MESSAGES];
+    if (_entries.copy_array_from_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    uint32_t max_sizes[MX_CHANNEL_BATCH_MAX_MESSAGES];
+    for (uint32_t i = 0u; i < num_entries; i++)
+        max_sizes[i] = entries[i].num_bytes;
+
+    // pop as many messages as fit in one pass under the channel lock
+    mxtl::unique_ptr<MessagePacket> msgs[MX_CHANNEL_BATCH_MAX_MESSAGES];
+    uint32_t actual = 0u;
+    result = channel->ReadBatch(max_sizes, num_entries, msgs, &actual);
+    if (result != NO_ERROR)
+        return result;
+
+    for (uint32_t i = 0u; i < actual; i++) {
+        const uint32_t size = msgs[i]->data_size();
+        entries[i].num_bytes = size;
+        entries[i].status = NO_ERROR;
+        if (size > 0u &&
+            make_user_ptr(entries[i].bytes).copy_array_to_user(msgs[i]->data(), size) != NO_ERROR) {
+            // the message has already been consumed; surface the bad buffer
+            // in the per-message status
+            entries[i].status = ERR_INVALID_ARGS;
+        }
+        ktrace(TAG_CHANNEL_READ, (uint32_t)channel->get_koid(), size, 0, 0);
+    }
+
+    if (_entries.copy_array_to_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual_entries.copy_to_user(actual) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    return NO_ERROR;
+}
+
+mx_status_t sys_channel_write_batch(mx_handle_t handle_value, uint32_t options,
+                                    user_ptr<mx_channel_batch_entry_t> _entries,
+                                    uint32_t num_entries,
+                                    user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("handle %d entries %p num_entries %u\n",
+            handle_value, _entries.get(), num_entries);
+
+    if (options)
+        return ERR_INVALID_ARGS;
+    if (num_entries == 0u || num_entries > MX_CHANNEL_BATCH_MAX_MESSAGES)
+        return ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ChannelDispatcher> channel;
+    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_WRITE, &channel);
+    if (result != NO_ERROR)
+        return result;
+
+    mx_channel_batch_entry_t entries[MX_CHANNEL_BATCH_MAX_MESSAGES];
+    if (_entries.copy_array_from_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // build every packet up front so the whole batch can be queued on the
+    // peer under a single lock acquisition
+    ChannelDispatcher::MessageList msgs;
+    uint32_t prepared = 0u;
+    mx_status_t batch_status = NO_ERROR;
+    for (; prepared < num_entries; prepared++) {
+        auto& entry = entries[prepared];
+
+        mxtl::unique_ptr<MessagePacket> msg;
+        mx_status_t r = MessagePacket::Create(entry.num_bytes, 0u, &msg);
+        if (r == NO_ERROR && entry.num_bytes > 0u &&
+            make_user_ptr(static_cast<const void*>(entry.bytes))
+                    .copy_array_from_user(msg->mutable_data(), entry.num_bytes) != NO_ERROR) {
+            r = ERR_INVALID_ARGS;
+        }
+        entry.status = r;
+        if (r != NO_ERROR) {
+            batch_status = r;
+            break;
+        }
+        msgs.push_back(mxtl::move(msg));
+    }
+
+    uint32_t written = 0u;
+    if (!msgs.is_empty()) {
+        mx_status_t wr = channel->WriteBatch(&msgs);
+        if (wr == NO_ERROR) {
+            written = prepared;
+            for (uint32_t i = 0u; i < prepared; i++)
+                ktrace(TAG_CHANNEL_WRITE, (uint32_t)channel->get_koid(),
+                       entries[i].num_bytes, 0, 0);
+        } else {
+            // nothing was queued (e.g. peer closed); report it per message
+            for (uint32_t i = 0u; i < prepared; i++)
+                entries[i].status = wr;
+            batch_status = wr;
+        }
+    }
+
+    if (_entries.copy_array_to_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual_entries.copy_to_user(written) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // a partial batch counts as success; the caller finds the stopping
+    // point via actual_entries and the per-message statuses
+    return (written > 0u) ? NO_ERROR : batch_status;
+}
+
 mx_status_t sys_channel_call(mx_handle_t handle_value, uint32_t options,
                              mx_time_t deadline, user_ptr<const mx_channel_call_args_t> _args,
                              user_ptr<uint32_t> actual_bytes, user_ptr<uint32_t> actual_handles,
@@ -284,12 +420,21 @@ mx_status_t sys_channel_call(mx_handle_t handle_value, uint32_t options,
             return ERR_INVALID_ARGS;
     }
 
-    AllocChecker ac;
-    mxtl::InlineArray<mx_handle_t, kChannelWriteHandlesInlineCount> handles(&ac, num_handles);
-    if (!ac.check())
-        return ERR_NO_MEMORY;
+    // As in sys_channel_write, prefer the thread's scratch buffer for the
+    // staged handles. It stays valid across the blocking Call below since
+    // it is private to this thread for the duration of the syscall.
+    mx_handle_t* handles = static_cast<mx_handle_t*>(
+        UserThread::GetCurrent()->GetScratchBuffer(num_handles * sizeof(mx_handle_t)));
+    mxtl::unique_ptr<mx_handle_t[]> handles_heap;
+    if (!handles) {
+        AllocChecker ac;
+        handles_heap.reset(new (&ac) mx_handle_t[num_handles]);
+        if (!ac.check())
+            return ERR_NO_MEMORY;
+        handles = handles_heap.get();
+    }
     if (num_handles > 0u) {
-        result = msg_put_handles(up, msg.get(), handles.get(),
+        result = msg_put_handles(up, msg.get(), handles,
                                  make_user_ptr<const mx_handle_t>(args.wr_handles), num_handles,
                                  static_cast<Dispatcher*>(channel.get()));
         if (result)
@@ -368,3 +513,69 @@ read_failed:
         read_status.copy_to_user(result);
     return ERR_CALL_FAILED;
 }
+
+mx_status_t sys_channel_call_async(mx_handle_t handle_value, uint32_t options,
+                                   mx_handle_t port_value, uint64_t key,
+                                   user_ptr<const void> _bytes, uint32_t num_bytes,
+                                   user_ptr<const mx_handle_t> _handles, uint32_t num_handles) {
+    LTRACEF("handle %d port %d key %" PRIu64 " bytes %p num_bytes %u\n",
+            handle_value, port_value, key, _bytes.get(), num_bytes);
+
+    if (options)
+        return ERR_INVALID_ARGS;
+
+    // Like sys_channel_call, the leading bytes must carry the txid the
+    // reply will be matched against.
+    if (num_bytes < sizeof(mx_txid_t))
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ChannelDispatcher> channel;
+    mx_status_t result = up->GetDispatcherWithRights(handle_value, MX_RIGHT_WRITE, &channel);
+    if (result != NO_ERROR)
+        return result;
+
+    mxtl::RefPtr<PortDispatcherV2> port;
+    result = up->GetDispatcherWithRights(port_value, MX_RIGHT_WRITE, &port);
+    if (result != NO_ERROR)
+        return result;
+
+    mxtl::unique_ptr<MessagePacket> msg;
+    result = MessagePacket::Create(num_bytes, num_handles, &msg);
+    if (result != NO_ERROR)
+        return result;
+
+    if (_bytes.copy_array_from_user(msg->mutable_data(), num_bytes) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // Stage the handles as in sys_channel_write.
+    mx_handle_t* handles = static_cast<mx_handle_t*>(
+        UserThread::GetCurrent()->GetScratchBuffer(num_handles * sizeof(mx_handle_t)));
+    mxtl::unique_ptr<mx_handle_t[]> handles_heap;
+    if (!handles) {
+        AllocChecker ac;
+        handles_heap.reset(new (&ac) mx_handle_t[num_handles]);
+        if (!ac.check())
+            return ERR_NO_MEMORY;
+        handles = handles_heap.get();
+    }
+    if (num_handles > 0u) {
+        result = msg_put_handles(up, msg.get(), handles, _handles, num_handles,
+                                 static_cast<Dispatcher*>(channel.get()));
+        if (result)
+            return result;
+    }
+
+    bool return_handles = false;
+    result = channel->CallAsync(mxtl::move(msg), mxtl::move(port), key, &return_handles);
+    if (result != NO_ERROR && return_handles) {
+        AutoLock lock(up->handle_table_lock());
+        for (size_t ix = 0; ix != num_handles; ++ix) {
+            up->UndoRemoveHandleLocked(handles[ix]);
+        }
+    }
+
+    ktrace(TAG_CHANNEL_WRITE, (uint32_t)channel->get_koid(), num_bytes, num_handles, 0);
+    return result;
+}
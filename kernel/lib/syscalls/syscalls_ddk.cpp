@@ -94,6 +94,33 @@ mx_status_t sys_interrupt_wait(mx_handle_t handle_value) {
     return interrupt->WaitForInterrupt();
 }
 
+mx_status_t sys_interrupt_wait_batch(mx_handle_t handle_value,
+                                     user_ptr<uint64_t> _out_count,
+                                     user_ptr<mx_time_t> _out_timestamp) {
+    LTRACEF("handle %d\n", handle_value);
+
+    if (!_out_count || !_out_timestamp)
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+    mxtl::RefPtr<InterruptDispatcher> interrupt;
+    mx_status_t status = up->GetDispatcher(handle_value, &interrupt);
+    if (status != NO_ERROR)
+        return status;
+
+    uint64_t count;
+    mx_time_t timestamp;
+    status = interrupt->WaitForInterruptBatched(&count, &timestamp);
+    if (status != NO_ERROR)
+        return status;
+
+    status = _out_count.copy_to_user(count);
+    if (status != NO_ERROR)
+        return status;
+
+    return _out_timestamp.copy_to_user(timestamp);
+}
+
 mx_status_t sys_interrupt_signal(mx_handle_t handle_value) {
     LTRACEF("handle %d\n", handle_value);
 
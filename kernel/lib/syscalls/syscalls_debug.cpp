@@ -149,6 +149,15 @@ mx_status_t sys_ktrace_control(
         name[sizeof(name) - 1] = 0;
         return ktrace_control(action, options, name);
     }
+    case KTRACE_ACTION_GET_CPU_STREAM: {
+        ktrace_cpu_stream_t stream;
+        mx_status_t result = ktrace_control(action, options, &stream);
+        if (result < 0)
+            return result;
+        if (_ptr.reinterpret<ktrace_cpu_stream_t>().copy_to_user(stream) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        return result;
+    }
     default:
         return ktrace_control(action, options, nullptr);
     }
@@ -11,6 +11,7 @@
 #include <kernel/auto_lock.h>
 
 #include <magenta/handle_owner.h>
+#include <magenta/handle_reaper.h>
 #include <magenta/magenta.h>
 #include <magenta/process_dispatcher.h>
 
@@ -18,6 +19,9 @@
 
 #define LOCAL_TRACE 0
 
+static_assert(MX_HANDLE_OP_BATCH_MAX * sizeof(mx_handle_op_entry_t) <= 512,
+              "handle op batches are staged on the kernel stack");
+
 mx_status_t sys_handle_close(mx_handle_t handle_value) {
     LTRACEF("handle %d\n", handle_value);
     auto up = ProcessDispatcher::GetCurrent();
@@ -27,6 +31,42 @@ mx_status_t sys_handle_close(mx_handle_t handle_value) {
     return NO_ERROR;
 }
 
+mx_status_t sys_handle_close_many(user_ptr<const mx_handle_t> _handles, uint32_t count) {
+    LTRACEF("count %u\n", count);
+
+    if (!count || count > MX_HANDLE_OP_BATCH_MAX)
+        return ERR_INVALID_ARGS;
+
+    mx_handle_t handles[MX_HANDLE_OP_BATCH_MAX];
+    if (_handles.copy_array_from_user(handles, count) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // Unlink the whole batch under one lock hold; the dispatchers are
+    // destroyed afterwards on the reaper path, so a teardown burst
+    // neither stalls concurrent syscalls on this process's handle table
+    // nor pays for recursive destruction inline.
+    Handle* removed[MX_HANDLE_OP_BATCH_MAX];
+    uint32_t num_removed = 0;
+    mx_status_t status = NO_ERROR;
+    {
+        AutoLock lock(up->handle_table_lock());
+        for (uint32_t ix = 0; ix != count; ++ix) {
+            HandleOwner handle(up->RemoveHandleLocked(handles[ix]));
+            if (!handle) {
+                // keep going: the rest of the batch still gets closed
+                status = ERR_BAD_HANDLE;
+                continue;
+            }
+            removed[num_removed++] = handle.release();
+        }
+    }
+    if (num_removed > 0)
+        ReapHandles(removed, num_removed);
+    return status;
+}
+
 mx_status_t sys_handle_duplicate(mx_handle_t handle_value, mx_rights_t rights, user_ptr<mx_handle_t> _out) {
     LTRACEF("handle %d\n", handle_value);
 
@@ -97,3 +137,104 @@ mx_status_t sys_handle_replace(mx_handle_t handle_value, mx_rights_t rights, use
 
     return NO_ERROR;
 }
+
+// The per-entry bodies of the batch syscalls, run with the handle table
+// lock held. They mirror sys_handle_duplicate and sys_handle_replace
+// exactly, except that the new handle value is recorded in the entry
+// rather than copied out (no user access happens under the lock).
+
+static mx_status_t handle_duplicate_locked(ProcessDispatcher* up,
+                                           mx_handle_op_entry_t* entry) {
+    Handle* source = up->GetHandleLocked(entry->handle);
+    if (!source)
+        return ERR_BAD_HANDLE;
+
+    if (!magenta_rights_check(source, MX_RIGHT_DUPLICATE))
+        return ERR_ACCESS_DENIED;
+
+    mx_rights_t rights = entry->rights;
+    if (rights == MX_RIGHT_SAME_RIGHTS) {
+        rights = source->rights();
+    } else if ((source->rights() & rights) != rights) {
+        return ERR_INVALID_ARGS;
+    }
+
+    HandleOwner dest(DupHandle(source, rights));
+    if (!dest)
+        return ERR_NO_MEMORY;
+
+    entry->out = up->MapHandleToValue(dest);
+    up->AddHandleLocked(mxtl::move(dest));
+    return NO_ERROR;
+}
+
+static mx_status_t handle_replace_locked(ProcessDispatcher* up,
+                                         mx_handle_op_entry_t* entry) {
+    HandleOwner source = up->RemoveHandleLocked(entry->handle);
+    if (!source)
+        return ERR_BAD_HANDLE;
+
+    mx_rights_t rights = entry->rights;
+    if (rights == MX_RIGHT_SAME_RIGHTS) {
+        rights = source->rights();
+    } else if ((source->rights() & rights) != rights) {
+        // Unwind: put |source| back!
+        up->AddHandleLocked(mxtl::move(source));
+        return ERR_INVALID_ARGS;
+    }
+
+    HandleOwner dest(DupHandle(source.get(), rights));
+    if (!dest) {
+        up->AddHandleLocked(mxtl::move(source));
+        return ERR_NO_MEMORY;
+    }
+
+    entry->out = up->MapHandleToValue(dest);
+    up->AddHandleLocked(mxtl::move(dest));
+    return NO_ERROR;
+}
+
+static mx_status_t handle_op_batch(user_ptr<mx_handle_op_entry_t> _entries,
+                                   uint32_t count, user_ptr<uint32_t> _actual,
+                                   bool replace) {
+    if (!count || count > MX_HANDLE_OP_BATCH_MAX)
+        return ERR_INVALID_ARGS;
+
+    mx_handle_op_entry_t entries[MX_HANDLE_OP_BATCH_MAX];
+    if (_entries.copy_array_from_user(entries, count) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+    uint32_t actual = 0;
+    {
+        AutoLock lock(up->handle_table_lock());
+        for (uint32_t ix = 0; ix != count; ++ix) {
+            entries[ix].out = MX_HANDLE_INVALID;
+            entries[ix].status = replace
+                ? handle_replace_locked(up, &entries[ix])
+                : handle_duplicate_locked(up, &entries[ix]);
+            if (entries[ix].status == NO_ERROR)
+                ++actual;
+        }
+    }
+
+    // Note: the operations above are already committed; as with
+    // mx_channel_read, a bad buffer at this point loses the results.
+    if (_entries.copy_array_to_user(entries, count) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual && _actual.copy_to_user(actual) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    return NO_ERROR;
+}
+
+mx_status_t sys_handle_duplicate_batch(user_ptr<mx_handle_op_entry_t> _entries,
+                                       uint32_t count, user_ptr<uint32_t> _actual) {
+    LTRACEF("count %u\n", count);
+    return handle_op_batch(_entries, count, _actual, /* replace */ false);
+}
+
+mx_status_t sys_handle_replace_batch(user_ptr<mx_handle_op_entry_t> _entries,
+                                     uint32_t count, user_ptr<uint32_t> _actual) {
+    LTRACEF("count %u\n", count);
+    return handle_op_batch(_entries, count, _actual, /* replace */ true);
+}
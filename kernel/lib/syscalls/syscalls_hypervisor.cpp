@@ -110,6 +110,23 @@ static mx_status_t guest_set_esi(mx_handle_t handle, uint32_t guest_esi) {
 }
 #endif
 
+static mx_status_t guest_set_state_area(mx_handle_t handle, mx_handle_t vmo_handle) {
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<GuestDispatcher> guest;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_EXECUTE, &guest);
+    if (status != NO_ERROR)
+        return status;
+
+    mxtl::RefPtr<VmObjectDispatcher> vcpu_state_vmo;
+    status = up->GetDispatcherWithRights(
+        vmo_handle, MX_RIGHT_READ | MX_RIGHT_WRITE, &vcpu_state_vmo);
+    if (status != NO_ERROR)
+        return status;
+
+    return guest->set_state_area(vcpu_state_vmo->vmo());
+}
+
 static mx_status_t guest_set_entry(mx_handle_t handle, uintptr_t guest_entry) {
     auto up = ProcessDispatcher::GetCurrent();
 
@@ -142,6 +159,14 @@ static mx_status_t guest_set_entry(mx_handle_t handle, uintptr_t guest_entry) {
     }
     case MX_HYPERVISOR_OP_GUEST_ENTER:
         return guest_enter(handle);
+    case MX_HYPERVISOR_OP_GUEST_SET_STATE_AREA: {
+        mx_handle_t vmo_handle;
+        if (args_len != sizeof(vmo_handle))
+            return ERR_INVALID_ARGS;
+        if (args.copy_array_from_user(&vmo_handle, sizeof(vmo_handle)) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+        return guest_set_state_area(handle, vmo_handle);
+    }
     case MX_HYPERVISOR_OP_GUEST_SET_ENTRY: {
         uintptr_t guest_entry;
         if (args_len != sizeof(guest_entry))
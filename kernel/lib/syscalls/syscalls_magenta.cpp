@@ -18,6 +18,7 @@
 #include <kernel/thread.h>
 
 #include <lib/crypto/global_prng.h>
+#include <lib/crypto/percpu_prng.h>
 #include <lib/user_copy.h>
 #include <lib/user_copy/user_ptr.h>
 
@@ -231,15 +232,57 @@ mx_status_t sys_log_read(mx_handle_t log_handle, uint32_t len, user_ptr<void> _p
     return static_cast<mx_status_t>(actual);
 }
 
+mx_status_t sys_log_get_vmo(mx_handle_t log_handle, user_ptr<mx_handle_t> _out) {
+    LTRACEF("log handle %d\n", log_handle);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<LogDispatcher> log;
+    mx_status_t status = up->GetDispatcherWithRights(log_handle, MX_RIGHT_READ, &log);
+    if (status != NO_ERROR)
+        return status;
+
+    mxtl::RefPtr<Dispatcher> vmo_dispatcher;
+    mx_rights_t rights;
+    if ((status = log->GetVmo(&vmo_dispatcher, &rights)) != NO_ERROR)
+        return status;
+
+    HandleOwner vmo_handle(MakeHandle(mxtl::move(vmo_dispatcher), rights));
+    if (!vmo_handle)
+        return ERR_NO_MEMORY;
+
+    if (_out.copy_to_user(up->MapHandleToValue(vmo_handle)) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    up->AddHandle(mxtl::move(vmo_handle));
+
+    return NO_ERROR;
+}
+
+mx_status_t sys_log_advance(mx_handle_t log_handle, uint64_t position) {
+    LTRACEF("log handle %d, position %" PRIu64 "\n", log_handle, position);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<LogDispatcher> log;
+    mx_status_t status = up->GetDispatcherWithRights(log_handle, MX_RIGHT_READ, &log);
+    if (status != NO_ERROR)
+        return status;
+
+    return log->Advance(position);
+}
+
 mx_status_t sys_cprng_draw(user_ptr<void> _buffer, size_t len, user_ptr<size_t> _actual) {
     if (len > kMaxCPRNGDraw)
         return ERR_INVALID_ARGS;
 
     uint8_t kernel_buf[kMaxCPRNGDraw];
 
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    ASSERT(prng->is_thread_safe());
-    prng->Draw(kernel_buf, static_cast<int>(len));
+    // Draw from the calling cpu's generator so frequent callers don't
+    // contend on the global PRNG lock.
+    static_assert(kMaxCPRNGDraw <= crypto::PercpuPRNG::kMaxDrawLen,
+                  "draw limit exceeds per-cpu PRNG limit");
+    crypto::PercpuPRNG::Draw(kernel_buf, len);
 
     if (_buffer.copy_array_to_user(kernel_buf, len) != NO_ERROR)
         return ERR_INVALID_ARGS;
@@ -264,6 +307,9 @@ mx_status_t sys_cprng_add_entropy(user_ptr<const void> _buffer, size_t len) {
     ASSERT(prng->is_thread_safe());
     prng->AddEntropy(kernel_buf, static_cast<int>(len));
 
+    // Have the per-cpu generators pick up the new entropy on their next draw.
+    crypto::PercpuPRNG::NotifyEntropyAdded();
+
     // Get rid of the stack copy of the random data
     memset(kernel_buf, 0, sizeof(kernel_buf));
 
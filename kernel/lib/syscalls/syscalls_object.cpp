@@ -6,8 +6,15 @@
 
 #include <err.h>
 #include <inttypes.h>
+#include <new.h>
+#include <string.h>
 #include <trace.h>
 
+#include <kernel/auto_lock.h>
+#include <kernel/vm.h>
+
+#include <lib/heap_profile.h>
+
 #include <magenta/handle_owner.h>
 #include <magenta/job_dispatcher.h>
 #include <magenta/magenta.h>
@@ -15,61 +22,16 @@
 #include <magenta/resource_dispatcher.h>
 #include <magenta/thread_dispatcher.h>
 #include <magenta/vm_address_region_dispatcher.h>
+#include <magenta/vm_object_dispatcher.h>
 
+#include <mxtl/array.h>
 #include <mxtl/ref_ptr.h>
+#include <mxtl/unique_ptr.h>
 
 #include "syscalls_priv.h"
 
 #define LOCAL_TRACE 0
 
-namespace {
-// Gathers the koids of a job's descendants.
-class SimpleJobEnumerator final : public JobEnumerator {
-public:
-    // If |job| is true, only records job koids; otherwise, only
-    // records process koids.
-    SimpleJobEnumerator(user_ptr<mx_koid_t> ptr, size_t max, bool jobs)
-        : jobs_(jobs), ptr_(ptr), max_(max) {}
-
-    size_t get_avail() const { return avail_; }
-    size_t get_count() const { return count_; }
-
-private:
-    bool OnJob(JobDispatcher* job) override {
-        if (!jobs_) {
-            return true;
-        }
-        return RecordKoid(job->get_koid());
-    }
-
-    bool OnProcess(ProcessDispatcher* proc) override {
-        if (jobs_) {
-            return true;
-        }
-        return RecordKoid(proc->get_koid());
-    }
-
-    bool RecordKoid(mx_koid_t koid) {
-        avail_++;
-        if (count_ < max_) {
-            // TODO: accumulate batches and do fewer user copies
-            if (ptr_.copy_array_to_user(&koid, 1, count_) != NO_ERROR) {
-                return false;
-            }
-            count_++;
-        }
-        return true;
-    }
-
-    const bool jobs_;
-    const user_ptr<mx_koid_t> ptr_;
-    const size_t max_;
-
-    size_t count_ = 0;
-    size_t avail_ = 0;
-};
-} // namespace
-
 // actual is an optional return parameter for the number of records returned
 // avail is an optional return parameter for the number of records available
 
@@ -194,19 +156,24 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
             if (error < 0)
                 return error;
 
-            size_t max = buffer_size / sizeof(mx_koid_t);
-            auto koids = _buffer.reinterpret<mx_koid_t>();
-            SimpleJobEnumerator sje(koids, max, topic == MX_INFO_JOB_CHILDREN);
+            // Snapshot the direct children into a kernel buffer first so
+            // the user copy below never runs under the job's lock.
+            mxtl::Array<mx_koid_t> koids;
+            mx_status_t status =
+                job->GetChildKoids(topic == MX_INFO_JOB_CHILDREN, &koids);
+            if (status != NO_ERROR)
+                return status;
 
-            // Don't recurse; we only want the job's direct children.
-            if (!job->EnumerateChildren(&sje, /* recurse */ false)) {
-                // SimpleJobEnumerator only returns false when it can't
-                // write to the user pointer.
+            size_t num_koids = koids.size();
+            size_t num_space_for = buffer_size / sizeof(mx_koid_t);
+            size_t num_to_copy = MIN(num_koids, num_space_for);
+
+            if (num_to_copy &&
+                _buffer.copy_array_to_user(koids.get(), sizeof(mx_koid_t) * num_to_copy) != NO_ERROR)
                 return ERR_INVALID_ARGS;
-            }
-            if (_actual && (_actual.copy_to_user(sje.get_count()) != NO_ERROR))
+            if (_actual && (_actual.copy_to_user(num_to_copy) != NO_ERROR))
                 return ERR_INVALID_ARGS;
-            if (_avail && (_avail.copy_to_user(sje.get_avail()) != NO_ERROR))
+            if (_avail && (_avail.copy_to_user(num_koids) != NO_ERROR))
                 return ERR_INVALID_ARGS;
             return NO_ERROR;
         }
@@ -263,6 +230,37 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
                 return ERR_BUFFER_TOO_SMALL;
             return NO_ERROR;
         }
+        case MX_INFO_THREAD_STATS: {
+            // TODO(MG-458): Handle forward/backward compatibility issues
+            // with changes to the struct.
+            size_t actual = (buffer_size < sizeof(mx_info_thread_stats_t)) ? 0 : 1;
+            size_t avail = 1;
+
+            // grab a reference to the dispatcher
+            mxtl::RefPtr<ThreadDispatcher> thread;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_READ, &thread);
+            if (error < 0)
+                return error;
+
+            if (actual > 0) {
+                // build the info structure
+                mx_info_thread_stats_t info = { };
+
+                auto err = thread->GetStats(&info);
+                if (err != NO_ERROR)
+                    return err;
+
+                if (_buffer.copy_array_to_user(&info, sizeof(info)) != NO_ERROR)
+                    return ERR_INVALID_ARGS;
+            }
+            if (_actual && (_actual.copy_to_user(actual) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(avail) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (actual == 0)
+                return ERR_BUFFER_TOO_SMALL;
+            return NO_ERROR;
+        }
         case MX_INFO_THREAD_EXCEPTION_REPORT: {
             // TODO(MG-458): Handle forward/backward compatibility issues
             // with changes to the struct.
@@ -328,6 +326,39 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
                 return ERR_BUFFER_TOO_SMALL;
             return NO_ERROR;
         }
+        case MX_INFO_JOB_STATS: {
+            // TODO(MG-458): Handle forward/backward compatibility issues
+            // with changes to the struct.
+            size_t actual =
+                (buffer_size < sizeof(mx_info_job_stats_t)) ? 0 : 1;
+            size_t avail = 1;
+
+            // grab a reference to the dispatcher
+            mxtl::RefPtr<JobDispatcher> job;
+            auto error = up->GetDispatcherWithRights(handle, MX_RIGHT_READ,
+                                                     &job);
+            if (error < 0)
+                return error;
+
+            if (actual > 0) {
+                // Build the info structure. The rollup is maintained
+                // incrementally, so this is O(1) in the number of tasks
+                // under the job.
+                mx_info_job_stats_t info = {};
+
+                job->GetStats(&info);
+
+                if (_buffer.copy_array_to_user(&info, sizeof(info)) != NO_ERROR)
+                    return ERR_INVALID_ARGS;
+            }
+            if (_actual && (_actual.copy_to_user(actual) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(avail) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (actual == 0)
+                return ERR_BUFFER_TOO_SMALL;
+            return NO_ERROR;
+        }
         case MX_INFO_PROCESS_MAPS: {
             mxtl::RefPtr<ProcessDispatcher> process;
             mx_status_t status =
@@ -380,11 +411,278 @@ mx_status_t sys_object_get_info(mx_handle_t handle, uint32_t topic,
                 return ERR_BUFFER_TOO_SMALL;
             return NO_ERROR;
         }
+        case MX_INFO_HEAP_SITES: {
+            // kernel-wide info requires the root resource
+            auto status = validate_resource_handle(handle);
+            if (status != NO_ERROR)
+                return status;
+
+            static_assert(sizeof(mx_info_heap_site_t) == sizeof(heap_profile_record_t),
+                          "mx_info_heap_site_t must match heap_profile_record_t");
+
+            size_t max = buffer_size / sizeof(mx_info_heap_site_t);
+            size_t avail = 0;
+            size_t count = 0;
+
+            // snapshot into a kernel buffer first; the profiler can't copy
+            // out to user space from under its lock
+            heap_profile_snapshot(nullptr, 0, &avail);
+            if (max > avail)
+                max = avail;
+            if (max > 0) {
+                AllocChecker ac;
+                mxtl::unique_ptr<heap_profile_record_t[]> records(
+                    new (&ac) heap_profile_record_t[max]);
+                if (!ac.check())
+                    return ERR_NO_MEMORY;
+
+                count = heap_profile_snapshot(records.get(), max, &avail);
+                auto sites = _buffer.reinterpret<mx_info_heap_site_t>();
+                if (count > 0 &&
+                    sites.copy_array_to_user(
+                        reinterpret_cast<mx_info_heap_site_t*>(records.get()),
+                        count) != NO_ERROR)
+                    return ERR_INVALID_ARGS;
+            }
+
+            if (_actual && (_actual.copy_to_user(count) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(avail) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            return NO_ERROR;
+        }
+        case MX_INFO_PMM_ARENAS: {
+            // kernel-wide info requires the root resource
+            auto status = validate_resource_handle(handle);
+            if (status != NO_ERROR)
+                return status;
+
+            size_t max = buffer_size / sizeof(mx_info_pmm_arena_t);
+            size_t avail = pmm_count_arenas();
+            size_t count = 0;
+
+            auto arenas = _buffer.reinterpret<mx_info_pmm_arena_t>();
+            for (; count < max && count < avail; ++count) {
+                pmm_arena_stats_t stats;
+                if (pmm_get_arena_stats(count, &stats) != NO_ERROR)
+                    break;
+
+                mx_info_pmm_arena_t entry = {};
+                static_assert(sizeof(entry.name) == sizeof(stats.info.name),
+                              "mx_info_pmm_arena_t name size must match pmm_arena_info_t");
+                memcpy(entry.name, stats.info.name, sizeof(entry.name));
+                entry.node = stats.info.node;
+                entry.flags = stats.info.flags;
+                entry.base = stats.info.base;
+                entry.size = stats.info.size;
+                entry.total_pages = stats.total_pages;
+                entry.free_pages = stats.free_pages;
+                entry.wired_pages = stats.wired_pages;
+                entry.committed_pages = stats.committed_pages;
+
+                if (arenas.element_offset(count).copy_to_user(entry) != NO_ERROR)
+                    return ERR_INVALID_ARGS;
+            }
+
+            if (_actual && (_actual.copy_to_user(count) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            if (_avail && (_avail.copy_to_user(avail) != NO_ERROR))
+                return ERR_INVALID_ARGS;
+            return NO_ERROR;
+        }
         default:
             return ERR_NOT_SUPPORTED;
     }
 }
 
+// One fixed-size info record, staged on the stack before being written
+// into the caller's vmo.
+union object_info_record {
+    mx_info_handle_basic_t handle_basic;
+    mx_info_process_t process;
+    mx_info_thread_t thread;
+    mx_info_thread_stats_t thread_stats;
+    mx_info_task_stats_t task_stats;
+    mx_info_job_stats_t job_stats;
+    mx_info_vmar_t vmar;
+};
+
+// Fill |record| for one batch entry. Mirrors the corresponding topics of
+// sys_object_get_info above; topics that return variable-length arrays
+// are not supported in batches.
+static mx_status_t object_info_query(mxtl::RefPtr<Dispatcher> dispatcher,
+                                     mx_rights_t rights, uint32_t topic,
+                                     object_info_record* record, size_t* size) {
+    switch (topic) {
+        case MX_INFO_HANDLE_BASIC: {
+            bool waitable = dispatcher->get_state_tracker() != nullptr;
+            mx_info_handle_basic_t info = {
+                .koid = dispatcher->get_koid(),
+                .rights = rights,
+                .type = dispatcher->get_type(),
+                .related_koid = dispatcher->get_related_koid(),
+                .props = waitable ? MX_OBJ_PROP_WAITABLE : MX_OBJ_PROP_NONE,
+            };
+            record->handle_basic = info;
+            *size = sizeof(info);
+            return NO_ERROR;
+        }
+        case MX_INFO_PROCESS: {
+            if (!(rights & MX_RIGHT_READ))
+                return ERR_ACCESS_DENIED;
+            auto process = DownCastDispatcher<ProcessDispatcher>(&dispatcher);
+            if (!process)
+                return ERR_WRONG_TYPE;
+            record->process = {};
+            *size = sizeof(record->process);
+            return process->GetInfo(&record->process);
+        }
+        case MX_INFO_THREAD: {
+            if (!(rights & MX_RIGHT_READ))
+                return ERR_ACCESS_DENIED;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            record->thread = {};
+            *size = sizeof(record->thread);
+            return thread->GetInfo(&record->thread);
+        }
+        case MX_INFO_THREAD_STATS: {
+            if (!(rights & MX_RIGHT_READ))
+                return ERR_ACCESS_DENIED;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            record->thread_stats = {};
+            *size = sizeof(record->thread_stats);
+            return thread->GetStats(&record->thread_stats);
+        }
+        case MX_INFO_TASK_STATS: {
+            if (!(rights & MX_RIGHT_READ))
+                return ERR_ACCESS_DENIED;
+            auto process = DownCastDispatcher<ProcessDispatcher>(&dispatcher);
+            if (!process)
+                return ERR_WRONG_TYPE;
+            record->task_stats = {};
+            *size = sizeof(record->task_stats);
+            return process->GetStats(&record->task_stats);
+        }
+        case MX_INFO_JOB_STATS: {
+            if (!(rights & MX_RIGHT_READ))
+                return ERR_ACCESS_DENIED;
+            auto job = DownCastDispatcher<JobDispatcher>(&dispatcher);
+            if (!job)
+                return ERR_WRONG_TYPE;
+            record->job_stats = {};
+            job->GetStats(&record->job_stats);
+            *size = sizeof(record->job_stats);
+            return NO_ERROR;
+        }
+        case MX_INFO_VMAR: {
+            auto vmar = DownCastDispatcher<VmAddressRegionDispatcher>(&dispatcher);
+            if (!vmar)
+                return ERR_WRONG_TYPE;
+            auto real_vmar = vmar->vmar();
+            mx_info_vmar_t info = {
+                .base = real_vmar->base(),
+                .len = real_vmar->size(),
+            };
+            record->vmar = info;
+            *size = sizeof(info);
+            return NO_ERROR;
+        }
+        default:
+            return ERR_NOT_SUPPORTED;
+    }
+}
+
+mx_status_t sys_object_get_info_batch(mx_handle_t vmo_handle,
+                                      user_ptr<mx_object_info_entry_t> _entries,
+                                      uint32_t count, user_ptr<uint32_t> _actual) {
+    LTRACEF("vmo %d count %u\n", vmo_handle, count);
+
+    if (!count || count > MX_OBJECT_INFO_BATCH_MAX)
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<VmObjectDispatcher> vmo;
+    mx_status_t status = up->GetDispatcherWithRights(vmo_handle, MX_RIGHT_WRITE, &vmo);
+    if (status != NO_ERROR)
+        return status;
+
+    AllocChecker ac;
+    mxtl::unique_ptr<mx_object_info_entry_t[]> entries(
+        new (&ac) mx_object_info_entry_t[count]);
+    if (!ac.check())
+        return ERR_NO_MEMORY;
+    if (_entries.copy_array_from_user(entries.get(), count) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    struct resolved_handle {
+        mxtl::RefPtr<Dispatcher> dispatcher;
+        mx_rights_t rights;
+    };
+    mxtl::unique_ptr<resolved_handle[]> resolved(new (&ac) resolved_handle[count]);
+    if (!ac.check())
+        return ERR_NO_MEMORY;
+
+    // One pass over the handle table for the whole batch. Only the
+    // lookups happen under the lock; the info queries may take other
+    // locks and the vmo writes may fault, so both run after it drops.
+    {
+        AutoLock lock(up->handle_table_lock());
+        for (uint32_t ix = 0; ix != count; ++ix) {
+            Handle* source = up->GetHandleLocked(entries[ix].handle);
+            if (!source) {
+                entries[ix].status = ERR_BAD_HANDLE;
+                continue;
+            }
+            resolved[ix].dispatcher = source->dispatcher();
+            resolved[ix].rights = source->rights();
+            entries[ix].status = NO_ERROR;
+        }
+    }
+
+    uint32_t actual = 0;
+    for (uint32_t ix = 0; ix != count; ++ix) {
+        entries[ix].actual = 0;
+        if (entries[ix].status != NO_ERROR)
+            continue;
+
+        if (entries[ix].topic == MX_INFO_HANDLE_VALID) {
+            // the successful lookup above is the whole query
+            ++actual;
+            continue;
+        }
+
+        object_info_record record;
+        size_t size = 0;
+        mx_status_t res = object_info_query(mxtl::move(resolved[ix].dispatcher),
+                                            resolved[ix].rights,
+                                            entries[ix].topic, &record, &size);
+        if (res == NO_ERROR && entries[ix].buffer_size < size)
+            res = ERR_BUFFER_TOO_SMALL;
+        if (res == NO_ERROR) {
+            size_t written;
+            res = vmo->vmo()->Write(&record, entries[ix].offset, size, &written);
+            if (res == NO_ERROR && written != size)
+                res = ERR_OUT_OF_RANGE;
+        }
+        entries[ix].status = res;
+        if (res == NO_ERROR) {
+            entries[ix].actual = static_cast<uint32_t>(size);
+            ++actual;
+        }
+    }
+
+    if (_entries.copy_array_to_user(entries.get(), count) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual && (_actual.copy_to_user(actual) != NO_ERROR))
+        return ERR_INVALID_ARGS;
+    return NO_ERROR;
+}
+
 mx_status_t sys_object_get_property(mx_handle_t handle_value, uint32_t property,
                                     user_ptr<void> _value, size_t size) {
     if (!_value)
@@ -428,6 +726,17 @@ mx_status_t sys_object_get_property(mx_handle_t handle_value, uint32_t property,
                 return ERR_INVALID_ARGS;
             return NO_ERROR;
         }
+        case MX_PROP_THREAD_TIMER_SLACK: {
+            if (size < sizeof(uint64_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            uint64_t value = thread->thread()->timer_slack();
+            if (_value.reinterpret<uint64_t>().copy_to_user(value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            return NO_ERROR;
+        }
         default:
             return ERR_INVALID_ARGS;
     }
@@ -492,6 +801,95 @@ mx_status_t sys_object_set_property(mx_handle_t handle_value, uint32_t property,
                 return ERR_INVALID_ARGS;
             return process->set_debug_addr(value);
         }
+        case MX_PROP_THREAD_TIMER_SLACK: {
+            if (size < sizeof(uint64_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            uint64_t value = 0;
+            if (_value.reinterpret<const uint64_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            thread->thread()->set_timer_slack(value);
+            return NO_ERROR;
+        }
+        case MX_PROP_VMO_NUMA_POLICY: {
+            if (size < sizeof(uint64_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto vmo = DownCastDispatcher<VmObjectDispatcher>(&dispatcher);
+            if (!vmo)
+                return ERR_WRONG_TYPE;
+            uint64_t value = 0;
+            if (_value.reinterpret<const uint64_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            uint32_t policy = static_cast<uint32_t>(value);
+            uint32_t node = static_cast<uint32_t>(value >> 32);
+            uint32_t node_flags;
+            switch (policy) {
+                case MX_NUMA_POLICY_NONE:
+                    node_flags = 0;
+                    break;
+                case MX_NUMA_POLICY_LOCAL:
+                    node_flags = PMM_ALLOC_FLAG_NODE_LOCAL;
+                    break;
+                case MX_NUMA_POLICY_INTERLEAVE:
+                    node_flags = PMM_ALLOC_FLAG_NODE_INTERLEAVE;
+                    break;
+                case MX_NUMA_POLICY_BIND:
+                    if (node > PMM_ALLOC_NODE_MASK)
+                        return ERR_INVALID_ARGS;
+                    node_flags = PMM_ALLOC_FLAG_NODE_BIND | PMM_ALLOC_FLAG_NODE(node);
+                    break;
+                default:
+                    return ERR_INVALID_ARGS;
+            }
+            return vmo->vmo()->SetNumaPolicy(node_flags);
+        }
+        case MX_PROP_PROCESS_MEMORY_WATERMARK: {
+            if (size < sizeof(uint64_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto process = DownCastDispatcher<ProcessDispatcher>(&dispatcher);
+            if (!process)
+                return ERR_WRONG_TYPE;
+            uint64_t value = 0;
+            if (_value.reinterpret<const uint64_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            return process->SetMemoryWatermark(value);
+        }
+        case MX_PROP_THREAD_DEADLINE: {
+            if (size < sizeof(mx_thread_deadline_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            mx_thread_deadline_t value = {};
+            if (_value.reinterpret<const mx_thread_deadline_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            return thread->thread()->set_deadline(value.capacity, value.relative_deadline,
+                                                  value.period);
+        }
+        case MX_PROP_THREAD_CPU_AFFINITY: {
+            if (size < sizeof(uint32_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+            if (!thread)
+                return ERR_WRONG_TYPE;
+            uint32_t value = 0;
+            if (_value.reinterpret<const uint32_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            return thread->thread()->set_cpu_affinity(value);
+        }
+        case MX_PROP_JOB_CPU_MASK: {
+            if (size < sizeof(uint32_t))
+                return ERR_BUFFER_TOO_SMALL;
+            auto job = DownCastDispatcher<JobDispatcher>(&dispatcher);
+            if (!job)
+                return ERR_WRONG_TYPE;
+            uint32_t value = 0;
+            if (_value.reinterpret<const uint32_t>().copy_from_user(&value) != NO_ERROR)
+                return ERR_INVALID_ARGS;
+            return job->set_cpu_mask(value);
+        }
     }
 
     return ERR_INVALID_ARGS;
@@ -22,6 +22,7 @@
 
 #include <mxtl/inline_array.h>
 #include <mxtl/ref_ptr.h>
+#include <mxtl/unique_ptr.h>
 
 #include "syscalls_priv.h"
 
@@ -29,7 +30,8 @@
 
 constexpr uint32_t kMaxWaitHandleCount = 1024u;
 
-// Note: This is used for quite a few InlineArrays (simultaneously) in sys_handle_wait_many.
+// Note: This is used for the WaitStateObserver InlineArray in sys_object_wait_many;
+// the items themselves are staged in the thread's scratch buffer when they fit.
 constexpr size_t kWaitManyInlineCount = 8u;
 
 mx_status_t sys_object_wait_one(mx_handle_t handle_value,
@@ -104,11 +106,19 @@ mx_status_t sys_object_wait_many(user_ptr<mx_wait_item_t> _items, uint32_t count
     if (count > kMaxWaitHandleCount)
         return ERR_INVALID_ARGS;
 
+    // Stage the items in the calling thread's scratch buffer when they fit,
+    // avoiding a heap allocation per call for all but the largest waits.
     AllocChecker ac;
-    mxtl::InlineArray<mx_wait_item_t, kWaitManyInlineCount> items(&ac, count);
-    if (!ac.check())
-        return ERR_NO_MEMORY;
-    if (_items.copy_array_from_user(items.get(), count) != NO_ERROR)
+    mx_wait_item_t* items = static_cast<mx_wait_item_t*>(
+        UserThread::GetCurrent()->GetScratchBuffer(count * sizeof(mx_wait_item_t)));
+    mxtl::unique_ptr<mx_wait_item_t[]> items_heap;
+    if (!items) {
+        items_heap.reset(new (&ac) mx_wait_item_t[count]);
+        if (!ac.check())
+            return ERR_NO_MEMORY;
+        items = items_heap.get();
+    }
+    if (_items.copy_array_from_user(items, count) != NO_ERROR)
         return ERR_INVALID_ARGS;
 
     mxtl::InlineArray<WaitStateObserver, kWaitManyInlineCount> wait_state_observers(&ac, count);
@@ -158,7 +168,7 @@ mx_status_t sys_object_wait_many(user_ptr<mx_wait_item_t> _items, uint32_t count
         combined |= (items[ix].pending = wait_state_observers[ix].End());
     }
 
-    if (_items.copy_array_to_user(items.get(), count) != NO_ERROR)
+    if (_items.copy_array_to_user(items, count) != NO_ERROR)
         return ERR_INVALID_ARGS;
 
     if (combined & MX_SIGNAL_HANDLE_CLOSED)
@@ -152,6 +152,36 @@ mx_status_t sys_port_wait(mx_handle_t handle, mx_time_t deadline,
     return NO_ERROR;
 }
 
+mx_status_t sys_port_dequeue(mx_handle_t handle, mx_time_t deadline,
+                             user_ptr<void> _packets, size_t count,
+                             user_ptr<size_t> _actual) {
+    magenta_check_deadline("port_dequeue", deadline);
+    LTRACEF("handle %d count %zu\n", handle, count);
+
+    if (!_packets || (count == 0u))
+        return ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // Bulk dequeue is only provided by V2 ports.
+    mxtl::RefPtr<PortDispatcherV2> port;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_READ, &port);
+    if (status != NO_ERROR)
+        return status;
+
+    mx_port_packet_t pp[PortDispatcherV2::kDeQueueBatchMax];
+    size_t actual = 0u;
+    status = port->DeQueueMany(deadline, pp, count, &actual);
+    if (status != NO_ERROR)
+        return status;
+
+    if (_packets.copy_array_to_user(pp, actual * sizeof(mx_port_packet_t)) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual.copy_to_user(actual) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    return NO_ERROR;
+}
+
 mx_status_t sys_port_bind(mx_handle_t handle, uint64_t key,
                           mx_handle_t source, mx_signals_t signals) {
     LTRACEF("handle %d source %d\n", handle, source);
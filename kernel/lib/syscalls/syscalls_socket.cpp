@@ -101,10 +101,13 @@ mx_status_t sys_socket_read(mx_handle_t handle, uint32_t options,
                             user_ptr<size_t> _actual) {
     LTRACEF("handle %d\n", handle);
 
-    if (options)
+    if (options & ~(MX_SOCKET_PEEK | MX_SOCKET_CONSUME))
+        return ERR_INVALID_ARGS;
+    if (options == (MX_SOCKET_PEEK | MX_SOCKET_CONSUME))
         return ERR_INVALID_ARGS;
 
-    if (!_buffer && size > 0)
+    // A consume drops already-peeked data; there is nothing to copy out.
+    if (!_buffer && size > 0 && options != MX_SOCKET_CONSUME)
         return ERR_INVALID_ARGS;
 
     auto up = ProcessDispatcher::GetCurrent();
@@ -115,8 +118,12 @@ mx_status_t sys_socket_read(mx_handle_t handle, uint32_t options,
         return status;
 
     size_t nread;
-    // TODO(andymutton): Change SocketDispatcher to accept a user_ptr?
-    status = socket->Read(_buffer.get(), size, true, &nread);
+    if (options == MX_SOCKET_CONSUME) {
+        status = socket->Consume(size, &nread);
+    } else {
+        // TODO(andymutton): Change SocketDispatcher to accept a user_ptr?
+        status = socket->Read(_buffer.get(), size, true, options == MX_SOCKET_PEEK, &nread);
+    }
 
     // Caller may ignore results if desired.
     if (status == NO_ERROR && _actual)
@@ -212,6 +212,55 @@ mx_status_t sys_task_suspend(mx_handle_t task_handle) {
     return thread->Suspend();
 }
 
+mx_status_t sys_task_step(mx_handle_t task_handle, uint32_t state_kind,
+                          user_ptr<void> _buffer, uint32_t buffer_len,
+                          user_ptr<uint32_t> _actual) {
+    LTRACEF("handle %d, state_kind %u\n", task_handle, state_kind);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // TODO(dje): debug rights
+    // Stepping both resumes the thread and reads its state back.
+    mxtl::RefPtr<ThreadDispatcher> thread;
+    mx_status_t status = up->GetDispatcherWithRights(task_handle,
+                                                     MX_RIGHT_READ | MX_RIGHT_WRITE, &thread);
+    if (status != NO_ERROR)
+        return status;
+
+    // avoid malloc'ing insane amounts
+    if (buffer_len > kMaxThreadStateSize)
+        return ERR_INVALID_ARGS;
+
+    status = thread->thread()->StepFromException();
+    if (status != NO_ERROR)
+        return status;
+
+    // The thread is stopped at the next instruction; hand back the new
+    // register snapshot so single-step loops don't need a separate
+    // thread_read_state call.
+    AllocChecker ac;
+    mxtl::InlineArray<uint8_t, kInlineThreadStateSize> bytes(&ac, buffer_len);
+    if (!ac.check())
+        return ERR_NO_MEMORY;
+
+    status = thread->thread()->ReadState(state_kind, bytes.get(), &buffer_len);
+
+    // Always set the actual size so the caller can provide larger buffers.
+    // The value is only usable if the status is NO_ERROR or ERR_BUFFER_TOO_SMALL.
+    if (status == NO_ERROR || status == ERR_BUFFER_TOO_SMALL) {
+        if (_actual.copy_to_user(buffer_len) != NO_ERROR)
+            return ERR_INVALID_ARGS;
+    }
+
+    if (status != NO_ERROR)
+        return status;
+
+    if (_buffer.copy_array_to_user(bytes.get(), buffer_len) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    return NO_ERROR;
+}
+
 mx_status_t sys_process_create(mx_handle_t job_handle,
                                user_ptr<const char> _name, uint32_t name_len,
                                uint32_t options, user_ptr<mx_handle_t> _proc_handle,
@@ -282,6 +331,90 @@ mx_status_t sys_process_create(mx_handle_t job_handle,
     return NO_ERROR;
 }
 
+mx_status_t sys_process_create_from_template(mx_handle_t job_handle,
+                                             mx_handle_t tmpl_handle,
+                                             user_ptr<const char> _name, uint32_t name_len,
+                                             uint32_t options, user_ptr<mx_handle_t> _proc_handle,
+                                             user_ptr<mx_handle_t> _vmar_handle) {
+    LTRACEF("job handle %d, template handle %d, options %#x\n",
+            job_handle, tmpl_handle, options);
+
+    // currently, the only valid option value is 0
+    if (options != 0)
+        return ERR_INVALID_ARGS;
+
+    // copy out the name
+    char buf[MX_MAX_NAME_LEN];
+    mxtl::StringPiece sp;
+    // Silently truncate the given name.
+    if (name_len > sizeof(buf))
+        name_len = sizeof(buf);
+    status_t result = magenta_copy_user_string(_name.get(), name_len, buf, sizeof(buf), &sp);
+    if (result != NO_ERROR)
+        return result;
+    LTRACEF("name %s\n", buf);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<JobDispatcher> job;
+    // TODO: define process creation job rights.
+    auto status = up->GetDispatcherWithRights(job_handle, MX_RIGHT_WRITE, &job);
+    if (status != NO_ERROR)
+        return status;
+
+    // the template's entire address space becomes readable through the COW
+    // clone (via the new process the caller controls), so hold this to the
+    // same bar as process_read_memory: READ and WRITE rights
+    mxtl::RefPtr<ProcessDispatcher> tmpl_proc;
+    status = up->GetDispatcherWithRights(tmpl_handle, MX_RIGHT_READ | MX_RIGHT_WRITE, &tmpl_proc);
+    if (status != NO_ERROR)
+        return status;
+
+    // create a new, empty process dispatcher
+    mxtl::RefPtr<Dispatcher> proc_dispatcher;
+    mxtl::RefPtr<VmAddressRegionDispatcher> vmar_dispatcher;
+    mx_rights_t proc_rights, vmar_rights;
+    status_t res = ProcessDispatcher::Create(mxtl::move(job), sp, options,
+                                             &proc_dispatcher, &proc_rights,
+                                             &vmar_dispatcher, &vmar_rights);
+    if (res != NO_ERROR)
+        return res;
+
+    // populate the new address space as a copy-on-write copy of the
+    // template's; no pages move until one side writes
+    res = vmar_dispatcher->vmar()->aspace()->CloneFrom(tmpl_proc->aspace().get());
+    if (res != NO_ERROR)
+        return res;
+
+    uint32_t koid = (uint32_t)proc_dispatcher->get_koid();
+    ktrace(TAG_PROC_CREATE, koid, 0, 0, 0);
+    ktrace_name(TAG_PROC_NAME, koid, 0, buf);
+
+    // Give arch-specific tracing a chance to record process creation.
+    arch_trace_process_create(koid, &vmar_dispatcher->vmar()->aspace()->arch_aspace());
+
+    // Create a handle and attach the dispatcher to it
+    HandleOwner proc_h(MakeHandle(mxtl::move(proc_dispatcher), proc_rights));
+    if (!proc_h)
+        return ERR_NO_MEMORY;
+
+    // Create a handle and attach the dispatcher to it
+    HandleOwner vmar_h(MakeHandle(mxtl::move(vmar_dispatcher), vmar_rights));
+    if (!vmar_h)
+        return ERR_NO_MEMORY;
+
+    if (_proc_handle.copy_to_user(up->MapHandleToValue(proc_h)) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    if (_vmar_handle.copy_to_user(up->MapHandleToValue(vmar_h)) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    up->AddHandle(mxtl::move(vmar_h));
+    up->AddHandle(mxtl::move(proc_h));
+
+    return NO_ERROR;
+}
+
 // Note: This is used to start the main thread (as opposed to using
 // sys_thread_start for that) for a few reasons:
 // - less easily exploitable
@@ -430,6 +563,108 @@ mx_status_t sys_process_write_memory(mx_handle_t proc, uintptr_t vaddr,
     return st;
 }
 
+// Resolves |vaddr| in |process| and transfers one range against the
+// backing vmo; the shared body of the memory accessors above and their
+// vectored variants below.
+static mx_status_t process_memory_op_one(ProcessDispatcher* process, uintptr_t vaddr,
+                                         user_ptr<void> buffer, size_t len,
+                                         bool write, size_t* actual) {
+    auto aspace = process->aspace();
+    if (!aspace)
+        return ERR_BAD_STATE;
+
+    auto region = aspace->FindRegion(vaddr);
+    if (!region)
+        return ERR_NO_MEMORY;
+
+    auto vm_mapping = region->as_vm_mapping();
+    if (!vm_mapping)
+        return ERR_NO_MEMORY;
+
+    auto vmo = vm_mapping->vmo();
+    if (!vmo)
+        return ERR_NO_MEMORY;
+
+    uint64_t offset = vaddr - vm_mapping->base() + vm_mapping->object_offset();
+    if (write)
+        return vmo->WriteUser(buffer.reinterpret<const void>(), offset, len, actual);
+    return vmo->ReadUser(buffer, offset, len, actual);
+}
+
+// Shared body of the vectored process memory accessors. Batches the
+// per-range resolution and transfer into one syscall; ranges may land
+// in different mappings, so unlike the vmo vector ops each range takes
+// its own vmo lock.
+static mx_status_t process_memory_vec(mx_handle_t proc, user_ptr<mx_iovec_entry_t> _entries,
+                                      uint32_t num_entries, user_ptr<uint32_t> _actual_entries,
+                                      bool write) {
+    if (num_entries == 0u || num_entries > MX_IOVEC_MAX_ENTRIES)
+        return ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<ProcessDispatcher> process;
+    mx_rights_t rights = write ? MX_RIGHT_WRITE : (MX_RIGHT_READ | MX_RIGHT_WRITE);
+    mx_status_t status = up->GetDispatcherWithRights(proc, rights, &process);
+    if (status != NO_ERROR)
+        return status;
+
+    mx_iovec_entry_t entries[MX_IOVEC_MAX_ENTRIES];
+    if (_entries.copy_array_from_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    const size_t max_block = write ? kMaxDebugWriteBlock : kMaxDebugReadBlock;
+    uint32_t done = 0;
+    mx_status_t stop_reason = NO_ERROR;
+    for (; done < num_entries; done++) {
+        auto& entry = entries[done];
+        entry.actual = 0;
+
+        mx_status_t r;
+        if (!entry.buffer || entry.length == 0 || entry.length > max_block) {
+            r = ERR_INVALID_ARGS;
+        } else {
+            r = process_memory_op_one(process.get(), entry.offset,
+                                      make_user_ptr(entry.buffer), entry.length,
+                                      write, &entry.actual);
+        }
+        entry.status = r;
+        if (r != NO_ERROR) {
+            stop_reason = r;
+            break;
+        }
+    }
+    // ranges never attempted because an earlier one failed
+    for (uint32_t i = done + 1; i < num_entries; i++) {
+        entries[i].actual = 0;
+        entries[i].status = ERR_BAD_STATE;
+    }
+
+    if (_entries.copy_array_to_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual_entries.copy_to_user(done) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // as with the other batched syscalls a partial vector is a success
+    return (done > 0u) ? NO_ERROR : stop_reason;
+}
+
+mx_status_t sys_process_read_memory_vec(mx_handle_t proc, user_ptr<mx_iovec_entry_t> _entries,
+                                        uint32_t num_entries,
+                                        user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("proc %d entries %p num_entries %u\n", proc, _entries.get(), num_entries);
+
+    return process_memory_vec(proc, _entries, num_entries, _actual_entries, false);
+}
+
+mx_status_t sys_process_write_memory_vec(mx_handle_t proc, user_ptr<mx_iovec_entry_t> _entries,
+                                         uint32_t num_entries,
+                                         user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("proc %d entries %p num_entries %u\n", proc, _entries.get(), num_entries);
+
+    return process_memory_vec(proc, _entries, num_entries, _actual_entries, true);
+}
+
 // helper routine for sys_task_kill
 template <typename T>
 static mx_status_t kill_task(mxtl::RefPtr<Dispatcher> dispatcher) {
@@ -143,6 +143,187 @@ mx_status_t sys_vmo_write(mx_handle_t handle, user_ptr<const void> _data,
     return status;
 }
 
+// Shared tail of the vectored vmo accessors: copy per-segment results
+// back out and report partial success the way the channel batch
+// syscalls do.
+static mx_status_t finish_vmo_vec(user_ptr<mx_iovec_entry_t> _entries,
+                                  mx_iovec_entry_t* entries, uint32_t num_entries,
+                                  const VmObject::UserVec* vec, size_t done,
+                                  mx_status_t status,
+                                  user_ptr<uint32_t> _actual_entries) {
+    for (uint32_t i = 0; i < num_entries; i++) {
+        entries[i].actual = vec[i].actual;
+        if (i < done) {
+            entries[i].status = NO_ERROR;
+        } else if (i == done && status != NO_ERROR) {
+            entries[i].status = status;
+        } else {
+            // never attempted because an earlier segment failed
+            entries[i].status = ERR_BAD_STATE;
+        }
+    }
+
+    if (_entries.copy_array_to_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+    if (_actual_entries.copy_to_user(static_cast<uint32_t>(done)) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // a partial vector is a success; the stop reason only surfaces when
+    // nothing transferred at all
+    return (done > 0u) ? NO_ERROR : status;
+}
+
+mx_status_t sys_vmo_read_vec(mx_handle_t handle, user_ptr<mx_iovec_entry_t> _entries,
+                             uint32_t num_entries, user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("handle %d entries %p num_entries %u\n", handle, _entries.get(), num_entries);
+
+    if (num_entries == 0u || num_entries > MX_IOVEC_MAX_ENTRIES)
+        return ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<VmObjectDispatcher> vmo;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_READ, &vmo);
+    if (status != NO_ERROR)
+        return status;
+
+    mx_iovec_entry_t entries[MX_IOVEC_MAX_ENTRIES];
+    if (_entries.copy_array_from_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // Force map every destination range up front, as in sys_vmo_read
+    // (TODO(MG-730) workaround), so the copy loop does not fault with
+    // the vmo lock held.
+    for (uint32_t i = 0; i < num_entries; i++) {
+        uint8_t byte = 0;
+        auto int_data = make_user_ptr(entries[i].buffer).reinterpret<uint8_t>();
+        for (size_t off = 0; off < entries[i].length; off += PAGE_SIZE) {
+            status = int_data.copy_array_to_user(&byte, 1, off);
+            if (status != NO_ERROR)
+                return status;
+        }
+        if (entries[i].length > 0) {
+            status = int_data.copy_array_to_user(&byte, 1, entries[i].length - 1);
+            if (status != NO_ERROR)
+                return status;
+        }
+    }
+
+    VmObject::UserVec vec[MX_IOVEC_MAX_ENTRIES];
+    for (uint32_t i = 0; i < num_entries; i++) {
+        vec[i].buffer = entries[i].buffer;
+        vec[i].offset = entries[i].offset;
+        vec[i].len = entries[i].length;
+    }
+
+    size_t done = 0;
+    status = vmo->ReadVector(vec, num_entries, &done);
+
+    return finish_vmo_vec(_entries, entries, num_entries, vec, done, status, _actual_entries);
+}
+
+mx_status_t sys_vmo_write_vec(mx_handle_t handle, user_ptr<mx_iovec_entry_t> _entries,
+                              uint32_t num_entries, user_ptr<uint32_t> _actual_entries) {
+    LTRACEF("handle %d entries %p num_entries %u\n", handle, _entries.get(), num_entries);
+
+    if (num_entries == 0u || num_entries > MX_IOVEC_MAX_ENTRIES)
+        return ERR_OUT_OF_RANGE;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    mxtl::RefPtr<VmObjectDispatcher> vmo;
+    mx_status_t status = up->GetDispatcherWithRights(handle, MX_RIGHT_WRITE, &vmo);
+    if (status != NO_ERROR)
+        return status;
+
+    mx_iovec_entry_t entries[MX_IOVEC_MAX_ENTRIES];
+    if (_entries.copy_array_from_user(entries, num_entries) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    // Force map every source range up front, as in sys_vmo_write
+    // (TODO(MG-730) workaround).
+    for (uint32_t i = 0; i < num_entries; i++) {
+        uint8_t byte = 0;
+        auto int_data = make_user_ptr(entries[i].buffer).reinterpret<const uint8_t>();
+        for (size_t off = 0; off < entries[i].length; off += PAGE_SIZE) {
+            status = int_data.copy_array_from_user(&byte, 1, off);
+            if (status != NO_ERROR)
+                return status;
+        }
+        if (entries[i].length > 0) {
+            status = int_data.copy_array_from_user(&byte, 1, entries[i].length - 1);
+            if (status != NO_ERROR)
+                return status;
+        }
+    }
+
+    VmObject::UserVec vec[MX_IOVEC_MAX_ENTRIES];
+    for (uint32_t i = 0; i < num_entries; i++) {
+        vec[i].buffer = entries[i].buffer;
+        vec[i].offset = entries[i].offset;
+        vec[i].len = entries[i].length;
+    }
+
+    size_t done = 0;
+    status = vmo->WriteVector(vec, num_entries, &done);
+
+    return finish_vmo_vec(_entries, entries, num_entries, vec, done, status, _actual_entries);
+}
+
+mx_status_t sys_vmo_transfer(mx_handle_t src_handle, uint64_t src_offset,
+                             mx_handle_t dst_handle, uint64_t dst_offset, uint64_t len) {
+    LTRACEF("src %d offset %#" PRIx64 " dst %d offset %#" PRIx64 " len %#" PRIx64 "\n",
+            src_handle, src_offset, dst_handle, dst_offset, len);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // lookup both dispatchers; read on the source, write on the destination
+    mxtl::RefPtr<VmObjectDispatcher> src;
+    mx_status_t status = up->GetDispatcherWithRights(src_handle, MX_RIGHT_READ, &src);
+    if (status != NO_ERROR)
+        return status;
+
+    mxtl::RefPtr<VmObjectDispatcher> dst;
+    status = up->GetDispatcherWithRights(dst_handle, MX_RIGHT_WRITE, &dst);
+    if (status != NO_ERROR)
+        return status;
+
+    // the copy runs entirely inside the vm, page by page through the kernel
+    // physmap, so the data never bounces through a user buffer
+    return VmObjectPaged::Transfer(src->vmo(), src_offset, dst->vmo(), dst_offset, len);
+}
+
+mx_status_t sys_vmo_dedup(mx_handle_t src_handle, uint64_t src_offset,
+                          mx_handle_t dst_handle, uint64_t dst_offset, uint64_t len,
+                          user_ptr<uint64_t> _deduped) {
+    LTRACEF("src %d offset %#" PRIx64 " dst %d offset %#" PRIx64 " len %#" PRIx64 "\n",
+            src_handle, src_offset, dst_handle, dst_offset, len);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // lookup both dispatchers; read on the source, write on the destination
+    mxtl::RefPtr<VmObjectDispatcher> src;
+    mx_status_t status = up->GetDispatcherWithRights(src_handle, MX_RIGHT_READ, &src);
+    if (status != NO_ERROR)
+        return status;
+
+    mxtl::RefPtr<VmObjectDispatcher> dst;
+    status = up->GetDispatcherWithRights(dst_handle, MX_RIGHT_WRITE, &dst);
+    if (status != NO_ERROR)
+        return status;
+
+    // the vm only merges destination pages whose contents match the source,
+    // so a caller with a bad hash table can waste time but not corrupt data
+    uint64_t deduped = 0;
+    status = VmObjectPaged::Dedup(src->vmo(), src_offset, dst->vmo(), dst_offset, len, &deduped);
+
+    // copy the count back, even if it failed
+    if (_deduped.copy_to_user(deduped) != NO_ERROR)
+        return ERR_INVALID_ARGS;
+
+    return status;
+}
+
 mx_status_t sys_vmo_get_size(mx_handle_t handle, user_ptr<uint64_t> _size) {
     LTRACEF("handle %d, sizep %p\n", handle, _size.get());
 
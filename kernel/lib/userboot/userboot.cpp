@@ -18,7 +18,9 @@
 #include <kernel/cmdline.h>
 #include <kernel/vm/vm_object_paged.h>
 
+#include <lib/boottime.h>
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/vdso.h>
 #include <lk/init.h>
 
@@ -182,6 +184,8 @@ enum bootstrap_handle_index {
     BOOTSTRAP_THREAD,
     BOOTSTRAP_JOB,
     BOOTSTRAP_VMAR_ROOT,
+    BOOTSTRAP_KCOUNTERS,
+    BOOTSTRAP_BOOTTIME,
     BOOTSTRAP_HANDLES
 };
 
@@ -236,6 +240,14 @@ static mxtl::unique_ptr<MessagePacket> prepare_bootstrap_message() {
         case BOOTSTRAP_VMAR_ROOT:
             info = PA_HND(PA_VMAR_ROOT, 0);
             break;
+        case BOOTSTRAP_KCOUNTERS:
+            info = PA_HND(PA_VMO_KCOUNTERS, 0);
+            break;
+        case BOOTSTRAP_BOOTTIME:
+            // The kernel's boot timeline rides as a second bootdata VMO
+            // next to the ramdisk, which carries the bootloader's.
+            info = PA_HND(PA_VMO_BOOTDATA, 1);
+            break;
         case BOOTSTRAP_HANDLES:
             __builtin_unreachable();
         }
@@ -247,6 +259,8 @@ static mxtl::unique_ptr<MessagePacket> prepare_bootstrap_message() {
 }
 
 static int attempt_userboot() {
+    boot_timeline_mark("krnl.userboot");
+
     size_t rsize;
     void* rbase = platform_get_ramdisk(&rsize);
     if (rbase)
@@ -276,6 +290,14 @@ static int attempt_userboot() {
     if (status == NO_ERROR)
         status = get_job_handle(&handles[BOOTSTRAP_JOB]);
 
+    if (status == NO_ERROR)
+        status = get_vmo_handle(kcounters_get_vmo(), true, nullptr,
+                                &handles[BOOTSTRAP_KCOUNTERS]);
+
+    if (status == NO_ERROR)
+        status = get_vmo_handle(boot_timeline_get_vmo(), true, nullptr,
+                                &handles[BOOTSTRAP_BOOTTIME]);
+
     if (status != NO_ERROR)
         return status;
 
@@ -31,4 +31,16 @@ struct vdso_constants {
 
     // Total amount of physical memory in the system, in bytes.
     uint64_t physmem;
+
+    // Conversion factor from raw ticks (see mx_ticks_get) to the
+    // monotonic clock, expressed as a binary fixed-point value with the
+    // integer part in ticks_to_mono_l0 and the next two 32-bit chunks
+    // of fraction in ticks_to_mono_l32 and ticks_to_mono_l64 (the same
+    // fp_32_64 representation the kernel's clock uses).  Valid only
+    // when ticks_to_mono_valid is nonzero; when it is zero, reading the
+    // monotonic clock requires entering the kernel.
+    uint32_t ticks_to_mono_valid;
+    uint32_t ticks_to_mono_l0;
+    uint32_t ticks_to_mono_l32;
+    uint32_t ticks_to_mono_l64;
 };
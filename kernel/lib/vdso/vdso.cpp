@@ -11,6 +11,7 @@
 #include <kernel/vm.h>
 #include <kernel/vm/vm_aspace.h>
 #include <kernel/vm/vm_object.h>
+#include <lib/fixed_point.h>
 #include <mxtl/type_support.h>
 #include <platform.h>
 
@@ -112,6 +113,14 @@ VDso::VDso() : RoDso("vdso", vdso_image, VDSO_CODE_END, VDSO_CODE_START) {
         "vDSO constants", vmo()->vmo(), VDSO_DATA_CONSTANTS);
     uint64_t per_second = ticks_per_second();
 
+    // If the platform's monotonic clock is a pure function of the raw
+    // tick counter, publish the conversion factor so the vDSO can
+    // compute mx_time_get(MX_CLOCK_MONOTONIC) without entering the
+    // kernel.
+    struct fp_32_64 ticks_to_mono = {};
+    bool fast_mono = platform_monotonic_tick_scale(&ticks_to_mono) &&
+        per_second != 0 && !cmdline_get_bool("vdso.soft_ticks", false);
+
     // Initialize the constants that should be visible to the vDSO.
     // Rather than assigning each member individually, do this with
     // struct assignment and a compound literal so that the compiler
@@ -121,8 +130,19 @@ VDso::VDso() : RoDso("vdso", vdso_image, VDSO_CODE_END, VDSO_CODE_START) {
         arch_dcache_line_size(),
         per_second,
         pmm_count_total_bytes(),
+        fast_mono ? 1u : 0u,
+        ticks_to_mono.l0,
+        ticks_to_mono.l32,
+        ticks_to_mono.l64,
     };
 
+    if (fast_mono) {
+        // Adjust the mx_time_get entry point to the userspace-only
+        // implementation for the monotonic clock.
+        VDsoDynSymWindow dynsym_window(vmo()->vmo());
+        REDIRECT_SYSCALL(dynsym_window, mx_time_get, fast_time_get);
+    }
+
     // If ticks_per_second has not been calibrated, it will return 0. In this
     // case, use soft_ticks instead.
     if (per_second == 0 || cmdline_get_bool("vdso.soft_ticks", false)) {
@@ -133,4 +153,14 @@ VDso::VDso() : RoDso("vdso", vdso_image, VDSO_CODE_END, VDSO_CODE_START) {
         VDsoDynSymWindow dynsym_window(vmo()->vmo());
         REDIRECT_SYSCALL(dynsym_window, mx_ticks_get, soft_ticks_get);
     }
+
+    // Route a few hot syscalls through userspace wrappers that answer
+    // trivially-invalid calls without entering the kernel.  The wrappers
+    // bake in limits of this kernel build, which is safe precisely
+    // because the vDSO is delivered by the kernel it was built with.
+    if (!cmdline_get_bool("vdso.no_fast_entry", false)) {
+        VDsoDynSymWindow dynsym_window(vmo()->vmo());
+        REDIRECT_SYSCALL(dynsym_window, mx_handle_close, fast_handle_close);
+        REDIRECT_SYSCALL(dynsym_window, mx_channel_write, fast_channel_write);
+    }
 }
@@ -67,4 +67,17 @@ extern void platform_watchdog_pet(void);
 status_t watchdog_hw_init(lk_time_t timeout);
 void watchdog_hw_set_enabled(bool enabled);
 
+/* Soft lockup detector.  Every cpu reports progress from its timer tick
+ * and from the scheduler; healthy cpus cross-check the other active cpus
+ * and report one that has stalled to the debug log, along with a backtrace
+ * captured on the stalled cpu via IPI.  Disable with
+ * kernel.lockup-detector=false on the command line.
+ */
+
+/* called by the scheduler on every reschedule */
+void watchdog_lockup_progress(void);
+
+/* called by the platform timer tick; also runs the cross-cpu check */
+void watchdog_lockup_tick(lk_time_t now);
+
 #endif  // __LIB_WATCHDOG_H__
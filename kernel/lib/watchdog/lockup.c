@@ -0,0 +1,129 @@
+// Copyright 2016 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+/* Soft lockup detector.
+ *
+ * Every cpu bumps a private progress counter from its timer tick and from
+ * the scheduler.  Whichever healthy cpu takes its timer tick next scans
+ * the other active cpus' counters (at most once per check interval); a cpu
+ * whose counter has not moved for the stall threshold is reported to the
+ * debug log along with a backtrace captured on the wedged cpu via IPI.
+ * The scan runs from every cpu's tick rather than from one timer so the
+ * detector keeps working no matter which cpu wedges.
+ */
+
+#include <assert.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <arch/ops.h>
+#include <kernel/cmdline.h>
+#include <kernel/mp.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <lib/watchdog.h>
+#include <lk/init.h>
+#include <magenta/compiler.h>
+#include <platform.h>
+
+/* how often a healthy cpu scans the others */
+#define LOCKUP_CHECK_INTERVAL LK_SEC(1)
+
+/* how long a cpu may make no progress before it is reported */
+#define LOCKUP_THRESHOLD LK_SEC(10)
+
+typedef struct lockup_state {
+    /* bumped by the owning cpu from the tick and the scheduler */
+    volatile uint32_t progress;
+    /* checker-side bookkeeping, protected by check_lock */
+    uint32_t last_seen;
+    lk_time_t stall_start;
+    bool reported;
+} __CPU_ALIGN lockup_state_t;
+
+static lockup_state_t lockup_state[SMP_MAX_CPUS];
+static spin_lock_t check_lock = SPIN_LOCK_INITIAL_VALUE;
+static lk_time_t last_check;
+static bool lockup_detector_enabled = true;
+
+void watchdog_lockup_progress(void)
+{
+    lockup_state[arch_curr_cpu_num()].progress++;
+}
+
+/* runs on the wedged cpu once it services interrupts again; everything
+ * printed here lands in the debuglog ring */
+static void lockup_capture_task(void *context)
+{
+    uint cpu = arch_curr_cpu_num();
+    thread_t *t = get_current_thread();
+
+    dprintf(CRITICAL, "WATCHDOG: cpu %u backtrace, current thread %p '%s':\n",
+            cpu, t, t ? t->name : "<none>");
+#if WITH_PANIC_BACKTRACE
+    thread_print_backtrace(t, __GET_FRAME());
+#endif
+}
+
+static void lockup_check(lk_time_t now)
+{
+    uint curr = arch_curr_cpu_num();
+
+    for (uint cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (cpu == curr || !mp_is_cpu_active(cpu))
+            continue;
+
+        lockup_state_t *s = &lockup_state[cpu];
+        uint32_t progress = s->progress;
+        if (progress != s->last_seen) {
+            s->last_seen = progress;
+            s->stall_start = now;
+            s->reported = false;
+            continue;
+        }
+
+        if (!s->reported && TIME_GT(now, s->stall_start + LOCKUP_THRESHOLD)) {
+            s->reported = true;
+            dprintf(CRITICAL,
+                    "WATCHDOG: cpu %u made no timer or scheduler progress for %" PRIu64 " ms\n",
+                    cpu, (now - s->stall_start) / LK_MSEC(1));
+            /* ask the wedged cpu for a backtrace.  fire-and-forget: a cpu
+             * spinning with interrupts disabled will never service the ipi,
+             * and a blocking request would wedge this cpu too */
+            mp_async_exec(1u << cpu, lockup_capture_task, NULL);
+        }
+    }
+}
+
+void watchdog_lockup_tick(lk_time_t now)
+{
+    lockup_state[arch_curr_cpu_num()].progress++;
+
+    if (!lockup_detector_enabled)
+        return;
+
+    /* rate limit the scan and keep checkers off each other; a trylock is
+     * enough since any healthy cpu's next tick will pick up the work */
+    if (TIME_LT(now, last_check + LOCKUP_CHECK_INTERVAL))
+        return;
+    if (!spin_trylock(&check_lock)) {
+        if (TIME_LT(now, last_check + LOCKUP_CHECK_INTERVAL)) {
+            spin_unlock(&check_lock);
+            return;
+        }
+        last_check = now;
+        lockup_check(now);
+        spin_unlock(&check_lock);
+    }
+}
+
+static void lockup_detector_init(uint level)
+{
+    lockup_detector_enabled = cmdline_get_bool("kernel.lockup-detector", true);
+}
+
+LK_INIT_HOOK(lockup_detector, lockup_detector_init, LK_INIT_LEVEL_THREADING);
@@ -39,3 +39,8 @@ __WEAK void *platform_get_ramdisk(size_t *size)
     *size = 0;
     return NULL;
 }
+
+__WEAK bool platform_monotonic_tick_scale(struct fp_32_64 *ns_per_tick)
+{
+    return false;
+}
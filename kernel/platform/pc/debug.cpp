@@ -33,15 +33,27 @@ static bool output_enabled = false;
 
 static enum handler_return platform_drain_debug_uart_rx(void)
 {
-    unsigned char c;
+    char buf[32];
+    size_t n = 0;
     bool resched = false;
 
+    // Batch chars out of the fifo; the keyboard also feeds
+    // console_input_buf, so use the locked writer, but batching still
+    // means one lock acquisition and one signal per chunk instead of
+    // per char.
     while (inp(uart_io_port + 5) & (1<<0)) {
-        c = inp(uart_io_port + 0);
-        cbuf_write_char(&console_input_buf, c, false);
+        buf[n++] = static_cast<char>(inp(uart_io_port + 0));
         resched = true;
+
+        if (n == sizeof(buf)) {
+            cbuf_write(&console_input_buf, buf, n, false);
+            n = 0;
+        }
     }
 
+    if (n > 0)
+        cbuf_write(&console_input_buf, buf, n, false);
+
     return resched ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
 }
 
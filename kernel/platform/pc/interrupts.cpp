@@ -16,6 +16,7 @@
 #include <arch/x86.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/apic.h>
+#include <arch/x86/mp.h>
 #include <lk/init.h>
 #include <kernel/spinlock.h>
 #include "platform_p.h"
@@ -340,6 +341,31 @@ status_t x86_alloc_msi_block(uint requested_irqs,
     return res;
 }
 
+status_t x86_msi_target_addr_for_cpu(uint cpu_num, uint64_t* out_tgt_addr) {
+    DEBUG_ASSERT(out_tgt_addr);
+
+    uint32_t apic_id;
+    status_t res = x86_cpu_num_to_apic_id(cpu_num, &apic_id);
+    if (res != NO_ERROR)
+        return res;
+
+    // Only 8 bits of destination ID fit in the target address; xAPIC IDs
+    // beyond that would need interrupt remapping support to target.
+    if (apic_id & ~0xFFu)
+        return ERR_NOT_SUPPORTED;
+
+    // Compute the target address.
+    // See section 10.11.1 of the Intel 64 and IA-32 Architectures Software
+    // Developer's Manual Volume 3A.
+    uint32_t tgt_addr = 0xFEE00000;      // base addr
+    tgt_addr |= apic_id << 12;           // Dest ID == target CPU's local APIC ID
+    tgt_addr &= ~0x08;                   // Redir hint == 0 (directed)
+    tgt_addr &= ~0x04;                   // Dest Mode == Physical
+
+    *out_tgt_addr = tgt_addr;
+    return NO_ERROR;
+}
+
 void x86_free_msi_block(pcie_msi_block_t* block) {
     DEBUG_ASSERT(block);
     DEBUG_ASSERT(block->allocated);
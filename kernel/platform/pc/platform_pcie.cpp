@@ -40,6 +40,10 @@ public:
                             void*                   ctx) override {
         x86_register_msi_handler(block, msi_id, handler, ctx);
     }
+
+    status_t MsiTargetAddrForCpu(uint cpu_num, uint64_t* out_tgt_addr) const override {
+        return x86_msi_target_addr_for_cpu(cpu_num, out_tgt_addr);
+    }
 };
 
 X86PciePlatformSupport platform_pcie_support;
@@ -133,6 +137,8 @@ static void x86_pcie_init_hook(uint level) {
     }
 }
 
-LK_INIT_HOOK(x86_pcie_init, x86_pcie_init_hook, LK_INIT_LEVEL_PLATFORM);
+// The bus scan only touches PCIe state and can overlap the rest of the
+// platform-level hooks; lk_init joins it before any higher level runs.
+LK_INIT_HOOK_PARALLEL(x86_pcie_init, x86_pcie_init_hook, LK_INIT_LEVEL_PLATFORM);
 
 #endif  // WITH_DEV_PCIE
@@ -12,11 +12,13 @@
  * initialized.
  */
 #include <arch/ops.h>
+#include <kernel/thread.h>
 #include <lk/init.h>
 
 #include <assert.h>
 #include <magenta/compiler.h>
 #include <debug.h>
+#include <stdbool.h>
 #include <trace.h>
 
 #define LOCAL_TRACE 0
@@ -28,6 +30,42 @@
 extern const struct lk_init_struct __start_lk_init[] __WEAK;
 extern const struct lk_init_struct __stop_lk_init[] __WEAK;
 
+#define MAX_PARALLEL_HOOKS 8
+
+struct parallel_hooks {
+    thread_t *threads[MAX_PARALLEL_HOOKS];
+    uint count;
+};
+
+static int parallel_hook_thread(void *arg)
+{
+    const struct lk_init_struct *ptr = arg;
+    ptr->hook(ptr->level);
+    return 0;
+}
+
+static void join_parallel_hooks(struct parallel_hooks *ph)
+{
+    for (uint i = 0; i < ph->count; i++)
+        thread_join(ph->threads[i], NULL, INFINITE_TIME);
+    ph->count = 0;
+}
+
+/* returns true if the hook was handed off to a worker thread */
+static bool spawn_parallel_hook(struct parallel_hooks *ph, const struct lk_init_struct *ptr)
+{
+    if (ph->count == MAX_PARALLEL_HOOKS)
+        return false;
+    thread_t *t = thread_create(ptr->name, parallel_hook_thread, (void *)ptr,
+                                DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+    if (!t)
+        return false;
+    ph->threads[ph->count] = t;
+    ph->count++;
+    thread_resume(t);
+    return true;
+}
+
 void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop_level)
 {
     LTRACEF("flags %#x, start_level %#x, stop_level %#x\n",
@@ -36,6 +74,8 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
     ASSERT(start_level > 0);
     uint last_called_level = start_level - 1;
     const struct lk_init_struct *last = NULL;
+    struct parallel_hooks pending = { .count = 0 };
+    uint pending_level = 0;
     for (;;) {
         /* search for the lowest uncalled hook to call */
         LTRACEF("last %p, last_called_level %#x\n", last, last_called_level);
@@ -77,16 +117,35 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
         if (!found)
             break;
 
+        /* parallel hooks at a lower level must finish before anything at a
+         * higher level runs */
+        if (pending.count > 0 && found->level > pending_level)
+            join_parallel_hooks(&pending);
+
 #if TRACE_INIT
         if (found->level >= EARLIEST_TRACE_LEVEL) {
             printf("INIT: cpu %u, calling hook %p (%s) at level %#x, flags %#x\n",
                    arch_curr_cpu_num(), found->hook, found->name, found->level, found->flags);
         }
 #endif
-        found->hook(found->level);
+        /* hooks marked parallel have no ordering against the rest of their
+         * level and can run on a worker thread once the scheduler is up */
+        bool spawned = false;
+        if ((found->flags & LK_INIT_FLAG_PARALLEL) &&
+            (required_flag == LK_INIT_FLAG_PRIMARY_CPU) &&
+            (found->level >= LK_INIT_LEVEL_THREADING)) {
+            spawned = spawn_parallel_hook(&pending, found);
+            if (spawned)
+                pending_level = found->level;
+        }
+        if (!spawned)
+            found->hook(found->level);
         last_called_level = found->level;
         last = found;
     }
+
+    if (pending.count > 0)
+        join_parallel_hooks(&pending);
 }
 
 #if 0
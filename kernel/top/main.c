@@ -20,6 +20,7 @@
 #include <lib/heap.h>
 #include <kernel/mutex.h>
 #include <kernel/thread.h>
+#include <lib/boottime.h>
 #include <lk/init.h>
 #include <lk/main.h>
 
@@ -48,6 +49,8 @@ void lk_main(void)
     // get us into some sort of thread context
     thread_init_early();
 
+    boot_timeline_mark("krnl.entry");
+
     // deal with any static constructors
     call_constructors();
 
@@ -63,6 +66,8 @@ void lk_main(void)
     lk_primary_cpu_init_level(LK_INIT_LEVEL_PLATFORM_EARLY, LK_INIT_LEVEL_TARGET_EARLY - 1);
     target_early_init();
 
+    boot_timeline_mark("krnl.early");
+
 #if WITH_SMP
     dprintf(INFO, "\nwelcome to lk/MP\n\n");
 #else
@@ -74,12 +79,16 @@ void lk_main(void)
     dprintf(SPEW, "initializing heap\n");
     heap_init();
 
+    boot_timeline_mark("krnl.heap");
+
     // initialize the kernel
     lk_primary_cpu_init_level(LK_INIT_LEVEL_HEAP, LK_INIT_LEVEL_KERNEL - 1);
     kernel_init();
 
     lk_primary_cpu_init_level(LK_INIT_LEVEL_KERNEL, LK_INIT_LEVEL_THREADING - 1);
 
+    boot_timeline_mark("krnl.kernel");
+
     // create a thread to complete system initialization
     dprintf(SPEW, "creating bootstrap completion thread\n");
     thread_t *t = thread_create("bootstrap2", &bootstrap2, NULL, DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
@@ -95,6 +104,8 @@ static int bootstrap2(void *arg)
 {
     dprintf(SPEW, "top of bootstrap2()\n");
 
+    boot_timeline_mark("krnl.threading");
+
     lk_primary_cpu_init_level(LK_INIT_LEVEL_THREADING, LK_INIT_LEVEL_ARCH - 1);
     arch_init();
 
@@ -103,6 +114,8 @@ static int bootstrap2(void *arg)
     lk_primary_cpu_init_level(LK_INIT_LEVEL_ARCH, LK_INIT_LEVEL_PLATFORM - 1);
     platform_init();
 
+    boot_timeline_mark("krnl.platform");
+
     // initialize the target
     dprintf(SPEW, "initializing target\n");
     lk_primary_cpu_init_level(LK_INIT_LEVEL_PLATFORM, LK_INIT_LEVEL_TARGET - 1);
@@ -114,6 +127,8 @@ static int bootstrap2(void *arg)
 
     lk_primary_cpu_init_level(LK_INIT_LEVEL_APPS, LK_INIT_LEVEL_LAST);
 
+    boot_timeline_mark("krnl.apps");
+
     return 0;
 }
 
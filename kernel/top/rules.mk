@@ -10,6 +10,7 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 MODULE := $(LOCAL_DIR)
 
 MODULE_DEPS := \
+	kernel/lib/boottime \
 	kernel/platform \
 	kernel/target \
 	kernel/app \
@@ -39,6 +39,7 @@ static mx_status_t cmd_ps0(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_bst(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_bif(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_enable_event(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
+static mx_status_t cmd_eval_batch(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 static mx_status_t cmd_new_connection(mx_handle_t h, acpi_handle_ctx_t* ctx, void* cmd);
 
 typedef mx_status_t (*cmd_handler_t)(mx_handle_t, acpi_handle_ctx_t*, void*);
@@ -51,6 +52,7 @@ static const cmd_handler_t cmd_table[] = {
         [ACPI_CMD_BST] = cmd_bst,
         [ACPI_CMD_BIF] = cmd_bif,
         [ACPI_CMD_ENABLE_EVENT] = cmd_enable_event,
+        [ACPI_CMD_EVAL_BATCH] = cmd_eval_batch,
         [ACPI_CMD_NEW_CONNECTION] = cmd_new_connection,
 };
 
@@ -700,6 +702,88 @@ static mx_status_t cmd_enable_event(mx_handle_t h, acpi_handle_ctx_t* ctx, void*
     return mx_channel_write(h, 0, &rsp, sizeof(rsp), NULL, 0);
 }
 
+// Evaluate a single batch entry into *result*.  Only methods returning an
+// integer or a package of integers are supported; richer results keep going
+// through their dedicated commands (e.g. ACPI_CMD_BIF for the strings).
+static void eval_batch_method(acpi_handle_ctx_t* ctx, char name[4],
+                              acpi_rsp_eval_batch_result_t* result) {
+    if (!is_valid_name(name)) {
+        result->status = ERR_INVALID_ARGS;
+        return;
+    }
+    char method[5] = {0};
+    memcpy(method, name, 4);
+
+    ACPI_BUFFER buffer = {
+        .Length = ACPI_ALLOCATE_BUFFER,
+        .Pointer = NULL,
+    };
+    ACPI_STATUS acpi_status = AcpiEvaluateObject(ctx->ns_node, method, NULL, &buffer);
+    if (acpi_status != AE_OK) {
+        result->status = ERR_NOT_FOUND;
+        return;
+    }
+    if (buffer.Pointer == NULL) {
+        // the method evaluated fine but returned nothing (_INI, _ON, ...);
+        // that falls outside the integer-results contract of this command
+        result->status = ERR_NOT_SUPPORTED;
+        return;
+    }
+
+    ACPI_OBJECT* obj = (ACPI_OBJECT*)buffer.Pointer;
+    if (obj->Type == ACPI_TYPE_INTEGER) {
+        result->status = NO_ERROR;
+        result->num_values = 1;
+        result->values[0] = obj->Integer.Value;
+    } else if (obj->Type == ACPI_TYPE_PACKAGE &&
+               obj->Package.Count <= ACPI_EVAL_BATCH_MAX_VALUES) {
+        result->status = NO_ERROR;
+        result->num_values = obj->Package.Count;
+        for (uint32_t i = 0; i < obj->Package.Count; i++) {
+            if (obj->Package.Elements[i].Type != ACPI_TYPE_INTEGER) {
+                result->status = ERR_NOT_SUPPORTED;
+                result->num_values = 0;
+                break;
+            }
+            result->values[i] = obj->Package.Elements[i].Integer.Value;
+        }
+    } else {
+        result->status = ERR_NOT_SUPPORTED;
+    }
+    ACPI_FREE(obj);
+}
+
+static mx_status_t cmd_eval_batch(mx_handle_t h, acpi_handle_ctx_t* ctx, void* _cmd) {
+    acpi_cmd_eval_batch_t* cmd = _cmd;
+    if (cmd->hdr.len < sizeof(*cmd)) {
+        return send_error(h, cmd->hdr.request_id, ERR_INVALID_ARGS);
+    }
+    const uint32_t count = cmd->count;
+    if (count == 0 || count > ACPI_EVAL_BATCH_MAX_METHODS ||
+        cmd->hdr.len != sizeof(*cmd) + sizeof(cmd->methods[0]) * count) {
+        return send_error(h, cmd->hdr.request_id, ERR_INVALID_ARGS);
+    }
+
+    acpi_rsp_eval_batch_t* rsp = NULL;
+    const uint32_t rsp_size = sizeof(*rsp) + sizeof(rsp->results[0]) * count;
+    rsp = calloc(1, rsp_size);
+    if (!rsp) {
+        return send_error(h, cmd->hdr.request_id, ERR_NO_MEMORY);
+    }
+
+    rsp->hdr.status = NO_ERROR;
+    rsp->hdr.len = rsp_size;
+    rsp->hdr.request_id = cmd->hdr.request_id;
+    rsp->count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        eval_batch_method(ctx, cmd->methods[i].name, &rsp->results[i]);
+    }
+
+    mx_status_t status = mx_channel_write(h, 0, rsp, rsp_size, NULL, 0);
+    free(rsp);
+    return status;
+}
+
 static mx_status_t cmd_new_connection(mx_handle_t h, acpi_handle_ctx_t* ctx, void* _cmd) {
     // if a handle was passed with this, as it should be
     // this command would have been handled without calling this function
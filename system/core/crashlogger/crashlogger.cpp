@@ -25,6 +25,7 @@
 #include "backtrace.h"
 #include "dso-list.h"
 #include "dump-pt.h"
+#include "minidump.h"
 #include "utils.h"
 
 #if defined(__x86_64__)
@@ -302,6 +303,22 @@ void process_report(const mx_exception_report_t* report, bool use_libunwind) {
         goto Fail;
     }
 
+    // In minidump mode skip the synchronous backtrace: snapshot everything
+    // into the pre-created VMO with bulk reads, resume the thread right away,
+    // and only then write the dump out for offline symbolization.
+    if (minidump_enabled) {
+        bool captured = minidump_capture(process, thread, report,
+                                         regs, sizeof(*regs), pc, sp);
+        resume_thread_from_exception(thread, report, regs);
+        crashed_thread = MX_HANDLE_INVALID;
+        crashed_thread_report = { };
+        if (captured)
+            minidump_finish();
+        mx_handle_close(thread);
+        mx_handle_close(process);
+        return;
+    }
+
     printf("bottom of user stack:\n");
     dump_memory(process, sp, kMemoryDumpSize);
     printf("arch: %s\n", arch);
@@ -408,6 +425,8 @@ void usage() {
     fprintf(stderr, "  -n = do not use libunwind\n");
     fprintf(stderr, "  -s[on|off] = enable s/w breakpoints to trigger\n");
     fprintf(stderr, "      a backtrace without terminating the process\n");
+    fprintf(stderr, "  -m[on|off] = write a minidump to /tmp instead of a\n");
+    fprintf(stderr, "      synchronous backtrace, symbolize offline\n");
 }
 
 int main(int argc, char** argv) {
@@ -441,6 +460,17 @@ int main(int argc, char** argv) {
 #endif
         } else if (strcmp(arg, "-n") == 0) {
             use_libunwind = false;
+        } else if (strncmp(arg, "-m", 2) == 0) {
+            if (arg[2] == '\0') {
+                minidump_enabled = true;
+            } else if (strcmp(arg, "-mon") == 0) {
+                minidump_enabled = true;
+            } else if (strcmp(arg, "-moff") == 0) {
+                minidump_enabled = false;
+            } else {
+                usage();
+                return 1;
+            }
         } else if (strncmp(arg, "-s", 2) == 0) {
             if (arg[2] == '\0') {
                 swbreak_backtrace_enabled = true;
@@ -458,6 +488,9 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (minidump_enabled)
+        minidump_init();
+
     // At debugging level 1 print our dso list (in case we crash in a way
     // that prevents printing it later).
     if (verbosity_level >= 1) {
@@ -0,0 +1,210 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <magenta/syscalls.h>
+
+#include "dso-list.h"
+#include "minidump.h"
+#include "utils.h"
+
+bool minidump_enabled = false;
+
+// How much of the crashed thread's stack to capture, starting at sp.
+// Everything above sp is live frames; this is plenty for offline unwinding.
+constexpr size_t kStackDumpSize = 64 * 1024;
+
+// How much to transfer per mx_process_read_memory call.
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+constexpr size_t kMaxDumpSize = 4 * 1024 * 1024;
+
+static const char kOutputDir[] = "/tmp";
+
+// Pre-opened on startup so the crash path doesn't allocate or traverse
+// the namespace.
+static mx_handle_t dump_vmo = MX_HANDLE_INVALID;
+static int output_dir_fd = -1;
+static uint8_t read_buf[kReadChunkSize];
+
+// State of the dump currently being built.
+static uint64_t dump_size;
+static uint32_t dump_records;
+static uint64_t dump_pid;
+
+void minidump_init() {
+    auto status = mx_vmo_create(kMaxDumpSize, 0, &dump_vmo);
+    if (status != NO_ERROR) {
+        print_mx_error("minidump: unable to create dump vmo", status);
+        minidump_enabled = false;
+        return;
+    }
+    output_dir_fd = open(kOutputDir, O_RDONLY | O_DIRECTORY);
+    if (output_dir_fd < 0) {
+        print_error("minidump: unable to open %s\n", kOutputDir);
+        minidump_enabled = false;
+    }
+}
+
+static bool append(const void* data, size_t len) {
+    if (dump_size + len > kMaxDumpSize)
+        return false;
+    size_t actual;
+    auto status = mx_vmo_write(dump_vmo, data, dump_size, len, &actual);
+    if (status != NO_ERROR || actual != len)
+        return false;
+    dump_size += len;
+    return true;
+}
+
+static bool append_pad() {
+    static const uint8_t zeros[8] = {};
+    size_t misalign = dump_size & 7;
+    if (misalign == 0)
+        return true;
+    return append(zeros, 8 - misalign);
+}
+
+static bool append_record(uint32_t type, const void* payload, size_t len) {
+    minidump_record_t rec = {type, static_cast<uint32_t>(len)};
+    if (!append(&rec, sizeof(rec)) || !append(payload, len) || !append_pad())
+        return false;
+    dump_records++;
+    return true;
+}
+
+// Captures [vaddr, vaddr + len) in kReadChunkSize transfers, stopping
+// early at unmapped memory.  The record is patched afterwards with the
+// length actually read.
+static bool append_memory(mx_handle_t process, mx_vaddr_t vaddr, size_t len) {
+    uint64_t rec_off = dump_size;
+    minidump_record_t rec = {MINIDUMP_RECORD_MEMORY, 0};
+    minidump_memory_t mem = {vaddr, 0};
+    if (!append(&rec, sizeof(rec)) || !append(&mem, sizeof(mem)))
+        return false;
+
+    size_t total = 0;
+    while (total < len) {
+        size_t xfer = len - total;
+        if (xfer > kReadChunkSize)
+            xfer = kReadChunkSize;
+        size_t actual = 0;
+        if (mx_process_read_memory(process, vaddr + total, read_buf,
+                                   xfer, &actual) != NO_ERROR || actual == 0)
+            break;
+        if (!append(read_buf, actual))
+            return false;
+        total += actual;
+        if (actual < xfer)
+            break;
+    }
+
+    rec.length = static_cast<uint32_t>(sizeof(mem) + total);
+    mem.length = total;
+    size_t actual;
+    if (mx_vmo_write(dump_vmo, &rec, rec_off, sizeof(rec), &actual) != NO_ERROR ||
+        mx_vmo_write(dump_vmo, &mem, rec_off + sizeof(rec), sizeof(mem), &actual) != NO_ERROR)
+        return false;
+    if (!append_pad())
+        return false;
+    dump_records++;
+    return true;
+}
+
+bool minidump_capture(mx_handle_t process, mx_handle_t thread,
+                      const mx_exception_report_t* report,
+                      const void* regs, size_t regs_size,
+                      mx_vaddr_t pc, mx_vaddr_t sp) {
+    if (dump_vmo == MX_HANDLE_INVALID)
+        return false;
+
+    dump_size = sizeof(minidump_header_t);
+    dump_records = 0;
+    dump_pid = report->context.pid;
+
+    minidump_info_t info = {};
+    info.pid = report->context.pid;
+    info.tid = report->context.tid;
+    info.excp_type = report->header.type;
+    info.arch_id = report->context.arch_id;
+    info.pc = pc;
+    if (!append_record(MINIDUMP_RECORD_INFO, &info, sizeof(info)))
+        return false;
+    if (!append_record(MINIDUMP_RECORD_REGS, regs, regs_size))
+        return false;
+
+    // TODO(dje): Registers and stacks of the other threads in the process,
+    // once they can be suspended. MG-588
+
+    if (!append_memory(process, sp, kStackDumpSize))
+        return false;
+
+    // The dso list (load addresses and build ids) is what lets the
+    // offline tool turn stack pcs back into symbols.
+    dsoinfo_t* dso_list = dso_fetch_list(process, "app");
+    for (dsoinfo_t* dso = dso_list; dso != nullptr; dso = dso->next) {
+        uint8_t payload[sizeof(minidump_dso_t) + sizeof(dso->buildid) + NAME_MAX + 2];
+        minidump_dso_t hdr = {dso->base};
+        size_t buildid_len = strlen(dso->buildid) + 1;
+        size_t name_len = strlen(dso->name) + 1;
+        if (name_len > NAME_MAX + 1)
+            name_len = NAME_MAX + 1;
+        memcpy(payload, &hdr, sizeof(hdr));
+        memcpy(payload + sizeof(hdr), dso->buildid, buildid_len);
+        memcpy(payload + sizeof(hdr) + buildid_len, dso->name, name_len);
+        payload[sizeof(hdr) + buildid_len + name_len - 1] = '\0';
+        if (!append_record(MINIDUMP_RECORD_DSO, payload,
+                           sizeof(hdr) + buildid_len + name_len)) {
+            dso_free_list(dso_list);
+            return false;
+        }
+    }
+    dso_free_list(dso_list);
+
+    minidump_header_t header = {MINIDUMP_MAGIC, MINIDUMP_VERSION,
+                                dump_records, static_cast<uint32_t>(dump_size)};
+    size_t actual;
+    return mx_vmo_write(dump_vmo, &header, 0, sizeof(header), &actual) == NO_ERROR;
+}
+
+void minidump_finish() {
+    if (dump_size == 0)
+        return;
+
+    char name[32];
+    snprintf(name, sizeof(name), "minidump.%" PRIu64, dump_pid);
+    int fd = openat(output_dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        print_error("minidump: unable to create %s/%s\n", kOutputDir, name);
+        return;
+    }
+
+    uint64_t off = 0;
+    while (off < dump_size) {
+        size_t xfer = dump_size - off;
+        if (xfer > kReadChunkSize)
+            xfer = kReadChunkSize;
+        size_t actual;
+        if (mx_vmo_read(dump_vmo, read_buf, off, xfer, &actual) != NO_ERROR ||
+            actual == 0) {
+            print_error("minidump: error reading back dump vmo\n");
+            break;
+        }
+        if (write(fd, read_buf, actual) != (ssize_t)actual) {
+            print_error("minidump: error writing %s/%s\n", kOutputDir, name);
+            break;
+        }
+        off += actual;
+    }
+    close(fd);
+
+    printf("minidump: wrote %" PRIu64 " bytes to %s/%s\n", off, kOutputDir, name);
+    dump_size = 0;
+}
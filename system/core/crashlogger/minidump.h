@@ -0,0 +1,78 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <magenta/types.h>
+#include <magenta/syscalls/exception.h>
+
+// A minidump is a minidump_header_t followed by a sequence of records,
+// each a minidump_record_t plus payload, padded to 8 byte boundaries.
+// It is built in a pre-created VMO on the crash path (registers, the
+// crashed thread's stack read in bulk, and the dso list needed to
+// symbolize offline) and only written out to a file after the crashed
+// thread has been resumed, so the job's exception port is stalled for
+// milliseconds instead of the seconds a synchronous backtrace takes.
+
+#define MINIDUMP_MAGIC   0x706d646d // 'mdmp'
+#define MINIDUMP_VERSION 1
+
+#define MINIDUMP_RECORD_INFO   1 // minidump_info_t
+#define MINIDUMP_RECORD_REGS   2 // raw MX_THREAD_STATE_REGSET0 contents
+#define MINIDUMP_RECORD_MEMORY 3 // minidump_memory_t followed by the bytes
+#define MINIDUMP_RECORD_DSO    4 // minidump_dso_t followed by "buildid\0name\0"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t total_size;        // including this header
+} minidump_header_t;
+
+typedef struct {
+    uint32_t type;              // MINIDUMP_RECORD_*
+    uint32_t length;            // payload length, excluding padding
+} minidump_record_t;
+
+typedef struct {
+    uint64_t pid;
+    uint64_t tid;
+    uint32_t excp_type;         // MX_EXCP_*
+    uint32_t arch_id;           // ARCH_ID_* from the exception context
+    uint64_t pc;
+} minidump_info_t;
+
+typedef struct {
+    uint64_t vaddr;
+    uint64_t length;            // bytes actually captured
+} minidump_memory_t;
+
+typedef struct {
+    uint64_t base;
+} minidump_dso_t;
+
+// If true then crashes produce a minidump instead of a synchronous
+// backtrace, and the crashed thread is resumed before anything is
+// written out.
+extern bool minidump_enabled;
+
+// Pre-opens everything the crash path needs (the dump VMO and the output
+// directory) so that no allocation or namespace traversal happens while
+// a crashed process is stalled on its exception port.
+void minidump_init();
+
+// Fast path: snapshot the exception info, thread registers, stack, and
+// dso list into the pre-created VMO using bulk reads.
+// Called before the crashed thread is resumed.
+bool minidump_capture(mx_handle_t process, mx_handle_t thread,
+                      const mx_exception_report_t* report,
+                      const void* regs, size_t regs_size,
+                      mx_vaddr_t pc, mx_vaddr_t sp);
+
+// Slow path, called after the crashed thread has been resumed: write the
+// captured dump to /tmp/minidump.<pid> for offline symbolization.
+void minidump_finish();
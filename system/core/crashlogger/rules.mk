@@ -13,6 +13,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/backtrace.cpp \
     $(LOCAL_DIR)/dso-list.cpp \
     $(LOCAL_DIR)/dump-pt.cpp \
+    $(LOCAL_DIR)/minidump.cpp \
     $(LOCAL_DIR)/utils.cpp \
 
 MODULE_NAME := crashlogger
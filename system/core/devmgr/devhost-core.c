@@ -205,10 +205,84 @@ static void devhost_device_probe_all(mx_device_t* dev, bool autobind) {
     }
 
     // if no driver is bound, add the device to the unmatched list
-    if (!device_is_bound(dev)) {
+    if (!device_is_bound(dev) && !list_in_list(&dev->unode)) {
         list_add_tail(&unmatched_device_list, &dev->unode);
     }
 }
+
+// async bind workers
+//
+// autobind probes run on a small pool of worker threads, so a slow driver
+// bind (usb enumeration, disk spinup, firmware load) does not serialize
+// device_add for independent branches of the device tree.  devices are
+// published (added to the tree and remoted to devmgr) before their probe
+// is queued, so parent-before-child ordering is unchanged.
+
+#define BIND_THREADS_MAX 4
+
+typedef struct {
+    list_node_t node;
+    mx_device_t* dev;
+} pending_bind_t;
+
+static list_node_t pending_bind_list = LIST_INITIAL_VALUE(pending_bind_list);
+static mtx_t bind_queue_lock = MTX_INIT;
+static cnd_t bind_queue_cnd = CND_INIT;
+static int bind_threads;
+static int bind_threads_idle;
+
+static int devhost_bind_worker(void* arg) {
+    mtx_lock(&bind_queue_lock);
+    while (1) {
+        pending_bind_t* pb;
+        while ((pb = list_remove_head_type(&pending_bind_list, pending_bind_t, node)) == NULL) {
+            bind_threads_idle++;
+            cnd_wait(&bind_queue_cnd, &bind_queue_lock);
+            bind_threads_idle--;
+        }
+        mtx_unlock(&bind_queue_lock);
+
+        mx_device_t* dev = pb->dev;
+        free(pb);
+
+        DM_LOCK();
+        if (!(dev->flags & DEV_FLAG_DEAD)) {
+            devhost_device_probe_all(dev, true);
+        }
+        // balances the acquire in devhost_queue_probe
+        dev_ref_release(dev);
+        DM_UNLOCK();
+
+        mtx_lock(&bind_queue_lock);
+    }
+    return 0;
+}
+
+// queue an autobind probe for a newly added device
+// called with the DM lock held
+static void devhost_queue_probe(mx_device_t* dev) {
+    pending_bind_t* pb = malloc(sizeof(pending_bind_t));
+    if (pb == NULL) {
+        // no memory to defer; probe on this thread instead
+        devhost_device_probe_all(dev, true);
+        return;
+    }
+    // keep the device alive until the worker has probed it
+    dev_ref_acquire(dev);
+    pb->dev = dev;
+
+    mtx_lock(&bind_queue_lock);
+    list_add_tail(&pending_bind_list, &pb->node);
+    if ((bind_threads_idle == 0) && (bind_threads < BIND_THREADS_MAX)) {
+        thrd_t t;
+        if (thrd_create_with_name(&t, devhost_bind_worker, NULL, "devhost-bind") == thrd_success) {
+            thrd_detach(t);
+            bind_threads++;
+        }
+    }
+    cnd_signal(&bind_queue_cnd);
+    mtx_unlock(&bind_queue_lock);
+}
 #endif
 
 
@@ -444,8 +518,9 @@ mx_status_t devhost_device_add(mx_device_t* dev, mx_device_t* parent,
     dev->flags |= DEV_FLAG_ADDED;
 
 #if !DEVHOST_V2
-    // probe the device
-    devhost_device_probe_all(dev, true);
+    // queue the device for autobind probing on a worker thread; a slow
+    // bind no longer blocks this add or its caller's siblings
+    devhost_queue_probe(dev);
 #endif
 
     dev->flags &= (~DEV_FLAG_BUSY);
@@ -224,7 +224,20 @@ static bool is_driver_disabled(const char* name) {
     return getenv(opt) != NULL;
 }
 
+// device binding program that pure (parentless)
+// misc devices use to get published in the
+// primary devhost
+static struct mx_bind_inst misc_device_binding =
+    BI_MATCH_IF(EQ, BIND_PROTOCOL, MX_PROTOCOL_MISC_PARENT);
+
+typedef struct {
+    const char* libname;
+    bool for_root;
+} search_args_t;
+
 static void found_driver(magenta_note_driver_t* note, mx_bind_inst_t* bi, void* cookie) {
+    search_args_t* args = cookie;
+
     // ensure strings are terminated
     note->name[sizeof(note->name) - 1] = 0;
     note->vendor[sizeof(note->vendor) - 1] = 0;
@@ -234,7 +247,17 @@ static void found_driver(magenta_note_driver_t* note, mx_bind_inst_t* bi, void*
         return;
     }
 
-    const char* libname = cookie;
+    // no-binding drivers and pure misc drivers only ever run in the
+    // root devhost; don't waste memory indexing them anywhere else
+    if (!args->for_root) {
+        if ((note->bindcount == 0) ||
+            ((note->bindcount == 1) &&
+             (memcmp(bi, &misc_device_binding, sizeof(misc_device_binding)) == 0))) {
+            return;
+        }
+    }
+
+    const char* libname = args->libname;
     size_t pathlen = strlen(libname) + 1;
     size_t namelen = strlen(note->name) + 1;
     size_t bindlen = note->bindcount * sizeof(mx_bind_inst_t);
@@ -277,12 +300,6 @@ static void found_driver(magenta_note_driver_t* note, mx_bind_inst_t* bi, void*
     }
 }
 
-// device binding program that pure (parentless)
-// misc devices use to get published in the
-// primary devhost
-static struct mx_bind_inst misc_device_binding =
-    BI_MATCH_IF(EQ, BIND_PROTOCOL, MX_PROTOCOL_MISC_PARENT);
-
 static bool is_misc_driver(mx_driver_t* drv) {
     return (drv->binding_size == sizeof(misc_device_binding)) &&
         (memcmp(&misc_device_binding, drv->binding, sizeof(misc_device_binding)) == 0);
@@ -318,7 +335,7 @@ static void init_loadable_drivers(bool for_root) {
     }
 }
 
-static void find_loadable_drivers(const char* path) {
+static void find_loadable_drivers(const char* path, bool for_root) {
     DIR* dir = opendir(path);
     if (dir == NULL) {
         return;
@@ -342,7 +359,11 @@ static void find_loadable_drivers(const char* path) {
         if ((fd = openat(dirfd(dir), de->d_name, O_RDONLY)) < 0) {
             continue;
         }
-        mx_status_t status = read_driver_info(fd, libname, found_driver);
+        search_args_t args = {
+            .libname = libname,
+            .for_root = for_root,
+        };
+        mx_status_t status = read_driver_info(fd, &args, found_driver);
         close(fd);
 
         if (status) {
@@ -395,7 +416,7 @@ void devhost_init_drivers(bool as_root) {
         _driver_acpi_root.ops->init(&_driver_acpi_root);
     }
     init_builtin_drivers(as_root);
-    find_loadable_drivers("/system/lib/driver");
-    find_loadable_drivers("/boot/lib/driver");
+    find_loadable_drivers("/system/lib/driver", as_root);
+    find_loadable_drivers("/boot/lib/driver", as_root);
     init_loadable_drivers(as_root);
 }
@@ -413,6 +413,10 @@ mx_status_t _devhost_rio_handler(mxrio_msg_t* msg, mx_handle_t rh_unused,
     case MXRIO_SYNC: {
         return do_ioctl(dev, IOCTL_DEVICE_SYNC, NULL, 0, NULL, 0);
     }
+    case MXRIO_SYNC_RANGE: {
+        // devices have no notion of a file range; sync the whole device
+        return do_ioctl(dev, IOCTL_DEVICE_SYNC, NULL, 0, NULL, 0);
+    }
     case MXRIO_IOCTL_1H: {
         if ((len > MXIO_IOCTL_MAX_INPUT) ||
             (arg > (ssize_t)sizeof(msg->data)) ||
@@ -114,6 +114,58 @@ static void start_system_init(void) {
     }
 }
 
+#define BOOTTIME_MAX 8
+
+static bootdata_boot_timeline_entry_t boottime_entries[BOOTTIME_MAX];
+static uint32_t boottime_count;
+
+void devmgr_boottime_mark(const char* name) {
+    if (boottime_count == BOOTTIME_MAX) {
+        return;
+    }
+    bootdata_boot_timeline_entry_t* e = &boottime_entries[boottime_count];
+    e->ticks = mx_ticks_get();
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->name[sizeof(e->name) - 1] = 0;
+    boottime_count++;
+}
+
+// Copies a boot timeline payload into a fresh VMO and publishes it at
+// /boot/kernel/boot-timeline.N, where the boottime tool picks it up.
+// The bootloader's and the kernel's records each arrive as a
+// BOOTDATA_BOOT_TIMELINE item; devmgr adds one of its own.
+static void publish_boot_timeline(const void* data, size_t len) {
+    static unsigned next = 0;
+    mx_handle_t vmo;
+    size_t actual;
+    if (mx_vmo_create(len, 0, &vmo) != NO_ERROR) {
+        return;
+    }
+    if (mx_vmo_write(vmo, data, 0, len, &actual) != NO_ERROR) {
+        mx_handle_close(vmo);
+        return;
+    }
+    char path[32];
+    snprintf(path, sizeof(path), "kernel/boot-timeline.%u", next);
+    if (bootfs_add_file(path, vmo, 0, len) == NO_ERROR) {
+        next++;
+    }
+}
+
+static void publish_devmgr_timeline(void) {
+    struct {
+        bootdata_boot_timeline_t hdr;
+        bootdata_boot_timeline_entry_t entries[BOOTTIME_MAX];
+    } timeline;
+    timeline.hdr.ticks_per_second = 0; // mx_ticks_get() timebase
+    timeline.hdr.entry_count = boottime_count;
+    timeline.hdr.reserved = 0;
+    memcpy(timeline.entries, boottime_entries,
+           boottime_count * sizeof(bootdata_boot_timeline_entry_t));
+    publish_boot_timeline(&timeline, sizeof(timeline.hdr) +
+                          (boottime_count * sizeof(timeline.entries[0])));
+}
+
 static bool has_secondary_bootfs = false;
 static ssize_t setup_bootfs_vmo(uint32_t n, uint32_t type, mx_handle_t vmo) {
     uint64_t size;
@@ -199,6 +251,18 @@ static void setup_bootfs(void) {
                 }
                 break;
             }
+            case BOOTDATA_BOOT_TIMELINE: {
+                void* data = malloc(bootdata.length);
+                if (data != NULL) {
+                    if ((mx_vmo_read(vmo, data, off + sizeof(bootdata),
+                                     bootdata.length, &actual) == NO_ERROR) &&
+                        (actual == bootdata.length)) {
+                        publish_boot_timeline(data, bootdata.length);
+                    }
+                    free(data);
+                }
+                break;
+            }
             case BOOTDATA_MDI:
             case BOOTDATA_CMDLINE:
             case BOOTDATA_ACPI_RSDP:
@@ -237,6 +301,9 @@ void devmgr_vfs_init(void) {
 
     setup_bootfs();
 
+    devmgr_boottime_mark("devmgr.vfs");
+    publish_devmgr_timeline();
+
     vfs_global_init(vfs_create_global_root());
 
     // give our own process access to files in the vfs
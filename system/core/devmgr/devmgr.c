@@ -365,6 +365,8 @@ int main(int argc, char** argv) {
     // loader sevice (as this leads to deadlocks in devhost v2)
     mxio_force_local_loader_service();
 
+    devmgr_boottime_mark("devmgr.start");
+
     devmgr_io_init();
 
     root_resource_handle = mx_get_startup_handle(PA_HND(PA_RESOURCE, 0));
@@ -15,6 +15,7 @@ void devmgr_handle_messages(void);
 
 void devmgr_io_init(void);
 void devmgr_vfs_init(void);
+void devmgr_boottime_mark(const char* name);
 void devmgr_vfs_exit(void);
 mx_status_t devmgr_launch(mx_handle_t job, const char* name,
                           int argc, const char* const* argv,
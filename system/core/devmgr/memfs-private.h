@@ -66,6 +66,7 @@ private:
     ssize_t Write(const void* data, size_t len, size_t off) final;
     mx_status_t Truncate(size_t len) final;
     mx_status_t Getattr(vnattr_t* a) final;
+    mx_status_t Mmap(int flags, size_t len, size_t* off, mx_handle_t* out) final;
 
     mx_handle_t vmo_;
     mx_off_t length_;
@@ -141,6 +142,7 @@ private:
     mx_status_t Serve(mx_handle_t h, uint32_t flags) final;
     ssize_t Read(void* data, size_t len, size_t off) final;
     mx_status_t Getattr(vnattr_t* a) final;
+    mx_status_t Mmap(int flags, size_t len, size_t* off, mx_handle_t* out) final;
     mx_status_t GetHandles(uint32_t flags, mx_handle_t* hnds,
                            uint32_t* type, void* extra, uint32_t* esize) final;
 
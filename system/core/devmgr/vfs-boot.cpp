@@ -27,6 +27,25 @@ mx_status_t VnodeVmo::Serve(mx_handle_t h, uint32_t flags) {
     return NO_ERROR;
 }
 
+mx_status_t VnodeVmo::Mmap(int flags, size_t len, size_t* off, mx_handle_t* out) {
+    // bootfs and systemfs blobs are read-only windows into a shared image vmo
+    if (flags & MXIO_MMAP_FLAG_WRITE) {
+        return ERR_ACCESS_DENIED;
+    }
+
+    mx_rights_t rights = MX_RIGHT_TRANSFER | MX_RIGHT_MAP;
+    rights |= (flags & MXIO_MMAP_FLAG_READ) ? MX_RIGHT_READ : 0;
+    rights |= (flags & MXIO_MMAP_FLAG_EXEC) ? MX_RIGHT_EXECUTE : 0;
+    mx_status_t status = mx_handle_duplicate(vmo_, rights, out);
+    if (status != NO_ERROR) {
+        return status;
+    }
+
+    // steer the caller to this file's window of the image
+    *off += offset_;
+    return NO_ERROR;
+}
+
 mx_status_t VnodeVmo::GetHandles(uint32_t flags, mx_handle_t* hnds,
                                  uint32_t* type, void* extra, uint32_t* esize) {
     mx_off_t* off = static_cast<mx_off_t*>(extra);
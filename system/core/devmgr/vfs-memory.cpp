@@ -142,6 +142,30 @@ ssize_t VnodeFile::Write(const void* data, size_t len, size_t off) {
     return actual;
 }
 
+mx_status_t VnodeFile::Mmap(int flags, size_t len, size_t* off, mx_handle_t* out) {
+    mx_status_t status;
+    if (vmo_ == MX_HANDLE_INVALID) {
+        // First access to the file? Allocate it.
+        if ((status = mx_vmo_create(0, 0, &vmo_)) != NO_ERROR) {
+            return status;
+        }
+    }
+
+    if (flags & MXIO_MMAP_FLAG_PRIVATE) {
+        // Private mappings get a copy-on-write snapshot of the file; later
+        // writes to the file (or the mapping) don't leak across.
+        return mx_vmo_clone(vmo_, MX_VMO_CLONE_COPY_ON_WRITE, 0, length_, out);
+    }
+
+    // Shared mappings hand out the file's own VMO, so pages are served in
+    // place and mapping and file contents stay coherent both ways.
+    mx_rights_t rights = MX_RIGHT_TRANSFER | MX_RIGHT_MAP;
+    rights |= (flags & MXIO_MMAP_FLAG_READ) ? MX_RIGHT_READ : 0;
+    rights |= (flags & MXIO_MMAP_FLAG_WRITE) ? MX_RIGHT_WRITE : 0;
+    rights |= (flags & MXIO_MMAP_FLAG_EXEC) ? MX_RIGHT_EXECUTE : 0;
+    return mx_handle_duplicate(vmo_, rights, out);
+}
+
 bool VnodeDir::IsRemote() const { return remoter_.IsRemote(); }
 mx_handle_t VnodeDir::DetachRemote() { return remoter_.DetachRemote(flags_); }
 mx_handle_t VnodeDir::WaitForRemote() { return remoter_.WaitForRemote(flags_); }
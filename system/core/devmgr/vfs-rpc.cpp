@@ -9,6 +9,7 @@
 #include <threads.h>
 
 #include <fs/vfs.h>
+#include <fs/vfs-dispatcher.h>
 #include <magenta/device/device.h>
 #include <magenta/device/vfs.h>
 #include <magenta/new.h>
@@ -60,12 +61,23 @@ mx_handle_t vfs_create_root_handle(VnodeMemfs* vn) {
     return h2;
 }
 
+// Worker pool size for the global VFS dispatcher
+static const unsigned kVfsPoolSize = 4;
+
 // Initialize the global root VFS node and dispatcher
 void vfs_global_init(VnodeDir* root) {
     memfs::global_vfs_root = root;
-    if (mxio_dispatcher_create(&vfs_dispatcher, mxrio_handler) == NO_ERROR) {
-        mxio_dispatcher_start(vfs_dispatcher, "vfs-rio-dispatcher");
+    AllocChecker ac;
+    fs::VfsDispatcher* dispatcher = new (&ac) fs::VfsDispatcher();
+    if (!ac.check()) {
+        return;
+    }
+    if ((dispatcher->Create(mxrio_handler, kVfsPoolSize) != NO_ERROR) ||
+        (dispatcher->Start("vfs-rio-dispatcher") != NO_ERROR)) {
+        delete dispatcher;
+        return;
     }
+    vfs_dispatcher = dispatcher;
 }
 
 // Return a RIO handle to the global root
@@ -0,0 +1,207 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "netsvc.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <inet6/inet6.h>
+
+#include <lib/crypto/cryptolib.h>
+
+#include <magenta/boot/netboot.h>
+
+// Content-addressed chunk cache.  Chunks of pushed files are kept in RAM
+// keyed by their sha256 digest, so that the next push of a mostly-unchanged
+// image (the routine dev-cycle case) only has to move the chunks that
+// actually differ; the rest are replayed from the cache via NB_CHUNK_WRITE.
+//
+// The cache survives for as long as netsvc runs.  Slots are allocated
+// lazily, so memory is only consumed once files are actually pushed.
+#define CHUNK_CACHE_SLOTS 2048 // 16MiB of chunk data when fully populated
+#define CHUNK_CACHE_PROBES 8
+
+typedef struct chunk_slot_t {
+    uint8_t digest[NB_DIGEST_SIZE];
+    uint8_t* data;
+    uint16_t size;
+} chunk_slot;
+
+static chunk_slot chunk_cache[CHUNK_CACHE_SLOTS];
+
+// Bytes written through netfile_write accumulate here so that freshly
+// pushed chunks enter the cache and are available to the next push.
+static uint8_t stage[NB_CHUNK_SIZE];
+static size_t staged;
+static bool stage_valid;
+
+static uint32_t chunk_hash(const uint8_t* digest) {
+    uint32_t h;
+    memcpy(&h, digest, sizeof(h));
+    return h % CHUNK_CACHE_SLOTS;
+}
+
+static chunk_slot* chunk_find(const uint8_t* digest) {
+    uint32_t idx = chunk_hash(digest);
+    for (unsigned n = 0; n < CHUNK_CACHE_PROBES; n++) {
+        chunk_slot* s = &chunk_cache[(idx + n) % CHUNK_CACHE_SLOTS];
+        if (s->data && !memcmp(s->digest, digest, NB_DIGEST_SIZE)) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static void chunk_insert(const uint8_t* digest, const void* data, size_t len) {
+    if (chunk_find(digest)) {
+        return;
+    }
+    uint32_t idx = chunk_hash(digest);
+    chunk_slot* victim = &chunk_cache[idx];
+    for (unsigned n = 0; n < CHUNK_CACHE_PROBES; n++) {
+        chunk_slot* s = &chunk_cache[(idx + n) % CHUNK_CACHE_SLOTS];
+        if (s->data == NULL) {
+            victim = s;
+            break;
+        }
+    }
+    if (victim->data == NULL) {
+        if ((victim->data = malloc(NB_CHUNK_SIZE)) == NULL) {
+            return;
+        }
+    }
+    memcpy(victim->digest, digest, NB_DIGEST_SIZE);
+    memcpy(victim->data, data, len);
+    victim->size = len;
+}
+
+void netchunk_stage_reset(void) {
+    staged = 0;
+    stage_valid = true;
+}
+
+void netchunk_stage(const void* data, size_t len) {
+    if (!stage_valid) {
+        return;
+    }
+    if (staged + len > NB_CHUNK_SIZE) {
+        // Writes are no longer chunk-aligned; stop caching this file.
+        stage_valid = false;
+        return;
+    }
+    memcpy(stage + staged, data, len);
+    staged += len;
+    if (staged == NB_CHUNK_SIZE) {
+        uint8_t digest[NB_DIGEST_SIZE];
+        clSHA256(stage, NB_CHUNK_SIZE, digest);
+        chunk_insert(digest, stage, NB_CHUNK_SIZE);
+        staged = 0;
+    }
+}
+
+void netchunk_stage_flush(void) {
+    // A short final chunk is still a chunk; cache it so the tail of the
+    // file can be skipped on the next push too.
+    if (stage_valid && staged > 0) {
+        uint8_t digest[NB_DIGEST_SIZE];
+        clSHA256(stage, staged, digest);
+        chunk_insert(digest, stage, staged);
+    }
+    staged = 0;
+    stage_valid = false;
+}
+
+void netchunk_query(const uint8_t* digests, size_t len, uint32_t cookie,
+                    uint32_t arg, const ip6_addr_t* saddr,
+                    uint16_t sport, uint16_t dport) {
+    struct {
+        nbmsg hdr;
+        uint8_t have[NB_QUERY_MAX_DIGESTS];
+    } m;
+    m.hdr.magic = NB_MAGIC;
+    m.hdr.cookie = cookie;
+    m.hdr.cmd = NB_ACK;
+    m.hdr.arg = arg;
+
+    if ((arg == 0) || (arg > NB_QUERY_MAX_DIGESTS) ||
+        (len < arg * NB_DIGEST_SIZE)) {
+        m.hdr.arg = -EINVAL;
+        udp6_send(&m.hdr, sizeof(m.hdr), saddr, sport, dport);
+        return;
+    }
+    for (uint32_t n = 0; n < arg; n++) {
+        m.have[n] = chunk_find(digests + n * NB_DIGEST_SIZE) ? 1 : 0;
+    }
+    udp6_send(&m, sizeof(m.hdr) + arg, saddr, sport, dport);
+}
+
+void netchunk_write(const uint8_t* digest, size_t len, uint32_t cookie,
+                    uint32_t arg, const ip6_addr_t* saddr,
+                    uint16_t sport, uint16_t dport) {
+    nbmsg m;
+    m.magic = NB_MAGIC;
+    m.cookie = cookie;
+    m.cmd = NB_ACK;
+    m.arg = 0;
+
+    if (netfile.fd < 0) {
+        printf("netsvc: chunk write, but no open file\n");
+        m.arg = -EBADF;
+        udp6_send(&m, sizeof(m), saddr, sport, dport);
+        return;
+    }
+    if (len < NB_DIGEST_SIZE) {
+        m.arg = -EINVAL;
+        udp6_send(&m, sizeof(m), saddr, sport, dport);
+        return;
+    }
+
+    if (arg == (netfile.blocknum - 1)) {
+        // repeat of last chunk write, probably due to dropped packet
+        // unless cookie doesn't match, in which case it's an error
+        if (cookie != netfile.cookie) {
+            m.arg = -EIO;
+            udp6_send(&m, sizeof(m), saddr, sport, dport);
+            return;
+        }
+    } else if (arg != netfile.blocknum) {
+        // ignore bogus write requests -- host will timeout if they're confused
+        return;
+    } else {
+        chunk_slot* s = chunk_find(digest);
+        if (s == NULL) {
+            // The chunk fell out of the cache since the query; the host
+            // falls back to sending it raw, so don't advance blocknum.
+            m.arg = -ENOENT;
+            udp6_send(&m, sizeof(m), saddr, sport, dport);
+            return;
+        }
+        if (staged != 0) {
+            // Cached chunks only land on chunk boundaries; a partial
+            // stage here means the host lost alignment, so stop caching.
+            staged = 0;
+            stage_valid = false;
+        }
+        ssize_t n = write(netfile.fd, s->data, s->size);
+        if (n != (ssize_t)s->size) {
+            printf("netsvc: error writing %s: %d\n", netfile.filename, errno);
+            m.arg = -errno;
+            if (m.arg == 0) {
+                m.arg = -EIO;
+            }
+            close(netfile.fd);
+            netfile.fd = -1;
+            udp6_send(&m, sizeof(m), saddr, sport, dport);
+            return;
+        }
+        netfile.blocknum++;
+        netfile.cookie = cookie;
+    }
+
+    udp6_send(&m, sizeof(m), saddr, sport, dport);
+}
@@ -92,6 +92,7 @@ again: // label here to catch filename=/path/to/new/directory/
         }
         strcat(netfile.filename, TMP_SUFFIX);
         netfile.needs_rename = true;
+        netchunk_stage_reset();
         netfile.fd = open(netfile.filename, O_WRONLY|O_CREAT|O_TRUNC);
         netfile.filename[len] = '\0';
         if (netfile.fd < 0 && errno == ENOENT) {
@@ -203,6 +204,7 @@ void netfile_write(const char* data, size_t len, uint32_t cookie, uint32_t arg,
             udp6_send(&m, sizeof(m), saddr, sport, dport);
             return;
         }
+        netchunk_stage(data, len);
         netfile.blocknum++;
         netfile.cookie = cookie;
     }
@@ -221,6 +223,7 @@ void netfile_close(uint32_t cookie,
     if (netfile.fd < 0) {
         printf("netsvc: close, but no open file\n");
     } else {
+        netchunk_stage_flush();
         if (netfile.needs_rename) {
             char src[PATH_MAX];
             strlcpy(src, netfile.filename, sizeof(netfile.filename));
@@ -86,80 +86,96 @@ static void run_server(const char* progname, const char* bin, mx_handle_t h) {
 
 static const char* nodename = "magenta";
 
-void udp6_recv(void* data, size_t len,
-               const ip6_addr_t* daddr, uint16_t dport,
-               const ip6_addr_t* saddr, uint16_t sport) {
+static void netboot_recv(void* data, size_t len,
+                         const ip6_addr_t* daddr, uint16_t dport,
+                         const ip6_addr_t* saddr, uint16_t sport) {
 
     bool mcast = (memcmp(daddr, &ip6_ll_all_nodes, sizeof(ip6_addr_t)) == 0);
 
-    if (dport == NB_SERVER_PORT) {
-        nbmsg* msg = data;
-        if ((len < (sizeof(nbmsg) + 1)) ||
-            (msg->magic != NB_MAGIC)) {
-            return;
-        }
-        // null terminate the payload
-        len -= sizeof(nbmsg);
-        msg->data[len - 1] = 0;
-
-        switch (msg->cmd) {
-        case NB_QUERY:
-            if (strcmp((char*)msg->data, "*") &&
-                strcmp((char*)msg->data, nodename)) {
-                break;
-            }
-            size_t dlen = strlen(nodename) + 1;
-            char buf[1024 + sizeof(nbmsg)];
-            if ((dlen + sizeof(nbmsg)) > sizeof(buf)) {
-                return;
-            }
-            msg->cmd = NB_ACK;
-            memcpy(buf, msg, sizeof(nbmsg));
-            memcpy(buf + sizeof(nbmsg), nodename, dlen);
-            udp6_send(buf, sizeof(nbmsg) + dlen, saddr, sport, dport);
-            break;
-        case NB_SHELL_CMD:
-            if (!mcast) {
-                run_command((char*) msg->data);
-                return;
-            }
-            break;
-        case NB_OPEN:
-            netfile_open((char*)msg->data, msg->cookie, msg->arg, saddr, sport, dport);
-            break;
-        case NB_READ:
-            netfile_read(msg->cookie, msg->arg, saddr, sport, dport);
-            break;
-        case NB_WRITE:
-            len--; // NB NUL-terminator is not part of the data
-            netfile_write((char*)msg->data, len, msg->cookie, msg->arg, saddr, sport, dport);
-            break;
-        case NB_CLOSE:
-            netfile_close(msg->cookie, saddr, sport, dport);
-            break;
-        }
+    nbmsg* msg = data;
+    if ((len < (sizeof(nbmsg) + 1)) ||
+        (msg->magic != NB_MAGIC)) {
         return;
     }
-
-    if (dport == DEBUGLOG_ACK_PORT) {
-        if ((len != 8) || mcast) {
-            return;
+    // null terminate the payload
+    len -= sizeof(nbmsg);
+    msg->data[len - 1] = 0;
+
+    switch (msg->cmd) {
+    case NB_QUERY:
+        if (strcmp((char*)msg->data, "*") &&
+            strcmp((char*)msg->data, nodename)) {
+            break;
         }
-        logpacket_t* pkt = data;
-        if ((pkt->magic != 0xaeae1123) || (pkt->seqno != seqno)) {
+        size_t dlen = strlen(nodename) + 1;
+        char buf[1024 + sizeof(nbmsg)];
+        if ((dlen + sizeof(nbmsg)) > sizeof(buf)) {
             return;
         }
-        if (pending) {
-            seqno++;
-            pending = 0;
-            // ensure we stop polling
-            netifc_set_timer(0);
+        msg->cmd = NB_ACK;
+        memcpy(buf, msg, sizeof(nbmsg));
+        memcpy(buf + sizeof(nbmsg), nodename, dlen);
+        udp6_send(buf, sizeof(nbmsg) + dlen, saddr, sport, dport);
+        break;
+    case NB_SHELL_CMD:
+        if (!mcast) {
+            run_command((char*) msg->data);
+            return;
         }
+        break;
+    case NB_OPEN:
+        netfile_open((char*)msg->data, msg->cookie, msg->arg, saddr, sport, dport);
+        break;
+    case NB_READ:
+        netfile_read(msg->cookie, msg->arg, saddr, sport, dport);
+        break;
+    case NB_WRITE:
+        len--; // NB NUL-terminator is not part of the data
+        netfile_write((char*)msg->data, len, msg->cookie, msg->arg, saddr, sport, dport);
+        break;
+    case NB_CLOSE:
+        netfile_close(msg->cookie, saddr, sport, dport);
+        break;
+    case NB_CHUNK_QUERY:
+        len--; // NB NUL-terminator is not part of the data
+        netchunk_query(msg->data, len, msg->cookie, msg->arg, saddr, sport, dport);
+        break;
+    case NB_CHUNK_WRITE:
+        len--; // NB NUL-terminator is not part of the data
+        netchunk_write(msg->data, len, msg->cookie, msg->arg, saddr, sport, dport);
+        break;
+    }
+}
+
+static void debuglog_recv(void* data, size_t len,
+                          const ip6_addr_t* daddr, uint16_t dport,
+                          const ip6_addr_t* saddr, uint16_t sport) {
+
+    bool mcast = (memcmp(daddr, &ip6_ll_all_nodes, sizeof(ip6_addr_t)) == 0);
+
+    if ((len != 8) || mcast) {
+        return;
+    }
+    logpacket_t* pkt = data;
+    if ((pkt->magic != 0xaeae1123) || (pkt->seqno != seqno)) {
+        return;
+    }
+    if (pending) {
+        seqno++;
+        pending = 0;
+        // ensure we stop polling
+        netifc_set_timer(0);
     }
 }
 
-void netifc_recv(void* data, size_t len) {
-    eth_recv(data, len);
+// fallback for UDP ports with no handler bound
+void udp6_recv(void* data, size_t len,
+               const ip6_addr_t* daddr, uint16_t dport,
+               const ip6_addr_t* saddr, uint16_t sport) {
+}
+
+void netifc_recv(void* data, size_t len, uint32_t flags) {
+    eth_recv(data, len, flags);
 }
 
 int main(int argc, char** argv) {
@@ -173,6 +189,9 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    udp6_bind(NB_SERVER_PORT, netboot_recv);
+    udp6_bind(DEBUGLOG_ACK_PORT, debuglog_recv);
+
     for (;;) {
         if (netifc_open() != 0) {
             printf("netsvc: fatal error initializing network\n");
@@ -41,3 +41,18 @@ void netfile_write(const char* data, size_t len, uint32_t cookie, uint32_t arg,
 
 void netfile_close(uint32_t cookie,
                    const ip6_addr_t* saddr, uint16_t sport, uint16_t dport);
+
+// Content-addressed chunk cache (netchunk.c): lets repeat pushes of
+// mostly-unchanged files skip chunks the device has already seen.
+void netchunk_query(const uint8_t* digests, size_t len, uint32_t cookie,
+                    uint32_t arg, const ip6_addr_t* saddr,
+                    uint16_t sport, uint16_t dport);
+
+void netchunk_write(const uint8_t* digest, size_t len, uint32_t cookie,
+                    uint32_t arg, const ip6_addr_t* saddr,
+                    uint16_t sport, uint16_t dport);
+
+// Feed bytes written via netfile_write into the cache.
+void netchunk_stage_reset(void);
+void netchunk_stage(const void* data, size_t len);
+void netchunk_stage_flush(void);
@@ -13,9 +13,10 @@ MODULE_TYPE := userapp
 MODULE_SRCS += \
     $(LOCAL_DIR)/netsvc.c \
     $(LOCAL_DIR)/netfile.c \
+    $(LOCAL_DIR)/netchunk.c \
     $(LOCAL_DIR)/device_id.c
 
-MODULE_STATIC_LIBS := system/ulib/inet6
+MODULE_STATIC_LIBS := system/ulib/inet6 third_party/ulib/cryptolib
 
 MODULE_LIBS := system/ulib/mxio system/ulib/launchpad system/ulib/magenta system/ulib/c
 
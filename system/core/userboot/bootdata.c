@@ -15,6 +15,7 @@
 #pragma GCC visibility pop
 
 mx_handle_t bootdata_get_bootfs(mx_handle_t log, mx_handle_t vmar_self,
+                                mx_handle_t proc_self,
                                 mx_handle_t bootdata_vmo) {
     size_t off = 0;
     for (;;) {
@@ -40,9 +41,10 @@ mx_handle_t bootdata_get_bootfs(mx_handle_t log, mx_handle_t vmar_self,
         case BOOTDATA_BOOTFS_BOOT:;
             const char* errmsg;
             mx_handle_t bootfs_vmo;
-            status = decompress_bootdata(vmar_self, bootdata_vmo, off,
-                                         bootdata.length + sizeof(bootdata),
-                                         &bootfs_vmo, &errmsg);
+            status = decompress_bootdata_parallel(proc_self, vmar_self,
+                                                  bootdata_vmo, off,
+                                                  bootdata.length + sizeof(bootdata),
+                                                  &bootfs_vmo, &errmsg);
             check(log, status, errmsg);
 
             // Signal that we've already processed this one.
@@ -54,6 +54,9 @@ MODULE_SRCS += system/ulib/elfload/elf-load.c
 
 MODULE_HEADER_DEPS += system/ulib/bootdata
 MODULE_SRCS += system/ulib/bootdata/decompress.c
+# Only userboot gets the parallel decompressor: it relies on raw mxr
+# threads, which would break safe-stack in normal (musl-hosted) callers.
+MODULE_COMPILEFLAGS += -DBOOTDATA_DECOMPRESS_PARALLEL
 
 MODULE_HEADER_DEPS += third_party/ulib/lz4
 MODULE_SRCS += third_party/ulib/lz4/lz4.c
@@ -193,7 +193,7 @@ static noreturn void bootstrap(mx_handle_t log, mx_handle_t bootstrap_pipe) {
 
     // Hang on to our own process handle.  If we closed it, our process
     // would be killed.  Exiting will clean it up.
-    __UNUSED const mx_handle_t proc_self = *proc_handle_loc;
+    const mx_handle_t proc_self = *proc_handle_loc;
     const mx_handle_t vmar_self = *vmar_root_handle_loc;
 
     // Hang on to the resource root handle.
@@ -206,7 +206,8 @@ static noreturn void bootstrap(mx_handle_t log, mx_handle_t bootstrap_pipe) {
     // Locate the first bootfs bootdata section and decompress it.
     // We need it to load devmgr and libc from.
     // Later bootfs sections will be processed by devmgr.
-    mx_handle_t bootfs_vmo = bootdata_get_bootfs(log, vmar_self, bootdata_vmo);
+    mx_handle_t bootfs_vmo = bootdata_get_bootfs(log, vmar_self, proc_self,
+                                                 bootdata_vmo);
 
     // Pass the decompressed bootfs VMO on.
     handles[nhandles + EXTRA_HANDLE_BOOTFS] = bootfs_vmo;
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -50,8 +51,25 @@ static bool run(std::vector<std::string>& in_paths, const char* out_path,
         out_file.write((const char *)&header, sizeof(header));
         out_file.write((const char *)&header, sizeof(header));
 
-        // write the nodes
-        root.serialize(out_file);
+        // write the nodes, collecting an index entry per list child
+        std::vector<mdi_index_entry_t> index;
+        root.serialize(out_file, 0, index);
+
+        // sorted by (list_offset, id, node_offset) for binary search;
+        // the node_offset tiebreak keeps duplicate ids in file order
+        std::sort(index.begin(), index.end(),
+                  [](const mdi_index_entry_t& a, const mdi_index_entry_t& b) {
+            if (a.list_offset != b.list_offset) return a.list_offset < b.list_offset;
+            if (a.id != b.id) return a.id < b.id;
+            return a.node_offset < b.node_offset;
+        });
+
+        mdi_index_header_t index_header;
+        index_header.magic = MDI_INDEX_MAGIC;
+        index_header.entry_count = index.size();
+        out_file.write((const char *)&index_header, sizeof(index_header));
+        out_file.write((const char *)index.data(),
+                       index.size() * sizeof(mdi_index_entry_t));
 
         size_t total_len = out_file.tellp();
 
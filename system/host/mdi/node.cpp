@@ -137,7 +137,8 @@ void Node::compute_node_length() {
     }
 }
 
-bool Node::serialize(std::ofstream& out_file) {
+bool Node::serialize(std::ofstream& out_file, uint32_t offset,
+                     std::vector<mdi_index_entry_t>& index) {
     mdi_node_t node;
     static_assert(sizeof(node) == MDI_ALIGN(sizeof(node)), "");
 
@@ -186,9 +187,21 @@ bool Node::serialize(std::ofstream& out_file) {
         // may need to pad following string value
         pad_length = strlen;
     } else if (type == MDI_LIST) {
-        // children are recursively written following node
+        // children are recursively written following node, each one
+        // contributing an index entry scoped to this list
+        uint32_t child_offset = offset + sizeof(node);
+        uint32_t following = child_count;
         for (auto iter = children.begin(); iter != children.end(); iter++) {
-            iter->serialize(out_file);
+            following--;
+            mdi_index_entry_t entry;
+            entry.id = iter->get_id();
+            entry.list_offset = offset;
+            entry.node_offset = child_offset;
+            entry.following = following;
+            index.push_back(entry);
+
+            iter->serialize(out_file, child_offset, index);
+            child_offset += iter->serialized_length;
         }
     } else if (type == MDI_ARRAY) {
         // array element values are written immediately after the mdi_node_t
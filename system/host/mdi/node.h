@@ -38,7 +38,11 @@ public:
     }
 
     void compute_node_length();
-    bool serialize(std::ofstream& out_file);
+    // serializes the node subtree, appending an index entry for every
+    // child of every list node; offset is the node's position relative
+    // to the root node
+    bool serialize(std::ofstream& out_file, uint32_t offset,
+                   std::vector<mdi_index_entry_t>& index);
 
 private:
     void print_indent(int depth);
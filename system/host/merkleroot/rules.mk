@@ -29,7 +29,9 @@ MODULE_DEFINES += USE_LIBCRYPTO=1
 MODULE_HOST_LIBS := -lcrypto
 else
 MODULE_COMPILEFLAGS += -Ithird_party/ulib/cryptolib/include
-MODULE_SRCS += third_party/ulib/cryptolib/cryptolib.c
+MODULE_SRCS += \
+	system/ulib/merkle/sha256.cpp \
+	third_party/ulib/cryptolib/cryptolib.c
 endif
 
 include make/module.mk
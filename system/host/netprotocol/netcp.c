@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <stdint.h>
 
+#include <lib/crypto/cryptolib.h>
 #include <magenta/boot/netboot.h>
 
 static const char* appname;
@@ -150,35 +151,95 @@ again:
         return -1;
     }
 
-    int n = 0;
-    int len = 0;
+    // Push the file NB_CHUNK_SIZE chunks at a time, asking the device
+    // which chunks it already has cached from previous pushes and only
+    // sending the ones it doesn't.  If the device doesn't answer chunk
+    // queries (older netsvc), fall back to sending everything raw.
+    static uint8_t chunkbuf[NB_QUERY_MAX_DIGESTS * NB_CHUNK_SIZE];
+    uint8_t digests[NB_QUERY_MAX_DIGESTS * NB_DIGEST_SIZE];
+    uint8_t have[NB_QUERY_MAX_DIGESTS];
+    bool chunked = true;
+
+    int n = 0;       // bytes of the file pushed
+    int sent = 0;    // bytes of those that went over the wire
+    int reused = 0;  // chunks replayed from the device's cache
     int blocknum = 0;
     for (;;) {
-        memset(&out, 0, sizeof(out));
-        out.hdr.cmd = NB_WRITE;
-        out.hdr.arg = blocknum;
-
-        len = read(fd, out.data, sizeof(out.data));
-        if (len < 0) {
+        ssize_t batch = read(fd, chunkbuf, sizeof(chunkbuf));
+        if (batch < 0) {
             fprintf(stderr, "%s: error reading block %d (%d)\n",
                     appname, blocknum, errno);
             close(fd);
-            return r;
+            return -1;
         }
-        if (len == 0) {
+        if (batch == 0) {
             break; // EOF
         }
+        int nchunks = (batch + NB_CHUNK_SIZE - 1) / NB_CHUNK_SIZE;
 
-        r = netboot_txn(s, &in, &out, sizeof(out.hdr) + len + 1);
-        if (r < 0) {
-            fprintf(stderr, "%s: error writing block %d (%d)\n",
-                    appname, blocknum, errno);
-            close(fd);
-            return r;
+        if (chunked) {
+            for (int i = 0; i < nchunks; i++) {
+                size_t clen = MIN(NB_CHUNK_SIZE, batch - i * NB_CHUNK_SIZE);
+                clSHA256(chunkbuf + i * NB_CHUNK_SIZE, clen,
+                         digests + i * NB_DIGEST_SIZE);
+            }
+            memset(&out, 0, sizeof(out));
+            out.hdr.cmd = NB_CHUNK_QUERY;
+            out.hdr.arg = nchunks;
+            memcpy(out.data, digests, nchunks * NB_DIGEST_SIZE);
+            r = netboot_txn(s, &in, &out,
+                            sizeof(out.hdr) + nchunks * NB_DIGEST_SIZE + 1);
+            if ((r < 0) || (r < (int)(sizeof(in.hdr) + nchunks))) {
+                chunked = false;
+            } else {
+                memcpy(have, in.data, nchunks);
+            }
         }
 
-        blocknum++;
-        n += len;
+        for (int i = 0; i < nchunks; i++) {
+            const uint8_t* chunk = chunkbuf + i * NB_CHUNK_SIZE;
+            size_t clen = MIN(NB_CHUNK_SIZE, batch - i * NB_CHUNK_SIZE);
+
+            if (chunked && have[i]) {
+                memset(&out, 0, sizeof(out));
+                out.hdr.cmd = NB_CHUNK_WRITE;
+                out.hdr.arg = blocknum;
+                memcpy(out.data, digests + i * NB_DIGEST_SIZE, NB_DIGEST_SIZE);
+                r = netboot_txn(s, &in, &out,
+                                sizeof(out.hdr) + NB_DIGEST_SIZE + 1);
+                if (r >= 0) {
+                    blocknum++;
+                    reused++;
+                    n += clen;
+                    continue;
+                }
+                if (errno != ENOENT) {
+                    fprintf(stderr, "%s: error writing chunk at block %d (%d)\n",
+                            appname, blocknum, errno);
+                    close(fd);
+                    return r;
+                }
+                // Chunk fell out of the device cache; send it raw.
+            }
+
+            for (size_t off = 0; off < clen; off += sizeof(out.data)) {
+                size_t len = MIN(sizeof(out.data), clen - off);
+                memset(&out, 0, sizeof(out));
+                out.hdr.cmd = NB_WRITE;
+                out.hdr.arg = blocknum;
+                memcpy(out.data, chunk + off, len);
+                r = netboot_txn(s, &in, &out, sizeof(out.hdr) + len + 1);
+                if (r < 0) {
+                    fprintf(stderr, "%s: error writing block %d (%d)\n",
+                            appname, blocknum, errno);
+                    close(fd);
+                    return r;
+                }
+                blocknum++;
+                n += len;
+                sent += len;
+            }
+        }
     }
 
     memset(&out, 0, sizeof(out));
@@ -197,7 +258,12 @@ again:
         return -1;
     }
 
-    fprintf(stderr, "wrote %d bytes\n", n);
+    if (reused) {
+        fprintf(stderr, "wrote %d bytes (%d sent, %d chunks reused)\n",
+                n, sent, reused);
+    } else {
+        fprintf(stderr, "wrote %d bytes\n", n);
+    }
 
     return 0;
 }
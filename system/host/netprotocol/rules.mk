@@ -20,6 +20,11 @@ MODULE_TYPE := hostapp
 
 MODULE_SRCS += $(LOCAL_DIR)/netcp.c $(LOCAL_DIR)/netprotocol.c
 
+# cryptolib is a single portable source file; compile it in directly for
+# the sha256 chunk digests rather than teaching host modules about libs.
+MODULE_SRCS += third_party/ulib/cryptolib/cryptolib.c
+MODULE_COMPILEFLAGS += -Ithird_party/ulib/cryptolib/include
+
 MODULE_NAME := netcp
 
 include make/module.mk
@@ -70,6 +70,12 @@
 // Content: a uint64_t physical address of the table
 #define BOOTDATA_EFI_SYSTEM_TABLE (0x53494645) // EFIS
 
+// Boot timeline records, one item per boot stage (bootloader, kernel,
+// devmgr).  The "extra" field is unused and set to 0.
+// Content: bootdata_boot_timeline_t followed by
+// bootdata_boot_timeline_entry_t[entry_count]
+#define BOOTDATA_BOOT_TIMELINE    (0x454e4c54) // TLNE
+
 #define BOOTDATA_IGNORE           (0x50494b53) // SKIP
 
 #ifndef ASSEMBLY
@@ -111,6 +117,21 @@ typedef struct {
     uint64_t reserved;
 } bootdata_kernel_t;
 
+#define BOOTDATA_TIMELINE_NAME_LEN 16
+
+typedef struct {
+    // Tick rate for the entries that follow, or 0 when the entries use
+    // the same timebase as mx_ticks_get().
+    uint64_t ticks_per_second;
+    uint32_t entry_count;
+    uint32_t reserved;
+} bootdata_boot_timeline_t;
+
+typedef struct {
+    uint64_t ticks;
+    char name[BOOTDATA_TIMELINE_NAME_LEN];
+} bootdata_boot_timeline_entry_t;
+
 __END_CDECLS;
 #endif
 
@@ -29,6 +29,8 @@
 #define NB_WRITE              9 // arg=blocknum, data=data
 #define NB_CLOSE             10 // arg=0
 #define NB_LAST_DATA         11  // arg=blocknum, data=data
+#define NB_CHUNK_QUERY       12 // arg=count, data=count digests; NB_ACK data=count presence bytes
+#define NB_CHUNK_WRITE       13 // arg=blocknum, data=digest of cached chunk to write
 
 #define NB_ACK                0 // arg=0 or -err, NB_READ: data=data
 #define NB_FILE_RECEIVED      0x70000001 // arg=size
@@ -45,6 +47,17 @@
 #define NB_VERSION_1_1  0x0001010
 #define NB_VERSION_CURRENT NB_VERSION_1_1
 
+// Content-addressed file transfer: files are divided into NB_CHUNK_SIZE
+// chunks identified by their sha256 digest.  A client asks which chunks
+// the device already holds in its cache (NB_CHUNK_QUERY) and has those
+// written into the open file straight from the cache (NB_CHUNK_WRITE,
+// sequenced by blocknum like NB_WRITE; NB_ACK arg=-ENOENT means the
+// chunk fell out of the cache and must be sent raw).  Routine pushes of
+// mostly-unchanged images then move only the chunks that differ.
+#define NB_CHUNK_SIZE        8192
+#define NB_DIGEST_SIZE       32 // sha256
+#define NB_QUERY_MAX_DIGESTS 31 // digests + trailing NUL fit a 1024 byte payload
+
 typedef struct nbmsg_t {
     uint32_t magic;
     uint32_t cookie;
@@ -42,6 +42,10 @@
 // otherwise, closing the client fifo is sufficient to shut down the server.
 #define IOCTL_BLOCK_FIFO_CLOSE \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 10)
+// Enable or disable scheduling (elevator ordering and adjacent-LBA merging)
+// of FIFO requests before they reach the underlying driver.  On by default.
+#define IOCTL_BLOCK_SET_SCHEDULING \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 11)
 
 // Block Core ioctls (specific to each block device):
 
@@ -96,6 +100,9 @@ IOCTL_WRAPPER_IN(ioctl_block_free_txn, IOCTL_BLOCK_FREE_TXN, txnid_t);
 // ssize_t ioctl_block_fifo_close(int fd);
 IOCTL_WRAPPER(ioctl_block_fifo_close, IOCTL_BLOCK_FIFO_CLOSE);
 
+// ssize_t ioctl_block_set_scheduling(int fd, const uint32_t* enabled);
+IOCTL_WRAPPER_IN(ioctl_block_set_scheduling, IOCTL_BLOCK_SET_SCHEDULING, uint32_t);
+
 // Multiple Block IO operations may be sent at once before a response is actually sent back.
 // Block IO ops may be sent concurrently to different vmoids, and they also may be sent
 // to different transactions at any point in time. Up to MAX_TXN_COUNT transactions may
@@ -144,7 +151,7 @@ IOCTL_WRAPPER(ioctl_block_fifo_close, IOCTL_BLOCK_FIFO_CLOSE);
 
 #define BLOCKIO_READ      0x0001 // Reads from the Block device into the VMO
 #define BLOCKIO_WRITE     0x0002 // Writes to the Block device from the VMO
-#define BLOCKIO_SYNC      0x0003 // Unimplemented
+#define BLOCKIO_SYNC      0x0003 // Barrier; waits for prior ops, then flushes the write cache
 #define BLOCKIO_CLOSE_VMO 0x0004 // Detaches the VMO from the block device; closes the handle to it.
 #define BLOCKIO_OP_MASK   0x00FF
 
@@ -44,11 +44,50 @@ typedef struct mx_display_info {
 #define IOCTL_DISPLAY_SET_FULLSCREEN \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DISPLAY, 4)
 
+// Import a VMO as a scanout image.  The driver maps the VMO's pages into
+// the display aperture; the returned id can be passed to IOCTL_DISPLAY_FLIP.
+// Not all display drivers support scanning out client buffers
+// (ERR_NOT_SUPPORTED).
+//   in: mx_handle_t (vmo)
+//   out: ioctl_display_image_t
+#define IOCTL_DISPLAY_IMPORT_VMO \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_DISPLAY, 5)
+
+// Release a previously imported scanout image.  The image must not be
+// the current scanout (flip away from it first).
+//   in: uint64_t (image id)
+//   out: none
+#define IOCTL_DISPLAY_RELEASE_VMO \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DISPLAY, 6)
+
+// Scan out an imported image starting at the next vertical blank, without
+// copying.  Id 0 is the default framebuffer.  The flip is latched by the
+// hardware; it does not block until the vertical blank occurs.
+//   in: uint64_t (image id)
+//   out: none
+#define IOCTL_DISPLAY_FLIP \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_DISPLAY, 7)
+
+// Get an event handle that is signaled with MX_USER_SIGNAL_0 at each
+// vertical blank.  The caller clears the signal after waiting; the driver
+// only ever sets it.
+//   in: none
+//   out: mx_handle_t (event)
+#define IOCTL_DISPLAY_GET_VSYNC_EVENT \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_DISPLAY, 8)
+
 typedef struct {
     mx_handle_t vmo;
     mx_display_info_t info;
 } ioctl_display_get_fb_t;
 
+typedef struct {
+    // id to pass to IOCTL_DISPLAY_FLIP/IOCTL_DISPLAY_RELEASE_VMO
+    uint64_t id;
+    // bytes of the VMO mapped into the display aperture
+    uint64_t length;
+} ioctl_display_image_t;
+
 typedef struct {
     uint32_t x;
     uint32_t y;
@@ -67,3 +106,15 @@ IOCTL_WRAPPER_IN(ioctl_display_flush_fb_region, IOCTL_DISPLAY_FLUSH_FB_REGION, i
 
 // ssize_t ioctl_display_set_fullscreen(int fd, uint32_t in);
 IOCTL_WRAPPER_IN(ioctl_display_set_fullscreen, IOCTL_DISPLAY_SET_FULLSCREEN, uint32_t);
+
+// ssize_t ioctl_display_import_vmo(int fd, const mx_handle_t* in, ioctl_display_image_t* out);
+IOCTL_WRAPPER_INOUT(ioctl_display_import_vmo, IOCTL_DISPLAY_IMPORT_VMO, mx_handle_t, ioctl_display_image_t);
+
+// ssize_t ioctl_display_release_vmo(int fd, const uint64_t* in);
+IOCTL_WRAPPER_IN(ioctl_display_release_vmo, IOCTL_DISPLAY_RELEASE_VMO, uint64_t);
+
+// ssize_t ioctl_display_flip(int fd, const uint64_t* in);
+IOCTL_WRAPPER_IN(ioctl_display_flip, IOCTL_DISPLAY_FLIP, uint64_t);
+
+// ssize_t ioctl_display_get_vsync_event(int fd, mx_handle_t* out);
+IOCTL_WRAPPER_OUT(ioctl_display_get_vsync_event, IOCTL_DISPLAY_GET_VSYNC_EVENT, mx_handle_t);
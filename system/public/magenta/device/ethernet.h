@@ -25,7 +25,9 @@ typedef struct eth_info_t {
     uint32_t reserved[12];
 } eth_info_t;
 
-#define ETH_FEATURE_WLAN 1
+#define ETH_FEATURE_WLAN    1
+#define ETH_FEATURE_RX_CSUM 2  // device validates L4 checksum on receive
+#define ETH_FEATURE_TX_CSUM 4  // device computes L4 checksum on transmit
 
 // Get the fifos to submit tx and rx operations
 //   in: none
@@ -62,6 +64,27 @@ typedef struct eth_fifos_t {
 #define IOCTL_ETHERNET_TX_LISTEN_STOP \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_ETH, 6)
 
+// Install a receive filter for this client.  Packets that do not match
+// are dropped in the driver, before being copied into the io buffer,
+// so capture clients do not pay for traffic they do not want.
+// Fields set to zero are wildcards; a filter with all fields zero
+// removes filtering.
+//   in: eth_filter_t
+//  out: none
+#define IOCTL_ETHERNET_SET_FILTER \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_ETH, 7)
+
+typedef struct eth_filter_t {
+    // match ethertype (host order), 0 = any
+    uint16_t ethertype;
+    // match IPv4 protocol / IPv6 next header, 0 = any
+    uint8_t ip_proto;
+    uint8_t pad;
+    // match TCP/UDP source or destination port (host order), 0 = any
+    uint16_t port;
+    uint16_t pad2;
+} eth_filter_t;
+
 
 // Operation
 //
@@ -92,6 +115,7 @@ typedef struct eth_fifos_t {
 #define ETH_FIFO_TX_OK   (1u)   // packet transmitted okay
 #define ETH_FIFO_INVALID (2u)   // offset+length not within io_vmo bounds
 #define ETH_FIFO_RX_TX   (4u)   // received our own tx packet (when TX_LISTEN)
+#define ETH_FIFO_RX_CSUM (8u)   // hardware validated the L4 checksum
 
 typedef struct eth_fifo_entry {
     // offset from start of io_vmo to packet data
@@ -124,3 +148,6 @@ IOCTL_WRAPPER(ioctl_ethernet_tx_listen_start, IOCTL_ETHERNET_TX_LISTEN_START);
 
 // ssize_t ioctl_ethernet_tx_listen_stop(int fd);
 IOCTL_WRAPPER(ioctl_ethernet_tx_listen_stop, IOCTL_ETHERNET_TX_LISTEN_STOP);
+
+// ssize_t ioctl_ethernet_set_filter(int fd, eth_filter_t* filter);
+IOCTL_WRAPPER_IN(ioctl_ethernet_set_filter, IOCTL_ETHERNET_SET_FILTER, eth_filter_t);
@@ -26,6 +26,10 @@
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 7)
 #define IOCTL_INPUT_SET_REPORT \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 8)
+#define IOCTL_INPUT_SET_READ_POLICY \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 9)
+#define IOCTL_INPUT_GET_REPORT_TIMES \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INPUT, 10)
 
 enum {
     INPUT_PROTO_NONE = 0,
@@ -59,6 +63,21 @@ typedef struct input_set_report {
     uint8_t data[];
 } input_set_report_t;
 
+// Controls when an input device signals readable.  By default every report
+// wakes the reader; high-rate devices can ask to be woken only once per batch.
+// Reads always drain as many complete reports as fit in the caller's buffer,
+// so one wakeup delivers the whole batch.
+typedef struct input_read_policy {
+    // do not signal readable until this many reports are pending
+    // (0 or 1 signals on every report, the default)
+    uint32_t min_reports;
+    uint32_t padding;
+    // ...unless the oldest pending report is at least this old, in
+    // nanoseconds (0 = no bound).  This is evaluated as new reports arrive,
+    // so it only bounds latency for devices that report at a steady rate.
+    uint64_t max_latency;
+} input_read_policy_t;
+
 typedef struct boot_kbd_report {
     uint8_t modifier;
     uint8_t reserved;
@@ -103,3 +122,12 @@ IOCTL_WRAPPER_IN_VAROUT(ioctl_input_get_report, IOCTL_INPUT_GET_REPORT,
 
 // ssize_t ioctl_input_set_report(int fd, const input_set_report_t* in, size_t in_len);
 IOCTL_WRAPPER_VARIN(ioctl_input_set_report, IOCTL_INPUT_SET_REPORT, input_set_report_t);
+
+// ssize_t ioctl_input_set_read_policy(int fd, const input_read_policy_t* in);
+IOCTL_WRAPPER_IN(ioctl_input_set_read_policy, IOCTL_INPUT_SET_READ_POLICY, input_read_policy_t);
+
+// Returns the arrival times (MX_CLOCK_MONOTONIC, in nanoseconds) of the
+// reports delivered by the most recent read on this fd, in the order they
+// were returned.
+// ssize_t ioctl_input_get_report_times(int fd, uint64_t* out, size_t out_len);
+IOCTL_WRAPPER_VAROUT(ioctl_input_get_report_times, IOCTL_INPUT_GET_REPORT_TIMES, uint64_t);
@@ -218,4 +218,32 @@ IOCTL_WRAPPER(ioctl_ipt_cpu_mode_stop, IOCTL_IPT_CPU_MODE_STOP);
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_IPT, 13)
 IOCTL_WRAPPER(ioctl_ipt_cpu_mode_free, IOCTL_IPT_CPU_MODE_FREE);
 
+typedef struct {
+    // trace buffer descriptor (the cpu when tracing cpus)
+    uint32_t descriptor;
+    // #bytes of the most recent trace data wanted, or 0 for the entire
+    // buffer; clipped to the size of the trace buffer
+    uint32_t size;
+} ioctl_ipt_snapshot_req_t;
+
+typedef struct {
+    // for IOCTL_KIND_GET_HANDLE first element must be the handle
+    mx_handle_t vmo;
+    // #bytes of trace data written to |vmo|, ending at the write head
+    uint32_t size;
+} ioctl_ipt_snapshot_rsp_t;
+
+// snapshot the most recent trace data of one circular trace buffer
+// The buffer's cpu is paused just long enough to freeze the write head and
+// copy the data out; collection on other cpus is undisturbed and collection
+// on this cpu resumes afterwards. Only valid while tracing is active.
+// N.B. If tracing hasn't wrapped yet the leading bytes are zero padding;
+// decoders skip padding.
+// Input: ioctl_ipt_snapshot_req_t
+// Output: ioctl_ipt_snapshot_rsp_t
+#define IOCTL_IPT_SNAPSHOT \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_IPT, 14)
+IOCTL_WRAPPER_INOUT(ioctl_ipt_snapshot, IOCTL_IPT_SNAPSHOT,
+                    ioctl_ipt_snapshot_req_t, ioctl_ipt_snapshot_rsp_t);
+
 __END_CDECLS
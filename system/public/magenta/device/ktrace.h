@@ -6,6 +6,7 @@
 
 #include <string.h>
 
+#include <magenta/ktrace.h>
 #include <magenta/syscalls.h>
 #include <magenta/types.h>
 
@@ -22,7 +23,21 @@
 #define IOCTL_KTRACE_ADD_PROBE \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_KTRACE, 2)
 
+// return the number of per-cpu trace streams
+// reply: uint32_t count
+#define IOCTL_KTRACE_GET_CPU_COUNT \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_KTRACE, 3)
+
+// return where one cpu's stream lands in the trace data
+// input: uint32_t cpu
+// reply: ktrace_cpu_stream_t
+#define IOCTL_KTRACE_GET_CPU_STREAM \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_KTRACE, 4)
+
 IOCTL_WRAPPER_OUT(ioctl_ktrace_get_handle, IOCTL_KTRACE_GET_HANDLE, mx_handle_t);
+IOCTL_WRAPPER_OUT(ioctl_ktrace_get_cpu_count, IOCTL_KTRACE_GET_CPU_COUNT, uint32_t);
+IOCTL_WRAPPER_INOUT(ioctl_ktrace_get_cpu_stream, IOCTL_KTRACE_GET_CPU_STREAM,
+                    uint32_t, ktrace_cpu_stream_t);
 
 static inline mx_status_t ioctl_ktrace_add_probe(int fd, const char* name, uint32_t* probe_id) {
     return mxio_ioctl(fd, IOCTL_KTRACE_ADD_PROBE,
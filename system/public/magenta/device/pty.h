@@ -54,6 +54,60 @@ typedef struct {
     uint32_t height;
 } pty_window_size_t;
 
+// Obtain a shared ring for bulk output (Client PTY -> Server PTY).
+//
+// Returns a VMO whose first page holds a pty_ring_hdr_t and whose
+// remaining pages are the data ring.  The client appends bytes at
+// head % size and publishes them with a release store of head; the
+// server consumes at tail, loading head with acquire ordering, and
+// retires consumed space with a release store of tail.  A kick
+// (IOCTL_PTY_OUT_RING_KICK) only signals the server that output is
+// pending, so bulk output costs one syscall per batch rather than one
+// per write().  The interactive path -- plain write(), including ^c
+// etc processing on input -- is unaffected.
+//
+//  in: none
+// out: mx_handle_t (VMO)
+#define IOCTL_PTY_GET_OUT_RING \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_PTY, 0x02)
+
+// Ring indices are C11 atomics so that the two sides, which run in
+// different processes, get the load-acquire/store-release ordering
+// described above (see mx_futex_t for the same C++ accommodation).
+#ifdef __cplusplus
+typedef uint32_t pty_ring_idx_t;
+#else
+typedef atomic_uint_least32_t pty_ring_idx_t;
+#endif
+
+typedef struct {
+    pty_ring_idx_t head; // advanced by the client (producer)
+    pty_ring_idx_t tail; // advanced by the server (consumer)
+    uint32_t size;       // data bytes following the first page; power of two
+    uint32_t reserved;
+} pty_ring_hdr_t;
+
+// Offset of the data ring within the VMO
+#define PTY_RING_DATA_OFFSET (4096u)
+
+// Flow control watermarks.  When a kick leaves at least the high
+// watermark queued, DEV_STATE_WRITABLE is deasserted on the client;
+// it is asserted again once the server has drained the ring below
+// the low watermark.
+#define PTY_RING_HIGH_WATER(size) ((size) - (size) / 4)
+#define PTY_RING_LOW_WATER(size) ((size) / 4)
+
+// Notify the server that output has been appended to the ring.
+//
+// Only data published (head advanced with a release store) before the
+// kick is guaranteed to be noticed by this kick; later appends need a
+// kick of their own unless the server is already draining.
+//
+//  in: none
+// out: none
+#define IOCTL_PTY_OUT_RING_KICK \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_PTY, 0x03)
+
 
 
 // IOCTLs allowed on the Controlling PTY
@@ -99,6 +153,8 @@ typedef struct {
 
 IOCTL_WRAPPER_IN(ioctl_pty_clr_set_feature, IOCTL_PTY_CLR_SET_FEATURE, pty_clr_set_t);
 IOCTL_WRAPPER_OUT(ioctl_pty_get_window_size, IOCTL_PTY_GET_WINDOW_SIZE, pty_window_size_t);
+IOCTL_WRAPPER_OUT(ioctl_pty_get_out_ring, IOCTL_PTY_GET_OUT_RING, mx_handle_t);
+IOCTL_WRAPPER(ioctl_pty_out_ring_kick, IOCTL_PTY_OUT_RING_KICK);
 
 IOCTL_WRAPPER_IN(ioctl_pty_make_active, IOCTL_PTY_MAKE_ACTIVE, uint32_t);
 IOCTL_WRAPPER_OUT(ioctl_pty_read_events, IOCTL_PTY_READ_EVENTS, uint32_t);
@@ -12,6 +12,12 @@
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 1)
 #define IOCTL_RAMDISK_UNLINK \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 2)
+// Acquire a handle to the VMO backing the ramdisk. Clients may map it and
+// move data in place; for bulk block-aligned transfers this avoids copying
+// through the block protocol entirely. Writes made through the mapping are
+// immediately visible to block reads and vice versa.
+#define IOCTL_RAMDISK_GET_VMO \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_RAMDISK, 3)
 
 typedef struct ramdisk_ioctl_config {
     uint64_t blk_size;
@@ -24,3 +30,6 @@ IOCTL_WRAPPER_IN(ioctl_ramdisk_config, IOCTL_RAMDISK_CONFIG, ramdisk_ioctl_confi
 
 // ssize_t ioctl_ramdisk_unlink(int fd);
 IOCTL_WRAPPER(ioctl_ramdisk_unlink, IOCTL_RAMDISK_UNLINK);
+
+// ssize_t ioctl_ramdisk_get_vmo(int fd, mx_handle_t* out);
+IOCTL_WRAPPER_OUT(ioctl_ramdisk_get_vmo, IOCTL_RAMDISK_GET_VMO, mx_handle_t);
@@ -29,12 +29,21 @@
 // Watch a directory for changes
 //   in: none
 //   out: handle to channel to get notified on.
-//        Notification messages will be a string child entry name WITHOUT a
-//        null-terminating character; the length of the string should be
-//        determined by the message length during the channel read.
+//        Notification messages are batches of one or more packed events:
+//          uint8_t event;    // bitmask of VFS_WATCH_EVT_*
+//          uint8_t len;      // length of name
+//          char name[len];   // child entry name, NOT null-terminated
+//        Events for the same name within a batch are merged into one
+//        entry with the event bits ORed together.
 #define IOCTL_VFS_WATCH_DIR \
     IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_VFS, 7)
 
+// A directory entry has been added
+#define VFS_WATCH_EVT_ADDED 0x01
+
+// Maximum size of a single watcher notification message
+#define VFS_WATCH_MSG_MAX 8192
+
 // ssize_t ioctl_vfs_mount_fs(int fd, mx_handle_t* in);
 IOCTL_WRAPPER_IN(ioctl_vfs_mount_fs, IOCTL_VFS_MOUNT_FS, mx_handle_t);
 
@@ -76,3 +85,14 @@ typedef struct blob_ioctl_config {
 
 // ssize_t ioctl_blobstore_blob_init(int fd, const blob_ioctl_config_t* in);
 IOCTL_WRAPPER_IN(ioctl_blobstore_blob_init, IOCTL_BLOBSTORE_BLOB_INIT, blob_ioctl_config_t);
+
+#define IOCTL_BLOBSTORE_DEDUP_STATS \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_VFS, 9)
+
+typedef struct blobstore_dedup_stats {
+    uint64_t pages_indexed; // Unique data pages currently in the dedup index
+    uint64_t pages_merged;  // Pages merged onto shared frames since mount
+} blobstore_dedup_stats_t;
+
+// ssize_t ioctl_blobstore_dedup_stats(int fd, blobstore_dedup_stats_t* out);
+IOCTL_WRAPPER_OUT(ioctl_blobstore_dedup_stats, IOCTL_BLOBSTORE_DEDUP_STATS, blobstore_dedup_stats_t);
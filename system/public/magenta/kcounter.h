@@ -0,0 +1,40 @@
+// Copyright 2016 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <stdint.h>
+
+__BEGIN_CDECLS
+
+// Layout of the kernel counters VMO handed to userboot as PA_VMO_KCOUNTERS.
+//
+// The VMO begins with a kcounter_vmo_header_t, followed by a table of
+// NUL-padded counter names, followed by the live per-CPU counter arena.
+// After mapping the VMO read-only, the current value of counter |i| is the
+// sum over all CPUs of the 64-bit word at
+//
+//   arena_off + (cpu * arena_percpu_stride) + (i * sizeof(uint64_t))
+//
+// The kernel updates its slots with plain stores, so individual reads may
+// observe a slot mid-update; the counters are statistics, not bookkeeping.
+// The header and name table never change after boot, so a poller can parse
+// them once and then re-read only the arena, with no syscalls at all.
+
+#define KCOUNTER_MAGIC   ((uint64_t)0x306b636e74727331)  // '0kcntrs1'
+#define KCOUNTER_VERSION ((uint64_t)1)
+
+typedef struct kcounter_vmo_header {
+    uint64_t magic;               // KCOUNTER_MAGIC
+    uint64_t version;             // KCOUNTER_VERSION
+    uint64_t num_counters;        // number of counters (and name entries)
+    uint64_t max_cpus;            // number of per-CPU slot groups in the arena
+    uint64_t name_table_off;      // byte offset of the name table
+    uint64_t name_size;           // bytes per name entry, NUL padded
+    uint64_t arena_off;           // byte offset of CPU 0's counter slots
+    uint64_t arena_percpu_stride; // bytes between consecutive CPUs' slots
+} kcounter_vmo_header_t;
+
+__END_CDECLS
@@ -10,6 +10,7 @@
 
 KTRACE_DEF(0x000,32B,VERSION,META) // version
 KTRACE_DEF(0x001,32B,TICKS_PER_MS,META) // lo32, hi32
+KTRACE_DEF(0x002,32B,CPU_STREAM,META) // cpu
 
 KTRACE_DEF(0x020,NAME,KTHREAD_NAME,META) // ktid, 0, name[]
 KTRACE_DEF(0x021,NAME,THREAD_NAME,META) // tid, pid, name[]
@@ -27,6 +28,8 @@ KTRACE_DEF(0x034,32B,PAGE_FAULT,IRQ) // virtual_address_hi, virtual_address_lo,
 
 KTRACE_DEF(0x040,32B,CONTEXT_SWITCH,SCHEDULER) // to-tid, (state<<16|cpu), from-kt, to-kt
 
+KTRACE_DEF(0x050,32B,PROF_SAMPLE,PROF) // pc_lo, pc_hi, caller_lo, caller_hi
+
 // events from 0x100 on all share the tag/tid/ts common header
 
 KTRACE_DEF(0x100,32B,OBJECT_DELETE,LIFECYCLE) // id
@@ -42,6 +45,8 @@ KTRACE_DEF(0x122,32B,PROC_EXIT,TASKS) // pid
 KTRACE_DEF(0x130,32B,CHANNEL_CREATE,IPC) // id0, id1, flags
 KTRACE_DEF(0x131,32B,CHANNEL_WRITE,IPC) // id0, bytes, handles
 KTRACE_DEF(0x132,32B,CHANNEL_READ,IPC) // id1, bytes, handles
+KTRACE_DEF(0x133,32B,MSGPKT_SEND,IPC) // idlo, idhi, channel-id, bytes
+KTRACE_DEF(0x134,32B,MSGPKT_RECV,IPC) // idlo, idhi, channel-id, bytes
 
 KTRACE_DEF(0x140,32B,PORT_WAIT,IPC) // id
 KTRACE_DEF(0x141,32B,PORT_WAIT_DONE,IPC) // id, status
@@ -57,6 +62,7 @@ KTRACE_DEF(0x151,32B,WAIT_ONE_DONE,IPC) // id, status, pending
 KTRACE_DEF(0x200,32B,IPT_START,ARCH) // MSR_PLATFORM_INFO[15:8], kernel cr3
 KTRACE_DEF(0x201,32B,IPT_STOP,ARCH)
 KTRACE_DEF(0x202,32B,IPT_PROCESS_CREATE,ARCH) // pid, cr3
+KTRACE_DEF(0x203,32B,IPT_SNAPSHOT,ARCH) // cpu, output_mask_ptrs
 #endif
 
 #undef KTRACE_DEF
@@ -46,6 +46,7 @@ __BEGIN_CDECLS
 #define KTRACE_GRP_IRQ            0x020
 #define KTRACE_GRP_PROBE          0x040
 #define KTRACE_GRP_ARCH           0x080
+#define KTRACE_GRP_PROF           0x100
 
 #define KTRACE_GRP_TO_MASK(grp)   ((grp) << 20)
 
@@ -75,6 +76,13 @@ typedef struct ktrace_rec_name {
     char name[1];
 } ktrace_rec_name_t;
 
+// location of one cpu's stream within the trace read space,
+// as reported by KTRACE_ACTION_GET_CPU_STREAM
+typedef struct ktrace_cpu_stream {
+    uint32_t offset;
+    uint32_t length;
+} ktrace_cpu_stream_t;
+
 #define KTRACE_DEF(num,type,name,group) TAG_##name = KTRACE_TAG_##type(num,KTRACE_GRP_##group),
 enum {
 #include <magenta/ktrace-def.h>
@@ -89,4 +97,7 @@ enum {
 #define KTRACE_ACTION_REWIND    3 // options ignored
 #define KTRACE_ACTION_NEW_PROBE 4 // options ignored, ptr = name
 
+#define KTRACE_ACTION_GET_CPU_COUNT  5 // returns number of per-cpu streams
+#define KTRACE_ACTION_GET_CPU_STREAM 6 // options = cpu, ptr = ktrace_cpu_stream_t
+
 __END_CDECLS
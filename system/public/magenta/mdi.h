@@ -70,4 +70,26 @@ typedef struct {
 } mdi_node_t;
 static_assert(sizeof(mdi_node_t) == 16, "");
 
+// The node tree may be followed (within the BOOTDATA_MDI item, after
+// MDI_ALIGN padding) by an index section: one mdi_index_entry_t for every
+// child of every list node, sorted by (list_offset, id, node_offset).
+// Readers binary search it to resolve mdi_find_node() queries in O(log n)
+// instead of rescanning the child list; the layout is position independent
+// (offsets relative to the root node) so a mapped image needs no fixups.
+// Images without an index section remain valid and are searched linearly.
+#define MDI_INDEX_MAGIC 0x5844494d  // MDIX
+
+typedef struct {
+    uint32_t    magic;              // MDI_INDEX_MAGIC
+    uint32_t    entry_count;        // number of mdi_index_entry_t that follow
+} mdi_index_header_t;
+
+typedef struct {
+    mdi_id_t    id;                 // id of the child node
+    uint32_t    list_offset;        // offset of the parent list node from the root node
+    uint32_t    node_offset;        // offset of the child node from the root node
+    uint32_t    following;          // number of siblings following the child in its list
+} mdi_index_entry_t;
+static_assert(sizeof(mdi_index_entry_t) == 16, "");
+
 __END_CDECLS;
@@ -10,13 +10,18 @@
 
 #pragma once
 
+#include <magenta/types.h>
+
 __BEGIN_CDECLS
 
-// mtrace_control() can operate on a range of features, for now just IPT.
-// It's an abstraction that doesn't mean much, and will likely be replaced
-// before it's useful; it's here in the interests of hackability in the
-// interim.
+// mtrace_control() can operate on a range of features, for now IPT and
+// the PMU. It's an abstraction that doesn't mean much, and will likely be
+// replaced before it's useful; it's here in the interests of hackability
+// in the interim.
 #define MTRACE_KIND_IPT 0
+#define MTRACE_KIND_PMU 1
+// Operations spanning several of the above kinds at once.
+#define MTRACE_KIND_SYNC 2
 
 // Actions for perf_control
 
@@ -35,6 +40,12 @@ __BEGIN_CDECLS
 #define MTRACE_IPT_CPU_MODE_STOP 5
 #define MTRACE_IPT_CPU_MODE_FREE 6
 
+// Pause/resume collection on one cpu (encoded in options) while tracing
+// stays active, so its buffer can be snapshotted. Pause returns the frozen
+// msr values (mx_x86_pt_regs_t).
+#define MTRACE_IPT_CPU_MODE_PAUSE 7
+#define MTRACE_IPT_CPU_MODE_RESUME 8
+
 // Encode/decode options values for mtrace_control().
 // At present we just encode the cpu number here.
 // We only support 32 cpus at the moment, the extra bit is for magic values.
@@ -45,4 +56,76 @@ __BEGIN_CDECLS
 
 #define MTRACE_IPT_OPTIONS_CPU(options) ((options) & MTRACE_IPT_OPTIONS_CPU_MASK)
 
+// Actions for MTRACE_KIND_PMU.
+// These mirror the IPT actions: set the mode, stage per-cpu configuration,
+// then alloc/start/stop/free; counter values are fetched per-cpu after
+// stopping, or for the calling thread at any time in thread mode.
+
+#define MTRACE_PMU_SET_MODE 0
+#define MTRACE_PMU_STAGE_CPU_DATA 1
+#define MTRACE_PMU_GET_CPU_DATA 2
+#define MTRACE_PMU_ALLOC 3
+#define MTRACE_PMU_START 4
+#define MTRACE_PMU_STOP 5
+#define MTRACE_PMU_FREE 6
+
+// Fetch counter totals for the calling thread (thread mode only).
+#define MTRACE_PMU_GET_THREAD_DATA 7
+
+// Bind (or with MX_HANDLE_INVALID unbind) a port to which a packet is
+// queued when a counter overflows. Only counters staged with the
+// interrupt-on-overflow bits set (IA32_PERFEVTSELx bit 20, or the PMI
+// bits of IA32_FIXED_CTR_CTRL) generate overflow interrupts. Packets
+// are coalesced: at most one is in flight at a time. The packet carries
+// the key passed here and MX_USER_SIGNAL_0.
+// arg is mx_pmu_overflow_port_t.
+#define MTRACE_PMU_SET_OVERFLOW_PORT 8
+
+#define MTRACE_PMU_OPTIONS_CPU_MASK 0x3f
+#define MTRACE_PMU_OPTIONS(cpu) (((cpu) & MTRACE_PMU_OPTIONS_CPU_MASK) + 0)
+
+#define MTRACE_PMU_OPTIONS_CPU(options) ((options) & MTRACE_PMU_OPTIONS_CPU_MASK)
+
+// Two "modes" of counting are supported, as with IPT:
+// count on each cpu, regardless of what's running on it
+#define PMU_MODE_CPUS 0
+// additionally accumulate counts per thread across context switches
+#define PMU_MODE_THREADS 1
+
+// Architectural limits of the x86 PMU regset below.
+#define MX_PMU_MAX_PROGRAMMABLE_COUNTERS 8
+#define MX_PMU_MAX_FIXED_COUNTERS 3
+
+// The PMU register set, accessed via mtrace like the IPT regset.
+// When staging, |evtsel| holds IA32_PERFEVTSELx values (0 = counter
+// unused), |fixed_ctrl| holds IA32_FIXED_CTR_CTRL, and the counter
+// slots hold initial values. When fetching, the counter slots return
+// the counter values and the control slots are echoed back.
+typedef struct {
+    uint64_t evtsel[MX_PMU_MAX_PROGRAMMABLE_COUNTERS];
+    uint64_t fixed_ctrl;
+    uint64_t counters[MX_PMU_MAX_PROGRAMMABLE_COUNTERS];
+    uint64_t fixed[MX_PMU_MAX_FIXED_COUNTERS];
+} mx_x86_pmu_regs_t;
+
+// Argument to MTRACE_PMU_SET_OVERFLOW_PORT.
+typedef struct {
+    mx_handle_t port; // handle to an IO port, or MX_HANDLE_INVALID to unbind
+    uint32_t reserved; // must be zero
+    uint64_t key; // delivered back in the packet
+} mx_pmu_overflow_port_t;
+
+// Actions for MTRACE_KIND_SYNC.
+// options is a bitmask, MTRACE_SYNC_KIND(kind), of the kinds to operate
+// on. Each named engine must already be configured (staged and, for
+// start, allocated); the engines are then started or stopped on all cpus
+// with a single cross-cpu synchronization, so their data can be
+// correlated without a skew of one engine running while the other's
+// start or stop is still propagating.
+
+#define MTRACE_SYNC_START 0
+#define MTRACE_SYNC_STOP 1
+
+#define MTRACE_SYNC_KIND(kind) (1u << (kind))
+
 __END_CDECLS
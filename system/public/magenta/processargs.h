@@ -121,6 +121,10 @@ struct mx_proc_args {
 // Used by kernel and userboot during startup
 #define PA_VMO_BOOTFS            0x1B
 
+// Handle to the read-only VMO holding the kernel event counter arena.
+// See magenta/kcounter.h for the layout.
+#define PA_VMO_KCOUNTERS         0x1C
+
 
 // --- Namespace Handles ---
 
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #define MX_HYPERVISOR_OP_GUEST_CREATE       1u
 #define MX_HYPERVISOR_OP_GUEST_ENTER        2u
 
@@ -16,3 +18,51 @@
 #define MX_HYPERVISOR_OP_GUEST_SET_ESI      5u
 #endif // __x86_64__
 
+// Provide a VMO whose first page is shared between the kernel and the VMM
+// as the vcpu state area. Takes a single mx_handle_t to the VMO.
+#define MX_HYPERVISOR_OP_GUEST_SET_STATE_AREA 6u
+
+// Set by the VMM after it has emulated an exit against the state area and
+// modified the register block; the kernel reloads the registers (and RIP)
+// from the state area before the next guest entry, then clears the flag.
+#define MX_VCPU_STATE_REGS_DIRTY            (1u << 0)
+
+#if __x86_64__
+// Layout of the vcpu state area.
+//
+// When the in-kernel exit handlers do not emulate an exit,
+// MX_HYPERVISOR_OP_GUEST_ENTER returns ERR_SHOULD_WAIT with the guest
+// registers and exit information stored here. The VMM emulates the access
+// directly against this state — no packet serialization — then sets
+// MX_VCPU_STATE_REGS_DIRTY and re-enters the guest. RSP and RFLAGS are
+// maintained by the VMCS and are not exposed.
+typedef struct mx_vcpu_state {
+    // Guest registers. Read-write for the VMM.
+    uint64_t rax;
+    uint64_t rbx;
+    uint64_t rcx;
+    uint64_t rdx;
+    uint64_t rdi;
+    uint64_t rsi;
+    uint64_t rbp;
+    uint64_t r8;
+    uint64_t r9;
+    uint64_t r10;
+    uint64_t r11;
+    uint64_t r12;
+    uint64_t r13;
+    uint64_t r14;
+    uint64_t r15;
+    uint64_t rip;
+
+    // Exit information. Read-only for the VMM; valid until the next entry.
+    uint32_t exit_reason;
+    uint32_t instruction_length;
+    uint64_t exit_qualification;
+    uint64_t guest_physical_address;
+
+    // MX_VCPU_STATE_* flags.
+    uint32_t flags;
+} mx_vcpu_state_t;
+#endif // __x86_64__
+
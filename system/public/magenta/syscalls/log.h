@@ -32,4 +32,33 @@ typedef struct mx_log_record {
 
 #define MX_LOG_FLAG_READABLE  0x40000000
 
+// Layout of the VMO returned by mx_log_get_vmo(): one header page
+// followed by the record ring.  The kernel appends records in place, so
+// a reader maps the vmo once, keeps a 64bit cursor, consumes the records
+// in [cursor, committed) directly from the mapping, and reports progress
+// with mx_log_advance() to manage the MX_LOG_READABLE signal.
+typedef struct mx_log_ring_header {
+    uint64_t magic;          // MX_LOG_RING_MAGIC
+    uint32_t version;        // MX_LOG_RING_VERSION
+    uint32_t data_offset;    // byte offset of the ring data in the vmo
+    uint64_t data_size;      // ring size in bytes, a power of two
+    uint64_t reserved;
+    uint64_t committed;      // records below this position are complete
+    uint64_t tail;           // oldest record still in the ring
+} mx_log_ring_header_t;
+
+#define MX_LOG_RING_MAGIC     (0x646c6f6772696e67ULL)
+#define MX_LOG_RING_VERSION   (1u)
+
+// Each record in the ring starts with a uint32_t size word (the
+// |reserved| field of mx_log_record_t): bits 0-11 hold the space the
+// record occupies in the ring, bits 12-23 the readable length (header
+// plus data).  Records are 4-byte aligned; the size word never wraps
+// around the ring end, but the rest of the record may.  A reader whose
+// cursor falls below |tail| has been lapped and must restart from
+// |tail|; after copying a record out it must re-check |tail| to discard
+// a copy torn by a concurrent overwrite.
+#define MX_LOG_RING_FIFOLEN(sizeword)  ((sizeword) & 0xFFFu)
+#define MX_LOG_RING_READLEN(sizeword)  (((sizeword) >> 12) & 0xFFFu)
+
 __END_CDECLS
@@ -27,6 +27,10 @@ typedef enum {
     MX_INFO_THREAD_EXCEPTION_REPORT    = 11, // mx_exception_report_t[1]
     MX_INFO_TASK_STATS                 = 12, // mx_info_task_stats_t[1]
     MX_INFO_PROCESS_MAPS               = 13, // mx_info_maps_t[n]
+    MX_INFO_THREAD_STATS               = 14, // mx_info_thread_stats_t[1]
+    MX_INFO_HEAP_SITES                 = 15, // mx_info_heap_site_t[n]
+    MX_INFO_PMM_ARENAS                 = 16, // mx_info_pmm_arena_t[n]
+    MX_INFO_JOB_STATS                  = 17, // mx_info_job_stats_t[1]
     MX_INFO_LAST
 } mx_object_info_topic_t;
 
@@ -108,6 +112,26 @@ typedef struct mx_info_thread {
     uint32_t wait_exception_port_type;
 } mx_info_thread_t;
 
+// Scheduler statistics for a thread. These counters are maintained
+// unconditionally by the scheduler and are cheap to sample, so monitoring
+// tools can poll them without setting up a tracing session.
+typedef struct mx_info_thread_stats {
+    // Total accumulated time the thread has spent running, in nanoseconds.
+    mx_time_t total_runtime;
+
+    // Total time the thread has spent ready-to-run, waiting in a run queue
+    // before being given a cpu, in nanoseconds.
+    mx_time_t queue_wait_time;
+
+    // Number of context switches where the thread gave up the cpu itself
+    // (blocked, slept or yielded).
+    uint64_t voluntary_switches;
+
+    // Number of context switches where the thread was preempted while it
+    // still wanted to run.
+    uint64_t involuntary_switches;
+} mx_info_thread_stats_t;
+
 // Statistics about resources (e.g., memory) used by a task. Can be relatively
 // expensive to gather.
 typedef struct mx_info_task_stats {
@@ -120,8 +144,77 @@ typedef struct mx_info_task_stats {
     // Some of the pages may be double-mapped (and thus double-counted),
     // or may be shared with other tasks.
     size_t mem_committed_bytes;
+
+    // The amount of mapped address space backed by pages that copy-on-write
+    // clones still share with their parent VMOs. Writing to these ranges
+    // forks the page, moving it from this count into mem_committed_bytes.
+    size_t mem_shared_bytes;
 } mx_info_task_stats_t;
 
+// Rolled-up resource usage of every process under a job (including nested
+// jobs), as reported by MX_INFO_JOB_STATS.  The counters are maintained
+// incrementally as processes run, so reading them is O(1) regardless of how
+// many tasks the job contains.  The values are approximate: handle counts
+// are propagated in batches, cpu time is accumulated as threads exit, and
+// committed memory is refreshed whenever a process's MX_INFO_TASK_STATS is
+// sampled and when the process dies.
+typedef struct mx_info_job_stats {
+    // Committed VMO bytes of the live processes under this job, as of each
+    // process's last MX_INFO_TASK_STATS sample.  Shared pages are counted
+    // once per process mapping them, as in mx_info_task_stats_t.
+    size_t mem_committed_bytes;
+
+    // Total cpu time consumed by exited threads of processes under this
+    // job, in nanoseconds.  Time accrued by still-running threads is not
+    // included until they exit.
+    mx_time_t cpu_time;
+
+    // Handles currently held by processes under this job.
+    uint64_t handle_count;
+} mx_info_job_stats_t;
+
+// One kernel heap allocation site, as reported by MX_INFO_HEAP_SITES on the
+// root resource.  Records exist only while kernel heap profiling has been
+// enabled from the kernel console; allocations are sampled, so the values
+// are estimates scaled by the sampling rate.
+typedef struct mx_info_heap_site {
+    // Kernel return address of the allocation site.
+    uint64_t caller;
+
+    // Estimated bytes currently allocated from this site.
+    uint64_t live_bytes;
+
+    // Estimated number of live allocations from this site.
+    uint64_t live_count;
+
+    // Estimated number of allocations ever made from this site.
+    uint64_t total_count;
+} mx_info_heap_site_t;
+
+// One physical memory arena, as reported by MX_INFO_PMM_ARENAS on the root
+// resource.  Page counts are sampled without stopping allocators, so they
+// are approximate.
+typedef struct mx_info_pmm_arena {
+    char name[16];
+
+    // NUMA node the arena's memory belongs to; 0 on non-NUMA systems.
+    uint32_t node;
+
+    uint32_t flags;
+
+    // Physical address range covered by the arena.
+    uint64_t base;
+    uint64_t size;
+
+    // Page counts by use.
+    uint64_t total_pages;
+    uint64_t free_pages;
+    // Pages owned by the kernel itself: wired, heap, page tables.
+    uint64_t wired_pages;
+    // Pages committed to VM objects.
+    uint64_t committed_pages;
+} mx_info_pmm_arena_t;
+
 typedef struct mx_info_vmar {
     // Base address of the region.
     uintptr_t base;
@@ -175,6 +268,26 @@ typedef struct mx_info_maps {
     } u;
 } mx_info_maps_t;
 
+// Entry for mx_object_get_info_batch(). Only topics whose record is a
+// single fixed-size struct can be sampled this way; topics that return
+// variable-length arrays must go through mx_object_get_info().
+typedef struct mx_object_info_entry {
+    // in: the handle to query
+    mx_handle_t handle;
+    // in: MX_INFO_* topic
+    uint32_t topic;
+    // in: byte offset of this entry's record in the result vmo
+    uint64_t offset;
+    // in: bytes reserved at |offset|
+    uint32_t buffer_size;
+    // out: bytes written at |offset|
+    uint32_t actual;
+    // per-entry result
+    mx_status_t status;
+} mx_object_info_entry_t;
+
+#define MX_OBJECT_INFO_BATCH_MAX ((uint32_t)32)
+
 
 // Object properties.
 
@@ -191,6 +304,55 @@ typedef struct mx_info_maps {
 // Argument is the value of ld.so's _dl_debug_addr, a uintptr_t.
 #define MX_PROP_PROCESS_DEBUG_ADDR          5u
 
+// Argument is a uint64_t nanosecond count. Timed waits made by the thread
+// may be serviced up to this much past their deadline so the kernel can
+// coalesce nearby timer expirations. Defaults to 0 (exact deadlines).
+#define MX_PROP_THREAD_TIMER_SLACK          6u
+
+// Argument is a uint64_t: bits 31:0 are one of the MX_NUMA_POLICY_xxx
+// values, bits 63:32 the target node for MX_NUMA_POLICY_BIND. Controls
+// which NUMA node backs pages allocated to the vmo after the call.
+#define MX_PROP_VMO_NUMA_POLICY             7u
+
+// Argument is a uint64_t byte count. While the process's committed memory
+// is at or above it, MX_PROCESS_HIGH_MEMORY is asserted on the process, so
+// a port or wait can observe crossings without polling. 0 (the default)
+// disarms the watermark and deasserts the signal.
+#define MX_PROP_PROCESS_MEMORY_WATERMARK    8u
+
+// Argument is an mx_thread_deadline_t. Reserves |capacity| ns of runtime
+// out of every |period| ns for the thread, due |relative_deadline| ns into
+// each period; deadline threads run earliest-deadline-first ahead of every
+// priority. Admission-controlled: fails with ERR_NO_RESOURCES rather than
+// over-committing the cpus. A |period| of 0 returns the thread to ordinary
+// priority scheduling.
+#define MX_PROP_THREAD_DEADLINE             9u
+
+typedef struct mx_thread_deadline {
+    mx_duration_t capacity;
+    mx_duration_t relative_deadline;
+    mx_duration_t period;
+} mx_thread_deadline_t;
+
+// Argument is a uint32_t with one bit per cpu. The scheduler only places
+// the thread on cpus in the mask (clipped to the cpu partition of the
+// process's job, if one is set). A mask of 0 fails with ERR_INVALID_ARGS;
+// bits for offline cpus are ignored. Defaults to all cpus.
+#define MX_PROP_THREAD_CPU_AFFINITY         10u
+
+// Argument is a uint32_t with one bit per cpu, 0 meaning "all cpus".
+// Cpuset-style partition: threads created under the job's processes after
+// the call are confined to these cpus, and per-thread affinity masks are
+// clipped to them. Already-running threads are not repartitioned. Child
+// jobs inherit the partition of their parent at creation time.
+#define MX_PROP_JOB_CPU_MASK                11u
+
+// Values for MX_PROP_VMO_NUMA_POLICY.
+#define MX_NUMA_POLICY_NONE                 0u  // no preference (the default)
+#define MX_NUMA_POLICY_LOCAL                1u  // prefer the faulting cpu's node
+#define MX_NUMA_POLICY_INTERLEAVE           2u  // rotate allocations across nodes
+#define MX_NUMA_POLICY_BIND                 3u  // allocate only from the given node
+
 // Values for mx_info_thread_t.state.
 #define MX_THREAD_STATE_NEW                 0u
 #define MX_THREAD_STATE_RUNNING             1u
@@ -45,11 +45,13 @@ typedef struct mx_exception_packet {
 
 #define MX_WAIT_ASYNC_ONCE          0u
 #define MX_WAIT_ASYNC_REPEATING     1u
+#define MX_WAIT_ASYNC_COUNTING      2u
 
 // packet types.
 #define MX_PKT_TYPE_USER            0u
 #define MX_PKT_TYPE_SIGNAL_ONE      1u
 #define MX_PKT_TYPE_SIGNAL_REP      2u
+#define MX_PKT_TYPE_CALL            3u
 
 // port_packet_t::type MX_PKT_TYPE_USER.
 typedef union mx_packet_user {
@@ -66,6 +68,16 @@ typedef struct mx_packet_signal {
     uint64_t count;
 } mx_packet_signal_t;
 
+// port_packet_t::type MX_PKT_TYPE_CALL. Queued when a reply to an
+// mx_channel_call_async() transaction arrives (or the call is aborted,
+// in which case the packet's status says why). The reply message itself
+// is delivered through the channel's regular message queue.
+typedef struct mx_packet_call {
+    mx_txid_t txid;
+    uint32_t reserved0;
+    uint64_t reserved1;
+} mx_packet_call_t;
+
 typedef struct mx_port_packet {
     uint64_t key;
     uint32_t type;
@@ -73,6 +85,7 @@ typedef struct mx_port_packet {
     union {
         mx_packet_user_t user;
         mx_packet_signal_t signal;
+        mx_packet_call_t call;
     };
 } mx_port_packet_t;
 
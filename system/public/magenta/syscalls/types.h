@@ -10,5 +10,6 @@ __BEGIN_CDECLS
 typedef struct mx_pcie_get_nth_info mx_pcie_get_nth_info_t;
 typedef struct mx_pci_init_arg mx_pci_init_arg_t;
 typedef union mx_rrec mx_rrec_t;
+typedef struct mx_object_info_entry mx_object_info_entry_t;
 
 __END_CDECLS
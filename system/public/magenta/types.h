@@ -115,6 +115,9 @@ typedef uint32_t mx_signals_t;
 // Port
 #define MX_PORT_READABLE            __MX_OBJECT_READABLE
 
+// Interrupt
+#define MX_INTERRUPT_SIGNALED       __MX_OBJECT_SIGNALED
+
 // Resource
 #define MX_RESOURCE_DESTROYED       __MX_OBJECT_SIGNALED
 #define MX_RESOURCE_READABLE        __MX_OBJECT_READABLE
@@ -139,6 +142,9 @@ typedef uint32_t mx_signals_t;
 
 // Process
 #define MX_PROCESS_TERMINATED       __MX_OBJECT_SIGNALED
+// Asserted while the process's committed memory sits at or above the
+// watermark armed with MX_PROP_PROCESS_MEMORY_WATERMARK.
+#define MX_PROCESS_HIGH_MEMORY      __MX_OBJECT_SIGNAL_4
 
 // Thread
 #define MX_THREAD_TERMINATED        __MX_OBJECT_SIGNALED
@@ -172,6 +178,42 @@ typedef struct {
     uint32_t rd_num_handles;
 } mx_channel_call_args_t;
 
+// Entry for mx_channel_write_batch()/mx_channel_read_batch(). Batched
+// messages carry bytes only; messages with handles must use
+// mx_channel_write()/mx_channel_read().
+typedef struct {
+    void* bytes;
+    // write: size of the message; read: buffer capacity on input, actual
+    // message size on output
+    uint32_t num_bytes;
+    // per-message result
+    mx_status_t status;
+} mx_channel_batch_entry_t;
+
+#define MX_CHANNEL_BATCH_MAX_MESSAGES ((uint32_t)16)
+
+// Limits on a single channel message.
+#define MX_CHANNEL_MAX_MSG_BYTES ((uint32_t)65536)
+#define MX_CHANNEL_MAX_MSG_HANDLES ((uint32_t)1024)
+
+// Entry for mx_vmo_read_vec()/mx_vmo_write_vec() and
+// mx_process_read_memory_vec()/mx_process_write_memory_vec(): one
+// discontiguous segment of the transfer. |offset| is the vmo offset,
+// or the remote virtual address for the process memory accessors.
+typedef struct {
+    void* buffer;
+    uint64_t offset;
+    // bytes to transfer
+    size_t length;
+    // bytes actually transferred (may be short at the end of a vmo)
+    size_t actual;
+    // per-segment result
+    mx_status_t status;
+    uint32_t reserved;
+} mx_iovec_entry_t;
+
+#define MX_IOVEC_MAX_ENTRIES ((uint32_t)16)
+
 // Structure for mx_object_wait_many():
 typedef struct {
     mx_handle_t handle;
@@ -201,6 +243,20 @@ typedef uint32_t mx_rights_t;
 #define MX_RIGHT_SET_POLICY       ((mx_rights_t)1u << 10)
 #define MX_RIGHT_GET_POLICY       ((mx_rights_t)1u << 11)
 
+// Entry for mx_handle_duplicate_batch()/mx_handle_replace_batch().
+typedef struct {
+    // in: the source handle
+    mx_handle_t handle;
+    // in: rights for the new handle, or MX_RIGHT_SAME_RIGHTS
+    mx_rights_t rights;
+    // out: the new handle, or MX_HANDLE_INVALID on failure
+    mx_handle_t out;
+    // per-entry result
+    mx_status_t status;
+} mx_handle_op_entry_t;
+
+#define MX_HANDLE_OP_BATCH_MAX ((uint32_t)32)
+
 #define MX_RIGHT_SAME_RIGHTS      ((mx_rights_t)1u << 31)
 
 // VM Object opcodes
@@ -213,6 +269,7 @@ typedef uint32_t mx_rights_t;
 #define MX_VMO_OP_CACHE_INVALIDATE       7u
 #define MX_VMO_OP_CACHE_CLEAN            8u
 #define MX_VMO_OP_CACHE_CLEAN_INVALIDATE 9u
+#define MX_VMO_OP_ZERO                   10u
 
 // VM Object clone flags
 #define MX_VMO_CLONE_COPY_ON_WRITE       1u
@@ -260,6 +317,10 @@ typedef int64_t mx_rel_off_t;
 
 // Socket options and limits.
 #define MX_SOCKET_HALF_CLOSE                1u
+// mx_socket_read() options: peek copies data out without consuming it;
+// consume discards previously peeked data without copying.
+#define MX_SOCKET_PEEK                      2u
+#define MX_SOCKET_CONSUME                   4u
 
 // Flags which can be used to to control cache policy for APIs which map memory.
 typedef enum {
@@ -157,6 +157,15 @@ ssize_t VnodeBlob::Ioctl(uint32_t op, const void* in_buf, size_t in_len, void* o
             const blob_ioctl_config_t* config = static_cast<const blob_ioctl_config_t*>(in_buf);
             return SpaceAllocate(config->size_data);
         }
+        case IOCTL_BLOBSTORE_DEDUP_STATS: {
+            if (out_len != sizeof(blobstore_dedup_stats_t)) {
+                return ERR_INVALID_ARGS;
+            }
+            blobstore_dedup_stats_t* stats = static_cast<blobstore_dedup_stats_t*>(out_buf);
+            stats->pages_indexed = blobstore_->dedup_pages_indexed_;
+            stats->pages_merged = blobstore_->dedup_pages_merged_;
+            return sizeof(blobstore_dedup_stats_t);
+        }
         default: {
             return ERR_NOT_SUPPORTED;
         }
@@ -45,6 +45,45 @@ constexpr BlobFlags kBlobOtherMask        = 0xFF000000;
 static_assert(((kBlobStateMask | kBlobOtherMask) & V_FLAG_RESERVED_MASK) == 0,
               "Blobstore flags conflict with VFS-reserved flags");
 
+// One entry per unique page of resident blob data, keyed by the SHA256 of
+// the page contents, so later blobs can merge identical pages onto the same
+// physical frame with mx_vmo_dedup. Entries sit in a per-Blobstore tree for
+// lookup and a per-VnodeBlob list so an owner's entries can be dropped when
+// its VMOs go away.
+struct DedupPageEntry {
+    uint8_t digest[merkle::Digest::kLength];
+    VnodeBlob* owner;
+    uint64_t offset; // Page offset within the owner's data VMO
+
+    mxtl::WAVLTreeNodeState<DedupPageEntry*> tree_state;
+    mxtl::DoublyLinkedListNodeState<DedupPageEntry*> list_state;
+
+    struct TreeTraits {
+        static mxtl::WAVLTreeNodeState<DedupPageEntry*>& node_state(DedupPageEntry& e) {
+            return e.tree_state;
+        }
+    };
+    struct ListTraits {
+        static mxtl::DoublyLinkedListNodeState<DedupPageEntry*>& node_state(DedupPageEntry& e) {
+            return e.list_state;
+        }
+    };
+
+    const uint8_t* GetKey() const { return digest; }
+};
+
+// Page content digests are the same length as merkle roots, so the index
+// can reuse the same key comparison scheme.
+struct DedupKeyTraits {
+    static const uint8_t* GetKey(const DedupPageEntry& e) { return e.digest; }
+    static bool LessThan(const uint8_t* k1, const uint8_t* k2) {
+        return memcmp(k1, k2, merkle::Digest::kLength) < 0;
+    }
+    static bool EqualTo(const uint8_t* k1, const uint8_t* k2) {
+        return memcmp(k1, k2, merkle::Digest::kLength) == 0;
+    }
+};
+
 class VnodeBlob final : public fs::Vnode {
 public:
     // Intrusive methods and structures
@@ -119,6 +158,12 @@ private:
     // Requires: kBlobStateReadable
     mx_status_t ReadInternal(void* data, size_t len, size_t off, size_t* actual);
 
+    // Verifies the blob contents overlapping [off, off + len) against the
+    // Merkle tree, skipping any nodes which an earlier call already verified.
+    // Nodes which pass are remembered in |verified_map_|, so each node is
+    // only hashed on first access.
+    mx_status_t VerifyRange(uint64_t off, size_t len);
+
     // Vnode I/O operations
     mx_status_t GetHandles(uint32_t flags, mx_handle_t* hnds,
                            uint32_t* type, void* extra, uint32_t* esize) final;
@@ -143,6 +188,14 @@ private:
     // the contents of a VMO into memory when it is opened.
     mx_status_t InitVmos();
 
+    // Hash each page of the freshly loaded data VMO against the blobstore's
+    // dedup index, merging pages whose contents match an already-indexed
+    // page onto a shared frame and indexing the rest.
+    void DedupData();
+
+    // Remove this blob's pages from the dedup index.
+    void ReleaseDedupPages();
+
     mx_status_t WriteShared(const void** data, size_t* len, size_t* actual,
                             uint64_t maxlen, mx_handle_t vmo, uint64_t start_block);
 
@@ -158,6 +211,13 @@ private:
     mx_handle_t vmo_blob_;
     uintptr_t   vmo_blob_addr_;
 
+    // One bit per Merkle tree node of blob data; set once the node has been
+    // checked against the tree, so repeat reads skip hashing.
+    RawBitmap verified_map_;
+
+    // This blob's entries in the blobstore's dedup page index.
+    mxtl::DoublyLinkedList<DedupPageEntry*, DedupPageEntry::ListTraits> dedup_entries_;
+
     mx_handle_t readable_event_;
     uint64_t bytes_written_;
 
@@ -246,6 +306,16 @@ private:
                                             VnodeBlob::TypeWavlTraits>;
     WAVLTreeByMerkle hash_; // Map of all 'in use' blobs
 
+    // Index of unique resident data pages by content digest, plus running
+    // dedup statistics, reported through IOCTL_BLOBSTORE_DEDUP_STATS.
+    using DedupTree = mxtl::WAVLTree<const uint8_t*,
+                                     DedupPageEntry*,
+                                     DedupKeyTraits,
+                                     DedupPageEntry::TreeTraits>;
+    DedupTree dedup_pages_;
+    uint64_t dedup_pages_indexed_;
+    uint64_t dedup_pages_merged_;
+
     RawBitmap block_map_;
     mxtl::unique_ptr<blobstore_inode_t[]> node_map_;
 };
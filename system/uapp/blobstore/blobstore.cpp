@@ -223,12 +223,72 @@ mx_status_t VnodeBlob::InitVmos() {
         goto fail;
     }
 
+    // Nothing has been checked against the Merkle tree yet; nodes are
+    // verified on first access.
+    if ((status = verified_map_.Reset(BlobDataBlocks(*inode))) != NO_ERROR) {
+        goto fail;
+    }
+
+    // Fold pages identical to already-resident blob data onto shared frames.
+    DedupData();
+
     return NO_ERROR;
 fail:
     BlobCloseHandles();
     return status;
 }
 
+void VnodeBlob::DedupData() {
+    blobstore_inode_t* inode = &blobstore_->node_map_[map_index_];
+    uint64_t data_vmo_size = BlobDataBlocks(*inode) * kBlobstoreBlockSize;
+
+    merkle::Digest digest;
+    for (uint64_t off = 0; off < data_vmo_size; off += PAGE_SIZE) {
+        digest.Hash((const void*)(vmo_blob_addr_ + off), PAGE_SIZE);
+        uint8_t key[merkle::Digest::kLength];
+        digest.CopyTo(key, sizeof(key));
+
+        DedupPageEntry* entry = blobstore_->dedup_pages_.find(key).CopyPointer();
+        if (entry != nullptr) {
+            if (entry->owner == this) {
+                continue;
+            }
+            // The kernel re-verifies the contents match before merging, so a
+            // hash collision costs a wasted call rather than corruption.
+            uint64_t merged = 0;
+            if (mx_vmo_dedup(entry->owner->vmo_blob_, entry->offset, vmo_blob_, off,
+                             PAGE_SIZE, &merged) == NO_ERROR) {
+                blobstore_->dedup_pages_merged_ += merged;
+            }
+            continue;
+        }
+
+        // First time this content has been seen; index it for later blobs.
+        AllocChecker ac;
+        entry = new (&ac) DedupPageEntry();
+        if (!ac.check()) {
+            // Index as much as memory allows; missing entries only cost
+            // dedup opportunities.
+            return;
+        }
+        memcpy(entry->digest, key, sizeof(entry->digest));
+        entry->owner = this;
+        entry->offset = off;
+        blobstore_->dedup_pages_.insert(entry);
+        dedup_entries_.push_back(entry);
+        blobstore_->dedup_pages_indexed_++;
+    }
+}
+
+void VnodeBlob::ReleaseDedupPages() {
+    while (!dedup_entries_.is_empty()) {
+        DedupPageEntry* entry = dedup_entries_.pop_front();
+        blobstore_->dedup_pages_.erase(*entry);
+        blobstore_->dedup_pages_indexed_--;
+        delete entry;
+    }
+}
+
 uint64_t VnodeBlob::SizeData() const {
     if (GetState() == kBlobStateReadable) {
         auto inode = &blobstore_->node_map_[map_index_];
@@ -262,6 +322,7 @@ VnodeBlob::VnodeBlob(mxtl::RefPtr<Blobstore> bs) :
 
 void VnodeBlob::BlobCloseHandles() {
     auto inode = &blobstore_->node_map_[map_index_];
+    ReleaseDedupPages();
     if (vmo_merkle_tree_addr_ != 0) {
         uint64_t size_merkle = merkle::Tree::GetTreeLength(inode->blob_size);
         mx_vmar_unmap(mx_vmar_root_self(), vmo_merkle_tree_addr_, size_merkle);
@@ -492,6 +553,60 @@ mx_status_t VnodeBlob::GetReadableEvent(mx_handle_t* out) {
     return sizeof(mx_handle_t);
 }
 
+// Each bit in |verified_map_| covers one node of blob data, which is the same
+// granularity the Merkle tree hashes at.
+static_assert(kBlobstoreBlockSize == merkle::Tree::kNodeSize,
+              "Blobstore blocks must match Merkle tree nodes");
+
+mx_status_t VnodeBlob::VerifyRange(uint64_t off, size_t len) {
+    constexpr uint64_t kNodeSize = merkle::Tree::kNodeSize;
+    merkle::Digest d;
+    d = ((const uint8_t*) &digest_[0]);
+    auto inode = &blobstore_->node_map_[map_index_];
+    uint64_t size_merkle = merkle::Tree::GetTreeLength(inode->blob_size);
+    if (inode->blob_size == 0) {
+        // No nodes to track; check the empty blob against the root directly.
+        merkle::Tree mt;
+        return mt.Verify((const void*)vmo_blob_addr_, inode->blob_size,
+                         (const void*)vmo_merkle_tree_addr_, size_merkle,
+                         off, len, d);
+    }
+    uint64_t finish = off + len;
+    if (finish < off || finish > inode->blob_size) {
+        // The same range check merkle::Tree::Verify would have made.
+        return ERR_INVALID_ARGS;
+    }
+    uint64_t node = off / kNodeSize;
+    uint64_t last = mxtl::roundup(finish, kNodeSize) / kNodeSize;
+    while (node < last) {
+        if (verified_map_.Get(node, node + 1)) {
+            node++;
+            continue;
+        }
+        // Extend to the whole run of unverified nodes so the tree levels
+        // above them are only walked once.
+        uint64_t run = node + 1;
+        while (run < last && !verified_map_.Get(run, run + 1)) {
+            run++;
+        }
+        merkle::Tree mt;
+        uint64_t start = node * kNodeSize;
+        mx_status_t status = mt.Verify(
+            (const void*)vmo_blob_addr_, inode->blob_size,
+            (const void*)vmo_merkle_tree_addr_, size_merkle, start,
+            static_cast<size_t>(
+                mxtl::min(run * kNodeSize, inode->blob_size) - start), d);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        if ((status = verified_map_.Set(node, run)) != NO_ERROR) {
+            return status;
+        }
+        node = run;
+    }
+    return NO_ERROR;
+}
+
 mx_status_t VnodeBlob::CopyVmo(mx_rights_t rights, mx_handle_t* out) {
     if (GetState() != kBlobStateReadable) {
         return ERR_BAD_STATE;
@@ -505,15 +620,11 @@ mx_status_t VnodeBlob::CopyVmo(mx_rights_t rights, mx_handle_t* out) {
     // 1) We could fault in pages on-demand, or
     // 2) We could create a COW subsection of the original VMO.
     //
-    // For now, we aggressively verify the entire VMO up front.
-    merkle::Tree mt;
-    merkle::Digest d;
-    d = ((const uint8_t*) &digest_[0]);
+    // Until then, anything handed out through a VMO must be verified up
+    // front; only reads through the file interface are verified on demand.
+    // Nodes that earlier reads already checked are skipped here.
     auto inode = &blobstore_->node_map_[map_index_];
-    uint64_t size_merkle = merkle::Tree::GetTreeLength(inode->blob_size);
-    status = mt.Verify((const void*)vmo_blob_addr_, inode->blob_size,
-                       (const void*)vmo_merkle_tree_addr_, size_merkle,
-                       0, inode->blob_size, d);
+    status = VerifyRange(0, inode->blob_size);
     if (status != NO_ERROR) {
         return status;
     }
@@ -531,14 +642,9 @@ mx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
         return status;
     }
 
-    merkle::Tree mt;
-    merkle::Digest d;
-    d = ((const uint8_t*) &digest_[0]);
-    auto inode = &blobstore_->node_map_[map_index_];
-    uint64_t size_merkle = merkle::Tree::GetTreeLength(inode->blob_size);
-    status = mt.Verify((const void*)vmo_blob_addr_, inode->blob_size,
-                       (const void*)vmo_merkle_tree_addr_, size_merkle,
-                       off, len, d);
+    // Only verify the nodes this read touches; the first access to each node
+    // checks one branch of the Merkle tree, and repeat accesses skip hashing.
+    status = VerifyRange(off, len);
     if (status != NO_ERROR) {
         return status;
     }
@@ -745,7 +851,8 @@ mx_status_t Blobstore::LookupBlob(const merkle::Digest& digest, mxtl::RefPtr<Vno
     return ERR_NOT_FOUND;
 }
 
-Blobstore::Blobstore(int fd, const blobstore_info_t* info) : blockfd_(fd) {
+Blobstore::Blobstore(int fd, const blobstore_info_t* info) :
+    blockfd_(fd), dedup_pages_indexed_(0), dedup_pages_merged_(0) {
     memcpy(&info_, info, sizeof(blobstore_info_t));
 }
 
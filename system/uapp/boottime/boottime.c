@@ -0,0 +1,109 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Prints the phase-by-phase boot timeline assembled from the
+// BOOTDATA_BOOT_TIMELINE records that the bootloader, kernel, and devmgr
+// publish at /boot/kernel/boot-timeline.N.
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <magenta/boot/bootdata.h>
+#include <magenta/syscalls.h>
+
+#define MAX_RECORDS 64
+
+typedef struct {
+    uint64_t ns;
+    char name[BOOTDATA_TIMELINE_NAME_LEN];
+} record_t;
+
+static record_t records[MAX_RECORDS];
+static size_t record_count;
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t tps) {
+    // split to avoid overflowing ticks * 1e9
+    return ((ticks / tps) * 1000000000ULL) +
+           (((ticks % tps) * 1000000000ULL) / tps);
+}
+
+static int load_timeline(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    bootdata_boot_timeline_t hdr;
+    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        close(fd);
+        return -1;
+    }
+    uint64_t tps = hdr.ticks_per_second;
+    if (tps == 0) {
+        tps = mx_ticks_per_second();
+    }
+
+    for (uint32_t n = 0; n < hdr.entry_count; n++) {
+        bootdata_boot_timeline_entry_t e;
+        if (read(fd, &e, sizeof(e)) != sizeof(e)) {
+            break;
+        }
+        if (record_count == MAX_RECORDS) {
+            break;
+        }
+        record_t* r = &records[record_count++];
+        r->ns = ticks_to_ns(e.ticks, tps);
+        memcpy(r->name, e.name, sizeof(r->name));
+        r->name[sizeof(r->name) - 1] = 0;
+    }
+
+    close(fd);
+    return 0;
+}
+
+static int cmp_record(const void* a, const void* b) {
+    uint64_t va = ((const record_t*)a)->ns;
+    uint64_t vb = ((const record_t*)b)->ns;
+    return (va < vb) ? -1 : (va > vb) ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    for (unsigned n = 0;; n++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/boot/kernel/boot-timeline.%u", n);
+        if (load_timeline(path) < 0) {
+            break;
+        }
+    }
+    if (record_count == 0) {
+        fprintf(stderr, "boottime: no boot timeline records found\n");
+        return -1;
+    }
+
+    // note when we got to run, as the final milestone
+    if (record_count < MAX_RECORDS) {
+        record_t* r = &records[record_count++];
+        r->ns = ticks_to_ns(mx_ticks_get(), mx_ticks_per_second());
+        strcpy(r->name, "boottime.run");
+    }
+
+    qsort(records, record_count, sizeof(records[0]), cmp_record);
+
+    printf("%-16s %12s %12s\n", "PHASE", "TIME(ms)", "DELTA(ms)");
+    uint64_t t0 = records[0].ns;
+    uint64_t prev = t0;
+    for (size_t i = 0; i < record_count; i++) {
+        uint64_t t_us = (records[i].ns - t0) / 1000;
+        uint64_t d_us = (records[i].ns - prev) / 1000;
+        printf("%-16s %8" PRIu64 ".%03" PRIu64 " %8" PRIu64 ".%03" PRIu64 "\n",
+               records[i].name, t_us / 1000, t_us % 1000,
+               d_us / 1000, d_us % 1000);
+        prev = records[i].ns;
+    }
+    return 0;
+}
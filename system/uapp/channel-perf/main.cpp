@@ -9,18 +9,68 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 
 #include <magenta/compiler.h>
 #include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
 #include <mxtl/unique_ptr.h>
 
 namespace {
 
+// When set (-c), each result is additionally emitted as one
+// "CSV,<test>,<params...>,<values...>" line for scripts.
+bool output_csv = false;
+
 void argument_error(const char* argv0, const char* message) {
     fprintf(stderr, "%s: error: %s\nRun with -h for help.\n", argv0, message);
     exit(EXIT_FAILURE);
 }
 
+uint64_t now_ns() {
+    return mx_time_get(MX_CLOCK_MONOTONIC);
+}
+
+int cmp_u64(const void* a, const void* b) {
+    uint64_t va = *static_cast<const uint64_t*>(a);
+    uint64_t vb = *static_cast<const uint64_t*>(b);
+    if (va < vb)
+        return -1;
+    if (va > vb)
+        return 1;
+    return 0;
+}
+
+// Sorts |samples| and reports its latency distribution. |params| is a
+// short comma-free description of the run, used in both output forms.
+void report_latency(const char* test, const char* params,
+                    uint64_t* samples, uint32_t count) {
+    qsort(samples, count, sizeof(samples[0]), cmp_u64);
+
+    uint64_t min = samples[0];
+    uint64_t p50 = samples[count / 2];
+    uint64_t p99 = samples[(uint64_t)count * 99 / 100];
+    uint64_t p999 = samples[(uint64_t)count * 999 / 1000];
+    uint64_t max = samples[count - 1];
+
+    printf("%s (%s): p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, p999 %" PRIu64
+           " ns (min %" PRIu64 ", max %" PRIu64 ", %u samples)\n",
+           test, params, p50, p99, p999, min, max, count);
+    if (output_csv) {
+        printf("CSV,%s,%s,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+               ",%" PRIu64 "\n",
+               test, params, count, min, p50, p99, p999, max);
+    }
+}
+
+void report_rate(const char* test, const char* params,
+                 const char* unit, double rate) {
+    printf("%s (%s): %.0f %s\n", test, params, rate, unit);
+    if (output_csv)
+        printf("CSV,%s,%s,%.0f,%s\n", test, params, rate, unit);
+}
+
 void duplicate_handles(uint32_t n, mx_handle_t src, mx_handle_t* dest) {
     for (uint32_t i = 0; i < n; i++) {
         assert(mx_handle_duplicate(src, MX_RIGHT_SAME_RIGHTS, &dest[i]) == 0);
@@ -109,6 +159,399 @@ void do_test(uint32_t duration, const TestArgs& test_args) {
     printf("write/read %" PRIu32 " bytes, %" PRIu32 " handles (%" PRIu32 " pre-queued): "
                "%.0f iterations/second\n",
            test_args.size, test_args.handles, test_args.queue, its_per_second);
+    if (output_csv) {
+        printf("CSV,throughput,size=%u handles=%u queue=%u,%.0f,ops/s\n",
+               test_args.size, test_args.handles, test_args.queue,
+               its_per_second);
+    }
+}
+
+// --- mx_channel_call round-trip latency ---
+
+// Echoes every message back unchanged (including the leading txid, which
+// is what routes the reply to the caller); exits when the peer closes.
+int call_echo_thread(void* arg) {
+    mx_handle_t channel = static_cast<mx_handle_t>(
+        reinterpret_cast<uintptr_t>(arg));
+    uint8_t buffer[65536];
+
+    for (;;) {
+        mx_signals_t observed;
+        mx_status_t status = mx_object_wait_one(
+            channel, MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+            MX_TIME_INFINITE, &observed);
+        assert(status == NO_ERROR);
+        uint32_t size = sizeof(buffer);
+        uint32_t nhandles = 0;
+        status = mx_channel_read(channel, 0u, buffer, nullptr, size, 0,
+                                 &size, &nhandles);
+        if (status == ERR_SHOULD_WAIT) {
+            if (observed & MX_CHANNEL_PEER_CLOSED)
+                break;
+            continue;
+        }
+        assert(status == NO_ERROR);
+        status = mx_channel_write(channel, 0u, buffer, size, nullptr, 0);
+        if (status != NO_ERROR)
+            break;
+    }
+    mx_handle_close(channel);
+    return 0;
+}
+
+void do_call_test(uint32_t size, uint32_t iterations) {
+    assert(size >= sizeof(mx_txid_t) && size <= 65536);
+
+    mx_handle_t client, server;
+    mx_status_t status = mx_channel_create(0u, &client, &server);
+    assert(status == NO_ERROR);
+
+    thrd_t echo;
+    int ret = thrd_create(&echo, call_echo_thread,
+                          reinterpret_cast<void*>(
+                              static_cast<uintptr_t>(server)));
+    assert(ret == thrd_success);
+
+    mxtl::unique_ptr<uint8_t[]> wr(new uint8_t[size]);
+    mxtl::unique_ptr<uint8_t[]> rd(new uint8_t[size]);
+    memset(wr.get(), 0xab, size);
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[iterations]);
+
+    mx_channel_call_args_t args = {};
+    args.wr_bytes = wr.get();
+    args.rd_bytes = rd.get();
+    args.wr_num_bytes = size;
+    args.rd_num_bytes = size;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint32_t actual_bytes, actual_handles;
+        mx_status_t read_status;
+        uint64_t t0 = now_ns();
+        status = mx_channel_call(client, 0u, MX_TIME_INFINITE, &args,
+                                 &actual_bytes, &actual_handles,
+                                 &read_status);
+        samples[i] = now_ns() - t0;
+        assert(status == NO_ERROR);
+        assert(actual_bytes == size);
+    }
+
+    mx_handle_close(client);
+    thrd_join(echo, nullptr);
+
+    char params[32];
+    snprintf(params, sizeof(params), "size=%u", size);
+    report_latency("call", params, samples.get(), iterations);
+}
+
+// --- wakeup cost: ports vs wait-many ---
+
+struct WakeupArgs {
+    mx_handle_t ping;
+    mx_handle_t pong;
+    uint32_t rounds;
+};
+
+int wakeup_partner_thread(void* arg) {
+    const WakeupArgs* a = static_cast<WakeupArgs*>(arg);
+    for (uint32_t i = 0; i < a->rounds; i++) {
+        mx_signals_t observed;
+        mx_status_t status = mx_object_wait_one(a->ping, MX_USER_SIGNAL_0,
+                                                MX_TIME_INFINITE, &observed);
+        assert(status == NO_ERROR);
+        status = mx_object_signal(a->ping, MX_USER_SIGNAL_0, 0);
+        assert(status == NO_ERROR);
+        status = mx_object_signal(a->pong, 0, MX_USER_SIGNAL_0);
+        assert(status == NO_ERROR);
+    }
+    return 0;
+}
+
+// Measures the round trip of signaling a partner thread and being woken
+// by its answer, with the waiter parked in mx_object_wait_many over
+// |width| handles or in mx_port_wait on a port with |width| bound
+// sources; the answering event is always the last one, the worst case
+// for the linear wait-many scan.
+void do_wakeup_test(bool use_port, uint32_t width, uint32_t iterations) {
+    assert(width >= 1 && width <= 64);
+
+    WakeupArgs args;
+    args.rounds = iterations;
+
+    mx_handle_t events[64];
+    for (uint32_t i = 0; i < width; i++) {
+        mx_status_t status = mx_event_create(0u, &events[i]);
+        assert(status == NO_ERROR);
+    }
+    mx_status_t status = mx_event_create(0u, &args.ping);
+    assert(status == NO_ERROR);
+    args.pong = events[width - 1];
+
+    mx_handle_t port = MX_HANDLE_INVALID;
+    mx_wait_item_t items[64];
+    if (use_port) {
+        status = mx_port_create(0u, &port);
+        assert(status == NO_ERROR);
+        for (uint32_t i = 0; i < width; i++) {
+            status = mx_port_bind(port, i, events[i], MX_USER_SIGNAL_0);
+            assert(status == NO_ERROR);
+        }
+    } else {
+        for (uint32_t i = 0; i < width; i++) {
+            items[i].handle = events[i];
+            items[i].waitfor = MX_USER_SIGNAL_0;
+            items[i].pending = 0;
+        }
+    }
+
+    thrd_t partner;
+    int ret = thrd_create(&partner, wakeup_partner_thread, &args);
+    assert(ret == thrd_success);
+
+    mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[iterations]);
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t t0 = now_ns();
+        status = mx_object_signal(args.ping, 0, MX_USER_SIGNAL_0);
+        assert(status == NO_ERROR);
+        if (use_port) {
+            mx_io_packet_t packet;
+            do {
+                status = mx_port_wait(port, MX_TIME_INFINITE, &packet,
+                                      sizeof(packet));
+                assert(status == NO_ERROR);
+            } while (packet.hdr.key != width - 1);
+        } else {
+            status = mx_object_wait_many(items, width, MX_TIME_INFINITE);
+            assert(status == NO_ERROR);
+        }
+        samples[i] = now_ns() - t0;
+        status = mx_object_signal(args.pong, MX_USER_SIGNAL_0, 0);
+        assert(status == NO_ERROR);
+    }
+
+    thrd_join(partner, nullptr);
+    if (use_port)
+        mx_handle_close(port);
+    mx_handle_close(args.ping);
+    for (uint32_t i = 0; i < width; i++)
+        mx_handle_close(events[i]);
+
+    char params[32];
+    snprintf(params, sizeof(params), "%s width=%u",
+             use_port ? "port" : "wait-many", width);
+    report_latency("wakeup", params, samples.get(), iterations);
+}
+
+// --- handle-transfer overhead scaling ---
+
+void do_handle_scaling_test(uint32_t iterations) {
+    static constexpr uint32_t kCounts[] = {0, 1, 2, 4, 8, 16, 32, 64};
+
+    mx_handle_t mp[2];
+    mx_status_t status = mx_channel_create(0u, &mp[0], &mp[1]);
+    assert(status == NO_ERROR);
+    mx_handle_t event;
+    status = mx_event_create(0u, &event);
+    assert(status == NO_ERROR);
+
+    for (size_t c = 0; c < countof(kCounts); c++) {
+        uint32_t nhandles = kCounts[c];
+        mx_handle_t handles[64];
+        duplicate_handles(nhandles, event, handles);
+
+        mxtl::unique_ptr<uint64_t[]> samples(new uint64_t[iterations]);
+        for (uint32_t i = 0; i < iterations; i++) {
+            // The handles read out are the same ones we wrote, so each
+            // iteration can resend them.
+            uint64_t t0 = now_ns();
+            status = mx_channel_write(mp[0], 0u, nullptr, 0, handles,
+                                      nhandles);
+            assert(status == NO_ERROR);
+            uint32_t r_size = 0;
+            uint32_t r_handles = nhandles;
+            status = mx_channel_read(mp[1], 0u, nullptr, handles, 0,
+                                     r_handles, &r_size, &r_handles);
+            samples[i] = now_ns() - t0;
+            assert(status == NO_ERROR);
+            assert(r_handles == nhandles);
+        }
+
+        for (uint32_t i = 0; i < nhandles; i++)
+            mx_handle_close(handles[i]);
+
+        char params[32];
+        snprintf(params, sizeof(params), "handles=%u", nhandles);
+        report_latency("handle-transfer", params, samples.get(), iterations);
+    }
+
+    mx_handle_close(event);
+    mx_handle_close(mp[0]);
+    mx_handle_close(mp[1]);
+}
+
+// --- socket streaming bandwidth ---
+
+struct SocketArgs {
+    mx_handle_t socket;
+    uint32_t chunk;
+    uint64_t total;
+};
+
+int socket_writer_thread(void* arg) {
+    const SocketArgs* a = static_cast<SocketArgs*>(arg);
+    mxtl::unique_ptr<uint8_t[]> buffer(new uint8_t[a->chunk]);
+    memset(buffer.get(), 0x5a, a->chunk);
+
+    uint64_t written = 0;
+    while (written < a->total) {
+        size_t actual;
+        mx_status_t status = mx_socket_write(a->socket, 0u, buffer.get(),
+                                             a->chunk, &actual);
+        if (status == ERR_SHOULD_WAIT) {
+            mx_signals_t observed;
+            status = mx_object_wait_one(a->socket, MX_SOCKET_WRITABLE,
+                                        MX_TIME_INFINITE, &observed);
+            assert(status == NO_ERROR);
+            continue;
+        }
+        assert(status == NO_ERROR);
+        written += actual;
+    }
+    return 0;
+}
+
+void do_socket_test(uint32_t chunk, uint64_t total) {
+    mx_handle_t sp[2];
+    mx_status_t status = mx_socket_create(0u, &sp[0], &sp[1]);
+    assert(status == NO_ERROR);
+
+    SocketArgs args = {sp[0], chunk, total};
+    thrd_t writer;
+    int ret = thrd_create(&writer, socket_writer_thread, &args);
+    assert(ret == thrd_success);
+
+    mxtl::unique_ptr<uint8_t[]> buffer(new uint8_t[chunk]);
+    uint64_t received = 0;
+    uint64_t start = now_ns();
+    while (received < total) {
+        size_t actual;
+        status = mx_socket_read(sp[1], 0u, buffer.get(), chunk, &actual);
+        if (status == ERR_SHOULD_WAIT) {
+            mx_signals_t observed;
+            status = mx_object_wait_one(sp[1], MX_SOCKET_READABLE,
+                                        MX_TIME_INFINITE, &observed);
+            assert(status == NO_ERROR);
+            continue;
+        }
+        assert(status == NO_ERROR);
+        received += actual;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    thrd_join(writer, nullptr);
+    mx_handle_close(sp[0]);
+    mx_handle_close(sp[1]);
+
+    double mb_per_s = (static_cast<double>(total) / (1024.0 * 1024.0)) /
+                      (static_cast<double>(elapsed) / 1000000000.0);
+    char params[32];
+    snprintf(params, sizeof(params), "chunk=%u", chunk);
+    report_rate("socket-stream", params, "MB/s", mb_per_s);
+}
+
+// --- multi-writer contention ---
+
+struct ContendArgs {
+    mx_handle_t channel;
+    uint32_t messages;
+    uint32_t size;
+};
+
+int contend_writer_thread(void* arg) {
+    const ContendArgs* a = static_cast<ContendArgs*>(arg);
+    mxtl::unique_ptr<uint8_t[]> buffer(new uint8_t[a->size]);
+    memset(buffer.get(), 0xc7, a->size);
+
+    for (uint32_t i = 0; i < a->messages; i++) {
+        mx_status_t status = mx_channel_write(a->channel, 0u, buffer.get(),
+                                              a->size, nullptr, 0);
+        assert(status == NO_ERROR);
+    }
+    return 0;
+}
+
+// |writers| threads hammer one endpoint while we drain the other;
+// total work is fixed so the curve over thread count isolates the cost
+// of contending on the channel, not of doing more work.
+void do_contention_test(uint32_t writers, uint32_t total_messages,
+                        uint32_t size) {
+    assert(writers >= 1 && writers <= 16);
+
+    mx_handle_t mp[2];
+    mx_status_t status = mx_channel_create(0u, &mp[0], &mp[1]);
+    assert(status == NO_ERROR);
+
+    ContendArgs args = {mp[0], total_messages / writers, size};
+    uint64_t expected = static_cast<uint64_t>(args.messages) * writers;
+
+    uint64_t start = now_ns();
+    thrd_t threads[16];
+    for (uint32_t i = 0; i < writers; i++) {
+        int ret = thrd_create(&threads[i], contend_writer_thread, &args);
+        assert(ret == thrd_success);
+    }
+
+    mxtl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+    uint64_t received = 0;
+    while (received < expected) {
+        uint32_t r_size = size;
+        uint32_t r_handles = 0;
+        status = mx_channel_read(mp[1], 0u, buffer.get(), nullptr, r_size, 0,
+                                 &r_size, &r_handles);
+        if (status == ERR_SHOULD_WAIT) {
+            mx_signals_t observed;
+            status = mx_object_wait_one(mp[1], MX_CHANNEL_READABLE,
+                                        MX_TIME_INFINITE, &observed);
+            assert(status == NO_ERROR);
+            continue;
+        }
+        assert(status == NO_ERROR);
+        received++;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    for (uint32_t i = 0; i < writers; i++)
+        thrd_join(threads[i], nullptr);
+    mx_handle_close(mp[0]);
+    mx_handle_close(mp[1]);
+
+    double msgs_per_s = static_cast<double>(received) /
+                        (static_cast<double>(elapsed) / 1000000000.0);
+    char params[32];
+    snprintf(params, sizeof(params), "writers=%u size=%u", writers, size);
+    report_rate("contention", params, "msgs/s", msgs_per_s);
+}
+
+void run_ipc_suite() {
+    static constexpr uint32_t kLatencyIterations = 10000;
+
+    do_call_test(64, kLatencyIterations);
+    do_call_test(1024, kLatencyIterations);
+
+    static constexpr uint32_t kWidths[] = {1, 8, 64};
+    for (size_t i = 0; i < countof(kWidths); i++) {
+        do_wakeup_test(false, kWidths[i], kLatencyIterations);
+        do_wakeup_test(true, kWidths[i], kLatencyIterations);
+    }
+
+    do_handle_scaling_test(2000);
+
+    static constexpr uint32_t kChunks[] = {64, 1024, 65536};
+    for (size_t i = 0; i < countof(kChunks); i++)
+        do_socket_test(kChunks[i], 64ull * 1024 * 1024);
+
+    static constexpr uint32_t kWriters[] = {1, 2, 4, 8};
+    for (size_t i = 0; i < countof(kWriters); i++)
+        do_contention_test(kWriters[i], 400000, 64);
 }
 
 }  // namespace
@@ -120,14 +563,19 @@ int main(int argc, char** argv) {
         "Options:\n"
         "  -h    show help (this)\n"
         "  -o    run single test (default)\n"
-        "  -s    run suite (ignores -S/-H/-Q)\n"
+        "  -s    run throughput suite (ignores -S/-H/-Q)\n"
+        "  -i    run IPC suite: call latency percentiles, port vs\n"
+        "        wait-many wakeups, handle-transfer scaling, socket\n"
+        "        bandwidth, multi-writer contention (ignores -S/-H/-Q)\n"
+        "  -c    also emit one CSV line per result\n"
         "  -n N  set test repetition count to N (default: 1)\n"
         "  -d N  set test duration to N seconds (default: 5)\n"
         "  -S N  set message size to N bytes (default: 10)\n"
         "  -H N  set message handle count to N handles (default: 0)\n"
         "  -Q N  set message pre-queue count to N messages (default: 0)\n";
 
-    bool run_suite = false;  // -o/-s
+    bool run_suite = false;      // -o/-s
+    bool run_ipc_tests = false;  // -i
     uint32_t duration = 5;   // -d
     uint32_t repeats = 1;    // -n
     // Ignored when running a suite:
@@ -138,7 +586,7 @@ int main(int argc, char** argv) {
     };
 
     int opt;
-    while ((opt = getopt(argc, argv, "+hosn:d:S:H:Q:")) != -1) {
+    while ((opt = getopt(argc, argv, "+hoscin:d:S:H:Q:")) != -1) {
         // Our option values are always unsigned numbers.
         uint32_t value = 0;
         if (optarg) {
@@ -160,6 +608,12 @@ int main(int argc, char** argv) {
             case 's':
                 run_suite = true;
                 break;
+            case 'i':
+                run_ipc_tests = true;
+                break;
+            case 'c':
+                output_csv = true;
+                break;
             case 'n':
                 assert(optarg);
                 repeats = value;
@@ -196,7 +650,9 @@ int main(int argc, char** argv) {
                    repeats);
         }
 
-        if (run_suite) {
+        if (run_ipc_tests) {
+            run_ipc_suite();
+        } else if (run_suite) {
             static constexpr TestArgs suite[] = {
                 {10, 0, 0},
                 {100, 0, 0},
@@ -6,10 +6,12 @@
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <hypervisor/guest.h>
 #include <magenta/boot/bootdata.h>
+#include <magenta/process.h>
 #include <magenta/syscalls.h>
 #include <magenta/syscalls/hypervisor.h>
 
@@ -70,6 +72,21 @@ static mx_status_t read_serial_fifo(mx_handle_t fifo) {
     return NO_ERROR;
 }
 
+// Service guest device output on its own thread, so that the vcpu loop
+// never blocks on host I/O between guest enters.
+static int serial_loop(void* arg) {
+    mx_handle_t fifo = (mx_handle_t)(uintptr_t)arg;
+    while (true) {
+        mx_status_t status = mx_object_wait_one(fifo, MX_FIFO_READABLE | MX_FIFO_PEER_CLOSED,
+                                                MX_TIME_INFINITE, NULL);
+        if (status != NO_ERROR)
+            return status;
+        status = read_serial_fifo(fifo);
+        if (status != NO_ERROR)
+            return status;
+    }
+}
+
 int main(int argc, char** argv) {
     if (argc != 2) {
         fprintf(stderr, "usage: %s <path to kernel.bin>\n", basename(argv[0]));
@@ -150,9 +167,53 @@ int main(int argc, char** argv) {
         return status;
     }
 
+    thrd_t serial_thread;
+    if (thrd_create(&serial_thread, serial_loop,
+                    (void*)(uintptr_t)guest_serial_fifo) != thrd_success) {
+        fprintf(stderr, "Failed to create serial thread\n");
+        return ERR_NO_RESOURCES;
+    }
+    thrd_detach(serial_thread);
+
+#if __x86_64__
+    // Share a vcpu state area with the kernel, so exits it does not emulate
+    // are serviced here out of shared memory instead of ending the run loop.
+    mx_vcpu_state_t* vcpu_state = NULL;
+    mx_handle_t vcpu_state_vmo;
+    status = mx_vmo_create(PAGE_SIZE, 0, &vcpu_state_vmo);
+    if (status != NO_ERROR) {
+        fprintf(stderr, "Failed to create vcpu state VMO\n");
+        return status;
+    }
+    uintptr_t vcpu_state_addr;
+    status = mx_vmar_map(mx_vmar_root_self(), 0, vcpu_state_vmo, 0, PAGE_SIZE,
+                         MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE, &vcpu_state_addr);
+    if (status != NO_ERROR) {
+        fprintf(stderr, "Failed to map vcpu state VMO\n");
+        return status;
+    }
+    status = mx_hypervisor_op(guest, MX_HYPERVISOR_OP_GUEST_SET_STATE_AREA,
+                              &vcpu_state_vmo, sizeof(vcpu_state_vmo), NULL, 0);
+    if (status != NO_ERROR) {
+        fprintf(stderr, "Failed to set guest vcpu state area\n");
+        return status;
+    }
+    vcpu_state = (mx_vcpu_state_t*)vcpu_state_addr;
+#endif // __x86_64__
+
     do {
         status = mx_hypervisor_op(guest, MX_HYPERVISOR_OP_GUEST_ENTER, NULL, 0, NULL, 0);
-        read_serial_fifo(guest_serial_fifo);
+#if __x86_64__
+        if (status == ERR_SHOULD_WAIT && vcpu_state != NULL) {
+            // No device models are attached yet, so accesses the kernel
+            // declines are skipped: step over the faulting instruction and
+            // resume. Device emulation slots in here, reading the exit
+            // state and registers directly from the state area.
+            vcpu_state->rip += vcpu_state->instruction_length;
+            vcpu_state->flags |= MX_VCPU_STATE_REGS_DIRTY;
+            status = NO_ERROR;
+        }
+#endif // __x86_64__
     } while(status == NO_ERROR);
     fprintf(stderr, "Failed to enter guest %d\n", status);
     return status;
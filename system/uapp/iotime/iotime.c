@@ -4,9 +4,11 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <magenta/syscalls.h>
@@ -249,12 +251,280 @@ int iotime_fread(int argc, char** argv) {
     return 0;
 }
 
+// Multi-queue fifo benchmark. Queue depth is modeled with one worker
+// thread per in-flight request, each on its own txnid (the fifo client
+// is thread-safe across distinct txnids), so up to <qdepth> requests
+// are outstanding at the block device at all times.
+
+#define MAX_QDEPTH 32
+
+typedef struct {
+    int fd;
+    fifo_client_t* client;
+    vmoid_t vmoid;
+    txnid_t txnids[MAX_QDEPTH];
+} fifo_dev_t;
+
+static int fifo_setup(fifo_dev_t* dev, const char* path, uint64_t total,
+                      uint64_t vmosz, bool writable) {
+    if (!strcmp(path, "--ramdisk")) {
+        if ((dev->fd = make_ramdisk(total)) < 0) {
+            fprintf(stderr, "error: cannot create %zu-byte ramdisk\n", total);
+            return -1;
+        }
+    } else {
+        if ((dev->fd = open(path, writable ? O_RDWR : O_RDONLY)) < 0) {
+            fprintf(stderr, "error: cannot open '%s'\n", path);
+            return -1;
+        }
+    }
+
+    mx_handle_t vmo;
+    if (mx_vmo_create(vmosz, 0, &vmo) != NO_ERROR) {
+        fprintf(stderr, "error: out of memory\n");
+        return -1;
+    }
+
+    mx_handle_t fifo;
+    if (ioctl_block_get_fifos(dev->fd, &fifo) != sizeof(fifo)) {
+        fprintf(stderr, "err: cannot get fifo for '%s'\n", path);
+        return -1;
+    }
+
+    for (unsigned n = 0; n < MAX_QDEPTH; n++) {
+        if (ioctl_block_alloc_txn(dev->fd, &dev->txnids[n]) != sizeof(txnid_t)) {
+            fprintf(stderr, "err: cannot allocate txn for '%s'\n", path);
+            return -1;
+        }
+    }
+
+    mx_handle_t dup;
+    if (mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &dup) != NO_ERROR) {
+        fprintf(stderr, "error: cannot duplicate handle\n");
+        return -1;
+    }
+
+    if (ioctl_block_attach_vmo(dev->fd, &dup, &dev->vmoid) != sizeof(vmoid_t)) {
+        fprintf(stderr, "error: cannot attach vmo for '%s'\n", path);
+        return -1;
+    }
+
+    if (block_fifo_create_client(fifo, &dev->client) != NO_ERROR) {
+        fprintf(stderr, "err: cannot create block client for '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    fifo_client_t* client;
+    txnid_t txnid;
+    vmoid_t vmoid;
+    uint64_t vmo_offset;
+    uint64_t bsize;
+    uint64_t ops;
+    uint64_t dev_start;
+    uint64_t dev_blocks;  // random span in blocks; 0 means sequential
+    bool is_write;
+    uint64_t seed;
+    uint64_t* lat_ns;
+    int result;
+} bench_worker_t;
+
+static int bench_worker(void* arg) {
+    bench_worker_t* w = arg;
+    uint64_t rng = w->seed;
+    for (uint64_t i = 0; i < w->ops; i++) {
+        uint64_t dev_offset;
+        if (w->dev_blocks) {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            dev_offset = ((rng >> 16) % w->dev_blocks) * w->bsize;
+        } else {
+            dev_offset = w->dev_start + i * w->bsize;
+        }
+        block_fifo_request_t request = {
+            .txnid = w->txnid,
+            .vmoid = w->vmoid,
+            .opcode = w->is_write ? BLOCKIO_WRITE : BLOCKIO_READ,
+            .length = w->bsize,
+            .vmo_offset = w->vmo_offset,
+            .dev_offset = dev_offset,
+        };
+        mx_time_t t0 = mx_time_get(MX_CLOCK_MONOTONIC);
+        if (block_fifo_txn(w->client, &request, 1) != NO_ERROR) {
+            fprintf(stderr, "error: block_fifo_txn error\n");
+            w->result = -1;
+            return -1;
+        }
+        w->lat_ns[i] = mx_time_get(MX_CLOCK_MONOTONIC) - t0;
+    }
+    w->result = 0;
+    return 0;
+}
+
+static int cmp_lat(const void* a, const void* b) {
+    uint64_t va = *(const uint64_t*)a;
+    uint64_t vb = *(const uint64_t*)b;
+    return (va < vb) ? -1 : (va > vb) ? 1 : 0;
+}
+
+static int run_config(fifo_dev_t* dev, uint64_t total, uint64_t bsize,
+                      uint32_t qdepth, bool is_random, bool is_write) {
+    uint64_t per_worker = (total / bsize) / qdepth;
+    if (per_worker == 0) {
+        fprintf(stderr, "error: too few blocks for bs=%zu qd=%u\n",
+                bsize, qdepth);
+        return -1;
+    }
+    uint64_t total_ops = per_worker * qdepth;
+
+    uint64_t* lat_ns = malloc(total_ops * sizeof(uint64_t));
+    if (lat_ns == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return -1;
+    }
+
+    bench_worker_t workers[MAX_QDEPTH];
+    thrd_t threads[MAX_QDEPTH];
+    mx_time_t t0 = mx_time_get(MX_CLOCK_MONOTONIC);
+    for (uint32_t n = 0; n < qdepth; n++) {
+        workers[n] = (bench_worker_t){
+            .client = dev->client,
+            .txnid = dev->txnids[n],
+            .vmoid = dev->vmoid,
+            .vmo_offset = n * bsize,
+            .bsize = bsize,
+            .ops = per_worker,
+            // Sequential workers split the span fio-style; random workers
+            // pick offsets anywhere in it from a fixed per-worker seed.
+            .dev_start = n * per_worker * bsize,
+            .dev_blocks = is_random ? (total / bsize) : 0,
+            .is_write = is_write,
+            .seed = 0x853c49e6748fea9bULL + n,
+            .lat_ns = lat_ns + n * per_worker,
+            .result = -1,
+        };
+        if (thrd_create(&threads[n], bench_worker, &workers[n]) != thrd_success) {
+            fprintf(stderr, "error: cannot create worker thread\n");
+            return -1;
+        }
+    }
+    int result = 0;
+    for (uint32_t n = 0; n < qdepth; n++) {
+        thrd_join(threads[n], NULL);
+        if (workers[n].result != 0) {
+            result = -1;
+        }
+    }
+    mx_time_t t1 = mx_time_get(MX_CLOCK_MONOTONIC);
+    if (result != 0) {
+        free(lat_ns);
+        return -1;
+    }
+
+    qsort(lat_ns, total_ops, sizeof(uint64_t), cmp_lat);
+    uint64_t iops = (total_ops * 1000000000ULL) / (t1 - t0);
+    fprintf(stderr, "%s-%s bs=%zu qd=%u: %zu ops in %zu ns: %zu IOPS, ",
+            is_random ? "rand" : "seq", is_write ? "write" : "read",
+            bsize, qdepth, total_ops, t1 - t0, iops);
+    bytes_per_second(total_ops * bsize, t1 - t0);
+    fprintf(stderr, "    latency ns: p50 %zu p90 %zu p99 %zu p999 %zu max %zu\n",
+            lat_ns[total_ops / 2], lat_ns[(total_ops * 9) / 10],
+            lat_ns[(total_ops * 99) / 100], lat_ns[(total_ops * 999) / 1000],
+            lat_ns[total_ops - 1]);
+    free(lat_ns);
+    return 0;
+}
+
+int iotime_fbench(int argc, char** argv) {
+    if (argc != 7) {
+        return usage();
+    }
+    uint64_t total = number(argv[3]);
+    uint64_t bsize = number(argv[4]);
+    uint64_t qdepth = number(argv[5]);
+    bool is_random;
+    bool is_write;
+    if (!strcmp(argv[6], "sr")) {
+        is_random = false;
+        is_write = false;
+    } else if (!strcmp(argv[6], "rr")) {
+        is_random = true;
+        is_write = false;
+    } else if (!strcmp(argv[6], "sw")) {
+        is_random = false;
+        is_write = true;
+    } else if (!strcmp(argv[6], "rw")) {
+        is_random = true;
+        is_write = true;
+    } else {
+        return usage();
+    }
+    if ((total % 4096) || (bsize % 4096)) {
+        fprintf(stderr, "error: total and block size must be multiples of 4K\n");
+        return -1;
+    }
+    if ((qdepth < 1) || (qdepth > MAX_QDEPTH)) {
+        fprintf(stderr, "error: queue depth must be 1..%u\n", MAX_QDEPTH);
+        return -1;
+    }
+
+    fifo_dev_t dev;
+    if (fifo_setup(&dev, argv[2], total, qdepth * bsize, is_write) < 0) {
+        return -1;
+    }
+    return run_config(&dev, total, bsize, (uint32_t)qdepth, is_random, is_write);
+}
+
+int iotime_fsweep(int argc, char** argv) {
+    if (argc != 4) {
+        return usage();
+    }
+    uint64_t total = number(argv[3]);
+    if (total % 4096) {
+        fprintf(stderr, "error: total must be a multiple of 4K\n");
+        return -1;
+    }
+
+    static const uint64_t bsizes[] = {4096, 32768, 131072};
+    static const uint32_t qdepths[] = {1, 4, 16, 32};
+
+    // Writes would trash a real device, so the sweep only includes them
+    // on a freshly-made ramdisk. Use fbench for explicit write runs.
+    bool is_ramdisk = !strcmp(argv[2], "--ramdisk");
+
+    fifo_dev_t dev;
+    if (fifo_setup(&dev, argv[2], total, MAX_QDEPTH * bsizes[2], is_ramdisk) < 0) {
+        return -1;
+    }
+
+    for (unsigned p = 0; p < (is_ramdisk ? 4u : 2u); p++) {
+        bool is_random = p & 1;
+        bool is_write = p & 2;
+        for (unsigned b = 0; b < sizeof(bsizes) / sizeof(bsizes[0]); b++) {
+            for (unsigned q = 0; q < sizeof(qdepths) / sizeof(qdepths[0]); q++) {
+                if (run_config(&dev, total, bsizes[b], qdepths[q],
+                               is_random, is_write) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
 int usage(void) {
     fprintf(stderr,
             "usage: iotime <op>...\n\n"
             "   op: lread <device> <bytes> <bufsize>   posix linear read\n"
             "       bread <device> <bytes> <bufsize>   block linear read\n"
-            "       fread <device> <bytes> <bufsize>   fifo linear read\n");
+            "       fread <device> <bytes> <bufsize>   fifo linear read\n"
+            "       fbench <device> <bytes> <bsize> <qdepth> <sr|rr|sw|rw>\n"
+            "                                          fifo benchmark, one config\n"
+            "       fsweep <device> <bytes>            fifo benchmark sweep over\n"
+            "                                          block size and queue depth\n"
+            "\n"
+            "   <device> may be --ramdisk to run against a new ramdisk\n");
     return -1;
 }
 
@@ -269,6 +539,10 @@ int main(int argc, char** argv) {
         return iotime_bread(argc, argv);
     } else if (!strcmp(argv[1], "fread")) {
         return iotime_fread(argc, argv);
+    } else if (!strcmp(argv[1], "fbench")) {
+        return iotime_fbench(argc, argv);
+    } else if (!strcmp(argv[1], "fsweep")) {
+        return iotime_fsweep(argc, argv);
     } else {
         return usage();
     }
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <fs/trace.h>
@@ -32,6 +33,20 @@ mx_status_t Bcache::Readblk(uint32_t bno, void* data) {
     return NO_ERROR;
 }
 
+mx_status_t Bcache::ReadRun(uint32_t bno, uint32_t count, void* data) {
+    off_t off = bno * kMinfsBlockSize;
+    trace(IO, "readrun() bno=%u count=%u\n", bno, count);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("minfs: cannot seek to block %u\n", bno);
+        return ERR_IO;
+    }
+    if (read(fd_, data, count * kMinfsBlockSize) != (ssize_t)(count * kMinfsBlockSize)) {
+        error("minfs: cannot read %u blocks at %u\n", count, bno);
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
 mx_status_t Bcache::Writeblk(uint32_t bno, const void* data) {
     off_t off = bno * kMinfsBlockSize;
     trace(IO, "writeblk() bno=%u off=%#llx\n", bno, (unsigned long long)off);
@@ -60,6 +75,7 @@ static const char* modestr(uint32_t mode) {
 }
 
 void Bcache::Invalidate() {
+    Flush();
     mxtl::RefPtr<BlockNode> blk;
     uint32_t n = 0;
     while ((blk = lists_.PopFront(kBlockLRU)) != nullptr) {
@@ -84,7 +100,7 @@ mxtl::RefPtr<BlockNode> Bcache::Get(uint32_t bno, uint32_t mode) {
         assert(!(blk->flags_ & kBlockBusy));
         lists_.Erase(blk, kBlockLRU);
         if (mode == kModeZero) {
-            blk->flags_ |= kBlockDirty;
+            SetDirty(blk);
             memset(blk->data(), 0, blocksize_);
         }
         goto done;
@@ -95,6 +111,14 @@ mxtl::RefPtr<BlockNode> Bcache::Get(uint32_t bno, uint32_t mode) {
         if ((blk = lists_.PopFront(kBlockFree)) != nullptr) {
             // nothing extra to do
         } else if ((blk = lists_.PopFront(kBlockLRU)) != nullptr) {
+            // write back before the block is reassigned
+            if (blk->flags_ & kBlockDirty) {
+                if (Writeblk(blk->bno_, blk->data()) < 0) {
+                    panic("bcache: bno %u write error!\n", blk->bno_);
+                }
+                blk->flags_ &= ~kBlockDirty;
+                dirty_count_--;
+            }
             // remove from hash, bno to be reassigned
             hash_.erase(*blk);
         } else {
@@ -104,7 +128,7 @@ mxtl::RefPtr<BlockNode> Bcache::Get(uint32_t bno, uint32_t mode) {
         hash_.insert(blk);
         assert(hash_.size() <= kMinfsBlockCacheSize);
         if (mode == kModeZero) {
-            blk->flags_ |= kBlockDirty;
+            SetDirty(blk);
             memset(blk->data(), 0, blocksize_);
         } else if (Readblk(bno, blk->data()) < 0) {
             panic("bcache: bno %u read error!\n", bno);
@@ -126,18 +150,184 @@ mxtl::RefPtr<BlockNode> Bcache::GetZero(uint32_t bno) {
     return Get(bno, kModeZero);
 }
 
+void Bcache::SetDirty(const mxtl::RefPtr<BlockNode>& blk) {
+    if (!(blk->flags_ & kBlockDirty)) {
+        blk->flags_ |= kBlockDirty;
+        dirty_count_++;
+    }
+}
+
 void Bcache::Put(mxtl::RefPtr<BlockNode> blk, uint32_t flags) {
     trace(BCACHE, "bcache_put() bno=%u%s\n", blk->bno_, (flags & kBlockDirty) ? " DIRTY" : "");
     assert(blk->flags_ & kBlockBusy);
     // remove from busy list
     lists_.Erase(blk, kBlockBusy);
-    if ((flags | blk->flags_) & kBlockDirty) {
-        if (Writeblk(blk->bno_, blk->data()) < 0) {
-            error("block write error!\n");
-        }
-        blk->flags_ &= ~kBlockDirty;
+    if (flags & kBlockDirty) {
+        SetDirty(blk);
     }
     lists_.PushBack(mxtl::move(blk), kBlockLRU);
+    // Dirty blocks stay in the cache so that repeated updates to the same
+    // metadata blocks (bitmaps, inode table, dirents) are absorbed, but
+    // bound how much unwritten data can accumulate.
+    if (dirty_count_ >= kMinfsDirtyCacheMax) {
+        Flush();
+    }
+}
+
+mx_status_t Bcache::WriteRun(BlockNode** blks, uint32_t count) {
+    off_t off = blks[0]->bno_ * kMinfsBlockSize;
+    trace(IO, "writerun() bno=%u count=%u\n", blks[0]->bno_, count);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("minfs: cannot seek to block %u\n", blks[0]->bno_);
+        return ERR_IO;
+    }
+    struct iovec iov[kMinfsBlockCacheSize];
+    for (uint32_t i = 0; i < count; i++) {
+        iov[i].iov_base = blks[i]->data();
+        iov[i].iov_len = kMinfsBlockSize;
+    }
+    if (writev(fd_, iov, count) != (ssize_t)(count * kMinfsBlockSize)) {
+        error("minfs: cannot write %u blocks at %u\n", count, blks[0]->bno_);
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
+// Continue an FNV-1a hash over another buffer.
+static uint32_t jnl_checksum(uint32_t hash, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len-- > 0) {
+        hash = (hash ^ (*p++)) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+mx_status_t Bcache::JournalWrite(BlockNode** blks, uint32_t count) {
+    assert(count <= jnl_len_ - 1);
+    trace(IO, "jnlwrite() seq=%llu count=%u\n",
+          (unsigned long long)(jnl_seq_ + 1), count);
+    // data blocks first...
+    uint32_t checksum = FNV32_OFFSET_BASIS;
+    for (uint32_t i = 0; i < count; i++) {
+        if (Writeblk(jnl_start_ + 1 + i, blks[i]->data()) != NO_ERROR) {
+            return ERR_IO;
+        }
+        checksum = jnl_checksum(checksum, &blks[i]->bno_, sizeof(blks[i]->bno_));
+        checksum = jnl_checksum(checksum, blks[i]->data(), kMinfsBlockSize);
+    }
+    // ...then the header which commits them
+    char data[kMinfsBlockSize];
+    memset(data, 0, sizeof(data));
+    minfs_jnl_header_t* hdr = reinterpret_cast<minfs_jnl_header_t*>(data);
+    hdr->magic = kMinfsJournalMagic;
+    hdr->seq = ++jnl_seq_;
+    hdr->count = count;
+    hdr->checksum = checksum;
+    for (uint32_t i = 0; i < count; i++) {
+        hdr->target_bno[i] = blks[i]->bno_;
+    }
+    if (Writeblk(jnl_start_, data) != NO_ERROR) {
+        return ERR_IO;
+    }
+    // the transaction must be durable before any in-place write lands
+    if (fsync(fd_) < 0) {
+        error("minfs: cannot sync journal\n");
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::Flush() {
+    if (dirty_count_ == 0) {
+        return NO_ERROR;
+    }
+    BlockNode* dirty[kMinfsBlockCacheSize];
+    uint32_t n = lists_.CollectDirty(dirty, kMinfsBlockCacheSize);
+    trace(BCACHE, "bcache_flush() %u dirty\n", n);
+    return FlushList(dirty, n);
+}
+
+mx_status_t Bcache::FlushBlocks(const uint32_t* bnos, uint32_t count) {
+    if (dirty_count_ == 0) {
+        return NO_ERROR;
+    }
+    BlockNode* dirty[kMinfsBlockCacheSize];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        mxtl::RefPtr<BlockNode> blk = hash_.find(bnos[i]).CopyPointer();
+        if ((blk == nullptr) || !(blk->flags_ & kBlockDirty) ||
+            (blk->flags_ & kBlockBusy)) {
+            // not cached, already clean, or held between Get() and Put()
+            // (busy blocks are written back when they are Put)
+            continue;
+        }
+        // skip duplicate bnos in the caller's list
+        uint32_t j = 0;
+        while ((j < n) && (dirty[j] != blk.get())) {
+            j++;
+        }
+        if (j == n) {
+            dirty[n++] = blk.get();
+        }
+    }
+    if (n == 0) {
+        return NO_ERROR;
+    }
+    trace(BCACHE, "bcache_flush_blocks() %u dirty of %u requested\n", n, count);
+    return FlushList(dirty, n);
+}
+
+mx_status_t Bcache::FlushList(BlockNode** dirty, uint32_t n) {
+    // Sort by block number so physically-adjacent blocks coalesce into
+    // ranged writes (insertion sort; the cache holds at most
+    // kMinfsBlockCacheSize blocks).
+    for (uint32_t i = 1; i < n; i++) {
+        BlockNode* tmp = dirty[i];
+        uint32_t j = i;
+        while ((j > 0) && (dirty[j - 1]->bno_ > tmp->bno_)) {
+            dirty[j] = dirty[j - 1];
+            j--;
+        }
+        dirty[j] = tmp;
+    }
+
+    mx_status_t status = NO_ERROR;
+    uint32_t base = 0;
+    while (base < n) {
+        // with a journal, a batch may not exceed one transaction
+        uint32_t chunk = n - base;
+        if ((jnl_len_ != 0) && (chunk > jnl_len_ - 1)) {
+            chunk = jnl_len_ - 1;
+        }
+        if (jnl_len_ != 0) {
+            mx_status_t r = JournalWrite(&dirty[base], chunk);
+            if (r != NO_ERROR) {
+                // leave the remaining blocks dirty; a later Flush retries
+                return r;
+            }
+        }
+        uint32_t i = base;
+        while (i < base + chunk) {
+            uint32_t run = 1;
+            while ((i + run < base + chunk) &&
+                   (dirty[i + run]->bno_ == dirty[i]->bno_ + run)) {
+                run++;
+            }
+            mx_status_t r = WriteRun(&dirty[i], run);
+            if (r != NO_ERROR) {
+                // leave the blocks dirty so a later Flush can retry
+                status = r;
+            } else {
+                for (uint32_t j = i; j < i + run; j++) {
+                    dirty[j]->flags_ &= ~kBlockDirty;
+                    dirty_count_--;
+                }
+            }
+            i += run;
+        }
+        base += chunk;
+    }
+    return status;
 }
 
 mx_status_t Bcache::Read(uint32_t bno, void* data, uint32_t off, uint32_t len) {
@@ -173,6 +363,16 @@ mx_status_t Bcache::Write(uint32_t bno, const void* data, uint32_t off, uint32_t
 }
 
 int Bcache::Sync() {
+    if (Flush() != NO_ERROR) {
+        return -1;
+    }
+    return fsync(fd_);
+}
+
+int Bcache::SyncBlocks(const uint32_t* bnos, uint32_t count) {
+    if (FlushBlocks(bnos, count) != NO_ERROR) {
+        return -1;
+    }
     return fsync(fd_);
 }
 
@@ -195,11 +395,13 @@ mx_status_t Bcache::Create(Bcache** out, int fd, uint32_t blockmax, uint32_t blo
 }
 
 int Bcache::Close() {
+    Flush();
     return close(fd_);
 }
 
 Bcache::Bcache(int fd, uint32_t blockmax, uint32_t blocksize) :
-    fd_(fd), blockmax_(blockmax), blocksize_(blocksize) {}
+    fd_(fd), blockmax_(blockmax), blocksize_(blocksize), dirty_count_(0),
+    jnl_start_(0), jnl_len_(0), jnl_seq_(0) {}
 Bcache::~Bcache() {}
 
 size_t BcacheLists::SizeAllSlow() const {
@@ -234,6 +436,20 @@ mxtl::RefPtr<BlockNode> BcacheLists::Erase(mxtl::RefPtr<BlockNode> blk, uint32_t
     return ptr;
 }
 
+uint32_t BcacheLists::CollectDirty(BlockNode** out, uint32_t max) {
+    uint32_t n = 0;
+    for (auto& blk : list_lru_) {
+        if (!(blk.flags_ & kBlockDirty)) {
+            continue;
+        }
+        if (n == max) {
+            break;
+        }
+        out[n++] = &blk;
+    }
+    return n;
+}
+
 BcacheLists::LinkedList* BcacheLists::GetList(uint32_t block_type) {
     switch (block_type) {
         case kBlockBusy : return &list_busy_;
@@ -214,17 +214,31 @@ mx_status_t VnodeMinfs::BlocksShrink(uint32_t start) {
 }
 
 #ifdef __Fuchsia__
-// Read data from disk at block 'bno', into the 'nth' logical block of the file.
-mx_status_t VnodeMinfs::FillBlock(uint32_t n, uint32_t bno) {
+// Read 'count' physically-consecutive blocks starting at disk block 'bno'
+// into the logical blocks [n, n + count) of the file.
+mx_status_t VnodeMinfs::FillBlockRun(uint32_t n, uint32_t bno, uint32_t count) {
     // TODO(smklein): read directly from block device into vmo; no need to copy
     // into an intermediate buffer.
-    char bdata[kMinfsBlockSize];
-    if (fs_->bc_->Readblk(bno, bdata)) {
-        return ERR_IO;
+    constexpr uint32_t kFillRunChunk = 8; // 64K bounce buffer
+    mxtl::unique_free_ptr<char> bdata(
+        static_cast<char*>(malloc(kFillRunChunk * kMinfsBlockSize)));
+    if (bdata == nullptr) {
+        return ERR_NO_MEMORY;
     }
-    mx_status_t status = vmo_write_exact(vmo_, bdata, n * kMinfsBlockSize, kMinfsBlockSize);
-    if (status != NO_ERROR) {
-        return status;
+    while (count > 0) {
+        uint32_t c = (count < kFillRunChunk) ? count : kFillRunChunk;
+        if (fs_->bc_->ReadRun(bno, c, bdata.get())) {
+            return ERR_IO;
+        }
+        mx_status_t status = vmo_write_exact(vmo_, bdata.get(),
+                                             (uint64_t)n * kMinfsBlockSize,
+                                             c * kMinfsBlockSize);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        n += c;
+        bno += c;
+        count -= c;
     }
     return NO_ERROR;
 }
@@ -247,40 +261,23 @@ mx_status_t VnodeMinfs::InitVmo() {
         return status;
     }
 
-    // Initialize all direct blocks
-    uint32_t bno;
-    for (uint32_t d = 0; d < kMinfsDirect; d++) {
-        if ((bno = inode_.dnum[d]) != 0) {
-            if ((status = FillBlock(d, bno)) != NO_ERROR) {
-                error("Failed to fill bno %u; error: %d\n", bno, status);
-                return status;
-            }
+    // Fill the VMO in extent-sized transfers: each physically-contiguous
+    // run of blocks becomes a single ranged read, and holes are skipped
+    // entirely (the VMO starts zeroed).
+    uint32_t blocks = static_cast<uint32_t>(mxtl::roundup(inode_.size, kMinfsBlockSize)
+                                            / kMinfsBlockSize);
+    uint32_t n = 0;
+    while (n < blocks) {
+        uint32_t bno;
+        uint32_t count;
+        if ((status = GetBnoRun(n, &bno, &count, blocks - n)) != NO_ERROR) {
+            return status;
         }
-    }
-
-    // Initialize all indirect blocks
-    for (uint32_t i = 0; i < kMinfsIndirect; i++) {
-        uint32_t ibno;
-        mxtl::RefPtr<BlockNode> iblk;
-        if ((ibno = inode_.inum[i]) != 0) {
-            // TODO(smklein): Should there be a separate vmo for indirect blocks?
-            if ((iblk = fs_->bc_->Get(ibno)) == nullptr) {
-                return ERR_IO;
-            }
-            uint32_t* ientry = static_cast<uint32_t*>(iblk->data());
-
-            const uint32_t direct_per_indirect = kMinfsBlockSize / sizeof(uint32_t);
-            for (uint32_t j = 0; j < direct_per_indirect; j++) {
-                if ((bno = ientry[j]) != 0) {
-                    uint32_t n = kMinfsDirect + i * direct_per_indirect + j;
-                    if ((status = FillBlock(n, bno)) != NO_ERROR) {
-                        fs_->bc_->Put(iblk, 0);
-                        return status;
-                    }
-                }
-            }
-            fs_->bc_->Put(iblk, 0);
+        if ((bno != 0) && ((status = FillBlockRun(n, bno, count)) != NO_ERROR)) {
+            error("Failed to fill bno %u; error: %d\n", bno, status);
+            return status;
         }
+        n += count;
     }
 
     return NO_ERROR;
@@ -288,6 +285,61 @@ mx_status_t VnodeMinfs::InitVmo() {
 #endif
 
 // Get the bno corresponding to the nth logical block within the file.
+// Resolve the extent of file blocks beginning at logical block 'n': *bno
+// receives the disk block backing 'n' (0 if unallocated) and *count the
+// number of logical blocks, up to 'max', sharing that extent -- either
+// physically-consecutive allocated blocks or a run of holes. One indirect
+// block fetch covers up to 2048 mapping entries, where per-block GetBno
+// fetches it once per block. Runs never cross a direct/indirect region
+// boundary; callers iterate.
+mx_status_t VnodeMinfs::GetBnoRun(uint32_t n, uint32_t* bno, uint32_t* count,
+                                  uint32_t max) {
+    assert(max > 0);
+    if (n < kMinfsDirect) {
+        *bno = inode_.dnum[n];
+        uint32_t c = 1;
+        while ((c < max) && (n + c < kMinfsDirect)) {
+            uint32_t next = inode_.dnum[n + c];
+            if ((*bno == 0) ? (next != 0) : (next != *bno + c)) {
+                break;
+            }
+            c++;
+        }
+        *count = c;
+        return NO_ERROR;
+    }
+    const uint32_t direct_per_indirect = kMinfsBlockSize / sizeof(uint32_t);
+    uint32_t i = (n - kMinfsDirect) / direct_per_indirect;
+    uint32_t j = (n - kMinfsDirect) % direct_per_indirect;
+    if (i >= kMinfsIndirect) {
+        return ERR_OUT_OF_RANGE;
+    }
+    if (inode_.inum[i] == 0) {
+        // a whole indirect block's worth of holes
+        uint32_t c = direct_per_indirect - j;
+        *bno = 0;
+        *count = (c < max) ? c : max;
+        return NO_ERROR;
+    }
+    mxtl::RefPtr<BlockNode> iblk = fs_->bc_->Get(inode_.inum[i]);
+    if (iblk == nullptr) {
+        return ERR_IO;
+    }
+    uint32_t* ientry = static_cast<uint32_t*>(iblk->data());
+    *bno = ientry[j];
+    uint32_t c = 1;
+    while ((c < max) && (j + c < direct_per_indirect)) {
+        uint32_t next = ientry[j + c];
+        if ((*bno == 0) ? (next != 0) : (next != *bno + c)) {
+            break;
+        }
+        c++;
+    }
+    fs_->bc_->Put(iblk, 0);
+    *count = c;
+    return NO_ERROR;
+}
+
 mx_status_t VnodeMinfs::GetBno(uint32_t n, uint32_t* bno, bool alloc) {
     uint32_t hint = 0;
     // direct blocks are simple... is there an entry in dnum[]?
@@ -418,18 +470,151 @@ static mx_status_t do_next_dirent(minfs_dirent_t* de, DirectoryOffset* offs) {
     return DIR_CB_NEXT;
 }
 
-static mx_status_t cb_dir_find(mxtl::RefPtr<VnodeMinfs> vndir, minfs_dirent_t* de, DirArgs* args,
-                               DirectoryOffset* offs) {
-    if ((de->ino != 0) && (de->namelen == args->len) &&
-        (!memcmp(de->name, args->name, args->len))) {
-        args->ino = de->ino;
-        args->type = de->type;
-        return DIR_CB_DONE;
-    } else {
-        return do_next_dirent(de, offs);
+DirIndex::~DirIndex() {
+    Reset();
+}
+
+void DirIndex::Reset() {
+    for (size_t i = 0; i < kDirIndexBuckets; i++) {
+        buckets_[i].clear();
+    }
+    ready_ = false;
+}
+
+bool DirIndex::Lookup(const char* name, size_t len, size_t* off_out) const {
+    auto iter = buckets_[Bucket(name, len)].find_if([name, len](const Entry& e) {
+        return (e.namelen == len) && !memcmp(e.name, name, len);
+    });
+    if (!iter.IsValid()) {
+        return false;
+    }
+    *off_out = iter->off;
+    return true;
+}
+
+mx_status_t DirIndex::Insert(const char* name, size_t len, size_t off) {
+    size_t b = Bucket(name, len);
+    auto iter = buckets_[b].find_if([name, len](const Entry& e) {
+        return (e.namelen == len) && !memcmp(e.name, name, len);
+    });
+    if (iter.IsValid()) {
+        iter->off = off;
+        return NO_ERROR;
+    }
+    AllocChecker ac;
+    mxtl::unique_ptr<Entry> e(new (&ac) Entry);
+    if (!ac.check()) {
+        return ERR_NO_MEMORY;
+    }
+    e->off = off;
+    e->namelen = static_cast<uint8_t>(len);
+    memcpy(e->name, name, len);
+    e->name[len] = 0;
+    buckets_[b].push_front(mxtl::move(e));
+    return NO_ERROR;
+}
+
+void DirIndex::Remove(const char* name, size_t len) {
+    buckets_[Bucket(name, len)].erase_if([name, len](const Entry& e) {
+        return (e.namelen == len) && !memcmp(e.name, name, len);
+    });
+}
+
+void VnodeMinfs::DirentAdded(const minfs_dirent_t* de, size_t off) {
+    if ((dir_index_ != nullptr) && dir_index_->ready() &&
+        (dir_index_->Insert(de->name, de->namelen, off) != NO_ERROR)) {
+        dir_index_->Reset();
     }
 }
 
+void VnodeMinfs::DirentRemoved(const minfs_dirent_t* de) {
+    if ((dir_index_ != nullptr) && dir_index_->ready()) {
+        dir_index_->Remove(de->name, de->namelen);
+    }
+}
+
+mx_status_t VnodeMinfs::FindDirent(DirArgs* args) {
+    char data[kMinfsMaxDirentSize];
+    minfs_dirent_t* de = (minfs_dirent_t*) data;
+    mx_status_t status;
+    size_t r;
+
+    if ((dir_index_ != nullptr) && dir_index_->ready()) {
+        size_t off;
+        if (!dir_index_->Lookup(args->name, args->len, &off)) {
+            return ERR_NOT_FOUND;
+        }
+        if ((status = ReadInternal(data, kMinfsMaxDirentSize, off, &r)) != NO_ERROR) {
+            return status;
+        } else if ((status = validate_dirent(de, r, off)) != NO_ERROR) {
+            return status;
+        }
+        if ((de->ino != 0) && (de->namelen == args->len) &&
+            !memcmp(de->name, args->name, args->len)) {
+            args->ino = de->ino;
+            args->type = de->type;
+            return NO_ERROR;
+        }
+        // The index disagrees with the disk; drop it and rescan.
+        dir_index_->Reset();
+    }
+
+    // Build the index (if this directory is large enough to deserve one)
+    // while performing the linear scan: the first search pays for a full
+    // pass, and every search afterwards becomes a hash lookup.
+    bool build = false;
+    if (inode_.dirent_count >= kMinfsDirIndexMinEntries) {
+        if (dir_index_ == nullptr) {
+            AllocChecker ac;
+            DirIndex* idx = new (&ac) DirIndex();
+            if (ac.check()) {
+                dir_index_.reset(idx);
+            }
+        }
+        build = (dir_index_ != nullptr);
+    }
+
+    mx_status_t result = ERR_NOT_FOUND;
+    size_t off = 0;
+    while (off + MINFS_DIRENT_SIZE < kMinfsMaxDirectorySize) {
+        if ((status = ReadInternal(data, kMinfsMaxDirentSize, off, &r)) != NO_ERROR) {
+            goto fail;
+        } else if ((status = validate_dirent(de, r, off)) != NO_ERROR) {
+            goto fail;
+        }
+        if (de->ino != 0) {
+            if ((result == ERR_NOT_FOUND) && (de->namelen == args->len) &&
+                !memcmp(de->name, args->name, args->len)) {
+                args->ino = de->ino;
+                args->type = de->type;
+                result = NO_ERROR;
+                if (!build) {
+                    break;
+                }
+            }
+            if (build && (dir_index_->Insert(de->name, de->namelen, off) != NO_ERROR)) {
+                // Out of memory: finish the search unindexed.
+                dir_index_->Reset();
+                build = false;
+                if (result == NO_ERROR) {
+                    break;
+                }
+            }
+        }
+        off += MinfsReclen(de, off);
+    }
+    if (build) {
+        dir_index_->SetReady();
+    }
+    return result;
+
+fail:
+    if (build) {
+        dir_index_->Reset();
+    }
+    return status;
+}
+
 bool VnodeMinfs::CanUnlink() const {
     // directories must be empty (dirent_count == 2)
     if (IsDirectory()) {
@@ -504,6 +689,10 @@ mx_status_t VnodeMinfs::UnlinkChild(mxtl::RefPtr<VnodeMinfs> childvn, minfs_dire
         TruncateInternal(off + MINFS_DIRENT_SIZE);
     }
 
+    // 'de' still carries the unlinked entry's name, even though its record
+    // has been erased above.
+    DirentRemoved(de);
+
     inode_.dirent_count--;
     // This effectively 'unlinks' the target node without deleting the direntry
     childvn->inode_.link_count--;
@@ -632,6 +821,7 @@ static mx_status_t add_dirent(mxtl::RefPtr<VnodeMinfs> vndir, minfs_dirent_t* de
     if (status != NO_ERROR) {
         return status;
     }
+    vndir->DirentAdded(de, off);
     vndir->inode_.dirent_count++;
     if (args->type == kMinfsTypeDir) {
         // Child directory has '..' which will point to parent directory
@@ -833,6 +1023,13 @@ ssize_t VnodeMinfs::Write(const void* data, size_t len, size_t off) {
 }
 
 // Internal write. Usable on directories.
+// Check whether a full block of incoming data is entirely zero; such a
+// write over an unallocated block can leave the hole in place.
+static bool block_is_zero(const void* data) {
+    static const char zeros[kMinfsBlockSize] = {};
+    return memcmp(data, zeros, kMinfsBlockSize) == 0;
+}
+
 mx_status_t VnodeMinfs::WriteInternal(const void* data, size_t len, size_t off, size_t* actual) {
     if (len == 0) {
         *actual = 0;
@@ -889,26 +1086,38 @@ mx_status_t VnodeMinfs::WriteInternal(const void* data, size_t len, size_t off,
         }
         const void* wdata = (xfer != kMinfsBlockSize) ? bdata : data;
         uint32_t bno;
-        if ((status = GetBno(n, &bno, true)) != NO_ERROR) {
+        // A whole block of zeros over an unallocated block keeps the
+        // hole: holes read back as zeros anyway, so skip the allocation
+        // and the disk write (preallocating writers emit these in bulk).
+        if ((xfer == kMinfsBlockSize) && block_is_zero(wdata)) {
+            if ((status = GetBno(n, &bno, false)) != NO_ERROR) {
+                return status;
+            }
+        } else if ((status = GetBno(n, &bno, true)) != NO_ERROR) {
             return status;
         }
-        assert(bno != 0);
-        if (fs_->bc_->Writeblk(bno, wdata)) {
+        if ((bno != 0) && fs_->bc_->Writeblk(bno, wdata)) {
             return ERR_IO;
         }
 #else
         uint32_t bno;
-        if ((status = GetBno(n, &bno, true)) != NO_ERROR) {
+        if ((xfer == kMinfsBlockSize) && block_is_zero(data)) {
+            // keep the hole; see above
+            if ((status = GetBno(n, &bno, false)) != NO_ERROR) {
+                goto done;
+            }
+        } else if ((status = GetBno(n, &bno, true)) != NO_ERROR) {
             goto done;
         }
-        assert(bno != 0);
-        char wdata[kMinfsBlockSize];
-        if (fs_->bc_->Readblk(bno, wdata)) {
-            return ERR_IO;
-        }
-        memcpy(wdata + adjust, data, xfer);
-        if (fs_->bc_->Writeblk(bno, wdata)) {
-            return ERR_IO;
+        if (bno != 0) {
+            char wdata[kMinfsBlockSize];
+            if (fs_->bc_->Readblk(bno, wdata)) {
+                return ERR_IO;
+            }
+            memcpy(wdata + adjust, data, xfer);
+            if (fs_->bc_->Writeblk(bno, wdata)) {
+                return ERR_IO;
+            }
         }
 #endif
 
@@ -962,7 +1171,7 @@ mx_status_t VnodeMinfs::LookupInternal(mxtl::RefPtr<fs::Vnode>* out, const char*
     args.name = name;
     args.len = len;
     mx_status_t status;
-    if ((status = ForEachDirent(&args, cb_dir_find)) < 0) {
+    if ((status = FindDirent(&args)) < 0) {
         return status;
     }
     mxtl::RefPtr<VnodeMinfs> vn;
@@ -1132,7 +1341,7 @@ mx_status_t VnodeMinfs::Create(mxtl::RefPtr<fs::Vnode>* out, const char* name, s
     args.len = len;
     // ensure file does not exist
     mx_status_t status;
-    if ((status = ForEachDirent(&args, cb_dir_find)) != ERR_NOT_FOUND) {
+    if ((status = FindDirent(&args)) != ERR_NOT_FOUND) {
         return ERR_ALREADY_EXISTS;
     }
 
@@ -1214,6 +1423,39 @@ mx_status_t VnodeMinfs::Unlink(const char* name, size_t len, bool must_be_dir) {
     return ForEachDirent(&args, cb_dir_unlink);
 }
 
+mx_status_t VnodeMinfs::FindSparse(bool data, size_t off, size_t* out) {
+    if (IsDirectory()) {
+        return ERR_NOT_SUPPORTED;
+    }
+    if (off >= inode_.size) {
+        return ERR_OUT_OF_RANGE;
+    }
+    uint32_t blocks = static_cast<uint32_t>(mxtl::roundup(inode_.size, kMinfsBlockSize)
+                                            / kMinfsBlockSize);
+    uint32_t n = static_cast<uint32_t>(off / kMinfsBlockSize);
+    while (n < blocks) {
+        uint32_t bno;
+        uint32_t count;
+        mx_status_t status = GetBnoRun(n, &bno, &count, blocks - n);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        if ((bno != 0) == data) {
+            // the first matching run may contain the starting offset
+            size_t pos = (size_t)n * kMinfsBlockSize;
+            *out = (pos < off) ? off : pos;
+            return NO_ERROR;
+        }
+        n += count;
+    }
+    if (!data) {
+        // the implicit hole at the end of the file
+        *out = inode_.size;
+        return NO_ERROR;
+    }
+    return ERR_OUT_OF_RANGE;
+}
+
 mx_status_t VnodeMinfs::Truncate(size_t len) {
     if (IsDirectory()) {
         return ERR_NOT_FILE;
@@ -1355,7 +1597,7 @@ mx_status_t VnodeMinfs::Rename(mxtl::RefPtr<fs::Vnode> _newdir, const char* oldn
     DirArgs args = DirArgs();
     args.name = oldname;
     args.len = oldlen;
-    if ((status = ForEachDirent(&args, cb_dir_find)) < 0) {
+    if ((status = FindDirent(&args)) < 0) {
         return status;
     } else if ((status = fs_->VnodeGet(&oldvn, args.ino)) < 0) {
         return status;
@@ -1442,7 +1684,7 @@ mx_status_t VnodeMinfs::Link(const char* name, size_t len, mxtl::RefPtr<fs::Vnod
     args.name = name;
     args.len = len;
     mx_status_t status;
-    if ((status = ForEachDirent(&args, cb_dir_find)) != ERR_NOT_FOUND) {
+    if ((status = FindDirent(&args)) != ERR_NOT_FOUND) {
         return (status == NO_ERROR) ? ERR_ALREADY_EXISTS : status;
     }
 
@@ -1464,6 +1706,92 @@ mx_status_t VnodeMinfs::Sync() {
     return fs_->bc_->Sync();
 }
 
+constexpr uint32_t kMinfsSyncRangeMax = 64;
+
+// Append bno to the list unless it is already present; returns false if
+// the list is full.
+static bool sync_range_add(uint32_t* list, uint32_t* n, uint32_t bno) {
+    for (uint32_t i = 0; i < *n; i++) {
+        if (list[i] == bno) {
+            return true;
+        }
+    }
+    if (*n == kMinfsSyncRangeMax) {
+        return false;
+    }
+    list[(*n)++] = bno;
+    return true;
+}
+
+mx_status_t VnodeMinfs::SyncRange(size_t off, size_t len) {
+    if (IsDirectory()) {
+        return Sync();
+    }
+    // File data and the inode table are written through to the device as
+    // they change; only the allocation bitmap and indirect blocks mapping
+    // the range still rest dirty in the block cache. Flush those, then
+    // sync the device, rather than writing back every dirty block in the
+    // filesystem.
+    if ((off >= inode_.size) || (len == 0)) {
+        // nothing in range; still make prior write-through writes durable
+        return fs_->bc_->SyncBlocks(nullptr, 0);
+    }
+    if (len > inode_.size - off) {
+        len = inode_.size - off;
+    }
+    uint32_t first = static_cast<uint32_t>(off / kMinfsBlockSize);
+    uint32_t last = static_cast<uint32_t>((off + len - 1) / kMinfsBlockSize);
+
+    uint32_t bnos[kMinfsSyncRangeMax];
+    uint32_t count = 0;
+    bool full = false;
+
+    // allocation bitmap blocks covering the data blocks in the range
+    uint32_t n = first;
+    while (n <= last) {
+        uint32_t bno;
+        uint32_t run;
+        mx_status_t status = GetBnoRun(n, &bno, &run, last - n + 1);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        if (bno != 0) {
+            // the run is physically consecutive, so its bitmap blocks are too
+            uint32_t abm_first = fs_->info_.abm_block + bno / kMinfsBlockBits;
+            uint32_t abm_last = fs_->info_.abm_block + (bno + run - 1) / kMinfsBlockBits;
+            for (uint32_t b = abm_first; b <= abm_last; b++) {
+                if (!sync_range_add(bnos, &count, b)) {
+                    full = true;
+                    break;
+                }
+            }
+        }
+        if (full) {
+            break;
+        }
+        n += run;
+    }
+
+    // indirect blocks mapping the range
+    if (!full && (last >= kMinfsDirect)) {
+        constexpr uint32_t kPerIndirect = kMinfsBlockSize / sizeof(uint32_t);
+        uint32_t ifirst = ((first > kMinfsDirect) ? (first - kMinfsDirect) : 0) / kPerIndirect;
+        uint32_t ilast = (last - kMinfsDirect) / kPerIndirect;
+        for (uint32_t i = ifirst; (i <= ilast) && (i < kMinfsIndirect); i++) {
+            if ((inode_.inum[i] != 0) && !sync_range_add(bnos, &count, inode_.inum[i])) {
+                full = true;
+                break;
+            }
+        }
+    }
+
+    if (full) {
+        // too fragmented to enumerate; fall back to a full sync
+        return Sync();
+    }
+    return fs_->bc_->SyncBlocks(bnos, count);
+}
+
 mx_status_t VnodeMinfs::AttachRemote(mx_handle_t h) {
     if (!IsDirectory() || IsDeletedDirectory()) {
         return ERR_NOT_DIR;
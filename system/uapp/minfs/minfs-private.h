@@ -31,6 +31,11 @@ constexpr uint32_t kMxFsSyncCtime   = (1<<1);
 
 constexpr uint32_t kMinfsBlockCacheSize = 64;
 
+// Limit on the number of dirty blocks the bcache may accumulate before
+// writing them back; bounds the amount of unflushed metadata outstanding
+// between Syncs.
+constexpr uint32_t kMinfsDirtyCacheMax = 16;
+
 // Used by fsck
 struct CheckMaps {
     RawBitmap checked_inodes;
@@ -99,6 +104,11 @@ private:
 #endif
     uint32_t abmblks_;
     uint32_t ibmblks_;
+    // Rotating allocation cursor: the bit after the most recently allocated
+    // block.  BlockNew() resumes its free-block search here when the caller
+    // has no better hint, rather than rescanning the (mostly allocated)
+    // front of the bitmap on every allocation.
+    size_t block_cursor_;
     RawBitmap inode_map_;
 #ifdef __Fuchsia__
     mxtl::unique_ptr<MappedVmo> inode_table_;
@@ -122,6 +132,56 @@ struct DirectoryOffset {
     size_t off_prev; // Offset in directory of previous record
 };
 
+// Directories with at least this many entries are worth indexing; smaller
+// ones are searched with the plain linear scan.
+constexpr uint32_t kMinfsDirIndexMinEntries = 128;
+
+// In-memory index mapping the names in a single directory to the offsets of
+// their dirents.
+//
+// The index is built lazily by FindDirent the first time a large directory
+// is searched, then kept in sync by the dirent create/unlink paths. Caching
+// offsets is safe because live dirents never move in place: appends fill
+// holes or extend the directory, and unlinks only coalesce the free records
+// surrounding them. The index is purely an acceleration structure; dropping
+// it (Reset) is always safe, and FindDirent falls back to the linear scan
+// whenever the index disagrees with the disk.
+class DirIndex {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(DirIndex);
+    DirIndex() {}
+    ~DirIndex();
+
+    // Only a fully-built index can answer negative lookups; a partial or
+    // reset one serves nothing.
+    bool ready() const { return ready_; }
+    void SetReady() { ready_ = true; }
+    // Drop all entries, returning to the unindexed state.
+    void Reset();
+
+    bool Lookup(const char* name, size_t len, size_t* off_out) const;
+    // Insert (or update) the offset recorded for 'name'. On allocation
+    // failure the caller must Reset the index: a ready index missing an
+    // entry would serve false negatives.
+    mx_status_t Insert(const char* name, size_t len, size_t off);
+    void Remove(const char* name, size_t len);
+
+private:
+    struct Entry : public mxtl::SinglyLinkedListable<mxtl::unique_ptr<Entry>> {
+        size_t off;
+        uint8_t namelen;
+        char name[kMinfsMaxNameSize + 1];
+    };
+
+    static constexpr size_t kDirIndexBuckets = 64;
+    static size_t Bucket(const char* name, size_t len) {
+        return fnv1a32(name, len) & (kDirIndexBuckets - 1);
+    }
+
+    mxtl::SinglyLinkedList<mxtl::unique_ptr<Entry>> buckets_[kDirIndexBuckets];
+    bool ready_ = false;
+};
+
 #define INO_HASH(ino) fnv1a_tiny(ino, kMinfsHashBits)
 
 constexpr uint32_t kMinfsFlagDeletedDirectory = 0x00010000;
@@ -145,6 +205,10 @@ public:
     static size_t GetHash(uint32_t key) { return INO_HASH(key); }
 
     mx_status_t UnlinkChild(mxtl::RefPtr<VnodeMinfs> child, minfs_dirent_t* de, DirectoryOffset* offs);
+    // Keep the directory index (if one has been built) in sync with a
+    // dirent that was just written at offset 'off' / erased.
+    void DirentAdded(const minfs_dirent_t* de, size_t off);
+    void DirentRemoved(const minfs_dirent_t* de);
     mx_status_t ReadInternal(void* data, size_t len, size_t off, size_t* actual);
     mx_status_t ReadExactInternal(void* data, size_t len, size_t off);
     mx_status_t WriteInternal(const void* data, size_t len, size_t off, size_t* actual);
@@ -182,18 +246,25 @@ private:
                        bool src_must_be_dir, bool dst_must_be_dir) final;
     mx_status_t Link(const char* name, size_t len, mxtl::RefPtr<fs::Vnode> target) final;
     mx_status_t Truncate(size_t len) final;
+    mx_status_t FindSparse(bool data, size_t off, size_t* out) final;
     mx_status_t Sync() final;
+    mx_status_t SyncRange(size_t off, size_t len) final;
     mx_status_t AttachRemote(mx_handle_t) final;
 
     mx_status_t InitVmo();
 
-    // Read data from disk at block 'bno', into the 'nth' logical block of the file.
-    mx_status_t FillBlock(uint32_t n, uint32_t bno);
+    // Read 'count' physically-consecutive blocks starting at disk block 'bno'
+    // into the logical blocks [n, n + count) of the file.
+    mx_status_t FillBlockRun(uint32_t n, uint32_t bno, uint32_t count);
 
     // Get the disk block 'bno' corresponding to the 'nth' logical block of the file.
     // Allocate the block if reqeusted.
     mx_status_t GetBno(uint32_t n, uint32_t* bno, bool alloc);
 
+    // Resolve the extent (run of physically-consecutive blocks, or run of
+    // holes) starting at the 'nth' logical block of the file.
+    mx_status_t GetBnoRun(uint32_t n, uint32_t* bno, uint32_t* count, uint32_t max);
+
     // Deletes all blocks (relateive to a file) from "start" (inclusive) to the end
     // of the file. Does not update mtime/atime.
     mx_status_t BlocksShrink(uint32_t start);
@@ -208,6 +279,15 @@ private:
                               mx_status_t (*func)(mxtl::RefPtr<VnodeMinfs>, minfs_dirent_t*, DirArgs*,
                                                   DirectoryOffset*));
 
+    // Find the dirent named by 'args', filling args->ino and args->type on
+    // success. Consults (and lazily builds) dir_index_ for large
+    // directories; small directories take the linear scan.
+    mx_status_t FindDirent(DirArgs* args);
+
+    // Name index over this directory's entries; allocated by FindDirent
+    // once the directory is large enough to warrant one.
+    mxtl::unique_ptr<DirIndex> dir_index_;
+
 #ifdef __Fuchsia__
     mx_status_t AddDispatcher(mx_handle_t h, vfs_iostate_t* cookie) final;
 
@@ -243,6 +323,9 @@ mx_status_t minfs_check(Bcache* bc);
 
 mx_status_t minfs_mount(mxtl::RefPtr<VnodeMinfs>* root_out, Bcache* bc);
 
+// replay any committed journal transaction (called during mount)
+mx_status_t minfs_replay_journal(Bcache* bc, const minfs_info_t* info);
+
 void minfs_dir_init(void* bdata, uint32_t ino_self, uint32_t ino_parent);
 
 } // namespace minfs
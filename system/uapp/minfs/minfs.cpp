@@ -37,6 +37,7 @@ void minfs_dump_info(minfs_info_t* info) {
     printf("minfs: inode bitmap @ %10u\n", info->ibm_block);
     printf("minfs: alloc bitmap @ %10u\n", info->abm_block);
     printf("minfs: inode table  @ %10u\n", info->ino_block);
+    printf("minfs: journal      @ %10u\n", info->jnl_block);
     printf("minfs: data blocks  @ %10u\n", info->dat_block);
 }
 
@@ -82,7 +83,7 @@ mx_status_t Minfs::InodeSync(uint32_t ino, const minfs_inode_t* inode) {
     return NO_ERROR;
 }
 
-Minfs::Minfs(Bcache* bc, minfs_info_t* info) : bc_(bc) {
+Minfs::Minfs(Bcache* bc, minfs_info_t* info) : bc_(bc), block_cursor_(0) {
     memcpy(&info_, info, sizeof(minfs_info_t));
 }
 
@@ -259,17 +260,21 @@ mx_status_t Minfs::VnodeGet(mxtl::RefPtr<VnodeMinfs>* out, uint32_t ino) {
 // Return the underlying block (obtained via Bcache::Get()), if 'out_block' is not nullptr.
 //
 // If hint is nonzero it indicates which block number to start the search for
-// free blocks from.
+// free blocks from.  If it is zero, the search resumes from the rotating
+// cursor (just past the last allocation), so back-to-back allocations do not
+// rescan the allocated front of the bitmap every time.
 mx_status_t Minfs::BlockNew(uint32_t hint, uint32_t* out_bno, mxtl::RefPtr<BlockNode> *out_block) {
+    size_t start = (hint != 0) ? hint : block_cursor_;
     size_t bitoff_start;
     mx_status_t status;
-    if ((status = block_map_.Find(false, hint, block_map_.size(), 1, &bitoff_start)) != NO_ERROR) {
-        if ((status = block_map_.Find(false, 0, hint, 1, &bitoff_start)) != NO_ERROR) {
+    if ((status = block_map_.Find(false, start, block_map_.size(), 1, &bitoff_start)) != NO_ERROR) {
+        if ((status = block_map_.Find(false, 0, start, 1, &bitoff_start)) != NO_ERROR) {
             return ERR_NO_SPACE;
         }
     }
     status = block_map_.Set(bitoff_start, bitoff_start + 1);
     assert(status == NO_ERROR);
+    block_cursor_ = bitoff_start + 1;
     uint32_t bno = static_cast<uint32_t>(bitoff_start);
     assert(bno != 0); // Cannot allocate root block
 
@@ -335,6 +340,9 @@ mx_status_t Minfs::Create(Minfs** out, Bcache* bc, minfs_info_t* info) {
         return status;
     }
 
+    // metadata flushed through the bcache is now journaled
+    bc->SetJournal(info->jnl_block, kMinfsJournalBlocks);
+
     AllocChecker ac;
     mxtl::unique_ptr<Minfs> fs(new (&ac) Minfs(bc, info));
     if (!ac.check()) {
@@ -419,6 +427,70 @@ mx_status_t Minfs::LoadBitmaps() {
     return NO_ERROR;
 }
 
+// Continue an FNV-1a hash over another buffer.
+static uint32_t replay_checksum(uint32_t hash, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len-- > 0) {
+        hash = (hash ^ (*p++)) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+// If the journal contains a committed transaction, re-apply its blocks.
+// Replay is a pure redo -- writing the journaled contents over blocks that
+// already contain them is harmless -- so this is safe to run on every
+// mount, crashed or not. A torn transaction (checksum mismatch) is simply
+// discarded; its in-place writes had not yet been issued.
+mx_status_t minfs_replay_journal(Bcache* bc, const minfs_info_t* info) {
+    char data[kMinfsBlockSize];
+    minfs_jnl_header_t hdr;
+    mx_status_t status;
+    if ((status = bc->Readblk(info->jnl_block, data)) != NO_ERROR) {
+        return status;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.magic != kMinfsJournalMagic) {
+        // empty journal; nothing to do
+        return NO_ERROR;
+    }
+    if (hdr.count > kMinfsJournalMaxBlocks) {
+        error("minfs: bad journal block count %u, discarding\n", hdr.count);
+        hdr.count = 0;
+    }
+    uint32_t checksum = FNV32_OFFSET_BASIS;
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        if ((status = bc->Readblk(info->jnl_block + 1 + i, data)) != NO_ERROR) {
+            return status;
+        }
+        checksum = replay_checksum(checksum, &hdr.target_bno[i],
+                                   sizeof(hdr.target_bno[i]));
+        checksum = replay_checksum(checksum, data, kMinfsBlockSize);
+    }
+    if ((hdr.count > 0) && (checksum == hdr.checksum)) {
+        trace(MINFS, "minfs: replaying journal seq=%llu count=%u\n",
+              (unsigned long long)hdr.seq, hdr.count);
+        for (uint32_t i = 0; i < hdr.count; i++) {
+            uint32_t bno = hdr.target_bno[i];
+            if ((bno == 0) || (bno >= info->block_count)) {
+                error("minfs: journal names bad block %u, skipping\n", bno);
+                continue;
+            }
+            if ((status = bc->Readblk(info->jnl_block + 1 + i, data)) != NO_ERROR) {
+                return status;
+            }
+            if ((status = bc->Writeblk(bno, data)) != NO_ERROR) {
+                return status;
+            }
+        }
+    }
+    // retire the transaction so it is not replayed again
+    memset(data, 0, kMinfsBlockSize);
+    if ((status = bc->Writeblk(info->jnl_block, data)) != NO_ERROR) {
+        return status;
+    }
+    return bc->Sync() ? ERR_IO : NO_ERROR;
+}
+
 mx_status_t minfs_mount(mxtl::RefPtr<VnodeMinfs>* out, Bcache* bc) {
     minfs_info_t info;
     mx_status_t status;
@@ -427,6 +499,12 @@ mx_status_t minfs_mount(mxtl::RefPtr<VnodeMinfs>* out, Bcache* bc) {
         error("minfs: could not read info block\n");
         return status;
     }
+    if (minfs_check_info(&info, bc->Maxblk()) == NO_ERROR) {
+        if ((status = minfs_replay_journal(bc, &info)) != NO_ERROR) {
+            error("minfs: journal replay failed\n");
+            return status;
+        }
+    }
 
     Minfs* fs;
     if ((status = Minfs::Create(&fs, bc, &info)) != NO_ERROR) {
@@ -490,7 +568,8 @@ int minfs_mkfs(Bcache* bc) {
     info.ibm_block = 8;
     info.abm_block = info.ibm_block + mxtl::roundup(ibmblks, 8u);
     info.ino_block = info.abm_block + mxtl::roundup(abmblks, 8u);
-    info.dat_block = info.ino_block + inoblks;
+    info.jnl_block = info.ino_block + inoblks;
+    info.dat_block = info.jnl_block + kMinfsJournalBlocks;
     minfs_dump_info(&info);
 
     RawBitmap abm;
@@ -557,6 +636,12 @@ int minfs_mkfs(Bcache* bc) {
         bc->Put(blk, kBlockDirty);
     }
 
+    // write (empty) journal
+    for (uint32_t n = 0; n < kMinfsJournalBlocks; n++) {
+        blk = bc->GetZero(info.jnl_block + n);
+        bc->Put(blk, kBlockDirty);
+    }
+
     // setup root inode
     blk = bc->Get(info.ino_block);
     minfs_inode_t* ino = (minfs_inode_t*) blk->data();
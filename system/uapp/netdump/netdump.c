@@ -10,6 +10,7 @@
 
 #include <fcntl.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -39,18 +40,61 @@ void handle_rx(mx_handle_t rx_fifo, char* iobuf, unsigned count) {
             }
             e->length = BUFSIZE;
             e->flags = 0;
-            uint32_t actual;
-            if ((status = mx_fifo_write(rx_fifo, e, sizeof(*e), &actual)) < 0) {
-                fprintf(stderr, "netdump: failed to queue rx packet: %d\n", status);
-                break;
-            }
+        }
+
+        // return the whole batch of buffers in one write; we only ever
+        // return buffers we own, so there is always fifo space
+        uint32_t actual;
+        if ((status = mx_fifo_write(rx_fifo, entries, n * sizeof(entries[0]), &actual)) < 0) {
+            fprintf(stderr, "netdump: failed to queue rx packets: %d\n", status);
+            return;
         }
     }
 }
 
+void usage(void) {
+    fprintf(stderr, "usage:  netdump [ -p port ] [ -t | -u ] <network-device>\n");
+    fprintf(stderr, "        -p  only capture TCP/UDP traffic on this port\n");
+    fprintf(stderr, "        -t  only capture TCP traffic\n");
+    fprintf(stderr, "        -u  only capture UDP traffic\n");
+}
+
 int main(int argc, char** argv) {
+    eth_filter_t filter = {0};
+    bool use_filter = false;
+
+    while (argc > 2) {
+        if (!strcmp(argv[1], "-p")) {
+            if (argc < 4) {
+                usage();
+                return -1;
+            }
+            int port = atoi(argv[2]);
+            if ((port < 1) || (port > 65535)) {
+                fprintf(stderr, "netdump: invalid port '%s'\n", argv[2]);
+                return -1;
+            }
+            filter.port = port;
+            use_filter = true;
+            argc -= 2;
+            argv += 2;
+        } else if (!strcmp(argv[1], "-t")) {
+            filter.ip_proto = 6; // IPPROTO_TCP
+            use_filter = true;
+            argc--;
+            argv++;
+        } else if (!strcmp(argv[1], "-u")) {
+            filter.ip_proto = 17; // IPPROTO_UDP
+            use_filter = true;
+            argc--;
+            argv++;
+        } else {
+            usage();
+            return -1;
+        }
+    }
     if (argc != 2) {
-        fprintf(stderr, "usage:  netdump <network-device>\n");
+        usage();
         return -1;
     }
 
@@ -69,7 +113,9 @@ int main(int argc, char** argv) {
         return r;
     }
 
-    unsigned count = fifos.rx_depth / 2;
+    // use the full fifo depth so the driver never runs out of rx
+    // buffers while we are busy printing
+    unsigned count = fifos.rx_depth;
     mx_handle_t iovmo;
     // allocate shareable ethernet buffer data heap
     if ((status = mx_vmo_create(count * BUFSIZE, 0, &iovmo)) < 0) {
@@ -88,6 +134,11 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    if (use_filter && ((r = ioctl_ethernet_set_filter(fd, &filter)) < 0)) {
+        fprintf(stderr, "netdump: failed to set filter: %zd\n", r);
+        return -1;
+    }
+
     // assign data chunks to ethbufs
     for (unsigned n = 0; n < count; n++) {
         eth_fifo_entry_t entry = {
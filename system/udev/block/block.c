@@ -152,6 +152,26 @@ done:
     return status;
 }
 
+static mx_status_t blkdev_set_scheduling(blkdev_t* bdev,
+                                     const void* in_buf, size_t in_len) {
+    if (in_len != sizeof(uint32_t)) {
+        return ERR_INVALID_ARGS;
+    }
+
+    mx_status_t status;
+    mtx_lock(&bdev->lock);
+    if (bdev->bs == NULL) {
+        status = ERR_BAD_STATE;
+        goto done;
+    }
+
+    blockserver_set_scheduling(bdev->bs, *(uint32_t*)in_buf != 0);
+    status = NO_ERROR;
+done:
+    mtx_unlock(&bdev->lock);
+    return status;
+}
+
 static mx_status_t blkdev_fifo_close(blkdev_t* bdev) {
     mtx_lock(&bdev->lock);
     if (bdev->bs != NULL) {
@@ -184,6 +204,8 @@ static mx_status_t blkdev_ioctl(void* ctx, uint32_t op, const void* cmd,
         return blkdev_free_txn(blkdev, cmd, cmdlen);
     case IOCTL_BLOCK_FIFO_CLOSE:
         return blkdev_fifo_close(blkdev);
+    case IOCTL_BLOCK_SET_SCHEDULING:
+        return blkdev_set_scheduling(blkdev, cmd, cmdlen);
     default:
         return device_op_ioctl(blkdev->parent, op, cmd, cmdlen, reply, max, out_actual);
     }
@@ -17,10 +17,13 @@
 
 #include "server.h"
 
+// Reads as many requests as the FIFO currently holds (up to the FIFO depth),
+// so a single wakeup drains the client's whole burst.
 static mx_status_t do_read(mx_handle_t fifo, block_fifo_request_t* requests, uint32_t* count) {
     mx_status_t status;
     while (true) {
-        status = mx_fifo_read(fifo, requests, sizeof(block_fifo_request_t), count);
+        status = mx_fifo_read(fifo, requests,
+                              sizeof(block_fifo_request_t) * BLOCK_FIFO_MAX_DEPTH, count);
         if (status == ERR_SHOULD_WAIT) {
             mx_signals_t signals;
             if ((status = mx_object_wait_one(fifo,
@@ -215,6 +218,10 @@ void blockserver_fifo_complete(void* cookie, mx_status_t status) {
     // Since iobuf is a RefPtr, it lives at least as long as the txn,
     // and is not discarded underneath the block device driver.
     msg->iobuf = nullptr;
+    if (msg->server != nullptr) {
+        msg->server->OpCompleted();
+        msg->server = nullptr;
+    }
     msg->txn->Complete(status);
     msg->txn = nullptr;
 }
@@ -223,6 +230,191 @@ static block_callbacks_t cb = {
     blockserver_fifo_complete,
 };
 
+void BlockServer::OpDispatched() {
+    mxtl::AutoLock lock(&pending_lock_);
+    pending_++;
+}
+
+void BlockServer::OpCompleted() {
+    mxtl::AutoLock lock(&pending_lock_);
+    MX_DEBUG_ASSERT(pending_ > 0);
+    if (--pending_ == 0) {
+        completion_signal(&drained_);
+    }
+}
+
+void BlockServer::DrainPending() {
+    while (true) {
+        {
+            mxtl::AutoLock lock(&pending_lock_);
+            if (pending_ == 0) {
+                return;
+            }
+            // Reset under the lock: a completion arriving afterwards will
+            // re-signal, so the wait below cannot miss the last wakeup.
+            completion_reset(&drained_);
+        }
+        completion_wait(&drained_, MX_TIME_INFINITE);
+    }
+}
+
+void BlockServer::ProcessRequest(mx_device_t* dev, block_ops_t* ops,
+                                 mx_handle_t fifo, block_fifo_request_t* req) {
+    bool wants_reply = req->opcode & BLOCKIO_TXN_END;
+    txnid_t txnid = req->txnid;
+    vmoid_t vmoid = req->vmoid;
+
+    mxtl::AutoLock server_lock(&server_lock_);
+    auto iobuf = tree_.find(vmoid);
+    if (!iobuf.IsValid()) {
+        // Operation which is not accessing a valid vmo
+        if (wants_reply) {
+            OutOfBandErrorRespond(fifo, ERR_IO, txnid);
+        }
+        return;
+    }
+    if (txnid >= MAX_TXN_COUNT || txns_[txnid] == nullptr) {
+        // Operation which is not accessing a valid txn
+        if (wants_reply) {
+            OutOfBandErrorRespond(fifo, ERR_IO, txnid);
+        }
+        return;
+    }
+
+    mx_status_t status;
+    switch (req->opcode & BLOCKIO_OP_MASK) {
+    case BLOCKIO_READ:
+    case BLOCKIO_WRITE: {
+        block_msg_t* msg;
+        status = txns_[txnid]->Enqueue(wants_reply, &msg);
+        if (status != NO_ERROR) {
+            break;
+        }
+        msg->txn = txns_[txnid];
+        msg->iobuf = iobuf.CopyPointer();
+        msg->server = this;
+        OpDispatched();
+
+        // Hack to ensure that the vmo is valid.
+        // In the future, this code will be responsible for pinning VMO pages,
+        // and the completion will be responsible for un-pinning those same pages.
+        status = iobuf->ValidateVmoHack(req->length, req->vmo_offset);
+        if (status != NO_ERROR) {
+            cb.complete(msg, status);
+            break;
+        }
+
+        if ((req->opcode & BLOCKIO_OP_MASK) == BLOCKIO_READ) {
+            ops->read(dev, iobuf->io_vmo_, req->length,
+                      req->vmo_offset, req->dev_offset, msg);
+        } else {
+            ops->write(dev, iobuf->io_vmo_, req->length,
+                       req->vmo_offset, req->dev_offset, msg);
+        }
+        break;
+    }
+    case BLOCKIO_SYNC: {
+        // TODO(smklein): It might be more useful to have this on a per-vmo basis
+        block_msg_t* msg;
+        status = txns_[txnid]->Enqueue(wants_reply, &msg);
+        if (status != NO_ERROR) {
+            break;
+        }
+        msg->txn = txns_[txnid];
+        msg->iobuf = iobuf.CopyPointer();
+        msg->server = this;
+
+        // Barrier: every operation dispatched before this one must have
+        // completed before the flush is issued (or the sync reported done).
+        // The Serve loop already keeps non-read/write requests ordered
+        // relative to scheduled runs.
+        DrainPending();
+
+        OpDispatched();
+        if (ops->flush != NULL) {
+            ops->flush(dev, msg);
+        } else {
+            // No volatile write cache to flush; the drain alone suffices.
+            cb.complete(msg, NO_ERROR);
+        }
+        break;
+    }
+    case BLOCKIO_CLOSE_VMO: {
+        tree_.erase(*iobuf);
+        if (wants_reply) {
+            OutOfBandErrorRespond(fifo, NO_ERROR, txnid);
+        }
+        break;
+    }
+    default: {
+        fprintf(stderr, "Unrecognized Block Server operation: %x\n",
+                req->opcode);
+    }
+    }
+}
+
+static bool is_rw(const block_fifo_request_t* req) {
+    uint16_t op = req->opcode & BLOCKIO_OP_MASK;
+    return (op == BLOCKIO_READ) || (op == BLOCKIO_WRITE);
+}
+
+// Returns true if |b| continues |a| on both the device and the VMO, so the
+// pair can be issued to the driver as a single operation.
+static bool can_merge(const block_fifo_request_t* a,
+                      const block_fifo_request_t* b) {
+    return ((a->opcode & BLOCKIO_OP_MASK) == (b->opcode & BLOCKIO_OP_MASK)) &&
+           (a->txnid == b->txnid) && (a->vmoid == b->vmoid) &&
+           (a->dev_offset + a->length == b->dev_offset) &&
+           (a->vmo_offset + a->length == b->vmo_offset) &&
+           (a->length + b->length > a->length);
+}
+
+void BlockServer::ScheduleRun(mx_device_t* dev, block_ops_t* ops,
+                              mx_handle_t fifo,
+                              block_fifo_request_t* requests, size_t count) {
+    // Elevator ordering: dispatch the run in ascending device offset.
+    // Requests in flight carry no ordering guarantee -- drivers and hardware
+    // queues already complete them in any order -- so reordering here is
+    // invisible to clients, which serialize through txn responses.
+    for (size_t i = 1; i < count; i++) {
+        block_fifo_request_t tmp = requests[i];
+        size_t j = i;
+        for (; j > 0 && requests[j - 1].dev_offset > tmp.dev_offset; j--) {
+            requests[j] = requests[j - 1];
+        }
+        requests[j] = tmp;
+    }
+
+    block_fifo_request_t merged[BLOCK_FIFO_MAX_DEPTH];
+    size_t nmerged = 0;
+    size_t i = 0;
+    while (i < count) {
+        merged[nmerged] = requests[i];
+        size_t next = i + 1;
+        while (next < count && can_merge(&merged[nmerged], &requests[next])) {
+            merged[nmerged].length += requests[next].length;
+            merged[nmerged].opcode |= requests[next].opcode & BLOCKIO_TXN_END;
+            next++;
+        }
+        nmerged++;
+        i = next;
+    }
+
+    // A request flagged BLOCKIO_TXN_END must be the last of its transaction
+    // to be enqueued, and sorting may have moved it ahead of its siblings;
+    // dispatch the unflagged requests first.
+    for (i = 0; i < nmerged; i++) {
+        if (!(merged[i].opcode & BLOCKIO_TXN_END)) {
+            ProcessRequest(dev, ops, fifo, &merged[i]);
+        }
+    }
+    for (i = 0; i < nmerged; i++) {
+        if (merged[i].opcode & BLOCKIO_TXN_END) {
+            ProcessRequest(dev, ops, fifo, &merged[i]);
+        }
+    }
+}
+
 mx_status_t BlockServer::Serve(mx_device_t* dev, block_ops_t* ops) {
 
     ops->set_callbacks(dev, &cb);
@@ -240,79 +432,38 @@ mx_status_t BlockServer::Serve(mx_device_t* dev, block_ops_t* ops) {
             return status;
         }
 
-        for (size_t i = 0; i < count; i++) {
-            bool wants_reply = requests[i].opcode & BLOCKIO_TXN_END;
-            txnid_t txnid = requests[i].txnid;
-            vmoid_t vmoid = requests[i].vmoid;
-
+        bool sched;
+        {
             mxtl::AutoLock server_lock(&server_lock_);
-            auto iobuf = tree_.find(vmoid);
-            if (!iobuf.IsValid()) {
-                // Operation which is not accessing a valid vmo
-                if (wants_reply) {
-                    OutOfBandErrorRespond(fifo, ERR_IO, txnid);
-                }
-                continue;
-            }
-            if (txnid >= MAX_TXN_COUNT || txns_[txnid] == nullptr) {
-                // Operation which is not accessing a valid txn
-                if (wants_reply) {
-                    OutOfBandErrorRespond(fifo, ERR_IO, txnid);
-                }
-                continue;
-            }
+            sched = sched_enabled_;
+        }
 
-            switch (requests[i].opcode & BLOCKIO_OP_MASK) {
-            case BLOCKIO_READ:
-            case BLOCKIO_WRITE: {
-                block_msg_t* msg;
-                status = txns_[txnid]->Enqueue(wants_reply, &msg);
-                if (status != NO_ERROR) {
-                    break;
-                }
-                msg->txn = txns_[txnid];
-                msg->iobuf = iobuf.CopyPointer();
-
-                // Hack to ensure that the vmo is valid.
-                // In the future, this code will be responsible for pinning VMO pages,
-                // and the completion will be responsible for un-pinning those same pages.
-                status = iobuf->ValidateVmoHack(requests[i].length, requests[i].vmo_offset);
-                if (status != NO_ERROR) {
-                    cb.complete(msg, status);
-                    break;
-                }
-
-                if ((requests[i].opcode & BLOCKIO_OP_MASK) == BLOCKIO_READ) {
-                    ops->read(dev, iobuf->io_vmo_, requests[i].length,
-                              requests[i].vmo_offset, requests[i].dev_offset, msg);
-                } else {
-                    ops->write(dev, iobuf->io_vmo_, requests[i].length,
-                               requests[i].vmo_offset, requests[i].dev_offset, msg);
-                }
-                break;
-            }
-            case BLOCKIO_SYNC: {
-                // TODO(smklein): It might be more useful to have this on a per-vmo basis
-                fprintf(stderr, "Warning: BLOCKIO_SYNC is currently unimplemented\n");
-                break;
-            }
-            case BLOCKIO_CLOSE_VMO: {
-                tree_.erase(*iobuf);
-                if (wants_reply) {
-                    OutOfBandErrorRespond(fifo, NO_ERROR, txnid);
-                }
-                break;
-            }
-            default: {
-                fprintf(stderr, "Unrecognized Block Server operation: %x\n",
-                        requests[i].opcode);
+        size_t i = 0;
+        while (i < count) {
+            if (!sched || !is_rw(&requests[i])) {
+                // Other operations act as barriers between scheduled runs,
+                // preserving their order relative to reads and writes.
+                ProcessRequest(dev, ops, fifo, &requests[i]);
+                i++;
+                continue;
             }
+            size_t run = i + 1;
+            while (run < count && is_rw(&requests[run])) {
+                run++;
             }
+            ScheduleRun(dev, ops, fifo, &requests[i], run - i);
+            i = run;
         }
     }
 }
 
-BlockServer::BlockServer() : fifo_(MX_HANDLE_INVALID), last_id(0) {}
+void BlockServer::SetScheduling(bool enabled) {
+    mxtl::AutoLock server_lock(&server_lock_);
+    sched_enabled_ = enabled;
+}
+
+BlockServer::BlockServer() : fifo_(MX_HANDLE_INVALID), last_id(0),
+    sched_enabled_(true), pending_(0), drained_() {}
 BlockServer::~BlockServer() {
     ShutDown();
 }
@@ -347,3 +498,6 @@ mx_status_t blockserver_allocate_txn(BlockServer* bs, txnid_t* out) {
 void blockserver_free_txn(BlockServer* bs, txnid_t txnid) {
     return bs->FreeTxn(txnid);
 }
+void blockserver_set_scheduling(BlockServer* bs, bool enabled) {
+    bs->SetScheduling(enabled);
+}
@@ -19,6 +19,7 @@
 #include <mxtl/ref_counted.h>
 #include <mxtl/ref_ptr.h>
 #include <mxtl/unique_ptr.h>
+#include <sync/completion.h>
 
 // Represents the mapping of "vmoid --> VMO"
 class IoBuffer : public mxtl::WAVLTreeContainable<mxtl::RefPtr<IoBuffer>>,
@@ -46,10 +47,12 @@ private:
 constexpr uint32_t kTxnFlagRespond = 0x00000001; // Should a reponse be sent when we hit goal?
 
 class BlockTransaction;
+class BlockServer;
 
 typedef struct {
     mxtl::RefPtr<BlockTransaction> txn;
     mxtl::RefPtr<IoBuffer> iobuf;
+    BlockServer* server = nullptr;
 } block_msg_t;
 
 class BlockTransaction : public mxtl::RefCounted<BlockTransaction> {
@@ -92,6 +95,14 @@ public:
     mx_status_t AllocateTxn(txnid_t* out);
     void FreeTxn(txnid_t txnid);
 
+    // Controls whether read/write requests are sorted by device offset and
+    // merged when adjacent before reaching the underlying driver.
+    void SetScheduling(bool enabled);
+
+    // Called from the device's completion callback when a dispatched
+    // operation finishes, so BLOCKIO_SYNC barriers can drain.
+    void OpCompleted();
+
     void ShutDown();
 
     ~BlockServer();
@@ -101,11 +112,31 @@ private:
 
     mx_status_t FindVmoIDLocked(vmoid_t* out);
 
+    // Dispatches a single FIFO request to the underlying device.
+    void ProcessRequest(mx_device_t* dev, block_ops_t* ops, mx_handle_t fifo,
+                        block_fifo_request_t* req);
+
+    // Sorts a run of read/write requests by device offset and merges
+    // adjacent ones before dispatching them.
+    void ScheduleRun(mx_device_t* dev, block_ops_t* ops, mx_handle_t fifo,
+                     block_fifo_request_t* requests, size_t count);
+
+    // Counts an operation handed to the underlying device; paired with
+    // OpCompleted.
+    void OpDispatched();
+    // Blocks until every dispatched operation has completed.
+    void DrainPending();
+
     mxtl::Mutex server_lock_;
     mx_handle_t fifo_;
     mxtl::WAVLTree<vmoid_t, mxtl::RefPtr<IoBuffer>> tree_;
     mxtl::RefPtr<BlockTransaction> txns_[MAX_TXN_COUNT];
     vmoid_t last_id;
+    bool sched_enabled_;
+
+    mxtl::Mutex pending_lock_;
+    uint32_t pending_;
+    completion_t drained_;
 };
 
 #else
@@ -136,4 +167,7 @@ mx_status_t blockserver_attach_vmo(BlockServer* bs, mx_handle_t vmo, vmoid_t* ou
 mx_status_t blockserver_allocate_txn(BlockServer* bs, txnid_t* out);
 void blockserver_free_txn(BlockServer* bs, txnid_t txnid);
 
+// Enable or disable request scheduling
+void blockserver_set_scheduling(BlockServer* bs, bool enabled);
+
 __END_CDECLS
@@ -13,6 +13,7 @@
 #include <magenta/syscalls.h>
 #include <magenta/types.h>
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -83,6 +84,12 @@ static void eth0_downref(ethdev0_t* edev0) {
 // This client wants to observe loopback tx packets
 #define ETHDEV_TX_LISTEN (16u)
 
+// receive thread has been created (zero-copy queue mode only)
+#define ETHDEV_RX_THREAD (32u)
+
+// This client has a receive filter installed
+#define ETHDEV_FILTER (64u)
+
 // ethernet instance device
 typedef struct ethdev {
     list_node_t node;
@@ -104,8 +111,29 @@ typedef struct ethdev {
     void* io_buf;
     size_t io_size;
 
-    // fifo thread
+    // physical addresses of the io buffer's pages, only populated
+    // when the mac uses the zero-copy queue interface
+    mx_paddr_t* io_paddrs;
+    size_t io_pages;
+
+    // in-order rings of entries whose buffers are owned by the mac
+    // until it calls complete_?x(); the client can have at most
+    // FIFO_DEPTH outstanding per direction so these cannot overflow.
+    // protected by edev0->lock
+    eth_fifo_entry_t tx_pending[FIFO_DEPTH];
+    uint32_t tx_pending_rd;
+    uint32_t tx_pending_wr;
+    eth_fifo_entry_t rx_pending[FIFO_DEPTH];
+    uint32_t rx_pending_rd;
+    uint32_t rx_pending_wr;
+
+    // receive filter, active when ETHDEV_FILTER is set
+    // protected by edev0->lock
+    eth_filter_t filter;
+
+    // fifo threads
     thrd_t tx_thr;
+    thrd_t rx_thr;
 
     mx_device_t* mxdev;
 
@@ -116,11 +144,89 @@ typedef struct ethdev {
 
 #define FAIL_REPORT_RATE 50
 
+// translates an io_buf extent into the (at most two) physical pages
+// backing it, as the queue_?x() interface describes buffers
+static mx_status_t eth_get_phys(ethdev_t* edev, uint32_t offset, uint16_t length,
+                                uintptr_t* pa0, uintptr_t* pa1) {
+    size_t page = offset / PAGE_SIZE;
+    size_t pgoff = offset % PAGE_SIZE;
+    if (pgoff + length > 2 * PAGE_SIZE) {
+        // a queue_?x() buffer cannot span more than two pages
+        return ERR_INVALID_ARGS;
+    }
+    *pa0 = edev->io_paddrs[page] + pgoff;
+    *pa1 = (pgoff + length > PAGE_SIZE) ? edev->io_paddrs[page + 1] : 0;
+    return NO_ERROR;
+}
+
+// minimal receive filter: ethertype, IP protocol and TCP/UDP port match.
+// runs before a packet is copied into a client's io buffer so capture
+// clients do not pay for traffic they do not want.
+static bool eth_filter_match(const eth_filter_t* f, const void* data, size_t len) {
+    const uint8_t* p = data;
+    if (len < 14) {
+        return false;
+    }
+    uint16_t ethertype = (p[12] << 8) | p[13];
+    if (f->ethertype && (f->ethertype != ethertype)) {
+        return false;
+    }
+    if ((f->ip_proto == 0) && (f->port == 0)) {
+        return true;
+    }
+    uint8_t proto;
+    size_t l4;
+    if (ethertype == 0x0800) { // IPv4
+        size_t ihl = (len < 15) ? 0 : (p[14] & 0x0F) * 4;
+        if ((ihl < 20) || (len < 14 + ihl)) {
+            return false;
+        }
+        proto = p[14 + 9];
+        // ports are only present in the first fragment
+        if (f->port && (((p[14 + 6] & 0x1F) != 0) || (p[14 + 7] != 0))) {
+            return false;
+        }
+        l4 = 14 + ihl;
+    } else if (ethertype == 0x86DD) { // IPv6
+        if (len < 14 + 40) {
+            return false;
+        }
+        // extension headers are not walked; uncommon on the traffic
+        // this is used to capture
+        proto = p[14 + 6];
+        l4 = 14 + 40;
+    } else {
+        // non-IP traffic cannot match an ip_proto/port filter
+        return false;
+    }
+    if (f->ip_proto && (f->ip_proto != proto)) {
+        return false;
+    }
+    if (f->port) {
+        if ((proto != 6) && (proto != 17)) { // TCP or UDP
+            return false;
+        }
+        if (len < l4 + 4) {
+            return false;
+        }
+        uint16_t sport = (p[l4] << 8) | p[l4 + 1];
+        uint16_t dport = (p[l4 + 2] << 8) | p[l4 + 3];
+        if ((f->port != sport) && (f->port != dport)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
     eth_fifo_entry_t e;
     mx_status_t status;
     uint32_t count;
 
+    if ((edev->state & ETHDEV_FILTER) && !eth_filter_match(&edev->filter, data, len)) {
+        return;
+    }
+
     // TODO: read multiple and cache locally to reduce syscalls
     if ((status = mx_fifo_read(edev->rx_fifo, &e, sizeof(e), &count)) < 0) {
         if (status == ERR_SHOULD_WAIT) {
@@ -171,11 +277,62 @@ static void eth0_status(void* cookie, uint32_t status) {
 // can deadlock with the ethermac device
 static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
     ethdev0_t* edev0 = cookie;
+    uint32_t extra = (flags & ETHMAC_RX_CSUM_OK) ? ETH_FIFO_RX_CSUM : 0;
 
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        eth_handle_rx(edev, data, len, 0);
+        eth_handle_rx(edev, data, len, extra);
+    }
+    mtx_unlock(&edev0->lock);
+}
+
+// the zero-copy queue interface only ever has a single active
+// instance (see eth_start_locked), so completions are in-order
+// pops of that instance's pending rings
+
+static void eth0_complete_rx(void* cookie, uint32_t length, uint32_t flags) {
+    ethdev0_t* edev0 = cookie;
+
+    mtx_lock(&edev0->lock);
+    ethdev_t* edev = list_peek_head_type(&edev0->list_active, ethdev_t, node);
+    if (edev && (edev->rx_pending_rd != edev->rx_pending_wr)) {
+        eth_fifo_entry_t* e = &edev->rx_pending[edev->rx_pending_rd & (FIFO_DEPTH - 1)];
+        edev->rx_pending_rd++;
+        e->length = length;
+        e->flags = ETH_FIFO_RX_OK;
+        if (flags & ETHMAC_RX_CSUM_OK) {
+            e->flags |= ETH_FIFO_RX_CSUM;
+        }
+        uint32_t count;
+        if (mx_fifo_write(edev->rx_fifo, e, sizeof(*e), &count) < 0) {
+            if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
+                printf("eth: no rx_fifo space available (%u times)\n",
+                       edev->fail_rx_write);
+            }
+        }
+    }
+    mtx_unlock(&edev0->lock);
+}
+
+static void eth0_complete_tx(void* cookie, uint32_t count) {
+    ethdev0_t* edev0 = cookie;
+
+    mtx_lock(&edev0->lock);
+    ethdev_t* edev = list_peek_head_type(&edev0->list_active, ethdev_t, node);
+    if (edev) {
+        while ((count-- > 0) && (edev->tx_pending_rd != edev->tx_pending_wr)) {
+            eth_fifo_entry_t* e = &edev->tx_pending[edev->tx_pending_rd & (FIFO_DEPTH - 1)];
+            edev->tx_pending_rd++;
+            e->flags = ETH_FIFO_TX_OK;
+            uint32_t actual;
+            if (mx_fifo_write(edev->tx_fifo, e, sizeof(*e), &actual) < 0) {
+                if ((edev->fail_tx_write++ % FAIL_REPORT_RATE) == 0) {
+                    printf("eth: no tx_fifo space available (%u times)\n",
+                           edev->fail_tx_write);
+                }
+            }
+        }
     }
     mtx_unlock(&edev0->lock);
 }
@@ -183,6 +340,8 @@ static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
 static ethmac_ifc_t ethmac_ifc = {
     .status = eth0_status,
     .recv = eth0_recv,
+    .complete_rx = eth0_complete_rx,
+    .complete_tx = eth0_complete_tx,
 };
 
 static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len) {
@@ -251,17 +410,46 @@ static int eth_tx_thread(void* arg) {
             }
         }
 
-        uint32_t n = count;
-        for (eth_fifo_entry_t* e = entries; count-- > 0; e++) {
-            if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
-                e->flags = ETH_FIFO_INVALID;
-            } else {
-                edev0->macops->send(edev0->mac, 0, edev->io_buf + e->offset, e->length);
-                e->flags = ETH_FIFO_TX_OK;
+        uint32_t n;
+        if (edev0->info.features & ETHMAC_FEATURE_TX_QUEUE) {
+            // hand buffers to the mac for direct dma; they complete
+            // via complete_tx().  only invalid entries (compacted to
+            // the front of the batch) are returned to the fifo here
+            n = 0;
+            for (eth_fifo_entry_t* e = entries; count-- > 0; e++) {
+                uintptr_t pa0, pa1;
+                if ((e->offset > edev->io_size) ||
+                    (e->length > (edev->io_size - e->offset)) ||
+                    (eth_get_phys(edev, e->offset, e->length, &pa0, &pa1) < 0)) {
+                    e->flags = ETH_FIFO_INVALID;
+                    entries[n++] = *e;
+                    continue;
+                }
+                mtx_lock(&edev0->lock);
+                edev->tx_pending[edev->tx_pending_wr & (FIFO_DEPTH - 1)] = *e;
+                edev->tx_pending_wr++;
+                mtx_unlock(&edev0->lock);
+                edev0->macops->queue_tx(edev0->mac, 0, pa0, pa1, e->length);
                 if (edev->state & ETHDEV_TX_LOOPBACK) {
                     eth_tx_echo(edev0, edev->io_buf + e->offset, e->length);
                 }
             }
+            if (n == 0) {
+                continue;
+            }
+        } else {
+            n = count;
+            for (eth_fifo_entry_t* e = entries; count-- > 0; e++) {
+                if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
+                    e->flags = ETH_FIFO_INVALID;
+                } else {
+                    edev0->macops->send(edev0->mac, 0, edev->io_buf + e->offset, e->length);
+                    e->flags = ETH_FIFO_TX_OK;
+                    if (edev->state & ETHDEV_TX_LOOPBACK) {
+                        eth_tx_echo(edev0, edev->io_buf + e->offset, e->length);
+                    }
+                }
+            }
         }
 
         if ((status = mx_fifo_write(edev->tx_fifo, entries, sizeof(eth_fifo_entry_t) * n, &count)) < 0) {
@@ -284,6 +472,57 @@ static int eth_tx_thread(void* arg) {
     return 0;
 }
 
+// feeds client rx buffers to the mac for direct dma; they are
+// returned to the client via complete_rx().  only runs when the mac
+// uses the zero-copy queue interface
+static int eth_rx_thread(void* arg) {
+    ethdev_t* edev = (ethdev_t*)arg;
+    ethdev0_t* edev0 = edev->edev0;
+    eth_fifo_entry_t entries[FIFO_DEPTH / 2];
+    mx_status_t status;
+    uint32_t count;
+
+    for (;;) {
+        if ((status = mx_fifo_read(edev->rx_fifo, entries, sizeof(entries), &count)) < 0) {
+            if (status == ERR_SHOULD_WAIT) {
+                if ((status = mx_object_wait_one(edev->rx_fifo,
+                                                 MX_FIFO_READABLE | MX_FIFO_PEER_CLOSED,
+                                                 MX_TIME_INFINITE, NULL)) < 0) {
+                    if (status != ERR_CANCELED) {
+                        printf("eth: rx_fifo: error waiting: %d\n", status);
+                    }
+                    break;
+                }
+                continue;
+            } else {
+                printf("eth: rx_fifo: cannot read: %d\n", status);
+                break;
+            }
+        }
+
+        for (eth_fifo_entry_t* e = entries; count-- > 0; e++) {
+            uintptr_t pa0, pa1;
+            if ((e->offset > edev->io_size) ||
+                (e->length > (edev->io_size - e->offset)) ||
+                (eth_get_phys(edev, e->offset, e->length, &pa0, &pa1) < 0)) {
+                e->length = 0;
+                e->flags = ETH_FIFO_INVALID;
+                uint32_t actual;
+                mx_fifo_write(edev->rx_fifo, e, sizeof(*e), &actual);
+                continue;
+            }
+            mtx_lock(&edev0->lock);
+            edev->rx_pending[edev->rx_pending_wr & (FIFO_DEPTH - 1)] = *e;
+            edev->rx_pending_wr++;
+            mtx_unlock(&edev0->lock);
+            edev0->macops->queue_rx(edev0->mac, 0, pa0, pa1, e->length);
+        }
+    }
+
+    printf("eth: rx_thread: exit: %d\n", status);
+    return 0;
+}
+
 static mx_status_t eth_get_fifos_locked(ethdev_t* edev, void* out_buf, size_t out_len,
                                     size_t* out_actual) {
     if (out_len < sizeof(eth_fifos_t)) {
@@ -342,11 +581,35 @@ static ssize_t eth_set_iobuf_locked(ethdev_t* edev, const void* in_buf, size_t i
         goto fail;
     }
 
+    // if the mac dmas directly into/out of the io buffer, pin its
+    // pages and record their physical addresses up front
+    if (edev->edev0->info.features &
+        (ETHMAC_FEATURE_RX_QUEUE | ETHMAC_FEATURE_TX_QUEUE)) {
+        size_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+        mx_paddr_t* paddrs = calloc(pages, sizeof(mx_paddr_t));
+        if (paddrs == NULL) {
+            status = ERR_NO_MEMORY;
+            goto fail_unmap;
+        }
+        if (((status = mx_vmo_op_range(vmo, MX_VMO_OP_COMMIT, 0, size, NULL, 0)) < 0) ||
+            ((status = mx_vmo_op_range(vmo, MX_VMO_OP_LOOKUP, 0, size,
+                                       paddrs, pages * sizeof(mx_paddr_t))) < 0)) {
+            printf("eth: could not look up io_buf pages: %d\n", status);
+            free(paddrs);
+            goto fail_unmap;
+        }
+        edev->io_paddrs = paddrs;
+        edev->io_pages = pages;
+    }
+
     edev->io_vmo = vmo;
     edev->io_size = size;
 
     return NO_ERROR;
 
+fail_unmap:
+    mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)edev->io_buf, 0);
+    edev->io_buf = NULL;
 fail:
     mx_handle_close(vmo);
     return status;
@@ -366,6 +629,24 @@ static mx_status_t eth_start_locked(ethdev_t* edev) {
         return NO_ERROR;
     }
 
+    // the zero-copy queue interface ties the mac to one client's io
+    // buffer, so only a single instance may be active at a time
+    if ((edev0->info.features & (ETHMAC_FEATURE_RX_QUEUE | ETHMAC_FEATURE_TX_QUEUE)) &&
+        !list_is_empty(&edev0->list_active)) {
+        return ERR_ALREADY_BOUND;
+    }
+
+    if ((edev0->info.features & ETHMAC_FEATURE_RX_QUEUE) &&
+        !(edev->state & ETHDEV_RX_THREAD)) {
+        int r = thrd_create_with_name(&edev->rx_thr, eth_rx_thread,
+                                      edev, "eth-rx-thread");
+        if (r != thrd_success) {
+            printf("eth: failed to start rx thread: %d\n", r);
+            return ERR_INTERNAL;
+        }
+        edev->state |= ETHDEV_RX_THREAD;
+    }
+
     if (!(edev->state & ETHDEV_TX_THREAD)) {
         int r = thrd_create_with_name(&edev->tx_thr, eth_tx_thread,
                                       edev, "eth-tx-thread");
@@ -434,6 +715,12 @@ static mx_status_t eth_ioctl(void* ctx, uint32_t op,
             if (edev->edev0->info.features & ETHMAC_FEATURE_WLAN) {
                 info->features |= ETH_FEATURE_WLAN;
             }
+            if (edev->edev0->info.features & ETHMAC_FEATURE_RX_CSUM) {
+                info->features |= ETH_FEATURE_RX_CSUM;
+            }
+            if (edev->edev0->info.features & ETHMAC_FEATURE_TX_CSUM) {
+                info->features |= ETH_FEATURE_TX_CSUM;
+            }
             info->mtu = edev->edev0->info.mtu;
             *out_actual = sizeof(*info);
             status = NO_ERROR;
@@ -458,6 +745,21 @@ static mx_status_t eth_ioctl(void* ctx, uint32_t op,
     case IOCTL_ETHERNET_TX_LISTEN_STOP:
         status = eth_tx_listen_locked(edev, false);
         break;
+    case IOCTL_ETHERNET_SET_FILTER: {
+        if (in_len < sizeof(eth_filter_t)) {
+            status = ERR_INVALID_ARGS;
+            break;
+        }
+        const eth_filter_t* filter = in_buf;
+        if ((filter->ethertype == 0) && (filter->ip_proto == 0) && (filter->port == 0)) {
+            edev->state &= (~ETHDEV_FILTER);
+        } else {
+            edev->filter = *filter;
+            edev->state |= ETHDEV_FILTER;
+        }
+        status = NO_ERROR;
+        break;
+    }
     default:
         // TODO: consider if we want this under the edev0->lock or not
         status = device_op_ioctl(edev->edev0->mac, op, in_buf, in_len, out_buf, out_len, out_actual);
@@ -497,18 +799,29 @@ static void eth_kill_locked(ethdev_t* edev) {
         edev->io_vmo = MX_HANDLE_INVALID;
     }
 
-    // closing handles will 'encourage' the tx thread to exit
+    // closing handles will 'encourage' the fifo threads to exit
     if (edev->state & ETHDEV_TX_THREAD) {
         edev->state &= (~ETHDEV_TX_THREAD);
         int ret;
         thrd_join(edev->tx_thr, &ret);
         xprintf("eth: kill: tx thread exited\n");
     }
+    if (edev->state & ETHDEV_RX_THREAD) {
+        edev->state &= (~ETHDEV_RX_THREAD);
+        int ret;
+        thrd_join(edev->rx_thr, &ret);
+        xprintf("eth: kill: rx thread exited\n");
+    }
 
     if (edev->io_buf) {
         mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t) edev->io_buf, 0);
         edev->io_buf = NULL;
     }
+    if (edev->io_paddrs) {
+        free(edev->io_paddrs);
+        edev->io_paddrs = NULL;
+        edev->io_pages = 0;
+    }
     xprintf("eth: all resources released\n");
 }
 
@@ -606,8 +919,6 @@ static mx_protocol_device_t ethdev0_ops = {
 };
 
 
-#define BAD_FEATURES (ETHMAC_FEATURE_RX_QUEUE | ETHMAC_FEATURE_TX_QUEUE)
-
 static mx_status_t eth_bind(mx_driver_t* drv, mx_device_t* dev, void** cookie) {
     ethdev0_t* edev0;
     if ((edev0 = calloc(1, sizeof(ethdev0_t))) == NULL) {
@@ -626,13 +937,6 @@ static mx_status_t eth_bind(mx_driver_t* drv, mx_device_t* dev, void** cookie) {
         goto fail;
     }
 
-    if (edev0->info.features & BAD_FEATURES) {
-        printf("eth: bind: ethermac requires unsupported features: %08x\n",
-               edev0->info.features & BAD_FEATURES);
-        status = ERR_NOT_SUPPORTED;
-        goto fail;
-    }
-
     mtx_init(&edev0->lock, mtx_plain);
     list_initialize(&edev0->list_active);
     list_initialize(&edev0->list_idle);
@@ -45,6 +45,12 @@ typedef struct gptpart_device {
     block_info_t info;
     block_callbacks_t* callbacks;
 
+    // the underlying BLOCK_CORE device and its ops, or NULL if no such
+    // device is reachable; when set, requests are remapped in place and
+    // handed straight down instead of being re-issued as iotxns
+    mx_device_t* parent_core;
+    block_ops_t* parent_ops;
+
     atomic_int writercount;
 } gptpart_device_t;
 
@@ -196,6 +202,12 @@ static mx_protocol_device_t gpt_proto = {
 static void gpt_block_set_callbacks(mx_device_t* dev, block_callbacks_t* cb) {
     gptpart_device_t* device = dev->ctx;
     device->callbacks = cb;
+    // completions are routed by cookie, so the parent can share the same
+    // callback table; this lets remapped requests go straight down without
+    // an iotxn in between
+    if (device->parent_ops != NULL) {
+        device->parent_ops->set_callbacks(device->parent_core, cb);
+    }
 }
 
 static void gpt_block_get_info(mx_device_t* dev, block_info_t* info) {
@@ -217,11 +229,25 @@ static void block_do_txn(gptpart_device_t* dev, uint32_t opcode, mx_handle_t vmo
         return;
     }
     uint64_t size = getsize(dev);
-    if ((dev_offset >= size) || (length >= (size - dev_offset))) {
+    if ((dev_offset > size) || (length > (size - dev_offset))) {
         dev->callbacks->complete(cookie, ERR_OUT_OF_RANGE);
         return;
     }
 
+    // fast path: when the parent speaks the block protocol, remap the offset
+    // in place and hand the request down with no allocation or extra
+    // completion hop
+    if (dev->parent_ops != NULL) {
+        if (opcode == IOTXN_OP_READ) {
+            dev->parent_ops->read(dev->parent_core, vmo, length, vmo_offset,
+                                  to_parent_offset(dev, dev_offset), cookie);
+        } else {
+            dev->parent_ops->write(dev->parent_core, vmo, length, vmo_offset,
+                                   to_parent_offset(dev, dev_offset), cookie);
+        }
+        return;
+    }
+
     mx_status_t status;
     iotxn_t* txn;
     if ((status = iotxn_alloc_vmo(&txn, IOTXN_ALLOC_POOL, vmo, vmo_offset, length)) != NO_ERROR) {
@@ -283,6 +309,20 @@ static int gpt_bind_thread(void* arg) {
                 block_info.block_size);
     }
 
+    // find the BLOCK_CORE device this block device sits on, if any, so
+    // partition requests can be remapped in place and passed through
+    // without an intermediate iotxn
+    mx_device_t* core_dev = dev;
+    block_ops_t* parent_ops = NULL;
+    if (device_op_get_protocol(core_dev, MX_PROTOCOL_BLOCK_CORE, (void**)&parent_ops) != NO_ERROR) {
+        core_dev = dev->parent;
+        if ((core_dev == NULL) ||
+            (device_op_get_protocol(core_dev, MX_PROTOCOL_BLOCK_CORE, (void**)&parent_ops) != NO_ERROR)) {
+            core_dev = NULL;
+            parent_ops = NULL;
+        }
+    }
+
     // allocate an iotxn to read the partition table
     iotxn_t* txn;
     mx_status_t status = iotxn_alloc(&txn, IOTXN_ALLOC_CONTIGUOUS, TXN_SIZE);
@@ -347,6 +387,8 @@ static int gpt_bind_thread(void* arg) {
             goto unbind;
         }
         device->parent = dev;
+        device->parent_core = core_dev;
+        device->parent_ops = parent_ops;
 
         iotxn_copyfrom(txn, &device->gpt_entry, sizeof(gpt_entry_t), sizeof(gpt_entry_t) * partitions);
         if (device->gpt_entry.type[0] == 0) {
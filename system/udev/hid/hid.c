@@ -11,6 +11,7 @@
 
 #include <magenta/assert.h>
 #include <magenta/listnode.h>
+#include <magenta/syscalls.h>
 
 #include <assert.h>
 #include <stdio.h>
@@ -20,6 +21,12 @@
 #define HID_FLAGS_DEAD         (1 << 0)
 #define HID_FLAGS_WRITE_FAILED (1 << 1)
 
+// Maximum number of reports pending in an instance fifo.  Reports beyond
+// this are dropped the same way a full fifo drops them; at 128 entries a
+// 1kHz digitizer gets 128ms of backlog before losing anything.
+#define HID_MAX_PENDING_REPORTS 128
+#define HID_PENDING_REPORTS_MASK (HID_MAX_PENDING_REPORTS - 1)
+
 #define USB_HID_DEBUG 0
 
 // TODO(johngro) : Get this from a standard header instead of defining our own.
@@ -87,6 +94,20 @@ typedef struct hid_instance {
 
     mx_hid_fifo_t fifo;
 
+    // arrival times of the reports in |fifo|, oldest first.  |time_head| and
+    // |time_tail| are free-running; their difference is the number of pending
+    // reports.  Protected by fifo.lock.
+    uint64_t times[HID_MAX_PENDING_REPORTS];
+    uint32_t time_head;
+    uint32_t time_tail;
+
+    // arrival times of the reports delivered by the most recent read
+    uint64_t last_times[HID_MAX_PENDING_REPORTS];
+    uint32_t last_time_count;
+
+    // wakeup moderation; zeroed policy signals readable on every report
+    input_read_policy_t policy;
+
     struct list_node node;
 } hid_instance_t;
 
@@ -285,9 +306,7 @@ static mx_status_t hid_read_instance(void* ctx, void* buf, size_t count, mx_off_
         return ERR_PEER_CLOSED;
     }
 
-    size_t left;
     mtx_lock(&hid->fifo.lock);
-    size_t xfer;
     uint8_t rpt_id;
     ssize_t r = mx_hid_fifo_peek(&hid->fifo, &rpt_id);
     if (r < 1) {
@@ -296,7 +315,7 @@ static mx_status_t hid_read_instance(void* ctx, void* buf, size_t count, mx_off_
         return ERR_SHOULD_WAIT;
     }
 
-    xfer = hid_get_report_size_by_id(hid->base, rpt_id, INPUT_REPORT_INPUT);
+    size_t xfer = hid_get_report_size_by_id(hid->base, rpt_id, INPUT_REPORT_INPUT);
     if (xfer == 0) {
         printf("error reading hid device: unknown report id (%u)!\n", rpt_id);
         mtx_unlock(&hid->fifo.lock);
@@ -309,19 +328,61 @@ static mx_status_t hid_read_instance(void* ctx, void* buf, size_t count, mx_off_
         return ERR_BUFFER_TOO_SMALL;
     }
 
-    r = mx_hid_fifo_read(&hid->fifo, buf, xfer);
-    left = mx_hid_fifo_size(&hid->fifo);
-    if (left == 0) {
+    // drain every complete pending report that fits, so a high-rate device
+    // costs the reader one wakeup and one read per batch
+    size_t total = 0;
+    hid->last_time_count = 0;
+    do {
+        r = mx_hid_fifo_read(&hid->fifo, buf + total, xfer);
+        if (r <= 0) {
+            break;
+        }
+        total += r;
+        if (hid->time_head != hid->time_tail) {
+            hid->last_times[hid->last_time_count++] =
+                hid->times[hid->time_tail++ & HID_PENDING_REPORTS_MASK];
+        }
+
+        if (mx_hid_fifo_peek(&hid->fifo, &rpt_id) < 1) {
+            break;
+        }
+        xfer = hid_get_report_size_by_id(hid->base, rpt_id, INPUT_REPORT_INPUT);
+    } while (xfer > 0 && xfer <= count - total);
+
+    if (mx_hid_fifo_size(&hid->fifo) == 0) {
         device_state_clr(hid->mxdev, DEV_STATE_READABLE);
     }
     mtx_unlock(&hid->fifo.lock);
-    if (r > 0) {
-        *actual = r;
-        r = NO_ERROR;
-    } else if (r == 0) {
-        r = ERR_SHOULD_WAIT;
+    if (total > 0) {
+        *actual = total;
+        return NO_ERROR;
+    }
+    return r < 0 ? r : ERR_SHOULD_WAIT;
+}
+
+static mx_status_t hid_set_read_policy(hid_instance_t* hid, const void* in_buf, size_t in_len) {
+    if (in_len < sizeof(input_read_policy_t)) return ERR_INVALID_ARGS;
+    const input_read_policy_t* policy = in_buf;
+    if (policy->min_reports > HID_MAX_PENDING_REPORTS) return ERR_INVALID_ARGS;
+
+    mtx_lock(&hid->fifo.lock);
+    hid->policy = *policy;
+    mtx_unlock(&hid->fifo.lock);
+    return NO_ERROR;
+}
+
+static mx_status_t hid_get_report_times(hid_instance_t* hid, void* out_buf, size_t out_len,
+                                        size_t* out_actual) {
+    mtx_lock(&hid->fifo.lock);
+    size_t reply_size = hid->last_time_count * sizeof(uint64_t);
+    if (out_len < reply_size) {
+        mtx_unlock(&hid->fifo.lock);
+        return ERR_BUFFER_TOO_SMALL;
     }
-    return r;
+    memcpy(out_buf, hid->last_times, reply_size);
+    mtx_unlock(&hid->fifo.lock);
+    *out_actual = reply_size;
+    return NO_ERROR;
 }
 
 static mx_status_t hid_ioctl_instance(void* ctx, uint32_t op,
@@ -348,6 +409,10 @@ static mx_status_t hid_ioctl_instance(void* ctx, uint32_t op,
         return hid_get_report(hid->base, in_buf, in_len, out_buf, out_len, out_actual);
     case IOCTL_INPUT_SET_REPORT:
         return hid_set_report(hid->base, in_buf, in_len);
+    case IOCTL_INPUT_SET_READ_POLICY:
+        return hid_set_read_policy(hid, in_buf, in_len);
+    case IOCTL_INPUT_GET_REPORT_TIMES:
+        return hid_get_report_times(hid, out_buf, out_len, out_actual);
     }
     return ERR_NOT_SUPPORTED;
 }
@@ -744,6 +809,7 @@ mx_protocol_device_t hid_device_proto = {
 
 void hid_io_queue(void* cookie, const uint8_t* buf, size_t len) {
     hid_device_t* hid = cookie;
+    uint64_t now = mx_time_get(MX_CLOCK_MONOTONIC);
 
     mtx_lock(&hid->instance_lock);
 
@@ -817,7 +883,14 @@ void hid_io_queue(void* cookie, const uint8_t* buf, size_t len) {
         foreach_instance(hid, instance) {
             mtx_lock(&instance->fifo.lock);
             bool was_empty = mx_hid_fifo_size(&instance->fifo) == 0;
-            ssize_t wrote = mx_hid_fifo_write(&instance->fifo, rbuf, rlen);
+            uint32_t pending = instance->time_head - instance->time_tail;
+            ssize_t wrote;
+            if (pending >= HID_MAX_PENDING_REPORTS) {
+                // the timestamp ring is as full as we let the fifo get
+                wrote = ERR_BUFFER_TOO_SMALL;
+            } else {
+                wrote = mx_hid_fifo_write(&instance->fifo, rbuf, rlen);
+            }
 
             if (wrote <= 0) {
                 if (!(instance->flags & HID_FLAGS_WRITE_FAILED)) {
@@ -827,7 +900,19 @@ void hid_io_queue(void* cookie, const uint8_t* buf, size_t len) {
                 }
             } else {
                 instance->flags &= ~HID_FLAGS_WRITE_FAILED;
-                if (was_empty) {
+                instance->times[instance->time_head++ & HID_PENDING_REPORTS_MASK] = now;
+                pending++;
+
+                // with a read policy in place, hold off waking the reader
+                // until a batch has accumulated or the oldest report is
+                // older than the latency bound
+                bool wake = true;
+                if (instance->policy.min_reports > 1 && pending < instance->policy.min_reports) {
+                    uint64_t oldest = instance->times[instance->time_tail & HID_PENDING_REPORTS_MASK];
+                    wake = (instance->policy.max_latency != 0 &&
+                            now - oldest >= instance->policy.max_latency);
+                }
+                if (wake && (was_empty || instance->policy.min_reports > 1)) {
                     device_state_set(instance->mxdev, DEV_STATE_READABLE);
                 }
             }
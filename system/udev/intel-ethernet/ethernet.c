@@ -52,14 +52,18 @@ static int irq_thread(void* arg) {
 
         mtx_lock(&edev->lock);
         if (eth_handle_irq(&edev->eth) & ETH_IRQ_RX) {
-            void* data;
-            size_t len;
+            eth_rx_entry_t entries[ETH_RX_BUDGET];
+            size_t count;
 
-            while (eth_rx(&edev->eth, &data, &len) == NO_ERROR) {
+            // drain the ring in budget-sized batches, handing the
+            // buffers back to hw once per batch
+            while ((count = eth_rx_batch(&edev->eth, entries, ETH_RX_BUDGET)) > 0) {
                 if (edev->ifc) {
-                    edev->ifc->recv(edev->cookie, data, len, 0);
+                    for (size_t i = 0; i < count; i++) {
+                        edev->ifc->recv(edev->cookie, entries[i].data, entries[i].len, 0);
+                    }
                 }
-                eth_rx_ack(&edev->eth);
+                eth_rx_ack_batch(&edev->eth, count);
             }
         }
         mtx_unlock(&edev->lock);
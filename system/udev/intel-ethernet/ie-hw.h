@@ -15,6 +15,7 @@
 #define IE_TXCW      0x0178 // TX Config Word
 #define IE_RXCW      0x0180 // RX Config Word
 #define IE_ICR       0x00C0 // Interrupt Cause Read
+#define IE_ITR       0x00C4 // Interrupt Throttling Rate (256ns units)
 #define IE_ICS       0x00C8 // Interrupt Cause Set
 #define IE_IMS       0x00D0 // Interrupt Mask Set / Read
 #define IE_IMC       0x00D8 // Interrupt Mask Clear
@@ -25,7 +26,8 @@
 #define IE_RDLEN     0x2808 // RX Descriptor Length
 #define IE_RDH       0x2810 // RX Descriptor Head
 #define IE_RDT       0x2818 // RX Descriptor Tail
-#define IE_RDTR      0x3820 // RX Delay Timer
+#define IE_RDTR      0x2820 // RX Interrupt Delay Timer
+#define IE_RADV      0x282C // RX Interrupt Absolute Delay
 
 #define IE_TCTL      0x0400 // Transmit Control
 #define IE_TIPG      0x0410 // TX IPG
@@ -35,6 +37,7 @@
 #define IE_TDH       0x3810 // TX Descriptor Head
 #define IE_TDT       0x3818 // TX Descriptor Tail
 #define IE_TIDV      0x3820 // TX Interrupt Delay Value
+#define IE_TADV      0x382C // TX Interrupt Absolute Delay
 
 #define IE_TXDMAC    0x3000 // TX DMA Control
 #define IE_TXDCTL    0x3828 // TX Descriptor Control
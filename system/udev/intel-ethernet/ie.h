@@ -48,6 +48,9 @@ struct ethdev {
 #define ETH_RXBUF_SIZE  2048
 #define ETH_RXBUF_COUNT 32
 
+// max frames gathered per eth_rx_batch() pass
+#define ETH_RX_BUDGET   16
+
 #define ETH_TXBUF_SIZE  2048
 #define ETH_TXBUF_COUNT 32
 #define ETH_TXBUF_HSIZE 128
@@ -65,8 +68,20 @@ void eth_init_hw(ethdev_t* eth);
 
 void eth_dump_regs(ethdev_t* eth);
 
-status_t eth_rx(ethdev_t* eth, void** data, size_t* len);
-void eth_rx_ack(ethdev_t* eth);
+// one received frame, valid until the descriptor is returned
+// to hw via eth_rx_ack_batch()
+typedef struct eth_rx_entry {
+    void* data;
+    size_t len;
+} eth_rx_entry_t;
+
+// gathers up to max completed rx frames into entries without
+// touching the ring; returns the number gathered (0 if none ready)
+size_t eth_rx_batch(ethdev_t* eth, eth_rx_entry_t* entries, size_t max);
+
+// returns the first count gathered descriptors to hw with a
+// single tail register write
+void eth_rx_ack_batch(ethdev_t* eth, size_t count);
 
 status_t eth_tx(ethdev_t* eth, const void* data, size_t len);
 
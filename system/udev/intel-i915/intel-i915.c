@@ -10,11 +10,15 @@
 #include <hw/pci.h>
 
 #include <assert.h>
+#include <limits.h>
+#include <magenta/device/display.h>
+#include <magenta/listnode.h>
 #include <magenta/syscalls.h>
 #include <magenta/types.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 
 #define INTEL_I915_VID (0x8086)
 #define INTEL_I915_BROADWELL_DID (0x1616)
@@ -25,6 +29,23 @@
 #define BACKLIGHT_CTRL_OFFSET (0xc8250)
 #define BACKLIGHT_CTRL_BIT ((uint32_t)(1u << 31))
 
+// gen8 display engine registers
+// primary plane A surface base address, latched at the next vertical blank
+#define DSPSURF_A_OFFSET (0x7019c)
+// display engine pipe A interrupt registers
+#define DE_PIPE_A_IMR_OFFSET (0x44404)
+#define DE_PIPE_A_IIR_OFFSET (0x44408)
+#define DE_PIPE_A_IER_OFFSET (0x4440c)
+#define DE_PIPE_VBLANK ((uint32_t)(1u << 0))
+// top level interrupt control
+#define MASTER_IRQ_OFFSET (0x44200)
+#define MASTER_IRQ_CONTROL ((uint32_t)(1u << 31))
+#define MASTER_IRQ_DE_PIPE_A ((uint32_t)(1u << 16))
+
+// on gen8 the global GTT occupies the upper half of the register bar,
+// one 64-bit entry per aperture page
+#define GTT_PAGE_PRESENT (1ull << 0)
+
 #define TRACE 0
 
 #if TRACE
@@ -35,6 +56,15 @@
     } while (0)
 #endif
 
+// a client VMO mapped into the display aperture for scanout
+typedef struct intel_i915_image {
+    list_node_t node;
+    uint64_t id;
+    mx_handle_t vmo;
+    uint32_t gtt_offset; // in pages
+    uint32_t num_pages;
+} intel_i915_image_t;
+
 typedef struct intel_i915_device {
     mx_device_t* mxdev;
     void* regs;
@@ -45,11 +75,27 @@ typedef struct intel_i915_device {
     uint64_t framebuffer_size;
     mx_handle_t framebuffer_handle;
 
+    // global GTT (gen8), NULL if this device is not supported for scanout
+    // of client buffers
+    volatile uint64_t* gtt;
+    uint32_t gtt_pages; // aperture size in pages
+    uint32_t fb_pages;  // pages at the start of the aperture reserved for the framebuffer
+
+    mx_handle_t irq_handle;
+    thrd_t irq_thread;
+    mx_handle_t vsync_event;
+
+    mtx_t images_lock;
+    list_node_t images; // imported images, sorted by gtt_offset
+    uint64_t next_image_id;
+    uint64_t scanout_image_id; // 0 = the default framebuffer
+
     mx_display_info_t info;
     uint32_t flags;
 } intel_i915_device_t;
 
 #define FLAGS_BACKLIGHT 1
+#define FLAGS_GTT 2
 
 static void intel_i915_enable_backlight(intel_i915_device_t* dev, bool enable) {
     if (dev->flags & FLAGS_BACKLIGHT) {
@@ -65,6 +111,162 @@ static void intel_i915_enable_backlight(intel_i915_device_t* dev, bool enable) {
     }
 }
 
+// scanout image management
+
+static mx_status_t intel_i915_import_vmo(intel_i915_device_t* device, mx_handle_t vmo,
+                                         ioctl_display_image_t* out) {
+    uint64_t size;
+    mx_status_t status = mx_vmo_get_size(vmo, &size);
+    if (status != NO_ERROR) {
+        return status;
+    }
+    uint32_t num_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (num_pages == 0 || num_pages > device->gtt_pages - device->fb_pages) {
+        return ERR_INVALID_ARGS;
+    }
+
+    mx_paddr_t* paddrs = malloc(num_pages * sizeof(mx_paddr_t));
+    intel_i915_image_t* image = calloc(1, sizeof(intel_i915_image_t));
+    if (!paddrs || !image) {
+        status = ERR_NO_MEMORY;
+        goto fail;
+    }
+
+    status = mx_vmo_op_range(vmo, MX_VMO_OP_COMMIT, 0, size, NULL, 0);
+    if (status != NO_ERROR) {
+        goto fail;
+    }
+    status = mx_vmo_op_range(vmo, MX_VMO_OP_LOOKUP, 0, size,
+                             paddrs, num_pages * sizeof(mx_paddr_t));
+    if (status != NO_ERROR) {
+        goto fail;
+    }
+
+    mtx_lock(&device->images_lock);
+
+    // first fit in the aperture, above the reserved framebuffer pages
+    list_node_t* insert_before = NULL;
+    uint32_t start = device->fb_pages;
+    intel_i915_image_t* other;
+    list_for_every_entry(&device->images, other, intel_i915_image_t, node) {
+        if (other->gtt_offset >= start + num_pages) {
+            insert_before = &other->node;
+            break;
+        }
+        start = other->gtt_offset + other->num_pages;
+    }
+    if (start + num_pages > device->gtt_pages) {
+        mtx_unlock(&device->images_lock);
+        status = ERR_NO_RESOURCES;
+        goto fail;
+    }
+
+    image->id = ++device->next_image_id;
+    image->vmo = vmo;
+    image->gtt_offset = start;
+    image->num_pages = num_pages;
+    if (insert_before) {
+        list_add_before(insert_before, &image->node);
+    } else {
+        list_add_tail(&device->images, &image->node);
+    }
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        device->gtt[start + i] = paddrs[i] | GTT_PAGE_PRESENT;
+    }
+    // posting read so the entries are visible before the client flips to them
+    (void)device->gtt[start + num_pages - 1];
+
+    mtx_unlock(&device->images_lock);
+
+    out->id = image->id;
+    out->length = (uint64_t)num_pages * PAGE_SIZE;
+    free(paddrs);
+    return NO_ERROR;
+
+fail:
+    free(paddrs);
+    free(image);
+    return status;
+}
+
+static mx_status_t intel_i915_release_image(intel_i915_device_t* device, uint64_t id) {
+    mtx_lock(&device->images_lock);
+    intel_i915_image_t* image;
+    list_for_every_entry(&device->images, image, intel_i915_image_t, node) {
+        if (image->id != id) {
+            continue;
+        }
+        if (device->scanout_image_id == id) {
+            mtx_unlock(&device->images_lock);
+            return ERR_BAD_STATE;
+        }
+        for (uint32_t i = 0; i < image->num_pages; i++) {
+            device->gtt[image->gtt_offset + i] = 0;
+        }
+        list_delete(&image->node);
+        mtx_unlock(&device->images_lock);
+        mx_handle_close(image->vmo);
+        free(image);
+        return NO_ERROR;
+    }
+    mtx_unlock(&device->images_lock);
+    return ERR_NOT_FOUND;
+}
+
+static mx_status_t intel_i915_flip(intel_i915_device_t* device, uint64_t id) {
+    mtx_lock(&device->images_lock);
+    uint32_t offset = 0; // the default framebuffer sits at the start of the aperture
+    if (id != 0) {
+        intel_i915_image_t* image;
+        bool found = false;
+        list_for_every_entry(&device->images, image, intel_i915_image_t, node) {
+            if (image->id == id) {
+                offset = image->gtt_offset * PAGE_SIZE;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            mtx_unlock(&device->images_lock);
+            return ERR_NOT_FOUND;
+        }
+    }
+    // the surface base address is double buffered in hardware; the write
+    // takes effect at the next vertical blank, so there is no tearing
+    void* dspsurf = (uint8_t*)device->regs + DSPSURF_A_OFFSET;
+    pcie_write32(dspsurf, offset);
+    device->scanout_image_id = id;
+    mtx_unlock(&device->images_lock);
+    return NO_ERROR;
+}
+
+static int intel_i915_irq_thread(void* arg) {
+    intel_i915_device_t* device = arg;
+    void* iir = (uint8_t*)device->regs + DE_PIPE_A_IIR_OFFSET;
+
+    while (1) {
+        mx_status_t wait_res = mx_interrupt_wait(device->irq_handle);
+        if (wait_res != NO_ERROR) {
+            if (wait_res != ERR_CANCELED) {
+                printf("i915: unexpected interrupt wait failure (%d)\n", wait_res);
+            }
+            mx_interrupt_complete(device->irq_handle);
+            break;
+        }
+
+        uint32_t pending = pcie_read32(iir);
+        if (pending & DE_PIPE_VBLANK) {
+            // write 1 to clear
+            pcie_write32(iir, DE_PIPE_VBLANK);
+            // the client clears the signal after waiting on it
+            mx_object_signal(device->vsync_event, 0, MX_USER_SIGNAL_0);
+        }
+        mx_interrupt_complete(device->irq_handle);
+    }
+    return 0;
+}
+
 // implement display protocol
 
 static mx_status_t intel_i915_set_mode(mx_device_t* dev, mx_display_info_t* info) {
@@ -103,10 +305,77 @@ static mx_status_t intel_i915_close(void* ctx, uint32_t flags) {
     return NO_ERROR;
 }
 
+static mx_status_t intel_i915_ioctl(void* ctx, uint32_t op,
+                                    const void* in_buf, size_t in_len,
+                                    void* out_buf, size_t out_len, size_t* out_actual) {
+    intel_i915_device_t* device = ctx;
+
+    switch (op) {
+    case IOCTL_DISPLAY_IMPORT_VMO: {
+        if (in_len < sizeof(mx_handle_t)) return ERR_INVALID_ARGS;
+        mx_handle_t vmo = *((mx_handle_t*)in_buf);
+        if (!device->gtt) {
+            mx_handle_close(vmo);
+            return ERR_NOT_SUPPORTED;
+        }
+        if (out_len < sizeof(ioctl_display_image_t)) {
+            mx_handle_close(vmo);
+            return ERR_INVALID_ARGS;
+        }
+        mx_status_t status = intel_i915_import_vmo(device, vmo, out_buf);
+        if (status != NO_ERROR) {
+            mx_handle_close(vmo);
+            return status;
+        }
+        *out_actual = sizeof(ioctl_display_image_t);
+        return NO_ERROR;
+    }
+    case IOCTL_DISPLAY_RELEASE_VMO: {
+        if (!device->gtt) return ERR_NOT_SUPPORTED;
+        if (in_len < sizeof(uint64_t)) return ERR_INVALID_ARGS;
+        return intel_i915_release_image(device, *((uint64_t*)in_buf));
+    }
+    case IOCTL_DISPLAY_FLIP: {
+        if (!device->gtt) return ERR_NOT_SUPPORTED;
+        if (in_len < sizeof(uint64_t)) return ERR_INVALID_ARGS;
+        return intel_i915_flip(device, *((uint64_t*)in_buf));
+    }
+    case IOCTL_DISPLAY_GET_VSYNC_EVENT: {
+        if (device->vsync_event == MX_HANDLE_INVALID) return ERR_NOT_SUPPORTED;
+        if (out_len < sizeof(mx_handle_t)) return ERR_INVALID_ARGS;
+        mx_status_t status = mx_handle_duplicate(device->vsync_event, MX_RIGHT_SAME_RIGHTS,
+                                                 (mx_handle_t*)out_buf);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        *out_actual = sizeof(mx_handle_t);
+        return NO_ERROR;
+    }
+    default:
+        return ERR_NOT_SUPPORTED;
+    }
+}
+
 static void intel_i915_release(void* ctx) {
     intel_i915_device_t* device = ctx;
     intel_i915_enable_backlight(device, false);
 
+    if (device->irq_handle != MX_HANDLE_INVALID) {
+        mx_interrupt_signal(device->irq_handle);
+        thrd_join(device->irq_thread, NULL);
+        mx_handle_close(device->irq_handle);
+    }
+
+    if (device->vsync_event != MX_HANDLE_INVALID) {
+        mx_handle_close(device->vsync_event);
+    }
+
+    intel_i915_image_t* image;
+    while ((image = list_remove_head_type(&device->images, intel_i915_image_t, node)) != NULL) {
+        mx_handle_close(image->vmo);
+        free(image);
+    }
+
     if (device->regs) {
         mx_handle_close(device->regs_handle);
         device->regs_handle = -1;
@@ -124,6 +393,7 @@ static mx_protocol_device_t intel_i915_device_proto = {
     .version = DEVICE_OPS_VERSION,
     .open = intel_i915_open,
     .close = intel_i915_close,
+    .ioctl = intel_i915_ioctl,
     .release = intel_i915_release,
 };
 
@@ -143,6 +413,11 @@ static mx_status_t intel_i915_bind(mx_driver_t* drv, mx_device_t* dev, void** co
     if (!device)
         return ERR_NO_MEMORY;
 
+    list_initialize(&device->images);
+    mtx_init(&device->images_lock, mtx_plain);
+    device->irq_handle = MX_HANDLE_INVALID;
+    device->vsync_event = MX_HANDLE_INVALID;
+
     const pci_config_t* pci_config;
     mx_handle_t cfg_handle = MX_HANDLE_INVALID;
     status = pci->get_config(dev, &pci_config, &cfg_handle);
@@ -150,6 +425,9 @@ static mx_status_t intel_i915_bind(mx_driver_t* drv, mx_device_t* dev, void** co
         if (pci_config->device_id == INTEL_I915_BROADWELL_DID) {
             // TODO: this should be based on the specific target
             device->flags |= FLAGS_BACKLIGHT;
+            // gen8 GTT layout; other generations differ, so only manage the
+            // aperture where we know the entry format
+            device->flags |= FLAGS_GTT;
         }
         mx_handle_close(cfg_handle);
     }
@@ -186,6 +464,46 @@ static mx_status_t intel_i915_bind(mx_driver_t* drv, mx_device_t* dev, void** co
     }
     di->flags = MX_DISPLAY_FLAG_HW_FRAMEBUFFER;
 
+    if (device->flags & FLAGS_GTT) {
+        // the global GTT occupies the upper half of the register bar
+        device->gtt = (volatile uint64_t*)((uint8_t*)device->regs + device->regs_size / 2);
+        device->gtt_pages = (device->regs_size / 2) / sizeof(uint64_t);
+        if ((uint64_t)device->gtt_pages * PAGE_SIZE > device->framebuffer_size) {
+            device->gtt_pages = device->framebuffer_size / PAGE_SIZE;
+        }
+        // reserve the bootloader framebuffer at the start of the aperture;
+        // use 4 bytes per pixel as an upper bound since the bootloader does
+        // not report the pixel size
+        uint64_t fb_bytes = (uint64_t)di->stride * di->height * 4;
+        device->fb_pages = (fb_bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+
+        // set up the vsync interrupt: unmask the pipe A vblank and enable
+        // it at the display engine and master levels
+        status = pci->set_irq_mode(dev, MX_PCIE_IRQ_MODE_MSI, 1);
+        if (status < 0) {
+            status = pci->set_irq_mode(dev, MX_PCIE_IRQ_MODE_LEGACY, 1);
+        }
+        if (status == NO_ERROR) {
+            status = pci->map_interrupt(dev, 0, &device->irq_handle);
+        }
+        if (status == NO_ERROR && mx_event_create(0, &device->vsync_event) == NO_ERROR) {
+            void* imr = (uint8_t*)device->regs + DE_PIPE_A_IMR_OFFSET;
+            void* ier = (uint8_t*)device->regs + DE_PIPE_A_IER_OFFSET;
+            void* master = (uint8_t*)device->regs + MASTER_IRQ_OFFSET;
+            pcie_write32(imr, pcie_read32(imr) & ~DE_PIPE_VBLANK);
+            pcie_write32(ier, pcie_read32(ier) | DE_PIPE_VBLANK);
+            pcie_write32(master, MASTER_IRQ_CONTROL | MASTER_IRQ_DE_PIPE_A);
+            thrd_create_with_name(&device->irq_thread, intel_i915_irq_thread, device,
+                                  "i915-irq");
+        } else {
+            xprintf("i915: no vsync interrupt (%d)\n", status);
+            if (device->irq_handle != MX_HANDLE_INVALID) {
+                mx_handle_close(device->irq_handle);
+                device->irq_handle = MX_HANDLE_INVALID;
+            }
+        }
+    }
+
     // TODO remove when the gfxconsole moves to user space
     intel_i915_enable_backlight(device, true);
     mx_set_framebuffer(get_root_resource(), device->framebuffer, device->framebuffer_size,
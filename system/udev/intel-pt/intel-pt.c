@@ -641,6 +641,100 @@ static mx_status_t x86_pt_cpu_mode_stop(ipt_device_t* ipt_dev) {
     return NO_ERROR;
 }
 
+// Copy |size| bytes of trace data ending at linear offset |end| out of
+// |per_trace|'s circular buffer into |vmo|, oldest bytes first.
+static mx_status_t x86_pt_copy_snapshot(const ipt_per_trace_state_t* per_trace,
+                                        size_t end, size_t size, mx_handle_t vmo) {
+    size_t buffer_size = (size_t)PAGE_SIZE << per_trace->buffer_order;
+    size_t total_size = buffer_size * per_trace->num_buffers;
+    size_t src = (end + total_size - size) % total_size;
+    size_t vmo_off = 0;
+
+    while (size > 0) {
+        uint32_t buffer = (uint32_t)(src / buffer_size);
+        size_t offset = src % buffer_size;
+        size_t chunk = buffer_size - offset;
+        if (chunk > size)
+            chunk = size;
+        const uint8_t* virt = io_buffer_virt(&per_trace->buffers[buffer]);
+        size_t actual;
+        mx_status_t status = mx_vmo_write(vmo, virt + offset, vmo_off, chunk, &actual);
+        if (status != NO_ERROR)
+            return status;
+        if (actual != chunk)
+            return ERR_IO;
+        vmo_off += chunk;
+        src = (src + chunk) % total_size;
+        size -= chunk;
+    }
+
+    return NO_ERROR;
+}
+
+// Freeze one cpu's trace just long enough to copy out the last |req->size|
+// bytes into a new VMO, then resume it. Collection on all other cpus is
+// undisturbed, so this can be used for always-on crash forensics.
+static mx_status_t x86_pt_snapshot(ipt_device_t* ipt_dev, const ioctl_ipt_snapshot_req_t* req,
+                                   mx_handle_t* out_vmo, uint32_t* out_size) {
+    if (!ipt_dev->active)
+        return ERR_BAD_STATE;
+    if (ipt_dev->mode != IPT_TRACE_CPUS)
+        return ERR_BAD_STATE;
+    if (req->descriptor >= ipt_dev->num_traces)
+        return ERR_INVALID_ARGS;
+    ipt_per_trace_state_t* per_trace = &ipt_dev->per_trace_state[req->descriptor];
+    if (!per_trace->allocated)
+        return ERR_INVALID_ARGS;
+    // Snapshotting is for continuous ring-mode tracing; a stop-on-full
+    // buffer is read with the usual stop + get-buffer-handle path.
+    if (!per_trace->is_circular)
+        return ERR_INVALID_ARGS;
+
+    mx_handle_t resource = get_root_resource();
+    mx_x86_pt_regs_t regs;
+    mx_status_t status = mx_mtrace_control(resource, MTRACE_KIND_IPT, MTRACE_IPT_CPU_MODE_PAUSE,
+                                           MTRACE_IPT_OPTIONS(req->descriptor),
+                                           &regs, sizeof(regs));
+    if (status != NO_ERROR)
+        return status;
+
+    // Record the frozen write head so compute_capture_size sees it.
+    per_trace->status = regs.status;
+    per_trace->output_base = regs.output_base;
+    per_trace->output_mask_ptrs = regs.output_mask_ptrs;
+
+    size_t buffer_size = (size_t)PAGE_SIZE << per_trace->buffer_order;
+    size_t total_size = buffer_size * per_trace->num_buffers;
+    size_t end = compute_capture_size(ipt_dev, per_trace);
+    size_t size = req->size;
+    if (size == 0 || size > total_size)
+        size = total_size;
+
+    mx_handle_t vmo = MX_HANDLE_INVALID;
+    status = mx_vmo_create(size, 0, &vmo);
+    if (status == NO_ERROR) {
+        status = x86_pt_copy_snapshot(per_trace, end, size, vmo);
+        if (status != NO_ERROR) {
+            mx_handle_close(vmo);
+            vmo = MX_HANDLE_INVALID;
+        }
+    }
+
+    mx_status_t resume_status =
+        mx_mtrace_control(resource, MTRACE_KIND_IPT, MTRACE_IPT_CPU_MODE_RESUME,
+                          MTRACE_IPT_OPTIONS(req->descriptor), NULL, 0);
+    if (status == NO_ERROR && resume_status != NO_ERROR) {
+        mx_handle_close(vmo);
+        status = resume_status;
+    }
+    if (status != NO_ERROR)
+        return status;
+
+    *out_vmo = vmo;
+    *out_size = (uint32_t)size;
+    return NO_ERROR;
+}
+
 // Release resources acquired by x86_pt_cpu_mode_alloc.
 // Also free any buffers allocated.
 static mx_status_t x86_pt_cpu_mode_free(ipt_device_t* ipt_dev) {
@@ -843,6 +937,26 @@ static mx_status_t ipt_get_buffer_handle(ipt_device_t* ipt_dev,
     return NO_ERROR;
 }
 
+static mx_status_t ipt_snapshot(ipt_device_t* ipt_dev,
+                            const void* cmd, size_t cmdlen,
+                            void* reply, size_t max, size_t* out_actual) {
+    ioctl_ipt_snapshot_req_t req;
+    ioctl_ipt_snapshot_rsp_t rsp;
+
+    if (cmdlen != sizeof(req))
+        return ERR_INVALID_ARGS;
+    if (max < sizeof(rsp))
+        return ERR_BUFFER_TOO_SMALL;
+
+    memcpy(&req, cmd, sizeof(req));
+    mx_status_t status = x86_pt_snapshot(ipt_dev, &req, &rsp.vmo, &rsp.size);
+    if (status != NO_ERROR)
+        return status;
+    memcpy(reply, &rsp, sizeof(rsp));
+    *out_actual = sizeof(rsp);
+    return NO_ERROR;
+}
+
 static mx_status_t ipt_free_buffer(ipt_device_t* ipt_dev,
                                const void* cmd, size_t cmdlen,
                                void* reply, size_t max) {
@@ -878,6 +992,8 @@ static mx_status_t ipt_ioctl1(ipt_device_t* ipt_dev, uint32_t op,
         return ipt_get_buffer_handle(ipt_dev, cmd, cmdlen, reply, max, out_actual);
     case IOCTL_IPT_FREE_BUFFER:
         return ipt_free_buffer(ipt_dev, cmd, cmdlen, reply, max);
+    case IOCTL_IPT_SNAPSHOT:
+        return ipt_snapshot(ipt_dev, cmd, cmdlen, reply, max, out_actual);
 
     case IOCTL_IPT_CPU_MODE_ALLOC:
         if (cmdlen != 0 || max != 0)
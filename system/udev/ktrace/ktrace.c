@@ -65,6 +65,33 @@ static mx_status_t ktrace_ioctl(void* ctx, uint32_t op,
         *out_actual = sizeof(uint32_t);
         return NO_ERROR;
     }
+    case IOCTL_KTRACE_GET_CPU_COUNT: {
+        if (max < sizeof(uint32_t)) {
+            return ERR_BUFFER_TOO_SMALL;
+        }
+        mx_status_t status = mx_ktrace_control(get_root_resource(),
+                                               KTRACE_ACTION_GET_CPU_COUNT, 0, NULL);
+        if (status < 0) {
+            return status;
+        }
+        *((uint32_t*) reply) = status;
+        *out_actual = sizeof(uint32_t);
+        return NO_ERROR;
+    }
+    case IOCTL_KTRACE_GET_CPU_STREAM: {
+        if ((cmdlen != sizeof(uint32_t)) || (max < sizeof(ktrace_cpu_stream_t))) {
+            return ERR_INVALID_ARGS;
+        }
+        uint32_t cpu;
+        memcpy(&cpu, cmd, sizeof(cpu));
+        mx_status_t status = mx_ktrace_control(get_root_resource(),
+                                               KTRACE_ACTION_GET_CPU_STREAM, cpu, reply);
+        if (status < 0) {
+            return status;
+        }
+        *out_actual = sizeof(ktrace_cpu_stream_t);
+        return NO_ERROR;
+    }
     default:
         return ERR_INVALID_ARGS;
     }
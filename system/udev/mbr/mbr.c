@@ -72,6 +72,13 @@ typedef struct mbrpart_device {
     mbr_partition_entry_t partition;
     block_info_t info;
     block_callbacks_t* callbacks;
+
+    // the underlying BLOCK_CORE device and its ops, or NULL if no such
+    // device is reachable; when set, requests are remapped in place and
+    // handed straight down instead of being re-issued as iotxns
+    mx_device_t* parent_core;
+    block_ops_t* parent_ops;
+
     atomic_int writercount;
 } mbrpart_device_t;
 
@@ -210,6 +217,12 @@ static mx_protocol_device_t mbr_proto = {
 static void mbr_block_set_callbacks(mx_device_t* dev, block_callbacks_t* cb) {
     mbrpart_device_t* device = dev->ctx;
     device->callbacks = cb;
+    // completions are routed by cookie, so the parent can share the same
+    // callback table; this lets remapped requests go straight down without
+    // an iotxn in between
+    if (device->parent_ops != NULL) {
+        device->parent_ops->set_callbacks(device->parent_core, cb);
+    }
 }
 
 static void mbr_block_get_info(mx_device_t* dev, block_info_t* info) {
@@ -231,11 +244,25 @@ static void block_do_txn(mbrpart_device_t* dev, uint32_t opcode, mx_handle_t vmo
         return;
     }
     uint64_t size = getsize(dev);
-    if ((dev_offset >= size) || (length >= (size - dev_offset))) {
+    if ((dev_offset > size) || (length > (size - dev_offset))) {
         dev->callbacks->complete(cookie, ERR_OUT_OF_RANGE);
         return;
     }
 
+    // fast path: when the parent speaks the block protocol, remap the offset
+    // in place and hand the request down with no allocation or extra
+    // completion hop
+    if (dev->parent_ops != NULL) {
+        if (opcode == IOTXN_OP_READ) {
+            dev->parent_ops->read(dev->parent_core, vmo, length, vmo_offset,
+                                  to_parent_offset(dev, dev_offset), cookie);
+        } else {
+            dev->parent_ops->write(dev->parent_core, vmo, length, vmo_offset,
+                                   to_parent_offset(dev, dev_offset), cookie);
+        }
+        return;
+    }
+
     mx_status_t status;
     iotxn_t* txn;
     if ((status = iotxn_alloc_vmo(&txn, IOTXN_ALLOC_POOL, vmo, vmo_offset, length)) != NO_ERROR) {
@@ -259,11 +286,22 @@ static void mbr_block_write(mx_device_t* dev, mx_handle_t vmo, uint64_t length,
     block_do_txn((mbrpart_device_t*)dev->ctx, IOTXN_OP_WRITE, vmo, length, vmo_offset, dev_offset, cookie);
 }
 
+static void mbr_block_flush(mx_device_t* dev, void* cookie) {
+    mbrpart_device_t* device = dev->ctx;
+    if ((device->parent_ops != NULL) && (device->parent_ops->flush != NULL)) {
+        device->parent_ops->flush(device->parent_core, cookie);
+        return;
+    }
+    // No flush path to the parent; treat its cache as write-through.
+    device->callbacks->complete(cookie, NO_ERROR);
+}
+
 static block_ops_t mbr_block_ops = {
     .set_callbacks = mbr_block_set_callbacks,
     .get_info = mbr_block_get_info,
     .read = mbr_block_read,
     .write = mbr_block_write,
+    .flush = mbr_block_flush,
 };
 
 static int mbr_bind_thread(void* arg) {
@@ -283,6 +321,20 @@ static int mbr_bind_thread(void* arg) {
         goto unbind;
     }
 
+    // find the BLOCK_CORE device this block device sits on, if any, so
+    // partition requests can be remapped in place and passed through
+    // without an intermediate iotxn
+    mx_device_t* core_dev = dev;
+    block_ops_t* parent_ops = NULL;
+    if (device_op_get_protocol(core_dev, MX_PROTOCOL_BLOCK_CORE, (void**)&parent_ops) != NO_ERROR) {
+        core_dev = dev->parent;
+        if ((core_dev == NULL) ||
+            (device_op_get_protocol(core_dev, MX_PROTOCOL_BLOCK_CORE, (void**)&parent_ops) != NO_ERROR)) {
+            core_dev = NULL;
+            parent_ops = NULL;
+        }
+    }
+
     // We need to read at least 512B to parse the MBR. Determine if we should
     // read the device's block size or we should ready exactly 512B.
     size_t iotxn_size = 0;
@@ -352,6 +404,8 @@ static int mbr_bind_thread(void* arg) {
             goto unbind;
         }
         pdev->parent = dev;
+        pdev->parent_core = core_dev;
+        pdev->parent_ops = parent_ops;
 
         memcpy(&pdev->partition, entry, sizeof(*entry));
         block_info.block_count = pdev->partition.sector_partition_length;
@@ -55,7 +55,12 @@ static mx_status_t psd_read(void* ctx, void* buf, size_t count, mx_off_t off, si
     mtx_lock(&psd->srv.lock);
     bool was_full = pty_fifo_is_full(&psd->fifo);
     size_t length = pty_fifo_read(&psd->fifo, buf, count);
-    if (pty_fifo_is_empty(&psd->fifo)) {
+    if (length < count) {
+        // top up from the active client's shared output ring, so bulk
+        // output lands in one read once the fifo is drained
+        length += pty_server_ring_read_locked(&psd->srv, buf + length, count - length);
+    }
+    if (pty_fifo_is_empty(&psd->fifo) && pty_server_ring_is_empty_locked(&psd->srv)) {
         device_state_clr(psd->srv.mxdev, DEV_STATE_READABLE);
     }
     if (was_full && length) {
@@ -123,6 +123,21 @@ static mx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd,
         device_remove(ramdev->mxdev);
         return NO_ERROR;
     }
+    case IOCTL_RAMDISK_GET_VMO: {
+        if (max < sizeof(mx_handle_t)) {
+            return ERR_BUFFER_TOO_SMALL;
+        }
+        // Let the client map the backing store directly; aligned bulk
+        // transfers can then bypass the copy through the block protocol.
+        mx_handle_t vmo;
+        mx_status_t status = mx_handle_duplicate(ramdev->vmo, MX_RIGHT_SAME_RIGHTS, &vmo);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        memcpy(reply, &vmo, sizeof(vmo));
+        *out_actual = sizeof(vmo);
+        return NO_ERROR;
+    }
     // Block Protocol
     case IOCTL_BLOCK_GET_NAME: {
         char* name = reply;
@@ -213,27 +213,40 @@ static bool cmd_is_queued(uint8_t cmd) {
 }
 
 static void ahci_port_complete_txn(ahci_device_t* dev, ahci_port_t* port, mx_status_t status) {
-    iotxn_t* txn;
+    iotxn_t* done_txns[AHCI_MAX_COMMANDS];
+    int done_count = 0;
+
+    // queued commands clear their sact bit on completion, non-queued commands
+    // clear their ci bit, so a single snapshot of both covers every slot
     uint32_t sact = ahci_read(&port->regs->sact);
-    for (int i = 0; i < AHCI_MAX_COMMANDS; i++) {
-        txn = port->commands[i];
-        if (txn == NULL) {
-            continue;
-        }
-        if (!(sact & (1 << i))) {
-            mtx_lock(&port->lock);
-            // clear state before calling the complete() hook
-            port->running &= ~(1 << i);
-            port->commands[i] = NULL;
+    uint32_t ci = ahci_read(&port->regs->ci);
 
-            // resume the port if paused for sync and no outstanding transactions
-            if ((port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) && !port->running) {
-                port->flags &= ~AHCI_PORT_FLAG_SYNC_PAUSED;
-            }
-            mtx_unlock(&port->lock);
+    mtx_lock(&port->lock);
+    uint32_t done;
+    if (status == NO_ERROR) {
+        done = port->running & ~(sact | ci);
+    } else {
+        // on error the device aborts everything outstanding; ci bits for the
+        // failed commands may still be set, so fail the whole queue
+        done = port->running;
+    }
+    // clear state before calling the complete() hooks
+    while (done) {
+        int i = __builtin_ctz(done);
+        done &= ~(1 << i);
+        done_txns[done_count++] = port->commands[i];
+        port->commands[i] = NULL;
+        port->running &= ~(1 << i);
+    }
 
-            iotxn_complete(txn, status, txn->length);
-        }
+    // resume the port if paused for sync and no outstanding transactions
+    if ((port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) && !port->running) {
+        port->flags &= ~AHCI_PORT_FLAG_SYNC_PAUSED;
+    }
+    mtx_unlock(&port->lock);
+
+    for (int i = 0; i < done_count; i++) {
+        iotxn_complete(done_txns[i], status, done_txns[i]->length);
     }
     // hit the worker thread to do the next txn
     completion_signal(&dev->worker_completion);
@@ -496,35 +509,38 @@ static int ahci_worker_thread(void* arg) {
                 goto next;
             }
 
-            txn = list_peek_head_type(&port->txn_list, iotxn_t, node);
-            if (!txn) {
-                goto next;
-            }
+            // issue commands until the queue drains or every usable slot is busy,
+            // so the device always has a full queue to schedule against
+            while ((txn = list_peek_head_type(&port->txn_list, iotxn_t, node)) != NULL) {
+                // if IOTXN_SYNC_BEFORE, pause the port if there are transactions in flight
+                if ((txn->flags & IOTXN_SYNC_BEFORE) && port->running) {
+                    port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                    break;
+                }
 
-            // if IOTXN_SYNC_BEFORE, pause the port if there are transactions in flight
-            if ((txn->flags & IOTXN_SYNC_BEFORE) && port->running) {
-                port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
-                goto next;
-            }
+                // find a free command tag
+                sata_pdata_t* pdata = sata_iotxn_pdata(txn);
+                int max = MIN(pdata->max_cmd, (int)((dev->cap >> 8) & 0x1f));
+                int slot = 0;
+                for (slot = 0; slot <= max; slot++) {
+                    if (!ahci_port_cmd_busy(port, slot)) break;
+                }
+                if (slot > max) {
+                    break;
+                }
 
-            // find a free command tag
-            sata_pdata_t* pdata = sata_iotxn_pdata(txn);
-            int max = MIN(pdata->max_cmd, (int)((dev->cap >> 8) & 0x1f));
-            int i = 0;
-            for (i = 0; i <= max; i++) {
-                if (!ahci_port_cmd_busy(port, i)) break;
-            }
-            if (i > max) {
-                goto next;
-            }
+                list_delete(&txn->node);
+                // if IOTXN_SYNC_AFTER, pause the port until this command is complete
+                if (txn->flags & IOTXN_SYNC_AFTER) {
+                    port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                }
+                // run the command
+                ahci_do_txn(dev, port, slot, txn);
 
-            list_delete(&txn->node);
-            // if IOTXN_SYNC_AFTER, pause the port until this command is complete
-            if (txn->flags & IOTXN_SYNC_AFTER) {
-                port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                if (port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) {
+                    break;
+                }
             }
-            // run the command
-            ahci_do_txn(dev, port, i, txn);
 next:
             mtx_unlock(&port->lock);
         }
@@ -584,13 +600,10 @@ static void ahci_port_irq(ahci_device_t* dev, int nr) {
     uint32_t is = ahci_read(&port->regs->is);
     ahci_write(&port->regs->is, is);
 
-    if (is & AHCI_PORT_INT_DHR) { // RFIS received
-        ahci_port_complete_txn(dev, port, NO_ERROR);
-    }
-    if (is & AHCI_PORT_INT_PS) { // PSFIS rcv
-        ahci_port_complete_txn(dev, port, NO_ERROR);
-    }
-    if (is & AHCI_PORT_INT_SDB) { // SDBFIS
+    // RFIS, PSFIS and SDBFIS all signal command completion; a single scan of
+    // the completion bitmaps retires everything that finished since the last
+    // interrupt, even when multiple queued commands completed at once
+    if (is & (AHCI_PORT_INT_DHR | AHCI_PORT_INT_PS | AHCI_PORT_INT_SDB)) {
         ahci_port_complete_txn(dev, port, NO_ERROR);
     }
     if (is & AHCI_PORT_INT_PRC) { // PhyRdy change
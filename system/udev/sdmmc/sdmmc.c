@@ -36,6 +36,11 @@
 #define SDMMC_STATE_RECV 0x5
 #define SDMMC_STATE_DATA 0x6
 
+// Size of the pre-allocated bounce buffer used for data commands. The host
+// controller requires physically contiguous buffers, so requests larger than
+// this are split into multi-block commands of this size.
+#define SDMMC_MAX_TRANSFER (SDHC_BLOCK_SIZE * 64)
+
 #define TRACE 0
 
 #if TRACE
@@ -55,6 +60,24 @@ typedef struct sdmmc {
     mx_device_t* sdmmc_mxdev;
     uint16_t rca;
     uint64_t capacity;
+
+    // Pre-allocated contiguous bounce buffer for data commands, so the data
+    // path never hits the allocator.
+    iotxn_t* data_txn;
+
+    // The card is known to be in TRAN state, so the SEND_STATUS probe before
+    // the next data command can be skipped.
+    bool card_in_tran;
+
+    thrd_t worker_thread;
+    bool dead;
+
+    // list of queued io transactions, drained by the worker thread
+    list_node_t queued_iotxns;
+
+    completion_t iotxn_completion;  // signals the worker when new iotxns arrive
+                                    // and when the device is unbound
+    mtx_t iotxn_lock;               // protects queued_iotxns and dead
 } sdmmc_t;
 
 static void sdmmc_txn_cplt(iotxn_t* request, void* cookie) {
@@ -112,11 +135,22 @@ static mx_status_t sdmmc_ioctl(void* ctx, uint32_t op, const void* cmd,
 
 static void sdmmc_unbind(void* ctx) {
     sdmmc_t* sdmmc = ctx;
+
+    // terminate our worker thread
+    mtx_lock(&sdmmc->iotxn_lock);
+    sdmmc->dead = true;
+    mtx_unlock(&sdmmc->iotxn_lock);
+    completion_signal(&sdmmc->iotxn_completion);
+    thrd_join(sdmmc->worker_thread, NULL);
+
     device_remove(sdmmc->mxdev);
 }
 
 static void sdmmc_release(void* ctx) {
     sdmmc_t* sdmmc = ctx;
+    if (sdmmc->data_txn) {
+        iotxn_release(sdmmc->data_txn);
+    }
     free(sdmmc);
 }
 
@@ -137,104 +171,162 @@ static void sdmmc_iotxn_queue(void* ctx, iotxn_t* txn) {
         return;
     }
 
-    iotxn_t* emmc_txn = NULL;
+    if (txn->opcode != IOTXN_OP_READ && txn->opcode != IOTXN_OP_WRITE) {
+        iotxn_complete(txn, ERR_INVALID_ARGS, 0);
+        return;
+    }
+
+    // Hand the txn to the worker thread so the caller is never blocked behind
+    // the card and the controller starts the next command as soon as the
+    // previous one retires.
     sdmmc_t* sdmmc = ctx;
+    mtx_lock(&sdmmc->iotxn_lock);
+    list_add_tail(&sdmmc->queued_iotxns, &txn->node);
+    mtx_unlock(&sdmmc->iotxn_lock);
+    completion_signal(&sdmmc->iotxn_completion);
+}
+
+static void sdmmc_do_txn(sdmmc_t* sdmmc, iotxn_t* txn) {
     mx_device_t* sdmmc_mxdev = sdmmc->sdmmc_mxdev;
-    uint32_t cmd = 0;
-
-    // Figure out which SD command we need to issue.
-    switch(txn->opcode) {
-        case IOTXN_OP_READ:
-            if (txn->length > SDHC_BLOCK_SIZE) {
-                cmd = SDMMC_READ_MULTIPLE_BLOCK;
-            } else {
-                cmd = SDMMC_READ_BLOCK;
+    iotxn_t* emmc_txn = sdmmc->data_txn;
+    sdmmc_protocol_data_t* pdata = iotxn_pdata(emmc_txn, sdmmc_protocol_data_t);
+
+    // A data command that completed normally leaves the card back in TRAN
+    // state (multi-block commands carry AUTO12), so the SEND_STATUS probe is
+    // only needed for the first command and after an error.
+    if (!sdmmc->card_in_tran) {
+        uint8_t current_state;
+        const size_t max_attempts = 10;
+        size_t attempt = 0;
+        for (; attempt <= max_attempts; attempt++) {
+            mx_status_t rc = sdmmc_do_command(sdmmc_mxdev, SDMMC_SEND_STATUS,
+                                              sdmmc->rca << 16, emmc_txn);
+            if (rc != NO_ERROR) {
+                iotxn_complete(txn, rc, 0);
+                return;
             }
-            break;
-        case IOTXN_OP_WRITE:
-            if (txn->length > SDHC_BLOCK_SIZE) {
-                cmd = SDMMC_WRITE_MULTIPLE_BLOCK;
-            } else {
-                cmd = SDMMC_WRITE_BLOCK;
+
+            current_state = (pdata->response[0] >> 9) & 0xf;
+
+            if (current_state == SDMMC_STATE_RECV) {
+                rc = sdmmc_do_command(sdmmc_mxdev, SDMMC_STOP_TRANSMISSION, 0, emmc_txn);
+                continue;
+            } else if (current_state == SDMMC_STATE_TRAN) {
+                break;
             }
-            break;
-        default:
-            // Invalid opcode?
-            iotxn_complete(txn, ERR_INVALID_ARGS, 0);
+
+            mx_nanosleep(mx_deadline_after(MX_MSEC(10)));
+        }
+
+        if (attempt == max_attempts) {
+            // Too many retries, fail.
+            iotxn_complete(txn, ERR_BAD_STATE, 0);
             return;
+        }
+        sdmmc->card_in_tran = true;
     }
 
-    if (iotxn_alloc(&emmc_txn, IOTXN_ALLOC_CONTIGUOUS | IOTXN_ALLOC_POOL, txn->length) != NO_ERROR) {
-        xprintf("sdmmc: error allocating emmc iotxn\n");
-        iotxn_complete(txn, ERR_INTERNAL, 0);
-        return;
-    }
-    emmc_txn->opcode = txn->opcode;
-    emmc_txn->flags = txn->flags;
-    emmc_txn->offset = txn->offset;
-    emmc_txn->length = txn->length;
-    emmc_txn->protocol = MX_PROTOCOL_SDMMC;
-    sdmmc_protocol_data_t* pdata = iotxn_pdata(emmc_txn, sdmmc_protocol_data_t);
+    uint8_t* buffer;
+    iotxn_mmap(txn, (void**)&buffer);
 
-    uint8_t current_state;
-    const size_t max_attempts = 10;
-    size_t attempt = 0;
-    for (; attempt <= max_attempts; attempt++) {
-        mx_status_t rc = sdmmc_do_command(sdmmc_mxdev, SDMMC_SEND_STATUS,
-                                          sdmmc->rca << 16, emmc_txn);
-        if (rc != NO_ERROR) {
-            iotxn_complete(txn, rc, 0);
-            goto out;
+    size_t bytes_processed = 0;
+    while (bytes_processed < txn->length) {
+        const size_t chunk = MIN(txn->length - bytes_processed, SDMMC_MAX_TRANSFER);
+        const uint16_t blkcnt = chunk / SDHC_BLOCK_SIZE;
+
+        // Figure out which SD command we need to issue.
+        uint32_t cmd;
+        if (txn->opcode == IOTXN_OP_READ) {
+            cmd = (blkcnt > 1) ? SDMMC_READ_MULTIPLE_BLOCK : SDMMC_READ_BLOCK;
+        } else {
+            cmd = (blkcnt > 1) ? SDMMC_WRITE_MULTIPLE_BLOCK : SDMMC_WRITE_BLOCK;
         }
 
-        current_state = (pdata->response[0] >> 9) & 0xf;
-
-        if (current_state == SDMMC_STATE_RECV) {
-            rc = sdmmc_do_command(sdmmc_mxdev, SDMMC_STOP_TRANSMISSION, 0, emmc_txn);
-            continue;
-        } else if (current_state == SDMMC_STATE_TRAN) {
-            break;
+        if (txn->opcode == IOTXN_OP_WRITE) {
+            if (blkcnt > 1) {
+                // Pre-erase hint: ACMD23 tells the card how many blocks the
+                // following WRITE_MULTIPLE_BLOCK will cover, letting it erase
+                // ahead instead of copying partially written allocation
+                // units. It is only a hint, so failure is ignored.
+                if (sdmmc_do_command(sdmmc_mxdev, SDMMC_APP_CMD, sdmmc->rca << 16,
+                                     emmc_txn) == NO_ERROR) {
+                    sdmmc_do_command(sdmmc_mxdev, SDMMC_SET_WR_BLK_ERASE_COUNT,
+                                     blkcnt, emmc_txn);
+                }
+            }
+            iotxn_copyto(emmc_txn, buffer + bytes_processed, chunk, 0);
         }
 
-        mx_nanosleep(mx_deadline_after(MX_MSEC(10)));
-    }
+        emmc_txn->opcode = txn->opcode;
+        emmc_txn->flags = txn->flags;
+        emmc_txn->offset = txn->offset + bytes_processed;
+        emmc_txn->length = chunk;
 
-    if (attempt == max_attempts) {
-        // Too many retries, fail.
-        iotxn_complete(txn, ERR_BAD_STATE, 0);
-        goto out;
-    }
+        pdata->blockcount = blkcnt;
+        pdata->blocksize = SDHC_BLOCK_SIZE;
 
-    // Which block to operate against.
-    const uint32_t blkid = emmc_txn->offset / SDHC_BLOCK_SIZE;
+        // Which block to operate against.
+        const uint32_t blkid = emmc_txn->offset / SDHC_BLOCK_SIZE;
 
-    pdata->blockcount = txn->length / SDHC_BLOCK_SIZE;
-    pdata->blocksize = SDHC_BLOCK_SIZE;
+        mx_status_t rc = sdmmc_do_command(sdmmc_mxdev, cmd, blkid, emmc_txn);
+        if (rc != NO_ERROR) {
+            // The card state is unknown after a failed data command;
+            // re-probe it before the next one.
+            sdmmc->card_in_tran = false;
+            iotxn_complete(txn, rc, bytes_processed);
+            return;
+        }
 
-    void* buffer;
-    size_t bytes_processed = 0;
-    if (txn->opcode == IOTXN_OP_WRITE) {
-        iotxn_mmap(txn, &buffer);
-        iotxn_copyto(emmc_txn, buffer, txn->length, 0);
-        bytes_processed = txn->length;
+        if (txn->opcode == IOTXN_OP_READ) {
+            const size_t actual = MIN(emmc_txn->actual, chunk);
+            iotxn_copyfrom(emmc_txn, buffer + bytes_processed, actual, 0);
+            bytes_processed += actual;
+            if (actual < chunk) {
+                // short read, don't bother asking for the rest
+                break;
+            }
+        } else {
+            bytes_processed += chunk;
+        }
     }
 
-    mx_status_t rc = sdmmc_do_command(sdmmc_mxdev, cmd, blkid, emmc_txn);
-    if (rc != NO_ERROR) {
-        iotxn_complete(txn, rc, 0);
-    }
+    iotxn_complete(txn, NO_ERROR, bytes_processed);
+}
+
+static int sdmmc_worker_thread(void* arg) {
+    sdmmc_t* sdmmc = arg;
 
-    if (txn->opcode == IOTXN_OP_READ) {
-        bytes_processed = MIN(emmc_txn->actual, txn->length);
-        iotxn_mmap(emmc_txn, &buffer);
-        iotxn_copyto(txn, buffer, bytes_processed, 0);
+    while (true) {
+        completion_wait(&sdmmc->iotxn_completion, MX_TIME_INFINITE);
+        completion_reset(&sdmmc->iotxn_completion);
+
+        // Drain the whole queue so the card never idles waiting for the
+        // block stack to wake us between requests.
+        while (true) {
+            mtx_lock(&sdmmc->iotxn_lock);
+            if (sdmmc->dead) {
+                mtx_unlock(&sdmmc->iotxn_lock);
+                goto done;
+            }
+            iotxn_t* txn = list_remove_head_type(&sdmmc->queued_iotxns, iotxn_t, node);
+            mtx_unlock(&sdmmc->iotxn_lock);
+            if (txn == NULL) {
+                break;
+            }
+            sdmmc_do_txn(sdmmc, txn);
+        }
     }
 
-    iotxn_complete(txn, NO_ERROR, bytes_processed);
+done:;
+    // fail any outstanding txns
+    iotxn_t* txn;
+    mtx_lock(&sdmmc->iotxn_lock);
+    while ((txn = list_remove_head_type(&sdmmc->queued_iotxns, iotxn_t, node)) != NULL) {
+        iotxn_complete(txn, ERR_PEER_CLOSED, 0);
+    }
+    mtx_unlock(&sdmmc->iotxn_lock);
 
-out:
-    if (emmc_txn)
-        iotxn_release(emmc_txn);
+    return 0;
 }
 
 // Block device protocol.
@@ -454,6 +546,25 @@ static int sdmmc_bootstrap_thread(void* arg) {
 
     sdmmc->sdmmc_mxdev = dev;
 
+    list_initialize(&sdmmc->queued_iotxns);
+    mtx_init(&sdmmc->iotxn_lock, mtx_plain);
+
+    // Pre-allocate the contiguous bounce buffer used for data commands so the
+    // data path never has to hit the allocator (or fail under fragmentation).
+    if ((st = iotxn_alloc(&sdmmc->data_txn, IOTXN_ALLOC_CONTIGUOUS,
+                          SDMMC_MAX_TRANSFER)) != NO_ERROR) {
+        xprintf("sdmmc: failed to allocate data iotxn, rc = %d\n", st);
+        goto err;
+    }
+    sdmmc->data_txn->protocol = MX_PROTOCOL_SDMMC;
+
+    int thrd_rc = thrd_create_with_name(&sdmmc->worker_thread, sdmmc_worker_thread,
+                                        sdmmc, "sdmmc_worker_thread");
+    if (thrd_rc != thrd_success) {
+        xprintf("sdmmc: failed to create worker thread\n");
+        goto err;
+    }
+
     device_add_args_t args = {
         .version = DEVICE_ADD_ARGS_VERSION,
         .name = "sdmmc",
@@ -465,7 +576,12 @@ static int sdmmc_bootstrap_thread(void* arg) {
 
     st = device_add(dev, &args, &sdmmc->mxdev);
     if (st != NO_ERROR) {
-         goto err;
+        mtx_lock(&sdmmc->iotxn_lock);
+        sdmmc->dead = true;
+        mtx_unlock(&sdmmc->iotxn_lock);
+        completion_signal(&sdmmc->iotxn_completion);
+        thrd_join(sdmmc->worker_thread, NULL);
+        goto err;
     }
 
     xprintf("sdmmc: bind success!\n");
@@ -473,6 +589,9 @@ static int sdmmc_bootstrap_thread(void* arg) {
     return 0;
 err:
     if (sdmmc) {
+        if (sdmmc->data_txn) {
+            iotxn_release(sdmmc->data_txn);
+        }
         free(sdmmc);
     }
 
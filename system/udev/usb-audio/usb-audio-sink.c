@@ -4,6 +4,7 @@
 
 #include <ddk/device.h>
 #include <ddk/common/usb.h>
+#include <ddk/common/usb-iso-stream.h>
 #include <magenta/device/audio.h>
 #include <magenta/device/usb.h>
 #include <magenta/hw/usb-audio.h>
@@ -17,6 +18,10 @@
 
 #define WRITE_REQ_COUNT 20
 
+// wake the writer once per 8 completed packets (8ms of audio)
+// rather than once per packet
+#define WRITE_BATCH_COUNT 8
+
 // Assume audio is paused and reset our timer logic
 // if no writes occur for 100ms
 #define WRITE_TIMEOUT_MS 100
@@ -28,11 +33,11 @@ typedef struct {
     uint8_t interface_number;
     uint8_t alternate_setting;
 
-    // pool of free USB requests
-    list_node_t free_write_reqs;
-    // mutex for synchronizing access to free_write_reqs, open and started
+    // circular schedule of pre-allocated isochronous transfers
+    usb_iso_stream_t* stream;
+    // mutex for synchronizing access to open and started
     mtx_t mutex;
-    // completion signals free_write_reqs not empty
+    // completion signals free slots may be available in the stream
     completion_t free_write_completion;
     // mutex used to synchronize ioctl_audio_start() and ioctl_audio_stop()
     mtx_t start_stop_mutex;
@@ -69,7 +74,7 @@ static void update_signals(usb_audio_sink_t* sink) {
     mx_signals_t new_signals = 0;
     if (sink->dead) {
         new_signals |= (DEV_STATE_WRITABLE | DEV_STATE_ERROR);
-    } else if (!list_is_empty(&sink->free_write_reqs)) {
+    } else if (usb_iso_stream_free_slots(sink->stream) > 0) {
         new_signals |= DEV_STATE_WRITABLE;
     }
     if (new_signals != sink->signals) {
@@ -79,16 +84,11 @@ static void update_signals(usb_audio_sink_t* sink) {
     }
 }
 
-static void usb_audio_sink_write_complete(iotxn_t* txn, void* cookie) {
-    if (txn->status == ERR_PEER_CLOSED) {
-        iotxn_release(txn);
-        return;
-    }
-
+// called by the stream once per WRITE_BATCH_COUNT completed packets
+static void usb_audio_sink_stream_cb(usb_iso_stream_t* stream, void* cookie) {
     usb_audio_sink_t* sink = (usb_audio_sink_t*)cookie;
-    // FIXME what to do with error here?
+
     mtx_lock(&sink->mutex);
-    list_add_tail(&sink->free_write_reqs, &txn->node);
     completion_signal(&sink->free_write_completion);
     update_signals(sink);
     mtx_unlock(&sink->mutex);
@@ -103,9 +103,8 @@ static void usb_audio_sink_unbind(void* ctx) {
 }
 
 static void usb_audio_sink_free(usb_audio_sink_t* sink) {
-    iotxn_t* txn;
-    while ((txn = list_remove_head_type(&sink->free_write_reqs, iotxn_t, node)) != NULL) {
-        iotxn_release(txn);
+    if (sink->stream) {
+        usb_iso_stream_release(sink->stream);
     }
     free(sink->sample_rates);
     free(sink);
@@ -232,22 +231,18 @@ static mx_status_t usb_audio_sink_write(void* ctx, const void* data, size_t leng
             sink->cur_txn = NULL;
             txn_offset = txn->length;
         } else {
-            completion_wait(&sink->free_write_completion, MX_TIME_INFINITE);
-            if (sink->dead) {
-                return ERR_PEER_CLOSED;
-            }
-            mtx_lock(&sink->mutex);
-            list_node_t* node = list_remove_head(&sink->free_write_reqs);
-            if (list_is_empty(&sink->free_write_reqs)) {
+            while ((txn = usb_iso_stream_next_slot(sink->stream)) == NULL) {
+                // re-check after resetting so we can't miss a batch
+                // callback that fired in between
                 completion_reset(&sink->free_write_completion);
+                if ((txn = usb_iso_stream_next_slot(sink->stream)) != NULL) {
+                    break;
+                }
+                completion_wait(&sink->free_write_completion, MX_TIME_INFINITE);
+                if (sink->dead) {
+                    return ERR_PEER_CLOSED;
+                }
             }
-            mtx_unlock(&sink->mutex);
-            if (!node) {
-                // shouldn't happen!
-                status = ERR_INTERNAL;
-                goto out;
-            }
-            txn = containerof(node, iotxn_t, node);
             txn_offset = 0;
         }
 
@@ -264,8 +259,7 @@ static mx_status_t usb_audio_sink_write(void* ctx, const void* data, size_t leng
             src += copy;
             length -= copy;
 
-            usb_iotxn_set_frame(txn, current_usb_frame);
-            iotxn_queue(sink->usb_mxdev, txn);
+            usb_iso_stream_queue(sink->stream, txn, current_usb_frame);
 
             sink->last_usb_frame = current_usb_frame;
             sink->audio_frame_count += current_audio_frames;
@@ -384,24 +378,18 @@ mx_status_t usb_audio_sink_create(mx_driver_t* driver, mx_device_t* device, int
         return ERR_NO_MEMORY;
     }
 
-    list_initialize(&sink->free_write_reqs);
-
     sink->usb_mxdev = device;
     sink->ep_addr = ep->bEndpointAddress;
     sink->interface_number = intf->bInterfaceNumber;
     sink->alternate_setting = intf->bAlternateSetting;
     int packet_size = usb_ep_max_packet(ep);
 
-    for (int i = 0; i < WRITE_REQ_COUNT; i++) {
-        iotxn_t* txn = usb_alloc_iotxn(sink->ep_addr, packet_size);
-        if (!txn) {
-            usb_audio_sink_free(sink);
-            return ERR_NO_MEMORY;
-        }
-        txn->length = packet_size;
-        txn->complete_cb = usb_audio_sink_write_complete;
-        txn->cookie = sink;
-        list_add_head(&sink->free_write_reqs, &txn->node);
+    mx_status_t status = usb_iso_stream_create(device, sink->ep_addr, packet_size,
+                                               WRITE_REQ_COUNT, WRITE_BATCH_COUNT,
+                                               usb_audio_sink_stream_cb, sink, &sink->stream);
+    if (status != NO_ERROR) {
+        usb_audio_sink_free(sink);
+        return status;
     }
     completion_signal(&sink->free_write_completion);
 
@@ -413,8 +401,8 @@ mx_status_t usb_audio_sink_create(mx_driver_t* driver, mx_device_t* device, int
     if (sink->sample_rate_count > 1) {
         // this may stall if only one sample rate is supported, so only call this if
         // multiple sample rates are supported
-        mx_status_t status = usb_audio_set_sample_rate(sink->usb_mxdev, sink->ep_addr,
-                                                       sink->sample_rate);
+        status = usb_audio_set_sample_rate(sink->usb_mxdev, sink->ep_addr,
+                                           sink->sample_rate);
         if (status != NO_ERROR) {
             printf("usb_audio_set_sample_rate failed in usb_audio_sink_create\n");
             usb_audio_sink_free(sink);
@@ -434,7 +422,7 @@ mx_status_t usb_audio_sink_create(mx_driver_t* driver, mx_device_t* device, int
         .proto_id = MX_PROTOCOL_AUDIO,
     };
 
-    mx_status_t status = device_add(device, &args, &sink->mxdev);
+    status = device_add(device, &args, &sink->mxdev);
     if (status != NO_ERROR) {
         printf("device_add failed in usb_audio_sink_create\n");
         usb_audio_sink_free(sink);
@@ -82,14 +82,21 @@ static void ums_send_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint
     ums_queue_request(ums, txn);
 }
 
-static mx_status_t ums_read_csw(ums_t* ums, uint32_t* out_residue) {
-    completion_t completion = COMPLETION_INIT;
+// Queues the CSW read on the bulk IN pipe without waiting for it. Callers may
+// queue it behind a data request (or, for writes, ahead of the data stage
+// entirely) so the host controller completes the status stage without a round
+// trip through the worker thread in between.
+static void ums_queue_csw(ums_t* ums) {
     iotxn_t* csw_request = ums->csw_iotxn;
-    csw_request->cookie = &completion;
+    completion_reset(&ums->csw_completion);
+    csw_request->cookie = &ums->csw_completion;
     ums_queue_request(ums, csw_request);
-    completion_wait(&completion, MX_TIME_INFINITE);
+}
+
+static mx_status_t ums_wait_csw(ums_t* ums, uint32_t* out_residue) {
+    completion_wait(&ums->csw_completion, MX_TIME_INFINITE);
 
-    csw_status_t csw_error = ums_verify_csw(ums, csw_request, out_residue);
+    csw_status_t csw_error = ums_verify_csw(ums, ums->csw_iotxn, out_residue);
 
     if (csw_error == CSW_SUCCESS) {
         return NO_ERROR;
@@ -104,6 +111,11 @@ static mx_status_t ums_read_csw(ums_t* ums, uint32_t* out_residue) {
     }
 }
 
+static mx_status_t ums_read_csw(ums_t* ums, uint32_t* out_residue) {
+    ums_queue_csw(ums);
+    return ums_wait_csw(ums, out_residue);
+}
+
 static csw_status_t ums_verify_csw(ums_t* ums, iotxn_t* csw_request, uint32_t* out_residue) {
     ums_csw_t csw;
     iotxn_copyfrom(csw_request, &csw, sizeof(csw), 0);
@@ -271,12 +283,19 @@ static void clone_complete(iotxn_t* clone, void* cookie) {
     completion_signal((completion_t *)cookie);
 }
 
-static void ums_queue_data_transfer(ums_t* ums, iotxn_t* txn, uint8_t ep_address, size_t max_packet) {
+// Runs the data stage for one txn, storing the result in txn->status and
+// txn->actual for the caller to report. If queue_csw is set, the CSW read is
+// queued immediately behind the data request so the status stage rides the
+// same bulk IN schedule; that is only legal when the data request cannot be
+// requeued for a continuation, i.e. txn->length <= ums->max_transfer.
+static mx_status_t ums_data_transfer(ums_t* ums, iotxn_t* txn, uint8_t ep_address,
+                                     size_t max_packet, bool queue_csw) {
     iotxn_t* clone = NULL;
     mx_status_t status = iotxn_clone(txn, &clone);
     if (status != NO_ERROR) {
-        iotxn_complete(txn, status, 0);
-        return;
+        txn->status = status;
+        txn->actual = 0;
+        return status;
     }
 
     clone->complete_cb = clone_complete;
@@ -298,31 +317,68 @@ static void ums_queue_data_transfer(ums_t* ums, iotxn_t* txn, uint8_t ep_address
     completion_t completion = COMPLETION_INIT;
     clone->cookie = &completion;
     ums_queue_request(ums, clone);
+    if (queue_csw) {
+        ums_queue_csw(ums);
+    }
     completion_wait(&completion, MX_TIME_INFINITE);
 
     txn->status = clone->status;
     txn->actual = (txn->status == NO_ERROR ? extra->offset : 0);
 
     iotxn_release(clone);
+    return txn->status;
+}
+
+// A non-zero dCSWDataResidue means the device moved fewer bytes than the CBW
+// asked for. Peel the residue off the tail of the batch so each txn reports
+// how much of its slice of the data stage actually transferred.
+static void ums_apply_residue(list_node_t* txns, uint32_t residue) {
+    iotxn_t* txn = list_peek_tail_type(txns, iotxn_t, node);
+    while (txn != NULL && residue > 0) {
+        if (txn->actual > residue) {
+            txn->actual -= residue;
+            residue = 0;
+        } else {
+            residue -= txn->actual;
+            txn->actual = 0;
+        }
+        txn = list_prev_type(txns, &txn->node, iotxn_t, node);
+    }
 }
 
-static mx_status_t ums_read(ums_block_t* dev, iotxn_t* txn) {
-    if (txn->length > UINT32_MAX) return ERR_INVALID_ARGS;
+// ums_read and ums_write operate on a batch of one or more txns covering a
+// contiguous block range (see ums_txn_mergeable), issuing a single CBW/CSW
+// pair for the whole range with each txn supplying its slice of the data
+// stage. Per-txn results are left in txn->status and txn->actual.
+static mx_status_t ums_read(ums_block_t* dev, list_node_t* txns) {
+    iotxn_t* head = list_peek_head_type(txns, iotxn_t, node);
+    iotxn_t* tail = list_peek_tail_type(txns, iotxn_t, node);
+    if (head->length > UINT32_MAX) return ERR_INVALID_ARGS;
 
-    uint64_t lba = txn->offset / dev->block_size;
+    uint64_t lba = head->offset / dev->block_size;
     if (lba > dev->total_blocks) {
         return ERR_OUT_OF_RANGE;
     }
-    uint32_t num_blocks = txn->length / dev->block_size;
+    uint32_t num_blocks = (tail->offset + tail->length - head->offset) / dev->block_size;
     if (lba + num_blocks >= dev->total_blocks) {
+        // merged batches never extend past the end of the device,
+        // so only a lone txn can be truncated here
         num_blocks = dev->total_blocks - lba;
         if (num_blocks == 0) {
-            return 0;
+            head->status = NO_ERROR;
+            head->actual = 0;
+            return NO_ERROR;
         }
     }
     uint32_t transfer_length = num_blocks * dev->block_size;
     ums_t* ums = block_to_ums(dev);
 
+    iotxn_t* txn;
+    list_for_every_entry(txns, txn, iotxn_t, node) {
+        txn->status = ERR_IO;
+        txn->actual = 0;
+    }
+
     // CBW Configuration
 
     // Need to use UMS_READ16 if block addresses are greater than 32 bit
@@ -351,34 +407,57 @@ static mx_status_t ums_read(ums_block_t* dev, iotxn_t* txn) {
         ums_send_cbw(ums, dev->lun, transfer_length, USB_DIR_IN, sizeof(command), &command);
     }
 
-    ums_queue_data_transfer(ums, txn, ums->bulk_in_addr, ums->bulk_in_max_packet);
+    // queue the data stages back to back on the bulk IN pipe. When the final
+    // data request cannot be split into continuations, park the CSW read
+    // right behind it so the host controller completes the status stage
+    // without waking us up in between.
+    bool csw_queued = false;
+    list_for_every_entry(txns, txn, iotxn_t, node) {
+        csw_queued = (txn == tail && txn->length <= ums->max_transfer);
+        if (ums_data_transfer(ums, txn, ums->bulk_in_addr, ums->bulk_in_max_packet,
+                              csw_queued) != NO_ERROR) {
+            break;
+        }
+    }
+    if (!csw_queued) {
+        ums_queue_csw(ums);
+    }
 
     uint32_t residue;
-    mx_status_t status = ums_read_csw(ums, &residue);
-    if (status == NO_ERROR) {
-        status = txn->actual - residue;
+    mx_status_t status = ums_wait_csw(ums, &residue);
+    if (status == NO_ERROR && residue > 0) {
+        ums_apply_residue(txns, residue);
     }
-
     return status;
 }
 
-static mx_status_t ums_write(ums_block_t* dev, iotxn_t* txn) {
-    if (txn->length > UINT32_MAX) return ERR_INVALID_ARGS;
+static mx_status_t ums_write(ums_block_t* dev, list_node_t* txns) {
+    iotxn_t* head = list_peek_head_type(txns, iotxn_t, node);
+    iotxn_t* tail = list_peek_tail_type(txns, iotxn_t, node);
+    if (head->length > UINT32_MAX) return ERR_INVALID_ARGS;
 
-    uint64_t lba = txn->offset / dev->block_size;
+    uint64_t lba = head->offset / dev->block_size;
     if (lba > dev->total_blocks) {
         return ERR_OUT_OF_RANGE;
     }
-    uint32_t num_blocks = txn->length / dev->block_size;
+    uint32_t num_blocks = (tail->offset + tail->length - head->offset) / dev->block_size;
     if (lba + num_blocks >= dev->total_blocks) {
         num_blocks = dev->total_blocks - lba;
         if (num_blocks == 0) {
-            return 0;
+            head->status = NO_ERROR;
+            head->actual = 0;
+            return NO_ERROR;
         }
     }
     uint32_t transfer_length = num_blocks * dev->block_size;
     ums_t* ums = block_to_ums(dev);
 
+    iotxn_t* txn;
+    list_for_every_entry(txns, txn, iotxn_t, node) {
+        txn->status = ERR_IO;
+        txn->actual = 0;
+    }
+
     // Need to use UMS_WRITE16 if block addresses are greater than 32 bit
     if (dev->total_blocks > UINT32_MAX) {
         scsi_command16_t command;
@@ -404,18 +483,41 @@ static mx_status_t ums_write(ums_block_t* dev, iotxn_t* txn) {
         ums_send_cbw(ums, dev->lun, transfer_length, USB_DIR_OUT, sizeof(command), &command);
     }
 
-    ums_queue_data_transfer(ums, txn, ums->bulk_out_addr, ums->bulk_out_max_packet);
+    // the status stage arrives on the otherwise idle bulk IN pipe; queue the
+    // CSW read up front so it overlaps the data stage instead of waiting for it
+    ums_queue_csw(ums);
+
+    list_for_every_entry(txns, txn, iotxn_t, node) {
+        if (ums_data_transfer(ums, txn, ums->bulk_out_addr, ums->bulk_out_max_packet,
+                              false) != NO_ERROR) {
+            break;
+        }
+    }
 
     // receive CSW
     uint32_t residue;
-    mx_status_t status = ums_read_csw(ums, &residue);
-    if (status == NO_ERROR) {
-        status = transfer_length - residue;
+    mx_status_t status = ums_wait_csw(ums, &residue);
+    if (status == NO_ERROR && residue > 0) {
+        ums_apply_residue(txns, residue);
     }
-
     return status;
 }
 
+// Returns true if the queued txn "next" can ride along on the same SCSI
+// command as "prev": same LUN, same direction, and its data continues exactly
+// where prev's ends. The combined range must stay addressable by one command
+// and entirely inside the device (merged commands are never truncated).
+static bool ums_txn_mergeable(ums_block_t* dev, iotxn_t* prev, iotxn_t* next,
+                              size_t total_length) {
+    if (next->context != dev) return false;
+    if (next->opcode != prev->opcode) return false;
+    if (next->offset != prev->offset + prev->length) return false;
+    if (next->length == 0 || (next->length % dev->block_size) != 0) return false;
+    if (total_length + next->length > UINT32_MAX) return false;
+    if ((next->offset + next->length) / dev->block_size > dev->total_blocks) return false;
+    return true;
+}
+
 static void ums_unbind(void* ctx) {
     ums_t* ums = ctx;
 
@@ -611,28 +713,53 @@ static int ums_worker_thread(void* arg) {
             wait = true;
             continue;
         }
-        ums->curr_txn = txn;
-        mtx_unlock(&ums->iotxn_lock);
 
+        // merge adjacent requests into one command: pull queued txns that
+        // continue the head txn's range so the whole run goes out under a
+        // single CBW/CSW pair instead of one bus round trip per txn
         ums_block_t* dev = txn->context;
+        list_node_t batch = LIST_INITIAL_VALUE(batch);
+        list_add_tail(&batch, &txn->node);
+        if ((txn->opcode == IOTXN_OP_READ || txn->opcode == IOTXN_OP_WRITE) &&
+            txn->length > 0 && (txn->length % dev->block_size) == 0 &&
+            (txn->offset + txn->length) / dev->block_size <= dev->total_blocks) {
+            size_t total_length = txn->length;
+            iotxn_t* prev = txn;
+            iotxn_t* next;
+            while ((next = list_peek_head_type(&ums->queued_iotxns, iotxn_t, node)) != NULL &&
+                   ums_txn_mergeable(dev, prev, next, total_length)) {
+                list_delete(&next->node);
+                list_add_tail(&batch, &next->node);
+                total_length += next->length;
+                prev = next;
+            }
+        }
+        // the batch completes as a unit, so syncing against the tail
+        // covers every txn in it
+        ums->curr_txn = list_peek_tail_type(&batch, iotxn_t, node);
+        mtx_unlock(&ums->iotxn_lock);
 
         mx_status_t status;
         if (txn->opcode == IOTXN_OP_READ) {
-            status = ums_read(dev, txn);
+            status = ums_read(dev, &batch);
         }else if (txn->opcode == IOTXN_OP_WRITE) {
-            status = ums_write(dev, txn);
+            status = ums_write(dev, &batch);
         } else {
             status = ERR_INVALID_ARGS;
         }
 
         mtx_lock(&ums->iotxn_lock);
-        // unblock calls to IOCTL_DEVICE_SYNC that are waiting for curr_txn to complete
+        // unblock calls to IOCTL_DEVICE_SYNC that are waiting for any txn in the batch
         ums_sync_node_t* sync_node;
         ums_sync_node_t* temp;
         list_for_every_entry_safe(&ums->sync_nodes, sync_node, temp, ums_sync_node_t, node) {
-            if (sync_node->iotxn == txn) {
-                list_delete(&sync_node->node);
-                completion_signal(&sync_node->completion);
+            iotxn_t* match;
+            list_for_every_entry(&batch, match, iotxn_t, node) {
+                if (sync_node->iotxn == match) {
+                    list_delete(&sync_node->node);
+                    completion_signal(&sync_node->completion);
+                    break;
+                }
             }
         }
         ums->curr_txn = NULL;
@@ -640,10 +767,14 @@ static int ums_worker_thread(void* arg) {
         wait = list_is_empty(&ums->queued_iotxns);
         mtx_unlock(&ums->iotxn_lock);
 
-        if (status >= 0) {
-            iotxn_complete(txn, NO_ERROR, status);
-        } else {
-            iotxn_complete(txn, status, 0);
+        while ((txn = list_remove_head_type(&batch, iotxn_t, node)) != NULL) {
+            if (status != NO_ERROR) {
+                iotxn_complete(txn, status, 0);
+            } else if (txn->status != NO_ERROR) {
+                iotxn_complete(txn, txn->status, 0);
+            } else {
+                iotxn_complete(txn, NO_ERROR, txn->actual);
+            }
         }
     }
 
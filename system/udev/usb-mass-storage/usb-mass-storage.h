@@ -55,6 +55,8 @@ typedef struct {
     iotxn_t* data_iotxn;
     iotxn_t* csw_iotxn;
 
+    completion_t csw_completion; // signalled when csw_iotxn completes
+
     thrd_t worker_thread;
     bool dead;
 
@@ -506,36 +506,54 @@ uint64_t xhci_get_current_frame(xhci_t* xhci) {
     return ((wrap_count * (1 << XHCI_MFINDEX_BITS)) + mfindex) >> 3;
 }
 
+// number of event TRBs we drain from the event ring at a time
+#define EVENT_BATCH_SIZE 32
+
 static void xhci_handle_events(xhci_t* xhci, int interruptor) {
     xhci_event_ring_t* er = &xhci->event_rings[interruptor];
-
-    // process all TRBs with cycle bit matching our CCS
-    while ((XHCI_READ32(&er->current->control) & TRB_C) == er->ccs) {
-        uint32_t type = trb_get_type(er->current);
-        switch (type) {
-        case TRB_EVENT_COMMAND_COMP:
-            xhci_handle_command_complete_event(xhci, er->current);
-            break;
-        case TRB_EVENT_PORT_STATUS_CHANGE:
-            // ignore, these are dealt with in xhci_handle_interrupt() below
-            break;
-        case TRB_EVENT_TRANSFER:
-            xhci_handle_transfer_event(xhci, er->current);
-            break;
-        case TRB_EVENT_MFINDEX_WRAP:
-            xhci_handle_mfindex_wrap(xhci);
-            break;
-        default:
-            printf("xhci_handle_events: unhandled event type %d\n", type);
-            break;
+    xhci_trb_t events[EVENT_BATCH_SIZE];
+
+    while (1) {
+        // copy a batch of pending TRBs off the event ring first, so we
+        // advance the dequeue pointer once per batch instead of once per
+        // event, and the controller can refill the ring while we dispatch
+        unsigned count = 0;
+        while (count < EVENT_BATCH_SIZE &&
+               (XHCI_READ32(&er->current->control) & TRB_C) == er->ccs) {
+            events[count++] = *er->current;
+
+            er->current++;
+            if (er->current == er->end) {
+                er->current = er->start;
+                er->ccs ^= TRB_C;
+            }
         }
-
-        er->current++;
-        if (er->current == er->end) {
-            er->current = er->start;
-            er->ccs ^= TRB_C;
+        if (count == 0) {
+            return;
         }
         xhci_update_erdp(xhci, interruptor);
+
+        for (unsigned i = 0; i < count; i++) {
+            xhci_trb_t* trb = &events[i];
+            uint32_t type = trb_get_type(trb);
+            switch (type) {
+            case TRB_EVENT_COMMAND_COMP:
+                xhci_handle_command_complete_event(xhci, trb);
+                break;
+            case TRB_EVENT_PORT_STATUS_CHANGE:
+                // ignore, these are dealt with in xhci_handle_interrupt() below
+                break;
+            case TRB_EVENT_TRANSFER:
+                xhci_handle_transfer_event(xhci, trb);
+                break;
+            case TRB_EVENT_MFINDEX_WRAP:
+                xhci_handle_mfindex_wrap(xhci);
+                break;
+            default:
+                printf("xhci_handle_events: unhandled event type %d\n", type);
+                break;
+            }
+        }
     }
 }
 
@@ -129,7 +129,17 @@ mx_status_t BlockDevice::Init() {
     // ack and set the driver status bit
     StatusAcknowledgeDriver();
 
-    // XXX check features bits and ack/nak them
+    // check the feature bits and ack the ones we want to use. Indirect
+    // descriptors let a whole scatter-gather request occupy a single ring
+    // slot, so the ring depth is not divided by segments per request.
+    uint32_t features = ReadDeviceFeatures();
+    uint32_t driver_features = 0;
+    if (features & (1u << VIRTIO_RING_F_INDIRECT_DESC)) {
+        indirect_desc_ = true;
+        driver_features |= (1u << VIRTIO_RING_F_INDIRECT_DESC);
+    }
+    SetDriverFeatures(driver_features);
+    LTRACEF("indirect descriptors %s\n", indirect_desc_ ? "on" : "off");
 
     // allocate the main vring
     auto err = vring_.Init(0, 128); // 128 matches legacy pci
@@ -138,8 +148,12 @@ mx_status_t BlockDevice::Init() {
         return err;
     }
 
-    // allocate a queue of block requests
+    // allocate a queue of block requests, a status byte per request, and
+    // (when negotiated) an indirect descriptor table per request
     size_t size = sizeof(virtio_blk_req) * blk_req_count + sizeof(uint8_t) * blk_req_count;
+    if (indirect_desc_) {
+        size += sizeof(vring_desc) * (blk_req_max_segs + 2) * blk_req_count;
+    }
 
     mx_status_t r = map_contiguous_memory(size, (uintptr_t*)&blk_req_, &blk_req_pa_);
     if (r < 0) {
@@ -155,6 +169,16 @@ mx_status_t BlockDevice::Init() {
 
     LTRACEF("allocated blk responses at %p, physical address %#" PRIxPTR "\n", blk_res_, blk_res_pa_);
 
+    if (indirect_desc_) {
+        // the tables follow the status bytes; the request array is 16 bytes
+        // per entry and the 32 status bytes keep the tables 16-byte aligned
+        blk_desc_pa_ = blk_res_pa_ + sizeof(uint8_t) * blk_req_count;
+        blk_desc_ = (vring_desc*)((uintptr_t)blk_res_ + sizeof(uint8_t) * blk_req_count);
+
+        LTRACEF("allocated indirect descriptor tables at %p, physical address %#" PRIxPTR "\n",
+                blk_desc_, blk_desc_pa_);
+    }
+
     // start the interrupt thread
     StartIrqThread();
 
@@ -192,6 +216,20 @@ void BlockDevice::IrqRingUpdate() {
         uint32_t i = (uint16_t)used_elem->id;
         struct vring_desc* desc = vring_.DescFromIndex((uint16_t)i);
         auto head_desc = desc; // save the first element
+
+        // the head descriptor points at the request header (or the indirect
+        // table holding it), which tells us which request slot and status
+        // byte this chain used
+        unsigned int req_index;
+        if (desc->flags & VRING_DESC_F_INDIRECT) {
+            req_index = (unsigned int)((desc->addr - blk_desc_pa_) /
+                                       (sizeof(vring_desc) * (blk_req_max_segs + 2)));
+        } else {
+            req_index = (unsigned int)((desc->addr - blk_req_pa_) / sizeof(virtio_blk_req));
+        }
+        uint8_t status = blk_res_[req_index];
+        free_blk_req(req_index);
+
         for (;;) {
             int next;
 
@@ -214,13 +252,17 @@ void BlockDevice::IrqRingUpdate() {
             desc = vring_.DescFromIndex((uint16_t)i);
         }
 
-        // search our pending txn list to see if this completes it
+        // search our in-flight txn list to see if this completes it
         iotxn_t* txn;
         list_for_every_entry (&iotxn_list, txn, iotxn_t, node) {
             if (txn->context == head_desc) {
-                LTRACEF("completes txn %p\n", txn);
+                LTRACEF("completes txn %p status %u\n", txn, status);
                 list_delete(&txn->node);
-                iotxn_complete(txn, NO_ERROR, txn->length);
+                if (status == VIRTIO_BLK_S_OK) {
+                    iotxn_complete(txn, NO_ERROR, txn->length);
+                } else {
+                    iotxn_complete(txn, ERR_IO, 0);
+                }
                 break;
             }
         }
@@ -228,6 +270,18 @@ void BlockDevice::IrqRingUpdate() {
 
     // tell the ring to find free chains and hand it back to our lambda
     vring_.IrqRingUpdate(free_chain);
+
+    // descriptors and request slots were just freed, so submit anything that
+    // was waiting on them
+    iotxn_t* txn;
+    while ((txn = list_peek_head_type(&pending_txn_list, iotxn_t, node)) != nullptr) {
+        list_delete(&txn->node);
+        if (SubmitTxn(txn) == ERR_SHOULD_WAIT) {
+            // still out of resources; put it back until the next completion
+            list_add_head(&pending_txn_list, &txn->node);
+            break;
+        }
+    }
 }
 
 void BlockDevice::IrqConfigChange() {
@@ -239,8 +293,6 @@ void BlockDevice::QueueReadWriteTxn(iotxn_t* txn) {
 
     mxtl::AutoLock lock(&lock_);
 
-    bool write = (txn->opcode == IOTXN_OP_WRITE);
-
     // offset must be aligned to block size
     if (txn->offset % config_.blk_size) {
         TRACEF("offset %#" PRIx64 " is not aligned to sector size %u!\n", txn->offset, config_.blk_size);
@@ -251,8 +303,51 @@ void BlockDevice::QueueReadWriteTxn(iotxn_t* txn) {
     // constrain to device capacity
     txn->length = MIN(txn->length, GetSize() - txn->offset);
 
+    // keep txns in FIFO order: anything already waiting for resources goes first
+    if (!list_is_empty(&pending_txn_list)) {
+        list_add_tail(&pending_txn_list, &txn->node);
+        return;
+    }
+
+    if (SubmitTxn(txn) == ERR_SHOULD_WAIT) {
+        // no request slot or descriptors free; retried from IrqRingUpdate
+        list_add_tail(&pending_txn_list, &txn->node);
+    }
+}
+
+mx_status_t BlockDevice::SubmitTxn(iotxn_t* txn) {
+    bool write = (txn->opcode == IOTXN_OP_WRITE);
+
+    // break the buffer into physically contiguous runs
+    iotxn_physmap(txn);
+
+    struct {
+        mx_paddr_t pa;
+        size_t len;
+    } segs[blk_req_max_segs];
+    size_t seg_count = 0;
+
+    iotxn_phys_iter_t iter;
+    iotxn_phys_iter_init(&iter, txn, 0);
+    mx_paddr_t seg_pa;
+    size_t seg_len;
+    while ((seg_len = iotxn_phys_iter_next(&iter, &seg_pa)) > 0) {
+        if (seg_count == blk_req_max_segs) {
+            TRACEF("txn %p has too many physical segments!\n", txn);
+            iotxn_complete(txn, ERR_INVALID_ARGS, 0);
+            return ERR_INVALID_ARGS;
+        }
+        segs[seg_count].pa = seg_pa;
+        segs[seg_count].len = seg_len;
+        seg_count++;
+    }
+
     // allocate and start filling out a block request
     auto index = alloc_blk_req();
+    if (index >= blk_req_count) {
+        LTRACEF("too many outstanding requests\n");
+        return ERR_SHOULD_WAIT;
+    }
     LTRACEF("request index %u\n", index);
     auto req = &blk_req_[index];
     req->type = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
@@ -263,46 +358,89 @@ void BlockDevice::QueueReadWriteTxn(iotxn_t* txn) {
 
     /* put together a transfer */
     uint16_t i;
-    auto desc = vring_.AllocDescChain(3, &i);
-    LTRACEF("after alloc chain desc %p, i %u\n", desc, i);
+    vring_desc* desc;
+    if (indirect_desc_) {
+        /* a single ring slot pointing at a per-request descriptor table */
+        desc = vring_.AllocDescChain(1, &i);
+        if (!desc) {
+            free_blk_req(index);
+            return ERR_SHOULD_WAIT;
+        }
 
-    /* point the iotxn at this head descriptor */
-    txn->context = desc;
+        vring_desc* table = blk_desc_ + index * (blk_req_max_segs + 2);
+
+        /* request header */
+        table[0].addr = blk_req_pa_ + index * sizeof(virtio_blk_req);
+        table[0].len = sizeof(struct virtio_blk_req);
+        table[0].flags = VRING_DESC_F_NEXT;
+        table[0].next = 1;
+
+        /* data segments */
+        for (size_t n = 0; n < seg_count; n++) {
+            table[n + 1].addr = segs[n].pa;
+            table[n + 1].len = (uint32_t)segs[n].len;
+            /* mark buffer as write-only if its a block read */
+            table[n + 1].flags = (uint16_t)(VRING_DESC_F_NEXT | (write ? 0 : VRING_DESC_F_WRITE));
+            table[n + 1].next = (uint16_t)(n + 2);
+        }
 
-    /* set up the descriptor pointing to the head */
-    desc->addr = blk_req_pa_ + index * sizeof(virtio_blk_req);
-    desc->len = sizeof(struct virtio_blk_req);
-    desc->flags |= VRING_DESC_F_NEXT;
+        /* response */
+        table[seg_count + 1].addr = blk_res_pa_ + index;
+        table[seg_count + 1].len = 1;
+        table[seg_count + 1].flags = VRING_DESC_F_WRITE;
+        table[seg_count + 1].next = 0;
+
+        desc->addr = blk_desc_pa_ + index * (blk_req_max_segs + 2) * sizeof(vring_desc);
+        desc->len = (uint32_t)((seg_count + 2) * sizeof(vring_desc));
+        desc->flags = VRING_DESC_F_INDIRECT;
 
 #if LOCAL_TRACE > 0
-    virtio_dump_desc(desc);
+        virtio_dump_desc(desc);
 #endif
+    } else {
+        /* direct chain: header + one descriptor per segment + response */
+        desc = vring_.AllocDescChain((uint16_t)(seg_count + 2), &i);
+        if (!desc) {
+            free_blk_req(index);
+            return ERR_SHOULD_WAIT;
+        }
 
-    /* set up the descriptor pointing to the buffer */
-    desc = vring_.DescFromIndex(desc->next);
-
-    iotxn_physmap(txn);
+        /* set up the descriptor pointing to the head */
+        desc->addr = blk_req_pa_ + index * sizeof(virtio_blk_req);
+        desc->len = sizeof(struct virtio_blk_req);
+        desc->flags |= VRING_DESC_F_NEXT;
 
-    desc->addr = (uint64_t)iotxn_phys(txn);
-    desc->len = (uint32_t)txn->length;
+#if LOCAL_TRACE > 0
+        virtio_dump_desc(desc);
+#endif
 
-    if (!write)
-        desc->flags |= VRING_DESC_F_WRITE; /* mark buffer as write-only if its a block read */
-    desc->flags |= VRING_DESC_F_NEXT;
+        /* set up the descriptors pointing to the buffer segments */
+        for (size_t n = 0; n < seg_count; n++) {
+            desc = vring_.DescFromIndex(desc->next);
+            desc->addr = segs[n].pa;
+            desc->len = (uint32_t)segs[n].len;
+            if (!write)
+                desc->flags |= VRING_DESC_F_WRITE; /* mark buffer as write-only if its a block read */
+            desc->flags |= VRING_DESC_F_NEXT;
 
 #if LOCAL_TRACE > 0
-    virtio_dump_desc(desc);
+            virtio_dump_desc(desc);
 #endif
+        }
 
-    /* set up the descriptor pointing to the response */
-    desc = vring_.DescFromIndex(desc->next);
-    desc->addr = blk_res_pa_ + index;
-    desc->len = 1;
-    desc->flags = VRING_DESC_F_WRITE;
+        /* set up the descriptor pointing to the response */
+        desc = vring_.DescFromIndex(desc->next);
+        desc->addr = blk_res_pa_ + index;
+        desc->len = 1;
+        desc->flags = VRING_DESC_F_WRITE;
 
 #if LOCAL_TRACE > 0
-    virtio_dump_desc(desc);
+        virtio_dump_desc(desc);
 #endif
+    }
+
+    /* point the iotxn at the head descriptor */
+    txn->context = vring_.DescFromIndex(i);
 
     // save the iotxn in a list
     list_add_tail(&iotxn_list, &txn->node);
@@ -312,6 +450,8 @@ void BlockDevice::QueueReadWriteTxn(iotxn_t* txn) {
 
     /* kick it off */
     vring_.Kick();
+
+    return NO_ERROR;
 }
 
 } // namespace virtio
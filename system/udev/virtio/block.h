@@ -6,6 +6,7 @@
 #include "device.h"
 #include "ring.h"
 
+#include <limits.h>
 #include <magenta/compiler.h>
 #include <stdlib.h>
 
@@ -36,9 +37,17 @@ private:
 
     void QueueReadWriteTxn(iotxn_t* txn);
 
+    // builds and submits the descriptor chain for a txn; requires lock_.
+    // returns ERR_SHOULD_WAIT if no request slot or descriptors are free,
+    // leaving the txn untouched; other failures complete the txn.
+    mx_status_t SubmitTxn(iotxn_t* txn);
+
     // the main virtio ring
     Ring vring_ = {this};
 
+    // whether VIRTIO_RING_F_INDIRECT_DESC was negotiated
+    bool indirect_desc_ = false;
+
     // saved block device configuration out of the pci config BAR
     struct virtio_blk_config {
         uint64_t capacity;
@@ -61,26 +70,42 @@ private:
     // a queue of block request/responses
     static const size_t blk_req_count = 32;
 
+    // maximum scatter-gather segments in a single request
+    static const size_t blk_req_max_segs = 32;
+
     mx_paddr_t blk_req_pa_ = 0;
     virtio_blk_req* blk_req_ = nullptr;
 
     mx_paddr_t blk_res_pa_ = 0;
     uint8_t* blk_res_ = nullptr;
 
+    // per-request indirect descriptor tables (blk_req_max_segs + 2 entries
+    // each), only allocated when indirect descriptors were negotiated
+    mx_paddr_t blk_desc_pa_ = 0;
+    vring_desc* blk_desc_ = nullptr;
+
     uint32_t blk_req_bitmap_ = 0;
+    static_assert(blk_req_count <= sizeof(blk_req_bitmap_) * CHAR_BIT, "");
 
+    // returns blk_req_count if no request buffer is free
     unsigned int alloc_blk_req() {
-        unsigned int i = 31 - __builtin_clz(blk_req_bitmap_);
-        blk_req_bitmap_ |= (1 << i);
+        if (blk_req_bitmap_ == 0xffffffff)
+            return (unsigned int)blk_req_count;
+        unsigned int i = __builtin_ctz(~blk_req_bitmap_);
+        blk_req_bitmap_ |= (1u << i);
         return i;
     }
 
     void free_blk_req(unsigned int i) {
-        blk_req_bitmap_ &= ~(1 << i);
+        blk_req_bitmap_ &= ~(1u << i);
     }
 
-    // pending iotxns
+    // iotxns currently in flight
     list_node iotxn_list = LIST_INITIAL_VALUE(iotxn_list);
+
+    // iotxns waiting for a request slot or ring descriptors, retried as
+    // in-flight requests complete
+    list_node pending_txn_list = LIST_INITIAL_VALUE(pending_txn_list);
 };
 
 } // namespace virtio
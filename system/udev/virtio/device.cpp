@@ -298,6 +298,35 @@ void Device::SetRing(uint16_t index, uint16_t count, mx_paddr_t pa_desc, mx_padd
     }
 }
 
+uint32_t Device::ReadDeviceFeatures() {
+    if (trans_) {
+        if (bar0_pio_base_) {
+            return inpd((bar0_pio_base_ + VIRTIO_PCI_DEVICE_FEATURES) & 0xffff);
+        }
+        // XXX implement
+        assert(0);
+        return 0;
+    }
+
+    mmio_regs_.common_config->device_feature_select = 0;
+    return mmio_regs_.common_config->device_feature;
+}
+
+void Device::SetDriverFeatures(uint32_t features) {
+    if (trans_) {
+        if (bar0_pio_base_) {
+            outpd((bar0_pio_base_ + VIRTIO_PCI_DRIVER_FEATURES) & 0xffff, features);
+            return;
+        }
+        // XXX implement
+        assert(0);
+        return;
+    }
+
+    mmio_regs_.common_config->driver_feature_select = 0;
+    mmio_regs_.common_config->driver_feature = features;
+}
+
 void Device::RingKick(uint16_t ring_index) {
     LTRACEF("index %u\n", ring_index);
     if (trans_) {
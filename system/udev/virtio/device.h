@@ -38,6 +38,10 @@ public:
     void SetRing(uint16_t index, uint16_t count, mx_paddr_t pa_desc, mx_paddr_t pa_avail, mx_paddr_t pa_used);
     void RingKick(uint16_t ring_index);
 
+    // feature negotiation (low 32 feature bits)
+    uint32_t ReadDeviceFeatures();
+    void SetDriverFeatures(uint32_t features);
+
 protected:
     // read bytes out of BAR 0's config space
     uint8_t ReadConfigBar(uint16_t offset);
@@ -21,6 +21,7 @@ enum {
     ACPI_CMD_BST = 6,
     ACPI_CMD_BIF = 7,
     ACPI_CMD_ENABLE_EVENT = 8,
+    ACPI_CMD_EVAL_BATCH = 9,
 };
 
 typedef struct {
@@ -157,3 +158,34 @@ typedef struct {
 typedef struct {
     acpi_rsp_hdr_t hdr;
 } __PACKED acpi_rsp_enable_event_t;
+
+// Evaluate several methods of the node in a single request. Intended for
+// steady-state polling (battery _BST, thermal _TMP, ...), where issuing the
+// queries one RPC at a time dominates the cost. Only methods that return an
+// integer or a package of integers can be evaluated this way; anything else
+// fails its entry with ERR_NOT_SUPPORTED.
+#define ACPI_EVAL_BATCH_MAX_METHODS 16
+#define ACPI_EVAL_BATCH_MAX_VALUES 8
+
+typedef struct {
+    acpi_cmd_hdr_t hdr;
+
+    uint32_t count;
+    struct {
+        // Method name relative to the node, not NULL terminated.
+        char name[4];
+    } methods[];
+} __PACKED acpi_cmd_eval_batch_t;
+typedef struct {
+    mx_status_t status;
+    uint32_t num_values;
+    uint64_t values[ACPI_EVAL_BATCH_MAX_VALUES];
+} __PACKED acpi_rsp_eval_batch_result_t;
+typedef struct {
+    acpi_rsp_hdr_t hdr;
+
+    // One result per requested method, in request order. A method that
+    // fails to evaluate fails only its own entry.
+    uint32_t count;
+    acpi_rsp_eval_batch_result_t results[];
+} __PACKED acpi_rsp_eval_batch_t;
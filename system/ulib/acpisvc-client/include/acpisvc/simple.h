@@ -86,6 +86,16 @@ mx_status_t acpi_bst(acpi_handle_t* h, acpi_rsp_bst_t** response);
 // NOTE: this is a temporary interface that will be removed soon.
 mx_status_t acpi_bif(acpi_handle_t* h, acpi_rsp_bif_t** response);
 
+// Evaluate several methods of the ACPI node in one round trip.
+//
+// *names* is an array of *count* 4-character method names (relative to the
+// node, as in a _BST or _TMP poll); at most ACPI_EVAL_BATCH_MAX_METHODS.
+// *response* is a pointer to store the response into; release with free().
+// Per-method status and values are in (*response)->results, in request
+// order.
+mx_status_t acpi_eval_batch(acpi_handle_t* h, const char (*names)[4], uint32_t count,
+                            acpi_rsp_eval_batch_t** response);
+
 // Receive ACPI events on a port.
 //
 // *port* is the port to queue event packets on. The handle will always be
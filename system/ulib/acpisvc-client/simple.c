@@ -335,6 +335,44 @@ mx_status_t acpi_bif(acpi_handle_t* h, acpi_rsp_bif_t** response) {
     return NO_ERROR;
 }
 
+mx_status_t acpi_eval_batch(acpi_handle_t* h, const char (*names)[4], uint32_t count,
+                            acpi_rsp_eval_batch_t** response) {
+    if (count == 0 || count > ACPI_EVAL_BATCH_MAX_METHODS) {
+        return ERR_INVALID_ARGS;
+    }
+
+    uint8_t buf[sizeof(acpi_cmd_eval_batch_t) +
+                sizeof(((acpi_cmd_eval_batch_t*)0)->methods[0]) * ACPI_EVAL_BATCH_MAX_METHODS];
+    acpi_cmd_eval_batch_t* cmd = (acpi_cmd_eval_batch_t*)buf;
+    const size_t cmd_len = sizeof(*cmd) + sizeof(cmd->methods[0]) * count;
+    memset(cmd, 0, cmd_len);
+    cmd->hdr.version = 0;
+    cmd->hdr.cmd = ACPI_CMD_EVAL_BATCH;
+    cmd->hdr.len = cmd_len;
+    cmd->count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(cmd->methods[i].name, names[i], sizeof(cmd->methods[i].name));
+    }
+
+    acpi_rsp_eval_batch_t* rsp;
+    size_t rsp_len;
+    mx_status_t status =
+        run_txn(h, cmd, cmd_len, (void**)&rsp, &rsp_len, 0, NULL, 0);
+    if (status != NO_ERROR) {
+        return status;
+    }
+
+    // Validate the response
+    if (rsp_len != sizeof(*rsp) + sizeof(rsp->results[0]) * count ||
+        rsp->count != count) {
+        free(rsp);
+        return ERR_BAD_STATE;
+    }
+
+    *response = rsp;
+    return NO_ERROR;
+}
+
 mx_status_t acpi_enable_event(acpi_handle_t* _h, mx_handle_t port, uint64_t key, uint16_t events) {
     if (_h == NULL) {
         mx_handle_close(port);
@@ -0,0 +1,586 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <fs/trace.h>
+
+#include <bcache/bcache.h>
+#include <magenta/new.h>
+#include <mxtl/ref_ptr.h>
+#include <mxtl/unique_ptr.h>
+
+#ifdef __Fuchsia__
+#include <magenta/process.h>
+#include <magenta/syscalls.h>
+#endif
+
+namespace bcache {
+
+namespace {
+
+constexpr uint32_t kModeLoad = 1;
+constexpr uint32_t kModeZero = 2;
+
+// The kernel zeroes discarded pages, so a zeroed canary after relocking
+// means the cache contents went away while the VMO was unlocked.
+constexpr uint64_t kCanary = 0x6263616368656f6bULL; // 'bcacheok'
+
+const char* modestr(uint32_t mode) {
+    switch (mode) {
+    case kModeLoad: return "LOAD";
+    case kModeZero: return "ZERO";
+    default: return "????";
+    }
+}
+
+} // namespace
+
+uint32_t fnv1a32(const void* ptr, size_t len) {
+    uint32_t hash = 0x811c9dc5u;
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    while (len-- > 0) {
+        hash = (hash ^ (*p++)) * 16777619u;
+    }
+    return hash;
+}
+
+mx_status_t Bcache::Readblk(uint32_t bno, void* data) {
+    off_t off = (off_t)bno * blocksize_;
+    trace(IO, "bcache: readblk() bno=%u off=%#llx\n", bno, (unsigned long long)off);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("bcache: cannot seek to block %u\n", bno);
+        return ERR_IO;
+    }
+    if (read(fd_, data, blocksize_) != (ssize_t)blocksize_) {
+        error("bcache: cannot read block %u\n", bno);
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::ReadRun(uint32_t bno, uint32_t count, void* data) {
+    off_t off = (off_t)bno * blocksize_;
+    trace(IO, "bcache: readrun() bno=%u count=%u\n", bno, count);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("bcache: cannot seek to block %u\n", bno);
+        return ERR_IO;
+    }
+    if (read(fd_, data, count * blocksize_) != (ssize_t)(count * blocksize_)) {
+        error("bcache: cannot read %u blocks at %u\n", count, bno);
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::Writeblk(uint32_t bno, const void* data) {
+    off_t off = (off_t)bno * blocksize_;
+    trace(IO, "bcache: writeblk() bno=%u off=%#llx\n", bno, (unsigned long long)off);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("bcache: cannot seek to block %u\n", bno);
+        return ERR_IO;
+    }
+    if (write(fd_, data, blocksize_) != (ssize_t)blocksize_) {
+        error("bcache: cannot write block %u\n", bno);
+        return ERR_IO;
+    }
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::WriteRun(Block** blks, uint32_t count) {
+    off_t off = (off_t)blks[0]->bno_ * blocksize_;
+    trace(IO, "bcache: writerun() bno=%u count=%u\n", blks[0]->bno_, count);
+    if (lseek(fd_, off, SEEK_SET) < 0) {
+        error("bcache: cannot seek to block %u\n", blks[0]->bno_);
+        return ERR_IO;
+    }
+    struct iovec iov[64];
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t chunk = count - done;
+        if (chunk > (sizeof(iov) / sizeof(iov[0]))) {
+            chunk = (sizeof(iov) / sizeof(iov[0]));
+        }
+        for (uint32_t i = 0; i < chunk; i++) {
+            iov[i].iov_base = blks[done + i]->data();
+            iov[i].iov_len = blocksize_;
+        }
+        if (writev(fd_, iov, chunk) != (ssize_t)(chunk * blocksize_)) {
+            error("bcache: cannot write %u blocks at %u\n", count, blks[0]->bno_);
+            return ERR_IO;
+        }
+        done += chunk;
+    }
+    return NO_ERROR;
+}
+
+void Bcache::SetDirty(const mxtl::RefPtr<Block>& blk) {
+    if (!(blk->flags_ & kBlockDirty)) {
+        blk->flags_ |= kBlockDirty;
+        dirty_count_++;
+    }
+}
+
+void Bcache::RememberGhost(uint32_t bno) {
+    if (ghost_count_ == num_blocks_) {
+        mxtl::unique_ptr<Ghost> oldest = ghost_fifo_.pop_front();
+        ghost_hash_.erase(*oldest);
+        ghost_count_--;
+    }
+    AllocChecker ac;
+    mxtl::unique_ptr<Ghost> ghost(new (&ac) Ghost(bno));
+    if (!ac.check()) {
+        // the ghost list is advisory; dropping an entry just costs a
+        // missed promotion
+        return;
+    }
+    ghost_hash_.insert(ghost.get());
+    ghost_fifo_.push_back(mxtl::move(ghost));
+    ghost_count_++;
+}
+
+bool Bcache::TakeGhost(uint32_t bno) {
+    Ghost* ghost = ghost_hash_.erase(bno);
+    if (ghost == nullptr) {
+        return false;
+    }
+    ghost_fifo_.erase(*ghost);
+    ghost_count_--;
+    return true;
+}
+
+// Pick and detach an eviction victim.  While the first-access FIFO is
+// over target the victim comes from its head and is remembered as a
+// ghost (2Q: scan traffic ages out here); otherwise the main LRU gives
+// up its coldest block.  Dirty victims are written back first.
+mxtl::RefPtr<Block> Bcache::Evict() {
+    mxtl::RefPtr<Block> blk;
+    bool from_fifo = (lists_.Size(kBlockFifo) >= fifo_target_);
+    if (from_fifo) {
+        blk = lists_.PopFront(kBlockFifo);
+    }
+    if (blk == nullptr) {
+        from_fifo = false;
+        blk = lists_.PopFront(kBlockHot);
+    }
+    if (blk == nullptr) {
+        return nullptr;
+    }
+    if (blk->flags_ & kBlockDirty) {
+        if (Writeblk(blk->bno_, blk->data()) != NO_ERROR) {
+            // leave the block dirty and in the cache; the caller's Get fails
+            lists_.PushBack(blk, from_fifo ? kBlockFifo : kBlockHot);
+            return nullptr;
+        }
+        blk->flags_ &= ~kBlockDirty;
+        dirty_count_--;
+    }
+    if (from_fifo) {
+        RememberGhost(blk->bno_);
+    }
+    hash_.erase(*blk);
+    return blk;
+}
+
+mxtl::RefPtr<Block> Bcache::GetInternal(uint32_t bno, uint32_t mode) {
+    trace(BCACHE, "bcache_get() bno=%u %s\n", bno, modestr(mode));
+    if (bno >= blockmax_) {
+        return nullptr;
+    }
+    if (LockMemory() != NO_ERROR) {
+        return nullptr;
+    }
+    mxtl::RefPtr<Block> blk = hash_.find(bno).CopyPointer();
+    if (blk != nullptr) {
+        assert(!(blk->flags_ & kBlockBusy));
+        if (blk->flags_ & kBlockHot) {
+            lists_.Erase(blk, kBlockHot);
+            blk->flags_ |= kBlockWasHot;
+        } else {
+            // a repeat hit while still on the FIFO does not prove the
+            // block is hot; it returns to the FIFO on Put
+            lists_.Erase(blk, kBlockFifo);
+        }
+        if (mode == kModeZero) {
+            SetDirty(blk);
+            memset(blk->data(), 0, blocksize_);
+        }
+    } else {
+        if ((blk = lists_.PopFront(kBlockFree)) == nullptr) {
+            if ((blk = Evict()) == nullptr) {
+                error("bcache: bno %u no frame available\n", bno);
+                return nullptr;
+            }
+        }
+        // a recent FIFO eviction re-referenced: it belongs on the main LRU
+        if (TakeGhost(bno)) {
+            blk->flags_ |= kBlockWasHot;
+        }
+        blk->bno_ = bno;
+        hash_.insert(blk);
+        if (mode == kModeZero) {
+            SetDirty(blk);
+            memset(blk->data(), 0, blocksize_);
+        } else if (Readblk(bno, blk->data()) != NO_ERROR) {
+            hash_.erase(*blk);
+            blk->flags_ &= ~kBlockWasHot;
+            lists_.PushBack(mxtl::move(blk), kBlockFree);
+            return nullptr;
+        }
+    }
+    lists_.PushBack(blk, kBlockBusy);
+    trace(BCACHE, "bcache_get bno=%u %p\n", bno, blk.get());
+    return blk;
+}
+
+mxtl::RefPtr<Block> Bcache::Get(uint32_t bno) {
+    return GetInternal(bno, kModeLoad);
+}
+
+mxtl::RefPtr<Block> Bcache::GetZero(uint32_t bno) {
+    return GetInternal(bno, kModeZero);
+}
+
+void Bcache::Put(mxtl::RefPtr<Block> blk, uint32_t flags) {
+    trace(BCACHE, "bcache_put() bno=%u%s\n", blk->bno_, (flags & kBlockDirty) ? " DIRTY" : "");
+    assert(blk->flags_ & kBlockBusy);
+    lists_.Erase(blk, kBlockBusy);
+    if (flags & kBlockDirty) {
+        SetDirty(blk);
+    }
+    uint32_t list = (blk->flags_ & kBlockWasHot) ? kBlockHot : kBlockFifo;
+    blk->flags_ &= ~kBlockWasHot;
+    lists_.PushBack(mxtl::move(blk), list);
+    // Dirty blocks stay in the cache so that repeated updates to the
+    // same blocks are absorbed, but bound how much unwritten data can
+    // accumulate.
+    if (dirty_count_ >= (num_blocks_ / 4) + 1) {
+        Flush();
+    }
+}
+
+mx_status_t Bcache::Flush() {
+    if (dirty_count_ == 0) {
+        return NO_ERROR;
+    }
+    AllocChecker ac;
+    mxtl::unique_ptr<Block*[]> dirty(new (&ac) Block*[num_blocks_]);
+    if (!ac.check()) {
+        return ERR_NO_MEMORY;
+    }
+    uint32_t n = lists_.CollectDirty(dirty.get(), num_blocks_);
+    trace(BCACHE, "bcache_flush() %u dirty\n", n);
+
+    // Sort by block number so physically-adjacent blocks coalesce into
+    // ranged writes (insertion sort; flushes are I/O bound anyway).
+    for (uint32_t i = 1; i < n; i++) {
+        Block* tmp = dirty[i];
+        uint32_t j = i;
+        while ((j > 0) && (dirty[j - 1]->bno_ > tmp->bno_)) {
+            dirty[j] = dirty[j - 1];
+            j--;
+        }
+        dirty[j] = tmp;
+    }
+
+    mx_status_t status = NO_ERROR;
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t run = 1;
+        while ((i + run < n) && (dirty[i + run]->bno_ == dirty[i]->bno_ + run)) {
+            run++;
+        }
+        mx_status_t r = WriteRun(&dirty[i], run);
+        if (r != NO_ERROR) {
+            // leave the blocks dirty so a later Flush can retry
+            status = r;
+        } else {
+            for (uint32_t j = i; j < i + run; j++) {
+                dirty[j]->flags_ &= ~kBlockDirty;
+                dirty_count_--;
+            }
+        }
+        i += run;
+    }
+    return status;
+}
+
+void Bcache::DropAll() {
+    mxtl::RefPtr<Block> blk;
+    uint32_t n = 0;
+    while ((blk = lists_.PopFront(kBlockFifo)) != nullptr) {
+        hash_.erase(*blk);
+        lists_.PushBack(mxtl::move(blk), kBlockFree);
+        n++;
+    }
+    while ((blk = lists_.PopFront(kBlockHot)) != nullptr) {
+        hash_.erase(*blk);
+        lists_.PushBack(mxtl::move(blk), kBlockFree);
+        n++;
+    }
+    trace(BCACHE, "[ %d blocks dropped ]\n", n);
+}
+
+void Bcache::Invalidate() {
+    Flush();
+    assert(lists_.IsEmpty(kBlockBusy));
+    DropAll();
+}
+
+mx_status_t Bcache::Read(uint32_t bno, void* data, uint32_t off, uint32_t len) {
+    trace(BCACHE, "bcache_read() bno=%u off=%u len=%u\n", bno, off, len);
+    if ((off > blocksize_) || ((blocksize_ - off) < len)) {
+        return ERR_INVALID_ARGS;
+    }
+    mxtl::RefPtr<Block> blk = Get(bno);
+    if (blk == nullptr) {
+        return ERR_IO;
+    }
+    memcpy(data, (void*)((uintptr_t)blk->data() + off), len);
+    Put(mxtl::move(blk), 0);
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::Write(uint32_t bno, const void* data, uint32_t off, uint32_t len) {
+    trace(BCACHE, "bcache_write() bno=%u off=%u len=%u\n", bno, off, len);
+    if ((off > blocksize_) || ((blocksize_ - off) < len)) {
+        return ERR_INVALID_ARGS;
+    }
+    mxtl::RefPtr<Block> blk = Get(bno);
+    if (blk == nullptr) {
+        return ERR_IO;
+    }
+    memcpy((void*)((uintptr_t)blk->data() + off), data, len);
+    Put(mxtl::move(blk), kBlockDirty);
+    return NO_ERROR;
+}
+
+#ifdef __Fuchsia__
+
+mx_status_t Bcache::Reclaim() {
+    if (!lists_.IsEmpty(kBlockBusy)) {
+        // a discard would zero memory under a client's pointer
+        return ERR_UNAVAILABLE;
+    }
+    mx_status_t status = Flush();
+    if (status != NO_ERROR) {
+        return status;
+    }
+    if (unlocked_) {
+        return NO_ERROR;
+    }
+    status = mx_vmo_op_range(vmo_, MX_VMO_OP_UNLOCK, 0, vmo_size_, nullptr, 0);
+    if (status != NO_ERROR) {
+        return status;
+    }
+    unlocked_ = true;
+    return NO_ERROR;
+}
+
+mx_status_t Bcache::LockMemory() {
+    if (!unlocked_) {
+        return NO_ERROR;
+    }
+    mx_status_t status = mx_vmo_op_range(vmo_, MX_VMO_OP_LOCK, 0, vmo_size_, nullptr, 0);
+    if (status != NO_ERROR) {
+        return status;
+    }
+    unlocked_ = false;
+    uint64_t* canary = (uint64_t*)addr_;
+    if (*canary != kCanary) {
+        // the kernel reclaimed the pages while unlocked; every frame now
+        // reads back as zeros, so the whole index is stale.  All blocks
+        // were clean when Reclaim() unlocked, so nothing is lost.
+        trace(BCACHE, "bcache: contents discarded under memory pressure\n");
+        DropAll();
+        *canary = kCanary;
+    }
+    return NO_ERROR;
+}
+
+#else
+
+mx_status_t Bcache::Reclaim() {
+    return Flush();
+}
+
+mx_status_t Bcache::LockMemory() {
+    return NO_ERROR;
+}
+
+#endif
+
+int Bcache::Sync() {
+    if (Flush() != NO_ERROR) {
+        return -1;
+    }
+    return fsync(fd_);
+}
+
+mx_status_t Bcache::Create(mxtl::unique_ptr<Bcache>* out, int fd, uint32_t blockmax,
+                           uint32_t blocksize, uint32_t num) {
+    if ((blocksize == 0) || (num == 0)) {
+        return ERR_INVALID_ARGS;
+    }
+    AllocChecker ac;
+    mxtl::unique_ptr<Bcache> bc(new (&ac) Bcache(fd, blockmax, blocksize));
+    if (!ac.check()) {
+        return ERR_NO_MEMORY;
+    }
+    bc->num_blocks_ = num;
+    // 2Q: a quarter of the frames absorb first-access (scan) traffic
+    bc->fifo_target_ = (num / 4) + 1;
+
+#ifdef __Fuchsia__
+    // one canary page, then the frames
+    size_t size = PAGE_SIZE + (size_t)num * blocksize;
+    size = (size + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+    mx_status_t status;
+    if ((status = mx_vmo_create(size, 0, &bc->vmo_)) != NO_ERROR) {
+        return status;
+    }
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, bc->vmo_, 0, size,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
+                              &bc->addr_)) != NO_ERROR) {
+        mx_handle_close(bc->vmo_);
+        bc->vmo_ = MX_HANDLE_INVALID;
+        return status;
+    }
+    bc->vmo_size_ = size;
+    *(uint64_t*)bc->addr_ = kCanary;
+#endif
+
+    for (uint32_t i = 0; i < num; i++) {
+        mxtl::RefPtr<Block> blk = mxtl::AdoptRef(new (&ac) Block());
+        if (!ac.check()) {
+            return ERR_NO_MEMORY;
+        }
+#ifdef __Fuchsia__
+        blk->vmo_offset_ = PAGE_SIZE + (uint64_t)i * blocksize;
+        blk->data_ = (void*)(bc->addr_ + blk->vmo_offset_);
+#else
+        blk->frame_.reset(static_cast<char*>(malloc(blocksize)));
+        if (blk->frame_ == nullptr) {
+            return ERR_NO_MEMORY;
+        }
+        blk->data_ = blk->frame_.get();
+#endif
+        bc->lists_.PushBack(mxtl::move(blk), kBlockFree);
+    }
+
+    *out = mxtl::move(bc);
+    return NO_ERROR;
+}
+
+int Bcache::Close() {
+    Flush();
+    return close(fd_);
+}
+
+Bcache::Bcache(int fd, uint32_t blockmax, uint32_t blocksize)
+    : ghost_count_(0), fd_(fd), blockmax_(blockmax), blocksize_(blocksize),
+      num_blocks_(0), fifo_target_(0), dirty_count_(0) {
+#ifdef __Fuchsia__
+    vmo_ = MX_HANDLE_INVALID;
+    addr_ = 0;
+    vmo_size_ = 0;
+    unlocked_ = false;
+#endif
+}
+
+Bcache::~Bcache() {
+    ghost_hash_.clear();
+    ghost_fifo_.clear();
+#ifdef __Fuchsia__
+    if (addr_ != 0) {
+        mx_vmar_unmap(mx_vmar_root_self(), addr_, vmo_size_);
+    }
+    if (vmo_ != MX_HANDLE_INVALID) {
+        mx_handle_close(vmo_);
+    }
+#endif
+}
+
+void BcacheLists::PushBack(mxtl::RefPtr<Block> blk, uint32_t block_type) {
+    block_type &= kBlockLLFlags;
+    auto ll = GetList(block_type);
+    blk->flags_ |= block_type;
+    ll->push_back(mxtl::move(blk));
+}
+
+mxtl::RefPtr<Block> BcacheLists::PopFront(uint32_t block_type) {
+    block_type &= kBlockLLFlags;
+    auto ll = GetList(block_type);
+    auto blk = ll->pop_front();
+    if (blk != nullptr) {
+        blk->flags_ &= ~block_type;
+    }
+    return blk;
+}
+
+mxtl::RefPtr<Block> BcacheLists::Erase(mxtl::RefPtr<Block> blk, uint32_t block_type) {
+    block_type &= kBlockLLFlags;
+    auto ll = GetList(block_type);
+    blk->flags_ &= ~block_type;
+    auto ptr = ll->erase(*blk);
+    assert(ptr != nullptr);
+    return ptr;
+}
+
+uint32_t BcacheLists::CollectDirty(Block** out, uint32_t max) {
+    uint32_t n = 0;
+    for (auto& blk : list_fifo_) {
+        if (!(blk.flags_ & kBlockDirty)) {
+            continue;
+        }
+        if (n == max) {
+            break;
+        }
+        out[n++] = &blk;
+    }
+    for (auto& blk : list_hot_) {
+        if (!(blk.flags_ & kBlockDirty)) {
+            continue;
+        }
+        if (n == max) {
+            break;
+        }
+        out[n++] = &blk;
+    }
+    return n;
+}
+
+bool BcacheLists::IsEmpty(uint32_t block_type) const {
+    return GetList(block_type & kBlockLLFlags)->is_empty();
+}
+
+size_t BcacheLists::Size(uint32_t block_type) const {
+    return GetList(block_type & kBlockLLFlags)->size_slow();
+}
+
+BcacheLists::LinkedList* BcacheLists::GetList(uint32_t block_type) {
+    switch (block_type) {
+        case kBlockBusy : return &list_busy_;
+        case kBlockFifo : return &list_fifo_;
+        case kBlockHot  : return &list_hot_;
+        case kBlockFree : return &list_free_;
+    }
+    assert(false); // Invalid Block Cache List
+    return nullptr;
+}
+
+const BcacheLists::LinkedList* BcacheLists::GetList(uint32_t block_type) const {
+    return const_cast<BcacheLists*>(this)->GetList(block_type);
+}
+
+Block::Block() : flags_(kBlockFree), bno_(0), data_(nullptr) {}
+Block::~Block() {}
+
+} // namespace bcache
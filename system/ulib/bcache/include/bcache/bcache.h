@@ -0,0 +1,231 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <magenta/types.h>
+#include <mxtl/intrusive_double_list.h>
+#include <mxtl/intrusive_single_list.h>
+#include <mxtl/intrusive_hash_table.h>
+#include <mxtl/ref_counted.h>
+#include <mxtl/ref_ptr.h>
+#include <mxtl/unique_free_ptr.h>
+#include <mxtl/unique_ptr.h>
+
+// A block cache shared between filesystems.
+//
+// Eviction follows the 2Q scheme: blocks touched once sit on a FIFO and
+// age out without disturbing the main LRU, so a one-pass scan (fsck,
+// backup, large file read) cannot flush the hot metadata set.  A block
+// is only promoted to the main LRU when it is referenced again after
+// falling off the FIFO, tracked through a ghost list of recently
+// evicted block numbers.
+//
+// On Fuchsia the cache frames live in a single VMO, so a frame can be
+// handed to a block device FIFO or another process without copying, and
+// the memory can be surrendered to the kernel under pressure: Reclaim()
+// writes back dirty blocks and unlocks the VMO (MX_VMO_OP_UNLOCK), and
+// the next access relocks it, detecting whether the kernel discarded
+// the contents in between and dropping the index if so.
+
+namespace bcache {
+
+constexpr uint32_t kBlockDirty  = 0x01;
+constexpr uint32_t kBlockBusy   = 0x02;
+constexpr uint32_t kBlockFifo   = 0x04; // on the first-access FIFO (2Q "A1in")
+constexpr uint32_t kBlockHot    = 0x08; // on the main LRU (2Q "Am")
+constexpr uint32_t kBlockFree   = 0x10;
+constexpr uint32_t kBlockWasHot = 0x20; // busy block returns to the main LRU
+
+constexpr uint32_t kBlockLLFlags = (kBlockBusy | kBlockFifo | kBlockHot | kBlockFree);
+
+uint32_t fnv1a32(const void* ptr, size_t len);
+
+class Bcache;
+
+class Block : public mxtl::DoublyLinkedListable<mxtl::RefPtr<Block>>,
+              public mxtl::RefCounted<Block> {
+public:
+    using NodeState = mxtl::DoublyLinkedListNodeState<mxtl::RefPtr<Block>>;
+    struct TypeListTraits {
+        static NodeState& node_state(Block& blk) { return blk.type_list_state_; }
+    };
+    struct TypeHashTraits {
+        static NodeState& node_state(Block& blk) { return blk.type_hash_state_; }
+    };
+
+    void* data() const { return data_; }
+    uint32_t bno() const { return bno_; }
+
+#ifdef __Fuchsia__
+    // Offset of this block's frame within the cache VMO (see
+    // Bcache::GetVmo), for zero-copy handoff.  Only valid while the
+    // block is held busy between Get() and Put().
+    uint64_t vmo_offset() const { return vmo_offset_; }
+#endif
+
+    // Allow Block to be placed in an mxtl::HashTable
+    uint32_t GetKey() const { return bno_; }
+    static size_t GetHash(uint32_t key) { return fnv1a32(&key, sizeof(key)); }
+
+    ~Block();
+
+private:
+    friend class Bcache;
+    friend class BcacheLists;
+    friend struct TypeListTraits;
+    friend struct TypeHashTraits;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Block);
+    Block();
+
+    NodeState type_list_state_;
+    NodeState type_hash_state_;
+    uint32_t flags_;
+    uint32_t bno_;
+    void* data_;
+#ifdef __Fuchsia__
+    uint64_t vmo_offset_;
+#else
+    mxtl::unique_free_ptr<char> frame_;
+#endif
+};
+
+// Remembers the block numbers of blocks recently evicted from the
+// first-access FIFO; a miss that hits here loads straight onto the main
+// LRU (the second reference proves the block is not scan traffic).
+class Ghost : public mxtl::DoublyLinkedListable<mxtl::unique_ptr<Ghost>>,
+              public mxtl::SinglyLinkedListable<Ghost*> {
+public:
+    Ghost(uint32_t bno) : bno_(bno) {}
+
+    uint32_t GetKey() const { return bno_; }
+    static size_t GetHash(uint32_t key) { return fnv1a32(&key, sizeof(key)); }
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Ghost);
+    uint32_t bno_;
+};
+
+class BcacheLists {
+public:
+    void PushBack(mxtl::RefPtr<Block> blk, uint32_t block_type);
+    mxtl::RefPtr<Block> PopFront(uint32_t block_type);
+    mxtl::RefPtr<Block> Erase(mxtl::RefPtr<Block> blk, uint32_t block_type);
+    uint32_t CollectDirty(Block** out, uint32_t max);
+    bool IsEmpty(uint32_t block_type) const;
+    size_t Size(uint32_t block_type) const;
+
+private:
+    using LinkedList = mxtl::DoublyLinkedList<mxtl::RefPtr<Block>, Block::TypeListTraits>;
+    LinkedList* GetList(uint32_t block_type);
+    const LinkedList* GetList(uint32_t block_type) const;
+
+    LinkedList list_busy_;  // between Get() and Put()
+    LinkedList list_fifo_;  // seen once; FIFO order
+    LinkedList list_hot_;   // seen again; LRU order
+    LinkedList list_free_;  // uninitialized or dropped
+};
+
+class Bcache {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Bcache);
+
+    // Create a cache of |num| blocks of |blocksize| bytes over |fd|,
+    // which must refer to a device (or image) of |blockmax| blocks.
+    // The fd is owned by the cache once Create succeeds.
+    static mx_status_t Create(mxtl::unique_ptr<Bcache>* out, int fd,
+                              uint32_t blockmax, uint32_t blocksize, uint32_t num);
+
+    // Raw block I/O; does not consult or populate the cache.
+    mx_status_t Readblk(uint32_t bno, void* data);
+    mx_status_t Writeblk(uint32_t bno, const void* data);
+    mx_status_t ReadRun(uint32_t bno, uint32_t count, void* data);
+
+    uint32_t Maxblk() const { return blockmax_; }
+    uint32_t Blocksize() const { return blocksize_; }
+
+    // Acquire a block, reading from disk if necessary.  Returns nullptr
+    // if |bno| is out of range or the backing I/O fails.
+    mxtl::RefPtr<Block> Get(uint32_t bno);
+    // Acquire a block without reading from disk, marking it dirty and
+    // clearing it to zeros.
+    mxtl::RefPtr<Block> GetZero(uint32_t bno);
+
+    // Release a block back to the cache.
+    // |flags| *must* contain kBlockDirty if it was modified.
+    //
+    // Dirty blocks are not written through; they remain in the cache
+    // until the dirty count crosses the write-back threshold, the block
+    // is evicted for re-use, or Flush/Sync is called.
+    void Put(mxtl::RefPtr<Block> blk, uint32_t flags);
+
+    // Helper functions which combine Get and Put.
+    mx_status_t Read(uint32_t bno, void* data, uint32_t off, uint32_t len);
+    mx_status_t Write(uint32_t bno, const void* data, uint32_t off, uint32_t len);
+
+    // Write all dirty blocks back to the disk, coalescing runs of
+    // adjacent block numbers into single ranged writes.
+    mx_status_t Flush();
+
+    // Write back dirty blocks, then drop all non-busy blocks.
+    void Invalidate();
+
+    // Hand the cache memory back to the kernel: write back all dirty
+    // blocks and unlock the cache VMO, making its pages discardable
+    // until the next access.  Fails with ERR_UNAVAILABLE while any
+    // block is held busy (a discard would zero memory under the
+    // client's pointer).  Callers wire this to their low-memory signal.
+    mx_status_t Reclaim();
+
+#ifdef __Fuchsia__
+    // The VMO backing the cache frames; see Block::vmo_offset().
+    mx_handle_t GetVmo() const { return vmo_; }
+#endif
+
+    int Sync();
+    int Close();
+
+    ~Bcache();
+
+private:
+    friend class Block;
+
+    Bcache(int fd, uint32_t blockmax, uint32_t blocksize);
+
+    mxtl::RefPtr<Block> GetInternal(uint32_t bno, uint32_t mode);
+    mxtl::RefPtr<Block> Evict();
+    void SetDirty(const mxtl::RefPtr<Block>& blk);
+    void RememberGhost(uint32_t bno);
+    bool TakeGhost(uint32_t bno);
+    void DropAll();
+    mx_status_t LockMemory();
+    mx_status_t WriteRun(Block** blks, uint32_t count);
+
+    using HashTableBucket = mxtl::DoublyLinkedList<mxtl::RefPtr<Block>, Block::TypeHashTraits>;
+    using HashTable = mxtl::HashTable<uint32_t, mxtl::RefPtr<Block>, HashTableBucket>;
+    using GhostTable = mxtl::HashTable<uint32_t, Ghost*>;
+
+    HashTable hash_; // Map of all 'in use' blocks, accessible by bno
+    BcacheLists lists_;
+    mxtl::DoublyLinkedList<mxtl::unique_ptr<Ghost>> ghost_fifo_;
+    GhostTable ghost_hash_;
+    uint32_t ghost_count_;
+    int fd_;
+    uint32_t blockmax_;
+    uint32_t blocksize_;
+    uint32_t num_blocks_;
+    uint32_t fifo_target_;
+    uint32_t dirty_count_;
+#ifdef __Fuchsia__
+    mx_handle_t vmo_;
+    uintptr_t addr_;
+    size_t vmo_size_;
+    bool unlocked_;
+#endif
+};
+
+} // namespace bcache
@@ -106,9 +106,11 @@ size_t RawBitmapGeneric<Storage>::Scan(size_t bitoff, size_t bitmax, bool is_set
     }
     size_t first_idx = FirstIdx(bitoff);
     size_t last_idx = LastIdx(bitmax);
+    // The word value an interior word must have for the run to continue.
+    const size_t match = is_set ? ~static_cast<size_t>(0) : 0;
     size_t i = first_idx;
     size_t value = 0;
-    for (i = first_idx; i <= last_idx; ++i) {
+    while (i <= last_idx) {
         value = GetMask(i == first_idx, i == last_idx, bitoff, bitmax);
         if (is_set) {
             // If is_set=true, invert the mask, OR it with the value, and invert
@@ -122,6 +124,16 @@ size_t RawBitmapGeneric<Storage>::Scan(size_t bitoff, size_t bitmax, bool is_set
         if (value != 0) {
             break;
         }
+        ++i;
+        // Interior words (everything past the first and before the last) need
+        // no masking, so burn through runs of them four at a time.  Folding
+        // the four comparisons into a single OR lets the compiler turn this
+        // into wide vector loads and compares where the target supports them.
+        while (i + 4 <= last_idx &&
+               ((data_[i] ^ match) | (data_[i + 1] ^ match) |
+                (data_[i + 2] ^ match) | (data_[i + 3] ^ match)) == 0) {
+            i += 4;
+        }
     }
     return mxtl::min(bitmax, CountZeros(i, value));
 }
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <assert.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <magenta/compiler.h>
@@ -40,11 +41,13 @@ static mx_status_t do_write(mx_handle_t fifo, block_fifo_request_t* request, siz
     }
 }
 
-static mx_status_t do_read(mx_handle_t fifo, block_fifo_response_t* response) {
+// Reads as many responses as the FIFO currently holds (up to the FIFO
+// depth), blocking only when none are available yet.
+static mx_status_t do_read(mx_handle_t fifo, block_fifo_response_t* responses, uint32_t* count) {
     mx_status_t status;
     while (true) {
-        uint32_t count;
-        status = mx_fifo_read(fifo, response, sizeof(block_fifo_response_t), &count);
+        status = mx_fifo_read(fifo, responses,
+                              sizeof(block_fifo_response_t) * BLOCK_FIFO_MAX_DEPTH, count);
         if (status == ERR_SHOULD_WAIT) {
             mx_signals_t signals;
             if ((status = mx_object_wait_one(fifo,
@@ -68,6 +71,9 @@ typedef struct block_completion {
 
 typedef struct fifo_client {
     mx_handle_t fifo;
+    // Serializes FIFO readers; whichever thread holds this drains responses
+    // for everyone.
+    mtx_t read_lock;
     block_completion_t txns[MAX_TXN_COUNT];
 } fifo_client_t;
 
@@ -77,6 +83,7 @@ mx_status_t block_fifo_create_client(mx_handle_t fifo, fifo_client_t** out) {
         return ERR_NO_MEMORY;
     }
     client->fifo = fifo;
+    mtx_init(&client->read_lock, mtx_plain);
     *out = client;
     return NO_ERROR;
 }
@@ -112,20 +119,34 @@ mx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests
         return status;
     }
 
-    // As expected by the protocol, when we send one "BLOCKIO_TXN_END" message, we
-    // must read a reply message.
-    block_fifo_response_t response;
-    if ((status = do_read(client->fifo, &response)) != NO_ERROR) {
-        return status;
-    }
+    // As expected by the protocol, when we send one "BLOCKIO_TXN_END" message, the
+    // server owes us exactly one reply. Responses are drained in batches:
+    // whichever thread is reading signals the completion of every response it
+    // pulls off the FIFO, so our reply may arrive via another thread's read.
+    while (completion_wait(&client->txns[txnid].completion, 0) == ERR_TIMED_OUT) {
+        mtx_lock(&client->read_lock);
+        // The previous reader may have drained our response while we were
+        // waiting for the lock.
+        if (completion_wait(&client->txns[txnid].completion, 0) == NO_ERROR) {
+            mtx_unlock(&client->read_lock);
+            break;
+        }
 
-    // Wake up someone who is waiting (it might be ourselves)
-    txnid_t response_txnid = response.txnid;
-    client->txns[response_txnid].status = response.status;
-    completion_signal(&client->txns[response_txnid].completion);
+        block_fifo_response_t responses[BLOCK_FIFO_MAX_DEPTH];
+        uint32_t response_count;
+        status = do_read(client->fifo, responses, &response_count);
+        mtx_unlock(&client->read_lock);
+        if (status != NO_ERROR) {
+            return status;
+        }
 
-    // Wait for someone to signal us
-    completion_wait(&client->txns[txnid].completion, MX_TIME_INFINITE);
+        // Wake up everyone who is waiting (possibly including ourselves)
+        for (uint32_t i = 0; i < response_count; i++) {
+            txnid_t response_txnid = responses[i].txnid;
+            client->txns[response_txnid].status = responses[i].status;
+            completion_signal(&client->txns[response_txnid].completion);
+        }
+    }
 
     return client->txns[txnid].status;
 }
@@ -13,6 +13,11 @@
 
 #include <lz4/lz4.h>
 
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+#include <runtime/thread.h>
+#include <stdbool.h>
+#endif
+
 // The LZ4 Frame format is used to compress a bootfs image, but we cannot use
 // the LZ4 library's decompression functions in userboot. The following
 // definitions are used in the reimplementation of LZ4 Frame decompression, with
@@ -85,7 +90,192 @@ static mx_status_t check_lz4_frame(const lz4_frame_desc* fd,
     return NO_ERROR;
 }
 
-static mx_status_t decompress_bootfs_vmo(mx_handle_t vmar,
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+
+// Parallel block decompression for callers (userboot) that can host raw
+// mxr threads.  Blocks in our restricted frame format are independent, so
+// they can be decompressed in any order once their output offsets are
+// known.  Every compressed block except the last must inflate to exactly
+// LZ4_BLOCK_SIZE for the precomputed offsets to hold; the workers verify
+// this and any violation makes the caller rerun the plain serial pass,
+// which rewrites the output from the start.
+
+#define LZ4_BLOCK_SIZE 65536u
+#define LZ4_MAX_WORKERS 8u
+#define LZ4_WORKER_STACK_SIZE 16384u
+
+typedef struct {
+    uint32_t src_off;
+    uint32_t dst_off;
+    uint32_t size;
+    uint32_t raw;
+} lz4_block_t;
+
+typedef struct {
+    const uint8_t* src;
+    uint8_t* dst;
+    const lz4_block_t* blocks;
+    uint32_t nblocks;
+    uint32_t first;
+    uint32_t stride;
+    size_t dst_len;
+    mx_status_t status;
+    mxr_thread_t thread;
+} lz4_worker_t;
+
+static void lz4_worker(void* arg) {
+    lz4_worker_t* w = arg;
+    for (uint32_t i = w->first; i < w->nblocks; i += w->stride) {
+        const lz4_block_t* b = &w->blocks[i];
+        if (b->raw) {
+            memcpy(w->dst + b->dst_off, w->src + b->src_off, b->size);
+        } else {
+            size_t expect = (i == w->nblocks - 1) ?
+                    w->dst_len - b->dst_off : LZ4_BLOCK_SIZE;
+            int dcmp = LZ4_decompress_safe((const char*)(w->src + b->src_off),
+                                           (char*)(w->dst + b->dst_off),
+                                           b->size, expect);
+            if ((dcmp < 0) || ((size_t)dcmp != expect)) {
+                w->status = ERR_BAD_STATE;
+                return;
+            }
+        }
+    }
+    w->status = NO_ERROR;
+}
+
+// data points at the first block size header; dst at the first output
+// byte (past the copied bootdata header); dst_len is the exact content
+// size from the frame header.  Any failure returns non-NO_ERROR and the
+// caller falls back to the serial loop.
+static mx_status_t decompress_blocks_parallel(mx_handle_t proc, mx_handle_t vmar,
+                                              const uint8_t* data, uint8_t* dst,
+                                              size_t dst_len) {
+    uint32_t nworkers = mx_system_get_num_cpus();
+    if (nworkers > LZ4_MAX_WORKERS) {
+        nworkers = LZ4_MAX_WORKERS;
+    }
+    if (nworkers < 2) {
+        // Nothing to gain over the serial loop.
+        return ERR_NOT_SUPPORTED;
+    }
+
+    // The block table and the worker stacks live in a scratch VMO since
+    // userboot has no heap.
+    uint32_t max_blocks = (uint32_t)(dst_len / LZ4_BLOCK_SIZE) + 2;
+    size_t table_size = (max_blocks * sizeof(lz4_block_t) + PAGE_SIZE - 1) &
+            ~((size_t)PAGE_SIZE - 1);
+    size_t scratch_size = table_size + (nworkers - 1) * LZ4_WORKER_STACK_SIZE;
+    mx_handle_t scratch_vmo;
+    mx_status_t status = mx_vmo_create(scratch_size, 0, &scratch_vmo);
+    if (status < 0) {
+        return status;
+    }
+    uintptr_t scratch = 0;
+    status = mx_vmar_map(vmar, 0, scratch_vmo, 0, scratch_size,
+                         MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE, &scratch);
+    if (status < 0) {
+        mx_handle_close(scratch_vmo);
+        return status;
+    }
+    lz4_block_t* blocks = (lz4_block_t*)scratch;
+
+    // Scan the block size headers, assigning each block an output offset
+    // under the assumption that compressed blocks inflate to exactly
+    // LZ4_BLOCK_SIZE (raw blocks carry their actual size).
+    status = ERR_BAD_STATE;
+    const uint8_t* p = data;
+    uint32_t nblocks = 0;
+    size_t dst_off = 0;
+    for (;;) {
+        uint32_t blocksize = *(const uint32_t*)p;
+        p += sizeof(uint32_t);
+        if (blocksize == 0) {
+            break;
+        }
+        if ((nblocks == max_blocks) || (dst_off >= dst_len) ||
+            ((size_t)(p - data) > UINT32_MAX)) {
+            goto done;
+        }
+        lz4_block_t* b = &blocks[nblocks++];
+        b->src_off = (uint32_t)(p - data);
+        b->dst_off = (uint32_t)dst_off;
+        b->raw = blocksize >> 31;
+        b->size = blocksize & 0x7fffffff;
+        p += b->size;
+        dst_off += b->raw ? b->size : LZ4_BLOCK_SIZE;
+    }
+    if (nblocks == 0) {
+        goto done;
+    }
+
+    // The final block is the only one allowed to come up short; check
+    // that the remainder it has to produce is plausible.
+    const lz4_block_t* lastb = &blocks[nblocks - 1];
+    size_t tail = dst_len - lastb->dst_off;
+    if (lastb->raw ? (lastb->size != tail) : (tail > LZ4_BLOCK_SIZE)) {
+        goto done;
+    }
+
+    lz4_worker_t workers[LZ4_MAX_WORKERS];
+    for (uint32_t i = 0; i < nworkers; i++) {
+        lz4_worker_t* w = &workers[i];
+        w->src = data;
+        w->dst = dst;
+        w->blocks = blocks;
+        w->nblocks = nblocks;
+        w->first = i;
+        w->stride = nworkers;
+        w->dst_len = dst_len;
+        w->status = ERR_BAD_STATE;
+    }
+
+    // Workers take blocks first, first+stride, ...; this thread doubles
+    // as worker zero.
+    uint32_t started = 1;
+    bool spawn_failed = false;
+    for (uint32_t i = 1; i < nworkers; i++) {
+        lz4_worker_t* w = &workers[i];
+        uintptr_t stack = scratch + table_size +
+                (i - 1) * LZ4_WORKER_STACK_SIZE;
+        if (mxr_thread_create(proc, "lz4-decompress", false, &w->thread) != NO_ERROR) {
+            spawn_failed = true;
+            break;
+        }
+        if (mxr_thread_start(&w->thread, stack, LZ4_WORKER_STACK_SIZE,
+                             lz4_worker, w) != NO_ERROR) {
+            mxr_thread_destroy(&w->thread);
+            spawn_failed = true;
+            break;
+        }
+        started++;
+    }
+    if (!spawn_failed) {
+        lz4_worker(&workers[0]);
+    }
+    for (uint32_t i = 1; i < started; i++) {
+        mxr_thread_join(&workers[i].thread);
+    }
+    if (spawn_failed) {
+        status = ERR_NO_RESOURCES;
+        goto done;
+    }
+    status = NO_ERROR;
+    for (uint32_t i = 0; i < nworkers; i++) {
+        if (workers[i].status != NO_ERROR) {
+            status = workers[i].status;
+        }
+    }
+
+done:
+    mx_vmar_unmap(vmar, scratch, scratch_size);
+    mx_handle_close(scratch_vmo);
+    return status;
+}
+
+#endif  // BOOTDATA_DECOMPRESS_PARALLEL
+
+static mx_status_t decompress_bootfs_vmo(mx_handle_t proc, mx_handle_t vmar,
                                          const uint8_t* data, mx_handle_t* out,
                                          const char** err) {
     const bootdata_t* hdr = (bootdata_t*)data;
@@ -135,6 +325,19 @@ static mx_status_t decompress_bootfs_vmo(mx_handle_t vmar,
     dst += sizeof(bootdata_t);
     remaining -= sizeof(bootdata_t);
 
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+    if (proc != MX_HANDLE_INVALID) {
+        if (decompress_blocks_parallel(proc, vmar, data, dst,
+                                       hdr->extra - sizeof(bootdata_t)) == NO_ERROR) {
+            goto unmap;
+        }
+        // Fall back to the serial pass below; it rewrites dst from the
+        // start, so any partial worker output is harmless.
+    }
+#else
+    (void)proc;
+#endif
+
     // Read each LZ4 block and decompress it. Block sizes are 32 bits.
     uint32_t blocksize = *(const uint32_t*)data;
     data += sizeof(uint32_t);
@@ -179,6 +382,9 @@ static mx_status_t decompress_bootfs_vmo(mx_handle_t vmar,
         return ERR_INVALID_ARGS;
     }
 
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+unmap:
+#endif
     status = mx_vmar_unmap(vmar, dst_addr, newsize);
     if (status < 0) {
         *err = "mx_vmar_unmap after decompress failed";
@@ -188,9 +394,10 @@ static mx_status_t decompress_bootfs_vmo(mx_handle_t vmar,
     return NO_ERROR;
 }
 
-mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
-                                size_t offset, size_t length,
-                                mx_handle_t* out, const char** err) {
+static mx_status_t decompress_bootdata_internal(mx_handle_t proc, mx_handle_t vmar,
+                                                mx_handle_t vmo,
+                                                size_t offset, size_t length,
+                                                mx_handle_t* out, const char** err) {
     *err = "none";
 
     if (length > SIZE_MAX) {
@@ -214,7 +421,7 @@ mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
     case BOOTDATA_BOOTFS_BOOT:
     case BOOTDATA_BOOTFS_SYSTEM:
         if (hdr->flags & BOOTDATA_BOOTFS_FLAG_COMPRESSED) {
-            status = decompress_bootfs_vmo(vmar, (const uint8_t*)addr, out, err);
+            status = decompress_bootfs_vmo(proc, vmar, (const uint8_t*)addr, out, err);
         }
         break;
     default:
@@ -226,3 +433,20 @@ mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
 
     return status;
 }
+
+mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
+                                size_t offset, size_t length,
+                                mx_handle_t* out, const char** err) {
+    return decompress_bootdata_internal(MX_HANDLE_INVALID, vmar, vmo,
+                                        offset, length, out, err);
+}
+
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+mx_status_t decompress_bootdata_parallel(mx_handle_t proc, mx_handle_t vmar,
+                                         mx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         mx_handle_t* out, const char** err) {
+    return decompress_bootdata_internal(proc, vmar, vmo,
+                                        offset, length, out, err);
+}
+#endif
@@ -16,4 +16,15 @@ mx_status_t decompress_bootdata(mx_handle_t vmar, mx_handle_t vmo,
                                 size_t offset, size_t length,
                                 mx_handle_t* out, const char** errmsg);
 
+#ifdef BOOTDATA_DECOMPRESS_PARALLEL
+// As above, but decompresses independent LZ4 blocks concurrently on one
+// worker thread per cpu, created in the process named by proc.  Only
+// compiled where the caller can host raw mxr threads (userboot); images
+// with irregular block sizes fall back to the serial path.
+mx_status_t decompress_bootdata_parallel(mx_handle_t proc, mx_handle_t vmar,
+                                         mx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         mx_handle_t* out, const char** errmsg);
+#endif
+
 #pragma GCC visibility pop
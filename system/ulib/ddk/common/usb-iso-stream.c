@@ -0,0 +1,172 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/common/usb.h>
+#include <ddk/common/usb-iso-stream.h>
+#include <magenta/hw/usb.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+
+struct usb_iso_stream {
+    mx_device_t* device;
+    uint8_t ep_address;
+    uint32_t num_slots;
+    uint32_t batch_size;
+    usb_iso_stream_cb_t cb;
+    void* cookie;
+
+    // protects the lists and counters below
+    mtx_t lock;
+    // slots available for the driver to fill
+    list_node_t free_slots;
+    // completed IN packets awaiting usb_iso_stream_claim()
+    list_node_t completed;
+    uint32_t free_count;
+    // slots queued to the host controller
+    uint32_t in_flight;
+    // completions since the callback last fired
+    uint32_t completions;
+    // set by usb_iso_stream_release(); remaining in-flight transfers tear
+    // the stream down as they complete
+    bool dead;
+};
+
+static void usb_iso_stream_free_locked(usb_iso_stream_t* stream) {
+    iotxn_t* txn;
+    while ((txn = list_remove_head_type(&stream->free_slots, iotxn_t, node)) != NULL) {
+        iotxn_release(txn);
+    }
+    while ((txn = list_remove_head_type(&stream->completed, iotxn_t, node)) != NULL) {
+        iotxn_release(txn);
+    }
+    mtx_unlock(&stream->lock);
+    free(stream);
+}
+
+static void usb_iso_stream_complete(iotxn_t* txn, void* cookie) {
+    usb_iso_stream_t* stream = (usb_iso_stream_t*)cookie;
+
+    mtx_lock(&stream->lock);
+    stream->in_flight--;
+
+    if (stream->dead || txn->status == ERR_PEER_CLOSED) {
+        iotxn_release(txn);
+        if (stream->dead && stream->in_flight == 0) {
+            usb_iso_stream_free_locked(stream);
+            return;
+        }
+        mtx_unlock(&stream->lock);
+        return;
+    }
+
+    bool in = (stream->ep_address & USB_ENDPOINT_DIR_MASK) == USB_DIR_IN;
+    if (in && txn->status == NO_ERROR && txn->actual > 0) {
+        list_add_tail(&stream->completed, &txn->node);
+    } else {
+        // OUT packets (and failed IN packets) become free slots again;
+        // isochronous errors are not retried, the stream just moves on
+        list_add_tail(&stream->free_slots, &txn->node);
+        stream->free_count++;
+    }
+
+    // wake the driver once per batch, or when the ring has fully drained
+    // so a refill cannot stall waiting for completions that will never come
+    bool fire_cb = false;
+    if (++stream->completions >= stream->batch_size || stream->in_flight == 0) {
+        stream->completions = 0;
+        fire_cb = true;
+    }
+    mtx_unlock(&stream->lock);
+
+    if (fire_cb && stream->cb) {
+        stream->cb(stream, stream->cookie);
+    }
+}
+
+mx_status_t usb_iso_stream_create(mx_device_t* device, uint8_t ep_address, size_t packet_size,
+                                  uint32_t num_slots, uint32_t batch_size,
+                                  usb_iso_stream_cb_t cb, void* cookie,
+                                  usb_iso_stream_t** out) {
+    if (num_slots == 0 || batch_size == 0 || batch_size > num_slots) {
+        return ERR_INVALID_ARGS;
+    }
+
+    usb_iso_stream_t* stream = calloc(1, sizeof(usb_iso_stream_t));
+    if (!stream) {
+        return ERR_NO_MEMORY;
+    }
+    stream->device = device;
+    stream->ep_address = ep_address;
+    stream->num_slots = num_slots;
+    stream->batch_size = batch_size;
+    stream->cb = cb;
+    stream->cookie = cookie;
+    mtx_init(&stream->lock, mtx_plain);
+    list_initialize(&stream->free_slots);
+    list_initialize(&stream->completed);
+
+    for (uint32_t i = 0; i < num_slots; i++) {
+        iotxn_t* txn = usb_alloc_iotxn(ep_address, packet_size);
+        if (!txn) {
+            mtx_lock(&stream->lock);
+            usb_iso_stream_free_locked(stream);
+            return ERR_NO_MEMORY;
+        }
+        txn->length = packet_size;
+        txn->complete_cb = usb_iso_stream_complete;
+        txn->cookie = stream;
+        list_add_tail(&stream->free_slots, &txn->node);
+        stream->free_count++;
+    }
+
+    *out = stream;
+    return NO_ERROR;
+}
+
+void usb_iso_stream_release(usb_iso_stream_t* stream) {
+    mtx_lock(&stream->lock);
+    if (stream->in_flight > 0) {
+        // the last completion frees the stream
+        stream->dead = true;
+        mtx_unlock(&stream->lock);
+        return;
+    }
+    usb_iso_stream_free_locked(stream);
+}
+
+iotxn_t* usb_iso_stream_next_slot(usb_iso_stream_t* stream) {
+    mtx_lock(&stream->lock);
+    iotxn_t* txn = list_remove_head_type(&stream->free_slots, iotxn_t, node);
+    if (txn) {
+        stream->free_count--;
+    }
+    mtx_unlock(&stream->lock);
+    return txn;
+}
+
+void usb_iso_stream_queue(usb_iso_stream_t* stream, iotxn_t* txn, uint64_t frame) {
+    usb_iotxn_set_frame(txn, frame);
+
+    mtx_lock(&stream->lock);
+    stream->in_flight++;
+    mtx_unlock(&stream->lock);
+
+    iotxn_queue(stream->device, txn);
+}
+
+iotxn_t* usb_iso_stream_claim(usb_iso_stream_t* stream) {
+    mtx_lock(&stream->lock);
+    iotxn_t* txn = list_remove_head_type(&stream->completed, iotxn_t, node);
+    mtx_unlock(&stream->lock);
+    return txn;
+}
+
+uint32_t usb_iso_stream_free_slots(usb_iso_stream_t* stream) {
+    mtx_lock(&stream->lock);
+    uint32_t count = stream->free_count;
+    mtx_unlock(&stream->lock);
+    return count;
+}
@@ -0,0 +1,136 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/dma-pool.h>
+#include <magenta/assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+// Free blocks are threaded into a singly linked list through their own
+// storage, so the pool needs no bookkeeping allocations of its own.
+typedef struct dma_pool_block {
+    struct dma_pool_block* next;
+} dma_pool_block_t;
+
+// Blocks are rounded up to this so two blocks never share a cache line,
+// which would defeat per-block clean/invalidate on non-coherent DMA.
+#define DMA_POOL_BLOCK_ALIGN 64
+
+struct dma_pool {
+    mtx_t lock;
+    io_buffer_t buffer;         // the backing slab
+    size_t block_size;
+    size_t block_count;
+    dma_pool_block_t* free_list;
+    // statistics, protected by lock
+    size_t free_count;
+    size_t low_water;
+    size_t alloc_failures;
+};
+
+mx_status_t dma_pool_create(size_t block_size, size_t block_count, uint32_t flags,
+                            dma_pool_t** out) {
+    if (block_size == 0 || block_count == 0) {
+        return ERR_INVALID_ARGS;
+    }
+    if (block_size < sizeof(dma_pool_block_t)) {
+        block_size = sizeof(dma_pool_block_t);
+    }
+    block_size = (block_size + DMA_POOL_BLOCK_ALIGN - 1) & ~(DMA_POOL_BLOCK_ALIGN - 1);
+
+    dma_pool_t* pool = calloc(1, sizeof(dma_pool_t));
+    if (pool == NULL) {
+        return ERR_NO_MEMORY;
+    }
+
+    mx_status_t status = io_buffer_init(&pool->buffer, block_size * block_count, flags);
+    if (status != NO_ERROR) {
+        printf("dma_pool: failed to allocate slab %d size: %zu\n", status,
+               block_size * block_count);
+        free(pool);
+        return status;
+    }
+
+    mtx_init(&pool->lock, mtx_plain);
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->free_count = block_count;
+    pool->low_water = block_count;
+
+    uintptr_t virt = (uintptr_t)io_buffer_virt(&pool->buffer);
+    for (size_t i = 0; i < block_count; i++) {
+        dma_pool_block_t* block = (dma_pool_block_t*)(virt + i * block_size);
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+
+    *out = pool;
+    return NO_ERROR;
+}
+
+mx_status_t dma_pool_alloc(dma_pool_t* pool, void** out_virt, mx_paddr_t* out_phys) {
+    mtx_lock(&pool->lock);
+    dma_pool_block_t* block = pool->free_list;
+    if (block == NULL) {
+        pool->alloc_failures++;
+        mtx_unlock(&pool->lock);
+        return ERR_SHOULD_WAIT;
+    }
+    pool->free_list = block->next;
+    pool->free_count--;
+    if (pool->free_count < pool->low_water) {
+        pool->low_water = pool->free_count;
+    }
+    mtx_unlock(&pool->lock);
+
+    *out_virt = block;
+    if (out_phys) {
+        *out_phys = dma_pool_phys(pool, block);
+    }
+    return NO_ERROR;
+}
+
+void dma_pool_free(dma_pool_t* pool, void* virt) {
+    uintptr_t offset = (uintptr_t)virt - (uintptr_t)io_buffer_virt(&pool->buffer);
+    MX_DEBUG_ASSERT(offset < pool->block_size * pool->block_count);
+    MX_DEBUG_ASSERT(offset % pool->block_size == 0);
+
+    dma_pool_block_t* block = virt;
+    mtx_lock(&pool->lock);
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->free_count++;
+    mtx_unlock(&pool->lock);
+}
+
+mx_paddr_t dma_pool_phys(dma_pool_t* pool, void* virt) {
+    uintptr_t offset = (uintptr_t)virt - (uintptr_t)io_buffer_virt(&pool->buffer);
+    MX_DEBUG_ASSERT(offset < pool->block_size * pool->block_count);
+    return io_buffer_phys(&pool->buffer) + offset;
+}
+
+mx_status_t dma_pool_cache_op(dma_pool_t* pool, uint32_t op, void* virt, size_t size) {
+    uintptr_t offset = (uintptr_t)virt - (uintptr_t)io_buffer_virt(&pool->buffer);
+    if (offset >= pool->block_size * pool->block_count || size > pool->block_size) {
+        return ERR_INVALID_ARGS;
+    }
+    return io_buffer_cache_op(&pool->buffer, op, offset, size);
+}
+
+void dma_pool_get_stats(dma_pool_t* pool, dma_pool_stats_t* out_stats) {
+    mtx_lock(&pool->lock);
+    out_stats->block_size = pool->block_size;
+    out_stats->block_count = pool->block_count;
+    out_stats->free_count = pool->free_count;
+    out_stats->low_water = pool->low_water;
+    out_stats->alloc_failures = pool->alloc_failures;
+    mtx_unlock(&pool->lock);
+}
+
+void dma_pool_destroy(dma_pool_t* pool) {
+    MX_DEBUG_ASSERT(pool->free_count == pool->block_count);
+    io_buffer_release(&pool->buffer);
+    free(pool);
+}
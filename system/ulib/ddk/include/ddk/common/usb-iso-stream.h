@@ -0,0 +1,59 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <ddk/device.h>
+#include <ddk/iotxn.h>
+#include <magenta/compiler.h>
+
+__BEGIN_CDECLS;
+
+// usb-iso-stream - circular schedule of pre-allocated isochronous transfers
+//
+// A stream owns a fixed ring of iotxns for one isochronous endpoint, allocated
+// once at creation time.  The driver refills free slots and queues them; the
+// stream recycles slots as the host controller completes them, so nothing is
+// allocated while streaming.  Instead of waking the driver for every completed
+// packet, the stream invokes its callback once per |batch_size| completions
+// (and whenever the ring drains completely), which is what keeps audio and
+// video refill threads off the CPU at high packet rates.
+
+typedef struct usb_iso_stream usb_iso_stream_t;
+
+// called on the HCI completion thread when |batch_size| packets have completed
+// since the last callback, or when the last in-flight packet completes.
+// the callback must not block; typically it signals the driver's refill thread.
+typedef void (*usb_iso_stream_cb_t)(usb_iso_stream_t* stream, void* cookie);
+
+// allocates a stream with |num_slots| transfers of |packet_size| bytes for the
+// isochronous endpoint |ep_address| on |device|.
+// |batch_size| must be nonzero and no greater than |num_slots|.
+mx_status_t usb_iso_stream_create(mx_device_t* device, uint8_t ep_address, size_t packet_size,
+                                  uint32_t num_slots, uint32_t batch_size,
+                                  usb_iso_stream_cb_t cb, void* cookie,
+                                  usb_iso_stream_t** out);
+
+// releases a stream and its transfers. transfers still in flight are released
+// as they complete.
+void usb_iso_stream_release(usb_iso_stream_t* stream);
+
+// returns a free slot for the driver to fill, or NULL if all slots are in
+// flight or awaiting usb_iso_stream_claim().
+iotxn_t* usb_iso_stream_next_slot(usb_iso_stream_t* stream);
+
+// queues a slot obtained from usb_iso_stream_next_slot() or
+// usb_iso_stream_claim().  txn->length must be set to the packet size to
+// transfer.  |frame| schedules the packet for a specific USB frame;
+// pass 0 to let the controller send it as soon as possible.
+void usb_iso_stream_queue(usb_iso_stream_t* stream, iotxn_t* txn, uint64_t frame);
+
+// returns the oldest completed IN packet (txn->actual bytes of data), or NULL
+// if none are pending.  the caller requeues it with usb_iso_stream_queue().
+iotxn_t* usb_iso_stream_claim(usb_iso_stream_t* stream);
+
+// number of slots currently free (not in flight and not awaiting claim)
+uint32_t usb_iso_stream_free_slots(usb_iso_stream_t* stream);
+
+__END_CDECLS;
@@ -0,0 +1,62 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <ddk/io-buffer.h>
+#include <magenta/compiler.h>
+#include <magenta/types.h>
+
+#include <stddef.h>
+
+__BEGIN_CDECLS;
+
+// A dma_pool hands out fixed-size DMA buffers carved from a single
+// contiguous slab that is reserved and mapped once at creation time.
+// Allocation and free are constant time (a locked free list pop/push) and
+// never touch the VM system, so they are safe to use on driver data paths
+// where a per-request mx_vmo_create_contiguous would fragment physical
+// memory and stall the transfer ring.
+//
+// Block sizes are rounded up to a cache line so adjacent blocks never share
+// one; on architectures without coherent DMA, use dma_pool_cache_op() to
+// clean blocks before device reads and invalidate them after device writes.
+typedef struct dma_pool dma_pool_t;
+
+typedef struct {
+    size_t block_size;      // size of each block after rounding
+    size_t block_count;     // total blocks in the pool
+    size_t free_count;      // blocks currently free
+    size_t low_water;       // lowest free_count ever observed
+    size_t alloc_failures;  // allocations that failed with the pool drained
+} dma_pool_stats_t;
+
+// Creates a pool of block_count blocks of block_size bytes each.
+// flags is IO_BUFFER_RO or IO_BUFFER_RW, as for io_buffer_init().
+mx_status_t dma_pool_create(size_t block_size, size_t block_count, uint32_t flags,
+                            dma_pool_t** out);
+
+// Allocates one block, returning its virtual and (optionally) physical
+// address. Returns ERR_SHOULD_WAIT if every block is outstanding; callers
+// should retry after freeing a block.
+mx_status_t dma_pool_alloc(dma_pool_t* pool, void** out_virt, mx_paddr_t* out_phys);
+
+// Returns a block obtained from dma_pool_alloc() to the pool.
+void dma_pool_free(dma_pool_t* pool, void* virt);
+
+// Returns the physical address of a block obtained from dma_pool_alloc().
+mx_paddr_t dma_pool_phys(dma_pool_t* pool, void* virt);
+
+// Performs a cache operation (MX_VMO_OP_CACHE_*) against size bytes of a
+// block obtained from dma_pool_alloc().
+mx_status_t dma_pool_cache_op(dma_pool_t* pool, uint32_t op, void* virt, size_t size);
+
+// Takes a snapshot of the pool's counters.
+void dma_pool_get_stats(dma_pool_t* pool, dma_pool_stats_t* out_stats);
+
+// Destroys the pool, unmapping and releasing the slab. All blocks must have
+// been freed first.
+void dma_pool_destroy(dma_pool_t* pool);
+
+__END_CDECLS;
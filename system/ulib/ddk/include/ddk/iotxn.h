@@ -219,4 +219,27 @@ void iotxn_phys_iter_init(iotxn_phys_iter_t* iter, iotxn_t* txn, size_t max_leng
 // return value is length, or zero if iteration is done.
 size_t iotxn_phys_iter_next(iotxn_phys_iter_t* iter, mx_paddr_t* out_paddr);
 
+// An iotxn pool preallocates a fixed number of iotxns whose buffers stay
+// committed, physically looked up, and mapped for the lifetime of the pool.
+// Acquiring and releasing pool iotxns in steady state performs no VM
+// operations, so drivers with a constant request size (eg block and usb
+// transfer rings) avoid the per-transaction map/unmap churn of iotxn_alloc().
+typedef struct iotxn_pool iotxn_pool_t;
+
+// create a pool of 'count' iotxns, each backed by a buffer of 'data_size'
+// bytes. 'alloc_flags' may include IOTXN_ALLOC_CONTIGUOUS. Buffers are
+// committed, their scatter-gather lists cached in 'phys'/'phys_count', and
+// their mappings cached in 'virt' before this returns.
+mx_status_t iotxn_pool_create(iotxn_pool_t** out, size_t count, uint64_t data_size,
+                              uint32_t alloc_flags);
+
+// take a free iotxn from the pool. returns ERR_SHOULD_WAIT if every iotxn in
+// the pool is currently in use. calling iotxn_release() on an acquired iotxn
+// returns it to its pool with buffer, mapping and scatter-gather list intact.
+mx_status_t iotxn_pool_acquire(iotxn_pool_t* pool, iotxn_t** out);
+
+// free the pool along with its iotxns and their buffers. all acquired iotxns
+// must have been released back to the pool before calling this.
+void iotxn_pool_free(iotxn_pool_t* pool);
+
 __END_CDECLS;
@@ -23,4 +23,8 @@ typedef struct block_ops {
     // Write from the VMO to the block device
     void (*write)(mx_device_t* dev, mx_handle_t vmo, uint64_t length, uint64_t vmo_offset,
                   uint64_t dev_offset, void* cookie);
+    // Flush the device's volatile write cache, making all previously
+    // completed writes durable. May be NULL if the device has no volatile
+    // cache; the caller then treats the flush as trivially complete.
+    void (*flush)(mx_device_t* dev, void* cookie);
 } block_ops_t;
@@ -21,15 +21,27 @@ __BEGIN_CDECLS;
 // interface (which is selectable independently for transmit and
 // receive)
 //
-// TODO: Implement zero-copy interface in the ethernet common
-// middle layer driver.  Currently ethermac drivers that request
-// these will not be loaded.
+// The ethernet common middle layer driver feeds client buffers
+// (at most two physical pages each) to macs that request the
+// zero-copy interface and returns them on complete_?x(), which
+// must be called in queue_?x() order.  Only one client may be
+// active at a time on such a mac.
 //
 // The FEATURE_WLAN flag indicates a device that supports wlan operations.
 
+// The FEATURE_?X_CSUM flags indicate that the device validates the
+// L4 checksum of received frames (reported per-frame via the
+// ETHMAC_RX_CSUM_OK recv()/complete_rx() flag) and computes the L4
+// checksum of transmitted frames.
+
 #define ETHMAC_FEATURE_RX_QUEUE (1u)
 #define ETHMAC_FEATURE_TX_QUEUE (2u)
 #define ETHMAC_FEATURE_WLAN     (4u)
+#define ETHMAC_FEATURE_RX_CSUM  (8u)
+#define ETHMAC_FEATURE_TX_CSUM  (16u)
+
+// flags for ifc->recv() and ifc->complete_rx()
+#define ETHMAC_RX_CSUM_OK (1u)  // hardware validated the L4 checksum
 
 typedef struct ethmac_info {
     uint32_t features;
@@ -485,6 +485,133 @@ mx_status_t iotxn_alloc_vmo(iotxn_t** out, uint32_t alloc_flags, mx_handle_t vmo
     return NO_ERROR;
 }
 
+// iotxn pools:
+
+typedef struct iotxn_pool_entry {
+    iotxn_t txn;
+    iotxn_pool_t* pool;
+} iotxn_pool_entry_t;
+
+struct iotxn_pool {
+    mtx_t lock;
+    list_node_t free_list;
+    size_t count;
+    iotxn_pool_entry_t entries[];
+};
+
+// return the iotxn into its pool's free list, keeping the buffer, mapping
+// and scatter-gather list for the next acquire
+static void iotxn_release_pool(iotxn_t* txn) {
+    iotxn_pool_entry_t* entry = containerof(txn, iotxn_pool_entry_t, txn);
+    iotxn_pool_t* pool = entry->pool;
+
+    mx_handle_t vmo_handle = txn->vmo_handle;
+    uint64_t vmo_length = txn->vmo_length;
+    void* virt = txn->virt;
+    mx_paddr_t* phys = txn->phys;
+    uint64_t phys_count = txn->phys_count;
+    uint32_t pflags = txn->pflags;
+
+    memset(txn, 0, sizeof(iotxn_t));
+    txn->vmo_handle = vmo_handle;
+    txn->vmo_length = vmo_length;
+    txn->virt = virt;
+    txn->phys = phys;
+    txn->phys_count = phys_count;
+    txn->pflags = pflags | IOTXN_PFLAG_FREE;
+    txn->release_cb = iotxn_release_pool;
+
+    mtx_lock(&pool->lock);
+    list_add_head(&pool->free_list, &txn->node);
+    mtx_unlock(&pool->lock);
+}
+
+mx_status_t iotxn_pool_create(iotxn_pool_t** out, size_t count, uint64_t data_size,
+                              uint32_t alloc_flags) {
+    if ((count == 0) || (data_size == 0)) {
+        return ERR_INVALID_ARGS;
+    }
+
+    iotxn_pool_t* pool = calloc(1, sizeof(iotxn_pool_t) + count * sizeof(iotxn_pool_entry_t));
+    if (pool == NULL) {
+        return ERR_NO_MEMORY;
+    }
+    mtx_init(&pool->lock, mtx_plain);
+    list_initialize(&pool->free_list);
+    pool->count = count;
+
+    mx_status_t status;
+    for (size_t i = 0; i < count; i++) {
+        iotxn_t* txn = &pool->entries[i].txn;
+        pool->entries[i].pool = pool;
+
+        if (alloc_flags & IOTXN_ALLOC_CONTIGUOUS) {
+            status = mx_vmo_create_contiguous(get_root_resource(), data_size, 0, &txn->vmo_handle);
+            txn->pflags |= IOTXN_PFLAG_CONTIGUOUS;
+        } else {
+            status = mx_vmo_create(data_size, 0, &txn->vmo_handle);
+        }
+        if (status != NO_ERROR) {
+            xprintf("iotxn_pool_create: error %d in mx_vmo_create, flags 0x%x\n",
+                    status, alloc_flags);
+            goto fail;
+        }
+        txn->vmo_offset = 0;
+        txn->vmo_length = data_size;
+        txn->pflags |= IOTXN_PFLAG_ALLOC;
+
+        // commit the pages and cache the scatter-gather list and mapping up
+        // front, so steady-state acquire/release issues no VM operations
+        if ((status = iotxn_physmap(txn)) != NO_ERROR) {
+            goto fail;
+        }
+        void* virt;
+        if ((status = iotxn_mmap(txn, &virt)) != NO_ERROR) {
+            goto fail;
+        }
+
+        txn->pflags |= IOTXN_PFLAG_FREE;
+        txn->release_cb = iotxn_release_pool;
+        list_add_tail(&pool->free_list, &txn->node);
+    }
+
+    *out = pool;
+    return NO_ERROR;
+
+fail:
+    iotxn_pool_free(pool);
+    return status;
+}
+
+mx_status_t iotxn_pool_acquire(iotxn_pool_t* pool, iotxn_t** out) {
+    mtx_lock(&pool->lock);
+    iotxn_t* txn = list_remove_head_type(&pool->free_list, iotxn_t, node);
+    mtx_unlock(&pool->lock);
+    if (txn == NULL) {
+        return ERR_SHOULD_WAIT;
+    }
+    txn->pflags &= ~IOTXN_PFLAG_FREE;
+    txn->length = txn->vmo_length;
+    *out = txn;
+    return NO_ERROR;
+}
+
+void iotxn_pool_free(iotxn_pool_t* pool) {
+    for (size_t i = 0; i < pool->count; i++) {
+        iotxn_t* txn = &pool->entries[i].txn;
+        if (txn->phys != NULL) {
+            free(txn->phys);
+        }
+        if (txn->virt != NULL) {
+            mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)txn->virt, txn->vmo_length);
+        }
+        if (txn->vmo_handle != MX_HANDLE_INVALID) {
+            mx_handle_close(txn->vmo_handle);
+        }
+    }
+    free(pool);
+}
+
 void iotxn_phys_iter_init(iotxn_phys_iter_t* iter, iotxn_t* txn, size_t max_length) {
     iter->txn = txn;
     iter->offset = 0;
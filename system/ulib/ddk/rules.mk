@@ -11,7 +11,9 @@ MODULE_TYPE := userlib
 MODULE_SRCS += \
     $(LOCAL_DIR)/common/hid-fifo.c \
     $(LOCAL_DIR)/common/usb.c \
+    $(LOCAL_DIR)/common/usb-iso-stream.c \
     $(LOCAL_DIR)/protocol/input.c \
+    $(LOCAL_DIR)/dma-pool.c \
     $(LOCAL_DIR)/io-buffer.c \
     $(LOCAL_DIR)/iotxn.c \
 
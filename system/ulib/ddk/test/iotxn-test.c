@@ -99,6 +99,40 @@ static bool test_physmap_unaligned_offset2(void) {
     END_TEST;
 }
 
+static bool test_pool(void) {
+    BEGIN_TEST;
+    iotxn_pool_t* pool;
+    ASSERT_EQ(iotxn_pool_create(&pool, 2, PAGE_SIZE * 3, 0), NO_ERROR, "");
+
+    // pool iotxns come with their mapping and scatter-gather list pre-cached
+    iotxn_t* txn;
+    ASSERT_EQ(iotxn_pool_acquire(pool, &txn), NO_ERROR, "");
+    ASSERT_NONNULL(txn, "");
+    ASSERT_NONNULL(txn->virt, "expected virt to be set");
+    ASSERT_NONNULL(txn->phys, "expected phys to be set");
+    ASSERT_EQ(txn->phys_count, 3u, "unexpected phys_count");
+    mx_paddr_t* phys = txn->phys;
+    void* virt = txn->virt;
+
+    // drain the pool
+    iotxn_t* txn2;
+    ASSERT_EQ(iotxn_pool_acquire(pool, &txn2), NO_ERROR, "");
+    iotxn_t* txn3;
+    ASSERT_EQ(iotxn_pool_acquire(pool, &txn3), ERR_SHOULD_WAIT,
+              "expected empty pool to fail acquire");
+
+    // releasing back to the pool preserves the cached buffer state
+    iotxn_release(txn);
+    ASSERT_EQ(iotxn_pool_acquire(pool, &txn3), NO_ERROR, "");
+    ASSERT_EQ(txn3->virt, virt, "expected same mapping after release");
+    ASSERT_EQ(txn3->phys, phys, "expected same phys list after release");
+
+    iotxn_release(txn2);
+    iotxn_release(txn3);
+    iotxn_pool_free(pool);
+    END_TEST;
+}
+
 static bool test_phys_iter(void) {
     BEGIN_TEST;
     iotxn_phys_iter_t iter;
@@ -209,6 +243,7 @@ RUN_TEST(test_physmap_clone)
 RUN_TEST(test_physmap_aligned_offset)
 RUN_TEST(test_physmap_unaligned_offset)
 RUN_TEST(test_physmap_unaligned_offset2)
+RUN_TEST(test_pool)
 RUN_TEST(test_phys_iter)
 END_TEST_CASE(iotxn_tests)
 
@@ -78,13 +78,33 @@ public:
     mx_handle_t h;
 };
 
-class WatcherContainer {
+class WatcherContainer : public mxtl::DoublyLinkedListable<WatcherContainer*> {
 public:
+    WatcherContainer();
+    ~WatcherContainer();
+
     virtual mx_status_t WatchDir(mx_handle_t* out) final;
     virtual void NotifyAdd(const char* name, size_t len) final;
+
+    // Deliver any batched events to the watchers. Called when a batch
+    // fills or ages out, and by the background flusher for batches which
+    // would otherwise linger.
+    void FlushPending();
 private:
+    // Batched events are packed in the watcher protocol's wire format
+    // and sent as a single channel message per watcher.
+    static constexpr size_t kMaxBatch = 1024;
+    // An event older than this is flushed as soon as another arrives;
+    // the background flusher covers the trailing batch of a burst.
+    static constexpr mx_time_t kMaxBatchAge = MX_MSEC(10);
+
+    void FlushLocked() __TA_REQUIRES(lock_);
+
     mxtl::Mutex lock_;
     mxtl::DoublyLinkedList<mxtl::unique_ptr<VnodeWatcher>> watch_list_ __TA_GUARDED(lock_);
+    uint8_t pending_[kMaxBatch] __TA_GUARDED(lock_);
+    size_t pending_len_ __TA_GUARDED(lock_);
+    mx_time_t batch_start_ __TA_GUARDED(lock_);
 };
 
 #endif // __Fuchsia__
@@ -185,6 +205,16 @@ public:
         return ERR_NOT_SUPPORTED;
     }
 
+    // Find the start of the next run of data (if |data| is true) or of
+    // unallocated "hole" blocks at or after |off|, following lseek
+    // SEEK_DATA/SEEK_HOLE semantics: the region at or past the end of
+    // the file counts as a hole, and a search starting there fails with
+    // ERR_OUT_OF_RANGE.  Filesystems without hole tracking leave this
+    // unimplemented; the RPC layer then treats the whole file as data.
+    virtual mx_status_t FindSparse(bool data, size_t off, size_t* out) {
+        return ERR_NOT_SUPPORTED;
+    }
+
     // Renames the path at oldname in olddir to the path at newname in newdir.
     // Called on the "olddir" vnode.
     // Unlinks any prior newname if it already exists.
@@ -215,6 +245,13 @@ public:
         return ERR_NOT_SUPPORTED;
     }
 
+    // Syncs at least the byte range [off, off + len) of the vnode with
+    // its underlying storage; len saturates at the end of the file.
+    // Filesystems which cannot sync a sub-range sync the whole vnode.
+    virtual mx_status_t SyncRange(size_t off, size_t len) {
+        return Sync();
+    }
+
     virtual ~Vnode() {};
 
 #ifdef __Fuchsia__
@@ -302,8 +339,6 @@ typedef struct vdircookie {
     void* p;
 } vdircookie_t;
 
-extern mxio_dispatcher_t* vfs_dispatcher;
-
 // Handle incoming mxrio messages, dispatching them to vnode operations.
 mx_status_t vfs_handler(mxrio_msg_t* msg, mx_handle_t rh, void* cookie);
 
@@ -315,3 +350,12 @@ mx_status_t vfs_unmount_handle(mx_handle_t h, mx_time_t deadline);
 mx_status_t vfs_uninstall_all(mx_time_t deadline);
 
 __END_CDECLS
+
+#ifdef __Fuchsia__
+namespace fs {
+class VfsDispatcher;
+}
+// Shared dispatcher pool serving vnodes that don't provide their own
+// (see Vnode::AddDispatcher). Created by vfs_rpc_server.
+extern fs::VfsDispatcher* vfs_dispatcher;
+#endif
@@ -24,9 +24,12 @@
 
 #define MXDEBUG 0
 
-// ** NOTE -- this prototype multithreaded dispatcher is only used by
-// ** minfs as part of ongoing multithread development. Not yet safe
-// ** for general consumption
+// Multithreaded dispatcher pool. A connection's port subscription is
+// re-armed only after its current batch of messages completes, so one
+// worker handles a given connection at a time (preserving op ordering)
+// while idle workers pick up whichever other connections become
+// readable. Handler callbacks must do their own locking; the VFS layer
+// currently serializes vnode operations behind vfs_big_lock.
 
 namespace fs {
 
@@ -29,3 +29,10 @@
 #ifndef __Fuchsia__
 #define O_NOREMOTE 0100000000
 #endif
+
+namespace fs {
+// Drop every dcache entry with the given name, whatever its parent
+// (vfs.cpp). Used when a directory entry appears without going through
+// Vfs::Open, e.g. devfs publishing a device node.
+void vfs_dcache_purge_name(const char* name, size_t len);
+}
@@ -9,6 +9,7 @@
 #include <sys/stat.h>
 #include <threads.h>
 
+#include <magenta/new.h>
 #include <magenta/process.h>
 #include <mxio/debug.h>
 #include <mxio/dispatcher.h>
@@ -19,6 +20,8 @@
 #include <mxtl/auto_lock.h>
 #include <mxtl/ref_ptr.h>
 
+#include <fs/vfs-dispatcher.h>
+
 #include "vfs-internal.h"
 
 #define MXDEBUG 0
@@ -113,6 +116,89 @@ done:
     vn->Serve(rh, open_flags);
 }
 
+// Sends up to len bytes of vn, starting at off, into the socket s.
+// When the vnode exposes its backing VMO the pages are mapped and fed
+// to the socket directly, so file data is copied exactly once; other
+// vnodes fall back to bounce-buffered reads, which still avoids the
+// round trip through the client.  Socket writes never block: a full
+// socket ends the transfer early and the client reissues the op once
+// the socket drains.
+ssize_t vfs_transmit(const mxtl::RefPtr<Vnode>& vn, mx_handle_t s,
+                     uint64_t off, uint64_t len) {
+    vnattr_t attr;
+    mx_status_t r;
+    if ((r = vn->Getattr(&attr)) < 0) {
+        return r;
+    }
+    if (off >= attr.size) {
+        return 0;
+    }
+    if (len > attr.size - off) {
+        len = attr.size - off;
+    }
+
+    size_t vmo_off = 0;
+    mx_handle_t vmo;
+    if (vn->Mmap(MXIO_MMAP_FLAG_READ, off + len, &vmo_off, &vmo) == NO_ERROR) {
+        // Map only the window being sent; off need not be page aligned
+        uint64_t map_off = (off + vmo_off) & ~(uint64_t)(PAGE_SIZE - 1);
+        uint64_t skip = (off + vmo_off) - map_off;
+        size_t map_len = static_cast<size_t>(skip + len);
+        uintptr_t addr;
+        r = mx_vmar_map(mx_vmar_root_self(), 0, vmo, map_off, map_len,
+                        MX_VM_FLAG_PERM_READ, &addr);
+        if (r == NO_ERROR) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(addr) + skip;
+            uint64_t sent = 0;
+            while (sent < len) {
+                size_t actual;
+                if ((r = mx_socket_write(s, 0, p + sent, len - sent,
+                                         &actual)) != NO_ERROR) {
+                    break;
+                }
+                sent += actual;
+            }
+            mx_vmar_unmap(mx_vmar_root_self(), addr, map_len);
+            mx_handle_close(vmo);
+            if (sent == 0 && r < 0) {
+                return r;
+            }
+            return static_cast<ssize_t>(sent);
+        }
+        mx_handle_close(vmo);
+    }
+
+    uint8_t buf[MXIO_CHUNK_SIZE];
+    uint64_t sent = 0;
+    while (sent < len) {
+        size_t xfer = (len - sent > sizeof(buf)) ? sizeof(buf) : len - sent;
+        ssize_t nread = vn->Read(buf, xfer, off + sent);
+        if (nread < 0) {
+            return (sent == 0) ? nread : static_cast<ssize_t>(sent);
+        } else if (nread == 0) {
+            break;
+        }
+        size_t done = 0;
+        while (done < static_cast<size_t>(nread)) {
+            size_t actual;
+            if ((r = mx_socket_write(s, 0, buf + done, nread - done,
+                                     &actual)) != NO_ERROR) {
+                break;
+            }
+            done += actual;
+        }
+        sent += done;
+        if (done < static_cast<size_t>(nread)) {
+            // socket is full; the unsent tail will be re-read on retry
+            if (sent == 0 && r < 0) {
+                return r;
+            }
+            break;
+        }
+    }
+    return static_cast<ssize_t>(sent);
+}
+
 // Consumes rh.
 void mxrio_reply_channel_status(mx_handle_t rh, mx_status_t status) {
     struct {
@@ -315,6 +401,26 @@ mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mx_handle_t rh, mxtl::RefPtr<Vnode>
                 }
             }
             break;
+        case SEEK_DATA:
+        case SEEK_HOLE: {
+            if (msg->arg2.off < 0) {
+                return ERR_INVALID_ARGS;
+            }
+            size_t target = static_cast<size_t>(msg->arg2.off);
+            size_t found;
+            if ((r = vn->FindSparse(arg == SEEK_DATA, target, &found)) == ERR_NOT_SUPPORTED) {
+                // without filesystem hole tracking the file is one run
+                // of data followed by the implicit hole at EOF
+                if (target >= attr.size) {
+                    return ERR_OUT_OF_RANGE;
+                }
+                found = (arg == SEEK_DATA) ? target : attr.size;
+            } else if (r < 0) {
+                return r;
+            }
+            n = found;
+            break;
+        }
         default:
             return ERR_INVALID_ARGS;
         }
@@ -494,9 +600,32 @@ mx_status_t vfs_handler_vn(mxrio_msg_t* msg, mx_handle_t rh, mxtl::RefPtr<Vnode>
         }
         return status;
     }
+    case MXRIO_TRANSMIT: {
+        // The socket handle is consumed regardless of outcome.
+        auto ac = mxtl::MakeAutoCall([&msg]() { mx_handle_close(msg->handle[0]); });
+
+        if (len != sizeof(mxrio_transmit_data_t)) {
+            return ERR_INVALID_ARGS;
+        }
+        mxrio_transmit_data_t* data = reinterpret_cast<mxrio_transmit_data_t*>(msg->data);
+        ssize_t r = fs::vfs_transmit(vn, msg->handle[0], data->offset, data->length);
+        if (r < 0) {
+            return static_cast<mx_status_t>(r);
+        }
+        data->length = static_cast<uint64_t>(r);
+        msg->datalen = sizeof(mxrio_transmit_data_t);
+        return msg->datalen;
+    }
     case MXRIO_SYNC: {
         return vn->Sync();
     }
+    case MXRIO_SYNC_RANGE: {
+        if (len != sizeof(mxrio_sync_range_data_t)) {
+            return ERR_INVALID_ARGS;
+        }
+        mxrio_sync_range_data_t* data = reinterpret_cast<mxrio_sync_range_data_t*>(msg->data);
+        return vn->SyncRange(data->offset, data->length);
+    }
     case MXRIO_UNLINK:
         return fs::Vfs::Unlink(mxtl::move(vn), (const char*)msg->data, len);
     default:
@@ -521,6 +650,12 @@ mx_status_t vfs_handler(mxrio_msg_t* msg, mx_handle_t rh, void* cookie) {
     return status;
 }
 
+// Worker pool size for the shared dispatcher. Each connection is
+// pinned to one worker at a time (its port subscription is re-armed
+// only after its batch completes), so per-connection op ordering is
+// preserved while idle workers pick up whichever connections are ready.
+static const unsigned kVfsPoolSize = 4;
+
 mx_handle_t vfs_rpc_server(mx_handle_t h, mxtl::RefPtr<Vnode> vn) {
     vfs_iostate_t* ios;
     mx_status_t r;
@@ -530,9 +665,24 @@ mx_handle_t vfs_rpc_server(mx_handle_t h, mxtl::RefPtr<Vnode> vn) {
     ios->vn = mxtl::move(vn);  // reference passed in by caller
     ios->io_flags = 0;
 
-    if ((r = mxio_dispatcher_create(&vfs_dispatcher, mxrio_handler)) < 0) {
-        free(ios);
-        return r;
+    if (vfs_dispatcher == nullptr) {
+        AllocChecker ac;
+        fs::VfsDispatcher* dispatcher = new (&ac) fs::VfsDispatcher();
+        if (!ac.check()) {
+            free(ios);
+            return ERR_NO_MEMORY;
+        }
+        if ((r = dispatcher->Create(mxrio_handler, kVfsPoolSize)) != NO_ERROR) {
+            delete dispatcher;
+            free(ios);
+            return r;
+        }
+        if ((r = dispatcher->Start("vfs-dispatcher")) != NO_ERROR) {
+            delete dispatcher;
+            free(ios);
+            return r;
+        }
+        vfs_dispatcher = dispatcher;
     }
 
     // Tell the calling process that we've mounted
@@ -541,12 +691,12 @@ mx_handle_t vfs_rpc_server(mx_handle_t h, mxtl::RefPtr<Vnode> vn) {
         return r;
     }
 
-    if ((r = mxio_dispatcher_add(vfs_dispatcher, h, (void*) vfs_handler, ios)) < 0) {
+    if ((r = vfs_dispatcher->Add(h, (void*) vfs_handler, ios)) < 0) {
         free(ios);
         return r;
     }
 
-    // calling thread blocks
-    mxio_dispatcher_run(vfs_dispatcher);
+    // calling thread joins the worker pool
+    vfs_dispatcher->Loop();
     return NO_ERROR;
 }
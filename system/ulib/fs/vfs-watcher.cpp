@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 
 #ifdef __Fuchsia__
@@ -14,8 +15,11 @@
 #endif
 
 #include <fs/vfs.h>
+#include <magenta/device/vfs.h>
 #include <magenta/new.h>
 
+#include "vfs-internal.h"
+
 namespace fs {
 
 VnodeWatcher::VnodeWatcher() : h(MX_HANDLE_INVALID) {}
@@ -26,6 +30,52 @@ VnodeWatcher::~VnodeWatcher() {
     }
 }
 
+// Containers with a batch of undelivered events are queued here; a single
+// background thread flushes batches which would otherwise linger after a
+// burst ends. The flusher holds watch_flush_lock across FlushPending, so
+// a container on the list cannot be destroyed mid-flush.
+static mxtl::Mutex watch_flush_lock;
+static mxtl::DoublyLinkedList<WatcherContainer*> watch_flush_list
+        __TA_GUARDED(watch_flush_lock);
+static bool watch_flush_thread_running __TA_GUARDED(watch_flush_lock);
+
+static int watch_flush_thread(void* arg) {
+    for (;;) {
+        mx_nanosleep(mx_deadline_after(MX_MSEC(10)));
+        mxtl::AutoLock lock(&watch_flush_lock);
+        WatcherContainer* container;
+        while ((container = watch_flush_list.pop_front()) != nullptr) {
+            container->FlushPending();
+        }
+    }
+    return 0;
+}
+
+static void watch_flush_schedule(WatcherContainer* container) {
+    mxtl::AutoLock lock(&watch_flush_lock);
+    if (!container->InContainer()) {
+        watch_flush_list.push_back(container);
+    }
+    if (!watch_flush_thread_running) {
+        thrd_t t;
+        if (thrd_create(&t, watch_flush_thread, nullptr) == thrd_success) {
+            thrd_detach(t);
+            watch_flush_thread_running = true;
+        }
+    }
+}
+
+WatcherContainer::WatcherContainer() : pending_len_(0), batch_start_(0) {}
+
+WatcherContainer::~WatcherContainer() {
+    // Serialize against the flusher, which calls FlushPending with
+    // watch_flush_lock held.
+    mxtl::AutoLock lock(&watch_flush_lock);
+    if (InContainer()) {
+        watch_flush_list.erase(*this);
+    }
+}
+
 mx_status_t WatcherContainer::WatchDir(mx_handle_t* out) {
     AllocChecker ac;
     mxtl::unique_ptr<VnodeWatcher> watcher(new (&ac) VnodeWatcher);
@@ -40,11 +90,13 @@ mx_status_t WatcherContainer::WatchDir(mx_handle_t* out) {
     return NO_ERROR;
 }
 
-void WatcherContainer::NotifyAdd(const char* name, size_t len) {
-    mxtl::AutoLock lock(&lock_);
+void WatcherContainer::FlushLocked() {
+    if (pending_len_ == 0) {
+        return;
+    }
     for (auto it = watch_list_.begin(); it != watch_list_.end();) {
-        mx_status_t status = mx_channel_write(it->h, 0, name,
-                                              static_cast<uint32_t>(len),
+        mx_status_t status = mx_channel_write(it->h, 0, pending_,
+                                              static_cast<uint32_t>(pending_len_),
                                               nullptr, 0);
         if (status < 0) {
             // Lazily remove watchers when their handles cannot accept incoming
@@ -56,6 +108,63 @@ void WatcherContainer::NotifyAdd(const char* name, size_t len) {
             ++it;
         }
     }
+    pending_len_ = 0;
+}
+
+void WatcherContainer::FlushPending() {
+    mxtl::AutoLock lock(&lock_);
+    FlushLocked();
+}
+
+void WatcherContainer::NotifyAdd(const char* name, size_t len) {
+    // a new entry invalidates any cached negative lookups for its name
+    vfs_dcache_purge_name(name, len);
+
+    if ((len == 0) || (len > UINT8_MAX)) {
+        return;
+    }
+
+    bool schedule = false;
+    {
+        mxtl::AutoLock lock(&lock_);
+        if (watch_list_.is_empty()) {
+            return;
+        }
+        // Batch events rather than waking every watcher per event: bulk
+        // operations (builds, unpacking) generate storms of additions, and
+        // one message carrying the whole burst is far cheaper to deliver
+        // and to drain than a message per entry.
+        //
+        // a duplicate name merges into its pending event
+        size_t off = 0;
+        while (off < pending_len_) {
+            uint8_t nlen = pending_[off + 1];
+            if ((nlen == len) && (memcmp(&pending_[off + 2], name, len) == 0)) {
+                pending_[off] |= VFS_WATCH_EVT_ADDED;
+                return;
+            }
+            off += 2u + nlen;
+        }
+        if (pending_len_ + 2 + len > sizeof(pending_)) {
+            FlushLocked();
+        }
+        if (pending_len_ == 0) {
+            batch_start_ = mx_time_get(MX_CLOCK_MONOTONIC);
+            schedule = true;
+        }
+        pending_[pending_len_++] = VFS_WATCH_EVT_ADDED;
+        pending_[pending_len_++] = static_cast<uint8_t>(len);
+        memcpy(&pending_[pending_len_], name, len);
+        pending_len_ += len;
+        // bound the latency of a sustained storm; the background flusher
+        // only covers batches which stop growing
+        if (mx_time_get(MX_CLOCK_MONOTONIC) - batch_start_ >= kMaxBatchAge) {
+            FlushLocked();
+        }
+    }
+    if (schedule) {
+        watch_flush_schedule(this);
+    }
 }
 
 } // namespace fs
@@ -3,19 +3,24 @@
 // found in the LICENSE file.
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <magenta/new.h>
 #include <mxio/dispatcher.h>
 #include <mxio/remoteio.h>
 #include <mxtl/auto_call.h>
+#include <mxtl/intrusive_double_list.h>
+#include <mxtl/ref_ptr.h>
 
 #ifdef __Fuchsia__
 #include <threads.h>
 #include <magenta/assert.h>
 #include <magenta/syscalls.h>
 #include <mxtl/auto_lock.h>
+#include <fs/vfs-dispatcher.h>
 #endif
 
 #include "vfs-internal.h"
@@ -24,8 +29,8 @@ uint32_t __trace_bits;
 
 #ifdef __Fuchsia__
 mtx_t vfs_lock = MTX_INIT;
+fs::VfsDispatcher* vfs_dispatcher;
 #endif
-mxio_dispatcher_t* vfs_dispatcher;
 
 namespace fs {
 namespace {
@@ -51,8 +56,173 @@ mx_status_t vfs_name_trim(const char* name, size_t len, size_t* len_out, bool* d
     return NO_ERROR;
 }
 
+// Directory entry cache. Maps (parent vnode, name) to the vnode that
+// Lookup returned, or to a negative entry recording that the name did
+// not exist, so hot path walks become hash probes instead of
+// filesystem directory scans. Entries are purged by the Vfs mutation
+// entry points (create, unlink, link, rename) and, by name, from the
+// directory watcher notification hook, which covers entries published
+// outside Vfs::Open such as devfs device nodes. The cache has its own
+// leaf lock rather than relying on vfs_lock because those notify hooks
+// run on threads that don't hold it.
+constexpr size_t kDcacheBuckets = 64;
+constexpr size_t kDcacheMaxEntries = 256;
+
+#ifdef __Fuchsia__
+mtx_t dcache_lock = MTX_INIT;
+#define DCACHE_LOCK() mtx_lock(&dcache_lock)
+#define DCACHE_UNLOCK() mtx_unlock(&dcache_lock)
+#else
+#define DCACHE_LOCK() ((void)0)
+#define DCACHE_UNLOCK() ((void)0)
+#endif
+
+struct DcacheEntry : public mxtl::DoublyLinkedListable<DcacheEntry*> {
+    DcacheEntry* hash_next = nullptr;
+    mxtl::RefPtr<Vnode> parent;
+    mxtl::RefPtr<Vnode> vn; // null for a negative entry
+    size_t namelen = 0;
+    char name[NAME_MAX + 1];
+};
+
+DcacheEntry* dcache_buckets[kDcacheBuckets];
+mxtl::DoublyLinkedList<DcacheEntry*> dcache_lru; // most recent at front
+size_t dcache_count;
+
+size_t dcache_hash(const Vnode* parent, const char* name, size_t len) {
+    size_t h = ((uintptr_t)parent) / sizeof(void*);
+    for (size_t i = 0; i < len; i++) {
+        h = (h * 31) + name[i];
+    }
+    return h % kDcacheBuckets;
+}
+
+// "." and ".." resolve to vnodes we already hold; no point caching them
+bool dcache_cacheable_name(const char* name, size_t len) {
+    if ((len == 0) || (len > NAME_MAX)) {
+        return false;
+    }
+    if ((name[0] == '.') && ((len == 1) || ((len == 2) && (name[1] == '.')))) {
+        return false;
+    }
+    return true;
+}
+
+DcacheEntry* dcache_find(const Vnode* parent, const char* name, size_t len) {
+    size_t h = dcache_hash(parent, name, len);
+    for (DcacheEntry* e = dcache_buckets[h]; e != nullptr; e = e->hash_next) {
+        if ((e->parent.get() == parent) && (e->namelen == len) &&
+            !memcmp(e->name, name, len)) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+void dcache_remove(DcacheEntry* e) {
+    size_t h = dcache_hash(e->parent.get(), e->name, e->namelen);
+    DcacheEntry** prev = &dcache_buckets[h];
+    while (*prev != e) {
+        prev = &(*prev)->hash_next;
+    }
+    *prev = e->hash_next;
+    dcache_lru.erase(*e);
+    dcache_count--;
+    delete e;
+}
+
+// Returns true on a hit; *out is the cached vnode, or null when the
+// cache remembers that the name does not exist.
+bool dcache_lookup(const Vnode* parent, const char* name, size_t len,
+                   mxtl::RefPtr<Vnode>* out) {
+    if (!dcache_cacheable_name(name, len)) {
+        return false;
+    }
+    DCACHE_LOCK();
+    DcacheEntry* e = dcache_find(parent, name, len);
+    if (e == nullptr) {
+        DCACHE_UNLOCK();
+        return false;
+    }
+    dcache_lru.erase(*e);
+    dcache_lru.push_front(e);
+    *out = e->vn;
+    DCACHE_UNLOCK();
+    return true;
+}
+
+// vn may be null to record a negative entry.
+void dcache_insert(const mxtl::RefPtr<Vnode>& parent, const char* name,
+                   size_t len, const mxtl::RefPtr<Vnode>& vn) {
+    if (!dcache_cacheable_name(name, len)) {
+        return;
+    }
+    if ((vn != nullptr) && (vn->IsRemote() || vn->IsDevice())) {
+        // mount points and devices come and go outside our view
+        return;
+    }
+    AllocChecker ac;
+    DcacheEntry* fresh = new (&ac) DcacheEntry();
+    if (!ac.check()) {
+        return;
+    }
+    DCACHE_LOCK();
+    DcacheEntry* e = dcache_find(parent.get(), name, len);
+    if (e != nullptr) {
+        e->vn = vn;
+        dcache_lru.erase(*e);
+        dcache_lru.push_front(e);
+        DCACHE_UNLOCK();
+        delete fresh;
+        return;
+    }
+    if (dcache_count == kDcacheMaxEntries) {
+        dcache_remove(&dcache_lru.back());
+    }
+    e = fresh;
+    e->parent = parent;
+    e->vn = vn;
+    e->namelen = len;
+    memcpy(e->name, name, len);
+    e->name[len] = 0;
+    size_t h = dcache_hash(parent.get(), name, len);
+    e->hash_next = dcache_buckets[h];
+    dcache_buckets[h] = e;
+    dcache_lru.push_front(e);
+    dcache_count++;
+    DCACHE_UNLOCK();
+}
+
+void dcache_purge(const Vnode* parent, const char* name, size_t len) {
+    DCACHE_LOCK();
+    DcacheEntry* e = dcache_find(parent, name, len);
+    if (e != nullptr) {
+        dcache_remove(e);
+    }
+    DCACHE_UNLOCK();
+}
+
 } // namespace anonymous
 
+// Drop every dcache entry with the given name, whatever its parent.
+// Hooked into WatcherContainer::NotifyAdd so that entries published
+// without going through Vfs::Open (devfs, svcfs) invalidate any cached
+// negative lookups for their name.
+void vfs_dcache_purge_name(const char* name, size_t len) {
+    DCACHE_LOCK();
+    for (size_t h = 0; h < kDcacheBuckets; h++) {
+        DcacheEntry* e = dcache_buckets[h];
+        while (e != nullptr) {
+            DcacheEntry* next = e->hash_next;
+            if ((e->namelen == len) && !memcmp(e->name, name, len)) {
+                dcache_remove(e);
+            }
+            e = next;
+        }
+    }
+    DCACHE_UNLOCK();
+}
+
 bool RemoteContainer::IsRemote() const {
     return remote_ > 0;
 }
@@ -132,12 +302,24 @@ mx_status_t Vfs::Open(mxtl::RefPtr<Vnode> vndir, mxtl::RefPtr<Vnode>* out, const
             }
             return r;
         }
+        dcache_purge(vndir.get(), path, len);
         vndir->NotifyAdd(path, len);
     } else {
     try_open:
-        r = vndir->Lookup(&vn, path, len);
-        if (r < 0) {
-            return r;
+        if (dcache_lookup(vndir.get(), path, len, &vn)) {
+            if (vn == nullptr) {
+                // cached negative entry
+                return ERR_NOT_FOUND;
+            }
+        } else {
+            r = vndir->Lookup(&vn, path, len);
+            if (r == ERR_NOT_FOUND) {
+                dcache_insert(vndir, path, len, nullptr);
+            }
+            if (r < 0) {
+                return r;
+            }
+            dcache_insert(vndir, path, len, vn);
         }
         if (!(flags & O_NOREMOTE) && vn->IsRemote() && !vn->IsDevice()) {
             // Opening a mount point: Traverse across remote.
@@ -174,6 +356,7 @@ mx_status_t Vfs::Unlink(mxtl::RefPtr<Vnode> vndir, const char* path, size_t len)
     if ((r = vfs_name_trim(path, len, &len, &must_be_dir)) != NO_ERROR) {
         return r;
     }
+    dcache_purge(vndir.get(), path, len);
     return vndir->Unlink(path, len, must_be_dir);
 }
 
@@ -206,6 +389,7 @@ mx_status_t Vfs::Link(mxtl::RefPtr<Vnode> oldparent, mxtl::RefPtr<Vnode> newpare
     if (r != NO_ERROR) {
         return r;
     }
+    dcache_purge(newparent.get(), newname, newlen);
     newparent->NotifyAdd(newname, newlen);
     return NO_ERROR;
 }
@@ -229,6 +413,8 @@ mx_status_t Vfs::Rename(mxtl::RefPtr<Vnode> oldparent, mxtl::RefPtr<Vnode> newpa
     if (r != NO_ERROR) {
         return r;
     }
+    dcache_purge(oldparent.get(), oldname, oldlen);
+    dcache_purge(newparent.get(), newname, newlen);
     newparent->NotifyAdd(newname, newlen);
     return NO_ERROR;
 }
@@ -332,9 +518,8 @@ mx_status_t Vfs::Close(mxtl::RefPtr<Vnode> vn) {
 
 #ifdef __Fuchsia__
 mx_status_t Vnode::AddDispatcher(mx_handle_t h, vfs_iostate_t* cookie) {
-    // default implementation adds this object to the mxio single
-    // threaded dispatcher
-    return mxio_dispatcher_add(vfs_dispatcher, h, (void*)vfs_handler, cookie);
+    // default implementation adds this object to the shared worker pool
+    return vfs_dispatcher->Add(h, (void*)vfs_handler, cookie);
 }
 #endif
 
@@ -401,11 +586,24 @@ mx_status_t Vfs::Walk(mxtl::RefPtr<Vnode> vn, mxtl::RefPtr<Vnode>* out,
             // traverse to the next segment
             size_t len = nextpath - path;
             nextpath++;
-            r = vn->Lookup(&vn, path, len);
-            assert(r <= 0);
-            if (r < 0) {
-                return r;
+            mxtl::RefPtr<Vnode> next;
+            if (dcache_lookup(vn.get(), path, len, &next)) {
+                if (next == nullptr) {
+                    // cached negative entry
+                    return ERR_NOT_FOUND;
+                }
+            } else {
+                r = vn->Lookup(&next, path, len);
+                assert(r <= 0);
+                if (r == ERR_NOT_FOUND) {
+                    dcache_insert(vn, path, len, nullptr);
+                }
+                if (r < 0) {
+                    return r;
+                }
+                dcache_insert(vn, path, len, next);
             }
+            vn = mxtl::move(next);
             path = nextpath;
         } else {
             // final path segment, we're done here
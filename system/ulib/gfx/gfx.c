@@ -76,6 +76,25 @@ static uint32_t ARGB8888_to_RGB2220(uint32_t in) {
     return out;
 }
 
+// accumulate a modified rectangle into the surface's dirty bounding box
+static void mark_dirty(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height) {
+    if (surface->dirty_y0 >= surface->dirty_y1) {
+        surface->dirty_x0 = x;
+        surface->dirty_y0 = y;
+        surface->dirty_x1 = x + width;
+        surface->dirty_y1 = y + height;
+        return;
+    }
+    if (x < surface->dirty_x0)
+        surface->dirty_x0 = x;
+    if (y < surface->dirty_y0)
+        surface->dirty_y0 = y;
+    if (x + width > surface->dirty_x1)
+        surface->dirty_x1 = x + width;
+    if (y + height > surface->dirty_y1)
+        surface->dirty_y1 = y + height;
+}
+
 /**
  * @brief  Copy a rectangle of pixels from one part of the display to another.
  */
@@ -104,6 +123,7 @@ void gfx_copyrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width,
     if (y2 + height > surface->height)
         height = surface->height - y2;
 
+    mark_dirty(surface, x2, y2, width, height);
     surface->copyrect(surface, x, y, width, height, x2, y2);
 }
 
@@ -117,6 +137,7 @@ void gfx_copylines(gfx_surface* dst, gfx_surface* src, unsigned srcy, unsigned d
     if ((dsty >= dst->height) || (dst->height - dsty) < height) {
         return;
     }
+    mark_dirty(dst, 0, dsty, dst->width, height);
     memcpy(dst->ptr + dsty * dst->stride * dst->pixelsize,
            src->ptr + srcy * src->stride * src->pixelsize,
            height * src->stride * src->pixelsize);
@@ -143,6 +164,7 @@ void gfx_fillrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width,
     if (y + height > surface->height)
         height = surface->height - y;
 
+    mark_dirty(surface, x, y, width, height);
     surface->fillrect(surface, x, y, width, height, color);
 }
 
@@ -155,6 +177,7 @@ void gfx_putpixel(gfx_surface* surface, unsigned x, unsigned y, unsigned color)
     if (y >= surface->height)
         return;
 
+    mark_dirty(surface, x, y, 1, 1);
     surface->putpixel(surface, x, y, color);
 }
 
@@ -211,157 +234,74 @@ void gfx_putchar(gfx_surface* surface, const gfx_font* font, unsigned ch, unsign
         fg = surface->translate_color(fg);
         bg = surface->translate_color(bg);
     }
+    mark_dirty(surface, x, y, font->width, font->height);
     surface->putchar(surface, font, ch, x, y, fg, bg);
 }
 
-static void copyrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint8_t* src = &((const uint8_t*)surface->ptr)[x + y * surface->stride];
-    uint8_t* dest = &((uint8_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+// copy a rectangle a row at a time with memmove, so overlapping source and
+// destination (scrolling) are safe and the copies run at memcpy speed
+static void copyrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
+    const unsigned ps = surface->pixelsize;
+    const size_t rowbytes = (size_t)width * ps;
+    const size_t stridebytes = (size_t)surface->stride * ps;
+    const uint8_t* src = (const uint8_t*)surface->ptr + x * ps + y * stridebytes;
+    uint8_t* dest = (uint8_t*)surface->ptr + x2 * ps + y2 * stridebytes;
+
+    if (dest <= src) {
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest += stridebytes;
+            src += stridebytes;
         }
     } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        // copy bottom up so overlapping rows are read before they are written
+        src += (size_t)(height - 1) * stridebytes;
+        dest += (size_t)(height - 1) * stridebytes;
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, rowbytes);
+            dest -= stridebytes;
+            src -= stridebytes;
         }
     }
 }
 
 static void fillrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint8_t* dest = &((uint8_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint8_t color8 = (uint8_t)(surface->translate_color(color));
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color8;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint16_t* src = &((const uint16_t*)surface->ptr)[x + y * surface->stride];
-    uint16_t* dest = &((uint16_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    for (unsigned i = 0; i < height; i++) {
+        memset(dest, color8, width);
+        dest += surface->stride;
     }
 }
 
+// fill the first row a pixel at a time, then replicate it with memcpy
 static void fillrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint16_t* dest = &((uint16_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint16_t color16 = (uint16_t)(surface->translate_color(color));
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color16;
-            dest++;
-        }
-        dest += stride_diff;
+    for (unsigned j = 0; j < width; j++) {
+        dest[j] = color16;
     }
-}
-
-static void copyrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint32_t* src = &((const uint32_t*)surface->ptr)[x + y * surface->stride];
-    uint32_t* dest = &((uint32_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    uint16_t* row = dest + surface->stride;
+    for (unsigned i = 1; i < height; i++) {
+        memcpy(row, dest, width * sizeof(uint16_t));
+        row += surface->stride;
     }
 }
 
 static void fillrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint32_t* dest = &((uint32_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    for (unsigned j = 0; j < width; j++) {
+        dest[j] = color;
+    }
+    uint32_t* row = dest + surface->stride;
+    for (unsigned i = 1; i < height; i++) {
+        memcpy(row, dest, width * sizeof(uint32_t));
+        row += surface->stride;
     }
 }
 
@@ -489,25 +429,18 @@ void gfx_blend(gfx_surface* target, gfx_surface* source, unsigned srcx, unsigned
     if (srcy + height > source->height)
         height = source->height - srcy;
 
+    mark_dirty(target, destx, desty, width, height);
+
     // XXX total hack to deal with various blends
     if (source->format == MX_PIXEL_FORMAT_RGB_565 && target->format == MX_PIXEL_FORMAT_RGB_565) {
         // 16 bit to 16 bit
         const uint16_t* src = &((const uint16_t*)source->ptr)[srcx + srcy * source->stride];
         uint16_t* dest = &((uint16_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
-
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
 
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (unsigned i = 0; i < height; i++) {
+            memcpy(dest, src, width * sizeof(uint16_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == MX_PIXEL_FORMAT_ARGB_8888 && target->format == MX_PIXEL_FORMAT_ARGB_8888) {
         // both are 32 bit modes, both alpha
@@ -533,39 +466,21 @@ void gfx_blend(gfx_surface* target, gfx_surface* source, unsigned srcx, unsigned
         // both are 32 bit modes, no alpha
         const uint32_t* src = &((const uint32_t*)source->ptr)[srcx + srcy * source->stride];
         uint32_t* dest = &((uint32_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
-
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
 
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (unsigned i = 0; i < height; i++) {
+            memcpy(dest, src, width * sizeof(uint32_t));
+            dest += target->stride;
+            src += source->stride;
         }
     } else if (source->format == MX_PIXEL_FORMAT_MONO_1 && target->format == MX_PIXEL_FORMAT_MONO_1) {
         // both are 8 bit modes, no alpha
         const uint8_t* src = &((const uint8_t*)source->ptr)[srcx + srcy * source->stride];
         uint8_t* dest = &((uint8_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
 
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (unsigned i = 0; i < height; i++) {
+            memcpy(dest, src, width);
+            dest += target->stride;
+            src += source->stride;
         }
     } else {
         xprintf("gfx_surface_blend: unimplemented colorspace combination (source %d target %d)\n", source->format, target->format);
@@ -584,6 +499,9 @@ void gfx_flush(gfx_surface* surface) {
 
     if (surface->flush)
         surface->flush(0, surface->height - 1);
+
+    surface->dirty_x0 = surface->dirty_y0 = 0;
+    surface->dirty_x1 = surface->dirty_y1 = 0;
 }
 
 /**
@@ -612,6 +530,19 @@ void gfx_flush_rows(struct gfx_surface* surface, unsigned start, unsigned end) {
         surface->flush(start, end);
 }
 
+/**
+ * @brief  Flush only the rows modified since the last flush.
+ */
+void gfx_flush_dirty(struct gfx_surface* surface) {
+    if (surface->dirty_y0 >= surface->dirty_y1)
+        return;
+
+    gfx_flush_rows(surface, surface->dirty_y0, surface->dirty_y1 - 1);
+
+    surface->dirty_x0 = surface->dirty_y0 = 0;
+    surface->dirty_x1 = surface->dirty_y1 = 0;
+}
+
 /**
  * @brief  Create a new graphics surface object
  */
@@ -639,12 +570,14 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     surface->height = height;
     surface->stride = stride;
     surface->alpha = MAX_ALPHA;
+    surface->dirty_x0 = surface->dirty_y0 = 0;
+    surface->dirty_x1 = surface->dirty_y1 = 0;
 
     // set up some function pointers
     switch (format) {
     case MX_PIXEL_FORMAT_RGB_565:
         surface->translate_color = &ARGB8888_to_RGB565;
-        surface->copyrect = &copyrect16;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect16;
         surface->putpixel = &putpixel16;
         surface->putchar = &putchar16;
@@ -654,7 +587,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     case MX_PIXEL_FORMAT_RGB_x888:
     case MX_PIXEL_FORMAT_ARGB_8888:
         surface->translate_color = NULL;
-        surface->copyrect = &copyrect32;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect32;
         surface->putpixel = &putpixel32;
         surface->putchar = &putchar32;
@@ -663,7 +596,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_MONO_1:
         surface->translate_color = &ARGB8888_to_Luma;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -672,7 +605,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_RGB_332:
         surface->translate_color = &ARGB8888_to_RGB332;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -681,7 +614,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case MX_PIXEL_FORMAT_RGB_2220:
         surface->translate_color = &ARGB8888_to_RGB2220;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
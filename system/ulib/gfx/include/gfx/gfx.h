@@ -46,6 +46,11 @@ struct gfx_surface {
     size_t len;
     unsigned alpha;
 
+    // bounding box of pixels modified since the last flush;
+    // x1/y1 are exclusive, the box is empty when dirty_y0 >= dirty_y1
+    unsigned dirty_x0, dirty_y0;
+    unsigned dirty_x1, dirty_y1;
+
     // function pointers
     uint32_t (*translate_color)(uint32_t input);
     void (*copyrect)(gfx_surface*, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2);
@@ -91,6 +96,9 @@ void gfx_flush(struct gfx_surface* surface);
 // flush a subset of the surface
 void gfx_flush_rows(struct gfx_surface* surface, unsigned start, unsigned end);
 
+// flush only the rows modified since the last flush
+void gfx_flush_dirty(struct gfx_surface* surface);
+
 // clear the entire surface with a color
 static inline void gfx_clear(gfx_surface* surface, unsigned color) {
     surface->fillrect(surface, 0, 0, surface->width, surface->height, color);
@@ -128,9 +128,12 @@ static inline uint32_t _swap32(uint32_t n) {
 char* ip6toa(char* _out, void* ip6addr);
 #define IP6TOAMAX 40
 
+// flags for eth_recv()
+#define ETH_RX_CSUM_OK 1u  // hardware already validated the L4 checksum
+
 // provided by inet6.c
 void ip6_init(void* macaddr);
-void eth_recv(void* data, size_t len);
+void eth_recv(void* data, size_t len, uint32_t flags);
 
 typedef struct eth_buffer eth_buffer_t;
 
@@ -147,7 +150,17 @@ int udp6_send(const void* data, size_t len,
               const ip6_addr_t* daddr, uint16_t dport,
               uint16_t sport);
 
-// implement to recive UDP packets
+// receive callback for a port bound via udp6_bind()
+typedef void (*udp6_recv_fn)(void* data, size_t len,
+                             const ip6_addr_t* daddr, uint16_t dport,
+                             const ip6_addr_t* saddr, uint16_t sport);
+
+// bind fn to a UDP port so matching packets dispatch directly from
+// the hashed demux table instead of the udp6_recv() fallback.
+// fn == NULL unbinds.  returns -1 if the table is full
+int udp6_bind(uint16_t port, udp6_recv_fn fn);
+
+// implement to recive UDP packets for ports with no bound handler
 void udp6_recv(void* data, size_t len,
                const ip6_addr_t* daddr, uint16_t dport,
                const ip6_addr_t* saddr, uint16_t sport);
@@ -142,15 +142,32 @@ static int resolve_ip6(mac_addr_t* _mac, const ip6_addr_t* _ip) {
     return -1;
 }
 
+// ones' complement sum, accumulated a 32bit word at a time.  ones'
+// complement addition commutes with byte order, so the wide
+// accumulation folds down to the same 16bit result the old
+// per-halfword loop produced, at a quarter of the memory operations.
+// the memcpy loads keep unaligned buffers legal and compile down to
+// plain word loads
 static uint16_t checksum(const void* _data, size_t len, uint16_t _sum) {
-    uint32_t sum = _sum;
-    const uint16_t* data = _data;
-    while (len > 1) {
-        sum += *data++;
+    uint64_t sum = _sum;
+    const uint8_t* data = _data;
+
+    while (len >= 4) {
+        uint32_t n;
+        memcpy(&n, data, 4);
+        sum += n;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t n;
+        memcpy(&n, data, 2);
+        sum += n;
+        data += 2;
         len -= 2;
     }
     if (len) {
-        sum += (*data & 0xFF);
+        sum += *data;
     }
     while (sum > 0xFFFF) {
         sum = (sum & 0xFFFF) + (sum >> 16);
@@ -158,6 +175,55 @@ static uint16_t checksum(const void* _data, size_t len, uint16_t _sum) {
     return sum;
 }
 
+// hashed UDP port demux table.  bound ports dispatch directly from
+// _udp6_recv(); everything else falls back to the udp6_recv() callback
+#define UDP_DEMUX_SIZE 16 // must be a power of two
+
+typedef struct {
+    uint16_t port;
+    udp6_recv_fn fn;
+} udp6_binding_t;
+
+static udp6_binding_t udp6_demux[UDP_DEMUX_SIZE];
+
+static unsigned udp6_demux_hash(uint16_t port) {
+    return (port ^ (port >> 4)) & (UDP_DEMUX_SIZE - 1);
+}
+
+int udp6_bind(uint16_t port, udp6_recv_fn fn) {
+    if (port == 0) {
+        return -1;
+    }
+    unsigned i = udp6_demux_hash(port);
+    for (unsigned n = 0; n < UDP_DEMUX_SIZE; n++) {
+        udp6_binding_t* b = &udp6_demux[i];
+        if ((b->port == port) || (b->port == 0)) {
+            // an unbound slot keeps its port so probe chains
+            // running through it stay intact
+            b->port = port;
+            b->fn = fn;
+            return 0;
+        }
+        i = (i + 1) & (UDP_DEMUX_SIZE - 1);
+    }
+    return -1;
+}
+
+static udp6_recv_fn udp6_demux_lookup(uint16_t port) {
+    unsigned i = udp6_demux_hash(port);
+    for (unsigned n = 0; n < UDP_DEMUX_SIZE; n++) {
+        udp6_binding_t* b = &udp6_demux[i];
+        if (b->port == port) {
+            return b->fn;
+        }
+        if (b->port == 0) {
+            return NULL;
+        }
+        i = (i + 1) & (UDP_DEMUX_SIZE - 1);
+    }
+    return NULL;
+}
+
 typedef struct {
     uint8_t eth[16];
     ip6_hdr_t ip6;
@@ -262,7 +328,7 @@ fail:
     return -1;
 }
 
-void _udp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
+void _udp6_recv(ip6_hdr_t* ip, void* _data, size_t len, uint32_t flags) {
     udp_hdr_t* udp = _data;
     uint16_t sum, n;
 
@@ -270,13 +336,17 @@ void _udp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
         BAD("Bogus Header Len");
     if (udp->checksum == 0)
         BAD("Checksum Invalid");
-    if (udp->checksum == 0xFFFF)
-        udp->checksum = 0;
 
-    sum = checksum(&ip->length, 2, htons(HDR_UDP));
-    sum = checksum(&ip->src, 32 + len, sum);
-    if (sum != 0xFFFF)
-        BAD("Checksum Incorrect");
+    // skip the software verify when hardware already validated it
+    if (!(flags & ETH_RX_CSUM_OK)) {
+        if (udp->checksum == 0xFFFF)
+            udp->checksum = 0;
+
+        sum = checksum(&ip->length, 2, htons(HDR_UDP));
+        sum = checksum(&ip->src, 32 + len, sum);
+        if (sum != 0xFFFF)
+            BAD("Checksum Incorrect");
+    }
 
     n = ntohs(udp->length);
     if (n < UDP_HDR_LEN)
@@ -285,9 +355,17 @@ void _udp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
         BAD("Packet Too Short");
     len = n - UDP_HDR_LEN;
 
-    udp6_recv((uint8_t*)_data + UDP_HDR_LEN, len,
-              (void*)&ip->dst, ntohs(udp->dst_port),
-              (void*)&ip->src, ntohs(udp->src_port));
+    uint16_t dport = ntohs(udp->dst_port);
+    udp6_recv_fn fn = udp6_demux_lookup(dport);
+    if (fn) {
+        fn((uint8_t*)_data + UDP_HDR_LEN, len,
+           (void*)&ip->dst, dport,
+           (void*)&ip->src, ntohs(udp->src_port));
+    } else {
+        udp6_recv((uint8_t*)_data + UDP_HDR_LEN, len,
+                  (void*)&ip->dst, dport,
+                  (void*)&ip->src, ntohs(udp->src_port));
+    }
 }
 
 void icmp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
@@ -341,7 +419,7 @@ void icmp6_recv(ip6_hdr_t* ip, void* _data, size_t len) {
     }
 }
 
-void eth_recv(void* _data, size_t len) {
+void eth_recv(void* _data, size_t len, uint32_t flags) {
     uint8_t* data = _data;
     ip6_hdr_t* ip;
     uint32_t n;
@@ -385,7 +463,7 @@ void eth_recv(void* _data, size_t len) {
         icmp6_recv(ip, data, len);
         break;
     case HDR_UDP:
-        _udp6_recv(ip, data, len);
+        _udp6_recv(ip, data, len, flags);
         break;
     default:
         // do nothing
@@ -13,4 +13,8 @@ const struct vdso_constants DATA_CONSTANTS = {
     0,
     0,
     0,
+    0,
+    0,
+    0,
+    0,
 };
@@ -0,0 +1,28 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <magenta/syscalls.h>
+
+#include "private.h"
+
+// The kernel redirects the {_,}mx_channel_write dynamic symbol table
+// entries to point here; see VDso::VDso.
+mx_status_t CODE_fast_channel_write(mx_handle_t handle, uint32_t options,
+                                    const void* bytes, uint32_t num_bytes,
+                                    const mx_handle_t* handles,
+                                    uint32_t num_handles) {
+    // Fail oversized messages without entering the kernel. The limits
+    // are compile-time constants of the kernel this vDSO shipped with
+    // (see message_packet.cpp), which is exactly the pairing the vDSO
+    // exists to exploit. Note the kernel checks the handle first, so
+    // an oversized write on a bad handle reports ERR_OUT_OF_RANGE here
+    // where the kernel would have said ERR_BAD_HANDLE; error precedence
+    // between two invalid arguments is not part of the interface.
+    if (unlikely(num_bytes > MX_CHANNEL_MAX_MSG_BYTES ||
+                 num_handles > MX_CHANNEL_MAX_MSG_HANDLES))
+        return ERR_OUT_OF_RANGE;
+
+    return VDSO_mx_channel_write(handle, options, bytes, num_bytes,
+                                 handles, num_handles);
+}
@@ -0,0 +1,39 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <magenta/syscalls.h>
+
+#include <lib/fixed_point.h>
+
+#include "private.h"
+
+// At boot time the kernel can decide to redirect the {_,}mx_time_get
+// dynamic symbol table entries to point to this instead, when the
+// monotonic clock is a pure function of the raw tick counter.  See
+// VDso::VDso.
+mx_time_t CODE_fast_time_get(uint32_t clock_id) {
+#if __x86_64__
+    if (likely(clock_id == MX_CLOCK_MONOTONIC)) {
+        // Apply the same transformation the kernel's current_time()
+        // uses: scale the raw tick counter by the fixed-point factor
+        // published in the constants page.
+        uint32_t ticks_low;
+        uint32_t ticks_high;
+        __asm__ volatile("rdtsc" : "=a" (ticks_low), "=d" (ticks_high));
+        uint64_t ticks = ((uint64_t)ticks_high << 32) | ticks_low;
+
+        struct fp_32_64 ticks_to_mono = {
+            DATA_CONSTANTS.ticks_to_mono_l0,
+            DATA_CONSTANTS.ticks_to_mono_l32,
+            DATA_CONSTANTS.ticks_to_mono_l64,
+        };
+        return u64_mul_u64_fp32_64(ticks, ticks_to_mono);
+    }
+#endif
+
+    // Every other clock still requires entering the kernel, as does
+    // every clock on architectures whose tick counter the kernel does
+    // not publish a conversion for.
+    return VDSO_mx_time_get(clock_id);
+}
@@ -20,6 +20,9 @@ extern "C" {
 #include <magenta/syscall-vdso-definitions.h>
 
 __LOCAL decltype(mx_ticks_get) CODE_soft_ticks_get;
+__LOCAL decltype(mx_time_get) CODE_fast_time_get;
+__LOCAL decltype(mx_handle_close) CODE_fast_handle_close;
+__LOCAL decltype(mx_channel_write) CODE_fast_channel_write;
 
 };
 
@@ -11,18 +11,21 @@ MODULE_TYPE := userlib
 # This library should not depend on libc.
 MODULE_COMPILEFLAGS := -ffreestanding
 
-MODULE_HEADER_DEPS := kernel/lib/vdso
+MODULE_HEADER_DEPS := kernel/lib/vdso kernel/lib/fixed_point
 
 MODULE_SRCS := \
     $(LOCAL_DIR)/data.cpp \
     $(LOCAL_DIR)/mx_cache_flush.cpp \
+    $(LOCAL_DIR)/mx_channel_write.cpp \
     $(LOCAL_DIR)/mx_deadline_after.cpp \
+    $(LOCAL_DIR)/mx_handle_close.cpp \
     $(LOCAL_DIR)/mx_status_get_string.cpp \
     $(LOCAL_DIR)/mx_system_get_num_cpus.cpp \
     $(LOCAL_DIR)/mx_system_get_physmem.cpp \
     $(LOCAL_DIR)/mx_system_get_version.cpp \
     $(LOCAL_DIR)/mx_ticks_get.cpp \
     $(LOCAL_DIR)/mx_ticks_per_second.cpp \
+    $(LOCAL_DIR)/mx_time_get.cpp \
 
 ifeq ($(ARCH),arm64)
 MODULE_SRCS += \
@@ -14,6 +14,10 @@ typedef struct mdi_node_ref {
     const mdi_node_t* node;
     uint32_t siblings_count;        // number of siblings following node in list
     const void* siblings_end;       // pointer to end of remaining siblings
+    // set by mdi_init() when the image carries an index section and
+    // propagated to child refs, so mdi_find_node() can binary search
+    const void* base;               // root node; index offsets are relative to it
+    const mdi_index_header_t* index;
 } mdi_node_ref_t;
 
 static inline bool mdi_valid(const mdi_node_ref_t* ref) {
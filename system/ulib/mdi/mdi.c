@@ -21,6 +21,26 @@
     } while (0)
 #endif
 
+// locates and validates the index section following the node tree, if any
+static const mdi_index_header_t* mdi_find_index(const mdi_node_t* root,
+                                                uint32_t total_length) {
+    uint32_t tree_length = MDI_ALIGN(root->length);
+    if (total_length < tree_length + sizeof(mdi_index_header_t)) {
+        return NULL;
+    }
+    const mdi_index_header_t* index =
+            (const mdi_index_header_t *)((const void *)root + tree_length);
+    if (index->magic != MDI_INDEX_MAGIC) {
+        return NULL;
+    }
+    if ((total_length - tree_length - sizeof(*index)) / sizeof(mdi_index_entry_t)
+        < index->entry_count) {
+        xprintf("%s: index entries exceed bootdata length\n", __FUNCTION__);
+        return NULL;
+    }
+    return index;
+}
+
 // takes pointer to MDI header and returns reference to MDI root node
 mx_status_t mdi_init(const void* mdi_data, size_t length, mdi_node_ref_t* out_ref) {
     const bootdata_t* header = (const bootdata_t *)mdi_data;
@@ -35,8 +55,10 @@ mx_status_t mdi_init(const void* mdi_data, size_t length, mdi_node_ref_t* out_re
         return ERR_INVALID_ARGS;
     }
 
+    // the node tree may be followed by an index section, so the root node
+    // is allowed to be shorter than the bootdata item that contains it
     const mdi_node_t* node = (const mdi_node_t *)(header + 1);
-    if (node->length != header->length) {
+    if (node->length > header->length) {
         xprintf("%s: bad root node length\n", __FUNCTION__);
         out_ref->node = NULL;
         return ERR_INVALID_ARGS;
@@ -45,6 +67,8 @@ mx_status_t mdi_init(const void* mdi_data, size_t length, mdi_node_ref_t* out_re
     out_ref->node = node;
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
+    out_ref->base = node;
+    out_ref->index = mdi_find_index(node, header->length);
     return NO_ERROR;
 }
 
@@ -189,6 +213,8 @@ mx_status_t mdi_first_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref)
     out_ref->node = NULL;
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
+    out_ref->base = ref->base;
+    out_ref->index = ref->index;
 
    if (mdi_node_type(ref) != MDI_LIST) {
         xprintf("%s: ref not a list\n", __FUNCTION__);
@@ -215,6 +241,8 @@ mx_status_t mdi_first_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref)
 }
 
 mx_status_t mdi_next_child(const mdi_node_ref_t* ref, mdi_node_ref_t* out_ref) {
+    out_ref->base = ref->base;
+    out_ref->index = ref->index;
     if (ref->siblings_count == 0) {
         out_ref->node = NULL;
         out_ref->siblings_count = 0;
@@ -243,7 +271,52 @@ uint32_t mdi_child_count(const mdi_node_ref_t* ref) {
     }
 }
 
+// binary search the index section for the first child of the list at
+// list_offset with the given id (entries are sorted by list_offset, id,
+// node_offset, so the match found is the first in file order)
+static const mdi_index_entry_t* mdi_index_lookup(const mdi_index_header_t* index,
+                                                 uint32_t list_offset, mdi_id_t id) {
+    const mdi_index_entry_t* entries = (const mdi_index_entry_t *)(index + 1);
+    uint32_t lo = 0;
+    uint32_t hi = index->entry_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const mdi_index_entry_t* entry = &entries[mid];
+        if (entry->list_offset < list_offset ||
+            (entry->list_offset == list_offset && entry->id < id)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < index->entry_count && entries[lo].list_offset == list_offset
+        && entries[lo].id == id) {
+        return &entries[lo];
+    }
+    return NULL;
+}
+
 mx_status_t mdi_find_node(const mdi_node_ref_t* ref, mdi_id_t id, mdi_node_ref_t* out_ref) {
+    if (ref->index && mdi_node_type(ref) == MDI_LIST) {
+        out_ref->base = ref->base;
+        out_ref->index = ref->index;
+
+        uint32_t list_offset = (uint32_t)((const void *)ref->node - ref->base);
+        const mdi_index_entry_t* entry = mdi_index_lookup(ref->index, list_offset, id);
+        const mdi_node_t* root = (const mdi_node_t *)ref->base;
+        if (entry && entry->node_offset + sizeof(mdi_node_t) <= root->length) {
+            out_ref->node = (const mdi_node_t *)(ref->base + entry->node_offset);
+            out_ref->siblings_count = entry->following;
+            out_ref->siblings_end = (const void *)ref->node + ref->node->length;
+            return NO_ERROR;
+        }
+        out_ref->node = NULL;
+        out_ref->siblings_count = 0;
+        out_ref->siblings_end = NULL;
+        return ERR_NOT_FOUND;
+    }
+
     out_ref->siblings_count = 0;
     out_ref->siblings_end = NULL;
     mx_status_t status = mdi_first_child(ref, out_ref);
@@ -14,6 +14,8 @@
 #include <magenta/new.h>
 #include <mxtl/unique_ptr.h>
 
+#include "sha256.h"
+
 namespace merkle {
 
 Digest::Digest(const Digest& other) {
@@ -51,6 +53,7 @@ void Digest::Init() {
     SHA256_Init(&ctx_);
 #else
     clSHA256_init(&ctx_);
+    SHA256Accelerate(&ctx_);
 #endif // USE_LIBCRYPTO
 }
 
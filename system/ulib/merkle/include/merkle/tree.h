@@ -135,6 +135,12 @@ private:
     // tree and writes the digests to |tree|.
     mx_status_t HashData(const void* data, size_t length, void* tree);
 
+    // Checks the digests of the data nodes between |offset_| and |finish|
+    // against the digest list starting at |hashes|, fanning the work out
+    // across CPUs when the range is large enough.  Mismatches are recorded as
+    // with |AddFailure|.
+    void VerifyData(const void* data, uint64_t finish, const uint8_t* hashes);
+
     // This method adds the given offset |off| to the appropriate list of
     // failures.
     void AddFailure();
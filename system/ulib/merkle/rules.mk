@@ -10,6 +10,7 @@ MODULE_TYPE := userlib
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/digest.cpp \
+    $(LOCAL_DIR)/sha256.cpp \
     $(LOCAL_DIR)/tree.cpp
 
 MODULE_SO_NAME := merkle
@@ -0,0 +1,261 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sha256.h"
+
+#ifndef USE_LIBCRYPTO
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#include <arm_neon.h>
+#endif
+
+// cryptolib's generic _HASH_update copies its input into the context buffer a
+// byte at a time and runs a scalar compression function.  That is fine for the
+// few dozen bytes it hashes during boot-time signature checks, but far too
+// slow for hashing whole blobs.  The vtab installed below keeps cryptolib's
+// context layout and digest format but consumes whole 64-byte blocks straight
+// from the caller's buffer, dispatching to the processor's SHA extensions when
+// they are available.  cryptolib itself is untouched; it is shared with the
+// kernel, which must not execute vector instructions.
+
+namespace merkle {
+
+namespace {
+
+// cryptolib's own vtab, captured the first time |SHA256Accelerate| runs.  It
+// is how the scalar fallback reaches cryptolib's compression function without
+// duplicating it here.
+const clHASH_vtab* gScalarVtab;
+
+// Consumes |blocks| whole 64-byte blocks from |data|, selected once at
+// startup from the implementations below.
+void (*gTransformBlocks)(clHASH_CTX* ctx, const uint8_t* data, size_t blocks);
+
+extern const clHASH_vtab gAccelVtab;
+
+#if defined(__aarch64__) || defined(__x86_64__)
+// The SHA-256 round constants, grouped by four for the 128-bit SHA
+// instructions.
+alignas(16) const uint32_t kSHA256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+#endif
+
+#if defined(__x86_64__)
+// Compression using the SHA-NI instructions.  The sha256rnds2 instruction
+// performs two rounds on state held in the ABEF/CDGH arrangement, so the state
+// words are permuted on entry and exit.
+__attribute__((target("sha,ssse3,sse4.1"))) void
+TransformBlocksSHANI(clHASH_CTX* ctx, const uint8_t* data, size_t blocks) {
+    const __m128i kFlip =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<__m128i*>(&ctx->state[0]));
+    __m128i state1 =
+        _mm_loadu_si128(reinterpret_cast<__m128i*>(&ctx->state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);          // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);    // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+    while (blocks-- > 0) {
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        __m128i m[4];
+        for (size_t i = 0; i < 4; ++i) {
+            m[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(data + i * 16)),
+                kFlip);
+        }
+        for (size_t i = 0; i < 16; ++i) {
+            __m128i wk = _mm_add_epi32(
+                m[i & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(
+                              &kSHA256K[i * 4])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            wk = _mm_shuffle_epi32(wk, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+            if (i < 12) {
+                // Schedule the message words for rounds 4*(i+4) onward.
+                __m128i shifted = _mm_alignr_epi8(m[(i + 3) & 3], m[(i + 2) & 3], 4);
+                m[i & 3] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(m[i & 3], m[(i + 1) & 3]),
+                                  shifted),
+                    m[(i + 3) & 3]);
+            }
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        data += 64;
+    }
+    tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);    // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&ctx->state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&ctx->state[4]), state1);
+}
+
+bool HaveSHANI() {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if ((ebx & (1u << 29)) == 0) { // SHA
+        return false;
+    }
+    __cpuid(1, eax, ebx, ecx, edx);
+    return (ecx & (1u << 19)) != 0; // SSE4.1
+}
+#endif // __x86_64__
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+// Compression using the ARMv8 cryptographic extensions.
+void TransformBlocksCE(clHASH_CTX* ctx, const uint8_t* data, size_t blocks) {
+    uint32x4_t state0 = vld1q_u32(&ctx->state[0]);
+    uint32x4_t state1 = vld1q_u32(&ctx->state[4]);
+    while (blocks-- > 0) {
+        uint32x4_t abcd = state0;
+        uint32x4_t efgh = state1;
+        uint32x4_t m[4];
+        for (size_t i = 0; i < 4; ++i) {
+            m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+        }
+        for (size_t i = 0; i < 16; ++i) {
+            uint32x4_t wk = vaddq_u32(m[i & 3], vld1q_u32(&kSHA256K[i * 4]));
+            uint32x4_t prev = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, wk);
+            efgh = vsha256h2q_u32(efgh, prev, wk);
+            if (i < 12) {
+                m[i & 3] = vsha256su1q_u32(
+                    vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]), m[(i + 2) & 3],
+                    m[(i + 3) & 3]);
+            }
+        }
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+        data += 64;
+    }
+    vst1q_u32(&ctx->state[0], state0);
+    vst1q_u32(&ctx->state[4], state1);
+}
+#endif // __aarch64__ && __ARM_FEATURE_CRYPTO
+
+// Fallback that feeds cryptolib's scalar compression function a block at a
+// time.  Still much faster than the byte-at-a-time generic update.
+void TransformBlocksScalar(clHASH_CTX* ctx, const uint8_t* data,
+                           size_t blocks) {
+    while (blocks-- > 0) {
+        if (data != ctx->buf) {
+            memcpy(ctx->buf, data, sizeof(ctx->buf));
+        }
+        gScalarVtab->_transform(ctx);
+        data += sizeof(ctx->buf);
+    }
+}
+
+void AccelInit(clHASH_CTX* ctx) {
+    clSHA256_init(ctx);
+    ctx->f = &gAccelVtab;
+}
+
+void AccelTransform(clHASH_CTX* ctx) {
+    gTransformBlocks(ctx, ctx->buf, 1);
+}
+
+void AccelUpdate(clHASH_CTX* ctx, const void* data, int len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t left = static_cast<size_t>(len);
+    size_t used = static_cast<size_t>(ctx->count & 63);
+    ctx->count += static_cast<uint64_t>(len);
+    // Top off a partially filled block first.
+    if (used != 0) {
+        size_t n = sizeof(ctx->buf) - used;
+        if (n > left) {
+            n = left;
+        }
+        memcpy(ctx->buf + used, p, n);
+        p += n;
+        left -= n;
+        if (used + n < sizeof(ctx->buf)) {
+            return;
+        }
+        gTransformBlocks(ctx, ctx->buf, 1);
+    }
+    size_t blocks = left / sizeof(ctx->buf);
+    if (blocks > 0) {
+        gTransformBlocks(ctx, p, blocks);
+        p += blocks * sizeof(ctx->buf);
+        left -= blocks * sizeof(ctx->buf);
+    }
+    if (left > 0) {
+        memcpy(ctx->buf, p, left);
+    }
+}
+
+// Identical padding and serialization to cryptolib's generic _HASH_final,
+// which is static and so can't be reused directly.
+const uint8_t* AccelFinal(clHASH_CTX* ctx) {
+    uint64_t cnt = ctx->count * 8;
+    AccelUpdate(ctx, "\x80", 1);
+    while ((ctx->count & 63) != 56) {
+        AccelUpdate(ctx, "\0", 1);
+    }
+    for (int i = 0; i < 8; ++i) {
+        uint8_t tmp = static_cast<uint8_t>(cnt >> ((7 - i) * 8));
+        AccelUpdate(ctx, &tmp, 1);
+    }
+    uint8_t* p = ctx->buf;
+    for (int i = 0; i < clSHA256_DIGEST_SIZE / 4; ++i) {
+        uint32_t tmp = ctx->state[i];
+        *p++ = static_cast<uint8_t>(tmp >> 24);
+        *p++ = static_cast<uint8_t>(tmp >> 16);
+        *p++ = static_cast<uint8_t>(tmp >> 8);
+        *p++ = static_cast<uint8_t>(tmp >> 0);
+    }
+    return ctx->buf;
+}
+
+// The padding hash is only consumed by clRSA2K_verify, which never sees this
+// vtab.
+const clHASH_vtab gAccelVtab = {
+    AccelInit, AccelUpdate, AccelFinal, AccelTransform, clSHA256_DIGEST_SIZE,
+    nullptr,
+};
+
+} // namespace
+
+void SHA256Accelerate(clSHA256_CTX* ctx) {
+    if (gTransformBlocks == nullptr) {
+        // Concurrent first calls both store the same values, so this needs no
+        // synchronization.
+        gScalarVtab = ctx->f;
+#if defined(__x86_64__)
+        gTransformBlocks =
+            HaveSHANI() ? TransformBlocksSHANI : TransformBlocksScalar;
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+        gTransformBlocks = TransformBlocksCE;
+#else
+        gTransformBlocks = TransformBlocksScalar;
+#endif
+    }
+    ctx->f = &gAccelVtab;
+}
+
+} // namespace merkle
+#endif // USE_LIBCRYPTO
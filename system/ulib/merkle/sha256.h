@@ -0,0 +1,19 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#ifndef USE_LIBCRYPTO
+#include <lib/crypto/cryptolib.h>
+
+namespace merkle {
+
+// Replaces the hash vtab on |ctx| with one that consumes whole 64-byte blocks
+// at a time, using the processor's SHA extensions when they are present.  |ctx|
+// must have just been initialized with |clSHA256_init|.  The digests produced
+// are bit-identical to cryptolib's; only the throughput changes.
+void SHA256Accelerate(clSHA256_CTX* ctx);
+
+} // namespace merkle
+#endif // USE_LIBCRYPTO
@@ -11,12 +11,25 @@
 #include <mxtl/algorithm.h>
 #include <mxtl/unique_ptr.h>
 
+#ifdef __Fuchsia__
+#include <threads.h>
+
+#include <magenta/syscalls.h>
+#endif
+
 namespace merkle {
 
 constexpr size_t Tree::kNodeSize;
 const size_t kDigestsPerNode = Tree::kNodeSize / Digest::kLength;
 const size_t kMaxFailures = kDigestsPerNode;
 
+#ifdef __Fuchsia__
+// Verification fans out across CPUs, but only when every worker gets at least
+// this many data nodes; below that the cost of starting threads dominates.
+const size_t kMinNodesPerThread = 16;
+const size_t kMaxVerifyThreads = 4;
+#endif
+
 Tree::~Tree() {}
 
 // Public methods
@@ -190,14 +203,15 @@ mx_status_t Tree::Verify(const void* data, size_t data_len, const void* tree,
             finish = mxtl::min(mxtl::roundup(offset + length, kNodeSize),
                                static_cast<uint64_t>(data_len));
             hash_offset = (offset_ / kDigestsPerNode);
-        } else {
-            offset_ = ranges_[level_ - 1].offset;
-            finish = offset_ + ranges_[level_ - 1].length;
-            hash_offset = offsets_[level_] +
-                          (offset_ - offsets_[level_ - 1]) / kDigestsPerNode;
+            VerifyData(data, finish, hashes + hash_offset);
+            continue;
         }
+        offset_ = ranges_[level_ - 1].offset;
+        finish = offset_ + ranges_[level_ - 1].length;
+        hash_offset = offsets_[level_] +
+                      (offset_ - offsets_[level_ - 1]) / kDigestsPerNode;
         while (offset_ < finish) {
-            HashNode(level_ == 0 ? data : tree);
+            HashNode(tree);
             if (digest_ != hashes + hash_offset) {
                 AddFailure();
             }
@@ -297,6 +311,113 @@ mx_status_t Tree::HashData(const void* data, size_t length, void* tree) {
     return NO_ERROR;
 }
 
+#ifdef __Fuchsia__
+namespace {
+
+// Describes the slice of data nodes that one worker checks in
+// |Tree::VerifyData|, along with where it records any mismatches.
+struct VerifyArgs {
+    const uint8_t* data;
+    size_t data_len;
+    uint64_t offset;
+    uint64_t finish;
+    const uint8_t* hashes;
+    size_t num_failures;
+    uint64_t failures[kMaxFailures];
+};
+
+// thrd_start_t routine which checks each data node in [offset, finish)
+// against its digest.  The hashing matches |Tree::HashNode| at level 0.
+int VerifyDataThread(void* arg) {
+    VerifyArgs* a = static_cast<VerifyArgs*>(arg);
+    Digest actual;
+    const uint8_t* hash = a->hashes;
+    for (uint64_t off = a->offset; off < a->finish; off += Tree::kNodeSize) {
+        actual.Init();
+        uint64_t locality = off; // level 0
+        actual.Update(&locality, sizeof(locality));
+        actual.Update(a->data + off,
+                      static_cast<size_t>(mxtl::min(
+                          static_cast<uint64_t>(Tree::kNodeSize),
+                          static_cast<uint64_t>(a->data_len) - off)));
+        actual.Final();
+        if (actual != hash) {
+            if (a->num_failures < kMaxFailures) {
+                a->failures[a->num_failures] = off;
+            }
+            ++a->num_failures;
+        }
+        hash += Digest::kLength;
+    }
+    return 0;
+}
+
+} // namespace
+#endif // __Fuchsia__
+
+void Tree::VerifyData(const void* data, uint64_t finish,
+                      const uint8_t* hashes) {
+#ifdef __Fuchsia__
+    size_t nodes =
+        static_cast<size_t>((finish - offset_ + kNodeSize - 1) / kNodeSize);
+    size_t threads = mxtl::min(static_cast<size_t>(mx_system_get_num_cpus()),
+                               kMaxVerifyThreads);
+    threads = mxtl::min(threads, nodes / kMinNodesPerThread);
+    if (threads > 1) {
+        AllocChecker ac;
+        mxtl::unique_ptr<VerifyArgs[]> args(new (&ac) VerifyArgs[threads]);
+        if (ac.check()) {
+            size_t per = (nodes + threads - 1) / threads;
+            for (size_t i = 0; i < threads; ++i) {
+                args[i].data = static_cast<const uint8_t*>(data);
+                args[i].data_len = data_len_;
+                args[i].offset = offset_ + (i * per) * kNodeSize;
+                args[i].finish =
+                    mxtl::min(args[i].offset + per * kNodeSize, finish);
+                args[i].hashes = hashes + (i * per) * Digest::kLength;
+                args[i].num_failures = 0;
+            }
+            thrd_t workers[kMaxVerifyThreads];
+            bool spawned[kMaxVerifyThreads] = {false};
+            for (size_t i = 1; i < threads; ++i) {
+                spawned[i] = thrd_create(&workers[i], VerifyDataThread,
+                                         &args[i]) == thrd_success;
+            }
+            VerifyDataThread(&args[0]);
+            for (size_t i = 1; i < threads; ++i) {
+                if (spawned[i]) {
+                    thrd_join(workers[i], nullptr);
+                } else {
+                    // Couldn't get a thread; check this slice ourselves.
+                    VerifyDataThread(&args[i]);
+                }
+            }
+            // The slices are disjoint and ascending, so replaying the
+            // failures in order matches what the serial walk records.
+            for (size_t i = 0; i < threads; ++i) {
+                size_t recorded =
+                    mxtl::min(args[i].num_failures, kMaxFailures);
+                for (size_t j = 0; j < recorded; ++j) {
+                    offset_ = args[i].failures[j] + kNodeSize;
+                    AddFailure();
+                }
+                num_failures_ += args[i].num_failures - recorded;
+            }
+            offset_ = finish;
+            return;
+        }
+        // No memory for the worker slices; fall through and check serially.
+    }
+#endif
+    while (offset_ < finish) {
+        HashNode(data);
+        if (digest_ != hashes) {
+            AddFailure();
+        }
+        hashes += Digest::kLength;
+    }
+}
+
 void Tree::AddFailure() {
     mxtl::Array<uint64_t>* failures =
         (level_ == 0 ? &data_failures_ : &tree_failures_);
@@ -20,11 +20,21 @@
 // TODO: should use a system default
 #define MAX_WAIT_EVENTS 1024
 
+// Registrations are subscriptions on a v2 port, held across epoll_wait
+// calls, so waiting costs one port dequeue per ready event rather than
+// re-arming every registered fd. Each registration gets a fresh key;
+// packets whose key no longer matches a cookie (the registration was
+// deleted or modified while the packet was queued) are skipped.
 typedef struct mxio_epoll_cookie {
     list_node_t node;
     mxio_t* io;
     struct epoll_event ep_event;
     int fd;
+    // key the current subscription was armed with
+    uint64_t key;
+    // cached waitable handle and signal mapping for ep_event.events
+    mx_handle_t h;
+    mx_signals_t signals;
 } mxio_epoll_cookie_t;
 
 typedef struct mxio_epoll {
@@ -32,6 +42,7 @@ typedef struct mxio_epoll {
     mx_handle_t h;
     mtx_t cookies_lock;
     list_node_t cookies;
+    atomic_uint_fast64_t next_key;
 } mxio_epoll_t;
 
 static void mxio_epoll_cookie_add(mxio_epoll_t* epio,
@@ -64,6 +75,16 @@ static mxio_epoll_cookie_t* mxio_epoll_cookie_find(mxio_epoll_t* epio, int fd) {
     return mxio_epoll_cookie_get(epio, fd, false);
 }
 
+static mxio_epoll_cookie_t* mxio_epoll_cookie_find_key_locked(mxio_epoll_t* epio, uint64_t key) {
+    mxio_epoll_cookie_t* entry = NULL;
+    list_for_every_entry(&epio->cookies, entry, mxio_epoll_cookie_t, node) {
+        if (entry->key == key) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
 static mxio_epoll_cookie_t* mxio_epoll_cookie_remove(mxio_epoll_t* epio, int fd) {
     return mxio_epoll_cookie_get(epio, fd, true);
 }
@@ -72,16 +93,18 @@ static mx_status_t mxio_epoll_close(mxio_t* io) {
     mxio_epoll_t* epio = (mxio_epoll_t*)io;
     mx_handle_t h = epio->h;
     epio->h = MX_HANDLE_INVALID;
-    mx_handle_close(h);
 
     mxio_epoll_cookie_t* cookie;
     mtx_lock(&epio->cookies_lock);
     while ((cookie = list_remove_head_type(&epio->cookies, mxio_epoll_cookie_t,
                                            node))) {
+        mx_port_cancel(h, cookie->h, cookie->key);
         mxio_release(cookie->io);
         free(cookie);
     }
     mtx_unlock(&epio->cookies_lock);
+
+    mx_handle_close(h);
     return NO_ERROR;
 }
 
@@ -115,13 +138,14 @@ static mxio_t* mxio_epoll_create(mx_handle_t h) {
     epio->h = h;
     mtx_init(&epio->cookies_lock, mtx_plain);
     list_initialize(&epio->cookies);
+    atomic_init(&epio->next_key, 1);
     return &epio->io;
 }
 
 mx_status_t mxio_epoll(mxio_t** out) {
     mx_handle_t h;
     mx_status_t status;
-    if ((status = mx_waitset_create(0, &h)) < 0) {
+    if ((status = mx_port_create(MX_PORT_OPT_V2, &h)) < 0) {
         return status;
     }
     mxio_t* io;
@@ -195,16 +219,14 @@ int epoll_ctl(int epfd, int op, int fd, struct epoll_event* ep_event) {
         break;
     case EPOLL_CTL_MOD:
     case EPOLL_CTL_DEL:
-        // or retrieve an existing cookie and remove the current epoll event
+        // or retrieve an existing cookie and drop its subscription; a
+        // packet it already queued is skipped by its stale key at wait time
         cookie = mxio_epoll_cookie_remove(epio, fd);
         if (cookie == NULL) {
             r = ERR_NOT_FOUND;
             goto end;
         }
-        if ((r = mx_waitset_remove(epio->h, (uint64_t)(uintptr_t)cookie)) < 0) {
-            mxio_epoll_cookie_add(epio, cookie);
-            goto end;
-        }
+        mx_port_cancel(epio->h, cookie->h, cookie->key);
         break;
     default:
         r = ERR_INVALID_ARGS;
@@ -216,18 +238,25 @@ int epoll_ctl(int epfd, int op, int fd, struct epoll_event* ep_event) {
         mxio_release(cookie->io);
         free(cookie);
     } else {
-        // or add a new epoll event and put the cookie into the list
+        // or subscribe with the new event set, caching the handle and
+        // signal mapping so epoll_wait never has to recompute them
         mx_handle_t h = MX_HANDLE_INVALID;
         mx_signals_t signals = 0;
         io->ops->wait_begin(io, ep_event->events, &h, &signals);
         if (h == MX_HANDLE_INVALID) {
             // wait operation is not applicable to the handle
             r = ERR_INVALID_ARGS;
+            mxio_release(cookie->io);
+            free(cookie);
             goto end;
         }
 
         cookie->ep_event = *ep_event;
-        if ((r = mx_waitset_add(epio->h, (uint64_t)(uintptr_t)cookie, h, signals)) < 0) {
+        cookie->h = h;
+        cookie->signals = signals;
+        cookie->key = atomic_fetch_add(&epio->next_key, 1);
+        if ((r = mx_object_wait_async(h, epio->h, cookie->key, signals,
+                                      MX_WAIT_ASYNC_ONCE)) < 0) {
             mxio_release(cookie->io);
             free(cookie);
             goto end;
@@ -263,29 +292,43 @@ int epoll_wait(int epfd, struct epoll_event* ep_events, int maxevents, int timeo
     }
     mxio_epoll_t* epio = (mxio_epoll_t*)io;
 
-    mx_status_t r;
-    uint32_t num_results = maxevents;
-    mx_waitset_result_t results[maxevents];
+    mx_status_t r = NO_ERROR;
     mx_time_t tmo = (timeout >= 0) ? mx_deadline_after(MX_MSEC(timeout)) : MX_TIME_INFINITE;
 
-    if ((r = mx_waitset_wait(epio->h, tmo, results, &num_results)) < 0) {
-        mxio_release(io);
-        return (r == ERR_TIMED_OUT) ? 0 : ERROR(r);
-    }
+    int count = 0;
+    while (count < maxevents) {
+        // block until the deadline for the first packet, then drain
+        // whatever else is already queued without waiting
+        mx_port_packet_t packet;
+        if ((r = mx_port_wait(epio->h, count ? 0ull : tmo, &packet, 0)) < 0) {
+            break;
+        }
 
-    for (uint32_t i = 0; i < num_results; i++) {
-        mxio_epoll_cookie_t* cookie = (mxio_epoll_cookie_t*)(uintptr_t)results[i].cookie;
-        mxio_t* io = cookie->io;
+        mtx_lock(&epio->cookies_lock);
+        mxio_epoll_cookie_t* cookie = mxio_epoll_cookie_find_key_locked(epio, packet.key);
+        if (cookie == NULL) {
+            // stale packet from a deleted or modified registration
+            mtx_unlock(&epio->cookies_lock);
+            continue;
+        }
         uint32_t events;
-
-        io->ops->wait_end(io, results[i].observed, &events);
+        cookie->io->ops->wait_end(cookie->io, packet.signal.observed, &events);
         // mask unrequested events except HUP/ERR
-        ep_events[i].events = events & (cookie->ep_event.events | EPOLLHUP | EPOLLERR);
-
-        ep_events[i].data = cookie->ep_event.data;
+        ep_events[count].events = events & (cookie->ep_event.events | EPOLLHUP | EPOLLERR);
+        ep_events[count].data = cookie->ep_event.data;
+        count++;
+
+        // re-arm; if the condition still holds this immediately queues
+        // a fresh packet, giving level-triggered behavior
+        mx_object_wait_async(cookie->h, epio->h, cookie->key, cookie->signals,
+                             MX_WAIT_ASYNC_ONCE);
+        mtx_unlock(&epio->cookies_lock);
     }
     mxio_release(io);
-    return (int)num_results;
+    if (count == 0 && r != ERR_TIMED_OUT) {
+        return ERROR(r);
+    }
+    return count;
 }
 
 int epoll_pwait(int epfd, struct epoll_event* events, int maxevents, int timeout, const sigset_t* sigmask) {
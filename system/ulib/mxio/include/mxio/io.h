@@ -57,4 +57,26 @@ mx_status_t mxio_pipe_half(mx_handle_t* handle, uint32_t* type);
 // eagerly reading the contents into a freshly-created VMO.
 mx_status_t mxio_get_vmo(int fd, mx_handle_t* out_vmo);
 
+// Enable or disable client-side buffering on a remote file fd.
+// While enabled, small reads are served from a readahead window (or
+// directly from the server's file VMO when it provides one) and small
+// writes are coalesced before being sent, so byte-grain consumers don't
+// pay a channel round trip per call. The file offset is tracked locally;
+// buffered data is flushed when the fd is closed or buffering is
+// disabled. Not coherent with concurrent access to the same file through
+// other fds or processes, and toggling races against concurrent io on
+// the same fd. Returns ERR_NOT_SUPPORTED for fds that don't speak the
+// remoteio protocol.
+mx_status_t mxio_fd_buffering(int fd, bool enable);
+
+// Send count bytes of file_fd, starting at offset, to a connected
+// stream socket_fd without bouncing the data through this process: the
+// filesystem server writes the file's pages into the socket directly.
+// The file offset of file_fd is not used or modified. Returns the
+// number of bytes sent, which may be short at end of file or (for a
+// non-blocking socket) when the socket buffer fills. Returns
+// ERR_NOT_SUPPORTED when file_fd does not speak the remoteio protocol
+// or socket_fd is not a connected stream socket.
+ssize_t mxio_transmit(int socket_fd, int file_fd, off_t offset, size_t count);
+
 __END_CDECLS
@@ -50,7 +50,9 @@ __BEGIN_CDECLS
 #define MXRIO_SYNC         0x00000019
 #define MXRIO_LINK        (0x0000001a | MXRIO_ONE_HANDLE)
 #define MXRIO_MMAP         0x0000001b
-#define MXRIO_NUM_OPS      28
+#define MXRIO_TRANSMIT    (0x0000001c | MXRIO_ONE_HANDLE)
+#define MXRIO_SYNC_RANGE   0x0000001d
+#define MXRIO_NUM_OPS      30
 
 #define MXRIO_OP(n)        ((n) & 0x3FF) // opcode
 #define MXRIO_HC(n)        (((n) >> 8) & 3) // handle count
@@ -63,7 +65,8 @@ __BEGIN_CDECLS
     "read_at", "write_at", "truncate", "rename", \
     "connect", "bind", "listen", "getsockname", \
     "getpeername", "getsockopt", "setsockopt", "getaddrinfo", \
-    "setattr", "sync", "link", "mmap" }
+    "setattr", "sync", "link", "mmap", \
+    "transmit", "sync_range" }
 
 const char* mxio_opname(uint32_t op);
 
@@ -156,6 +159,26 @@ typedef struct mxrio_mmap_data {
     int32_t flags;
 } mxrio_mmap_data_t;
 
+// TRANSMIT asks the server to write file bytes [offset, offset + length)
+// directly into a socket handle provided by the client, avoiding the
+// bounce through the client's address space.  The server never blocks
+// on the socket; on reply, length holds the bytes actually sent and the
+// client is expected to wait for the socket to drain and reissue the op
+// for the remainder.
+typedef struct mxrio_transmit_data {
+    uint64_t offset;
+    uint64_t length;
+} mxrio_transmit_data_t;
+
+// SYNC_RANGE asks the server to make at least the file bytes
+// [offset, offset + length) durable, allowing a filesystem to commit
+// less than its whole dirty set.  length saturates at the end of the
+// file; servers which cannot sync a sub-range sync the whole file.
+typedef struct mxrio_sync_range_data {
+    uint64_t offset;
+    uint64_t length;
+} mxrio_sync_range_data_t;
+
 static_assert(MXIO_CHUNK_SIZE >= PATH_MAX, "MXIO_CHUNK_SIZE must be large enough to contain paths");
 
 #define READDIR_CMD_NONE  0
@@ -199,6 +222,7 @@ static_assert(MXIO_CHUNK_SIZE >= PATH_MAX, "MXIO_CHUNK_SIZE must be large enough
 // SYNC        0          0        0                 0           -               -
 // LINK        0          0        <name1>0<name2>0  0           -               -
 // MMAP        maxreply   0        mmap_data_msg     0           mmap_data_msg   vmohandle
+// TRANSMIT    0          0        transmit_data     0           transmit_data   - (tx handle[0]: socket, consumed)
 //
 // proposed:
 //
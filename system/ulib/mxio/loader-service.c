@@ -177,13 +177,69 @@ done:
     return 0;
 }
 
+// One resolved library, kept for the life of the multiloader.  Every
+// process asking for the same name gets a duplicate of the same vmo, so
+// the library is opened and transferred once and all of its readers
+// share the same pages (text stays shared; the client's dynamic linker
+// only copies the pages it relocates).  If a library is replaced on
+// disk, the cached vmo keeps serving the old contents until the
+// multiloader is restarted.
+typedef struct dlsvc_cached_lib {
+    struct dlsvc_cached_lib* next;
+    mx_handle_t vmo;
+    char name[];
+} dlsvc_cached_lib_t;
+
 struct mxio_multiloader {
     char name[MX_MAX_NAME_LEN];
     mtx_t dispatcher_lock;
     mxio_dispatcher_t* dispatcher;
     mx_handle_t dispatcher_log;
+    mtx_t cache_lock;
+    dlsvc_cached_lib_t* cache;
 };
 
+// Serve LOAD_OBJECT from the multiloader's cache, falling through to
+// the search path only on the first request for each name.
+static mx_handle_t multiloader_load_object(void* arg, uint32_t load_op,
+                                           const char* fn) {
+    mxio_multiloader_t* ml = arg;
+
+    if (load_op != LOADER_SVC_OP_LOAD_OBJECT) {
+        // script interpreters are rare and named by absolute path;
+        // not worth caching
+        return default_load_object(NULL, load_op, fn);
+    }
+
+    mtx_lock(&ml->cache_lock);
+    dlsvc_cached_lib_t* lib;
+    for (lib = ml->cache; lib != NULL; lib = lib->next) {
+        if (!strcmp(lib->name, fn)) {
+            break;
+        }
+    }
+    if (lib == NULL) {
+        mx_handle_t vmo = default_load_object(NULL, load_op, fn);
+        if (vmo < 0) {
+            mtx_unlock(&ml->cache_lock);
+            return vmo;
+        }
+        if ((lib = malloc(sizeof(*lib) + strlen(fn) + 1)) == NULL) {
+            // no memory to remember it; just serve this request
+            mtx_unlock(&ml->cache_lock);
+            return vmo;
+        }
+        lib->vmo = vmo;
+        strcpy(lib->name, fn);
+        lib->next = ml->cache;
+        ml->cache = lib;
+    }
+    mx_handle_t out;
+    mx_status_t r = mx_handle_duplicate(lib->vmo, MX_RIGHT_SAME_RIGHTS, &out);
+    mtx_unlock(&ml->cache_lock);
+    return (r < 0) ? r : out;
+}
+
 mx_status_t mxio_multiloader_create(const char* name,
                                     mxio_multiloader_t** ml_out) {
     if (name == NULL || name[0] == '\0' || ml_out == NULL) {
@@ -209,7 +265,7 @@ static mx_status_t multiloader_cb(mx_handle_t h, void* cb, void* cookie) {
     // This uses ml->dispatcher_log without grabbing the lock, but
     // it will never change once the dispatcher that called us is created.
     mxio_multiloader_t* ml = (mxio_multiloader_t*) cookie;
-    return handle_loader_rpc(h, default_load_object, NULL, ml->dispatcher_log);
+    return handle_loader_rpc(h, multiloader_load_object, ml, ml->dispatcher_log);
 }
 
 // TODO(dbort): Provide a name/id for the process that this handle will
@@ -7,6 +7,7 @@
 #include "private.h"
 
 typedef struct mxrio mxrio_t;
+typedef struct mxrio_buffer mxrio_buffer_t;
 struct mxrio {
     // base mxio io object
     mxio_t io;
@@ -19,8 +20,20 @@ struct mxrio {
 
     // transaction id used for synchronous remoteio calls
     _Atomic mx_txid_t txid;
+
+    // optional readahead/write-behind buffer (see mxio_fd_buffering),
+    // NULL when buffering is off
+    mxrio_buffer_t* buf;
+
+    // nonzero while a thread has pipelined transactions in flight on h;
+    // other large ops fall back to one-at-a-time transactions meanwhile
+    atomic_int pipeline_busy;
 };
 
+// how many tagged transactions a multi-chunk read or write keeps
+// outstanding on the channel at once
+#define MXRIO_MAX_INFLIGHT 8
+
 // These are for the benefit of namespace.c
 // which needs lower level access to remoteio internals
 
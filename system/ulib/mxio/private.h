@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <threads.h>
 
 typedef struct mxio mxio_t;
@@ -33,6 +34,8 @@ typedef struct mxio_ops {
     ssize_t (*read_at)(mxio_t* io, void* data, size_t len, mx_off_t offset);
     ssize_t (*write)(mxio_t* io, const void* data, size_t len);
     ssize_t (*write_at)(mxio_t* io, const void* data, size_t len, mx_off_t offset);
+    ssize_t (*readv)(mxio_t* io, const struct iovec* iov, int niov);
+    ssize_t (*writev)(mxio_t* io, const struct iovec* iov, int niov);
     ssize_t (*recvmsg)(mxio_t* io, struct msghdr* msg, int flags);
     ssize_t (*sendmsg)(mxio_t* io, const struct msghdr* msg, int flags);
     off_t (*seek)(mxio_t* io, off_t offset, int whence);
@@ -134,6 +137,12 @@ mxio_t* mxio_vmofile_create(mx_handle_t h, mx_off_t off, mx_off_t len);
 // Takes ownership of h and s.
 mxio_t* mxio_socket_create(mx_handle_t h, mx_handle_t s, int flags);
 
+// Connect to the service |name| below the service directory |svc| via the
+// factory cache (service.c). Returns NO_ERROR only on a cache hit, in which
+// case |h| has been consumed; on any error |h| remains owned by the caller
+// so the uncached path may be tried instead.
+mx_status_t mxio_service_cache_connect(mx_handle_t svc, const char* name, mx_handle_t h);
+
 // creates a message port and pair of simple io mxio_t's
 int mxio_pipe_pair(mxio_t** a, mxio_t** b);
 
@@ -13,6 +13,7 @@
 #include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <threads.h>
+#include <unistd.h>
 
 #include <magenta/device/device.h>
 #include <magenta/device/ioctl.h>
@@ -24,8 +25,10 @@
 #include <mxio/io.h>
 #include <mxio/remoteio.h>
 #include <mxio/util.h>
+#include <mxio/vfs.h>
 
 #include "private-remoteio.h"
+#include "unistd.h"
 
 #define MXDEBUG 0
 
@@ -329,57 +332,232 @@ ssize_t mxrio_ioctl(mxio_t* io, uint32_t op, const void* in_buf,
     return r;
 }
 
-static ssize_t write_common(uint32_t op, mxio_t* io, const void* _data, size_t len, off_t offset) {
-    mxrio_t* rio = (mxrio_t*)io;
-    const uint8_t* data = _data;
-    ssize_t count = 0;
-    mx_status_t r = 0;
-    mxrio_msg_t msg;
-    ssize_t xfer;
+// Read and write payloads are gathered from and scattered to an iovec
+// array; (idx, off) name a byte position within the array. Zero length
+// entries are skipped.
 
+static void iov_advance(const struct iovec* iov, size_t* idx, size_t* off, size_t len) {
     while (len > 0) {
-        xfer = (len > MXIO_CHUNK_SIZE) ? MXIO_CHUNK_SIZE : len;
+        size_t space = iov[*idx].iov_len - *off;
+        if (len < space) {
+            *off += len;
+            return;
+        }
+        len -= space;
+        (*idx)++;
+        *off = 0;
+    }
+}
 
-        memset(&msg, 0, MXRIO_HDR_SZ);
-        msg.op = op;
-        msg.datalen = xfer;
-        if (op == MXRIO_WRITE_AT)
-            msg.arg2.off = offset;
-        memcpy(msg.data, data, xfer);
+static void iov_gather(uint8_t* dst, const struct iovec* iov, size_t idx, size_t off, size_t len) {
+    while (len > 0) {
+        size_t n = iov[idx].iov_len - off;
+        if (n > len)
+            n = len;
+        if (n > 0) {
+            memcpy(dst, (uint8_t*)iov[idx].iov_base + off, n);
+            dst += n;
+            len -= n;
+        }
+        idx++;
+        off = 0;
+    }
+}
 
-        if ((r = mxrio_txn(rio, &msg)) < 0) {
-            break;
+static void iov_scatter(const struct iovec* iov, size_t idx, size_t off, const uint8_t* src, size_t len) {
+    while (len > 0) {
+        size_t n = iov[idx].iov_len - off;
+        if (n > len)
+            n = len;
+        if (n > 0) {
+            memcpy((uint8_t*)iov[idx].iov_base + off, src, n);
+            src += n;
+            len -= n;
         }
-        discard_handles(msg.handle, msg.hcount);
+        idx++;
+        off = 0;
+    }
+}
 
-        if (r > xfer) {
-            r = ERR_IO;
-            break;
+// Read one reply message off the channel, blocking until one arrives.
+// Returns an error if the message is not a valid MXRIO_STATUS reply.
+static mx_status_t mxrio_read_reply(mx_handle_t h, mxrio_msg_t* msg) {
+    mx_status_t r;
+    for (;;) {
+        msg->hcount = MXIO_MAX_HANDLES;
+        uint32_t dsize = sizeof(*msg);
+        r = mx_channel_read(h, 0, msg, msg->handle, dsize, msg->hcount, &dsize, &msg->hcount);
+        if (r == ERR_SHOULD_WAIT) {
+            mx_signals_t pending;
+            r = mx_object_wait_one(h, MX_CHANNEL_READABLE | MX_CHANNEL_PEER_CLOSED,
+                                   MX_TIME_INFINITE, &pending);
+            if (r < 0) {
+                return r;
+            }
+            if (pending & MX_CHANNEL_READABLE) {
+                continue;
+            }
+            return ERR_PEER_CLOSED;
         }
-        count += r;
-        data += r;
-        len -= r;
-        if (op == MXRIO_WRITE_AT)
-            offset += r;
-        // stop at short read
-        if (r < xfer) {
-            break;
+        if (r < 0) {
+            return r;
         }
+        // read and write replies never carry handles
+        discard_handles(msg->handle, msg->hcount);
+        if (!is_message_reply_valid(msg, dsize) ||
+            (MXRIO_OP(msg->op) != MXRIO_STATUS)) {
+            return ERR_IO;
+        }
+        return NO_ERROR;
     }
-    return count ? count : r;
 }
 
-static ssize_t mxrio_write(mxio_t* io, const void* _data, size_t len) {
-    return write_common(MXRIO_WRITE, io, _data, len, 0);
-}
+// one outstanding pipelined transaction
+typedef struct {
+    mx_txid_t txid;
+    size_t xfer;      // bytes requested by this op
+    size_t idx, off;  // where in the iovec array its data begins
+    ssize_t result;
+    bool done;
+} mxrio_flight_t;
+
+// Multi-chunk reads and writes keep up to MXRIO_MAX_INFLIGHT tagged
+// transactions outstanding on the channel instead of round-tripping one
+// mx_channel_call per chunk, hiding server latency. Replies are matched
+// back to their op by txid, so a multithreaded server may complete them
+// out of order. This coexists with concurrent mx_channel_call transactions
+// from other threads sharing the handle: the kernel routes those replies
+// directly to their callers, so the only messages arriving on the plain
+// read queue are replies to requests this thread wrote.
+//
+// Results are retired in issue order: an error or short transfer stops the
+// byte count there, and any ops already issued past it are drained and
+// their results discarded.
+static ssize_t mxrio_rw_pipelined(mxrio_t* rio, uint32_t op, const struct iovec* iov,
+                                  size_t len, off_t offset) {
+    bool is_read = (MXRIO_OP(op) == MXRIO_READ) || (MXRIO_OP(op) == MXRIO_READ_AT);
+    bool has_offset = (MXRIO_OP(op) == MXRIO_READ_AT) || (MXRIO_OP(op) == MXRIO_WRITE_AT);
+
+    size_t nops = (len + MXIO_CHUNK_SIZE - 1) / MXIO_CHUNK_SIZE;
+    mxrio_flight_t flight[MXRIO_MAX_INFLIGHT];
+    mxrio_msg_t msg;
 
-static ssize_t mxrio_write_at(mxio_t* io, const void* _data, size_t len, mx_off_t offset) {
-    return write_common(MXRIO_WRITE_AT, io, _data, len, offset);
+    size_t next_issue = 0;
+    size_t next_retire = 0;
+    size_t idx = 0;
+    size_t off = 0;
+    size_t remaining = len;
+    ssize_t count = 0;
+    mx_status_t error = 0;
+    bool stop = false;
+
+    while (next_retire < nops) {
+        // keep the window full
+        while (!stop && (next_issue < nops) &&
+               (next_issue - next_retire < MXRIO_MAX_INFLIGHT)) {
+            mxrio_flight_t* f = &flight[next_issue % MXRIO_MAX_INFLIGHT];
+            f->xfer = (remaining > MXIO_CHUNK_SIZE) ? MXIO_CHUNK_SIZE : remaining;
+            f->txid = atomic_fetch_add(&rio->txid, 1);
+            f->idx = idx;
+            f->off = off;
+            f->done = false;
+
+            memset(&msg, 0, MXRIO_HDR_SZ);
+            msg.txid = f->txid;
+            msg.op = op;
+            if (has_offset)
+                msg.arg2.off = offset + (off_t)(len - remaining);
+            if (is_read) {
+                msg.arg = f->xfer;
+            } else {
+                msg.datalen = f->xfer;
+                iov_gather(msg.data, iov, idx, off, f->xfer);
+            }
+
+            mx_status_t r = mx_channel_write(rio->h, 0, &msg,
+                                             MXRIO_HDR_SZ + msg.datalen, NULL, 0);
+            if (r < 0) {
+                if (next_issue == next_retire) {
+                    return count ? count : r;
+                }
+                // drain what's already in flight before reporting
+                error = r;
+                stop = true;
+                break;
+            }
+            iov_advance(iov, &idx, &off, f->xfer);
+            remaining -= f->xfer;
+            next_issue++;
+        }
+
+        if (next_issue == next_retire) {
+            break;
+        }
+
+        // collect one reply; completion may be out of order
+        mx_status_t r = mxrio_read_reply(rio->h, &msg);
+        if (r < 0) {
+            // the channel is unusable; nothing left to drain
+            return count ? count : r;
+        }
+        mxrio_flight_t* f = NULL;
+        for (size_t i = next_retire; i < next_issue; i++) {
+            mxrio_flight_t* candidate = &flight[i % MXRIO_MAX_INFLIGHT];
+            if (!candidate->done && (candidate->txid == msg.txid)) {
+                f = candidate;
+                ssize_t res = msg.arg;
+                if (res >= 0) {
+                    if (((size_t)res > f->xfer) ||
+                        (is_read && (res > (ssize_t)msg.datalen))) {
+                        res = ERR_IO;
+                    } else if (is_read) {
+                        iov_scatter(iov, f->idx, f->off, msg.data, res);
+                    }
+                }
+                f->result = res;
+                f->done = true;
+                break;
+            }
+        }
+        if (f == NULL) {
+            // a reply we never asked for; the stream is corrupt
+            return count ? count : ERR_IO;
+        }
+
+        // retire completed ops in issue order so errors and short transfers
+        // land at the right byte count
+        while ((next_retire < next_issue) &&
+               flight[next_retire % MXRIO_MAX_INFLIGHT].done) {
+            f = &flight[next_retire % MXRIO_MAX_INFLIGHT];
+            next_retire++;
+            if (stop) {
+                // already past an error or short transfer; just draining
+                continue;
+            }
+            if (f->result < 0) {
+                error = f->result;
+                stop = true;
+            } else {
+                count += f->result;
+                if ((size_t)f->result < f->xfer) {
+                    stop = true;
+                }
+            }
+        }
+    }
+
+    return count ? count : error;
 }
 
-static ssize_t read_common(uint32_t op, mxio_t* io, void* _data, size_t len, off_t offset) {
-    mxrio_t* rio = (mxrio_t*)io;
-    uint8_t* data = _data;
+// One transaction at a time via mx_channel_call; used for single-chunk ops
+// and as the fallback when another thread holds the pipeline.
+static ssize_t mxrio_rw_serial(mxrio_t* rio, uint32_t op, const struct iovec* iov,
+                               size_t len, off_t offset) {
+    bool is_read = (MXRIO_OP(op) == MXRIO_READ) || (MXRIO_OP(op) == MXRIO_READ_AT);
+    bool has_offset = (MXRIO_OP(op) == MXRIO_READ_AT) || (MXRIO_OP(op) == MXRIO_WRITE_AT);
+
+    size_t idx = 0;
+    size_t off = 0;
     ssize_t count = 0;
     mx_status_t r = 0;
     mxrio_msg_t msg;
@@ -390,27 +568,33 @@ static ssize_t read_common(uint32_t op, mxio_t* io, void* _data, size_t len, off
 
         memset(&msg, 0, MXRIO_HDR_SZ);
         msg.op = op;
-        msg.arg = xfer;
-        if (op == MXRIO_READ_AT)
+        if (has_offset)
             msg.arg2.off = offset;
+        if (is_read) {
+            msg.arg = xfer;
+        } else {
+            msg.datalen = xfer;
+            iov_gather(msg.data, iov, idx, off, xfer);
+        }
 
         if ((r = mxrio_txn(rio, &msg)) < 0) {
             break;
         }
         discard_handles(msg.handle, msg.hcount);
 
-        if ((r > (int)msg.datalen) || (r > xfer)) {
+        if ((r > xfer) || (is_read && (r > (int)msg.datalen))) {
             r = ERR_IO;
             break;
         }
-        memcpy(data, msg.data, r);
+        if (is_read) {
+            iov_scatter(iov, idx, off, msg.data, r);
+        }
+        iov_advance(iov, &idx, &off, r);
         count += r;
-        data += r;
         len -= r;
-        if (op == MXRIO_READ_AT)
-            offset += r;
+        offset += r;
 
-        // stop at short read
+        // stop at short read or write
         if (r < xfer) {
             break;
         }
@@ -418,12 +602,294 @@ static ssize_t read_common(uint32_t op, mxio_t* io, void* _data, size_t len, off
     return count ? count : r;
 }
 
+static ssize_t mxrio_rw(mxio_t* io, uint32_t op, const struct iovec* iov, int niov,
+                        off_t offset) {
+    mxrio_t* rio = (mxrio_t*)io;
+
+    size_t len = 0;
+    for (int i = 0; i < niov; i++) {
+        len += iov[i].iov_len;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    if (len > MXIO_CHUNK_SIZE) {
+        int busy = 0;
+        if (atomic_compare_exchange_strong(&rio->pipeline_busy, &busy, 1)) {
+            ssize_t r = mxrio_rw_pipelined(rio, op, iov, len, offset);
+            atomic_store(&rio->pipeline_busy, 0);
+            return r;
+        }
+    }
+    return mxrio_rw_serial(rio, op, iov, len, offset);
+}
+
+// Optional readahead/write-behind buffering (see mxio_fd_buffering).
+// While enabled, read()/write()/seek() track the file offset locally and
+// all server io goes through the *_AT ops, so byte-grain consumers pay
+// one round trip per window instead of one per call. When the server
+// provides its file vmo via MXRIO_MMAP, reads bypass the channel
+// entirely; the first write drops the vmo in case it was a snapshot.
+struct mxrio_buffer {
+    mtx_t lock;
+
+    // client-tracked file offset for read()/write()/seek()
+    mx_off_t offset;
+
+    // read fast path: the server's file vmo and the cached file size
+    // used to clamp reads at eof
+    mx_handle_t vmo;
+    uint64_t size;
+
+    // one window over the file: readahead contents, or not-yet-written
+    // data when dirty
+    mx_off_t win_off;
+    size_t win_len;
+    bool dirty;
+    uint8_t win[MXIO_CHUNK_SIZE];
+};
+
+static mx_status_t mxrio_buf_stat_size(mxrio_t* rio, uint64_t* size) {
+    vnattr_t attr;
+    int r = rio->io.ops->misc(&rio->io, MXRIO_STAT, 0, sizeof(attr), &attr, 0);
+    if (r < 0) {
+        return r;
+    }
+    if (r < (int)sizeof(attr)) {
+        return ERR_IO;
+    }
+    *size = attr.size;
+    return NO_ERROR;
+}
+
+static mx_status_t mxrio_buf_flush_locked(mxrio_t* rio) {
+    mxrio_buffer_t* b = rio->buf;
+    if (!b->dirty) {
+        return NO_ERROR;
+    }
+    struct iovec iov = { b->win, b->win_len };
+    ssize_t r = mxrio_rw(&rio->io, MXRIO_WRITE_AT, &iov, 1, b->win_off);
+    if (r < 0) {
+        return r;
+    }
+    if ((size_t)r < b->win_len) {
+        return ERR_IO;
+    }
+    b->dirty = false;
+    b->win_len = 0;
+    return NO_ERROR;
+}
+
+static ssize_t mxrio_buf_read_locked(mxrio_t* rio, uint8_t* data, size_t len, mx_off_t offset) {
+    mxrio_buffer_t* b = rio->buf;
+    mx_status_t r;
+
+    if (b->vmo != MX_HANDLE_INVALID) {
+        if (offset >= b->size) {
+            // maybe the file grew since we cached its size
+            if ((mxrio_buf_stat_size(rio, &b->size) < 0) || (offset >= b->size)) {
+                return 0;
+            }
+        }
+        size_t xfer = len;
+        if (offset + xfer > b->size) {
+            xfer = b->size - offset;
+        }
+        size_t actual;
+        if ((r = mx_vmo_read(b->vmo, data, offset, xfer, &actual)) < 0) {
+            return r;
+        }
+        return actual;
+    }
+
+    size_t count = 0;
+    while (len > 0) {
+        if ((offset >= b->win_off) && (offset < b->win_off + (mx_off_t)b->win_len)) {
+            size_t n = b->win_off + b->win_len - offset;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(data, b->win + (offset - b->win_off), n);
+            data += n;
+            offset += n;
+            len -= n;
+            count += n;
+            continue;
+        }
+        if ((r = mxrio_buf_flush_locked(rio)) < 0) {
+            return count ? (ssize_t)count : r;
+        }
+        if (len >= sizeof(b->win)) {
+            // large residue: not worth staging through the window
+            struct iovec iov = { data, len };
+            ssize_t n = mxrio_rw(&rio->io, MXRIO_READ_AT, &iov, 1, offset);
+            if (n < 0) {
+                return count ? (ssize_t)count : n;
+            }
+            return count + n;
+        }
+        struct iovec iov = { b->win, sizeof(b->win) };
+        ssize_t n = mxrio_rw(&rio->io, MXRIO_READ_AT, &iov, 1, offset);
+        if (n < 0) {
+            return count ? (ssize_t)count : n;
+        }
+        b->win_off = offset;
+        b->win_len = n;
+        if (n == 0) {
+            // eof
+            break;
+        }
+    }
+    return count;
+}
+
+static ssize_t mxrio_buf_write_locked(mxrio_t* rio, const uint8_t* data, size_t len, mx_off_t offset) {
+    mxrio_buffer_t* b = rio->buf;
+    mx_status_t r;
+
+    // the vmo may be a snapshot; first write falls back to rpc io
+    if (b->vmo != MX_HANDLE_INVALID) {
+        mx_handle_close(b->vmo);
+        b->vmo = MX_HANDLE_INVALID;
+    }
+
+    size_t count = 0;
+    while (len > 0) {
+        if (b->dirty && (offset == b->win_off + (mx_off_t)b->win_len) &&
+            (b->win_len < sizeof(b->win))) {
+            size_t n = sizeof(b->win) - b->win_len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(b->win + b->win_len, data, n);
+            b->win_len += n;
+            data += n;
+            offset += n;
+            len -= n;
+            count += n;
+            continue;
+        }
+        if ((r = mxrio_buf_flush_locked(rio)) < 0) {
+            return count ? (ssize_t)count : r;
+        }
+        if (len >= sizeof(b->win)) {
+            struct iovec iov = { (void*)data, len };
+            ssize_t n = mxrio_rw(&rio->io, MXRIO_WRITE_AT, &iov, 1, offset);
+            if (n < 0) {
+                return count ? (ssize_t)count : n;
+            }
+            return count + n;
+        }
+        // start a fresh dirty window at this offset; this also discards
+        // any readahead contents the window held
+        b->win_off = offset;
+        b->win_len = 0;
+        b->dirty = true;
+    }
+    return count;
+}
+
+static ssize_t mxrio_buf_read(mxrio_t* rio, void* data, size_t len, const mx_off_t* at) {
+    mxrio_buffer_t* b = rio->buf;
+    mtx_lock(&b->lock);
+    ssize_t r = mxrio_buf_read_locked(rio, data, len, at ? *at : b->offset);
+    if ((r > 0) && (at == NULL)) {
+        b->offset += r;
+    }
+    mtx_unlock(&b->lock);
+    return r;
+}
+
+static ssize_t mxrio_buf_write(mxrio_t* rio, const void* data, size_t len, const mx_off_t* at) {
+    mxrio_buffer_t* b = rio->buf;
+    mtx_lock(&b->lock);
+    ssize_t r = mxrio_buf_write_locked(rio, data, len, at ? *at : b->offset);
+    if ((r > 0) && (at == NULL)) {
+        b->offset += r;
+    }
+    mtx_unlock(&b->lock);
+    return r;
+}
+
+static ssize_t mxrio_write(mxio_t* io, const void* _data, size_t len) {
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        return mxrio_buf_write(rio, _data, len, NULL);
+    }
+    struct iovec iov = { (void*)_data, len };
+    return mxrio_rw(io, MXRIO_WRITE, &iov, 1, 0);
+}
+
+static ssize_t mxrio_write_at(mxio_t* io, const void* _data, size_t len, mx_off_t offset) {
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        return mxrio_buf_write(rio, _data, len, &offset);
+    }
+    struct iovec iov = { (void*)_data, len };
+    return mxrio_rw(io, MXRIO_WRITE_AT, &iov, 1, offset);
+}
+
 static ssize_t mxrio_read(mxio_t* io, void* _data, size_t len) {
-    return read_common(MXRIO_READ, io, _data, len, 0);
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        return mxrio_buf_read(rio, _data, len, NULL);
+    }
+    struct iovec iov = { _data, len };
+    return mxrio_rw(io, MXRIO_READ, &iov, 1, 0);
 }
 
 static ssize_t mxrio_read_at(mxio_t* io, void* _data, size_t len, mx_off_t offset) {
-    return read_common(MXRIO_READ_AT, io, _data, len, offset);
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        return mxrio_buf_read(rio, _data, len, &offset);
+    }
+    struct iovec iov = { _data, len };
+    return mxrio_rw(io, MXRIO_READ_AT, &iov, 1, offset);
+}
+
+static ssize_t mxrio_readv(mxio_t* io, const struct iovec* iov, int niov) {
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        ssize_t count = 0;
+        for (int i = 0; i < niov; i++) {
+            if (iov[i].iov_len == 0) {
+                continue;
+            }
+            ssize_t r = mxrio_buf_read(rio, iov[i].iov_base, iov[i].iov_len, NULL);
+            if (r < 0) {
+                return count ? count : r;
+            }
+            count += r;
+            if ((size_t)r < iov[i].iov_len) {
+                break;
+            }
+        }
+        return count;
+    }
+    return mxrio_rw(io, MXRIO_READ, iov, niov, 0);
+}
+
+static ssize_t mxrio_writev(mxio_t* io, const struct iovec* iov, int niov) {
+    mxrio_t* rio = (mxrio_t*)io;
+    if (rio->buf != NULL) {
+        ssize_t count = 0;
+        for (int i = 0; i < niov; i++) {
+            if (iov[i].iov_len == 0) {
+                continue;
+            }
+            ssize_t r = mxrio_buf_write(rio, iov[i].iov_base, iov[i].iov_len, NULL);
+            if (r < 0) {
+                return count ? count : r;
+            }
+            count += r;
+            if ((size_t)r < iov[i].iov_len) {
+                break;
+            }
+        }
+        return count;
+    }
+    return mxrio_rw(io, MXRIO_WRITE, iov, niov, 0);
 }
 
 static off_t mxrio_seek(mxio_t* io, off_t offset, int whence) {
@@ -431,6 +897,68 @@ static off_t mxrio_seek(mxio_t* io, off_t offset, int whence) {
     mxrio_msg_t msg;
     mx_status_t r;
 
+    if (rio->buf != NULL) {
+        // buffered fds track the offset locally; only SEEK_END needs
+        // to ask the server anything
+        mxrio_buffer_t* b = rio->buf;
+        mtx_lock(&b->lock);
+        off_t base;
+        switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = b->offset;
+            break;
+        case SEEK_END: {
+            uint64_t size;
+            if ((r = mxrio_buf_stat_size(rio, &size)) < 0) {
+                mtx_unlock(&b->lock);
+                return r;
+            }
+            // an unflushed window may extend the file
+            if (b->dirty && (b->win_off + b->win_len > size)) {
+                size = b->win_off + b->win_len;
+            }
+            base = size;
+            break;
+        }
+        case SEEK_DATA:
+        case SEEK_HOLE: {
+            // hole information lives with the server; push any dirty
+            // window first so it sees the latest data, then query
+            if ((r = mxrio_buf_flush_locked(rio)) < 0) {
+                mtx_unlock(&b->lock);
+                return r;
+            }
+            memset(&msg, 0, MXRIO_HDR_SZ);
+            msg.op = MXRIO_SEEK;
+            msg.arg2.off = offset;
+            msg.arg = whence;
+            if ((r = mxrio_txn(rio, &msg)) < 0) {
+                mtx_unlock(&b->lock);
+                return r;
+            }
+            discard_handles(msg.handle, msg.hcount);
+            b->offset = msg.arg2.off;
+            off_t result = b->offset;
+            mtx_unlock(&b->lock);
+            return result;
+        }
+        default:
+            mtx_unlock(&b->lock);
+            return ERR_INVALID_ARGS;
+        }
+        if (base + offset < 0) {
+            mtx_unlock(&b->lock);
+            return ERR_INVALID_ARGS;
+        }
+        b->offset = base + offset;
+        off_t result = b->offset;
+        mtx_unlock(&b->lock);
+        return result;
+    }
+
     memset(&msg, 0, MXRIO_HDR_SZ);
     msg.op = MXRIO_SEEK;
     msg.arg2.off = offset;
@@ -444,11 +972,91 @@ static off_t mxrio_seek(mxio_t* io, off_t offset, int whence) {
     return msg.arg2.off;
 }
 
+// Enable buffering: pick up the current server-side offset, then try to
+// get the server's file vmo so reads can skip the channel entirely.
+static mx_status_t mxrio_buffering_enable(mxrio_t* rio) {
+    if (rio->buf != NULL) {
+        return NO_ERROR;
+    }
+
+    mxrio_buffer_t* b = calloc(1, sizeof(*b));
+    if (b == NULL) {
+        return ERR_NO_MEMORY;
+    }
+    if (mtx_init(&b->lock, mtx_plain) != thrd_success) {
+        free(b);
+        return ERR_NO_MEMORY;
+    }
+    b->vmo = MX_HANDLE_INVALID;
+
+    off_t off = mxrio_seek(&rio->io, 0, SEEK_CUR);
+    if (off < 0) {
+        free(b);
+        return off;
+    }
+    b->offset = off;
+
+    if (mxrio_buf_stat_size(rio, &b->size) == NO_ERROR) {
+        mxrio_mmap_data_t data = {
+            .offset = 0,
+            .length = b->size,
+            .flags = MXIO_MMAP_FLAG_READ,
+        };
+        ssize_t r = mxrio_misc(&rio->io, MXRIO_MMAP, 0, sizeof(data), &data, sizeof(data));
+        if (r >= 0) {
+            b->vmo = (mx_handle_t)r;
+        }
+        // servers without mmap support just use the readahead window
+    }
+
+    rio->buf = b;
+    return NO_ERROR;
+}
+
+static mx_status_t mxrio_buffering_disable(mxrio_t* rio) {
+    mxrio_buffer_t* b = rio->buf;
+    if (b == NULL) {
+        return NO_ERROR;
+    }
+
+    mtx_lock(&b->lock);
+    mx_status_t r = mxrio_buf_flush_locked(rio);
+    if (r < 0) {
+        mtx_unlock(&b->lock);
+        return r;
+    }
+    if (b->vmo != MX_HANDLE_INVALID) {
+        mx_handle_close(b->vmo);
+    }
+    mx_off_t off = b->offset;
+    rio->buf = NULL;
+    mtx_unlock(&b->lock);
+    free(b);
+
+    // push the locally tracked offset back to the server so unbuffered
+    // read()/write() continue where we left off
+    off_t sr = mxrio_seek(&rio->io, off, SEEK_SET);
+    return (sr < 0) ? (mx_status_t)sr : NO_ERROR;
+}
+
+
 mx_status_t mxrio_close(mxio_t* io) {
     mxrio_t* rio = (mxrio_t*)io;
     mxrio_msg_t msg;
     mx_status_t r;
 
+    if (rio->buf != NULL) {
+        mxrio_buffer_t* b = rio->buf;
+        mtx_lock(&b->lock);
+        mxrio_buf_flush_locked(rio);
+        if (b->vmo != MX_HANDLE_INVALID) {
+            mx_handle_close(b->vmo);
+        }
+        rio->buf = NULL;
+        mtx_unlock(&b->lock);
+        free(b);
+    }
+
     memset(&msg, 0, MXRIO_HDR_SZ);
     msg.op = MXRIO_CLOSE;
 
@@ -548,6 +1156,13 @@ mx_status_t mxio_service_connect(const char* svcpath, mx_handle_t h) {
     if (strncmp("/svc/", svcpath, 5)) {
         return ERR_NOT_FOUND;
     }
+    // Steady-state connects go through the factory cache (service.c),
+    // which turns them into a single pipelined CLONE on a cached channel.
+    // Any miss or error falls back to the full open below, which also
+    // seeds the cache for the next connect.
+    if (mxio_service_cache_connect(mxio_svc_root, svcpath + 5, h) == NO_ERROR) {
+        return NO_ERROR;
+    }
     return mxio_service_connect_at(mxio_svc_root, svcpath + 5, h);
 }
 
@@ -853,11 +1468,48 @@ static void mxrio_wait_end(mxio_t* io, mx_signals_t signals, uint32_t* _events)
     *_events = (signals >> POLL_SHIFT) & POLL_MASK;
 }
 
+// Ask the server for its backing vmo via MXRIO_MMAP, so consumers like
+// mxio_get_vmo (and through it launchpad's ELF loader) can map file
+// pages in place instead of copying the whole file at every use.
+static mx_status_t mxrio_get_vmo(mxio_t* io, mx_handle_t* out, size_t* off, size_t* len) {
+    vnattr_t attr;
+    int r = mxrio_misc(io, MXRIO_STAT, 0, sizeof(attr), &attr, 0);
+    if (r < 0) {
+        return r;
+    }
+    if (r < (int)sizeof(attr)) {
+        return ERR_IO;
+    }
+
+    mxrio_mmap_data_t data = {
+        .offset = 0,
+        .length = attr.size,
+        .flags = MXIO_MMAP_FLAG_READ | MXIO_MMAP_FLAG_EXEC,
+    };
+    ssize_t n = mxrio_misc(io, MXRIO_MMAP, 0, sizeof(data), &data, sizeof(data));
+    if (n < 0) {
+        // servers may refuse executable mappings; settle for read-only
+        data.offset = 0;
+        data.length = attr.size;
+        data.flags = MXIO_MMAP_FLAG_READ;
+        n = mxrio_misc(io, MXRIO_MMAP, 0, sizeof(data), &data, sizeof(data));
+    }
+    if (n < 0) {
+        return (mx_status_t)n;
+    }
+    *out = (mx_handle_t)n;
+    *off = data.offset;
+    *len = data.length;
+    return NO_ERROR;
+}
+
 static mxio_ops_t mx_remote_ops = {
     .read = mxrio_read,
     .read_at = mxrio_read_at,
     .write = mxrio_write,
     .write_at = mxrio_write_at,
+    .readv = mxrio_readv,
+    .writev = mxrio_writev,
     .recvmsg = mxio_default_recvmsg,
     .sendmsg = mxio_default_sendmsg,
     .misc = mxrio_misc,
@@ -870,7 +1522,7 @@ static mxio_ops_t mx_remote_ops = {
     .wait_end = mxrio_wait_end,
     .unwrap = mxrio_unwrap,
     .posix_ioctl = mxio_default_posix_ioctl,
-    .get_vmo = mxio_default_get_vmo,
+    .get_vmo = mxrio_get_vmo,
 };
 
 mxio_t* mxio_remote_create(mx_handle_t h, mx_handle_t e) {
@@ -887,3 +1539,107 @@ mxio_t* mxio_remote_create(mx_handle_t h, mx_handle_t e) {
     rio->h2 = e;
     return &rio->io;
 }
+
+ssize_t mxio_transmit(int socket_fd, int file_fd, off_t offset, size_t count) {
+    if (offset < 0) {
+        return ERR_INVALID_ARGS;
+    }
+    mxio_t* fio = fd_to_io(file_fd);
+    if (fio == NULL) {
+        return ERR_BAD_HANDLE;
+    }
+    mxio_t* sio = fd_to_io(socket_fd);
+    if (sio == NULL) {
+        mxio_release(fio);
+        return ERR_BAD_HANDLE;
+    }
+    mx_status_t r = NO_ERROR;
+    size_t sent = 0;
+    if ((fio->ops != &mx_remote_ops) ||
+        !(sio->flags & MXIO_FLAG_SOCKET) ||
+        !(sio->flags & MXIO_FLAG_SOCKET_CONNECTED)) {
+        r = ERR_NOT_SUPPORTED;
+        goto done;
+    }
+    mxrio_t* frio = (mxrio_t*)fio;
+    mxrio_t* srio = (mxrio_t*)sio;
+
+    // make sure the server sees locally buffered writes
+    if (frio->buf != NULL) {
+        mtx_lock(&frio->buf->lock);
+        r = mxrio_buf_flush_locked(frio);
+        mtx_unlock(&frio->buf->lock);
+        if (r < 0) {
+            goto done;
+        }
+    }
+
+    while (sent < count) {
+        mx_handle_t s;
+        if ((r = mx_handle_duplicate(srio->h2, MX_RIGHT_SAME_RIGHTS, &s)) < 0) {
+            break;
+        }
+        mxrio_msg_t msg;
+        memset(&msg, 0, MXRIO_HDR_SZ);
+        msg.op = MXRIO_TRANSMIT;
+        msg.datalen = sizeof(mxrio_transmit_data_t);
+        mxrio_transmit_data_t* data = (mxrio_transmit_data_t*)msg.data;
+        data->offset = offset + sent;
+        data->length = count - sent;
+        msg.handle[0] = s;
+        msg.hcount = 1;
+
+        r = mxrio_txn(frio, &msg);
+        discard_handles(msg.handle, msg.hcount);
+        if (r == ERR_SHOULD_WAIT) {
+            // the server filled the socket; wait for it to drain
+            if (sio->flags & MXIO_FLAG_NONBLOCK) {
+                break;
+            }
+            mx_signals_t pending;
+            if ((r = mx_object_wait_one(srio->h2, MX_SOCKET_WRITABLE,
+                                        MX_TIME_INFINITE, &pending)) < 0) {
+                break;
+            }
+            continue;
+        }
+        if (r < 0) {
+            break;
+        }
+        if (msg.datalen != sizeof(mxrio_transmit_data_t)) {
+            r = ERR_IO;
+            break;
+        }
+        if (data->length == 0) {
+            // end of file
+            break;
+        }
+        sent += data->length;
+    }
+
+done:
+    mxio_release(sio);
+    mxio_release(fio);
+    if (sent == 0 && r < 0) {
+        return r;
+    }
+    return (ssize_t)sent;
+}
+
+mx_status_t mxio_fd_buffering(int fd, bool enable) {
+    mxio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return ERR_BAD_HANDLE;
+    }
+    mx_status_t r;
+    if (io->ops != &mx_remote_ops) {
+        // other transports don't pay a round trip per call
+        r = ERR_NOT_SUPPORTED;
+    } else if (enable) {
+        r = mxrio_buffering_enable((mxrio_t*)io);
+    } else {
+        r = mxrio_buffering_disable((mxrio_t*)io);
+    }
+    mxio_release(io);
+    return r;
+}
@@ -3,12 +3,18 @@
 // found in the LICENSE file.
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 
+#include <magenta/device/vfs.h>
 #include <magenta/errors.h>
 #include <magenta/syscalls.h>
 
+#include <mxio/remoteio.h>
+
 #include "private.h"
 #include "unistd.h"
 
@@ -86,3 +92,216 @@ mx_status_t mxio_get_service_handle(int fd, mx_handle_t* out) {
         return STATUS(r);
     }
 }
+
+// Factory cache for service connections.
+//
+// The first connect to a service also opens the service vnode itself with
+// O_NOREMOTE, which svcfs serves as a plain rio object instead of handing
+// the channel to the service provider. That channel is kept here as a
+// "factory": a pipelined CLONE minted on it becomes a fresh provider
+// connection, so steady-state connects are a single channel write with no
+// path walk through the service directory.
+//
+// Invalidation is push-based. The cache holds a vfs-watcher channel on the
+// service directory and drains it before every lookup; a watch event naming
+// a cached entry means the service was (re)registered, so the stale factory
+// is dropped and the next connect repopulates it. If the watcher cannot be
+// armed, nothing is cached: a stale factory could otherwise outlive a
+// re-registered service and mint dead connections forever.
+
+#define SVC_CACHE_ENTRIES 16
+
+typedef struct {
+    mx_handle_t factory;
+    char name[MXIO_MAX_FILENAME + 1];
+} svc_cache_entry_t;
+
+static svc_cache_entry_t svc_cache[SVC_CACHE_ENTRIES];
+static mx_handle_t svc_cache_watch = MX_HANDLE_INVALID;
+static mtx_t svc_cache_lock = MTX_INIT;
+
+static void svc_cache_evict_locked(svc_cache_entry_t* entry) {
+    mx_handle_close(entry->factory);
+    entry->factory = MX_HANDLE_INVALID;
+    entry->name[0] = 0;
+}
+
+// Apply any invalidations the server has pushed since the last lookup.
+static void svc_cache_sweep_locked(void) {
+    if (svc_cache_watch == MX_HANDLE_INVALID) {
+        return;
+    }
+    for (;;) {
+        uint8_t evbuf[VFS_WATCH_MSG_MAX];
+        uint32_t sz = sizeof(evbuf);
+        mx_status_t r = mx_channel_read(svc_cache_watch, 0, evbuf, NULL, sz, 0, &sz, NULL);
+        if (r == ERR_SHOULD_WAIT) {
+            return;
+        }
+        if (r < 0) {
+            // watcher died: the server can no longer tell us anything,
+            // so every cached factory is suspect
+            mx_handle_close(svc_cache_watch);
+            svc_cache_watch = MX_HANDLE_INVALID;
+            for (unsigned n = 0; n < SVC_CACHE_ENTRIES; n++) {
+                if (svc_cache[n].factory != MX_HANDLE_INVALID) {
+                    svc_cache_evict_locked(&svc_cache[n]);
+                }
+            }
+            return;
+        }
+        // messages are batches of packed events (see IOCTL_VFS_WATCH_DIR)
+        uint32_t off = 0;
+        while (off + 2 <= sz) {
+            uint32_t nlen = evbuf[off + 1];
+            if (off + 2 + nlen > sz) {
+                break;
+            }
+            const char* name = (const char*)&evbuf[off + 2];
+            off += 2 + nlen;
+            for (unsigned n = 0; n < SVC_CACHE_ENTRIES; n++) {
+                if ((svc_cache[n].factory != MX_HANDLE_INVALID) &&
+                    (strlen(svc_cache[n].name) == nlen) &&
+                    (memcmp(svc_cache[n].name, name, nlen) == 0)) {
+                    svc_cache_evict_locked(&svc_cache[n]);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Obtain a watcher channel on the service directory (IOCTL_VFS_WATCH_DIR
+// over raw rio, since the directory is a bare channel rather than an fd).
+static mx_status_t svc_cache_arm_locked(mx_handle_t svc) {
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.txid = 1;
+    msg.op = MXRIO_IOCTL;
+    msg.arg = sizeof(mx_handle_t);
+    msg.arg2.op = IOCTL_VFS_WATCH_DIR;
+
+    mx_channel_call_args_t args = {
+        .wr_bytes = &msg,
+        .wr_handles = NULL,
+        .rd_bytes = &msg,
+        .rd_handles = msg.handle,
+        .wr_num_bytes = MXRIO_HDR_SZ,
+        .wr_num_handles = 0,
+        .rd_num_bytes = sizeof(msg),
+        .rd_num_handles = MXIO_MAX_HANDLES,
+    };
+    uint32_t dsize;
+    mx_status_t rs = ERR_INTERNAL;
+    mx_status_t r = mx_channel_call(svc, 0, MX_TIME_INFINITE, &args, &dsize, &msg.hcount, &rs);
+    if (r < 0) {
+        return (r == ERR_CALL_FAILED) ? rs : r;
+    }
+    if ((dsize < MXRIO_HDR_SZ) || (MXRIO_OP(msg.op) != MXRIO_STATUS)) {
+        r = ERR_IO;
+    } else if ((r = msg.arg) >= 0) {
+        if (msg.hcount > 0) {
+            svc_cache_watch = msg.handle[0];
+            while (msg.hcount > 1) {
+                mx_handle_close(msg.handle[--msg.hcount]);
+            }
+            return NO_ERROR;
+        }
+        r = ERR_IO;
+    }
+    while (msg.hcount > 0) {
+        mx_handle_close(msg.handle[--msg.hcount]);
+    }
+    return r;
+}
+
+// Open a factory channel for the named service and remember it. Best
+// effort: the open is pipelined, so a bogus name simply yields a factory
+// whose peer closes, which the next lookup detects and evicts.
+static void svc_cache_fill_locked(mx_handle_t svc, const char* name, size_t len) {
+    svc_cache_entry_t* entry = NULL;
+    for (unsigned n = 0; n < SVC_CACHE_ENTRIES; n++) {
+        if (svc_cache[n].factory == MX_HANDLE_INVALID) {
+            entry = &svc_cache[n];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        return;
+    }
+    if ((svc_cache_watch == MX_HANDLE_INVALID) &&
+        (svc_cache_arm_locked(svc) != NO_ERROR)) {
+        return;
+    }
+
+    mx_handle_t cli, srv;
+    if (mx_channel_create(0, &cli, &srv) < 0) {
+        return;
+    }
+
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.op = MXRIO_OPEN;
+    msg.datalen = len;
+    msg.arg = MXRIO_OFLAG_PIPELINE | O_NOREMOTE | O_RDWR;
+    msg.arg2.mode = 0755;
+    msg.hcount = 1;
+    msg.handle[0] = srv;
+    memcpy(msg.data, name, len);
+
+    if (mx_channel_write(svc, 0, &msg, MXRIO_HDR_SZ + msg.datalen, msg.handle, 1) < 0) {
+        mx_handle_close(cli);
+        mx_handle_close(srv);
+        return;
+    }
+
+    entry->factory = cli;
+    memcpy(entry->name, name, len);
+    entry->name[len] = 0;
+}
+
+mx_status_t mxio_service_cache_connect(mx_handle_t svc, const char* name, mx_handle_t h) {
+    size_t len = strlen(name);
+    if ((len == 0) || (len > MXIO_MAX_FILENAME) || (memchr(name, '/', len) != NULL)) {
+        // only leaf services are cached; nested paths take the real walk
+        return ERR_NOT_SUPPORTED;
+    }
+    if (svc == MX_HANDLE_INVALID) {
+        return ERR_UNAVAILABLE;
+    }
+
+    mtx_lock(&svc_cache_lock);
+    svc_cache_sweep_locked();
+
+    svc_cache_entry_t* entry = NULL;
+    for (unsigned n = 0; n < SVC_CACHE_ENTRIES; n++) {
+        if ((svc_cache[n].factory != MX_HANDLE_INVALID) &&
+            (strcmp(svc_cache[n].name, name) == 0)) {
+            entry = &svc_cache[n];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        svc_cache_fill_locked(svc, name, len);
+        mtx_unlock(&svc_cache_lock);
+        return ERR_NOT_FOUND;
+    }
+
+    // Mint a provider connection: pipelined CLONE on the factory. On
+    // failure the caller still owns h and falls back to the slow path.
+    mxrio_msg_t msg;
+    memset(&msg, 0, MXRIO_HDR_SZ);
+    msg.op = MXRIO_CLONE;
+    msg.arg = MXRIO_OFLAG_PIPELINE | O_RDWR;
+    msg.hcount = 1;
+    msg.handle[0] = h;
+
+    mx_status_t r = mx_channel_write(entry->factory, 0, &msg, MXRIO_HDR_SZ, msg.handle, 1);
+    if (r < 0) {
+        // factory went away underneath us (service exited or was replaced
+        // before the watcher told us); repopulate on the next connect
+        svc_cache_evict_locked(entry);
+    }
+    mtx_unlock(&svc_cache_lock);
+    return r;
+}
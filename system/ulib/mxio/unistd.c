@@ -754,6 +754,25 @@ int mxio_status_to_errno(mx_status_t status) {
 // centric posix-y io operations.
 
 ssize_t readv(int fd, const struct iovec* iov, int num) {
+    mxio_t* io = fd_to_io(fd);
+    if (io != NULL && io->ops->readv != NULL) {
+        // transports with a native vectored op can coalesce the whole
+        // iovec array instead of paying one transaction per entry
+        mx_status_t status;
+        for (;;) {
+            status = io->ops->readv(io, iov, num);
+            if (status != ERR_SHOULD_WAIT || io->flags & MXIO_FLAG_NONBLOCK) {
+                break;
+            }
+            mxio_wait_fd(fd, MXIO_EVT_READABLE, NULL, MX_TIME_INFINITE);
+        }
+        mxio_release(io);
+        return STATUS(status);
+    }
+    if (io != NULL) {
+        mxio_release(io);
+    }
+
     ssize_t count = 0;
     ssize_t r;
     while (num > 0) {
@@ -774,6 +793,23 @@ ssize_t readv(int fd, const struct iovec* iov, int num) {
 }
 
 ssize_t writev(int fd, const struct iovec* iov, int num) {
+    mxio_t* io = fd_to_io(fd);
+    if (io != NULL && io->ops->writev != NULL) {
+        mx_status_t status;
+        for (;;) {
+            status = io->ops->writev(io, iov, num);
+            if (status != ERR_SHOULD_WAIT || io->flags & MXIO_FLAG_NONBLOCK) {
+                break;
+            }
+            mxio_wait_fd(fd, MXIO_EVT_WRITABLE, NULL, MX_TIME_INFINITE);
+        }
+        mxio_release(io);
+        return STATUS(status);
+    }
+    if (io != NULL) {
+        mxio_release(io);
+    }
+
     ssize_t count = 0;
     ssize_t r;
     while (num > 0) {
@@ -1325,6 +1361,27 @@ int fdatasync(int fd) {
     return fsync(fd);
 }
 
+int sync_file_range(int fd, off_t offset, off_t nbytes, unsigned flags) {
+    if ((offset < 0) || (nbytes < 0) ||
+        (flags & ~(SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                   SYNC_FILE_RANGE_WAIT_AFTER))) {
+        return ERRNO(EINVAL);
+    }
+    mxio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return ERRNO(EBADF);
+    }
+    // All flag combinations are serviced as a synchronous ranged sync;
+    // the write-and-return-early variants are only a hint.
+    mxrio_sync_range_data_t data;
+    data.offset = offset;
+    // nbytes == 0 means "from offset through the end of the file"
+    data.length = (nbytes == 0) ? UINT64_MAX : (uint64_t)nbytes;
+    int r = STATUS(io->ops->misc(io, MXRIO_SYNC_RANGE, 0, 0, &data, sizeof(data)));
+    mxio_release(io);
+    return r;
+}
+
 int fstat(int fd, struct stat* s) {
     mxio_t* io = fd_to_io(fd);
     if (io == NULL) {
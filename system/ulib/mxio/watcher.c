@@ -17,6 +17,11 @@
 struct mxio_watcher {
     mx_handle_t h;
     bool want_waiting_event;
+    // unconsumed tail of the last notification message; messages are
+    // batches of packed events (see IOCTL_VFS_WATCH_DIR)
+    uint32_t buf_len;
+    uint32_t buf_off;
+    uint8_t buf[VFS_WATCH_MSG_MAX];
 };
 
 mx_status_t mxio_watcher_create(int dirfd, mxio_watcher_t** out) {
@@ -32,15 +37,36 @@ mx_status_t mxio_watcher_create(int dirfd, mxio_watcher_t** out) {
     }
 
     watcher->want_waiting_event = false;
+    watcher->buf_len = 0;
+    watcher->buf_off = 0;
     *out = watcher;
     return NO_ERROR;
 }
 
 mx_status_t mxio_watcher_wait(mxio_watcher_t* watcher, char name[MXIO_MAX_FILENAME + 1]) {
     for (;;) {
+        // hand out the next event batched in the last message, if any
+        while (watcher->buf_off < watcher->buf_len) {
+            uint8_t* evt = watcher->buf + watcher->buf_off;
+            uint32_t nlen = evt[1];
+            if ((watcher->buf_off + 2 + nlen > watcher->buf_len) ||
+                (nlen > MXIO_MAX_FILENAME)) {
+                // malformed batch; drop the remainder of the message
+                watcher->buf_off = watcher->buf_len;
+                break;
+            }
+            watcher->buf_off += 2 + nlen;
+            // only additions are reported today, so any event bit
+            // means a new name
+            memcpy(name, evt + 2, nlen);
+            name[nlen] = 0;
+            return NO_ERROR;
+        }
+
         mx_status_t status;
-        uint32_t sz = MXIO_MAX_FILENAME;
-        if ((status = mx_channel_read(watcher->h, 0, name, NULL, sz, 0, &sz, NULL)) < 0) {
+        uint32_t sz = sizeof(watcher->buf);
+        if ((status = mx_channel_read(watcher->h, 0, watcher->buf, NULL,
+                                      sz, 0, &sz, NULL)) < 0) {
             if (status != ERR_SHOULD_WAIT) {
                 return status;
             }
@@ -55,8 +81,8 @@ mx_status_t mxio_watcher_wait(mxio_watcher_t* watcher, char name[MXIO_MAX_FILENA
             }
             continue;
         }
-        name[sz] = 0;
-        return NO_ERROR;
+        watcher->buf_len = sz;
+        watcher->buf_off = 0;
     }
 }
 
@@ -0,0 +1,434 @@
+// Copyright 2016 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <magenta/assert.h>
+#include <mxtl/macros.h>
+#include <mxtl/type_support.h>
+
+// Implementation Notes:
+//
+// FlatHashTable<> is a non-intrusive, open-addressed alternative to
+// mxtl::HashTable<>.  Where HashTable chains collisions through per-bucket
+// singly linked lists (one dependent pointer load per chain element),
+// FlatHashTable stores its entries in a single contiguous array and resolves
+// collisions with linear probing, so a lookup typically touches one or two
+// cache lines regardless of occupancy.
+//
+// Layout: the table is a single allocation holding an array of entries
+// followed by one metadata byte per slot.  A metadata byte is 0 for an empty
+// slot; for an occupied slot it holds the top bit set plus a 7-bit fragment of
+// the key's hash.  Probes scan the (dense) metadata bytes and only dereference
+// an entry when its hash fragment matches, which filters out nearly all
+// non-matching slots without ever loading them.
+//
+// Erases use backward-shift deletion rather than tombstones: the entries after
+// the erased slot are shifted back toward their home positions, so probe
+// sequences always terminate at a genuinely empty slot and lookup cost does
+// not degrade as entries churn.
+//
+// The table keeps its capacity at a power of two and grows (doubling) once it
+// reaches 75% occupancy.  Operations which may grow the table (insert) return
+// false if the allocation fails; the table is left unchanged in that case.
+//
+// Unlike the intrusive containers, FlatHashTable owns its entries by value.
+// Growth and erase move entries around in memory, so pointers and iterators
+// into the table are invalidated by any mutation.  KeyType and ValueType must
+// be movable; they are moved (never copied) by the container.
+//
+// The default hash traits serve unsigned-integer keys (handle values, vaddrs,
+// koids) and run them through a 64-bit finalizer so that the low bits -- the
+// only ones the power-of-two mask looks at -- carry entropy even for
+// sequential or pointer-aligned keys.  Other key types must supply their own
+// traits, providing:
+//
+// static size_t GetHash(const KeyType& key);
+// static bool   EqualTo(const KeyType& key1, const KeyType& key2);
+namespace mxtl {
+
+template <typename KeyType>
+struct DefaultFlatHashTraits {
+    static_assert(is_unsigned_integer<KeyType>::value,
+                  "DefaultFlatHashTraits only supports unsigned integer keys; "
+                  "supply custom hash traits for other key types.");
+
+    static size_t GetHash(const KeyType& key) {
+        // SplitMix64 finalizer.
+        uint64_t h = static_cast<uint64_t>(key);
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return static_cast<size_t>(h);
+    }
+
+    static bool EqualTo(const KeyType& key1, const KeyType& key2) { return key1 == key2; }
+};
+
+template <typename _KeyType,
+          typename _ValueType,
+          typename _HashTraits = DefaultFlatHashTraits<_KeyType>>
+class FlatHashTable {
+private:
+    // Private fwd decls of the iterator implementation.
+    template <typename IterTraits> class iterator_impl;
+    struct iterator_traits;
+    struct const_iterator_traits;
+
+public:
+    using KeyType       = _KeyType;
+    using ValueType     = _ValueType;
+    using HashTraits    = _HashTraits;
+    using ContainerType = FlatHashTable<KeyType, ValueType, HashTraits>;
+
+    // The unit of storage.  Exposed so that iterators have something
+    // meaningful to dereference.  Mutating the key of an Entry through an
+    // iterator is forbidden (it would corrupt the table).
+    struct Entry {
+        KeyType   key;
+        ValueType value;
+    };
+
+    // Declarations of the standard iterator types.
+    using iterator       = iterator_impl<iterator_traits>;
+    using const_iterator = iterator_impl<const_iterator_traits>;
+
+    // The capacity used by the first allocation; subsequent growth doubles.
+    static constexpr size_t kInitialCapacity = 16;
+
+    constexpr FlatHashTable() { }
+
+    // Rvalue construction/assignment move the table contents; the moved-from
+    // table is left empty.
+    FlatHashTable(FlatHashTable&& other) { swap(other); }
+
+    FlatHashTable& operator=(FlatHashTable&& other) {
+        reset();
+        swap(other);
+        return *this;
+    }
+
+    ~FlatHashTable() { reset(); }
+
+    // Standard begin/end, cbegin/cend iterator accessors.
+    iterator        begin()       { return iterator(this, FirstOccupied()); }
+    const_iterator  begin() const { return const_iterator(this, FirstOccupied()); }
+    const_iterator cbegin() const { return const_iterator(this, FirstOccupied()); }
+
+    iterator          end()       { return iterator(this, capacity_); }
+    const_iterator    end() const { return const_iterator(this, capacity_); }
+    const_iterator   cend() const { return const_iterator(this, capacity_); }
+
+    size_t size()     const { return count_; }
+    size_t capacity() const { return capacity_; }
+    bool   is_empty() const { return count_ == 0; }
+
+    // insert
+    //
+    // Insert the given key/value pair into the table.  The key must not
+    // already be present (this is DEBUG_ASSERTed).  Returns false -- leaving
+    // the table unchanged and dropping the pair -- if the table needed to
+    // grow and the allocation failed.
+    bool insert(KeyType key, ValueType value) {
+        MX_DEBUG_ASSERT(find(key) == nullptr);
+
+        if (!EnsureCapacity())
+            return false;
+
+        Entry incoming = { mxtl::move(key), mxtl::move(value) };
+        InsertEntry(&incoming);
+        ++count_;
+        return true;
+    }
+
+    // find
+    //
+    // Return a pointer to the value stored under the given key, or nullptr if
+    // the key is not present.  The pointer is only valid until the next
+    // mutation of the table.
+    const ValueType* find(const KeyType& key) const {
+        if (count_ == 0)
+            return nullptr;
+
+        const size_t  mask = capacity_ - 1;
+        const size_t  hash = HashTraits::GetHash(key);
+        const uint8_t fp   = Fingerprint(hash);
+
+        size_t ndx = hash & mask;
+        while (metadata_[ndx] != kEmptySlot) {
+            if ((metadata_[ndx] == fp) && HashTraits::EqualTo(entries_[ndx].key, key))
+                return &entries_[ndx].value;
+            ndx = (ndx + 1) & mask;
+        }
+
+        return nullptr;
+    }
+
+    ValueType* find(const KeyType& key) {
+        return const_cast<ValueType*>(
+                const_cast<const FlatHashTable*>(this)->find(key));
+    }
+
+    // erase
+    //
+    // Remove the entry stored under the given key, moving its value into
+    // *removed (if non-null).  Returns true if the key was present.
+    bool erase(const KeyType& key, ValueType* removed = nullptr) {
+        if (count_ == 0)
+            return false;
+
+        const size_t  mask = capacity_ - 1;
+        const size_t  hash = HashTraits::GetHash(key);
+        const uint8_t fp   = Fingerprint(hash);
+
+        size_t ndx = hash & mask;
+        while (metadata_[ndx] != kEmptySlot) {
+            if ((metadata_[ndx] == fp) && HashTraits::EqualTo(entries_[ndx].key, key)) {
+                if (removed)
+                    *removed = mxtl::move(entries_[ndx].value);
+                entries_[ndx].~Entry();
+                metadata_[ndx] = kEmptySlot;
+
+                // Backward-shift deletion: walk the rest of the collision
+                // cluster, moving each entry which probed past the hole back
+                // into it.  This keeps probe sequences gap-free without
+                // tombstones.  The loop must terminate; max load is 75%, so
+                // the cluster always ends in an empty slot.
+                size_t hole = ndx;
+                size_t cur  = (ndx + 1) & mask;
+                while (metadata_[cur] != kEmptySlot) {
+                    const size_t home = HashTraits::GetHash(entries_[cur].key) & mask;
+                    if (((cur - home) & mask) >= ((cur - hole) & mask)) {
+                        new (&entries_[hole]) Entry {
+                            mxtl::move(entries_[cur].key),
+                            mxtl::move(entries_[cur].value)
+                        };
+                        entries_[cur].~Entry();
+                        metadata_[hole] = metadata_[cur];
+                        metadata_[cur]  = kEmptySlot;
+                        hole = cur;
+                    }
+                    cur = (cur + 1) & mask;
+                }
+
+                --count_;
+                return true;
+            }
+            ndx = (ndx + 1) & mask;
+        }
+
+        return false;
+    }
+
+    // clear
+    //
+    // Destroy every entry in the table.  The table's storage is retained.
+    void clear() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (metadata_[i] != kEmptySlot) {
+                entries_[i].~Entry();
+                metadata_[i] = kEmptySlot;
+            }
+        }
+        count_ = 0;
+    }
+
+    // reset
+    //
+    // Destroy every entry in the table and release the table's storage.
+    void reset() {
+        clear();
+        ::free(entries_);
+        entries_  = nullptr;
+        metadata_ = nullptr;
+        capacity_ = 0;
+    }
+
+    // swap : swaps the contents of two tables.
+    void swap(FlatHashTable& other) {
+        pod_swap(entries_,  other.entries_);
+        pod_swap(metadata_, other.metadata_);
+        pod_swap(capacity_, other.capacity_);
+        pod_swap(count_,    other.count_);
+    }
+
+private:
+    // The traits of a non-const iterator
+    struct iterator_traits {
+        using EntryRefType = Entry&;
+        using EntryPtrType = Entry*;
+        using TablePtrType = FlatHashTable*;
+    };
+
+    // The traits of a const iterator
+    struct const_iterator_traits {
+        using EntryRefType = const Entry&;
+        using EntryPtrType = const Entry*;
+        using TablePtrType = const FlatHashTable*;
+    };
+
+    // The shared implementation of the iterator
+    template <class IterTraits>
+    class iterator_impl {
+    public:
+        iterator_impl() { }
+        iterator_impl(const iterator_impl& other) {
+            table_ = other.table_;
+            ndx_   = other.ndx_;
+        }
+
+        iterator_impl& operator=(const iterator_impl& other) {
+            table_ = other.table_;
+            ndx_   = other.ndx_;
+            return *this;
+        }
+
+        bool IsValid() const { return (table_ != nullptr) && (ndx_ < table_->capacity_); }
+        bool operator==(const iterator_impl& other) const {
+            return (table_ == other.table_) && (ndx_ == other.ndx_);
+        }
+        bool operator!=(const iterator_impl& other) const { return !operator==(other); }
+
+        // Prefix
+        iterator_impl& operator++() {
+            if (IsValid())
+                ndx_ = table_->NextOccupied(ndx_);
+            return *this;
+        }
+
+        // Postfix
+        iterator_impl operator++(int) {
+            iterator_impl ret(*this);
+            ++(*this);
+            return ret;
+        }
+
+        typename IterTraits::EntryRefType operator*() const {
+            MX_DEBUG_ASSERT(IsValid());
+            return table_->entries_[ndx_];
+        }
+
+        typename IterTraits::EntryPtrType operator->() const {
+            MX_DEBUG_ASSERT(IsValid());
+            return &table_->entries_[ndx_];
+        }
+
+    private:
+        friend ContainerType;
+
+        iterator_impl(typename IterTraits::TablePtrType table, size_t ndx)
+            : table_(table), ndx_(ndx) { }
+
+        typename IterTraits::TablePtrType table_ = nullptr;
+        size_t ndx_ = 0;
+    };  // class iterator_impl
+
+    // move semantics only
+    DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(FlatHashTable);
+
+    // Metadata byte values.  kEmptySlot marks an unoccupied slot; occupied
+    // slots hold a fingerprint with the top bit set, so the two can never
+    // collide.
+    static constexpr uint8_t kEmptySlot = 0;
+
+    static uint8_t Fingerprint(size_t hash) {
+        // The bucket index comes from the low bits of the hash; take the
+        // fingerprint from the high bits so that the two are independent.
+        return static_cast<uint8_t>(0x80u | ((static_cast<uint64_t>(hash) >> 57) & 0x7fu));
+    }
+
+    template <typename T>
+    static void pod_swap(T& first, T& second) {
+        T tmp  = first;
+        first  = second;
+        second = tmp;
+    }
+
+    size_t FirstOccupied() const { return (count_ == 0) ? capacity_ : NextOccupied(SIZE_MAX); }
+
+    // Return the index of the first occupied slot after |ndx|, or capacity_
+    // if there is none.
+    size_t NextOccupied(size_t ndx) const {
+        for (ndx = ndx + 1; ndx < capacity_; ++ndx) {
+            if (metadata_[ndx] != kEmptySlot)
+                return ndx;
+        }
+        return capacity_;
+    }
+
+    // Make sure there is room for one more entry, growing the table if it is
+    // absent or at its load limit (75%).
+    bool EnsureCapacity() {
+        if (capacity_ == 0)
+            return GrowTable(kInitialCapacity);
+        if (((count_ + 1) * 4) > (capacity_ * 3))
+            return GrowTable(capacity_ << 1);
+        return true;
+    }
+
+    // Move the contents of |*incoming| into the table.  The table must have
+    // at least one empty slot.  The caller is responsible for the count
+    // bookkeeping (growth rehashes do not change the count).
+    void InsertEntry(Entry* incoming) {
+        const size_t mask = capacity_ - 1;
+        const size_t hash = HashTraits::GetHash(incoming->key);
+
+        size_t ndx = hash & mask;
+        while (metadata_[ndx] != kEmptySlot)
+            ndx = (ndx + 1) & mask;
+
+        new (&entries_[ndx]) Entry { mxtl::move(incoming->key), mxtl::move(incoming->value) };
+        metadata_[ndx] = Fingerprint(hash);
+    }
+
+    bool GrowTable(size_t new_capacity) {
+        MX_DEBUG_ASSERT((new_capacity & (new_capacity - 1)) == 0);
+        MX_DEBUG_ASSERT(new_capacity > capacity_);
+
+        // One allocation holds the entry array followed by the metadata
+        // bytes.  malloc's alignment covers any Entry with fundamental
+        // alignment.
+        static_assert(alignof(Entry) <= 2 * sizeof(void*),
+                      "Entry alignment exceeds what the allocator guarantees");
+        const size_t entry_bytes = new_capacity * sizeof(Entry);
+        void* mem = ::malloc(entry_bytes + new_capacity);
+        if (mem == nullptr)
+            return false;
+
+        Entry*   old_entries  = entries_;
+        uint8_t* old_metadata = metadata_;
+        const size_t old_capacity = capacity_;
+
+        entries_  = static_cast<Entry*>(mem);
+        metadata_ = static_cast<uint8_t*>(mem) + entry_bytes;
+        capacity_ = new_capacity;
+        memset(metadata_, kEmptySlot, new_capacity);
+
+        // Migrate the old residents.  The new table is at most half loaded,
+        // so every InsertEntry is guaranteed to find an empty slot.
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_metadata[i] == kEmptySlot)
+                continue;
+            InsertEntry(&old_entries[i]);
+            old_entries[i].~Entry();
+        }
+
+        // The metadata shared the entry array's allocation.
+        ::free(old_entries);
+        return true;
+    }
+
+    Entry*   entries_  = nullptr;
+    uint8_t* metadata_ = nullptr;
+    size_t   capacity_ = 0;
+    size_t   count_    = 0;
+};
+
+}  // namespace mxtl
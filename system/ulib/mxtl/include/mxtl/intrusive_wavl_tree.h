@@ -38,6 +38,14 @@
 // upper_bound(key) : Finds the element (E) in the tree such that E.key > key
 // lower_bound(key) : Finds the element (E) in the tree such that E.key >= key
 //
+// The ordering also enables two bulk operations:
+// insert_back(ptr) : Appends an element known to belong at the right-most
+//    position in O(1) (plus amortized constant rebalancing), allowing a tree
+//    to be built from a pre-sorted ascending run in O(n) total.
+// erase_range(min_key, max_key, fn) : Erases every element whose key lies in
+//    [min_key, max_key), paying a single O(log n) search plus amortized
+//    constant time per removed element.
+//
 // The worst depth of a WAVL tree depends on whether or not the tree has ever
 // been subject to erase operations.
 // ++ If the tree has seen only insert operations, the worst case depth of the
@@ -217,6 +225,66 @@ public:
     void insert(const PtrType& ptr) { insert(PtrType(ptr)); }
     void insert(PtrType&& ptr)      { internal_insert(mxtl::move(ptr)); }
 
+    // insert_back
+    //
+    // Insert the object pointed to by ptr as the new right-most element of
+    // the tree.  The object's key *must* be strictly greater than the key of
+    // every element already in the tree; this is DEBUG_ASSERTed.  Attaching
+    // the node is O(1) (no descent from the root is needed) and post-insert
+    // rebalancing remains amortized constant, so populating a tree from an
+    // ascending pre-sorted run with insert_back costs O(n) overall instead of
+    // the O(n log n) that repeated insert() calls would pay.
+    void insert_back(const PtrType& ptr) { insert_back(PtrType(ptr)); }
+    void insert_back(PtrType&& ptr) {
+        MX_DEBUG_ASSERT(ptr != nullptr);
+
+        auto& ns = NodeTraits::node_state(*ptr);
+        MX_DEBUG_ASSERT(ns.IsValid() && !ns.InContainer());
+
+        // The rank of an inserted node always starts at 0.
+        ns.rank_ = 0;
+
+        // If the tree is currently empty, then this is easy.
+        if (root_ == nullptr) {
+            ns.parent_ = sentinel();
+            ns.left_   = PtrTraits::MakeSentinel(this);
+            ns.right_  = PtrTraits::MakeSentinel(this);
+
+            MX_DEBUG_ASSERT(PtrTraits::IsSentinel(left_most_) &&
+                            PtrTraits::IsSentinel(right_most_));
+            left_most_  = PtrTraits::GetRaw(ptr);
+            right_most_ = PtrTraits::GetRaw(ptr);
+
+            root_ = mxtl::move(ptr);
+
+            ++count_;
+            Observer::RecordInsert();
+            return;
+        }
+
+        // Otherwise, the new node must become the right child of the current
+        // right-most node, taking over its sentinel in the process.
+        RawPtrType parent = right_most_;
+        auto& parent_ns = NodeTraits::node_state(*parent);
+        MX_DEBUG_ASSERT(KeyTraits::LessThan(KeyTraits::GetKey(*parent),
+                                            KeyTraits::GetKey(*ptr)));
+
+        PtrType* owner = &parent_ns.right_;
+        MX_DEBUG_ASSERT(PtrTraits::IsSentinel(*owner));
+        ns.right_   = PtrTraits::Take(*owner);
+        right_most_ = PtrTraits::GetRaw(ptr);
+
+        MX_DEBUG_ASSERT(*owner == nullptr);
+        ns.parent_ = parent;
+        *owner = mxtl::move(ptr);
+
+        ++count_;
+        Observer::RecordInsert();
+
+        // Finally, perform post-insert balance operations.
+        BalancePostInsert(PtrTraits::GetRaw(*owner));
+    }
+
     // insert or find
     //
     // Insert the object pointed to by ptr if it is not already in the
@@ -430,6 +498,38 @@ public:
         return PtrType(nullptr);
     }
 
+    // erase_range
+    //
+    // Erase every element whose key lies in the half-open interval
+    // [min_key, max_key), passing each removed pointer to 'fn'.  Locating the
+    // first element in the range costs O(log n); each subsequent removal is a
+    // direct erase running in amortized constant time, so removing k
+    // contiguous elements costs O(log n + k) instead of the k separate
+    // O(log n) searches which erase-by-key would pay.  Returns the number of
+    // elements erased.
+    template <typename UnaryFn>
+    size_t erase_range(const KeyType& min_key, const KeyType& max_key, UnaryFn fn) {
+        size_t erased = 0;
+
+        iterator iter = lower_bound(min_key);
+        while (iter.IsValid() &&
+               KeyTraits::LessThan(KeyTraits::GetKey(*iter), max_key)) {
+            // Step past the victim before erasing it.  Erase operations (even
+            // those which swap the victim with its in-tree successor) never
+            // move other nodes in memory, so the successor's iterator remains
+            // valid across the erase.
+            iterator next = iter;
+            ++next;
+
+            fn(internal_erase(&(*iter)));
+            ++erased;
+
+            iter = next;
+        }
+
+        return erased;
+    }
+
     // find_if
     //
     // Find the first member of the list which satisfies the predicate given by
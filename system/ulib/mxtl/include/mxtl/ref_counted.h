@@ -45,4 +45,33 @@ public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(RefCounted);
 };
 
+// RefCountedShared<> has exactly the same contract as RefCounted<>, but pads
+// the reference count out to its own cache line.  Use as
+//
+// class JobDispatcher : public RefCountedShared<JobDispatcher> {
+// };
+//
+// Opt in for objects which are long-lived and globally shared (the root job,
+// devmgr's root devices): on such objects, RefPtr churn from many CPUs
+// otherwise ping-pongs the cache line which also holds the object's leading
+// data members, penalizing every reader of those fields.  The padding costs a
+// cache line of memory per object, so this is not the right default for
+// small or numerous types.
+//
+template <typename T>
+class RefCountedShared : public internal::RefCountedPaddedBase {
+public:
+    RefCountedShared() {}
+    ~RefCountedShared() {}
+
+    using internal::RefCountedPaddedBase::AddRef;
+    using internal::RefCountedPaddedBase::Release;
+#if MX_DEBUG_ASSERT_IMPLEMENTED
+    using internal::RefCountedPaddedBase::Adopt;
+#endif
+
+    // RefCountedShared<> instances may not be copied, assigned or moved.
+    DISALLOW_COPY_ASSIGN_AND_MOVE(RefCountedShared);
+};
+
 }  // namespace mxtl
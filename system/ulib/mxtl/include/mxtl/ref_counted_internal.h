@@ -49,5 +49,29 @@ private:
 #endif
 };
 
+// A variant of RefCountedBase which pads the reference count out to a full
+// cache line, so that AddRef/Release churn from many CPUs does not invalidate
+// the line which holds the derived object's leading data members.
+//
+// The count is padded rather than alignas()-aligned: the heap only guarantees
+// fundamental alignment, so an over-aligned base could not safely be
+// allocated with the usual AllocChecker new.  Padding alone is sufficient for
+// the false-sharing problem this solves -- with the base as the first (and
+// only) base class, the derived object's own fields always start a full cache
+// line after the count.
+class RefCountedPaddedBase : public RefCountedBase {
+protected:
+    constexpr RefCountedPaddedBase() : padding_{} {}
+    ~RefCountedPaddedBase() {}
+
+private:
+    // 64 bytes covers the cache line size of every architecture we currently
+    // target (x86-64, arm64, arm).
+    static constexpr size_t kCacheLineSize = 64;
+    static_assert(sizeof(RefCountedBase) < kCacheLineSize,
+                  "RefCountedBase no longer fits in a cache line");
+    char padding_[kCacheLineSize - sizeof(RefCountedBase)] __UNUSED;
+};
+
 }  // namespace internal
 }  // namespace mxtl
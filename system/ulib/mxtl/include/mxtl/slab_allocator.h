@@ -287,7 +287,8 @@ enum class SlabAllocatorFlavor {
 template <typename T,
           size_t   SLAB_SIZE,
           typename LockType,
-          SlabAllocatorFlavor AllocatorFlavor> struct SlabAllocatorTraits;
+          SlabAllocatorFlavor AllocatorFlavor,
+          size_t   MAGAZINE_DEPTH> struct SlabAllocatorTraits;
 template <typename SATraits, typename = void> class SlabAllocator;
 template <typename SATraits, typename = void> class SlabAllocated;
 
@@ -630,11 +631,22 @@ protected:
 //     the object to the allocator it came from.  MANUAL_DELETE allocators are
 //     only permitted for unmanaged pointer types.
 //
+// ++ MAGAZINE_DEPTH
+//  STATIC allocators only.  When non-zero, each thread keeps a private
+//  "magazine" of up to MAGAZINE_DEPTH freed slots and satisfies allocations
+//  from it before touching the allocator's internal lock, so threads which
+//  both allocate and free mostly avoid the shared free list entirely.  A
+//  thread's magazine is flushed back to the central free list when the thread
+//  exits.  Only static allocators may cache per-thread: their storage lives
+//  for the whole process, so a cached slot can never outlive its allocator.
+//  Defaults to 0 (disabled).
+//
 ////////////////////////////////////////////////////////////////////////////////
 template <typename T,
           size_t   _SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
           typename _LockType  = ::mxtl::Mutex,
-          SlabAllocatorFlavor _AllocatorFlavor = SlabAllocatorFlavor::INSTANCED>
+          SlabAllocatorFlavor _AllocatorFlavor = SlabAllocatorFlavor::INSTANCED,
+          size_t   _MAGAZINE_DEPTH = 0>
 struct SlabAllocatorTraits {
     using PtrTraits     = internal::SlabAllocatorPtrTraits<T>;
     using PtrType       = typename PtrTraits::PtrType;
@@ -643,6 +655,7 @@ struct SlabAllocatorTraits {
 
     static constexpr size_t SLAB_SIZE = _SLAB_SIZE;
     static constexpr SlabAllocatorFlavor AllocatorFlavor = _AllocatorFlavor;
+    static constexpr size_t MAGAZINE_DEPTH = _MAGAZINE_DEPTH;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -665,6 +678,11 @@ public:
 
     static constexpr size_t AllocsPerSlab = BaseAllocatorType::AllocsPerSlab;
 
+    // Per-thread magazines are only safe when the allocator's lifetime is the
+    // process's lifetime; see MAGAZINE_DEPTH in the traits documentation.
+    static_assert(SATraits::MAGAZINE_DEPTH == 0,
+                  "Only STATIC slab allocators may use a per-thread magazine!");
+
     explicit SlabAllocator(size_t max_slabs, bool alloc_initial = false)
         : BaseAllocatorType(max_slabs, alloc_initial) { }
 
@@ -798,6 +816,12 @@ public:
 
     template <typename... ConstructorSignature>
     static PtrType New(ConstructorSignature&&... args) {
+        if (SATraits::MAGAZINE_DEPTH > 0u) {
+            void* mem = GetMagazine().Pop();
+            if (mem != nullptr)
+                return PtrTraits::CreatePtr(
+                        ConstructObject(mem, mxtl::forward<ConstructorSignature>(args)...));
+        }
         return allocator_.New(mxtl::forward<ConstructorSignature>(args)...);
     }
 
@@ -812,7 +836,53 @@ private:
         return new (mem) ObjType(mxtl::forward<ConstructorSignature>(args)...);
     }
 
-    static void ReturnToFreeList(void* ptr) { allocator_.ReturnToFreeList(ptr); }
+    static void ReturnToFreeList(void* ptr) {
+        if ((SATraits::MAGAZINE_DEPTH > 0u) && GetMagazine().Push(ptr))
+            return;
+        allocator_.ReturnToFreeList(ptr);
+    }
+
+    // A bounded per-thread cache of freed slots; see MAGAZINE_DEPTH in the
+    // traits documentation.  Slots are raw memory at this point, so their
+    // first word serves as the next link, just as the central free list
+    // overlays a FreeListEntry on freed slots.
+    struct Magazine {
+        ~Magazine() {
+            // The thread is exiting; flush straight to the central free list.
+            while (head_ != nullptr) {
+                void* mem = head_;
+                head_ = *reinterpret_cast<void**>(mem);
+                allocator_.ReturnToFreeList(mem);
+            }
+        }
+
+        void* Pop() {
+            void* mem = head_;
+            if (mem != nullptr) {
+                head_ = *reinterpret_cast<void**>(mem);
+                --count_;
+            }
+            return mem;
+        }
+
+        bool Push(void* mem) {
+            if (count_ >= SATraits::MAGAZINE_DEPTH)
+                return false;
+            *reinterpret_cast<void**>(mem) = head_;
+            head_ = mem;
+            ++count_;
+            return true;
+        }
+
+        void*  head_  = nullptr;
+        size_t count_ = 0u;
+    };
+
+    static Magazine& GetMagazine() {
+        thread_local Magazine magazine;
+        return magazine;
+    }
+
     static InternalAllocatorType allocator_;
 };
 
@@ -846,6 +916,16 @@ template <typename T,
 using UnlockedStaticSlabAllocatorTraits =
     SlabAllocatorTraits<T, SLAB_SIZE, ::mxtl::NullLock, SlabAllocatorFlavor::STATIC>;
 
+// Shorthand for declaring the properties of a static allocator with a
+// per-thread magazine in front of the central free list.
+template <typename T,
+          size_t   SLAB_SIZE = DEFAULT_SLAB_ALLOCATOR_SLAB_SIZE,
+          size_t   MAGAZINE_DEPTH = 16,
+          typename LockType  = ::mxtl::Mutex>
+using MagazineStaticSlabAllocatorTraits =
+    SlabAllocatorTraits<T, SLAB_SIZE, LockType,
+                        SlabAllocatorFlavor::STATIC, MAGAZINE_DEPTH>;
+
 // Shorthand for declaring the global storage required for a static allocator
 #define DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(ALLOC_TRAITS, ...) \
 template<> ::mxtl::SlabAllocator<ALLOC_TRAITS>::InternalAllocatorType \
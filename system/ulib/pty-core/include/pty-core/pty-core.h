@@ -71,6 +71,18 @@ mx_status_t pty_server_send(pty_server_t* ps, const void* data, size_t len, bool
 // ps->lock must be held.
 void pty_server_resume_locked(pty_server_t* ps);
 
+// Drain up to count bytes of bulk output from the active client's
+// shared ring (see IOCTL_PTY_GET_OUT_RING).  Returns the number of
+// bytes copied (0 if there is no active client or no ring).  Applies
+// the low watermark: a flow-controlled client is made writable again
+// once the ring drains far enough.
+// ps->lock must be held.
+size_t pty_server_ring_read_locked(pty_server_t* ps, void* buf, size_t count);
+
+// True if the active client has no shared ring or its ring is empty.
+// ps->lock must be held.
+bool pty_server_ring_is_empty_locked(pty_server_t* ps);
+
 void pty_server_set_window_size(pty_server_t* ps, uint32_t w, uint32_t h);
 
 // device ops for pty_server
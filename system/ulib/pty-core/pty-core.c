@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 #include <threads.h>
@@ -12,6 +13,8 @@
 
 #include <magenta/errors.h>
 #include <magenta/device/pty.h>
+#include <magenta/process.h>
+#include <magenta/syscalls.h>
 
 #if 1
 #define xprintf(fmt...) printf(fmt)
@@ -30,6 +33,10 @@
 #define PTY_CLI_CONTROL     (0x00010000u)
 #define PTY_CLI_ACTIVE      (0x00020000u)
 #define PTY_CLI_PEER_CLOSED (0x00040000u)
+#define PTY_CLI_RING_XOFF   (0x00080000u)
+
+// data bytes in the shared output ring (vmo is one header page larger)
+#define PTY_RING_SIZE (32768u)
 
 struct pty_client {
     mx_device_t* mxdev;
@@ -37,6 +44,12 @@ struct pty_client {
     uint32_t id;
     uint32_t flags;
     pty_fifo_t fifo;
+
+    // shared bulk output ring, if the client requested one
+    // (see IOCTL_PTY_GET_OUT_RING); ring points at the mapped header
+    mx_handle_t ring_vmo;
+    pty_ring_hdr_t* ring;
+
     list_node_t node;
 };
 
@@ -107,6 +120,12 @@ static void pty_make_active_locked(pty_server_t* ps, pty_client_t* pc) {
         ps->active = pc;
         pc->flags |= PTY_CLI_ACTIVE;
         device_state_set(pc->mxdev, DEV_STATE_WRITABLE);
+        if ((pc->ring != NULL) &&
+            (atomic_load_explicit(&pc->ring->head, memory_order_relaxed) !=
+             atomic_load_explicit(&pc->ring->tail, memory_order_relaxed))) {
+            // output queued in the ring while inactive is now readable
+            device_state_set(ps->mxdev, DEV_STATE_READABLE);
+        }
         if (pty_fifo_is_full(&pc->fifo)) {
             device_state_set_clr(ps->mxdev, 0, DEV_STATE_WRITABLE | DEV_STATE_HANGUP);
         } else {
@@ -132,6 +151,137 @@ static void pty_adjust_signals_locked(pty_client_t* pc) {
 }
 
 
+// shared bulk output ring (client -> server)
+
+static mx_status_t pty_client_get_out_ring(pty_server_t* ps, pty_client_t* pc,
+                                           void* out_buf, size_t out_len, size_t* out_actual) {
+    if (out_len != sizeof(mx_handle_t)) {
+        return ERR_INVALID_ARGS;
+    }
+
+    mx_handle_t vmo;
+    mx_status_t status = mx_vmo_create(PTY_RING_DATA_OFFSET + PTY_RING_SIZE, 0, &vmo);
+    if (status != NO_ERROR) {
+        return status;
+    }
+    uintptr_t addr;
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, vmo, 0,
+                              PTY_RING_DATA_OFFSET + PTY_RING_SIZE,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE, &addr)) < 0) {
+        mx_handle_close(vmo);
+        return status;
+    }
+    pty_ring_hdr_t* hdr = (pty_ring_hdr_t*)addr;
+    atomic_init(&hdr->head, 0);
+    atomic_init(&hdr->tail, 0);
+    hdr->size = PTY_RING_SIZE;
+
+    mx_handle_t h;
+    if ((status = mx_handle_duplicate(vmo, MX_RIGHT_SAME_RIGHTS, &h)) < 0) {
+        mx_vmar_unmap(mx_vmar_root_self(), addr, PTY_RING_DATA_OFFSET + PTY_RING_SIZE);
+        mx_handle_close(vmo);
+        return status;
+    }
+
+    mtx_lock(&ps->lock);
+    if (pc->ring != NULL) {
+        mtx_unlock(&ps->lock);
+        mx_handle_close(h);
+        mx_vmar_unmap(mx_vmar_root_self(), addr, PTY_RING_DATA_OFFSET + PTY_RING_SIZE);
+        mx_handle_close(vmo);
+        return ERR_ALREADY_BOUND;
+    }
+    pc->ring_vmo = vmo;
+    pc->ring = hdr;
+    mtx_unlock(&ps->lock);
+
+    xprintf("pty cli %p (id=%u) out ring created\n", pc, pc->id);
+
+    *((mx_handle_t*)out_buf) = h;
+    *out_actual = sizeof(mx_handle_t);
+    return NO_ERROR;
+}
+
+static mx_status_t pty_client_ring_kick(pty_server_t* ps, pty_client_t* pc) {
+    mtx_lock(&ps->lock);
+    if (pc->ring == NULL) {
+        mtx_unlock(&ps->lock);
+        return ERR_BAD_STATE;
+    }
+    uint32_t head = atomic_load_explicit(&pc->ring->head, memory_order_acquire);
+    uint32_t used = head - atomic_load_explicit(&pc->ring->tail, memory_order_relaxed);
+    if (used > PTY_RING_SIZE) {
+        // the shared indices are damaged; drop everything rather than
+        // letting the server read wild lengths
+        atomic_store_explicit(&pc->ring->tail, head, memory_order_release);
+        mtx_unlock(&ps->lock);
+        return ERR_IO_DATA_INTEGRITY;
+    }
+    if (used && (pc->flags & PTY_CLI_ACTIVE)) {
+        device_state_set(ps->mxdev, DEV_STATE_READABLE);
+    }
+    if (used >= PTY_RING_HIGH_WATER(PTY_RING_SIZE)) {
+        // flow control: the client stays unwritable until the server
+        // drains below the low watermark
+        pc->flags |= PTY_CLI_RING_XOFF;
+        device_state_clr(pc->mxdev, DEV_STATE_WRITABLE);
+    }
+    mtx_unlock(&ps->lock);
+    return NO_ERROR;
+}
+
+size_t pty_server_ring_read_locked(pty_server_t* ps, void* buf, size_t count) {
+    pty_client_t* pc = ps->active;
+    if ((pc == NULL) || (pc->ring == NULL)) {
+        return 0;
+    }
+    pty_ring_hdr_t* r = pc->ring;
+
+    // Load head exactly once -- the client may be appending concurrently
+    // and a re-read would be a double fetch.  The acquire pairs with the
+    // client's release store of head, making the bytes it published
+    // visible before we copy them.  Lengths are validated against our own
+    // PTY_RING_SIZE, never the (client-writable) header copy.
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t avail = head - tail;
+    if (avail > PTY_RING_SIZE) {
+        atomic_store_explicit(&r->tail, head, memory_order_release);
+        return 0;
+    }
+    if (count > avail) {
+        count = avail;
+    }
+
+    uint8_t* data = (uint8_t*)r + PTY_RING_DATA_OFFSET;
+    uint32_t offset = tail & (PTY_RING_SIZE - 1);
+    size_t run = PTY_RING_SIZE - offset;
+    if (count <= run) {
+        memcpy(buf, data + offset, count);
+    } else {
+        memcpy(buf, data + offset, run);
+        memcpy((uint8_t*)buf + run, data, count - run);
+    }
+    // release: the client may reuse the space only after our copies above
+    tail += count;
+    atomic_store_explicit(&r->tail, tail, memory_order_release);
+
+    if ((pc->flags & PTY_CLI_RING_XOFF) &&
+        ((head - tail) < PTY_RING_LOW_WATER(PTY_RING_SIZE))) {
+        pc->flags &= ~PTY_CLI_RING_XOFF;
+        device_state_set(pc->mxdev, DEV_STATE_WRITABLE);
+    }
+    return count;
+}
+
+bool pty_server_ring_is_empty_locked(pty_server_t* ps) {
+    pty_client_t* pc = ps->active;
+    return (pc == NULL) || (pc->ring == NULL) ||
+           (atomic_load_explicit(&pc->ring->head, memory_order_relaxed) ==
+            atomic_load_explicit(&pc->ring->tail, memory_order_relaxed));
+}
+
+
 static mx_status_t pty_client_ioctl(void* ctx, uint32_t op,
                                 const void* in_buf, size_t in_len,
                                 void* out_buf, size_t out_len, size_t* out_actual) {
@@ -202,6 +352,10 @@ static mx_status_t pty_client_ioctl(void* ctx, uint32_t op,
         *out_actual = sizeof(uint32_t);
         return NO_ERROR;
     }
+    case IOCTL_PTY_GET_OUT_RING:
+        return pty_client_get_out_ring(ps, pc, out_buf, out_len, out_actual);
+    case IOCTL_PTY_OUT_RING_KICK:
+        return pty_client_ring_kick(ps, pc);
     default:
         if (ps->ioctl != NULL) {
             return ps->ioctl(ps, op, in_buf, in_len, out_buf, out_len, out_actual);
@@ -247,6 +401,12 @@ static void pty_client_release(void* ctx) {
         }
     }
 
+    if (pc->ring != NULL) {
+        mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)pc->ring,
+                      PTY_RING_DATA_OFFSET + PTY_RING_SIZE);
+        mx_handle_close(pc->ring_vmo);
+    }
+
     xprintf("pty cli %p (id=%u) release\n", pc, pc->id);
     free(pc);
 }
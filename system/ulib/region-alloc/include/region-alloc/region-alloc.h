@@ -218,6 +218,20 @@ static inline const ralloc_region_t* ralloc_get_specific_region(
 size_t ralloc_get_allocated_region_count(const ralloc_allocator_t* allocator);
 size_t ralloc_get_available_region_count(const ralloc_allocator_t* allocator);
 
+// Fragmentation statistics for an allocator.  The byte/size figures are a
+// snapshot of the current available set; the split/coalesce figures are
+// lifetime counters which, observed over time, indicate how badly the
+// available space is fragmenting (many splits, few coalesces) or how well it
+// is healing (the reverse).
+typedef struct ralloc_stats {
+    uint64_t avail_bytes;       // total bytes currently available for allocation
+    uint64_t largest_avail;     // size of the largest single available region
+    uint64_t split_count;       // lifetime count of regions split by allocation
+    uint64_t coalesce_count;    // lifetime count of regions merged on release
+} ralloc_stats_t;
+
+void ralloc_get_stats(const ralloc_allocator_t* allocator, ralloc_stats_t* out_stats);
+
 // RegionAllocator::Region interface.  In addition to the base/size members
 // which may be used to determine the location of the allocation,  valid
 // operations are...
@@ -473,6 +487,10 @@ public:
         return avail_regions_by_base_.size();
     }
 
+    // Fetch a snapshot of the allocator's fragmentation statistics.  See the
+    // ralloc_stats_t definition above for the meaning of each field.
+    void GetStats(ralloc_stats_t* out_stats) const;
+
 private:
     mx_status_t AddSubtractSanityCheckLocked(const ralloc_region_t& region);
     void ReleaseRegion(Region* region);
@@ -501,6 +519,8 @@ private:
     Region::WAVLTreeSortByBase avail_regions_by_base_;
     Region::WAVLTreeSortBySize avail_regions_by_size_;
     RegionPool::RefPtr region_pool_;
+    uint64_t split_count_ = 0;
+    uint64_t coalesce_count_ = 0;
 };
 
 // If this is C++, clear out this pre-processor constant.  People can get to the
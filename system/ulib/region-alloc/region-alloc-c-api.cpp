@@ -157,6 +157,12 @@ size_t ralloc_get_available_region_count(const ralloc_allocator_t* allocator) {
     return alloc.AvailableRegionCount();
 }
 
+void ralloc_get_stats(const ralloc_allocator_t* allocator, ralloc_stats_t* out_stats) {
+    MX_DEBUG_ASSERT((allocator != nullptr) && (out_stats != nullptr));
+    const RegionAllocator& alloc = *(reinterpret_cast<const RegionAllocator*>(allocator));
+    alloc.GetStats(out_stats);
+}
+
 void ralloc_put_region(const ralloc_region_t* region) {
     MX_DEBUG_ASSERT(region);
 
@@ -371,6 +371,22 @@ mx_status_t RegionAllocator::GetRegion(const ralloc_region_t& requested_region,
     return AllocFromAvailLocked(by_size_iter, out_region, base, size);
 }
 
+void RegionAllocator::GetStats(ralloc_stats_t* out_stats) const {
+    MX_DEBUG_ASSERT(out_stats != nullptr);
+    mxtl::AutoLock alloc_lock(&alloc_lock_);
+
+    uint64_t avail_bytes = 0;
+    for (const auto& region : avail_regions_by_base_)
+        avail_bytes += region.size;
+
+    out_stats->avail_bytes    = avail_bytes;
+    out_stats->largest_avail  = avail_regions_by_size_.is_empty()
+                              ? 0
+                              : avail_regions_by_size_.back().size;
+    out_stats->split_count    = split_count_;
+    out_stats->coalesce_count = coalesce_count_;
+}
+
 mx_status_t RegionAllocator::AddSubtractSanityCheckLocked(const ralloc_region_t& region) {
     // Check our RegionPool
     if (region_pool_ == nullptr)
@@ -503,6 +519,10 @@ mx_status_t RegionAllocator::AllocFromAvailLocked(Region::WAVLTreeSortBySize::it
 
         out_region.reset(region);
     }
+
+    // Record how many new available fragments this allocation produced.
+    split_count_ += (split_before ? 1 : 0) + (split_after ? 1 : 0);
+
     return NO_ERROR;
 }
 
@@ -533,6 +553,7 @@ void RegionAllocator::AddRegionToAvailLocked(Region* region, bool allow_overlap)
             avail_regions_by_size_.erase(*removed);
             MX_DEBUG_ASSERT(region_pool_ != nullptr);
             region_pool_->Delete(removed);
+            coalesce_count_++;
         }
     }
 
@@ -552,6 +573,7 @@ void RegionAllocator::AddRegionToAvailLocked(Region* region, bool allow_overlap)
         avail_regions_by_size_.erase(*removed);
         MX_DEBUG_ASSERT(region_pool_ != nullptr);
         region_pool_->Delete(removed);
+        coalesce_count_++;
 
         if (!allow_overlap)
             break;
@@ -4,6 +4,7 @@
 
 #include <svcfs/svcfs.h>
 
+#include <fcntl.h>
 #include <string.h>
 
 #include <magenta/new.h>
@@ -93,6 +94,15 @@ mx_status_t VnodeSvc::Serve(mx_handle_t h, uint32_t flags) {
         return ERR_UNAVAILABLE;
     }
 
+    if (flags & O_NOREMOTE) {
+        // Factory connection: serve the vnode itself rather than handing
+        // the channel to the provider. O_NOREMOTE is stripped from the io
+        // state, so every CLONE minted on this connection takes the branch
+        // below and becomes a provider connection -- without repeating the
+        // path walk through the service directory.
+        return fs::Vnode::Serve(h, flags & ~O_NOREMOTE);
+    }
+
     provider_->Connect(name_.get(), name_.size(), mx::channel(h));
     return NO_ERROR;
 }
@@ -0,0 +1,41 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/types.h>
+#include <magenta/compiler.h>
+
+#include <stdatomic.h>
+
+__BEGIN_CDECLS;
+
+// An adaptive futex-backed mutex: contended acquires briefly spin with
+// exponential backoff before parking in the kernel, so short critical
+// sections are usually resolved without a syscall. The spin budget is
+// sized once at runtime from the cpu count (no spinning on a single
+// cpu), and a waiter that finds others already parked in the kernel
+// parks immediately instead of jumping the queue.
+typedef struct {
+    atomic_int futex;
+} sync_mutex_t;
+
+#define SYNC_MUTEX_INIT ((sync_mutex_t){})
+
+// Attempts to take the lock without blocking. Returns NO_ERROR if the
+// lock is obtained, and ERR_BAD_STATE if not.
+mx_status_t sync_mutex_trylock(sync_mutex_t* mutex);
+
+// Attempts to take the lock before the timeout expires. This takes an
+// absolute time. Returns NO_ERROR if the lock is acquired, and
+// ERR_TIMED_OUT if the timeout expires.
+mx_status_t sync_mutex_timedlock(sync_mutex_t* mutex, mx_time_t abstime);
+
+// Blocks until the lock is obtained.
+void sync_mutex_lock(sync_mutex_t* mutex);
+
+// Unlocks the lock.
+void sync_mutex_unlock(sync_mutex_t* mutex);
+
+__END_CDECLS;
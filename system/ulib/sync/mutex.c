@@ -0,0 +1,172 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <sync/mutex.h>
+
+#include <magenta/syscalls.h>
+#include <stdatomic.h>
+
+// This is the same three-state futex mutex as mxr_mutex (see
+// system/ulib/runtime/mutex.c and Ulrich Drepper's "Futexes Are Tricky",
+// "Mutex, Take 2"), with an adaptive twist: a contended acquire spins
+// with exponential backoff for a bounded number of iterations before
+// parking in the kernel with mx_futex_wait().  Most critical sections
+// guarded by userspace mutexes are short, so the holder usually releases
+// the lock while we spin and the futex syscall is avoided entirely.
+
+// The value of UNLOCKED must be 0 so that mutexes can be allocated in BSS
+// segments (zero-initialized data).
+enum {
+    UNLOCKED = 0,
+    LOCKED_WITHOUT_WAITERS = 1,
+    LOCKED_WITH_WAITERS = 2
+};
+
+// Maximum delay, in pause iterations, between successive polls of the
+// futex state while spinning.
+#define MAX_SPIN_BACKOFF 64
+
+static void spin_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("pause" ::: "memory");
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ volatile("yield" ::: "memory");
+#else
+    atomic_thread_fence(memory_order_seq_cst);
+#endif
+}
+
+// Returns the number of state polls a contended acquire may make before
+// parking in the kernel.  Spinning only helps if the lock holder can
+// make progress on another cpu, so the budget is zero on a single-cpu
+// system.  The cpu count is read once and cached; the cache stores
+// budget + 1 so that 0 means "not yet initialized".
+static int spin_budget(void) {
+    static atomic_int cached_budget = 0;
+    int budget = atomic_load_explicit(&cached_budget, memory_order_relaxed);
+    if (budget == 0) {
+        uint32_t num_cpus = _mx_system_get_num_cpus();
+        if (num_cpus > 16)
+            num_cpus = 16;
+        budget = (num_cpus > 1) ? (int)(100u * num_cpus) : 0;
+        atomic_store_explicit(&cached_budget, budget + 1,
+                              memory_order_relaxed);
+        return budget;
+    }
+    return budget - 1;
+}
+
+// Spins waiting for the mutex to be released.  Returns the last observed
+// state.  Gives up early if other waiters have already parked in the
+// kernel (LOCKED_WITH_WAITERS): spinning past them would let later
+// arrivals starve threads already in the wait queue.
+static int spin_for_mutex(sync_mutex_t* mutex) {
+    int old_state = UNLOCKED;
+    int backoff = 1;
+    for (int spins = spin_budget(); spins > 0; spins -= backoff) {
+        old_state = atomic_load_explicit(&mutex->futex, memory_order_relaxed);
+        if (old_state != LOCKED_WITHOUT_WAITERS)
+            return old_state;
+        for (int i = 0; i < backoff; i++)
+            spin_pause();
+        if (backoff < MAX_SPIN_BACKOFF)
+            backoff <<= 1;
+    }
+    return atomic_load_explicit(&mutex->futex, memory_order_relaxed);
+}
+
+// On success, this will leave the mutex in the LOCKED_WITH_WAITERS state.
+static mx_status_t lock_slow_path(sync_mutex_t* mutex, mx_time_t abstime,
+                                  int old_state) {
+    for (;;) {
+        // Spin briefly in the hope that the holder releases the mutex
+        // before we have to enter the kernel.
+        if (old_state == LOCKED_WITHOUT_WAITERS) {
+            old_state = spin_for_mutex(mutex);
+            if (old_state == UNLOCKED) {
+                // The mutex was released while we were spinning.  Since we
+                // never parked, we may claim it without forcing the
+                // contended state.  On failure the CAS updates old_state
+                // and we fall through to the wait path.
+                if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                                   LOCKED_WITHOUT_WAITERS)) {
+                    return NO_ERROR;
+                }
+            }
+        }
+
+        // If the state shows there are already waiters, or we can update
+        // it to indicate that there are waiters, then wait.
+        if (old_state == LOCKED_WITH_WAITERS ||
+            (old_state == LOCKED_WITHOUT_WAITERS &&
+             atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                            LOCKED_WITH_WAITERS))) {
+            mx_status_t status = _mx_futex_wait(
+                    &mutex->futex, LOCKED_WITH_WAITERS, abstime);
+            if (status == ERR_TIMED_OUT)
+                return ERR_TIMED_OUT;
+        }
+
+        // Try again to claim the mutex.  On this try, we must set the
+        // mutex state to LOCKED_WITH_WAITERS rather than
+        // LOCKED_WITHOUT_WAITERS.  This is because we could have been
+        // woken up when many threads are in the wait queue for the mutex.
+        old_state = UNLOCKED;
+        if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                           LOCKED_WITH_WAITERS)) {
+            return NO_ERROR;
+        }
+    }
+}
+
+mx_status_t sync_mutex_trylock(sync_mutex_t* mutex) {
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                       LOCKED_WITHOUT_WAITERS)) {
+        return NO_ERROR;
+    }
+    return ERR_BAD_STATE;
+}
+
+mx_status_t sync_mutex_timedlock(sync_mutex_t* mutex, mx_time_t abstime) {
+    // Try to claim the mutex.  This compare-and-swap executes the full
+    // memory barrier that locking a mutex is required to execute.
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                       LOCKED_WITHOUT_WAITERS)) {
+        return NO_ERROR;
+    }
+    return lock_slow_path(mutex, abstime, old_state);
+}
+
+void sync_mutex_lock(sync_mutex_t* mutex) {
+    mx_status_t status = sync_mutex_timedlock(mutex, MX_TIME_INFINITE);
+    if (status != NO_ERROR)
+        __builtin_trap();
+}
+
+void sync_mutex_unlock(sync_mutex_t* mutex) {
+    // Attempt to release the mutex.  This atomic swap executes the full
+    // memory barrier that unlocking a mutex is required to execute.
+    int old_state = atomic_exchange(&mutex->futex, UNLOCKED);
+    switch (old_state) {
+        case LOCKED_WITHOUT_WAITERS:
+            // There were no waiters, so there is nothing more to do.
+            break;
+
+        case LOCKED_WITH_WAITERS: {
+            mx_status_t status = _mx_futex_wake(&mutex->futex, 1);
+            if (status != NO_ERROR)
+                __builtin_trap();
+            break;
+        }
+
+        case UNLOCKED:
+        default:
+            // Either the mutex was unlocked (in which case the unlock call
+            // was invalid), or the mutex was in an invalid state.
+            __builtin_trap();
+            break;
+    }
+}
@@ -0,0 +1,488 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <task/executor.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <magenta/listnode.h>
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
+#include <mxio/private.h>
+
+// Worker structure:
+//
+// Every worker owns a bounded Chase-Lev deque: the owner pushes and pops
+// at the bottom with plain atomics, thieves race a compare-and-swap at
+// the top.  Posting from a worker thread lands on that worker's own
+// deque; posting from outside goes through a mutex-protected injection
+// list, which workers drain in batches so the lock is off the per-task
+// path.  An idle worker first tries to steal from its peers and only
+// then parks in mx_port_wait() on the shared port, with its deadline
+// clamped to the earliest pending timer.
+//
+// The port carries three kinds of packets: user packets with KEY_WAKE
+// (work was injected while workers were parked), user packets with
+// KEY_SHUTDOWN, and MX_PKT_TYPE_SIGNAL_ONE packets whose key is the
+// pointer to a pending fd-wait task.
+
+#define DEQUE_SIZE 256u // power of two
+
+#define KEY_WAKE 0u
+#define KEY_SHUTDOWN 1u
+
+// Timer wheel geometry: insertions hash into a slot by expiry tick so
+// they stay O(1); deadlines beyond the horizon sit in an overflow list
+// until the wheel catches up.
+#define WHEEL_SLOTS 64u
+#define WHEEL_TICK MX_MSEC(10)
+#define WHEEL_HORIZON (WHEEL_SLOTS * WHEEL_TICK)
+
+typedef struct task {
+    list_node_t node;
+    task_handler_t func;
+    void* cookie;
+    // Timed tasks only.
+    mx_time_t deadline;
+    // fd waits only.
+    mxio_t* io;
+    int fd;
+    task_fd_handler_t fd_func;
+} task_t;
+
+typedef struct worker {
+    thrd_t thread;
+    task_executor_t* executor;
+    uint32_t index;
+    // Chase-Lev deque of task_t*.  Signed so bottom may transiently run
+    // one below top in deque_pop().
+    atomic_llong top;
+    atomic_llong bottom;
+    atomic_uintptr_t slot[DEQUE_SIZE];
+} worker_t;
+
+struct task_executor {
+    mx_handle_t port;
+    uint32_t num_workers;
+    atomic_bool shutdown;
+    atomic_int num_parked;
+
+    // Injection queue for posts from non-worker threads.
+    mtx_t inject_lock;
+    list_node_t inject_list;
+
+    // Timer wheel, guarded by timer_lock.  next_deadline caches the
+    // earliest pending expiry (MX_TIME_INFINITE when the wheel is empty)
+    // so parking workers can read their wait deadline cheaply.
+    mtx_t timer_lock;
+    list_node_t wheel[WHEEL_SLOTS];
+    list_node_t timer_overflow;
+    mx_time_t next_deadline;
+
+    worker_t workers[];
+};
+
+// Set on worker threads so task_executor_post() can use the local deque.
+static thread_local worker_t* tls_worker;
+
+// Owner-side push.  Fails when the deque is full; callers fall back to
+// the injection queue.
+static bool deque_push(worker_t* w, task_t* task) {
+    long long b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    if (b - t >= (long long)DEQUE_SIZE)
+        return false;
+    atomic_store_explicit(&w->slot[b & (DEQUE_SIZE - 1)], (uintptr_t)task,
+                          memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+// Owner-side pop from the bottom.  Races thieves only for the final
+// element, which is resolved with the same CAS on top that thieves use.
+static task_t* deque_pop(worker_t* w) {
+    long long b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    task_t* task = NULL;
+    if (t <= b) {
+        task = (task_t*)atomic_load_explicit(&w->slot[b & (DEQUE_SIZE - 1)],
+                                             memory_order_relaxed);
+        if (t == b) {
+            if (!atomic_compare_exchange_strong(&w->top, &t, t + 1))
+                task = NULL;
+            atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+// Thief-side steal from the top.
+static task_t* deque_steal(worker_t* w) {
+    long long t = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if (t >= b)
+        return NULL;
+    task_t* task = (task_t*)atomic_load_explicit(&w->slot[t & (DEQUE_SIZE - 1)],
+                                                 memory_order_relaxed);
+    if (!atomic_compare_exchange_strong(&w->top, &t, t + 1))
+        return NULL;
+    return task;
+}
+
+static void post_user_packet(task_executor_t* ex, uint64_t key) {
+    mx_port_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.key = key;
+    packet.type = MX_PKT_TYPE_USER;
+    mx_port_queue(ex->port, &packet, 0);
+}
+
+// Wakes one parked worker if any are parked.  Posting unconditionally
+// would fill the port with stale wake packets under load.
+static void wake_one(task_executor_t* ex) {
+    if (atomic_load(&ex->num_parked) > 0)
+        post_user_packet(ex, KEY_WAKE);
+}
+
+static void inject(task_executor_t* ex, task_t* task) {
+    mtx_lock(&ex->inject_lock);
+    list_add_tail(&ex->inject_list, &task->node);
+    mtx_unlock(&ex->inject_lock);
+    wake_one(ex);
+}
+
+// Moves a batch of injected tasks onto |w|'s deque and returns one to
+// run, so the injection lock is taken once per batch rather than once
+// per task.
+static task_t* take_injected(task_executor_t* ex, worker_t* w) {
+    mtx_lock(&ex->inject_lock);
+    task_t* first = list_remove_head_type(&ex->inject_list, task_t, node);
+    if (first) {
+        task_t* task;
+        while ((task = list_remove_head_type(&ex->inject_list, task_t, node)) != NULL) {
+            if (!deque_push(w, task)) {
+                list_add_head(&ex->inject_list, &task->node);
+                break;
+            }
+        }
+    }
+    mtx_unlock(&ex->inject_lock);
+    return first;
+}
+
+static task_t* steal(task_executor_t* ex, worker_t* self) {
+    // Start at the next worker over so thieves spread out instead of
+    // all hammering worker 0.
+    for (uint32_t i = 1; i < ex->num_workers; i++) {
+        worker_t* victim = &ex->workers[(self->index + i) % ex->num_workers];
+        task_t* task = deque_steal(victim);
+        if (task)
+            return task;
+    }
+    return NULL;
+}
+
+static uint32_t wheel_slot(mx_time_t deadline) {
+    return (uint32_t)((deadline / WHEEL_TICK) % WHEEL_SLOTS);
+}
+
+// Pulls one expired timer off the wheel, promoting overflow entries
+// that have come within the horizon.  Recomputes next_deadline from
+// what remains.  Returns NULL when nothing has expired.
+static task_t* timer_service(task_executor_t* ex) {
+    mtx_lock(&ex->timer_lock);
+    mx_time_t now = mx_time_get(MX_CLOCK_MONOTONIC);
+
+    task_t* task;
+    task_t* temp;
+    list_for_every_entry_safe (&ex->timer_overflow, task, temp, task_t, node) {
+        if (task->deadline < now + WHEEL_HORIZON) {
+            list_delete(&task->node);
+            list_add_tail(&ex->wheel[wheel_slot(task->deadline)], &task->node);
+        }
+    }
+
+    task_t* expired = NULL;
+    mx_time_t earliest = MX_TIME_INFINITE;
+    for (uint32_t i = 0; i < WHEEL_SLOTS && !expired; i++) {
+        list_for_every_entry (&ex->wheel[i], task, task_t, node) {
+            if (task->deadline <= now) {
+                list_delete(&task->node);
+                expired = task;
+                break;
+            }
+            if (task->deadline < earliest)
+                earliest = task->deadline;
+        }
+    }
+    if (expired) {
+        // More may have expired with it; leave next_deadline in the
+        // past so the next idle worker comes straight back here.
+        earliest = now;
+    } else {
+        list_for_every_entry (&ex->timer_overflow, task, task_t, node) {
+            if (task->deadline < earliest)
+                earliest = task->deadline;
+        }
+    }
+    ex->next_deadline = earliest;
+    mtx_unlock(&ex->timer_lock);
+    return expired;
+}
+
+static void run_task(task_t* task) {
+    task->func(task->cookie);
+    free(task);
+}
+
+static void run_fd_task(task_t* task, const mx_packet_signal_t* signal) {
+    uint32_t events = 0;
+    __mxio_wait_end(task->io, signal->observed, &events);
+    __mxio_release(task->io);
+    task->fd_func(task->cookie, task->fd, events);
+    free(task);
+}
+
+static int worker_thread(void* arg) {
+    worker_t* self = arg;
+    task_executor_t* ex = self->executor;
+    tls_worker = self;
+
+    for (;;) {
+        task_t* task = deque_pop(self);
+        if (!task)
+            task = take_injected(ex, self);
+        if (!task)
+            task = steal(ex, self);
+        if (!task)
+            task = timer_service(ex);
+        if (task) {
+            run_task(task);
+            continue;
+        }
+
+        if (atomic_load(&ex->shutdown))
+            break;
+
+        // Nothing runnable: park on the port until a packet arrives or
+        // the earliest timer expires.  Recheck the injection queue
+        // after publishing ourselves as parked, or a post landing in
+        // the window would see num_parked == 0 and skip the wake.
+        atomic_fetch_add(&ex->num_parked, 1);
+        mtx_lock(&ex->inject_lock);
+        bool pending = !list_is_empty(&ex->inject_list);
+        mtx_unlock(&ex->inject_lock);
+        if (pending) {
+            atomic_fetch_sub(&ex->num_parked, 1);
+            continue;
+        }
+
+        mtx_lock(&ex->timer_lock);
+        mx_time_t deadline = ex->next_deadline;
+        mtx_unlock(&ex->timer_lock);
+
+        mx_port_packet_t packet;
+        mx_status_t status = mx_port_wait(ex->port, deadline, &packet, 0);
+        atomic_fetch_sub(&ex->num_parked, 1);
+        if (status == ERR_TIMED_OUT)
+            continue; // a timer came due; the top of the loop services it
+        if (status != NO_ERROR)
+            break;
+
+        switch (packet.type) {
+        case MX_PKT_TYPE_SIGNAL_ONE:
+            run_fd_task((task_t*)(uintptr_t)packet.key, &packet.signal);
+            break;
+        case MX_PKT_TYPE_USER:
+            if (packet.key == KEY_SHUTDOWN) {
+                // Pass it on so every worker sees one.
+                post_user_packet(ex, KEY_SHUTDOWN);
+                return 0;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+mx_status_t task_executor_create(uint32_t num_workers, task_executor_t** out) {
+    if (out == NULL)
+        return ERR_INVALID_ARGS;
+    if (num_workers == 0)
+        num_workers = mx_system_get_num_cpus();
+
+    task_executor_t* ex = calloc(1, sizeof(task_executor_t) +
+                                        num_workers * sizeof(worker_t));
+    if (ex == NULL)
+        return ERR_NO_MEMORY;
+
+    mx_status_t status = mx_port_create(MX_PORT_OPT_V2, &ex->port);
+    if (status != NO_ERROR) {
+        free(ex);
+        return status;
+    }
+
+    ex->num_workers = num_workers;
+    mtx_init(&ex->inject_lock, mtx_plain);
+    list_initialize(&ex->inject_list);
+    mtx_init(&ex->timer_lock, mtx_plain);
+    for (uint32_t i = 0; i < WHEEL_SLOTS; i++)
+        list_initialize(&ex->wheel[i]);
+    list_initialize(&ex->timer_overflow);
+    ex->next_deadline = MX_TIME_INFINITE;
+
+    for (uint32_t i = 0; i < num_workers; i++) {
+        worker_t* w = &ex->workers[i];
+        w->executor = ex;
+        w->index = i;
+        char name[32];
+        snprintf(name, sizeof(name), "task-worker-%u", i);
+        if (thrd_create_with_name(&w->thread, worker_thread, w, name) != thrd_success) {
+            // Unwind the workers already running.
+            atomic_store(&ex->shutdown, true);
+            post_user_packet(ex, KEY_SHUTDOWN);
+            for (uint32_t j = 0; j < i; j++)
+                thrd_join(ex->workers[j].thread, NULL);
+            mx_handle_close(ex->port);
+            free(ex);
+            return ERR_NO_MEMORY;
+        }
+    }
+
+    *out = ex;
+    return NO_ERROR;
+}
+
+static task_t* task_create(task_handler_t func, void* cookie) {
+    task_t* task = calloc(1, sizeof(task_t));
+    if (task == NULL)
+        return NULL;
+    task->func = func;
+    task->cookie = cookie;
+    return task;
+}
+
+mx_status_t task_executor_post(task_executor_t* ex,
+                               task_handler_t func, void* cookie) {
+    if (ex == NULL || func == NULL)
+        return ERR_INVALID_ARGS;
+    task_t* task = task_create(func, cookie);
+    if (task == NULL)
+        return ERR_NO_MEMORY;
+
+    worker_t* self = tls_worker;
+    if (self != NULL && self->executor == ex && deque_push(self, task)) {
+        // A peer may be parked with nothing else to steal.
+        wake_one(ex);
+        return NO_ERROR;
+    }
+    inject(ex, task);
+    return NO_ERROR;
+}
+
+mx_status_t task_executor_post_at(task_executor_t* ex, mx_time_t deadline,
+                                  task_handler_t func, void* cookie) {
+    if (ex == NULL || func == NULL)
+        return ERR_INVALID_ARGS;
+    task_t* task = task_create(func, cookie);
+    if (task == NULL)
+        return ERR_NO_MEMORY;
+    task->deadline = deadline;
+
+    mtx_lock(&ex->timer_lock);
+    mx_time_t now = mx_time_get(MX_CLOCK_MONOTONIC);
+    if (deadline < now + WHEEL_HORIZON) {
+        list_add_tail(&ex->wheel[wheel_slot(deadline)], &task->node);
+    } else {
+        list_add_tail(&ex->timer_overflow, &task->node);
+    }
+    bool is_earliest = deadline < ex->next_deadline;
+    if (is_earliest)
+        ex->next_deadline = deadline;
+    mtx_unlock(&ex->timer_lock);
+
+    // Parked workers computed their wait deadline from the old
+    // next_deadline; kick one so it re-arms with the new one.
+    if (is_earliest)
+        wake_one(ex);
+    return NO_ERROR;
+}
+
+mx_status_t task_executor_wait_fd(task_executor_t* ex, int fd, uint32_t events,
+                                  task_fd_handler_t func, void* cookie) {
+    if (ex == NULL || func == NULL)
+        return ERR_INVALID_ARGS;
+    mxio_t* io = __mxio_fd_to_io(fd);
+    if (io == NULL)
+        return ERR_INVALID_ARGS;
+
+    mx_handle_t handle = MX_HANDLE_INVALID;
+    mx_signals_t signals = MX_SIGNAL_NONE;
+    __mxio_wait_begin(io, events, &handle, &signals);
+    if (handle == MX_HANDLE_INVALID) {
+        __mxio_release(io);
+        return ERR_NOT_SUPPORTED;
+    }
+
+    task_t* task = calloc(1, sizeof(task_t));
+    if (task == NULL) {
+        __mxio_release(io);
+        return ERR_NO_MEMORY;
+    }
+    task->io = io;
+    task->fd = fd;
+    task->fd_func = func;
+    task->cookie = cookie;
+
+    mx_status_t status = mx_object_wait_async(handle, ex->port,
+                                              (uint64_t)(uintptr_t)task,
+                                              signals, MX_WAIT_ASYNC_ONCE);
+    if (status != NO_ERROR) {
+        __mxio_release(io);
+        free(task);
+    }
+    return status;
+}
+
+static void free_task_list(list_node_t* list) {
+    task_t* task;
+    while ((task = list_remove_head_type(list, task_t, node)) != NULL)
+        free(task);
+}
+
+void task_executor_destroy(task_executor_t* ex) {
+    if (ex == NULL)
+        return;
+    atomic_store(&ex->shutdown, true);
+    post_user_packet(ex, KEY_SHUTDOWN);
+    for (uint32_t i = 0; i < ex->num_workers; i++)
+        thrd_join(ex->workers[i].thread, NULL);
+    mx_handle_close(ex->port);
+
+    // Workers are gone: drain what never ran.  fd-wait tasks queued on
+    // the port leak their mxio reference by design here; the fds they
+    // referenced still belong to the caller.
+    for (uint32_t i = 0; i < ex->num_workers; i++) {
+        worker_t* w = &ex->workers[i];
+        task_t* task;
+        while ((task = deque_pop(w)) != NULL)
+            free(task);
+    }
+    free_task_list(&ex->inject_list);
+    for (uint32_t i = 0; i < WHEEL_SLOTS; i++)
+        free_task_list(&ex->wheel[i]);
+    free_task_list(&ex->timer_overflow);
+    free(ex);
+}
@@ -0,0 +1,58 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/types.h>
+#include <magenta/compiler.h>
+
+#include <stdint.h>
+
+__BEGIN_CDECLS;
+
+// A fixed pool of worker threads bound to a single V2 port.
+//
+// Each worker owns a lock-free run queue and steals from its peers when
+// its own queue drains, so independent tasks scale across workers
+// without a shared queue lock on the hot path.  Timed tasks go through
+// a timer wheel serviced by whichever worker sleeps next, and fd waits
+// are adapted onto the port with mx_object_wait_async() so blocking on
+// I/O never ties up a worker thread.
+typedef struct task_executor task_executor_t;
+
+typedef void (*task_handler_t)(void* cookie);
+
+// Invoked when a one-shot fd wait completes.  |events| holds the
+// posix-style events (EPOLLIN, EPOLLOUT, EPOLLERR, ...) observed.
+typedef void (*task_fd_handler_t)(void* cookie, int fd, uint32_t events);
+
+// Creates an executor with |num_workers| worker threads, or one per cpu
+// if |num_workers| is 0.
+mx_status_t task_executor_create(uint32_t num_workers, task_executor_t** out);
+
+// Queues |func| to run on some worker as soon as possible.  Safe to
+// call from any thread, including from a task running on the executor
+// (in which case it lands on the caller's own run queue).
+mx_status_t task_executor_post(task_executor_t* executor,
+                               task_handler_t func, void* cookie);
+
+// Queues |func| to run on some worker once |deadline| (MX_CLOCK_MONOTONIC)
+// has passed.
+mx_status_t task_executor_post_at(task_executor_t* executor, mx_time_t deadline,
+                                  task_handler_t func, void* cookie);
+
+// Arranges for |func| to run on some worker once one of |events|
+// (posix-style, as for mxio_wait_fd()) is pending on |fd|.  The wait is
+// one-shot: re-arm from the handler to keep watching the fd.  The fd
+// must stay open until the handler runs.
+mx_status_t task_executor_wait_fd(task_executor_t* executor, int fd,
+                                  uint32_t events,
+                                  task_fd_handler_t func, void* cookie);
+
+// Stops the workers and destroys the executor.  Tasks already running
+// are allowed to finish; queued tasks, pending timers, and unfired fd
+// waits are discarded.  Must not be called from a worker.
+void task_executor_destroy(task_executor_t* executor);
+
+__END_CDECLS;
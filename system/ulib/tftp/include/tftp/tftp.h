@@ -107,6 +107,12 @@ int tftp_session_set_write_cb(tftp_session* session, tftp_write cb);
 // before sending additional data packets.
 bool tftp_session_has_pending(tftp_session* session);
 
+// Returns the number of file bytes confirmed transferred so far: bytes acked
+// by the peer when sending, bytes written when receiving. The library keeps
+// no clock, so callers wanting a throughput report should time the transfer
+// themselves and combine the elapsed time with this value at completion.
+size_t tftp_session_bytes_transferred(tftp_session* session);
+
 // Generates a write request to send to a tftp server. |filename| is the name
 // sent to the server. |datalen| is the size of the data to be sent.
 // |block_size|, |timeout|, and |window_size| negotiate tftp options with the
@@ -121,7 +127,7 @@ tftp_status tftp_generate_write_request(tftp_session* session,
                                         size_t datalen,
                                         size_t block_size,
                                         uint8_t timeout,
-                                        uint8_t window_size,
+                                        uint16_t window_size,
                                         void* outgoing,
                                         size_t* outlen,
                                         uint32_t* timeout_ms);
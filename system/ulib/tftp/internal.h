@@ -43,6 +43,9 @@ typedef struct tftp_data_msg_t {
 #define DEFAULT_WINDOWSIZE 1
 #define DEFAULT_MODE MODE_OCTET
 
+// Consecutive timeouts with no progress before the transfer is abandoned
+#define TFTP_MAX_RETRIES 8
+
 typedef struct tftp_options_t {
     // Maximum filename really is 505 including \0
     // max request size (512) - opcode (2) - shortest mode (4) - null (1)
@@ -92,7 +95,6 @@ typedef enum {
     COMPLETED,
 } tftp_state;
 
-// TODO add a state so time out can be handled properly as well as unexpected traffic
 struct tftp_session_t {
     tftp_options options;
     tftp_state state;
@@ -101,6 +103,14 @@ struct tftp_session_t {
     uint32_t block_number;
     uint32_t window_index;
 
+    // Retransmit state. |sending| is set on the side that generated the
+    // write request. |last_ack_block| is the highest block the peer has
+    // acked (sender side only); a timeout rewinds transmission to it.
+    // |retries| counts consecutive timeouts with no progress.
+    bool sending;
+    uint32_t last_ack_block;
+    uint32_t retries;
+
     // "Negotiated" values
     size_t file_size;
     tftp_mode mode;
@@ -23,7 +23,9 @@
 
 #include "tftp/tftp.h"
 
-#define BLOCKSZ 1024
+// 1428 is the largest block that fits a 1500 byte MTU alongside the
+// IP, UDP and TFTP headers
+#define BLOCKSZ 1428
 #define WINSZ   64
 #define SCRATCHSZ 2048
 
@@ -135,6 +137,17 @@ err:
     return NULL;
 }
 
+void print_throughput(tftp_session* session, struct timeval* start) {
+    struct timeval end;
+    gettimeofday(&end, NULL);
+    double secs = (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1000000.0;
+    size_t bytes = tftp_session_bytes_transferred(session);
+    if (secs > 0.0) {
+        fprintf(stdout, "Transferred %zu bytes in %.3fs (%.2f MB/s)\n",
+                bytes, secs, bytes / (1024.0 * 1024.0) / secs);
+    }
+}
+
 void print_usage() {
     fprintf(stdout, "tftp (-s filename|-r filename)\n");
     fprintf(stdout, "\t -s filename to send the provided file\n");
@@ -211,6 +224,9 @@ tftp_status tftp_send_file(tftp_session* session,
     void* incoming = (void*)in_scratch;
     uint32_t timeout_ms = 60000;
 
+    struct timeval start;
+    gettimeofday(&start, NULL);
+
     tftp_status s =
         tftp_generate_write_request(session,
                                     "magenta.bin",
@@ -273,11 +289,12 @@ tftp_status tftp_send_file(tftp_session* session,
             }
             if (errno == EAGAIN) {
                 fprintf(stdout, "Timed out\n");
+                out = SCRATCHSZ;
                 ret = tftp_timeout(session,
                                    outgoing,
                                    &out,
                                    &timeout_ms,
-                                   connection);
+                                   &f);
                 if (out) {
                     n = connection_send(connection, outgoing, out);
                     if (n < 0) {
@@ -317,6 +334,7 @@ tftp_status tftp_send_file(tftp_session* session,
             return -1;
         } else if (ret == TFTP_TRANSFER_COMPLETED) {
             fprintf(stderr, "Completed\n");
+            print_throughput(session, &start);
             return 0;
         }
         if (tftp_session_has_pending(session)) {
@@ -358,6 +376,7 @@ tftp_status tftp_receive_file(tftp_session* session,
 
     int n, ret;
     int wrq_received = 0;
+    struct timeval start;
     do {
         in = SCRATCHSZ;
         n = connection_receive(connection, incoming, in, true);
@@ -391,7 +410,10 @@ tftp_status tftp_receive_file(tftp_session* session,
         } else {
             fprintf(stdout, "Received: %d\n", n);
             in = n;
-            wrq_received = 1;
+            if (!wrq_received) {
+                gettimeofday(&start, NULL);
+                wrq_received = 1;
+            }
         }
 
         out = SCRATCHSZ;
@@ -416,6 +438,7 @@ tftp_status tftp_receive_file(tftp_session* session,
             fprintf(stderr, "Completed %zu ... ", f.size);
             close(f.fd);
             fprintf(stderr, "Flushed to disk\n");
+            print_throughput(session, &start);
             return 0;
         }
         connection_set_timeout(connection, timeout_ms);
@@ -1112,6 +1112,224 @@ static bool test_tftp_send_data_receive_ack_window_size(void) {
     END_TEST;
 }
 
+static bool test_tftp_send_data_block_wraparound(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+
+    auto status = tftp_generate_write_request(ts.session, kFilename, MODE_OCTET,
+        0x4000000, 0, 0, 0, ts.out, &ts.outlen, &ts.timeout);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "error generating write request");
+    EXPECT_TRUE(verify_write_request(ts), "bad write request");
+
+    uint8_t oack_buf[] = {
+        0x00, 0x06,                                 // Opcode (OACK)
+        'T', 'S', 'I', 'Z', 'E', 0x00,              // Option
+        '6', '7', '1', '0', '8', '8', '6', '4', 0x00,  // TSIZE value
+    };
+
+    tftp_session_set_read_cb(ts.session, mock_read);
+
+    tx_test_data td;
+    status = tftp_handle_msg(ts.session, oack_buf, sizeof(oack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    ASSERT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+    ASSERT_TRUE(verify_read_data(ts, td), "bad test data");
+
+    // Fast-forward to the end of the 16 bit block number range
+    ts.session->block_number = 65535;
+    ts.session->last_ack_block = 65535;
+
+    uint8_t ack_buf[] = {
+        0x00, 0x04,  // Opcode (ACK)
+        0xff, 0xff,  // Block
+    };
+
+    // Block 65536 wraps to 0 on the wire but must keep advancing the session
+    tx_test_data td2;
+    td2.expected.block = 0;
+    td2.expected.offset = 65535ull * DEFAULT_BLOCKSIZE;
+    status = tftp_handle_msg(ts.session, ack_buf, sizeof(ack_buf), ts.out, &ts.outlen, &ts.timeout, &td2);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+    EXPECT_TRUE(verify_read_data(ts, td2), "bad test data");
+
+    ack_buf[2] = 0x00;
+    ack_buf[3] = 0x00;
+
+    tx_test_data td3;
+    td3.expected.block = 1;
+    td3.expected.offset = 65536ull * DEFAULT_BLOCKSIZE;
+    status = tftp_handle_msg(ts.session, ack_buf, sizeof(ack_buf), ts.out, &ts.outlen, &ts.timeout, &td3);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(65537, ts.session->block_number, "tftp session block number mismatch");
+    EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+    EXPECT_TRUE(verify_read_data(ts, td3), "bad test data");
+
+    END_TEST;
+}
+
+static bool test_tftp_receive_data_block_wraparound(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+    tftp_session_set_open_cb(ts.session,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                EXPECT_STR_EQ(filename, kFilename, strlen(kFilename), "bad filename");
+                EXPECT_EQ(size, 67108864, "bad file size");
+                return 0;
+            });
+
+    uint8_t req_buf[] = {
+        0x00, 0x02,                                   // Opcode (WRQ)
+        'f', 'i', 'l', 'e', 'n', 'a', 'm', 'e', 0x00, // Filename
+        'O', 'C', 'T', 'E', 'T', 0x00,                // Mode
+        'T', 'S', 'I', 'Z', 'E', 0x00,                // Option
+        '6', '7', '1', '0', '8', '8', '6', '4', 0x00, // TSIZE value
+    };
+    auto status = tftp_handle_msg(ts.session, req_buf, sizeof(req_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_OACK), "bad response");
+
+    // Fast-forward to the end of the 16 bit block number range
+    ts.session->block_number = 65535;
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x00, 0x00,  // Block 65536 wraps to 0 on the wire
+        0xaa, 0xbb, 0xcc, 0xdd,
+    };
+
+    // The write offset is too large for mock_write's buffer; just record it
+    tftp_session_set_write_cb(ts.session,
+            [](const void* data, size_t* len, off_t offset, void* cookie) -> tftp_status {
+                tx_test_data* td = static_cast<tx_test_data*>(cookie);
+                td->actual.offset = offset;
+                td->actual.len = *len;
+                return static_cast<tftp_status>(*len);
+            });
+
+    tx_test_data td;
+    status = tftp_handle_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_TRUE(verify_response_opcode(ts, OPCODE_ACK), "bad response");
+    EXPECT_EQ(65535ull * DEFAULT_BLOCKSIZE, td.actual.offset, "write offset mismatch");
+    EXPECT_EQ(512, td.actual.len, "write length mismatch");
+    EXPECT_EQ(65536, ts.session->block_number, "tftp session block number mismatch");
+
+    END_TEST;
+}
+
+static bool test_tftp_send_data_timeout_rewind(void) {
+    constexpr uint8_t kWindowSize = 2;
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 2048, 1500);
+
+    auto status = tftp_generate_write_request(ts.session, kFilename, MODE_OCTET,
+        ts.msg_size, 0, 0, kWindowSize, ts.out, &ts.outlen, &ts.timeout);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "error generating write request");
+
+    uint8_t oack_buf[] = {
+        0x00, 0x06,                     // Opcode (OACK)
+        'T', 'S', 'I', 'Z', 'E', 0x00,  // Option
+        '2', '0', '4', '8', 0x00,       // TSIZE value
+        'W', 'I', 'N', 'D', 'O', 'W', 'S', 'I', 'Z', 'E', 0x00,  // Option
+        '2', 0x00,                                                // WINDOWSIZE value
+    };
+
+    tftp_session_set_read_cb(ts.session, mock_read);
+
+    tx_test_data td;
+    status = tftp_handle_msg(ts.session, oack_buf, sizeof(oack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    ASSERT_TRUE(verify_read_data(ts, td), "bad test data");
+    ASSERT_TRUE(tftp_session_has_pending(ts.session), "expected pending data to transmit");
+
+    td.expected.block = 2;
+    td.expected.offset += DEFAULT_BLOCKSIZE;
+    td.expected.data[0]++;
+    status = tftp_prepare_data(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    ASSERT_TRUE(verify_read_data(ts, td), "bad test data");
+    ASSERT_EQ(2, ts.session->block_number, "tftp session block number mismatch");
+
+    // The window was never acked; a timeout should rewind to the last acked
+    // block and resend from there
+    tx_test_data td2;
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, &td2);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    EXPECT_EQ(1, ts.session->retries, "retry count mismatch");
+    EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+    EXPECT_TRUE(verify_read_data(ts, td2), "bad test data");
+    EXPECT_TRUE(tftp_session_has_pending(ts.session), "expected pending data to transmit");
+
+    END_TEST;
+}
+
+static bool test_tftp_receive_data_timeout_reack(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+    tftp_session_set_open_cb(ts.session,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                return 0;
+            });
+
+    uint8_t req_buf[] = {
+        0x00, 0x02,                                   // Opcode (WRQ)
+        'f', 'i', 'l', 'e', 'n', 'a', 'm', 'e', 0x00, // Filename
+        'O', 'C', 'T', 'E', 'T', 0x00,                // Mode
+        'T', 'S', 'I', 'Z', 'E', 0x00,                // Option
+        '2', '0', '4', '8', 0x00,                     // TSIZE value
+    };
+    auto status = tftp_handle_msg(ts.session, req_buf, sizeof(req_buf), ts.out, &ts.outlen, &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x01, 0x00,  // Block
+        0xaa, 0xbb, 0xcc, 0xdd,
+    };
+
+    tftp_session_set_write_cb(ts.session, mock_write);
+
+    tx_test_data td;
+    status = tftp_handle_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    ASSERT_EQ(1, ts.session->block_number, "tftp session block number mismatch");
+
+    // A timeout on the receive side should re-ack the last in-order block
+    status = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, nullptr);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "timeout failed");
+    EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg), "bad outlen");
+    auto msg = reinterpret_cast<tftp_data_msg*>(ts.out);
+    EXPECT_EQ(msg->opcode, htons(OPCODE_ACK), "bad opcode");
+    EXPECT_EQ(1, msg->block, "bad block number");
+
+    // Receiving the next block resets the retry count
+    EXPECT_EQ(1, ts.session->retries, "retry count mismatch");
+    data_buf[2] = 0x02;
+    td.expected.offset = DEFAULT_BLOCKSIZE;
+    status = tftp_handle_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_EQ(0, ts.session->retries, "retry count mismatch");
+
+    // Repeated timeouts with no progress eventually abandon the transfer
+    tftp_status last = TFTP_NO_ERROR;
+    for (int i = 0; i <= TFTP_MAX_RETRIES; i++) {
+        last = tftp_timeout(ts.session, ts.out, &ts.outlen, &ts.timeout, nullptr);
+    }
+    EXPECT_EQ(TFTP_ERR_TIMED_OUT, last, "expected timeout error");
+    EXPECT_EQ(ERROR, ts.session->state, "session should be in error state");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(tftp_setup)
 RUN_TEST(test_tftp_init)
 RUN_TEST(test_tftp_session_options)
@@ -1148,6 +1366,7 @@ RUN_TEST(test_tftp_receive_data_blocksize)
 RUN_TEST(test_tftp_receive_data_windowsize)
 RUN_TEST(test_tftp_receive_data_skipped_block)
 RUN_TEST(test_tftp_receive_data_windowsize_skipped_block)
+RUN_TEST(test_tftp_receive_data_block_wraparound)
 END_TEST_CASE(tftp_receive_data)
 
 BEGIN_TEST_CASE(tftp_send_data)
@@ -1155,8 +1374,14 @@ RUN_TEST(test_tftp_send_data_receive_ack)
 RUN_TEST(test_tftp_send_data_receive_final_ack)
 RUN_TEST(test_tftp_send_data_receive_ack_skipped_block)
 RUN_TEST(test_tftp_send_data_receive_ack_window_size)
+RUN_TEST(test_tftp_send_data_block_wraparound)
 END_TEST_CASE(tftp_send_data)
 
+BEGIN_TEST_CASE(tftp_timeout)
+RUN_TEST(test_tftp_send_data_timeout_rewind)
+RUN_TEST(test_tftp_receive_data_timeout_reack)
+END_TEST_CASE(tftp_timeout)
+
 int main(int argc, char* argv[]) {
     return unittest_run_all_tests(argc, argv) ? 0 : -1;
 }
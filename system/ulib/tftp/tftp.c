@@ -133,8 +133,22 @@ static void set_error(tftp_session* session, uint16_t opcode, tftp_msg* resp, si
     session->state = ERROR;
 }
 
+// DATA and ACK packets carry only the low 16 bits of the block number
+// (RFC 1350). Reconstruct the full value by picking the candidate closest
+// to where the session currently is, so that transfers of more than 65535
+// blocks keep advancing instead of stalling at the wraparound.
+static uint32_t full_block_number(uint32_t current, uint16_t wire) {
+    uint32_t full = (current & 0xFFFF0000) | wire;
+    if (full + 0x8000 < current) {
+        full += 0x10000;
+    } else if ((full >= 0x10000) && (full - 0x8000 > current)) {
+        full -= 0x10000;
+    }
+    return full;
+}
+
 tftp_status tx_data(tftp_session* session, tftp_data_msg* resp, size_t* outlen, void* cookie) {
-    session->offset = (session->block_number + session->window_index) * session->block_size;
+    session->offset = (size_t)(session->block_number + session->window_index) * session->block_size;
     *outlen = 0;
     if (session->offset < session->file_size) {
         session->window_index++;
@@ -219,13 +233,19 @@ bool tftp_session_has_pending(tftp_session* session) {
     return session->window_index > 0 && session->window_index < session->window_size;
 }
 
+size_t tftp_session_bytes_transferred(tftp_session* session) {
+    uint64_t bytes = (uint64_t)(session->sending ? session->last_ack_block
+                                                 : session->block_number) * session->block_size;
+    return bytes > session->file_size ? session->file_size : (size_t)bytes;
+}
+
 tftp_status tftp_generate_write_request(tftp_session* session,
                                         const char* filename,
                                         tftp_mode mode,
                                         size_t datalen,
                                         size_t block_size,
                                         uint8_t timeout,
-                                        uint8_t window_size,
+                                        uint16_t window_size,
                                         void* outgoing,
                                         size_t* outlen,
                                         uint32_t* timeout_ms) {
@@ -300,6 +320,7 @@ tftp_status tftp_generate_write_request(tftp_session* session,
     *timeout_ms = 1000 * session->timeout;
 
     session->state = WRITE_REQUESTED;
+    session->sending = true;
     xprintf("Generated write request, len=%zu\n", *outlen);
     return TFTP_NO_ERROR;
 }
@@ -502,41 +523,43 @@ tftp_status tftp_handle_data(tftp_session* session,
 
     tftp_data_msg* data = (tftp_data_msg*)msg;
     tftp_data_msg* ack_data = (tftp_data_msg*)resp;
-    xprintf(" <- Block %u (Last = %u, Offset = %d, Size = %ld, Left = %ld)\n", data->block,
-            session->block_number, session->block_number * session->block_size,
+    uint32_t block = full_block_number(session->block_number, data->block);
+    xprintf(" <- Block %u (Last = %u, Offset = %zu, Size = %ld, Left = %ld)\n", block,
+            session->block_number, (size_t)session->block_number * session->block_size,
             session->file_size, session->file_size - session->block_number * session->block_size);
-    if (data->block == session->block_number + 1) {
+    if (block == session->block_number + 1) {
         xprintf("Advancing normally + 1\n");
         size_t wr = msg_len - sizeof(tftp_data_msg);
         // TODO(tkilbourn): assert that these function pointers are set
         tftp_status ret = session->write_fn(data->data, &wr,
-                session->block_number * session->block_size, cookie);
+                (size_t)session->block_number * session->block_size, cookie);
         if (ret < 0) {
             xprintf("Error writing: %d\n", ret);
             return ret;
         }
         session->block_number++;
         session->window_index++;
-    } else if (data->block > session->block_number + 1) {
+        session->retries = 0;
+    } else if (block > session->block_number + 1) {
         // Force sending a ACK with the last block_number we received
-        xprintf("Skipped: got %d, expected %d\n", data->block, session->block_number + 1);
+        xprintf("Skipped: got %d, expected %d\n", block, session->block_number + 1);
         session->window_index = session->window_size;
     } else {
-        xprintf("Resetting to block %d\n", data->block);
+        xprintf("Resetting to block %d\n", block);
         // Skip writing this block; subsequent blocks will get overwritten
         // though.
-        session->block_number = data->block;
+        session->block_number = block;
         session->window_index = 1;
     }
 
     if (session->window_index == session->window_size ||
-            session->block_number * session->block_size >= session->file_size) {
+            (size_t)session->block_number * session->block_size >= session->file_size) {
         xprintf(" -> Ack %d\n", session->block_number);
         session->window_index = 0;
         OPCODE(ack_data, OPCODE_ACK);
         ack_data->block = session->block_number;
         *resp_len = sizeof(*ack_data);
-        if (session->block_number * session->block_size >= session->file_size) {
+        if ((size_t)session->block_number * session->block_size >= session->file_size) {
             return TFTP_TRANSFER_COMPLETED;
         }
     } else {
@@ -571,10 +594,12 @@ tftp_status tftp_handle_ack(tftp_session* session,
     tftp_data_msg* resp_data = (void*)resp;
 
     xprintf(" <- Ack %d\n", ack_data->block);
-    session->block_number = ack_data->block;
+    session->block_number = full_block_number(session->block_number, ack_data->block);
+    session->last_ack_block = session->block_number;
     session->window_index = 0;
+    session->retries = 0;
 
-    if ((session->block_number + session->window_index) * session->block_size >= session->file_size) {
+    if ((size_t)(session->block_number + session->window_index) * session->block_size >= session->file_size) {
         *resp_len = 0;
         return TFTP_TRANSFER_COMPLETED;
     }
@@ -704,6 +729,7 @@ tftp_status tftp_handle_oack(tftp_session* session,
     tftp_data_msg* resp_data = (void*)resp;
     session->offset = 0;
     session->block_number = 0;
+    session->last_ack_block = 0;
 
     tftp_status ret = tx_data(session, resp_data, resp_len, cookie);
     if (ret < 0) {
@@ -770,7 +796,7 @@ tftp_status tftp_prepare_data(tftp_session* session,
                               void* cookie) {
     tftp_data_msg* resp_data = outgoing;
 
-    if ((session->block_number + session->window_index) * session->block_size >= session->file_size) {
+    if ((size_t)(session->block_number + session->window_index) * session->block_size >= session->file_size) {
         *outlen = 0;
         return TFTP_TRANSFER_COMPLETED;
     }
@@ -787,6 +813,54 @@ tftp_status tftp_timeout(tftp_session* session,
                          size_t* outlen,
                          uint32_t* timeout_ms,
                          void* cookie) {
-    // TODO: really handle timeouts
+    xprintf("Timeout\n");
+    switch (session->state) {
+    case WRITE_REQUESTED:
+    case TRANSMITTING:
+    case LAST_PACKET:
+        break;
+    default:
+        *outlen = 0;
+        return TFTP_NO_ERROR;
+    }
+
+    if (++session->retries > TFTP_MAX_RETRIES) {
+        session->state = ERROR;
+        *outlen = 0;
+        return TFTP_ERR_TIMED_OUT;
+    }
+    *timeout_ms = 1000 * session->timeout;
+
+    if (session->sending) {
+        if (session->state == WRITE_REQUESTED) {
+            // The request (or the OACK for it) was lost; resend it with
+            // the original options.
+            char filename[sizeof(session->options.filename)];
+            memcpy(filename, session->options.filename, sizeof(filename));
+            uint8_t requested = session->options.requested;
+            return tftp_generate_write_request(session, filename,
+                    session->options.mode, session->file_size,
+                    (requested & BLOCKSIZE_OPTION) ? session->options.block_size : 0,
+                    (requested & TIMEOUT_OPTION) ? session->options.timeout : 0,
+                    (requested & WINDOWSIZE_OPTION) ? session->options.window_size : 0,
+                    outgoing, outlen, timeout_ms);
+        }
+        // Data (or the ack for it) was lost; rewind to the last block the
+        // receiver acked and resend the window from there.
+        session->block_number = session->last_ack_block;
+        session->window_index = 0;
+        tftp_status ret = tx_data(session, (tftp_data_msg*)outgoing, outlen, cookie);
+        if (ret < 0) {
+            set_error(session, OPCODE_ERROR, outgoing, outlen);
+        }
+        return ret;
+    }
+
+    // Receiving: re-ack the last in-order block so the sender rewinds to it.
+    tftp_data_msg* ack_data = (tftp_data_msg*)outgoing;
+    OPCODE(ack_data, OPCODE_ACK);
+    ack_data->block = session->block_number;
+    session->window_index = 0;
+    *outlen = sizeof(*ack_data);
     return TFTP_NO_ERROR;
 }
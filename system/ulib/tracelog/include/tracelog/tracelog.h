@@ -0,0 +1,108 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <magenta/compiler.h>
+#include <magenta/types.h>
+
+#include <stdint.h>
+
+__BEGIN_CDECLS;
+
+// A wait-free, single-producer trace writer.
+//
+// Each writer owns a VMO holding a ring of fixed-size records, shared
+// with a collector process that maps the same VMO. Appending a record
+// is a handful of stores plus one release-ordered stamp -- no syscalls
+// and no waiting -- so a thread can emit millions of events per second
+// without burning its syscall budget the way a debuglog write per line
+// does. The only kernel entry on the producer side is a port doorbell
+// queued once per ring revolution, which bounds how long the collector
+// may sleep between drains.
+//
+// The ring is strictly single-producer: create one writer per thread
+// and never share it. The collector is the single consumer. When the
+// ring is full the writer drops the record and counts it in the shared
+// header; it never blocks and never overwrites unconsumed records.
+
+#define TRACELOG_RECORD_ARGS 5
+
+// One trace event. Records are written in place in the shared ring;
+// the collector reads a slot only once its stamp matches the slot's
+// expected sequence.
+typedef struct tracelog_record {
+    // (sequence + 1) once the payload is complete, 0 if the slot has
+    // never been written. Written last, with release ordering.
+    uint64_t stamp;
+    // mx_ticks_get() at the time of the write.
+    uint64_t ticks;
+    // Caller-defined event id.
+    uint32_t event;
+    uint32_t reserved;
+    // Caller-defined payload; unused slots are zero.
+    uint64_t args[TRACELOG_RECORD_ARGS];
+} tracelog_record_t;
+
+// Shared control block at offset 0 of the ring VMO, followed by
+// record_count records.
+typedef struct tracelog_header {
+    uint64_t magic;        // TRACELOG_MAGIC
+    uint32_t record_count; // power of two
+    uint32_t record_size;  // sizeof(tracelog_record_t)
+    // Caller-defined producer id (typically the thread's koid), so the
+    // collector can tell rings apart.
+    uint64_t producer;
+    // Next sequence to reserve. Written only by the producer.
+    uint64_t head;
+    // First sequence not yet consumed. Written only by the collector.
+    uint64_t tail;
+    // Records discarded because the ring was full.
+    uint64_t dropped;
+    uint64_t reserved[2];
+} tracelog_header_t;
+
+#define TRACELOG_MAGIC ((uint64_t)0x676f6c6563617274ULL) // 'tracelog'
+
+typedef struct tracelog_writer tracelog_writer_t;
+typedef struct tracelog_reader tracelog_reader_t;
+
+// Creates a writer with a ring of |record_count| records (rounded up to
+// a power of two; 0 picks a default), tagged with |producer|. If |port|
+// is valid it is duplicated and a MX_PKT_TYPE_USER packet carrying |key|
+// is queued to it once per ring revolution as a doorbell.
+mx_status_t tracelog_writer_create(uint32_t record_count, uint64_t producer,
+                                   mx_handle_t port, uint64_t key,
+                                   tracelog_writer_t** out);
+
+// Duplicates the ring VMO for handoff to the collector.
+mx_status_t tracelog_writer_get_vmo(tracelog_writer_t* writer, mx_handle_t* out);
+
+// Appends one record. Wait-free; drops (and counts) the record if the
+// collector has fallen a full ring behind. At most TRACELOG_RECORD_ARGS
+// args are recorded. Must only be called from the owning thread.
+void tracelog_write(tracelog_writer_t* writer, uint32_t event,
+                    const uint64_t* args, uint32_t num_args);
+
+// Rings the doorbell immediately, regardless of position in the ring.
+// Useful when a low-rate thread wants its records drained promptly.
+void tracelog_writer_flush(tracelog_writer_t* writer);
+
+// Unmaps the ring and closes the writer's handles. The collector's
+// mapping (and any outstanding VMO handles) keep the ring alive.
+void tracelog_writer_destroy(tracelog_writer_t* writer);
+
+// Maps |vmo| (not consumed) and validates the ring header.
+mx_status_t tracelog_reader_create(mx_handle_t vmo, tracelog_reader_t** out);
+
+// Copies out the next record and advances the shared tail cursor.
+// Returns ERR_SHOULD_WAIT when the ring is empty.
+mx_status_t tracelog_read(tracelog_reader_t* reader, tracelog_record_t* out);
+
+// The shared header, for producer id and drop accounting.
+const tracelog_header_t* tracelog_reader_header(tracelog_reader_t* reader);
+
+void tracelog_reader_destroy(tracelog_reader_t* reader);
+
+__END_CDECLS;
@@ -0,0 +1,239 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <tracelog/tracelog.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <magenta/process.h>
+#include <magenta/syscalls.h>
+#include <magenta/syscalls/port.h>
+
+// The shared cursors and stamps are plain uint64_t in the wire format so
+// the header stays usable from C++ collectors; all cross-process accesses
+// go through the __atomic builtins below.
+
+#define DEFAULT_RECORD_COUNT 4096u
+
+struct tracelog_writer {
+    tracelog_header_t* hdr;
+    tracelog_record_t* records;
+    uint32_t mask;
+    size_t map_size;
+    mx_handle_t vmo;
+    mx_handle_t port; // MX_HANDLE_INVALID if no doorbell was requested
+    uint64_t key;
+};
+
+struct tracelog_reader {
+    tracelog_header_t* hdr;
+    tracelog_record_t* records;
+    uint32_t mask;
+    uint64_t next;
+    size_t map_size;
+};
+
+static uint32_t round_up_pow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static void ring_doorbell(tracelog_writer_t* writer, uint64_t seq) {
+    mx_port_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.key = writer->key;
+    packet.type = MX_PKT_TYPE_USER;
+    packet.user.u64[0] = seq;
+    mx_port_queue(writer->port, &packet, 0u);
+}
+
+mx_status_t tracelog_writer_create(uint32_t record_count, uint64_t producer,
+                                   mx_handle_t port, uint64_t key,
+                                   tracelog_writer_t** out) {
+    if (record_count == 0) {
+        record_count = DEFAULT_RECORD_COUNT;
+    }
+    record_count = round_up_pow2(record_count);
+
+    tracelog_writer_t* writer = calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return ERR_NO_MEMORY;
+    }
+    writer->port = MX_HANDLE_INVALID;
+
+    mx_status_t status;
+    size_t size = sizeof(tracelog_header_t) +
+                  (size_t)record_count * sizeof(tracelog_record_t);
+    if ((status = mx_vmo_create(size, 0, &writer->vmo)) != NO_ERROR) {
+        free(writer);
+        return status;
+    }
+
+    uintptr_t addr;
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, writer->vmo, 0, size,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
+                              &addr)) != NO_ERROR) {
+        goto fail;
+    }
+    writer->hdr = (tracelog_header_t*)addr;
+    writer->records = (tracelog_record_t*)(addr + sizeof(tracelog_header_t));
+    writer->mask = record_count - 1;
+    writer->map_size = size;
+    writer->key = key;
+
+    if (port != MX_HANDLE_INVALID) {
+        if ((status = mx_handle_duplicate(port, MX_RIGHT_SAME_RIGHTS,
+                                          &writer->port)) != NO_ERROR) {
+            mx_vmar_unmap(mx_vmar_root_self(), addr, size);
+            goto fail;
+        }
+    }
+
+    writer->hdr->magic = TRACELOG_MAGIC;
+    writer->hdr->record_count = record_count;
+    writer->hdr->record_size = sizeof(tracelog_record_t);
+    writer->hdr->producer = producer;
+
+    *out = writer;
+    return NO_ERROR;
+
+fail:
+    mx_handle_close(writer->vmo);
+    free(writer);
+    return status;
+}
+
+mx_status_t tracelog_writer_get_vmo(tracelog_writer_t* writer, mx_handle_t* out) {
+    return mx_handle_duplicate(writer->vmo, MX_RIGHT_SAME_RIGHTS, out);
+}
+
+void tracelog_write(tracelog_writer_t* writer, uint32_t event,
+                    const uint64_t* args, uint32_t num_args) {
+    tracelog_header_t* hdr = writer->hdr;
+
+    // head is only ever written by this thread, so the load can be relaxed.
+    uint64_t seq = __atomic_load_n(&hdr->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+    if (seq - tail > writer->mask) {
+        // Ring full. Dropping (and counting) is the wait-free policy;
+        // overwriting would race the collector's copy-out.
+        __atomic_store_n(&hdr->dropped, hdr->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    tracelog_record_t* rec = &writer->records[seq & writer->mask];
+    rec->ticks = mx_ticks_get();
+    rec->event = event;
+    rec->reserved = 0;
+    if (num_args > TRACELOG_RECORD_ARGS) {
+        num_args = TRACELOG_RECORD_ARGS;
+    }
+    uint32_t ix = 0;
+    for (; ix < num_args; ix++) {
+        rec->args[ix] = args[ix];
+    }
+    for (; ix < TRACELOG_RECORD_ARGS; ix++) {
+        rec->args[ix] = 0;
+    }
+
+    // Publish the payload before the cursor that advertises it.
+    __atomic_store_n(&rec->stamp, seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&hdr->head, seq + 1, __ATOMIC_RELEASE);
+
+    // One doorbell per ring revolution bounds how stale the collector
+    // can get without charging every record a syscall.
+    if (((seq + 1) & writer->mask) == 0 && writer->port != MX_HANDLE_INVALID) {
+        ring_doorbell(writer, seq + 1);
+    }
+}
+
+void tracelog_writer_flush(tracelog_writer_t* writer) {
+    if (writer->port != MX_HANDLE_INVALID) {
+        ring_doorbell(writer, __atomic_load_n(&writer->hdr->head, __ATOMIC_RELAXED));
+    }
+}
+
+void tracelog_writer_destroy(tracelog_writer_t* writer) {
+    mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)writer->hdr, writer->map_size);
+    mx_handle_close(writer->vmo);
+    if (writer->port != MX_HANDLE_INVALID) {
+        mx_handle_close(writer->port);
+    }
+    free(writer);
+}
+
+mx_status_t tracelog_reader_create(mx_handle_t vmo, tracelog_reader_t** out) {
+    uint64_t size;
+    mx_status_t status = mx_vmo_get_size(vmo, &size);
+    if (status != NO_ERROR) {
+        return status;
+    }
+    if (size < sizeof(tracelog_header_t)) {
+        return ERR_INVALID_ARGS;
+    }
+
+    tracelog_reader_t* reader = calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        return ERR_NO_MEMORY;
+    }
+
+    uintptr_t addr;
+    if ((status = mx_vmar_map(mx_vmar_root_self(), 0, vmo, 0, size,
+                              MX_VM_FLAG_PERM_READ | MX_VM_FLAG_PERM_WRITE,
+                              &addr)) != NO_ERROR) {
+        free(reader);
+        return status;
+    }
+    reader->hdr = (tracelog_header_t*)addr;
+    reader->map_size = size;
+
+    tracelog_header_t* hdr = reader->hdr;
+    uint32_t count = hdr->record_count;
+    if ((hdr->magic != TRACELOG_MAGIC) ||
+        (hdr->record_size != sizeof(tracelog_record_t)) ||
+        (count == 0) || (count & (count - 1)) ||
+        (size < sizeof(tracelog_header_t) +
+             (uint64_t)count * sizeof(tracelog_record_t))) {
+        mx_vmar_unmap(mx_vmar_root_self(), addr, size);
+        free(reader);
+        return ERR_INVALID_ARGS;
+    }
+
+    reader->records = (tracelog_record_t*)(addr + sizeof(tracelog_header_t));
+    reader->mask = count - 1;
+    reader->next = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+
+    *out = reader;
+    return NO_ERROR;
+}
+
+mx_status_t tracelog_read(tracelog_reader_t* reader, tracelog_record_t* out) {
+    uint64_t seq = reader->next;
+    tracelog_record_t* rec = &reader->records[seq & reader->mask];
+
+    // The producer stamps a slot only after the payload is complete, and
+    // never rewrites it before tail advances past it, so a matching stamp
+    // means the whole record is stable.
+    if (__atomic_load_n(&rec->stamp, __ATOMIC_ACQUIRE) != seq + 1) {
+        return ERR_SHOULD_WAIT;
+    }
+    *out = *rec;
+
+    reader->next = seq + 1;
+    __atomic_store_n(&reader->hdr->tail, seq + 1, __ATOMIC_RELEASE);
+    return NO_ERROR;
+}
+
+const tracelog_header_t* tracelog_reader_header(tracelog_reader_t* reader) {
+    return reader->hdr;
+}
+
+void tracelog_reader_destroy(tracelog_reader_t* reader) {
+    mx_vmar_unmap(mx_vmar_root_self(), (uintptr_t)reader->hdr, reader->map_size);
+    free(reader);
+}
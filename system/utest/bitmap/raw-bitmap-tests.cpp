@@ -335,6 +335,39 @@ static bool SetOutOfOrder(void) {
     END_TEST;
 }
 
+template <typename RawBitmap>
+static bool ScanLongRuns(void) {
+    BEGIN_TEST;
+
+    // Spans many whole words, so Scan takes its unmasked interior fast path.
+    RawBitmap bitmap;
+    EXPECT_EQ(bitmap.Reset(4096), NO_ERROR, "");
+    EXPECT_EQ(bitmap.size(), 4096U, "get size");
+
+    EXPECT_EQ(bitmap.Scan(0, 4096, false), 4096U, "scan all clear");
+    EXPECT_EQ(bitmap.Scan(0, 4096, true), 0U, "scan all clear for set");
+
+    // A single set bit deep in the interior must stop the scan, at every
+    // offset within its word.
+    for (size_t bit = 2048; bit < 2048 + 64; ++bit) {
+        EXPECT_EQ(bitmap.SetOne(bit), NO_ERROR, "set interior bit");
+        EXPECT_EQ(bitmap.Scan(3, 4096, false), bit, "scan clear to interior bit");
+        EXPECT_EQ(bitmap.ClearOne(bit), NO_ERROR, "clear interior bit");
+    }
+
+    EXPECT_EQ(bitmap.Set(0, 4096), NO_ERROR, "set all");
+    EXPECT_EQ(bitmap.Scan(3, 4093, true), 4093U, "scan set over interior");
+    EXPECT_EQ(bitmap.ClearOne(1234), NO_ERROR, "clear interior bit");
+    EXPECT_EQ(bitmap.Scan(3, 4093, true), 1234U, "scan set to interior hole");
+
+    size_t bitoff_start;
+    EXPECT_EQ(bitmap.Find(false, 0, 4096, 1, &bitoff_start), NO_ERROR,
+              "find the only clear bit");
+    EXPECT_EQ(bitoff_start, 1234U, "check returned arg");
+
+    END_TEST;
+}
+
 #define RUN_TEMPLATIZED_TEST(test, specialization) RUN_TEST(test<specialization>)
 #define ALL_TESTS(specialization)                           \
     RUN_TEMPLATIZED_TEST(InitializedEmpty, specialization)  \
@@ -347,7 +380,8 @@ static bool SetOutOfOrder(void) {
     RUN_TEMPLATIZED_TEST(ClearSubrange, specialization)     \
     RUN_TEMPLATIZED_TEST(BoundaryArguments, specialization) \
     RUN_TEMPLATIZED_TEST(ClearAll, specialization)          \
-    RUN_TEMPLATIZED_TEST(SetOutOfOrder, specialization)
+    RUN_TEMPLATIZED_TEST(SetOutOfOrder, specialization)     \
+    RUN_TEMPLATIZED_TEST(ScanLongRuns, specialization)
 
 BEGIN_TEST_CASE(raw_bitmap_tests)
 ALL_TESTS(RawBitmapGeneric<DefaultStorage>)
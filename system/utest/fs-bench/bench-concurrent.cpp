@@ -0,0 +1,339 @@
+// Copyright 2017 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Concurrent-client benchmarks: N threads doing metadata ops
+// (create/stat/unlink) or mixed 4k reads/writes against the filesystem
+// mounted at /benchmark (minfs or memfs), with per-op latency recording.
+// Op counts are fixed and the file sets and read/write mix are generated
+// from deterministic seeds, so runs are comparable across builds.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <magenta/new.h>
+#include <magenta/syscalls.h>
+#include <mxtl/unique_ptr.h>
+#include <unittest/unittest.h>
+
+#define MOUNT_POINT "/benchmark"
+
+namespace {
+
+constexpr uint32_t kMaxThreads = 8;
+constexpr uint32_t kMetadataOpsPerThread = 1000;
+constexpr uint32_t kMixedOpsPerThread = 2000;
+constexpr size_t kMixedFileSize = 1 << 20;
+constexpr size_t kMixedIoSize = 4096;
+
+uint64_t now_ns() {
+    return mx_time_get(MX_CLOCK_MONOTONIC);
+}
+
+// Deterministic per-thread op stream (a 64-bit LCG), so a given thread
+// always touches the same offsets in the same order.
+uint64_t lcg_next(uint64_t* state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 16;
+}
+
+int cmp_u64(const void* a, const void* b) {
+    uint64_t va = *static_cast<const uint64_t*>(a);
+    uint64_t vb = *static_cast<const uint64_t*>(b);
+    if (va < vb)
+        return -1;
+    if (va > vb)
+        return 1;
+    return 0;
+}
+
+// Histogram over log2 ns buckets from 1us up; everything faster lands in
+// the first bucket and everything >= 64ms in the last.
+constexpr size_t kHistBuckets = 18;
+
+void print_histogram(const uint64_t* samples, size_t count) {
+    size_t hist[kHistBuckets] = {};
+    for (size_t i = 0; i < count; i++) {
+        size_t bucket = 0;
+        uint64_t us = samples[i] / 1000;
+        while (us > 0 && bucket < kHistBuckets - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        hist[bucket]++;
+    }
+    for (size_t b = 0; b < kHistBuckets; b++) {
+        if (hist[b] == 0)
+            continue;
+        uint64_t lo = (b == 0) ? 0 : (1ull << (b - 1));
+        printf("    [%6" PRIu64 "us, %6" PRIu64 "us): %zu\n",
+               lo, 1ull << b, hist[b]);
+    }
+}
+
+// Sorts |samples| and reports op latency percentiles and the histogram.
+void report_latency(const char* op, uint32_t threads,
+                    uint64_t* samples, size_t count) {
+    qsort(samples, count, sizeof(samples[0]), cmp_u64);
+    printf("%-8s %u thread(s): p50 %8" PRIu64 " ns, p90 %8" PRIu64
+           " ns, p99 %8" PRIu64 " ns, max %8" PRIu64 " ns (%zu ops)\n",
+           op, threads, samples[count / 2], samples[count * 9 / 10],
+           samples[count * 99 / 100], samples[count - 1], count);
+    print_histogram(samples, count);
+}
+
+struct MetadataArgs {
+    uint32_t id;
+    uint32_t ops;
+    // One latency per op, per op type.
+    uint64_t* create_ns;
+    uint64_t* stat_ns;
+    uint64_t* unlink_ns;
+    int result;
+};
+
+int metadata_worker(void* arg) {
+    MetadataArgs* a = static_cast<MetadataArgs*>(arg);
+    char path[PATH_MAX];
+
+    for (uint32_t i = 0; i < a->ops; i++) {
+        // The name set is a pure function of thread id and op index.
+        snprintf(path, sizeof(path), MOUNT_POINT "/md-%u-%u", a->id, i);
+
+        uint64_t t0 = now_ns();
+        int fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+        uint64_t t1 = now_ns();
+        if (fd < 0) {
+            a->result = -1;
+            return -1;
+        }
+        close(fd);
+        a->create_ns[i] = t1 - t0;
+
+        struct stat buf;
+        t0 = now_ns();
+        if (stat(path, &buf) != 0) {
+            a->result = -1;
+            return -1;
+        }
+        a->stat_ns[i] = now_ns() - t0;
+
+        t0 = now_ns();
+        if (unlink(path) != 0) {
+            a->result = -1;
+            return -1;
+        }
+        a->unlink_ns[i] = now_ns() - t0;
+    }
+    a->result = 0;
+    return 0;
+}
+
+bool run_metadata_bench(uint32_t threads) {
+    printf("\nBenchmarking concurrent create/stat/unlink, %u thread(s)\n",
+           threads);
+
+    AllocChecker ac;
+    size_t total = threads * kMetadataOpsPerThread;
+    mxtl::unique_ptr<uint64_t[]> create_ns(new (&ac) uint64_t[total]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> stat_ns(new (&ac) uint64_t[total]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> unlink_ns(new (&ac) uint64_t[total]);
+    ASSERT_EQ(ac.check(), true, "");
+
+    MetadataArgs args[kMaxThreads];
+    thrd_t workers[kMaxThreads];
+    uint64_t start = now_ns();
+    for (uint32_t t = 0; t < threads; t++) {
+        args[t].id = t;
+        args[t].ops = kMetadataOpsPerThread;
+        args[t].create_ns = &create_ns[t * kMetadataOpsPerThread];
+        args[t].stat_ns = &stat_ns[t * kMetadataOpsPerThread];
+        args[t].unlink_ns = &unlink_ns[t * kMetadataOpsPerThread];
+        args[t].result = -1;
+        ASSERT_EQ(thrd_create(&workers[t], metadata_worker, &args[t]),
+                  thrd_success, "Could not create worker");
+    }
+    for (uint32_t t = 0; t < threads; t++) {
+        ASSERT_EQ(thrd_join(workers[t], nullptr), thrd_success, "");
+        ASSERT_EQ(args[t].result, 0, "Worker failed");
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("Total: %zu ops in %" PRIu64 " msec\n", total * 3,
+           elapsed / 1000000);
+    report_latency("create", threads, create_ns.get(), total);
+    report_latency("stat", threads, stat_ns.get(), total);
+    report_latency("unlink", threads, unlink_ns.get(), total);
+    return true;
+}
+
+struct MixedArgs {
+    uint32_t id;
+    uint32_t ops;
+    uint64_t* read_ns;
+    uint64_t* write_ns;
+    size_t num_reads;
+    size_t num_writes;
+    int result;
+};
+
+int mixed_worker(void* arg) {
+    MixedArgs* a = static_cast<MixedArgs*>(arg);
+    a->num_reads = 0;
+    a->num_writes = 0;
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), MOUNT_POINT "/mixed-%u", a->id);
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        a->result = -1;
+        return -1;
+    }
+
+    uint8_t block[kMixedIoSize];
+    memset(block, 0x5a, sizeof(block));
+
+    uint64_t rng = 0x9e3779b97f4a7c15ull + a->id;
+    constexpr uint64_t kBlocks = kMixedFileSize / kMixedIoSize;
+    for (uint32_t i = 0; i < a->ops; i++) {
+        uint64_t r = lcg_next(&rng);
+        off_t offset = static_cast<off_t>((r % kBlocks) * kMixedIoSize);
+        if (r & 1) {
+            uint64_t t0 = now_ns();
+            ssize_t actual = pwrite(fd, block, sizeof(block), offset);
+            uint64_t t1 = now_ns();
+            if (actual != static_cast<ssize_t>(sizeof(block))) {
+                a->result = -1;
+                close(fd);
+                return -1;
+            }
+            a->write_ns[a->num_writes++] = t1 - t0;
+        } else {
+            uint64_t t0 = now_ns();
+            ssize_t actual = pread(fd, block, sizeof(block), offset);
+            uint64_t t1 = now_ns();
+            if (actual != static_cast<ssize_t>(sizeof(block))) {
+                a->result = -1;
+                close(fd);
+                return -1;
+            }
+            a->read_ns[a->num_reads++] = t1 - t0;
+        }
+    }
+
+    close(fd);
+    a->result = 0;
+    return 0;
+}
+
+bool run_mixed_bench(uint32_t threads) {
+    printf("\nBenchmarking concurrent mixed 4k read/write, %u thread(s)\n",
+           threads);
+
+    // Pre-fill one file per thread, untimed.
+    AllocChecker ac;
+    mxtl::unique_ptr<uint8_t[]> fill(new (&ac) uint8_t[kMixedIoSize]);
+    ASSERT_EQ(ac.check(), true, "");
+    memset(fill.get(), 0xee, kMixedIoSize);
+    char path[PATH_MAX];
+    for (uint32_t t = 0; t < threads; t++) {
+        snprintf(path, sizeof(path), MOUNT_POINT "/mixed-%u", t);
+        int fd = open(path, O_CREAT | O_RDWR, 0644);
+        ASSERT_GT(fd, 0, "Cannot create file (FS benchmarks assume mounted FS exists at '/benchmark')");
+        for (size_t off = 0; off < kMixedFileSize; off += kMixedIoSize) {
+            ASSERT_EQ(write(fd, fill.get(), kMixedIoSize),
+                      static_cast<ssize_t>(kMixedIoSize), "");
+        }
+        ASSERT_EQ(close(fd), 0, "");
+    }
+
+    size_t total = threads * kMixedOpsPerThread;
+    mxtl::unique_ptr<uint64_t[]> read_ns(new (&ac) uint64_t[total]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> write_ns(new (&ac) uint64_t[total]);
+    ASSERT_EQ(ac.check(), true, "");
+
+    MixedArgs args[kMaxThreads];
+    thrd_t workers[kMaxThreads];
+    uint64_t start = now_ns();
+    for (uint32_t t = 0; t < threads; t++) {
+        args[t].id = t;
+        args[t].ops = kMixedOpsPerThread;
+        args[t].read_ns = &read_ns[t * kMixedOpsPerThread];
+        args[t].write_ns = &write_ns[t * kMixedOpsPerThread];
+        args[t].result = -1;
+        ASSERT_EQ(thrd_create(&workers[t], mixed_worker, &args[t]),
+                  thrd_success, "Could not create worker");
+    }
+    size_t num_reads = 0;
+    size_t num_writes = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        ASSERT_EQ(thrd_join(workers[t], nullptr), thrd_success, "");
+        ASSERT_EQ(args[t].result, 0, "Worker failed");
+        num_reads += args[t].num_reads;
+        num_writes += args[t].num_writes;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    // Compact the per-thread sample runs for a global distribution.
+    mxtl::unique_ptr<uint64_t[]> all_reads(new (&ac) uint64_t[num_reads]);
+    ASSERT_EQ(ac.check(), true, "");
+    mxtl::unique_ptr<uint64_t[]> all_writes(new (&ac) uint64_t[num_writes]);
+    ASSERT_EQ(ac.check(), true, "");
+    size_t r = 0, w = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        memcpy(&all_reads[r], args[t].read_ns,
+               args[t].num_reads * sizeof(uint64_t));
+        memcpy(&all_writes[w], args[t].write_ns,
+               args[t].num_writes * sizeof(uint64_t));
+        r += args[t].num_reads;
+        w += args[t].num_writes;
+    }
+
+    printf("Total: %zu ops in %" PRIu64 " msec\n", total, elapsed / 1000000);
+    report_latency("read", threads, all_reads.get(), num_reads);
+    report_latency("write", threads, all_writes.get(), num_writes);
+
+    for (uint32_t t = 0; t < threads; t++) {
+        snprintf(path, sizeof(path), MOUNT_POINT "/mixed-%u", t);
+        ASSERT_EQ(unlink(path), 0, "");
+    }
+    return true;
+}
+
+bool benchmark_concurrent_metadata(void) {
+    BEGIN_TEST;
+    static constexpr uint32_t kThreadCounts[] = {1, 2, 4};
+    for (size_t i = 0; i < countof(kThreadCounts); i++) {
+        ASSERT_TRUE(run_metadata_bench(kThreadCounts[i]), "");
+    }
+    END_TEST;
+}
+
+bool benchmark_concurrent_mixed(void) {
+    BEGIN_TEST;
+    static constexpr uint32_t kThreadCounts[] = {1, 2, 4};
+    for (size_t i = 0; i < countof(kThreadCounts); i++) {
+        ASSERT_TRUE(run_mixed_bench(kThreadCounts[i]), "");
+    }
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(concurrent_benchmarks)
+RUN_TEST_PERFORMANCE(benchmark_concurrent_metadata)
+RUN_TEST_PERFORMANCE(benchmark_concurrent_mixed)
+END_TEST_CASE(concurrent_benchmarks)
@@ -15,6 +15,7 @@ MODULE_NAME := fs-bench-test
 MODULE_SRCS := \
     $(LOCAL_DIR)/main.cpp \
     $(LOCAL_DIR)/bench-basic.cpp \
+    $(LOCAL_DIR)/bench-concurrent.cpp \
 
 MODULE_STATIC_LIBS := \
     system/ulib/mxcpp \
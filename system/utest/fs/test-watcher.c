@@ -22,15 +22,19 @@
 #include "filesystems.h"
 #include "misc.h"
 
-// Try to read from the channel when it should be empty.
+// Try to read from the channel when it should be empty. Batched events
+// may still be in flight, so allow the server a moment to flush first.
 bool check_for_empty(mx_handle_t h) {
-    char name[NAME_MAX + 1];
-    ASSERT_EQ(mx_channel_read(h, 0, &name, NULL, sizeof(name), 0, NULL, NULL),
+    mx_nanosleep(mx_deadline_after(MX_MSEC(50)));
+    uint8_t msg[VFS_WATCH_MSG_MAX];
+    ASSERT_EQ(mx_channel_read(h, 0, msg, NULL, sizeof(msg), 0, NULL, NULL),
               ERR_SHOULD_WAIT, "");
     return true;
 }
 
-// Try to read the 'expected' name off the channel.
+// Try to read the 'expected' name off the channel. Messages are batches
+// of packed events (see IOCTL_VFS_WATCH_DIR); here each event is read
+// back individually before the next one is generated.
 bool check_for_watched(mx_handle_t h, const char* expected, size_t expected_len) {
     mx_signals_t observed;
     ASSERT_EQ(mx_object_wait_one(h, MX_CHANNEL_READABLE,
@@ -38,11 +42,13 @@ bool check_for_watched(mx_handle_t h, const char* expected, size_t expected_len)
               NO_ERROR, "");
     ASSERT_EQ(observed & MX_CHANNEL_READABLE, MX_CHANNEL_READABLE, "");
     uint32_t actual;
-    char name[NAME_MAX + 1];
-    ASSERT_EQ(mx_channel_read(h, 0, &name, NULL, expected_len, 0, &actual, NULL),
+    uint8_t msg[VFS_WATCH_MSG_MAX];
+    ASSERT_EQ(mx_channel_read(h, 0, msg, NULL, sizeof(msg), 0, &actual, NULL),
               NO_ERROR, "");
-    ASSERT_EQ(actual, expected_len, "");
-    ASSERT_EQ(strncmp(name, expected, expected_len), 0, "");
+    ASSERT_EQ(actual, 2 + expected_len, "");
+    ASSERT_EQ(msg[0] & VFS_WATCH_EVT_ADDED, VFS_WATCH_EVT_ADDED, "");
+    ASSERT_EQ(msg[1], expected_len, "");
+    ASSERT_EQ(strncmp((const char*)&msg[2], expected, expected_len), 0, "");
     return true;
 }
 
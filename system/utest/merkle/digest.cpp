@@ -24,6 +24,9 @@ const char* kZeroDigest =
 // echo -n | sha256sum | cut -c1-64 | tr -d '\n' | xxd -p -r | sha256sum
 const char* kDoubleZeroDigest =
     "5df6e0e2761359d30a8275058e299fcc0381534545f55cf43e41983f5d4c9456";
+// printf 'a%.0s' $(seq 1000000) | sha256sum
+const char* kMillionADigest =
+    "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
 
 ////////////////
 // Test cases
@@ -81,6 +84,36 @@ bool DigestSplit(void) {
     END_TEST;
 }
 
+bool DigestMultiBlock(void) {
+    BEGIN_TEST;
+    Digest actual, expected;
+    mx_status_t rc = expected.Parse(kMillionADigest, strlen(kMillionADigest));
+    ASSERT_EQ(rc, NO_ERROR, mx_status_get_string(rc));
+    size_t n = 1000000;
+    char* buf = static_cast<char*>(malloc(n));
+    ASSERT_TRUE(buf != nullptr, "Failed to allocate data");
+    memset(buf, 'a', n);
+    actual.Hash(buf, n);
+    ASSERT_TRUE(actual == expected, __FUNCTION__);
+    // Updates of varying sizes must reach the same digest as the one-shot
+    // hash, no matter how they fall against the block boundaries.
+    actual.Init();
+    size_t off = 0;
+    size_t chunk = 1;
+    while (off < n) {
+        if (chunk > n - off) {
+            chunk = n - off;
+        }
+        actual.Update(buf + off, chunk);
+        off += chunk;
+        chunk = (chunk * 2) + 1;
+    }
+    actual.Final();
+    free(buf);
+    ASSERT_TRUE(actual == expected, __FUNCTION__);
+    END_TEST;
+}
+
 bool DigestCWrappers(void) {
     BEGIN_TEST;
     uint8_t buf[Digest::kLength];
@@ -134,6 +167,7 @@ RUN_TEST(DigestStrings)
 RUN_TEST(DigestZero)
 RUN_TEST(DigestSelf)
 RUN_TEST(DigestSplit)
+RUN_TEST(DigestMultiBlock)
 RUN_TEST(DigestCWrappers)
 RUN_TEST(DigestEquality)
 END_TEST_CASE(MerkleDigestTests)
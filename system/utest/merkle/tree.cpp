@@ -868,6 +868,28 @@ bool VerifyBadLeaves(void) {
     END_TEST;
 }
 
+bool VerifyBadLeavesLarge(void) {
+    BEGIN_TEST;
+    Tree merkleTree;
+    auto& data_failures = merkleTree.data_failures();
+    auto& tree_failures = merkleTree.tree_failures();
+    // Use enough nodes that verification fans out across CPUs, and corrupt a
+    // leaf well past the start of the range.
+    InitZeroData(kNodeSize * 64);
+    mx_status_t rc =
+        merkleTree.Create(gData, gDataLen, gTree, gTreeLen, &gDigest);
+    ASSERT_EQ(rc, NO_ERROR, mx_status_get_string(rc));
+    uint64_t bad_node = kNodeSize * 50;
+    gData[bad_node] ^= 1;
+    rc = merkleTree.Verify(gData, gDataLen, gTree, gTreeLen, 0, gDataLen,
+                           gDigest);
+    ASSERT_EQ(rc, ERR_IO_DATA_INTEGRITY, mx_status_get_string(rc));
+    ASSERT_EQ(data_failures.size(), 1, "Wrong number of data_failures");
+    ASSERT_EQ(data_failures[0], bad_node, "Wrong offset for data_failure");
+    ASSERT_EQ(tree_failures.size(), 0, "Wrong number of tree_failures");
+    END_TEST;
+}
+
 bool CreateAndVerifyHugePRNGData(void) {
     BEGIN_TEST;
     Tree merkleTree;
@@ -1024,5 +1046,6 @@ RUN_TEST(VerifyGoodPartOfBadTree)
 RUN_TEST(VerifyBadTree)
 RUN_TEST(VerifyGoodPartOfBadLeaves)
 RUN_TEST(VerifyBadLeaves)
+RUN_TEST(VerifyBadLeavesLarge)
 RUN_TEST(CreateAndVerifyHugePRNGData)
 END_TEST_CASE(MerkleTreeTests)
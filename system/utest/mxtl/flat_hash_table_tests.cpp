@@ -0,0 +1,190 @@
+// Copyright 2016 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <magenta/new.h>
+#include <mxtl/flat_hash_table.h>
+#include <mxtl/unique_ptr.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+using TestTable = mxtl::FlatHashTable<uint64_t, uint64_t>;
+
+static bool flat_hash_table_basic_test() {
+    BEGIN_TEST;
+
+    TestTable table;
+    EXPECT_TRUE(table.is_empty(), "");
+    EXPECT_EQ(0u, table.size(), "");
+    EXPECT_NULL(table.find(0u), "");
+    EXPECT_FALSE(table.erase(0u), "");
+
+    // Insert a handful of entries and find them again.
+    static constexpr size_t kCount = 8;
+    for (uint64_t i = 0; i < kCount; ++i)
+        ASSERT_TRUE(table.insert(i, i * 100), "");
+    EXPECT_EQ(kCount, table.size(), "");
+
+    for (uint64_t i = 0; i < kCount; ++i) {
+        uint64_t* val = table.find(i);
+        ASSERT_NONNULL(val, "");
+        EXPECT_EQ(i * 100, *val, "");
+    }
+    EXPECT_NULL(table.find(kCount), "");
+
+    // Values found through the table may be updated in place.
+    *table.find(3u) = 42u;
+    EXPECT_EQ(42u, *table.find(3u), "");
+
+    // Erase an entry, recovering its value, and make sure the rest survive.
+    uint64_t removed = 0;
+    EXPECT_TRUE(table.erase(3u, &removed), "");
+    EXPECT_EQ(42u, removed, "");
+    EXPECT_NULL(table.find(3u), "");
+    EXPECT_EQ(kCount - 1, table.size(), "");
+    for (uint64_t i = 0; i < kCount; ++i) {
+        if (i == 3u)
+            continue;
+        ASSERT_NONNULL(table.find(i), "");
+    }
+
+    // Erasing an absent key is a no-op.
+    EXPECT_FALSE(table.erase(3u), "");
+    EXPECT_EQ(kCount - 1, table.size(), "");
+
+    table.clear();
+    EXPECT_TRUE(table.is_empty(), "");
+    EXPECT_NULL(table.find(0u), "");
+
+    END_TEST;
+}
+
+static bool flat_hash_table_growth_test() {
+    BEGIN_TEST;
+
+    // Push the table well past several doublings, verifying the contents
+    // after every insert batch.  Use keys with common low bits so that the
+    // default traits' mixing, not the raw key values, is what spreads the
+    // entries.
+    static constexpr size_t kCount = 4096;
+    static constexpr uint64_t kStride = 0x1000;
+
+    TestTable table;
+    for (uint64_t i = 0; i < kCount; ++i)
+        ASSERT_TRUE(table.insert(i * kStride, i), "");
+    EXPECT_EQ(kCount, table.size(), "");
+
+    // The load factor cap guarantees spare capacity.
+    EXPECT_GT(table.capacity(), table.size(), "");
+
+    for (uint64_t i = 0; i < kCount; ++i) {
+        uint64_t* val = table.find(i * kStride);
+        ASSERT_NONNULL(val, "");
+        EXPECT_EQ(i, *val, "");
+    }
+
+    // Erase every other entry, then verify both halves, exercising
+    // backward-shift deletion inside large collision clusters.
+    for (uint64_t i = 0; i < kCount; i += 2)
+        ASSERT_TRUE(table.erase(i * kStride), "");
+    EXPECT_EQ(kCount / 2, table.size(), "");
+
+    for (uint64_t i = 0; i < kCount; ++i) {
+        uint64_t* val = table.find(i * kStride);
+        if (i & 1) {
+            ASSERT_NONNULL(val, "");
+            EXPECT_EQ(i, *val, "");
+        } else {
+            EXPECT_NULL(val, "");
+        }
+    }
+
+    // Drain the rest.
+    for (uint64_t i = 1; i < kCount; i += 2)
+        ASSERT_TRUE(table.erase(i * kStride), "");
+    EXPECT_TRUE(table.is_empty(), "");
+
+    END_TEST;
+}
+
+static bool flat_hash_table_iterator_test() {
+    BEGIN_TEST;
+
+    TestTable table;
+
+    // Iterating an empty table visits nothing.
+    EXPECT_TRUE(table.begin() == table.end(), "");
+
+    static constexpr size_t kCount = 64;
+    for (uint64_t i = 0; i < kCount; ++i)
+        ASSERT_TRUE(table.insert(i, i), "");
+
+    // Iteration visits every entry exactly once (in no particular order).
+    bool seen[kCount] = { };
+    size_t visited = 0;
+    for (const auto& entry : table) {
+        ASSERT_LT(entry.key, kCount, "");
+        EXPECT_EQ(entry.key, entry.value, "");
+        EXPECT_FALSE(seen[entry.key], "");
+        seen[entry.key] = true;
+        ++visited;
+    }
+    EXPECT_EQ(kCount, visited, "");
+
+    // Values are mutable through a non-const iterator.
+    for (auto iter = table.begin(); iter != table.end(); ++iter)
+        iter->value += 1000u;
+    for (uint64_t i = 0; i < kCount; ++i)
+        EXPECT_EQ(i + 1000u, *table.find(i), "");
+
+    END_TEST;
+}
+
+static bool flat_hash_table_move_semantics_test() {
+    BEGIN_TEST;
+
+    // Tables of managed pointers release their contents when destroyed or
+    // reset, and move construction/assignment transfers ownership.
+    using PtrTable = mxtl::FlatHashTable<uint64_t, mxtl::unique_ptr<uint64_t>>;
+
+    PtrTable table;
+    for (uint64_t i = 0; i < 16; ++i) {
+        AllocChecker ac;
+        mxtl::unique_ptr<uint64_t> val(new (&ac) uint64_t(i));
+        ASSERT_TRUE(ac.check(), "");
+        ASSERT_TRUE(table.insert(i, mxtl::move(val)), "");
+    }
+
+    // Move the table; the source ends up empty with its contents intact in
+    // the destination.
+    PtrTable other(mxtl::move(table));
+    EXPECT_TRUE(table.is_empty(), "");
+    EXPECT_EQ(16u, other.size(), "");
+    for (uint64_t i = 0; i < 16; ++i) {
+        auto* val = other.find(i);
+        ASSERT_NONNULL(val, "");
+        EXPECT_EQ(i, *(*val), "");
+    }
+
+    // Erase transfers the value out.
+    mxtl::unique_ptr<uint64_t> removed;
+    EXPECT_TRUE(other.erase(5u, &removed), "");
+    ASSERT_NONNULL(removed.get(), "");
+    EXPECT_EQ(5u, *removed, "");
+
+    // reset() releases everything which remains.
+    other.reset();
+    EXPECT_TRUE(other.is_empty(), "");
+
+    END_TEST;
+}
+
+}  // namespace
+
+BEGIN_TEST_CASE(flat_hash_table_tests)
+RUN_NAMED_TEST("Basic",          flat_hash_table_basic_test)
+RUN_NAMED_TEST("Growth",         flat_hash_table_growth_test)
+RUN_NAMED_TEST("Iterator",       flat_hash_table_iterator_test)
+RUN_NAMED_TEST("Move semantics", flat_hash_table_move_semantics_test)
+END_TEST_CASE(flat_hash_table_tests);
@@ -421,6 +421,68 @@ static bool WAVLBalanceTest() {
     END_TEST;
 }
 
+static bool WAVLInsertBackEraseRangeTest() {
+    BEGIN_TEST;
+
+    // Declare these in a specific order (object pointer first) so that the tree
+    // has a chance to clean up before the memory backing the objects gets
+    // cleaned up.
+    unique_ptr<BalanceTestObj[]> objects;
+    BalanceTestTree tree;
+
+    // Allocate the objects we will use for the test.
+    {
+        AllocChecker ac;
+        objects.reset(new (&ac) BalanceTestObj[kBalanceTestSize]);
+        ASSERT_TRUE(ac.check(), "Failed to allocate test objects!");
+    }
+
+    // Build the tree from an ascending pre-sorted run using insert_back,
+    // sanity checking the tree (including the rank rule) as we go.
+    for (size_t i = 0; i < kBalanceTestSize; ++i) {
+        objects[i].Init(i);
+        tree.insert_back(BalanceTestObjPtr(&objects[i]));
+        ASSERT_TRUE(WAVLTreeChecker::SanityCheck(tree), "");
+    }
+    ASSERT_EQ(kBalanceTestSize, tree.size(), "");
+
+    // Erase the middle half of the key space with a single ranged erase.
+    // BalanceTestObj's delete is a no-op, so simply dropping the pointers
+    // handed to the callback is fine.
+    static constexpr BalanceTestKeyType kEraseStart = kBalanceTestSize / 4;
+    static constexpr BalanceTestKeyType kEraseEnd   = (3 * kBalanceTestSize) / 4;
+    size_t erased = tree.erase_range(kEraseStart, kEraseEnd,
+                                     [](BalanceTestObjPtr) { });
+    ASSERT_EQ(static_cast<size_t>(kEraseEnd - kEraseStart), erased, "");
+    ASSERT_EQ(kBalanceTestSize - erased, tree.size(), "");
+    ASSERT_TRUE(WAVLTreeChecker::SanityCheck(tree), "");
+
+    // Everything inside the erased range is gone; everything outside survived.
+    for (size_t i = 0; i < kBalanceTestSize; ++i) {
+        bool was_erased = (i >= kEraseStart) && (i < kEraseEnd);
+        ASSERT_EQ(!was_erased, objects[i].InContainer(), "");
+    }
+
+    // A range which matches no keys erases nothing.
+    erased = tree.erase_range(kEraseStart, kEraseEnd,
+                              [](BalanceTestObjPtr) { });
+    ASSERT_EQ(0u, erased, "");
+
+    // Put the erased elements back (the tree is no longer strictly
+    // ascending-built, so use plain insert), then clear the whole key space
+    // with one ranged erase.
+    for (size_t i = kEraseStart; i < kEraseEnd; ++i)
+        tree.insert(BalanceTestObjPtr(&objects[i]));
+    ASSERT_EQ(kBalanceTestSize, tree.size(), "");
+
+    erased = tree.erase_range(0u, kBalanceTestSize,
+                              [](BalanceTestObjPtr) { });
+    ASSERT_EQ(kBalanceTestSize, erased, "");
+    ASSERT_TRUE(tree.is_empty(), "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(wavl_tree_tests)
 //////////////////////////////////////////
 // General container specific tests.
@@ -540,6 +602,7 @@ RUN_NAMED_TEST("LowerBound (RefPtr)",            RPTE::LowerBoundTest)
 // WAVLTree specific tests.
 ////////////////////////////
 RUN_NAMED_TEST("BalanceTest", WAVLBalanceTest)
+RUN_NAMED_TEST("InsertBackEraseRangeTest", WAVLInsertBackEraseRangeTest)
 
 END_TEST_CASE(wavl_tree_tests);
 
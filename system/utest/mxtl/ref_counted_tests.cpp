@@ -26,6 +26,49 @@ static void* inc_and_dec(void* arg) {
     return nullptr;
 }
 
+class PaddedDestructionTracker
+    : public mxtl::RefCountedShared<PaddedDestructionTracker> {
+public:
+    explicit PaddedDestructionTracker(bool* destroyed)
+        : destroyed_(destroyed) {}
+    ~PaddedDestructionTracker() { *destroyed_ = true; }
+
+    uintptr_t first_field_addr() const {
+        return reinterpret_cast<uintptr_t>(&destroyed_);
+    }
+
+private:
+    bool* destroyed_;
+};
+
+static bool ref_counted_shared_test() {
+    BEGIN_TEST;
+
+    bool destroyed = false;
+    {
+        AllocChecker ac;
+        mxtl::RefPtr<PaddedDestructionTracker> ptr =
+            mxtl::AdoptRef(new (&ac) PaddedDestructionTracker(&destroyed));
+        EXPECT_TRUE(ac.check(), "");
+
+        // The point of RefCountedShared is layout: the derived object's own
+        // fields must start at least a full cache line past the reference
+        // count at the head of the object.
+        auto base = reinterpret_cast<uintptr_t>(ptr.get());
+        EXPECT_LE(base + 64u, ptr->first_field_addr(),
+                  "fields should start a cache line past the ref count");
+
+        // The reference counting contract is unchanged.
+        {
+            mxtl::RefPtr<PaddedDestructionTracker> extra = ptr;
+            EXPECT_FALSE(destroyed, "should not be destroyed with two refs");
+        }
+        EXPECT_FALSE(destroyed, "should not be destroyed with one ref");
+    }
+    EXPECT_TRUE(destroyed, "should be destroyed when the last ref drops");
+    END_TEST;
+}
+
 static bool ref_counted_test() {
     BEGIN_TEST;
 
@@ -58,4 +101,5 @@ static bool ref_counted_test() {
 
 BEGIN_TEST_CASE(ref_counted_tests)
 RUN_NAMED_TEST("Ref Counted", ref_counted_test)
+RUN_NAMED_TEST("Ref Counted Shared", ref_counted_shared_test)
 END_TEST_CASE(ref_counted_tests);
@@ -14,6 +14,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/algorithm_tests.cpp \
     $(LOCAL_DIR)/atomic_tests.cpp \
     $(LOCAL_DIR)/auto_call_tests.cpp \
+    $(LOCAL_DIR)/flat_hash_table_tests.cpp \
     $(LOCAL_DIR)/forward_tests.cpp \
     $(LOCAL_DIR)/inline_array_tests.cpp \
     $(LOCAL_DIR)/intrusive_container_tests.cpp \
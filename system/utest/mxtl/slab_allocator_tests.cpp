@@ -346,6 +346,30 @@ struct StaticRefPtrTestTraits {
     }
 };
 
+template <typename LockType>
+struct MagazineStaticTestTraits {
+    class ObjType;
+    using PtrType       = ObjType*;
+    using AllocTraits   = mxtl::MagazineStaticSlabAllocatorTraits<PtrType, 1024, 4, LockType>;
+    using AllocatorType = mxtl::SlabAllocator<AllocTraits>;
+    using RefList       = mxtl::DoublyLinkedList<PtrType>;
+
+    class ObjType : public TestBase,
+                    public mxtl::SlabAllocated<AllocTraits>,
+                    public mxtl::DoublyLinkedListable<PtrType> {
+    public:
+        ObjType()                                     : TestBase() { }
+        explicit ObjType(const size_t& val)           : TestBase(val) { }
+        explicit ObjType(size_t&& val)                : TestBase(mxtl::move(val)) { }
+        explicit ObjType(const size_t& a, size_t&& b) : TestBase(a, mxtl::move(b)) { }
+    };
+
+    static size_t MaxAllocs() { return AllocatorType::AllocsPerSlab * AllocatorType::max_slabs(); }
+
+    static constexpr size_t MaxSlabs  = 4;
+    static constexpr bool   IsManaged = false;
+};
+
 template <typename Traits>
 bool do_static_slab_test(size_t test_allocs) {
     BEGIN_TEST;
@@ -441,6 +465,8 @@ DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(StaticUnmanagedTestTraits<NullLock>::Alloc
 DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(StaticUniquePtrTestTraits<NullLock>::AllocTraits, 1);
 DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(StaticRefPtrTestTraits<NullLock>::AllocTraits, 1);
 
+DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(MagazineStaticTestTraits<MutexLock>::AllocTraits, 1);
+
 BEGIN_TEST_CASE(slab_allocator_tests)
 RUN_NAMED_TEST("Unmanaged Single Slab (mutex)", (slab_test<UnmanagedTestTraits<MutexLock>, 1>))
 RUN_NAMED_TEST("Unmanaged Multi Slab  (mutex)", (slab_test<UnmanagedTestTraits<MutexLock>>))
@@ -472,4 +498,6 @@ RUN_NAMED_TEST("Static RefPtr    (mutex)", (static_slab_test<StaticRefPtrTestTra
 RUN_NAMED_TEST("Static Unmanaged (unlock)", (static_slab_test<StaticUnmanagedTestTraits<NullLock>>))
 RUN_NAMED_TEST("Static UniquePtr (unlock)", (static_slab_test<StaticUniquePtrTestTraits<NullLock>>))
 RUN_NAMED_TEST("Static RefPtr    (unlock)", (static_slab_test<StaticRefPtrTestTraits<NullLock>>))
+
+RUN_NAMED_TEST("Static Magazine  (mutex)",  (static_slab_test<MagazineStaticTestTraits<MutexLock>>))
 END_TEST_CASE(slab_allocator_tests);
@@ -206,6 +206,41 @@ bool ramdisk_test_multiple(void) {
     END_TEST;
 }
 
+bool ramdisk_test_get_vmo(void) {
+    uint8_t buf[PAGE_SIZE];
+    uint8_t out[PAGE_SIZE];
+
+    BEGIN_TEST;
+    int fd = get_ramdisk("ramdisk-test-get-vmo", PAGE_SIZE, 512);
+
+    // Acquire the backing VMO
+    mx_handle_t vmo;
+    ssize_t expected = sizeof(vmo);
+    ASSERT_EQ(ioctl_ramdisk_get_vmo(fd, &vmo), expected, "Failed to get backing VMO");
+
+    // Writes made through the VMO should be visible to block reads
+    memset(buf, 'v', sizeof(buf));
+    size_t actual;
+    ASSERT_EQ(mx_vmo_write(vmo, buf, PAGE_SIZE, sizeof(buf), &actual), NO_ERROR, "");
+    ASSERT_EQ(actual, sizeof(buf), "");
+    ASSERT_EQ(lseek(fd, PAGE_SIZE, SEEK_SET), PAGE_SIZE, "");
+    ASSERT_EQ(read(fd, out, sizeof(out)), (ssize_t) sizeof(out), "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "");
+
+    // ... and block writes should be visible through the VMO
+    memset(buf, 'b', sizeof(buf));
+    ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0, "");
+    ASSERT_EQ(write(fd, buf, sizeof(buf)), (ssize_t) sizeof(buf), "");
+    ASSERT_EQ(mx_vmo_read(vmo, out, 0, sizeof(out), &actual), NO_ERROR, "");
+    ASSERT_EQ(actual, sizeof(out), "");
+    ASSERT_EQ(memcmp(out, buf, sizeof(out)), 0, "");
+
+    ASSERT_EQ(mx_handle_close(vmo), NO_ERROR, "");
+    ASSERT_GE(ioctl_ramdisk_unlink(fd), 0, "Could not unlink ramdisk device");
+    close(fd);
+    END_TEST;
+}
+
 bool ramdisk_test_fifo_no_op(void) {
     // Get a FIFO connection to a ramdisk and immediately close it
     BEGIN_TEST;
@@ -902,6 +937,7 @@ RUN_TEST(ramdisk_test_simple)
 RUN_TEST(ramdisk_test_filesystem)
 RUN_TEST(ramdisk_test_bad_requests)
 RUN_TEST(ramdisk_test_multiple)
+RUN_TEST(ramdisk_test_get_vmo)
 RUN_TEST(ramdisk_test_fifo_no_op)
 RUN_TEST(ramdisk_test_fifo_basic)
 RUN_TEST(ramdisk_test_fifo_multiple_vmo)
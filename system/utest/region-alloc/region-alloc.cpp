@@ -235,6 +235,55 @@ static bool ralloc_subtract_test() {
     END_TEST;
 }
 
+static bool ralloc_stats_test() {
+    BEGIN_TEST;
+
+    // Make an allocator with a pool and a single 1KB region.
+    RegionAllocator alloc(RegionAllocator::RegionPool::Create(REGION_POOL_MAX_SIZE));
+    ASSERT_EQ(NO_ERROR, alloc.AddRegion({ 0u, 1024u }), "");
+
+    ralloc_stats_t stats;
+    alloc.GetStats(&stats);
+    EXPECT_EQ(1024u, stats.avail_bytes, "");
+    EXPECT_EQ(1024u, stats.largest_avail, "");
+    EXPECT_EQ(0u, stats.split_count, "");
+    EXPECT_EQ(0u, stats.coalesce_count, "");
+
+    // Allocating from the front of the region splits it once.
+    RegionAllocator::Region::UPtr r1 = alloc.GetRegion(256, 1);
+    ASSERT_NONNULL(r1, "");
+    alloc.GetStats(&stats);
+    EXPECT_EQ(768u, stats.avail_bytes, "");
+    EXPECT_EQ(768u, stats.largest_avail, "");
+    EXPECT_EQ(1u, stats.split_count, "");
+
+    // A specific allocation out of the middle of what is left splits twice.
+    RegionAllocator::Region::UPtr r2 = alloc.GetRegion({ 512u, 128u });
+    ASSERT_NONNULL(r2, "");
+    alloc.GetStats(&stats);
+    EXPECT_EQ(640u, stats.avail_bytes, "");
+    EXPECT_EQ(384u, stats.largest_avail, "");
+    EXPECT_EQ(3u, stats.split_count, "");
+    EXPECT_EQ(0u, stats.coalesce_count, "");
+
+    // Returning the middle allocation merges it with both neighbors.
+    r2 = nullptr;
+    alloc.GetStats(&stats);
+    EXPECT_EQ(768u, stats.avail_bytes, "");
+    EXPECT_EQ(768u, stats.largest_avail, "");
+    EXPECT_EQ(2u, stats.coalesce_count, "");
+
+    // Returning the first allocation heals the region completely.
+    r1 = nullptr;
+    alloc.GetStats(&stats);
+    EXPECT_EQ(1024u, stats.avail_bytes, "");
+    EXPECT_EQ(1024u, stats.largest_avail, "");
+    EXPECT_EQ(3u, stats.coalesce_count, "");
+    EXPECT_EQ(1u, alloc.AvailableRegionCount(), "");
+
+    END_TEST;
+}
+
 } //namespace
 
 BEGIN_TEST_CASE(ralloc_tests)
@@ -243,4 +292,5 @@ RUN_NAMED_TEST("Alloc by size",  ralloc_by_size_test)
 RUN_NAMED_TEST("Alloc specific", ralloc_specific_test)
 RUN_NAMED_TEST("Add/Overlap",    ralloc_add_overlap_test)
 RUN_NAMED_TEST("Subtract",       ralloc_subtract_test)
+RUN_NAMED_TEST("Stats",          ralloc_stats_test)
 END_TEST_CASE(ralloc_tests)
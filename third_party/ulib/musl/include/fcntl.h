@@ -120,6 +120,8 @@ int posix_fallocate(int, off_t, off_t);
 #define SEEK_SET 0
 #define SEEK_CUR 1
 #define SEEK_END 2
+#define SEEK_DATA 3
+#define SEEK_HOLE 4
 
 #ifndef S_IRUSR
 #define S_ISUID 04000
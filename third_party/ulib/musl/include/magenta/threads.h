@@ -14,6 +14,14 @@ extern "C" {
 // execution of the C11 thread.
 mx_handle_t thrd_get_mx_handle(thrd_t t);
 
+// Decommit the cold tail of the calling thread's stacks: every whole
+// page of the safe and unsafe stack blocks comfortably below the live
+// stack pointers is handed back to the kernel and refaults in
+// zero-filled on the next deep call chain. Intended for long-lived
+// pool threads after a burst of deep work; contents below the stack
+// pointer are dead by the ABI, so this is always safe to call.
+mx_status_t thrd_decommit_unused_stack(void);
+
 // Converts a threads.h-style status value to an |mx_status_t|.
 static inline mx_status_t __PURE thrd_status_to_mx_status(int thrd_status) {
     switch (thrd_status) {
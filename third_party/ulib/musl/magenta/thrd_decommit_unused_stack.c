@@ -0,0 +1,41 @@
+#include <magenta/threads.h>
+
+#include <magenta/syscalls.h>
+#include <sys/uio.h>
+
+#include "pthread_impl.h"
+
+// Keep this many bytes below the live stack pointer committed: the ABI
+// red zone plus headroom so the decommit call itself does not fault the
+// pages it is releasing straight back in.
+#define STACK_TRIM_SLACK (2 * PAGE_SIZE)
+
+static void decommit_tail(mx_handle_t vmo, size_t vmo_offset,
+                          const struct iovec* stack, uintptr_t sp) {
+    uintptr_t base = (uintptr_t)stack->iov_base;
+    if (sp < base + STACK_TRIM_SLACK || sp > base + stack->iov_len)
+        return;
+
+    // stacks grow down: everything between the base of the block and a
+    // slack distance below the live stack pointer is dead by the ABI
+    uintptr_t end = (sp - STACK_TRIM_SLACK) & -(uintptr_t)PAGE_SIZE;
+    if (end <= base)
+        return;
+
+    // best effort; a failure just leaves the pages committed
+    _mx_vmo_op_range(vmo, MX_VMO_OP_DECOMMIT, vmo_offset, end - base, NULL, 0);
+}
+
+mx_status_t thrd_decommit_unused_stack(void) {
+    pthread_t self = __pthread_self();
+    if (self->stack_vmo == MX_HANDLE_INVALID)
+        return ERR_BAD_STATE;
+
+    decommit_tail(self->stack_vmo, self->stack_vmo_offset,
+                  &self->safe_stack, (uintptr_t)__builtin_frame_address(0));
+    decommit_tail(self->stack_vmo,
+                  self->stack_vmo_offset + self->safe_stack.iov_len,
+                  &self->unsafe_stack, self->abi.unsafe_sp);
+
+    return NO_ERROR;
+}
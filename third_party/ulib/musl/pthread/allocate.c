@@ -165,7 +165,10 @@ __NO_SAFESTACK pthread_t __allocate_thread(const pthread_attr_t* attr) {
         return NULL;
     }
 
-    _mx_handle_close(vmo);
+    // Keep the VMO so the thread can decommit cold stack pages later;
+    // the mappings alone would not let us release committed pages.
+    td->stack_vmo = vmo;
+    td->stack_vmo_offset = tcb_size;
     td->tcb_region = tcb_region;
     td->locale = &libc.global_locale;
     td->head.tp = (uintptr_t)pthread_to_tp(td);
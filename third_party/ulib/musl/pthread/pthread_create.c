@@ -97,6 +97,7 @@ int pthread_create(pthread_t* restrict res, const pthread_attr_t* restrict attrp
 
     atomic_fetch_sub(&libc.thread_count, 1);
 fail_after_alloc:
+    _mx_handle_close(new->stack_vmo);
     deallocate_region(&new->safe_stack_region);
     deallocate_region(&new->unsafe_stack_region);
     deallocate_region(&new->tcb_region);
@@ -107,6 +108,9 @@ static _Noreturn void final_exit(pthread_t self)
     __asm__("final_exit") __attribute__((used));
 
 static __NO_SAFESTACK void final_exit(pthread_t self) {
+    // Closing the last handle to the stack VMO releases its committed
+    // pages once the mappings below are gone.
+    _mx_handle_close(self->stack_vmo);
     deallocate_region(&self->safe_stack_region);
     deallocate_region(&self->unsafe_stack_region);
 
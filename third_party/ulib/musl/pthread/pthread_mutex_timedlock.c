@@ -1,5 +1,27 @@
 #include "pthread_impl.h"
 
+#include <magenta/syscalls.h>
+
+// Number of a_spin() iterations a contended lock may burn before
+// parking in the kernel.  Spinning only pays off when the lock holder
+// can run concurrently, so the budget is zero on a single-cpu system
+// and scales with the cpu count otherwise.  The cpu count is read once
+// and cached; the cache stores budget + 1 so that 0 means
+// "not yet initialized".
+static int spin_budget(void) {
+    static atomic_int cached_budget;
+    int budget = atomic_load(&cached_budget);
+    if (budget == 0) {
+        uint32_t num_cpus = _mx_system_get_num_cpus();
+        if (num_cpus > 16)
+            num_cpus = 16;
+        budget = (num_cpus > 1) ? (int)(100u * num_cpus) : 0;
+        atomic_store(&cached_budget, budget + 1);
+        return budget;
+    }
+    return budget - 1;
+}
+
 int pthread_mutex_timedlock(pthread_mutex_t* restrict m, const struct timespec* restrict at) {
     if ((m->_m_type & PTHREAD_MUTEX_MASK) == PTHREAD_MUTEX_NORMAL &&
         !a_cas_shim(&m->_m_lock, 0, EBUSY))
@@ -11,9 +33,18 @@ int pthread_mutex_timedlock(pthread_mutex_t* restrict m, const struct timespec*
     if (r != EBUSY)
         return r;
 
-    int spins = 100;
-    while (spins-- && atomic_load(&m->_m_lock) && !atomic_load(&m->_m_waiters))
-        a_spin();
+    // Spin with exponential backoff in the hope that the holder releases
+    // the lock before we enter the kernel, but not past waiters that have
+    // already parked.
+    int backoff = 1;
+    for (int spins = spin_budget(); spins > 0; spins -= backoff) {
+        if (!atomic_load(&m->_m_lock) || atomic_load(&m->_m_waiters))
+            break;
+        for (int i = 0; i < backoff; i++)
+            a_spin();
+        if (backoff < 64)
+            backoff <<= 1;
+    }
 
     while ((r = pthread_mutex_trylock(m)) == EBUSY) {
         if (!(r = atomic_load(&m->_m_lock)))
@@ -55,6 +55,13 @@ struct pthread {
     struct iovec safe_stack, safe_stack_region;
     struct iovec unsafe_stack, unsafe_stack_region;
 
+    // The VMO backing the stacks (and TCB), kept so cold stack pages can
+    // be decommitted while the thread is alive; stack_vmo_offset is the
+    // offset of the safe stack within it, with the unsafe stack
+    // immediately after.
+    mx_handle_t stack_vmo;
+    size_t stack_vmo_offset;
+
     struct tls_dtor* tls_dtors;
     void* tsd[PTHREAD_KEYS_MAX];
     int tsd_used;